@@ -33,18 +33,24 @@
 #include "param_interface.h"
 #include "camera_interface.h"
 
+#ifdef CAMERA_USE_JPEG
+#include "global_graphics.h"
+#endif
+
 void shutdown_module(int signo __attribute__ ((unused)))
 {
   carmen_camera_shutdown();
   exit(0);
 }
 
+static carmen_camera_encoding_t encoding = CARMEN_CAMERA_ENCODING_RAW;
+static int quality = 75;
+static int use_shared_memory = 0;
+
 void carmen_camera_publish_image_message(carmen_camera_image_t *image)
 {
   static carmen_camera_image_message msg;
 
-  IPC_RETURN_TYPE err;
-
   msg.host = carmen_get_host();
   msg.timestamp = image->timestamp;
 
@@ -54,15 +60,12 @@ void carmen_camera_publish_image_message(carmen_camera_image_t *image)
   msg.bytes_per_pixel = image->bytes_per_pixel;
   msg.image = image->image;
 
-  err = IPC_publishData(CARMEN_CAMERA_IMAGE_NAME, &msg);
-  carmen_test_ipc_exit(err, "Could not publish",
-		       CARMEN_CAMERA_IMAGE_NAME);
+  carmen_camera_publish_image(&msg, encoding, quality, use_shared_memory);
 }
 
 int main(int argc, char **argv)
 {
   carmen_camera_image_t *image;
-  IPC_RETURN_TYPE err;
   double interframe_sleep = 5.0;
   int param_err;
 
@@ -70,15 +73,19 @@ int main(int argc, char **argv)
   carmen_ipc_initialize(argc, argv);
   carmen_param_check_version(argv[0]);
 
-  err = IPC_defineMsg(CARMEN_CAMERA_IMAGE_NAME, IPC_VARIABLE_LENGTH,
-		      CARMEN_CAMERA_IMAGE_FMT);
-  carmen_test_ipc_exit(err, "Could not define", CARMEN_CAMERA_IMAGE_NAME);
-
   carmen_param_allow_unfound_variables(0);
   param_err = carmen_param_get_double("camera_interframe_sleep", &interframe_sleep, NULL);
   if (param_err < 0)
     carmen_die("Could not find parameter in carmen.ini file: camera_interframe_sleep\n");
 
+#ifdef CAMERA_USE_JPEG
+  carmen_camera_register_codec(CARMEN_CAMERA_ENCODING_JPEG, 
+			       carmen_graphics_jpeg_compress, 
+			       carmen_graphics_jpeg_decompress);
+#endif
+  carmen_camera_install_transport_params(argc, argv, &encoding, &quality,
+					 &use_shared_memory);
+
   image = carmen_camera_start(argc, argv);
   if (image == NULL)
     exit(-1);
@@ -9,7 +9,8 @@
 //#define MAX_REQUESTED_LASER_IDS 100
 
 volatile int carmen_laser_has_to_stop=0;
-carmen_laser_message_queue_t carmen_laser_queue;
+/* one queue per laser, all drained by the main thread */
+carmen_laser_message_queue_t* carmen_laser_queue = NULL;
 
 carmen_laser_device_t** carmen_laser_pdevice = NULL;
 int  *carmen_laser_flipped=NULL;
@@ -57,12 +58,12 @@ int delete_lock(char* filename){
   return unlink(buf);
 }
 
-int carmen_laser_enqueue(struct carmen_laser_device_t * device __attribute__((unused)), carmen_laser_laser_static_message* message){
-  carmen_laser_message_queue_add(&carmen_laser_queue, message);
+int carmen_laser_enqueue(struct carmen_laser_device_t * device, carmen_laser_laser_static_message* message){
+  carmen_laser_message_queue_add(carmen_laser_queue+id_to_index(device->laser_id), message);
   return 0;
 }
 
-int carmen_laser_enqueue_correct(struct carmen_laser_device_t * device __attribute__((unused)), carmen_laser_laser_static_message* message){
+int carmen_laser_enqueue_correct(struct carmen_laser_device_t * device, carmen_laser_laser_static_message* message){
   double expectedTime=device->last_packet_time+device->expected_period;
   double dt=message->timestamp-device->last_packet_time;
   device->last_packet_time=message->timestamp;
@@ -71,13 +72,16 @@ int carmen_laser_enqueue_correct(struct carmen_laser_device_t * device __attribu
     message->timestamp=expectedTime;
     //fprintf(stderr,"c");
   }
-  carmen_laser_message_queue_add(&carmen_laser_queue, message);
+  carmen_laser_message_queue_add(carmen_laser_queue+id_to_index(device->laser_id), message);
   return 0;
 }
 
 
 void sigquit_handler(int q __attribute__((unused))){
   carmen_laser_has_to_stop=1;
+  /* the main thread may sleep in the queues with no scan coming */
+  if (carmen_laser_queue)
+    carmen_laser_message_queue_interrupt(carmen_laser_queue);
 }
 
 
@@ -86,6 +90,7 @@ void* laser_fn (struct carmen_laser_device_t * device){
   result=(*(device->f_start))(device);
   if (! result){
     carmen_laser_has_to_stop=1;
+    carmen_laser_message_queue_interrupt(carmen_laser_queue);
     return 0;
   }
   while (! carmen_laser_has_to_stop){
@@ -538,6 +543,48 @@ int carmen_laser_read_parameters(int argc, char **argv)
 
 
 
+/* publishes a scan straight from its queue slot */
+void carmen_laser_publish(carmen_laser_laser_static_message* m, void* data){
+  char* hostname=(char*)data;
+  static carmen_laser_laser_message msg;
+
+  msg.num_readings = m->num_readings;
+  msg.num_remissions = m->num_remissions;
+  msg.config = m->config;
+  msg.id = m->id;
+  msg.range = m->num_readings ? m->range : NULL;
+  msg.remission = m->num_remissions ? m->remission : NULL;
+
+  /* is the laser flipped (mouted upside down) */
+  int idx = id_to_index(msg.id);
+  if (carmen_laser_flipped[idx]) {
+    float tmp=0;
+    int i;
+    int upto=msg.num_readings/2;
+    if (msg.range != NULL) {
+      for (i=0; i < upto; i++) {
+	tmp = msg.range[i] ;
+	msg.range[i] = msg.range[msg.num_readings-i];
+	msg.range[msg.num_readings-i] = tmp;
+      }
+    }
+    upto=msg.num_remissions/2;
+    if (msg.remission != NULL) {
+      for (i=0; i < upto; i++) {
+	tmp = msg.remission[i] ;
+	msg.remission[i] = msg.remission[msg.num_remissions-i];
+	msg.remission[msg.num_remissions-i] = tmp;
+      }
+    }
+  }
+
+  msg.timestamp = m->timestamp;
+  msg.host = hostname;
+
+  if (msg.id>0)
+    carmen_laser_publish_laser_message(msg.id, &msg);
+}
+
 int main(int argc, char **argv) 
 {
 
@@ -548,11 +595,8 @@ int main(int argc, char **argv)
   pthread_t* laser_thread;
   void * tresult;
   char* hostname;
-  static carmen_laser_laser_message msg;
-  static float ranges[4096];
-  static float remissions[4096];
-  msg.range=ranges;
-  msg.remission=remissions;
+  int n, queued;
+  unsigned int dropped;
 
   hostname = carmen_get_host();
   carmen_ipc_initialize(argc, argv);
@@ -572,6 +616,13 @@ int main(int argc, char **argv)
     carmen_laser_define_laser_message(i);
     
   
+  carmen_laser_queue = calloc(num_laser_devices, sizeof(carmen_laser_message_queue_t));
+  carmen_test_alloc(carmen_laser_queue);
+  for(i=0; i<num_laser_devices;i++) {
+    carmen_laser_message_queue_init(carmen_laser_queue+i);
+    carmen_laser_message_queue_share_wakeup(carmen_laser_queue+i, carmen_laser_queue);
+  }
+
   laser_thread = calloc(num_laser_devices, sizeof(laser_thread));
   carmen_test_alloc(laser_thread);
 
@@ -590,74 +641,34 @@ int main(int argc, char **argv)
   signal(SIGINT, sigquit_handler);
 
 
-  //waits in the queue
+  //waits in the queues
   double lastTime=0;
-  carmen_laser_laser_static_message m;
   while (! carmen_laser_has_to_stop){
-    carmen_laser_message_queue_wait_get(&carmen_laser_queue, &m);
+    carmen_laser_message_queue_wait(carmen_laser_queue, num_laser_devices);
 
     if (lastTime==0)
       lastTime = carmen_get_time();
-    c++;
-    msg.num_readings = m.num_readings;
-    msg.num_remissions = m.num_remissions;
-    msg.config = m.config;
-    msg.id = m.id;
-  
-    //    fprintf(stderr, "r=%d\n", m.num_readings);
-    if (m.num_readings){ 
-      msg.range=ranges;
-      memcpy(msg.range,m.range, m.num_readings*sizeof(float));
-    } else {
-      msg.range=NULL;
-    }
-
-    if (m.num_remissions){
-      msg.remission=remissions;
-      memcpy(msg.remission, m.remission, m.num_remissions*sizeof(float));
-    } else {
-      msg.remission=NULL;
-    }
+    n=0;
+    for(i=0; i<num_laser_devices;i++)
+      n+=carmen_laser_message_queue_drain(carmen_laser_queue+i, carmen_laser_publish, hostname, 0);
 
-    /* is the laser flipped (mouted upside down) */
-    int idx = id_to_index(msg.id);
-    if (carmen_laser_flipped[idx]) {
-      float tmp=0;
-      int i;
-      int upto=msg.num_readings/2;
-      if (msg.range != NULL) {
-	for (i=0; i < upto; i++) {
-	  tmp = msg.range[i] ;
-	  msg.range[i] = msg.range[msg.num_readings-i];
-	  msg.range[msg.num_readings-i] = tmp;
-	}
-      }
-      upto=msg.num_remissions/2;
-      if (msg.remission != NULL) {
-	for (i=0; i < upto; i++) {
-	  tmp = msg.remission[i] ;
-	  msg.remission[i] = msg.remission[msg.num_remissions-i];
-	  msg.remission[msg.num_remissions-i] = tmp;
-	}
-      }
-    }
-
-    msg.timestamp = m.timestamp;
-    msg.host = hostname;
-    
-    if (msg.id>0)
-      carmen_laser_publish_laser_message(msg.id, &msg);
-    
-    if (c>0 && !(c%10)){
+    if (c/10 != (c+n)/10){
       double time=carmen_get_time();
       if (time-lastTime > 3.0) {
-	
-	fprintf(stderr, "status:   send-queue: %d msg(s),   laser-msg freqency: %.3f Hz (globally)\n", 
-		carmen_laser_queue.size, ((double)c)/(time-lastTime));
+	queued=0;
+	dropped=0;
+	for(i=0; i<num_laser_devices;i++) {
+	  queued+=carmen_laser_message_queue_size(carmen_laser_queue+i);
+	  dropped+=carmen_laser_message_queue_dropped(carmen_laser_queue+i);
+	}
+	fprintf(stderr, "status:   send-queue: %d msg(s),   dropped: %u msg(s),   laser-msg freqency: %.3f Hz (globally)\n", 
+		queued, dropped, ((double)(c+n))/(time-lastTime));
 	c=0;
+	n=0;
 	lastTime=time;
       }
     }
+    c+=n;
   }
   
   for(i=0; i<num_laser_devices;i++) {
@@ -686,6 +697,10 @@ int main(int argc, char **argv)
     }
   }    
 
+  for(i=0; i<num_laser_devices;i++)
+    carmen_laser_message_queue_destroy(carmen_laser_queue+i);
+  free(carmen_laser_queue);
+
   if (carmen_laser_flipped)
     free(carmen_laser_flipped);  
   return 0;
@@ -37,6 +37,7 @@
 #include "robot_interface.h"
 #include "localize_interface.h"
 #include "map_interface.h"
+#include "simulator_interface.h"
 
 /* global variables */
 carmen_localize_map_t map;
@@ -46,6 +47,54 @@ carmen_localize_summary_t summary;
 
 carmen_robot_laser_message front_laser;
 
+/* publishing: messages nobody subscribes to are not built, and particles
+   and sensor data go out at most at the configured rates (Hz, 0 for
+   every scan) */
+typedef struct {
+  char *name;
+  int num_handlers;
+  double last_publish;
+} publisher_t;
+
+publisher_t globalpos_publisher = {CARMEN_LOCALIZE_GLOBALPOS_NAME, 0, 0.0};
+publisher_t particle_publisher = {CARMEN_LOCALIZE_PARTICLE_NAME, 0, 0.0};
+publisher_t compact_particle_publisher =
+  {CARMEN_LOCALIZE_COMPACT_PARTICLE_NAME, 0, 0.0};
+publisher_t sensor_publisher = {CARMEN_LOCALIZE_SENSOR_NAME, 0, 0.0};
+
+double particle_rate = 0.0, sensor_rate = 0.0;
+int compact_max_particles = 500;
+
+static void handlers_changed(const char *msg_name __attribute__ ((unused)),
+			     int num_handlers, void *client_data)
+{
+  ((publisher_t *)client_data)->num_handlers = num_handlers;
+}
+
+void watch_publisher(publisher_t *publisher)
+{
+  IPC_RETURN_TYPE err;
+
+  publisher->num_handlers = IPC_numHandlers(publisher->name);
+  err = IPC_subscribeHandlerChange(publisher->name, handlers_changed,
+				   publisher);
+  carmen_test_ipc(err, "Could not watch subscriptions of", publisher->name);
+  /* without change notifications, always publish */
+  if (err != IPC_OK)
+    publisher->num_handlers = 1;
+}
+
+int publish_due(publisher_t *publisher, double rate, double now)
+{
+  if (publisher->num_handlers <= 0)
+    return 0;
+  if (rate > 0.0 && now - publisher->last_publish < 1.0 / rate)
+    return 0;
+
+  publisher->last_publish = now;
+  return 1;
+}
+
 /* publish a global position message */
 
 void publish_globalpos(carmen_localize_summary_p summary)
@@ -76,7 +125,8 @@ void publish_particles(carmen_localize_particle_filter_p filter,
   pmsg.timestamp = carmen_get_time();
   pmsg.host = carmen_get_host();
   pmsg.globalpos = summary->mean;
-  pmsg.globalpos_std = summary->mean;
+  pmsg.globalpos_std = summary->std;
+  pmsg.globalpos_xy_cov = summary->xy_cov;
   pmsg.num_particles = filter->param->num_particles;
   pmsg.particles = (carmen_localize_particle_ipc_p)filter->particles;
   err = IPC_publishData(CARMEN_LOCALIZE_PARTICLE_NAME, &pmsg);
@@ -85,6 +135,50 @@ void publish_particles(carmen_localize_particle_filter_p filter,
   fprintf(stderr, "P");
 }
 
+/* publish a subsampled, quantized particle message */
+
+void publish_compact_particles(carmen_localize_particle_filter_p filter, 
+			       carmen_localize_summary_p summary)
+{
+  static carmen_localize_compact_particle_message pmsg;
+  static int max_particles = 0;
+  IPC_RETURN_TYPE err;
+
+  if (compact_max_particles < 1)
+    compact_max_particles = 1;
+  if (max_particles != compact_max_particles) {
+    max_particles = compact_max_particles;
+    pmsg.particles = (carmen_localize_compact_particle_p)
+      realloc(pmsg.particles, 
+	      max_particles * sizeof(carmen_localize_compact_particle_t));
+    carmen_test_alloc(pmsg.particles);
+  }
+
+  pmsg.timestamp = carmen_get_time();
+  pmsg.host = carmen_get_host();
+  pmsg.globalpos = summary->mean;
+  pmsg.globalpos_std = summary->std;
+  pmsg.globalpos_xy_cov = summary->xy_cov;
+  carmen_localize_encode_compact_particles
+    ((carmen_localize_particle_ipc_p)filter->particles,
+     filter->param->num_particles, max_particles, &pmsg);
+  err = IPC_publishData(CARMEN_LOCALIZE_COMPACT_PARTICLE_NAME, &pmsg);
+  carmen_test_ipc_exit(err, "Could not publish", 
+		       CARMEN_LOCALIZE_COMPACT_PARTICLE_NAME);  
+}
+
+/* publish the particle messages someone listens to, at most at rate */
+
+void publish_particle_messages(double rate)
+{
+  double now = carmen_get_time();
+
+  if (publish_due(&particle_publisher, rate, now))
+    publish_particles(filter, &summary);
+  if (publish_due(&compact_particle_publisher, rate, now))
+    publish_compact_particles(filter, &summary);
+}
+
 /* publish sensor message */
 
 void publish_sensor(carmen_localize_particle_filter_p filter,
@@ -134,7 +228,7 @@ void carmen_localize_initialize_handler(carmen_localize_initialize_message
 						   initialize_msg->std);
   else if(initialize_msg->distribution == CARMEN_INITIALIZE_UNIFORM) {
     carmen_localize_initialize_particles_uniform(filter, &front_laser, &map);
-    publish_particles(filter, &summary);
+    publish_particle_messages(0.0);
   }
 }
 
@@ -142,7 +236,7 @@ void carmen_localize_initialize_placename_handler(carmen_localize_initialize_pla
 {
   carmen_localize_initialize_particles_placename(filter, &placelist,
 						 init_place->placename);
-  publish_particles(filter, &summary);
+  publish_particle_messages(0.0);
 }
 
 void robot_frontlaser_handler(carmen_robot_laser_message *flaser)
@@ -155,9 +249,11 @@ void robot_frontlaser_handler(carmen_robot_laser_message *flaser)
 			      flaser->range, filter->param->front_laser_offset,
 			      flaser->config.angular_resolution,
 			      flaser->config.start_angle, 0);
-    publish_globalpos(&summary);
-    publish_particles(filter, &summary);
-    publish_sensor(filter, &summary, flaser, 1);
+    if (publish_due(&globalpos_publisher, 0.0, carmen_get_time()))
+      publish_globalpos(&summary);
+    publish_particle_messages(particle_rate);
+    if (publish_due(&sensor_publisher, sensor_rate, carmen_get_time()))
+      publish_sensor(filter, &summary, flaser, 1);
   }
 }
 
@@ -169,16 +265,11 @@ void robot_rearlaser_handler(carmen_robot_laser_message *rlaser)
 void 
 map_update_handler(carmen_map_t *new_map) 
 {
-  int i;
   carmen_localize_param_p param;
 
   param = filter->param;
 
-  for(i = 0; i < filter->param->num_particles; i++) 
-    free(filter->temp_weights[i]);  
-  free(filter->temp_weights);
-  free(filter->particles);
-  free(filter);
+  carmen_localize_particle_filter_free(filter);
 
   free(map.complete_x_offset);
   free(map.complete_y_offset);
@@ -306,11 +397,24 @@ int register_ipc_messages(void)
 		      CARMEN_LOCALIZE_PARTICLE_FMT);
   carmen_test_ipc_exit(err, "Could not define", CARMEN_LOCALIZE_PARTICLE_NAME);
 
+  /* register compact particle message */
+  err = IPC_defineMsg(CARMEN_LOCALIZE_COMPACT_PARTICLE_NAME, 
+		      IPC_VARIABLE_LENGTH, 
+		      CARMEN_LOCALIZE_COMPACT_PARTICLE_FMT);
+  carmen_test_ipc_exit(err, "Could not define", 
+		       CARMEN_LOCALIZE_COMPACT_PARTICLE_NAME);
+
   /* register sensor message */
   err = IPC_defineMsg(CARMEN_LOCALIZE_SENSOR_NAME, IPC_VARIABLE_LENGTH,
 		      CARMEN_LOCALIZE_SENSOR_FMT);
   carmen_test_ipc_exit(err, "Could not define", CARMEN_LOCALIZE_SENSOR_NAME);
 
+  /* track subscribers of everything published per scan */
+  watch_publisher(&globalpos_publisher);
+  watch_publisher(&particle_publisher);
+  watch_publisher(&compact_particle_publisher);
+  watch_publisher(&sensor_publisher);
+
   /* register initialize message */
   err = IPC_defineMsg(CARMEN_LOCALIZE_INITIALIZE_NAME, IPC_VARIABLE_LENGTH, 
 		      CARMEN_LOCALIZE_INITIALIZE_FMT);
@@ -413,7 +517,13 @@ void read_parameters(int argc, char **argv, carmen_localize_param_p param)
     {"localize", "tracking_beam_minlikelihood", CARMEN_PARAM_DOUBLE, 
      &param->tracking_beam_minlikelihood, 0, NULL},
     {"localize", "global_beam_minlikelihood", CARMEN_PARAM_DOUBLE, 
-     &param->global_beam_minlikelihood, 0, NULL}
+     &param->global_beam_minlikelihood, 0, NULL},
+    {"localize", "particle_rate", CARMEN_PARAM_DOUBLE, 
+     &particle_rate, 1, NULL},
+    {"localize", "sensor_rate", CARMEN_PARAM_DOUBLE, 
+     &sensor_rate, 1, NULL},
+    {"localize", "compact_max_particles", CARMEN_PARAM_INT, 
+     &compact_max_particles, 1, NULL}
   };
 
   carmen_param_install_params(argc, argv, param_list, 
@@ -471,6 +581,9 @@ int main(int argc, char **argv)
   /* Initialize all the relevant parameters */
   read_parameters(argc, argv, &param);
 
+  /* follow the simulator's clock in lockstep mode */
+  carmen_simulator_initialize_clock(argc, argv);
+
   /* get a map */
   create_localize_map(&map, &param);
 
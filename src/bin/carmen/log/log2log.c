@@ -28,12 +28,83 @@
 
 #include "global.h"
 
+#include "readlog.h"
 #include "logtools.h"
 
+#define MAX_LINE_LENGTH 524288
+
 void
 print_usage( void )
 {
   fprintf( stderr, "\nusage: log2log <LOG-FILE> <LOG-FILE>\n");
+  fprintf( stderr, "\n  Carmen logs are converted losslessly from and to "
+	   "columnar logs\n  (output files ending in %s).\n", 
+	   CARMEN_COLLOG_EXTENSION );
+}
+
+int
+has_extension( char * filename, char * extension )
+{
+  int len = strlen(filename), ext_len = strlen(extension);
+
+  return (len >= ext_len && !strcmp( filename + len - ext_len, extension ));
+}
+
+/**************************************************************************
+ * LINE-BY-LINE CONVERSION FROM AND TO COLUMNAR LOGS
+ **************************************************************************/
+
+int
+convert_columnar( char * infilename, char * outfilename )
+{
+  carmen_FILE              * infile, * outfile = NULL;
+  carmen_collog_writer_p     writer = NULL;
+  carmen_logfile_index_p     index;
+  char                     * line;
+  int                        i, error = 0;
+
+  infile = carmen_fopen( infilename, "r" );
+  if (infile == NULL) {
+    fprintf( stderr, "ERROR: could not open file %s for reading\n",
+	     infilename );
+    return(FALSE);
+  }
+  if (has_extension( outfilename, CARMEN_COLLOG_EXTENSION ))
+    writer = carmen_collog_writer_open( outfilename );
+  else
+    outfile = carmen_fopen( outfilename, "w" );
+  if (writer == NULL && outfile == NULL) {
+    fprintf( stderr, "ERROR: could not open file %s for writing\n",
+	     outfilename );
+    carmen_fclose( infile );
+    return(FALSE);
+  }
+
+  line = (char *) malloc( MAX_LINE_LENGTH );
+  carmen_test_alloc( line );
+
+  index = carmen_logfile_index_messages( infile );
+  for (i=0; i<index->num_messages && !error; i++) {
+    carmen_logfile_read_line( index, infile, i, MAX_LINE_LENGTH, line );
+    if (writer != NULL)
+      error = (carmen_collog_write_line( writer, line ) < 0);
+    else
+      carmen_fprintf( outfile, "%s", line );
+  }
+
+  if (writer != NULL && carmen_collog_writer_close( writer ) < 0)
+    error = 1;
+  if (outfile != NULL)
+    carmen_fclose( outfile );
+  carmen_logfile_free_index( &index );
+  carmen_fclose( infile );
+  free( line );
+
+  if (error) {
+    fprintf( stderr, "ERROR: could not write file %s\n", outfilename );
+    return(FALSE);
+  }
+  return(TRUE);
 }
 
 /**************************************************************************
@@ -58,6 +129,13 @@ main(int argc, char *argv[])
     }
   }
 
+  if (carmen_collog_file_is_columnar( argv[argc-2] ) ||
+      has_extension( argv[argc-1], CARMEN_COLLOG_EXTENSION )) {
+    if (!convert_columnar( argv[argc-2], argv[argc-1] ))
+      exit(1);
+    exit(0);
+  }
+
   if (!logtools_read_logfile( &log, argv[argc-2] ))
       exit(1);
 
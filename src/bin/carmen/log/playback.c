@@ -26,6 +26,9 @@
  *
  ********************************************************/
 
+#include <pthread.h>
+#include <time.h>
+
 #include "global.h"
 
 #include "param_interface.h"
@@ -35,8 +38,19 @@
 
 #define        MAX_LINE_LENGTH           100000
 
-carmen_FILE *logfile = NULL;
-carmen_logfile_index_p logfile_index = NULL;
+#define        MAX_LOGFILES              16
+
+/* Several logs are played back on one timeline, ordered by
+   carmen_logfile_merge. A position on the timeline is a message of one
+   of the logs. */
+int num_logfiles = 0;
+char *logfile_names[MAX_LOGFILES];
+carmen_FILE *logfile[MAX_LOGFILES];
+carmen_logfile_index_p logfile_index[MAX_LOGFILES];
+int num_positions = 0;
+int *position_log = NULL, *position_message = NULL;
+double *position_time = NULL;
+double seek_time = 0.0;
 
 double playback_starttime = 0.0;
 double last_logfile_time = 0.0;
@@ -52,18 +66,8 @@ int basic_messages = 0;
 
 double playback_timestamp;
 
-carmen_base_odometry_message odometry;
-carmen_simulator_truepos_message truepos;
-carmen_robot_laser_message laser1, laser2, laser3, laser4, laser5;
-carmen_laser_laser_message rawlaser1, rawlaser2, rawlaser3, rawlaser4, rawlaser5;
-carmen_localize_globalpos_message globalpos;
-carmen_arm_state_message arm;
-carmen_base_sonar_message sonar;
-carmen_base_bumper_message bumper;
-
-carmen_imu_message imu;
-carmen_gps_gpgga_message gpsgga;
-carmen_gps_gprmc_message gpsrmc;
+void seek(int position);
+int find_position(double time);
 
 void print_playback_status(void)
 {
@@ -99,6 +103,7 @@ void playback_command_handler(carmen_playback_command_message *command)
     if(!paused)
       paused = 1;
     current_position = 0;
+    seek(0);
     playback_starttime = 0.0;
     //    fprintf(stderr, "\nRESET ");
     playback_timestamp = 0;
@@ -126,6 +131,13 @@ void playback_command_handler(carmen_playback_command_message *command)
     break;
   case CARMEN_PLAYBACK_COMMAND_SET_SPEED:
   	break;
+  case CARMEN_PLAYBACK_COMMAND_SEEK:
+    current_position = find_position(command->arg);
+    seek(current_position);
+    playback_starttime = 0.0;
+    playback_timestamp = command->arg;
+    print_playback_status();
+    break;
   }
   if(fabs(command->speed - playback_speed) > 0.001) {
     playback_starttime = 0.0;
@@ -201,132 +213,525 @@ void register_ipc_messages(void)
                            CARMEN_SUBSCRIBE_LATEST);
 }
 
-// ts is in logfile time
-void wait_for_timestamp(double ts) 
-{
-  double current_time; // in logfile time
-  struct timeval tv;
-
-  // playback_starttime is offset between file-start and playback-start
-  if(playback_starttime == 0.0)
-    playback_starttime = (carmen_get_time() - ts / playback_speed); 
-  current_time = (carmen_get_time() - playback_starttime) * playback_speed;
-  if(!fast && !paused && ts > current_time) {
-    double towait = (ts - current_time) / playback_speed;
-    tv.tv_sec = (int)floor(towait);
-    tv.tv_usec = (towait - tv.tv_sec) * 1e6;
-    select(0, NULL, NULL, NULL, &tv);
-  }
-}
-
 typedef char *(*converter_func)(char *, void *);
 
 typedef struct {
   char *logger_message_name;
   char *ipc_message_name;
   converter_func conv_func;
-  void *message_data;
+  int message_size;
   int interpreted;
 } logger_callback_t;
 
 logger_callback_t logger_callbacks[] = {
   {"RAWLASER1", CARMEN_LASER_FRONTLASER_NAME, 
-   (converter_func)carmen_string_to_laser_laser_message, &rawlaser1, 0},
+   (converter_func)carmen_string_to_laser_laser_message, 
+   sizeof(carmen_laser_laser_message), 0},
   {"RAWLASER2", CARMEN_LASER_REARLASER_NAME, 
-   (converter_func)carmen_string_to_laser_laser_message, &rawlaser2, 0},
+   (converter_func)carmen_string_to_laser_laser_message, 
+   sizeof(carmen_laser_laser_message), 0},
   {"RAWLASER3", CARMEN_LASER_LASER3_NAME, 
-   (converter_func)carmen_string_to_laser_laser_message, &rawlaser3, 0},
+   (converter_func)carmen_string_to_laser_laser_message, 
+   sizeof(carmen_laser_laser_message), 0},
   {"RAWLASER4", CARMEN_LASER_LASER4_NAME, 
-   (converter_func)carmen_string_to_laser_laser_message, &rawlaser4, 0},
+   (converter_func)carmen_string_to_laser_laser_message, 
+   sizeof(carmen_laser_laser_message), 0},
   {"RAWLASER5", CARMEN_LASER_LASER5_NAME, 
-   (converter_func)carmen_string_to_laser_laser_message, &rawlaser5, 0},
+   (converter_func)carmen_string_to_laser_laser_message, 
+   sizeof(carmen_laser_laser_message), 0},
   {"ROBOTLASER1", CARMEN_ROBOT_FRONTLASER_NAME, 
-   (converter_func)carmen_string_to_robot_laser_message, &laser1, 0},
+   (converter_func)carmen_string_to_robot_laser_message, 
+   sizeof(carmen_robot_laser_message), 0},
   {"ROBOTLASER2", CARMEN_ROBOT_REARLASER_NAME, 
-   (converter_func)carmen_string_to_robot_laser_message, &laser2, 0},
+   (converter_func)carmen_string_to_robot_laser_message, 
+   sizeof(carmen_robot_laser_message), 0},
   {"ROBOTLASER3", CARMEN_ROBOT_FRONTLASER_NAME, 
-   (converter_func)carmen_string_to_robot_laser_message, &laser3, 0},
+   (converter_func)carmen_string_to_robot_laser_message, 
+   sizeof(carmen_robot_laser_message), 0},
   {"ROBOTLASER4", CARMEN_ROBOT_FRONTLASER_NAME, 
-   (converter_func)carmen_string_to_robot_laser_message, &laser4, 0},
+   (converter_func)carmen_string_to_robot_laser_message, 
+   sizeof(carmen_robot_laser_message), 0},
   {"ROBOTLASER5", CARMEN_ROBOT_FRONTLASER_NAME, 
-   (converter_func)carmen_string_to_robot_laser_message, &laser5, 0},
+   (converter_func)carmen_string_to_robot_laser_message, 
+   sizeof(carmen_robot_laser_message), 0},
   {"ODOM", CARMEN_BASE_ODOMETRY_NAME, 
-   (converter_func)carmen_string_to_base_odometry_message, &odometry, 0},
+   (converter_func)carmen_string_to_base_odometry_message, 
+   sizeof(carmen_base_odometry_message), 0},
   {"SONAR", CARMEN_BASE_SONAR_NAME,
-    (converter_func) carmen_string_to_base_sonar_message, &sonar, 0},
+   (converter_func)carmen_string_to_base_sonar_message, 
+   sizeof(carmen_base_sonar_message), 0},
   {"BUMPER", CARMEN_BASE_BUMPER_NAME,
-    (converter_func) carmen_string_to_base_bumper_message, &bumper, 0},
+   (converter_func)carmen_string_to_base_bumper_message, 
+   sizeof(carmen_base_bumper_message), 0},
   {"ARM", CARMEN_ARM_STATE_NAME, 
-   (converter_func)carmen_string_to_arm_state_message, &arm, 0},
+   (converter_func)carmen_string_to_arm_state_message, 
+   sizeof(carmen_arm_state_message), 0},
   {"TRUEPOS", CARMEN_SIMULATOR_TRUEPOS_NAME,
-   (converter_func)carmen_string_to_simulator_truepos_message, &odometry, 0},
+   (converter_func)carmen_string_to_simulator_truepos_message, 
+   sizeof(carmen_simulator_truepos_message), 0},
   {"FLASER", CARMEN_ROBOT_FRONTLASER_NAME, 
-   (converter_func)carmen_string_to_robot_laser_message_orig, &laser1, 0},
+   (converter_func)carmen_string_to_robot_laser_message_orig, 
+   sizeof(carmen_robot_laser_message), 0},
   {"RLASER", CARMEN_ROBOT_REARLASER_NAME,
-   (converter_func)carmen_string_to_robot_laser_message_orig, &laser2, 0},
+   (converter_func)carmen_string_to_robot_laser_message_orig, 
+   sizeof(carmen_robot_laser_message), 0},
   {"LASER3", CARMEN_LASER_LASER3_NAME, 
-   (converter_func)carmen_string_to_laser_laser_message_orig, &rawlaser3, 0},
+   (converter_func)carmen_string_to_laser_laser_message_orig, 
+   sizeof(carmen_laser_laser_message), 0},
   {"LASER4", CARMEN_LASER_LASER4_NAME, 
-   (converter_func)carmen_string_to_laser_laser_message_orig, &rawlaser4, 0},
+   (converter_func)carmen_string_to_laser_laser_message_orig, 
+   sizeof(carmen_laser_laser_message), 0},
   {"LASER5", CARMEN_LASER_LASER5_NAME, 
-   (converter_func)carmen_string_to_laser_laser_message_orig, &rawlaser5, 0},
+   (converter_func)carmen_string_to_laser_laser_message_orig, 
+   sizeof(carmen_laser_laser_message), 0},
   {"IMU", CARMEN_IMU_MESSAGE_NAME,
-    (converter_func) carmen_string_to_imu_message, &imu, 0},
+   (converter_func)carmen_string_to_imu_message, 
+   sizeof(carmen_imu_message), 0},
   {"NMEAGGA", CARMEN_GPS_GPGGA_MESSAGE_NAME, 
-   (converter_func)carmen_string_to_gps_gpgga_message, &gpsgga, 0},
+   (converter_func)carmen_string_to_gps_gpgga_message, 
+   sizeof(carmen_gps_gpgga_message), 0},
   {"NMEARMC", CARMEN_GPS_GPRMC_MESSAGE_NAME, 
-   (converter_func)carmen_string_to_gps_gprmc_message, &gpsrmc, 0},
+   (converter_func)carmen_string_to_gps_gprmc_message, 
+   sizeof(carmen_gps_gprmc_message), 0},
 };
 
-int read_message(int message_num, int publish)
+#define NUM_LOGGER_CALLBACKS \
+  ((int)(sizeof(logger_callbacks) / sizeof(logger_callback_t)))
+
+/* message types by the hash of their name, for dispatching a line
+   without comparing its first word against every name */
+
+#define DISPATCH_TABLE_SIZE       64
+
+int dispatch_table[DISPATCH_TABLE_SIZE];
+
+unsigned int hash_word(char *word, int *length)
 {
-  char line[MAX_LINE_LENGTH], *current_pos;
-  IPC_RETURN_TYPE err;
-  int i, j;
-  char command[100];
-  static double last_update = 0;
-  double current_time;
-
-  carmen_logfile_read_line(logfile_index, logfile, message_num, 
-			   MAX_LINE_LENGTH, line);
-  current_pos = carmen_next_word(line);
-
-  for(i = 0; i < (int)(sizeof(logger_callbacks) / 
-		       sizeof(logger_callback_t)); i++) {
-    /* copy the command over */
-    j = 0;
-    while(line[j] != ' ') {
-      command[j] = line[j];
-      j++;
+  unsigned int hash = 2166136261u;
+  int i;
+
+  for(i = 0; word[i] != ' ' && word[i] != '\0' && word[i] != '\n'; i++)
+    hash = (hash ^ (unsigned char)word[i]) * 16777619u;
+  *length = i;
+  return hash;
+}
+
+void build_dispatch_table(void)
+{
+  unsigned int h;
+  int i, length;
+
+  for(h = 0; h < DISPATCH_TABLE_SIZE; h++)
+    dispatch_table[h] = -1;
+  for(i = 0; i < NUM_LOGGER_CALLBACKS; i++) {
+    h = hash_word(logger_callbacks[i].logger_message_name, &length) % 
+      DISPATCH_TABLE_SIZE;
+    while(dispatch_table[h] >= 0)
+      h = (h + 1) % DISPATCH_TABLE_SIZE;
+    dispatch_table[h] = i;
+  }
+}
+
+/* returns the index into logger_callbacks of the message in line, or -1 */
+int message_type(char *line)
+{
+  unsigned int h;
+  int length, i;
+
+  h = hash_word(line, &length) % DISPATCH_TABLE_SIZE;
+  while((i = dispatch_table[h]) >= 0) {
+    if(strncmp(line, logger_callbacks[i].logger_message_name, length) == 0 &&
+       logger_callbacks[i].logger_message_name[length] == '\0')
+      return i;
+    h = (h + 1) % DISPATCH_TABLE_SIZE;
+  }
+  return -1;
+}
+
+/* The decoder thread reads and converts messages ahead of playback into
+   a bounded queue, so that the main thread only waits and publishes.
+   Each slot keeps a message of every type it has held, so the arrays
+   the converters allocate are reused. */
+
+#define PLAYBACK_QUEUE_SIZE       256
+
+typedef struct {
+  int position;
+  int type;                   /* -1 marks the end of the log */
+  double timestamp;
+  void *messages[NUM_LOGGER_CALLBACKS];
+} playback_slot_t;
+
+playback_slot_t playback_queue[PLAYBACK_QUEUE_SIZE];
+int queue_head = 0, queue_tail = 0;
+/* bumped by every seek, so the decoder drops what it was converting */
+int queue_generation = 0;
+int decode_position = 0;
+int decoder_done = 0;
+pthread_mutex_t queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t queue_not_full = PTHREAD_COND_INITIALIZER;
+pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
+pthread_mutex_t logfile_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_t decoder_thread;
+
+/* messages are only played back up to the one before the last */
+int last_position(void)
+{
+  return num_positions - 1;
+}
+
+void build_timeline(void)
+{
+  carmen_logfile_merge_p merge;
+  int i, log, message;
+  double time;
+
+  for(i = 0; i < num_logfiles; i++)
+    num_positions += logfile_index[i]->num_messages;
+  position_log = (int *)calloc(num_positions, sizeof(int));
+  carmen_test_alloc(position_log);
+  position_message = (int *)calloc(num_positions, sizeof(int));
+  carmen_test_alloc(position_message);
+  position_time = (double *)calloc(num_positions, sizeof(double));
+  carmen_test_alloc(position_time);
+
+  merge = carmen_logfile_merge_new(num_logfiles, logfile_index);
+  for(i = 0; carmen_logfile_merge_next(merge, &log, &message, &time); i++) {
+    position_log[i] = log;
+    position_message[i] = message;
+    position_time[i] = time;
+  }
+  carmen_logfile_merge_free(merge);
+}
+
+/* returns the first position at or after time */
+int find_position(double time)
+{
+  int low = 0, high = last_position(), middle;
+
+  while(low < high) {
+    middle = low + (high - low) / 2;
+    if(position_time[middle] < time)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low;
+}
+
+typedef int (*reader_func)(carmen_logfile_index_p, carmen_FILE *, int, int,
+			   char *, void *);
+
+/* readers that decode the ranges of a columnar log straight into the
+   message, for the converters that parse them from text */
+reader_func laser_reader(converter_func conv_func)
+{
+  if(conv_func == (converter_func)carmen_string_to_laser_laser_message ||
+     conv_func == (converter_func)carmen_string_to_laser_laser_message_orig)
+    return (reader_func)carmen_logfile_read_laser_laser_message;
+  if(conv_func == (converter_func)carmen_string_to_robot_laser_message ||
+     conv_func == (converter_func)carmen_string_to_robot_laser_message_orig)
+    return (reader_func)carmen_logfile_read_robot_laser_message;
+  return NULL;
+}
+
+/* returns the type of the message at position and reads its line, unless
+   *reader is set to the reader of a laser message of a columnar log */
+int read_message(int position, char *line, reader_func *reader)
+{
+  carmen_logfile_index_p index;
+  int type, log = position_log[position];
+
+  index = logfile_index[log];
+  *reader = NULL;
+  if(index->columnar != NULL) {
+    pthread_mutex_lock(&logfile_mutex);
+    type = message_type((char *)carmen_collog_message_type
+			(index->columnar, position_message[position]));
+    pthread_mutex_unlock(&logfile_mutex);
+    if(type >= 0 && basic_messages && logger_callbacks[type].interpreted)
+      return -1;
+    if(type >= 0)
+      *reader = laser_reader(logger_callbacks[type].conv_func);
+    if(*reader != NULL)
+      return type;
+  }
+
+  pthread_mutex_lock(&logfile_mutex);
+  carmen_logfile_read_line(index, logfile[log], 
+			   position_message[position], MAX_LINE_LENGTH, line);
+  pthread_mutex_unlock(&logfile_mutex);
+  type = message_type(line);
+  if(type >= 0 && basic_messages && logger_callbacks[type].interpreted)
+    return -1;
+  return type;
+}
+
+void decode_message(playback_slot_t *slot, int position, char *line)
+{
+  logger_callback_t *callback;
+  reader_func reader = NULL;
+  char *current_pos;
+  int log;
+
+  slot->position = position;
+  slot->type = position < last_position() ? 
+    read_message(position, line, &reader) : -1;
+  if(slot->type < 0)
+    return;
+
+  callback = logger_callbacks + slot->type;
+  if(slot->messages[slot->type] == NULL) {
+    slot->messages[slot->type] = calloc(1, callback->message_size);
+    carmen_test_alloc(slot->messages[slot->type]);
+  }
+  if(reader != NULL) {
+    log = position_log[position];
+    pthread_mutex_lock(&logfile_mutex);
+    reader(logfile_index[log], logfile[log], position_message[position],
+	   MAX_LINE_LENGTH, line, slot->messages[slot->type]);
+    pthread_mutex_unlock(&logfile_mutex);
+  }
+  else {
+    current_pos = carmen_next_word(line);
+    callback->conv_func(current_pos, slot->messages[slot->type]);
+  }
+  slot->timestamp = position_time[position];
+}
+
+void *decoder_main(void *arg __attribute__ ((unused)))
+{
+  static char line[MAX_LINE_LENGTH];
+  playback_slot_t *slot;
+  int generation, position;
+
+  pthread_mutex_lock(&queue_mutex);
+  while(!decoder_done) {
+    if(queue_tail - queue_head == PLAYBACK_QUEUE_SIZE || 
+       decode_position > last_position()) {
+      pthread_cond_wait(&queue_not_full, &queue_mutex);
+      continue;
     }
-    command[j] = '\0';
-    if(strncmp(command, logger_callbacks[i].logger_message_name, j) == 0) {
-      if(!basic_messages || !logger_callbacks[i].interpreted) {
-	current_pos = 
-	  logger_callbacks[i].conv_func(current_pos, 
-					logger_callbacks[i].message_data);
-	playback_timestamp = atof(current_pos);
-	if(publish) {
-	  current_time = carmen_get_time();
-	  if(current_time - last_update > 1.0) {
-	    print_playback_status();
-	    last_update = current_time;
-	  }
-	  wait_for_timestamp(playback_timestamp);
-	  err = IPC_publishData(logger_callbacks[i].ipc_message_name, 
-				logger_callbacks[i].message_data);
-	}
-	/* return 1 if it is a front laser message */
-	return (strcmp(command, "FLASER") == 0);
-      }
+    generation = queue_generation;
+    position = decode_position;
+    slot = playback_queue + queue_tail % PLAYBACK_QUEUE_SIZE;
+    pthread_mutex_unlock(&queue_mutex);
+
+    decode_message(slot, position, line);
+
+    pthread_mutex_lock(&queue_mutex);
+    if(generation != queue_generation)
+      continue;
+    decode_position = position + 1;
+    /* lines that are not played back are not queued, the end is */
+    if(slot->type >= 0 || position >= last_position()) {
+      queue_tail++;
+      pthread_cond_signal(&queue_not_empty);
     }
   }
+  pthread_mutex_unlock(&queue_mutex);
+  return NULL;
+}
+
+void start_decoder(void)
+{
+  build_dispatch_table();
+  if(pthread_create(&decoder_thread, NULL, decoder_main, NULL) != 0)
+    carmen_die("Error: could not start the decoder thread.\n");
+}
+
+void stop_decoder(void)
+{
+  pthread_mutex_lock(&queue_mutex);
+  decoder_done = 1;
+  pthread_cond_signal(&queue_not_full);
+  pthread_mutex_unlock(&queue_mutex);
+  pthread_join(decoder_thread, NULL);
+}
+
+/* drops the queue and continues decoding at position */
+void seek(int position)
+{
+  pthread_mutex_lock(&queue_mutex);
+  queue_generation++;
+  queue_head = queue_tail;
+  decode_position = position;
+  pthread_cond_signal(&queue_not_full);
+  pthread_mutex_unlock(&queue_mutex);
+}
+
+/* returns the next slot once it is decoded, or NULL if the decoder
+   does not get there within timeout seconds */
+playback_slot_t *peek_message(double timeout)
+{
+  playback_slot_t *slot = NULL;
+  struct timespec deadline;
+
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += (int)timeout;
+  deadline.tv_nsec += (timeout - (int)timeout) * 1e9;
+  if(deadline.tv_nsec >= 1000000000) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+
+  pthread_mutex_lock(&queue_mutex);
+  while(queue_head == queue_tail && 
+	pthread_cond_timedwait(&queue_not_empty, &queue_mutex, 
+			       &deadline) == 0);
+  if(queue_head != queue_tail)
+    slot = playback_queue + queue_head % PLAYBACK_QUEUE_SIZE;
+  pthread_mutex_unlock(&queue_mutex);
+  return slot;
+}
+
+void pop_message(void)
+{
+  pthread_mutex_lock(&queue_mutex);
+  queue_head++;
+  pthread_cond_signal(&queue_not_full);
+  pthread_mutex_unlock(&queue_mutex);
+}
+
+/* Pacing runs on the monotonic clock and sleeps until an absolute time,
+   so the time spent publishing does not add up over messages. */
+
+#define MAX_SLEEP                 0.02
+
+#define NUM_JITTER_BINS           8
+
+double jitter_bins[NUM_JITTER_BINS] = {0.0001, 0.00025, 0.0005, 0.001, 
+				       0.002, 0.005, 0.01, HUGE_VAL};
+int jitter_histogram[NUM_JITTER_BINS];
+double max_jitter = 0.0;
+
+double monotonic_time(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void record_jitter(double jitter)
+{
+  int i;
+
+  jitter = fabs(jitter);
+  for(i = 0; jitter >= jitter_bins[i]; i++);
+  jitter_histogram[i]++;
+  if(jitter > max_jitter)
+    max_jitter = jitter;
+}
+
+void print_jitter_histogram(void)
+{
+  int i, n = 0;
+
+  for(i = 0; i < NUM_JITTER_BINS; i++)
+    n += jitter_histogram[i];
+  if(n == 0)
+    return;
+
+  fprintf(stderr, "\nTiming error of %d messages:\n", n);
+  for(i = 0; i < NUM_JITTER_BINS; i++)
+    if(jitter_bins[i] < HUGE_VAL)
+      fprintf(stderr, "  < %6.2f ms   %6.2f%%\n", jitter_bins[i] * 1e3, 
+	      100.0 * jitter_histogram[i] / n);
+    else
+      fprintf(stderr, " >= %6.2f ms   %6.2f%%\n", jitter_bins[i - 1] * 1e3,
+	      100.0 * jitter_histogram[i] / n);
+  fprintf(stderr, "  max %.3f ms\n", max_jitter * 1e3);
+  memset(jitter_histogram, 0, sizeof(jitter_histogram));
+  max_jitter = 0.0;
+}
+
+// ts is in logfile time. Returns the time ts is due at, or 0 if it is
+// further than MAX_SLEEP away and IPC should be handled first.
+double wait_for_timestamp(double ts) 
+{
+  struct timespec deadline;
+  double current_time, due;
+
+  // playback_starttime is offset between file-start and playback-start
+  current_time = monotonic_time();
+  if(playback_starttime == 0.0)
+    playback_starttime = current_time - ts / playback_speed; 
+  due = playback_starttime + ts / playback_speed;
+  if(fast || paused || due <= current_time)
+    return due;
+  if(due - current_time > MAX_SLEEP) {
+    due = current_time + MAX_SLEEP;
+    deadline.tv_sec = (time_t)due;
+    deadline.tv_nsec = (due - deadline.tv_sec) * 1e9;
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, 
+			  &deadline, NULL) == EINTR);
+    return 0.0;
+  }
+  deadline.tv_sec = (time_t)due;
+  deadline.tv_nsec = (due - deadline.tv_sec) * 1e9;
+  while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, 
+			&deadline, NULL) == EINTR);
+  return due;
+}
+
+/* Publishes the next message if it is due. Returns 1 if it published
+   a message, -1 at the end of the log, and 0 otherwise. */
+int publish_message(int *laser)
+{
+  static double last_update = 0;
+  playback_slot_t *slot;
+  double current_time, due;
+  
+  slot = peek_message(MAX_SLEEP);
+  if(slot == NULL)
+    return 0;
+  if(slot->type < 0)
+    return -1;
+
+  due = wait_for_timestamp(slot->timestamp);
+  if(due == 0.0)
+    return 0;
+  current_time = monotonic_time();
+  if(!fast && !paused)
+    record_jitter(current_time - due);
+  IPC_publishData(logger_callbacks[slot->type].ipc_message_name, 
+		  slot->messages[slot->type]);
+
+  playback_timestamp = slot->timestamp;
+  current_position = slot->position + 1;
+  /* FLASER is the frame for stepping */
+  *laser = (strcmp(logger_callbacks[slot->type].logger_message_name, 
+		   "FLASER") == 0);
+  pop_message();
+
+  if(current_time - last_update > 1.0) {
+    print_playback_status();
+    last_update = current_time;
+  }
+  return 1;
+}
+
+/* returns the position of the last FLASER before position, or 0 */
+int previous_laser(int position)
+{
+  static char line[MAX_LINE_LENGTH];
+  reader_func reader;
+  int type;
+
+  while(position > 0) {
+    position--;
+    type = read_message(position, line, &reader);
+    if(type >= 0 && strcmp(logger_callbacks[type].logger_message_name, 
+			   "FLASER") == 0)
+      return position;
+  }
   return 0;
 }
 
 void main_playback_loop(void)
 {
-  int laser;
+  int laser, published;
 
   print_playback_status();
   while(1) {
@@ -335,43 +740,35 @@ void main_playback_loop(void)
       current_position += offset;
       if(current_position < 0)
 	current_position = 0;
-      if(current_position >= logfile_index->num_messages - 1)
-	current_position = logfile_index->num_messages - 2;
+      if(current_position >= last_position())
+	current_position = last_position() - 1;
       offset = 0;
+      seek(current_position);
     }
     
-    if(!paused && current_position >= logfile_index->num_messages - 1) {
-      paused = 1;
-      current_position = 0;
-      playback_starttime = 0.0;
-      playback_timestamp = 0;
-      print_playback_status();
-    }
-    else if(!paused && current_position < logfile_index->num_messages - 1) {
-      read_message(current_position, 1);
-      current_position++;
+    if(!paused) {
+      if(publish_message(&laser) < 0) {
+	paused = 1;
+	current_position = 0;
+	playback_starttime = 0.0;
+	playback_timestamp = 0;
+	seek(0);
+	print_jitter_histogram();
+	print_playback_status();
+      }
     }
-    else if(paused && advance_frame) {
+    else if(advance_frame) {
       laser = 0;
-      while(current_position < logfile_index->num_messages - 1 && !laser) {
-	laser = read_message(current_position, 1);
-	current_position++;
-      } 
+      while(!laser && (published = publish_message(&laser)) >= 0)
+	if(!published)
+	  carmen_ipc_sleep(0.0001);
       advance_frame = 0;
     }
-    else if(paused && rewind_frame) {
-      laser = 0;
-      while(current_position > 0 && !laser) {
-	current_position--;
-	laser = read_message(current_position, 0);
-      } 
-      laser = 0;
-      while(current_position > 0 && !laser) {
-	current_position--;
-	laser = read_message(current_position, 0);
-      }
-      read_message(current_position, 1);
-      current_position++;
+    else if(rewind_frame) {
+      /* back to the laser before the one last published */
+      current_position = previous_laser(previous_laser(current_position));
+      seek(current_position);
+      while(!publish_message(&laser));
       rewind_frame = 0;
     }
     if(paused)
@@ -392,8 +789,9 @@ void usage(char *fmt, ...)
   vfprintf(stderr, fmt, args);
   va_end(args);
   
-  fprintf(stderr, "Usage: playback filename <args>\n");
+  fprintf(stderr, "Usage: playback filename [filename ...] <args>\n");
   fprintf(stderr, "\t-fast         - ignore timestamps.\n");
+  fprintf(stderr, "\t-seek <s>     - start s seconds into the log.\n");
   exit(-1);
 }
 
@@ -404,7 +802,7 @@ void read_parameters(int argc, char **argv)
   if(argc < 2)
     usage("Needs at least one argument.\n");
 
-  for(index = 0; index < argc; index++) {
+  for(index = 1; index < argc; index++) {
     if(strncmp(argv[index], "-h", 2) == 0 || 
        strncmp(argv[index], "--help", 6) == 0)
       usage(NULL);
@@ -414,12 +812,25 @@ void read_parameters(int argc, char **argv)
       paused = 0;
     if(strncmp(argv[index], "-basic", 6) == 0)
       basic_messages = 1;
+    if(strncmp(argv[index], "-seek", 5) == 0) {
+      if(index + 1 == argc)
+	usage("-seek needs the time to start at.\n");
+      seek_time = atof(argv[++index]);
+    }
+    else if(argv[index][0] != '-') {
+      if(num_logfiles == MAX_LOGFILES)
+	usage("Can play back at most %d logs.\n", MAX_LOGFILES);
+      logfile_names[num_logfiles++] = argv[index];
+    }
   }
+  if(num_logfiles == 0)
+    usage("Needs a logfile.\n");
 }
 
 void shutdown_playback_module(int sig)
 {
   if(sig == SIGINT) {
+    print_jitter_histogram();
     fprintf(stderr, "\n");
     exit(1);
   }
@@ -427,25 +838,7 @@ void shutdown_playback_module(int sig)
 
 int main(int argc, char **argv)
 {
-  memset(&odometry, 0, sizeof(odometry));
-  memset(&arm, 0, sizeof(arm));
-  memset(&imu, 0, sizeof(imu));
-  memset(&sonar, 0, sizeof(sonar));
-  memset(&bumper, 0, sizeof(bumper));
-  memset(&truepos, 0, sizeof(truepos));
-  memset(&laser1, 0, sizeof(laser1));
-  memset(&laser2, 0, sizeof(laser2));
-  memset(&laser3, 0, sizeof(laser3));
-  memset(&laser4, 0, sizeof(laser4));
-  memset(&laser5, 0, sizeof(laser5));
-  memset(&rawlaser1, 0, sizeof(rawlaser1));
-  memset(&rawlaser2, 0, sizeof(rawlaser2));
-  memset(&rawlaser3, 0, sizeof(rawlaser3));
-  memset(&rawlaser4, 0, sizeof(rawlaser4));
-  memset(&rawlaser5, 0, sizeof(rawlaser5));
-  memset(&gpsgga, 0, sizeof(gpsgga));
-  memset(&gpsrmc, 0, sizeof(gpsrmc));
-
+  int i;
 
   carmen_ipc_initialize(argc, argv);
   carmen_param_check_version(argv[0]);
@@ -454,11 +847,23 @@ int main(int argc, char **argv)
   read_parameters(argc, argv);
   signal(SIGINT, shutdown_playback_module);
   
-  logfile = carmen_fopen(argv[1], "r");
-  if(logfile == NULL)
-    carmen_die("Error: could not open file %s for reading.\n", argv[1]);
-  logfile_index = carmen_logfile_index_messages(logfile);
+  for(i = 0; i < num_logfiles; i++) {
+    logfile[i] = carmen_fopen(logfile_names[i], "r");
+    if(logfile[i] == NULL)
+      carmen_die("Error: could not open file %s for reading.\n", 
+		 logfile_names[i]);
+    logfile_index[i] = carmen_logfile_index_messages_cached(logfile[i],
+							    logfile_names[i]);
+  }
+  build_timeline();
+  if(seek_time > 0.0) {
+    current_position = find_position(seek_time);
+    decode_position = current_position;
+    playback_timestamp = seek_time;
+  }
+  start_decoder();
   main_playback_loop();
+  stop_decoder();
   return 0;
 }
 
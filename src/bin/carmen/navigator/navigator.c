@@ -48,6 +48,10 @@ static carmen_base_odometry_message last_odometry;
 static carmen_robot_laser_message frontlaser, rearlaser;
 static carmen_localize_globalpos_message globalpos;
 
+static carmen_hmap_t hmap;
+static carmen_hmap_planner_p hmap_planner = NULL;
+static char *map_zone = NULL;
+
 static void base_odometry_handler(void)
 {
   static int odometry_initialised = 0;
@@ -206,12 +210,67 @@ robot_rearlaser_handler(void)
 
 }
 
+/* Uses the costs built in the background for the current zone, if they
+   belong to nav_map. */
+static void
+set_planner_map(void)
+{
+  carmen_map_config_t config;
+  double *costs = NULL;
+  int zone;
+
+  if (hmap_planner != NULL && map_zone != NULL) {
+    zone = carmen_hmap_find_zone(&hmap, map_zone);
+    if (zone >= 0)
+      costs = carmen_hmap_planner_zone_costs(hmap_planner, zone, &config);
+    if (costs != NULL && (config.x_size != nav_map->config.x_size ||
+			  config.y_size != nav_map->config.y_size ||
+			  config.resolution != nav_map->config.resolution))
+      costs = NULL;
+  }
+
+  if (costs != NULL)
+    carmen_planner_set_map_with_costs(nav_map, costs);
+  else
+    carmen_planner_set_map(nav_map, &robot_config);
+}
+
 static void
 map_update_handler(carmen_map_t *new_map)
 {
   carmen_map_destroy(&nav_map);
   nav_map = carmen_map_copy(new_map);
-  carmen_planner_set_map(nav_map, &robot_config);
+  set_planner_map();
+}
+
+static void
+map_zone_handler(char **zone_name)
+{
+  carmen_navigator_change_zone(*zone_name);
+}
+
+static carmen_map_p
+load_zone_map(char *zone_name, void *data __attribute__ ((unused)))
+{
+  carmen_map_p map;
+  carmen_offlimits_p offlimits;
+  int num_offlimits_segments;
+
+  map = (carmen_map_p)calloc(1, sizeof(carmen_map_t));
+  carmen_test_alloc(map);
+
+  if (carmen_map_get_gridmap_by_name(zone_name, map) < 0) {
+    free(map);
+    return NULL;
+  }
+  if (carmen_map_get_offlimits_by_name(zone_name, &offlimits,
+				       &num_offlimits_segments) == 0) {
+    carmen_map_apply_offlimits_chunk_to_map(offlimits,
+					    num_offlimits_segments, map);
+    free(offlimits);
+  }
+
+  return map;
 }
 
 static void
@@ -220,6 +279,8 @@ navigator_shutdown(int signo __attribute__ ((unused)) )
   static int done = 0;
 
   if(!done) {
+    if (hmap_planner != NULL)
+      carmen_hmap_planner_free(hmap_planner);
     carmen_ipc_disconnect();
     printf("Disconnected from IPC.\n");
 
@@ -295,7 +356,7 @@ read_parameters(int argc, char **argv)
 int main(int argc, char **argv)
 {
   handler handler_func;
-  int x, y;
+  int x, y, zone;
   carmen_offlimits_p offlimits;
   int num_offlimits_segments;
   char *goal_string;
@@ -304,6 +365,7 @@ int main(int argc, char **argv)
   carmen_param_check_version(argv[0]);
 
   read_parameters(argc, argv);
+  carmen_simulator_initialize_clock(argc, argv);
 
   if(carmen_navigator_initialize_ipc() < 0)
     carmen_die("Error: could not connect to IPC Server\n");
@@ -311,6 +373,23 @@ int main(int argc, char **argv)
   handler_func = navigator_shutdown;
   signal(SIGINT, handler_func);
 
+  /* The map server only publishes the zone when it changes, so ask for
+     the one it serves now; goals and the first map both need it. */
+  if (carmen_map_get_hmap(&hmap) == 0 && hmap.num_zones > 1) {
+    hmap_planner = carmen_hmap_planner_new(&hmap, &robot_config,
+					   load_zone_map, NULL);
+    carmen_navigator_set_hmap_planner(hmap_planner);
+    carmen_map_subscribe_map_zone_message
+      (&map_zone, (carmen_handler_t)map_zone_handler,
+       CARMEN_SUBSCRIBE_LATEST);
+    if (carmen_map_get_zone(&map_zone) == 0 && map_zone != NULL) {
+      zone = carmen_hmap_find_zone(&hmap, map_zone);
+      if (zone >= 0 && carmen_hmap_planner_prefetch(hmap_planner, zone) == 0)
+	carmen_hmap_planner_wait_zone(hmap_planner, zone);
+      carmen_navigator_change_zone(map_zone);
+    }
+  }
+
   nav_map = (carmen_map_p)calloc(1, sizeof(carmen_map_t));
   carmen_test_alloc(nav_map);
 
@@ -319,7 +398,7 @@ int main(int argc, char **argv)
   carmen_map_apply_offlimits_chunk_to_map(offlimits, num_offlimits_segments,
 					  nav_map);
   carmen_map_get_placelist(&placelist);
-  carmen_planner_set_map(nav_map, &robot_config);
+  set_planner_map();
 
   if(!nav_config.dont_integrate_odometry)
     carmen_base_subscribe_odometry_message
@@ -64,6 +64,10 @@ static char *default_list[] = {"carmen.ini", "../carmen.ini",
 static carmen_ini_param_p param_list = NULL;
 static int num_params = 0;
 static int param_table_capacity = 0;
+
+/* Open-addressing index of param_list by lvalue, at most half full */
+static int *param_hash = NULL;
+static int param_hash_size = 0;
 #ifndef COMPILE_WITHOUT_MAP_SUPPORT
 static char *map_filename = NULL;
 #endif
@@ -93,18 +97,64 @@ shutdown_param_server(int signo)
   }
 }
 
-static int
-lookup_name(char *full_name) 
+static unsigned int
+hash_name(const char *name)
+{
+  unsigned int hash = 2166136261u;
+
+  for (; *name != '\0'; name++)
+    hash = (hash ^ (unsigned char)tolower(*name)) * 16777619u;
+
+  return hash;
+}
+
+static void
+hash_param(int param_index)
+{
+  unsigned int slot;
+
+  slot = hash_name(param_list[param_index].lvalue) & (param_hash_size - 1);
+  while (param_hash[slot] >= 0)
+    slot = (slot + 1) & (param_hash_size - 1);
+  param_hash[slot] = param_index;
+}
+
+static void
+check_hash_space(void)
 {
   int index;
-  unsigned int name_length;
 
-  name_length = strlen(full_name);
+  if (2 * (num_params + 1) <= param_hash_size)
+    return;
+
+  free(param_hash);
+  if (param_hash_size == 0)
+    param_hash_size = 256;
+  while (2 * (num_params + 1) > param_hash_size)
+    param_hash_size *= 2;
+  param_hash = (int *)malloc(param_hash_size * sizeof(int));
+  carmen_test_alloc(param_hash);
+
+  for (index = 0; index < param_hash_size; index++)
+    param_hash[index] = -1;
   for (index = 0; index < num_params; index++)
-    {
-      if (carmen_strcasecmp(param_list[index].lvalue, full_name) == 0)
-	return index;
-    }
+    hash_param(index);
+}
+
+static int
+lookup_name(char *full_name) 
+{
+  unsigned int slot;
+
+  if (param_hash_size == 0)
+    return -1;
+
+  slot = hash_name(full_name) & (param_hash_size - 1);
+  while (param_hash[slot] >= 0) {
+    if (carmen_strcasecmp(param_list[param_hash[slot]].lvalue, full_name) == 0)
+      return param_hash[slot];
+    slot = (slot + 1) & (param_hash_size - 1);
+  }
 
   return -1;
 }
@@ -202,12 +252,14 @@ set_param(char *lvalue, char *rvalue, int param_level)
       }
 
       check_param_space();
+      check_hash_space();
       param_index = num_params;
       num_params++;
       param_list[param_index].lvalue = (char *)calloc
 	(strlen(lvalue)+1, sizeof(char));
       carmen_test_alloc(param_list[param_index].lvalue);
       strcpy(param_list[param_index].lvalue, lvalue);
+      hash_param(param_index);
             
       param_list[param_index].module_name = (char *)calloc
 	(strlen(module)+1, sizeof(char));
@@ -901,6 +953,104 @@ get_param_all(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
 }
 
 
+static void
+get_param_bulk(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
+	       void *clientData __attribute__ ((unused)))
+{
+  FORMATTER_PTR formatter;
+  IPC_RETURN_TYPE err = IPC_OK; 
+  carmen_param_query_bulk_message query;
+  carmen_param_response_bulk_message response; 
+  int *indices;
+  int num_indices, query_index, param_index;
+
+  formatter = IPC_msgInstanceFormatter(msgRef);
+  err = IPC_unmarshallData(formatter, callData, &query, 
+                           sizeof(carmen_param_query_bulk_message));
+  IPC_freeByteArray(callData);
+  
+  carmen_test_ipc_return(err, "Could not unmarshall", 
+			 IPC_msgInstanceName(msgRef));  
+
+  /* Resolve the query into parameter indices, -1 for unknown variables.
+     Empty strings arrive as NULL. */
+  num_indices = 0;
+  for (query_index = 0; query_index < query.num_variables; query_index++)
+    if (query.variable_names[query_index] == NULL)
+      continue;
+    else if (strcmp(query.variable_names[query_index], "*") == 0) {
+      if (query.module_names[query_index] != NULL)
+	num_indices += query_num_params(query.module_names[query_index]);
+    } else
+      num_indices++;
+
+  indices = (int *)calloc(num_indices + 1, sizeof(int));
+  carmen_test_alloc(indices);
+  response.num_variables = num_indices;
+  response.module_names = (char **)calloc(num_indices + 1, sizeof(char *));
+  carmen_test_alloc(response.module_names);
+  response.variable_names = (char **)calloc(num_indices + 1, sizeof(char *));
+  carmen_test_alloc(response.variable_names);
+  response.values = (char **)calloc(num_indices + 1, sizeof(char *));
+  carmen_test_alloc(response.values);
+  response.expert = (int *)calloc(num_indices + 1, sizeof(int));
+  carmen_test_alloc(response.expert);
+  response.status = (int *)calloc(num_indices + 1, sizeof(int));
+  carmen_test_alloc(response.status);
+
+  num_indices = 0;
+  for (query_index = 0; query_index < query.num_variables; query_index++) {
+    if (query.variable_names[query_index] == NULL)
+      continue;
+    else if (strcmp(query.variable_names[query_index], "*") == 0) {
+      if (query.module_names[query_index] == NULL)
+	continue;
+      for (param_index = 0; param_index < num_params; param_index++)
+	if (carmen_strcasecmp(param_list[param_index].module_name,
+			      query.module_names[query_index]) == 0) {
+	  response.module_names[num_indices] =
+	    param_list[param_index].module_name;
+	  response.variable_names[num_indices] =
+	    param_list[param_index].variable_name;
+	  indices[num_indices++] = param_index;
+	}
+    } else {
+      response.module_names[num_indices] = query.module_names[query_index];
+      response.variable_names[num_indices] =
+	query.variable_names[query_index];
+      indices[num_indices++] =
+	lookup_parameter(query.module_names[query_index],
+			 query.variable_names[query_index]);
+    }
+  }
+
+  for (query_index = 0; query_index < num_indices; query_index++) {
+    param_index = indices[query_index];
+    if (param_index < 0) {
+      response.values[query_index] = "";
+      response.status[query_index] = CARMEN_PARAM_NOT_FOUND;
+    } else {
+      response.values[query_index] = param_list[param_index].rvalue;
+      response.expert[query_index] = param_list[param_index].expert;
+      response.status[query_index] = CARMEN_PARAM_OK;
+    }
+  }
+
+  response.timestamp = carmen_get_time();
+  response.host = carmen_get_host();
+
+  err = IPC_respondData(msgRef, CARMEN_PARAM_RESPONSE_BULK_NAME, &response);
+  carmen_test_ipc(err, "Could not respond", CARMEN_PARAM_RESPONSE_BULK_NAME);
+
+  free(indices);
+  free(response.module_names);
+  free(response.variable_names);
+  free(response.values);
+  free(response.expert);
+  free(response.status);
+  IPC_freeDataElements(formatter, &query);
+}
+
 static void
 get_param_int(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
 	      void *clientData)
@@ -1216,6 +1366,16 @@ initialize_param_ipc(void)
   carmen_test_ipc_exit(err, "Could not define message", 
 		       CARMEN_PARAM_RESPONSE_ALL_NAME);
   
+  err = IPC_defineMsg(CARMEN_PARAM_QUERY_BULK_NAME, IPC_VARIABLE_LENGTH, 
+		      CARMEN_PARAM_QUERY_BULK_FMT);
+  carmen_test_ipc_exit(err, "Could not define message", 
+		       CARMEN_PARAM_QUERY_BULK_NAME);
+  
+  err = IPC_defineMsg(CARMEN_PARAM_RESPONSE_BULK_NAME, IPC_VARIABLE_LENGTH, 
+		      CARMEN_PARAM_RESPONSE_BULK_FMT);
+  carmen_test_ipc_exit(err, "Could not define message", 
+		       CARMEN_PARAM_RESPONSE_BULK_NAME);
+  
   err = IPC_defineMsg(CARMEN_PARAM_QUERY_INT_NAME, IPC_VARIABLE_LENGTH, 
 		      CARMEN_PARAM_QUERY_FMT);
   carmen_test_ipc_exit(err, "Could not define message", 
@@ -1295,6 +1455,11 @@ initialize_param_ipc(void)
 		       CARMEN_PARAM_QUERY_ALL_NAME);
   IPC_setMsgQueueLength(CARMEN_PARAM_QUERY_ALL_NAME, 100);
 
+  err = IPC_subscribe(CARMEN_PARAM_QUERY_BULK_NAME, get_param_bulk, NULL);
+  carmen_test_ipc_exit(err, "Could not subscribe to", 
+		       CARMEN_PARAM_QUERY_BULK_NAME);
+  IPC_setMsgQueueLength(CARMEN_PARAM_QUERY_BULK_NAME, 100);
+
   err = IPC_subscribe(CARMEN_PARAM_QUERY_INT_NAME, get_param_int, NULL);
   carmen_test_ipc_exit(err, "Could not subscribe to", 
 		       CARMEN_PARAM_QUERY_INT_NAME);
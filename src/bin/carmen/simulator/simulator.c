@@ -42,6 +42,17 @@
 static carmen_simulator_config_t *simulator_config;
 static int use_robot = 1;
 
+/* lockstep mode */
+static int lockstep = 0;
+static int lockstep_consumers = 0;
+static double lockstep_timeout = 1.0;
+static double lockstep_duration = 0.0;
+static int lockstep_step = 0;
+static int lockstep_acks = 0;
+static int lockstep_timeouts = 0;
+static double lockstep_start_time = 0.0;
+static double lockstep_start_wall_time = 0.0;
+
 static int publish_readings(void);
 
 /* handlers */
@@ -188,6 +199,23 @@ static void next_tick_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
   }
 }
 
+static void clock_ack_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData, 
+			      void *clientData __attribute__ ((unused)))
+{
+  carmen_simulator_clock_ack_message msg;
+  FORMATTER_PTR formatter;
+  
+  formatter = IPC_msgInstanceFormatter(msgRef);
+  IPC_unmarshallData(formatter, callData, &msg,
+                     sizeof(carmen_simulator_clock_ack_message));
+  IPC_freeByteArray(callData);
+
+  if (msg.step == lockstep_step)
+    lockstep_acks++;
+
+  IPC_freeDataElements(formatter, &msg);
+}
+
 static void truepos_query_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData, 
 				  void *clientData __attribute__ ((unused)))
 {
@@ -208,10 +236,25 @@ static void truepos_query_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
 
 }
 
+static void lockstep_report(void)
+{
+  double simulated_time, wall_time;
+
+  simulated_time = carmen_get_time() - lockstep_start_time;
+  wall_time = carmen_get_wall_time() - lockstep_start_wall_time;
+  carmen_warn("Lockstep: %d steps, %.1f s simulated in %.1f s wall time "
+	      "(%.1fx real time), %d acknowledgement timeouts\n", 
+	      lockstep_step, simulated_time, wall_time, 
+	      wall_time > 0 ? simulated_time / wall_time : 0.0, 
+	      lockstep_timeouts);
+}
+
 /* handles C^c */
 static void shutdown_module(int x)
 {
   if(x == SIGINT) {
+    if (lockstep)
+      lockstep_report();
     if (use_robot) 
       carmen_robot_shutdown(x);
     carmen_ipc_disconnect();
@@ -297,6 +340,18 @@ static int initialize_ipc(void)
   if(err != IPC_OK)
     return -1;
 
+  err = IPC_defineMsg(CARMEN_SIMULATOR_CLOCK_NAME,
+                      IPC_VARIABLE_LENGTH,
+                      CARMEN_SIMULATOR_CLOCK_FMT);
+  if(err != IPC_OK)
+    return -1;
+
+  err = IPC_defineMsg(CARMEN_SIMULATOR_CLOCK_ACK_NAME,
+                      IPC_VARIABLE_LENGTH,
+                      CARMEN_SIMULATOR_CLOCK_ACK_FMT);
+  if(err != IPC_OK)
+    return -1;
+
   err = IPC_subscribe(CARMEN_SIMULATOR_SET_TRUEPOSE_NAME, 
 		      set_truepose_handler, NULL);
   if (err != IPC_OK)
@@ -332,6 +387,12 @@ static int initialize_ipc(void)
   if (err != IPC_OK)
     return 1;
 
+  err = IPC_subscribe(CARMEN_SIMULATOR_CLOCK_ACK_NAME, 
+		      clock_ack_handler, NULL);
+  if (err != IPC_OK)
+    return 1;
+  IPC_setMsgQueueLength(CARMEN_SIMULATOR_CLOCK_ACK_NAME, 100);
+
   return 0;
 }
 
@@ -416,7 +477,8 @@ publish_readings(void)
 
   timestamp = carmen_get_time();
 
-  if (simulator_config->real_time && !simulator_config->sync_mode) {
+  if (lockstep || 
+      (simulator_config->real_time && !simulator_config->sync_mode)) {
     delta_time = timestamp - simulator_config->time_of_last_command;
     if ((simulator_config->tv > 0 || simulator_config->rv > 0) && 
 	delta_time > simulator_config->motion_timeout) {
@@ -484,6 +546,46 @@ publish_readings(void)
   return 1;
 }
 
+/* advances the simulated clock by one step, publishes all readings of
+   that step followed by the clock message, and then waits until every
+   consumer has acknowledged the step */
+static void
+lockstep_run(void)
+{
+  static carmen_simulator_clock_message clock;
+  IPC_RETURN_TYPE err = IPC_OK;
+  double time_left, deadline;
+
+  lockstep_step++;
+  lockstep_acks = 0;
+  carmen_set_simulated_time(carmen_get_time() + simulator_config->delta_t);
+
+  if (use_robot)
+    carmen_robot_run();
+  publish_readings();
+
+  clock.step = lockstep_step;
+  clock.delta_t = simulator_config->delta_t;
+  clock.timestamp = carmen_get_time();
+  clock.host = carmen_get_host();
+  err = IPC_publishData(CARMEN_SIMULATOR_CLOCK_NAME, &clock);
+  carmen_test_ipc(err, "Could not publish simulator_clock_message", 
+		  CARMEN_SIMULATOR_CLOCK_NAME);
+
+  deadline = carmen_get_wall_time() + lockstep_timeout;
+  while (lockstep_acks < lockstep_consumers) {
+    time_left = deadline - carmen_get_wall_time();
+    if (time_left <= 0) {
+      lockstep_timeouts++;
+      carmen_verbose("Step %d acknowledged by %d of %d consumers only\n",
+		     lockstep_step, lockstep_acks, lockstep_consumers);
+      break;
+    }
+    IPC_listen(time_left * 1000);
+  }
+  /* handle commands the consumers issued in response to this step */
+  IPC_listenClear(0);
+}
 
 void fill_laser_config_data(carmen_simulator_laser_config_t *lasercfg) 
 {
@@ -520,6 +622,13 @@ static void read_parameters(int argc, char *argv[],
     {"simulator", "sync_mode", CARMEN_PARAM_ONOFF,
      &(config->sync_mode), 1, NULL},
     {"simulator", "use_robot", CARMEN_PARAM_ONOFF, &use_robot, 1, NULL},
+    {"simulator", "lockstep", CARMEN_PARAM_ONOFF, &lockstep, 0, NULL},
+    {"simulator", "lockstep_consumers", CARMEN_PARAM_INT, 
+     &lockstep_consumers, 0, NULL},
+    {"simulator", "lockstep_timeout", CARMEN_PARAM_DOUBLE, 
+     &lockstep_timeout, 0, NULL},
+    {"simulator", "lockstep_duration", CARMEN_PARAM_DOUBLE, 
+     &lockstep_duration, 0, NULL},
 #ifdef OLD_MOTION_MODEL
     {"localize", "odom_a1", CARMEN_PARAM_DOUBLE, &(config->odom_a1), 1, NULL},
     {"localize", "odom_a2", CARMEN_PARAM_DOUBLE, &(config->odom_a2), 1, NULL},
@@ -683,6 +792,12 @@ int main(int argc, char** argv)
   memset(&init_msg, 0, sizeof(carmen_localize_initialize_message));
   simulator_config = &simulator_conf;
   read_parameters(argc, argv, &simulator_conf);
+
+  if (lockstep) {
+    lockstep_start_wall_time = carmen_get_wall_time();
+    lockstep_start_time = lockstep_start_wall_time;
+    carmen_set_simulated_time(lockstep_start_time);
+  }
   carmen_simulator_initialize_object_model(argc, argv);
 
   signal(SIGINT, shutdown_module);
@@ -707,6 +822,18 @@ int main(int argc, char** argv)
   if (use_robot) 
     carmen_robot_start(argc, argv);
 
+  while (lockstep) {
+    lockstep_run();
+    if (lockstep_duration > 0 && 
+	carmen_get_time() - lockstep_start_time >= lockstep_duration) {
+      lockstep_report();
+      if (use_robot)
+	carmen_robot_shutdown(SIGINT);
+      carmen_ipc_disconnect();
+      exit(0);
+    }
+  }
+
   while (1) {
     carmen_ipc_sleep(simulator_conf.real_time);
     if (!simulator_conf.sync_mode) {
@@ -204,6 +204,12 @@ main(int argc, char **argv)
   carmen_ipc_initialize(argc, argv);
   carmen_param_check_version(argv[0]);
 
+#ifndef NO_JPEG
+  carmen_camera_register_codec(CARMEN_CAMERA_ENCODING_JPEG, 
+			       carmen_graphics_jpeg_compress, 
+			       carmen_graphics_jpeg_decompress);
+#endif
+
   carmen_camera_subscribe_images
     (NULL, (carmen_handler_t)image_handler, CARMEN_SUBSCRIBE_LATEST);
 
@@ -38,7 +38,7 @@ static void main_usage(char *prog_name)
   carmen_die("\nUsage: %s <action> <...>\n\n"
 	     "<action> is one of: toppm, "
 	     "tomap, "
-	     "rotate, minimize, add_place, add_offset, \n"
+	     "rotate, minimize, pyramid, compact, add_place, add_offset, \n"
 	     "strip, info.\n"
 	     "Run %s help <action> to get help on using each action.\n\n",
 	     prog_name, prog_name);  
@@ -115,6 +115,21 @@ static void help(int argc, char **argv)
   else if (carmen_strcasecmp(action, "minimize") == 0)
     carmen_die("\nUsage: %s minimize <in map filename> <out map filename>\n\n",
 	       argv[0]);
+  else if (carmen_strcasecmp(action, "pyramid") == 0)
+    carmen_die("\nUsage: %s pyramid <levels> <min|max|mean> <in map filename> "
+	       "<out map filename>\n\nStores levels 1 to <levels>-1 of a map "
+	       "pyramid as gridmap chunks named\n\"pyramid-<reducer>:<level>\". "
+	       "Each level halves the resolution of the\nprevious one; max keeps "
+	       "the most occupied cell of each block and is the\nconservative "
+	       "choice for planning.\n\n", argv[0]);
+  else if (carmen_strcasecmp(action, "compact") == 0)
+    carmen_die("\nUsage: %s compact u8 <in map filename> <out map filename>\n"
+	       "       %s compact bitmap <occupied threshold> <in map filename> "
+	       "<out map filename>\n\nReplaces the gridmap by a compact one: "
+	       "u8 stores occupancy in one byte per\ncell, bitmap only stores "
+	       "whether a cell is free, occupied (occupancy above\nthe "
+	       "threshold) or unknown, in two bits per cell.\n\n", 
+	       argv[0], argv[0]);
   else if (carmen_strcasecmp(action, "add_place") == 0) {
     fprintf(stderr, "\nUsage: %s <mapfilename> <placename> <place params>\n",
 	    argv[0]);
@@ -494,6 +509,144 @@ static void minimize(int argc, char *argv[])
   carmen_fclose(out_fp);
 }
 
+static void pyramid(int argc, char *argv[])
+{
+  char *input_filename, *output_filename;
+  int next_arg;
+  carmen_FILE *in_fp, *out_fp;
+  carmen_map_t map;
+  carmen_map_pyramid_p map_pyramid;
+  carmen_map_reducer_t reducer;
+  char pyramid_name[128], chunk_name[128];
+  int num_levels, level;
+  int force;
+
+  next_arg = handle_options(argc, argv, &force);
+  next_arg++;
+
+  if(argc - next_arg != 4) {
+    carmen_warn("\nError: wrong number of parameters.\n");    
+    carmen_die("\nUsage: %s pyramid <levels> <min|max|mean> "
+	       "<in map filename> <out map filename>\n\n", argv[0]);
+  }
+
+  num_levels = atoi(argv[next_arg]);
+  if (num_levels < 2)
+    carmen_die("A pyramid needs at least 2 levels.\n");
+
+  if (carmen_strcasecmp(argv[next_arg+1], "min") == 0)
+    reducer = CARMEN_MAP_REDUCE_MIN;
+  else if (carmen_strcasecmp(argv[next_arg+1], "max") == 0)
+    reducer = CARMEN_MAP_REDUCE_MAX;
+  else if (carmen_strcasecmp(argv[next_arg+1], "mean") == 0)
+    reducer = CARMEN_MAP_REDUCE_MEAN;
+  else
+    carmen_die("Unknown reducer %s: must be one of min, max or mean.\n",
+	       argv[next_arg+1]);
+
+  input_filename = check_mapfile(argv[next_arg+2]);
+  output_filename = check_output(argv[next_arg+3], force);
+
+  snprintf(pyramid_name, 128, "pyramid-%s", argv[next_arg+1]);
+  snprintf(chunk_name, 128, CARMEN_MAP_PYRAMID_CHUNK_NAME, pyramid_name, 1);
+  if (carmen_map_named_chunk_exists(input_filename, CARMEN_MAP_GRIDMAP_CHUNK,
+				    chunk_name) > 0)
+    carmen_die("%s already contains a %s pyramid.\n", input_filename,
+	       argv[next_arg+1]);
+
+  if (carmen_map_read_gridmap_chunk(input_filename, &map) < 0)
+    carmen_die_syserror("Couldn't read GRIDMAP_CHUNK from %s", input_filename);
+
+  map_pyramid = carmen_map_util_build_pyramid(&map, num_levels, reducer, 0);
+  for (level = 1; level < map_pyramid->num_levels; level++)
+    carmen_warn("Level %d: %d x %d at %.2f m\n", level,
+		map_pyramid->level[level].config.x_size,
+		map_pyramid->level[level].config.y_size,
+		map_pyramid->level[level].config.resolution);
+
+  in_fp = carmen_fopen(input_filename, "r");
+  if (in_fp == NULL)
+    carmen_die_syserror("Couldn't open %s for reading", input_filename);
+
+  out_fp = carmen_fopen(output_filename, "w");
+  if (out_fp == NULL)
+    carmen_die_syserror("Couldn't open %s for writing", output_filename);
+
+  if (carmen_map_vstrip(in_fp, out_fp, 0) < 0)
+    carmen_die_syserror("Couldn't copy map to %s", output_filename);
+
+  if (carmen_map_write_pyramid_chunks(out_fp, pyramid_name, map_pyramid) < 0)
+    carmen_die_syserror("Couldn't write pyramid to %s", output_filename);
+
+  carmen_fclose(in_fp);
+  carmen_fclose(out_fp);
+
+  carmen_map_util_free_pyramid(map_pyramid);
+}
+
+static void compact(int argc, char *argv[])
+{
+  char *input_filename, *output_filename;
+  int next_arg, num_args;
+  carmen_FILE *in_fp, *out_fp;
+  carmen_map_t map;
+  carmen_compact_map_p compact_map;
+  int encoding;
+  float threshold = 0.0;
+  int force;
+
+  next_arg = handle_options(argc, argv, &force);
+  next_arg++;
+  num_args = argc - next_arg;
+
+  if (num_args == 3 && carmen_strcasecmp(argv[next_arg], "u8") == 0)
+    encoding = CARMEN_MAP_ENCODING_U8;
+  else if (num_args == 4 && 
+	   carmen_strcasecmp(argv[next_arg], "bitmap") == 0) {
+    encoding = CARMEN_MAP_ENCODING_BITMAP;
+    threshold = atof(argv[next_arg+1]);
+    next_arg++;
+  } else {
+    carmen_warn("\nError: wrong parameters.\n");    
+    carmen_die("\nUsage: %s compact u8 <in map filename> "
+	       "<out map filename>\n"
+	       "       %s compact bitmap <occupied threshold> "
+	       "<in map filename> <out map filename>\n\n", argv[0], argv[0]);
+  }
+
+  input_filename = check_mapfile(argv[next_arg+1]);
+  output_filename = check_output(argv[next_arg+2], force);
+
+  if (carmen_map_read_gridmap_chunk(input_filename, &map) < 0)
+    carmen_die_syserror("Couldn't read GRIDMAP_CHUNK from %s", input_filename);
+
+  compact_map = carmen_map_util_compact_map(&map, encoding, threshold);
+
+  in_fp = carmen_fopen(input_filename, "r");
+  if (in_fp == NULL)
+    carmen_die_syserror("Couldn't open %s for reading", input_filename);
+
+  out_fp = carmen_fopen(output_filename, "w");
+  if (out_fp == NULL)
+    carmen_die_syserror("Couldn't open %s for writing", output_filename);
+
+  if (carmen_map_vstrip(in_fp, out_fp, 2, CARMEN_MAP_GRIDMAP_CHUNK,
+			CARMEN_MAP_COMPACT_GRIDMAP_CHUNK) < 0)
+    carmen_die_syserror("Couldn't strip map to %s", output_filename);
+
+  if (carmen_map_write_compact_gridmap_chunk(out_fp, compact_map) < 0)
+    carmen_die_syserror("Couldn't write compact gridmap to %s", 
+			output_filename);
+
+  carmen_fclose(in_fp);
+  carmen_fclose(out_fp);
+
+  carmen_warn("Gridmap went from %d to %d bytes\n", 
+	      map.config.x_size*map.config.y_size*(int)sizeof(float),
+	      map.config.x_size*compact_map->column_bytes);
+  carmen_map_util_free_compact_map(compact_map);
+}
+
 static void add_place(int argc, char *argv[])
 {
   char *input_filename;
@@ -809,6 +962,12 @@ static void info(int argc, char *argv[])
     }
   else
     printf("GRIDMAP       : no\n");
+  chunk_size = carmen_map_chunk_exists(filename, 
+				       CARMEN_MAP_COMPACT_GRIDMAP_CHUNK);
+  if(chunk_size > 0)
+    printf("COMPACTMAP    : yes (%d bytes)\n", chunk_size);
+  else
+    printf("COMPACTMAP    : no\n");
   chunk_size = carmen_map_chunk_exists(filename, CARMEN_MAP_OFFLIMITS_CHUNK);
   if(chunk_size > 0) {
     printf("OFFLIMITS     : yes (%d bytes)\n", chunk_size);
@@ -900,6 +1059,10 @@ int main(int argc, char **argv)
     rotate(argc, argv);
   else if (carmen_strcasecmp(action, "minimize") == 0)
     minimize(argc, argv);
+  else if (carmen_strcasecmp(action, "pyramid") == 0)
+    pyramid(argc, argv);
+  else if (carmen_strcasecmp(action, "compact") == 0)
+    compact(argc, argv);
   else if (carmen_strcasecmp(action, "add_place") == 0)
     add_place(argc, argv);
   else if (carmen_strcasecmp(action, "add_offset") == 0)
@@ -27,6 +27,7 @@
  ********************************************************/
 
 #include "global_graphics.h"
+#include "map_graphics.h"
 
 #include "param_interface.h"
 #include "simulator_interface.h"
@@ -182,6 +183,8 @@ static void read_parameters(int argc, char *argv[],
 
     {"navigator_panel", "initial_map_zoom", CARMEN_PARAM_DOUBLE,
      &(navigator_panel_config->initial_map_zoom), 1, NULL},
+    {"navigator_panel", "max_frame_rate", CARMEN_PARAM_DOUBLE,
+     &(navigator_panel_config->max_frame_rate), 0, NULL},
     {"navigator_panel", "track_robot", CARMEN_PARAM_ONOFF,
      &(navigator_panel_config->track_robot), 1, NULL},
     {"navigator_panel", "draw_waypoints", CARMEN_PARAM_ONOFF,
@@ -221,6 +224,7 @@ int main(int argc, char **argv)
 
   signal(SIGINT, nav_shutdown);
 
+  nav_panel_config.max_frame_rate = CARMEN_MAP_GRAPHICS_DEFAULT_FRAME_RATE;
   read_parameters(argc, argv, &robot_config, &nav_config, &nav_panel_config);
 
   carmen_navigator_subscribe_status_message
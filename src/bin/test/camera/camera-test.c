@@ -0,0 +1,222 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include <time.h>
+
+#include "global.h"
+
+#include "camera_hw_interface.h"
+#include "camera_interface.h"
+#include "camera_shared.h"
+
+#ifdef CAMERA_USE_JPEG
+#include "global_graphics.h"
+#endif
+
+#define NUM_FRAMES 300
+
+/* Measures how many frames per second, and how much CPU per frame, each
+   encoding and transport costs for images taken from fakecam. The copies
+   through central are modelled by copying the message data twice, once
+   into central and once out to the subscriber. */
+
+static void
+benchmark(const char *label, carmen_camera_image_t *source, 
+	  unsigned char *pixels, int width, int height, 
+	  carmen_camera_encoding_t encoding, int use_shared_memory, 
+	  int *errors)
+{
+  carmen_camera_shared_p segment = NULL;
+  unsigned char *data, *central, *decoded;
+  const unsigned char *received;
+  double start_time, wall_time;
+  clock_t start_clock;
+  long sent_bytes = 0, central_bytes = 0;
+  int image_size = width*height*3, data_size, received_size, frame, i;
+  int x, n, source_x;
+  int slot, sequence, lossless = (encoding != CARMEN_CAMERA_ENCODING_JPEG);
+
+  decoded = (unsigned char *)malloc(image_size);
+  carmen_test_alloc(decoded);
+  central = (unsigned char *)malloc(2*image_size + 1024);
+  carmen_test_alloc(central);
+  if (use_shared_memory) {
+    segment = carmen_camera_shared_create("/carmen_camera_test",
+					  CARMEN_CAMERA_SHARED_NUM_SLOTS,
+					  2*image_size + 1024);
+    if (segment == NULL) {
+      printf("%-20s shared memory not available\n", label);
+      free(decoded);
+      free(central);
+      return;
+    }
+  }
+
+  start_time = carmen_get_time();
+  start_clock = clock();
+  for (frame = 0; frame < NUM_FRAMES; frame++) {
+    carmen_camera_grab_image(source);
+    /* Tile the fakecam frame into the benchmark resolution, shifted by a
+       few pixels per frame */
+    for (i = 0; i < height; i++)
+      for (x = 0; x < width; x += n) {
+	source_x = (x + frame) % source->width;
+	n = carmen_fmin(width - x, source->width - source_x);
+	memcpy(pixels + (i*width + x)*3, source->image + 
+	       ((i % source->height)*source->width + source_x)*3, n*3);
+      }
+
+    if (carmen_camera_encode(encoding, pixels, width, height, 3, 75, 
+			     &data, &data_size) < 0) {
+      printf("%-20s encoding not available\n", label);
+      break;
+    }
+    sent_bytes += data_size;
+
+    if (use_shared_memory) {
+      carmen_camera_shared_write(segment, data, data_size, &slot, &sequence);
+      received = (const unsigned char *)
+	carmen_camera_shared_read(segment, slot, sequence, &received_size);
+    }
+    else {
+      memcpy(central, data, data_size);
+      memcpy(central + image_size, central, data_size);
+      central_bytes += 2*data_size;
+      received = central + image_size;
+      received_size = data_size;
+    }
+
+    if (received == NULL || 
+	carmen_camera_decode(encoding, received, received_size, decoded, 
+			     width, height, 3) < 0 ||
+	(lossless && memcmp(decoded, pixels, image_size) != 0)) {
+      printf("%-20s frame %d did not survive the round trip\n", label, 
+	     frame);
+      (*errors)++;
+    }
+    free(data);
+  }
+  wall_time = carmen_get_time() - start_time;
+
+  if (frame == NUM_FRAMES)
+    printf("%-20s %4dx%-4d %8.1f fps %8.3f ms CPU/frame %9.1f kB/frame "
+	   "%9.1f kB/frame through central\n", label, width, height, 
+	   NUM_FRAMES / wall_time, 
+	   1000.0*(clock() - start_clock) / CLOCKS_PER_SEC / NUM_FRAMES,
+	   sent_bytes / 1024.0 / NUM_FRAMES, 
+	   central_bytes / 2048.0 / NUM_FRAMES);
+
+  carmen_camera_shared_close(segment);
+  free(decoded);
+  free(central);
+}
+
+/* Streams frames through shared memory the way publisher and subscriber
+   do, with frames growing beyond the slots half way. The subscriber must
+   follow the publisher to its new segment and get every frame. */
+
+static void
+test_growing_frames(int *errors)
+{
+  carmen_camera_shared_p publisher = NULL, subscriber = NULL;
+  unsigned char data[64*1024];
+  const unsigned char *received;
+  int frame, size, slot, sequence, received_size, generations = 0;
+
+  for (frame = 0; frame < 60; frame++) {
+    size = (frame < 20 ? 1000 : (frame < 40 ? 8000 : 64*1024));
+    memset(data, frame, size);
+    if (carmen_camera_shared_publish(&publisher, "/carmen_camera_test", 
+				     data, size, size, &slot, 
+				     &sequence) < 0) {
+      printf("shared memory not available\n");
+      return;
+    }
+    received = (const unsigned char *)
+      carmen_camera_shared_receive(&subscriber, publisher->name, slot, 
+				   sequence, &received_size);
+    if (received == NULL || received_size != size || 
+	memcmp(received, data, size) != 0) {
+      printf("frame %d of growing frames was %s\n", frame, 
+	     received == NULL ? "lost" : "stale");
+      (*errors)++;
+    }
+    generations = publisher->generation + 1;
+  }
+  printf("growing frames: %d segments\n", generations);
+
+  carmen_camera_shared_close(subscriber);
+  carmen_camera_shared_close(publisher);
+}
+
+int
+main(int argc, char **argv)
+{
+  carmen_camera_image_t *source;
+  unsigned char *pixels;
+  int sizes[][2] = {{455, 307}, {640, 480}, {1280, 960}};
+  int errors = 0, size;
+
+  source = carmen_camera_start(argc, argv);
+  if (source == NULL || source->bytes_per_pixel != 3)
+    carmen_die("Could not start fakecam\n");
+
+#ifdef CAMERA_USE_JPEG
+  carmen_camera_register_codec(CARMEN_CAMERA_ENCODING_JPEG, 
+			       carmen_graphics_jpeg_compress, 
+			       carmen_graphics_jpeg_decompress);
+#endif
+
+  test_growing_frames(&errors);
+
+  for (size = 0; size < 3; size++) {
+    pixels = (unsigned char *)calloc(sizes[size][0]*sizes[size][1]*3, 1);
+    carmen_test_alloc(pixels);
+
+    benchmark("raw", source, pixels, sizes[size][0], sizes[size][1], 
+	      CARMEN_CAMERA_ENCODING_RAW, 0, &errors);
+    benchmark("deflate", source, pixels, sizes[size][0], sizes[size][1], 
+	      CARMEN_CAMERA_ENCODING_DEFLATE, 0, &errors);
+    benchmark("jpeg", source, pixels, sizes[size][0], sizes[size][1], 
+	      CARMEN_CAMERA_ENCODING_JPEG, 0, &errors);
+    benchmark("raw, shared", source, pixels, sizes[size][0], 
+	      sizes[size][1], CARMEN_CAMERA_ENCODING_RAW, 1, &errors);
+    benchmark("deflate, shared", source, pixels, sizes[size][0], 
+	      sizes[size][1], CARMEN_CAMERA_ENCODING_DEFLATE, 1, &errors);
+
+    free(pixels);
+  }
+
+  carmen_camera_shutdown();
+
+  if (errors > 0) {
+    printf("%d frames were corrupted\n", errors);
+    return 1;
+  }
+  return 0;
+}
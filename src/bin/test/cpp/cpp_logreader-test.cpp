@@ -0,0 +1,143 @@
+#include "cpp_logfile.h"
+#include "cpp_logreader.h"
+
+#include "writelog.h"
+
+// Writes a log of odometry and laser messages, then reads it with
+// LogFile and, through a small cache, with LogReader, in order, in
+// random order and from a position found by time. Both must return the
+// same messages.
+
+#define NUM_SCANS  5000
+#define NUM_BEAMS  181
+
+static void writeLog(char* filename) {
+  carmen_FILE* outfile = carmen_fopen(filename, "w");
+  if (outfile == NULL)
+    carmen_die("Error: could not open file %s for writing.\n", filename);
+
+  carmen_logwrite_write_header(outfile);
+
+  carmen_base_odometry_message odometry;
+  memset(&odometry, 0, sizeof(carmen_base_odometry_message));
+  odometry.host = (char*) "localhost";
+
+  carmen_robot_laser_message laser;
+  memset(&laser, 0, sizeof(carmen_robot_laser_message));
+  laser.config.fov = M_PI;
+  laser.config.start_angle = -M_PI/2;
+  laser.config.angular_resolution = M_PI/(NUM_BEAMS-1);
+  laser.config.maximum_range = 81.0;
+  laser.num_readings = NUM_BEAMS;
+  laser.range = new float[NUM_BEAMS];
+  laser.host = (char*) "localhost";
+
+  for (int i = 0; i < NUM_SCANS; i++) {
+    odometry.x = 0.01*i;
+    odometry.timestamp = 1000.0 + 0.1*i;
+    carmen_logwrite_write_odometry(&odometry, outfile, 0.1*i);
+
+    for (int j = 0; j < NUM_BEAMS; j++)
+      laser.range[j] = 1.0 + (i+j) % 50 * 0.1;
+    laser.timestamp = 1000.0 + 0.1*i + 0.05;
+    carmen_logwrite_write_robot_laser(&laser, 1, outfile, 0.1*i + 0.05);
+  }
+  carmen_fclose(outfile);
+  delete [] laser.range;
+}
+
+static int compare(const AbstractMessage* message,
+                   const AbstractMessage* expected) {
+  if (message == NULL || strcmp(message->getMessageID(),
+                                expected->getMessageID()) ||
+      message->getTimestamp() != expected->getTimestamp())
+    return 1;
+  if (!strcmp(expected->getMessageID(), "ROBOTLASER")) {
+    const RobotLaserMessage* laser = (const RobotLaserMessage*) message;
+    const RobotLaserMessage* expectedLaser =
+      (const RobotLaserMessage*) expected;
+    if (laser->getNumReadings() != expectedLaser->getNumReadings())
+      return 1;
+    for (int j = 0; j < laser->getNumReadings(); j++)
+      if (laser->getRange(j) != expectedLaser->getRange(j))
+        return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  char filename[] = "/tmp/cpp_logreader-testXXXXXX";
+  int errors = 0;
+
+  carmen_randomize(&argc, &argv);
+  int fd = mkstemp(filename);
+  if (fd < 0)
+    carmen_die_syserror("Could not create %s", filename);
+  close(fd);
+  writeLog(filename);
+
+  LogFile logfile;
+  logfile.load(filename);
+
+  double start = carmen_get_time();
+  LogReader reader(filename, 16);
+  double openTime = carmen_get_time() - start;
+
+  // the header comments are messages of LogFile as well
+  std::vector<int> positions;
+  for (LogReader::const_iterator it = reader.begin(); it != reader.end();
+       ++it)
+    if (*it != NULL)
+      positions.push_back(it.getPosition());
+  if (positions.size() != logfile.size()) {
+    carmen_warn("LogReader has %d messages, LogFile %d\n",
+                (int) positions.size(), (int) logfile.size());
+    errors++;
+  }
+
+  for (unsigned int i = 0; i < positions.size() && i < logfile.size(); i++)
+    if (compare(reader[positions[i]], logfile[i]) && errors++ < 5)
+      carmen_warn("message %d differs\n", i);
+
+  int decoded = reader.getNumDecoded();
+  for (int i = 0; i < 2000; i++) {
+    int n = (int) carmen_uniform_random(0, positions.size() - 1);
+    if (compare(reader[positions[n]], logfile[n]) && errors++ < 5)
+      carmen_warn("random message %d differs\n", n);
+  }
+
+  // a recent message comes from the cache
+  reader[positions[10]];
+  decoded = reader.getNumDecoded();
+  reader[positions[10]];
+  if (reader.getNumDecoded() != decoded) {
+    carmen_warn("cached message was decoded again\n");
+    errors++;
+  }
+
+  LogReader::const_iterator it = reader.find(250.0);
+  if (it == reader.end() || (*it)->getTimestamp() != 1000.0 + 250.0) {
+    carmen_warn("find went to position %d\n", it.getPosition());
+    errors++;
+  }
+
+  printf("%d messages, opened in %.3f s, %d decoded through %d slots\n",
+         reader.size(), openTime, reader.getNumDecoded(),
+         reader.getCacheSize());
+
+  for (LogFile::Collection::iterator it = logfile.begin();
+       it != logfile.end(); ++it)
+    delete *it;
+
+  std::string indexFilename = std::string(filename) +
+    CARMEN_LOGFILE_INDEX_EXTENSION;
+  unlink(indexFilename.c_str());
+  unlink(filename);
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
@@ -0,0 +1,197 @@
+#include <stdlib.h>
+
+#include "cpp_mapdefinitions.h"
+
+// Checks that GenericMap and TiledMap move like the copying moveMap of
+// AbstractMap, and that writes through a MapView reach the map. Then
+// compares the time to fill, iterate and shift large maps, 10000 x 10000
+// cells unless another size is given.
+
+#define TEST_SIZE_X  300
+#define TEST_SIZE_Y  200
+
+template<class MAP>
+static int compare(const char* name, MAP& map, FloatMap& expected) {
+  int errors = 0;
+
+  if (map.getOffset() != expected.getOffset()) {
+    carmen_warn("%s: offset differs\n", name);
+    errors++;
+  }
+  for (int x = 0; x < expected.getMapSizeX(); x++)
+    for (int y = 0; y < expected.getMapSizeY(); y++)
+      if ((float) map.cell(x, y) != (float) expected.cell(x, y) &&
+          errors++ < 5)
+        carmen_warn("%s: cell (%d, %d) is %f, expected %f\n", name, x, y,
+                    (float) map.cell(x, y), (float) expected.cell(x, y));
+  return errors;
+}
+
+static int testMoves() {
+  MapConfig cfg(TEST_SIZE_X, TEST_SIZE_Y, 0.1, Point(-5.0, 3.0));
+  FloatMap expected(cfg), generic(cfg);
+  TiledFloatMap tiled(cfg);
+  int errors = 0;
+
+  expected.resetCells();
+  generic.resetCells();
+  for (int i = 0; i < 200; i++) {
+    // writes in a corner, so that tiles stay sparse
+    for (int j = 0; j < 500; j++) {
+      int x = (int) carmen_uniform_random(0, TEST_SIZE_X/3);
+      int y = (int) carmen_uniform_random(0, TEST_SIZE_Y);
+      float value = carmen_uniform_random(0, 1);
+      expected.cell(x, y) = value;
+      generic.cell(x, y) = value;
+      tiled.cell(x, y) = value;
+    }
+
+    int dx = (int) carmen_uniform_random(-80, 80);
+    int dy = (int) carmen_uniform_random(-80, 80);
+    if (i % 50 == 49)
+      dx = TEST_SIZE_X + 1;
+    expected.AbstractMap<FloatCell>::moveMap(dx, dy);
+    generic.moveMap(dx, dy);
+    tiled.moveMap(dx, dy);
+
+    errors += compare("GenericMap", generic, expected);
+    errors += compare("TiledMap", tiled, expected);
+    if (errors)
+      break;
+  }
+
+  int length;
+  for (int x = 0; x < TEST_SIZE_X; x++)
+    for (int y = 0; y < TEST_SIZE_Y; y += length) {
+      const FloatCell* column = 
+        ((const TiledFloatMap&) tiled).getColumn(x, y, &length);
+      for (int i = 0; i < length; i++)
+        if ((float) (column ? column[i] : tiled.defaultCell()) != 
+            (float) expected.cell(x, y+i) && errors++ < 5)
+          carmen_warn("column of cell (%d, %d) differs\n", x, y+i);
+    }
+
+  TiledFloatMap copy(tiled);
+  errors += compare("copy of TiledMap", copy, expected);
+
+  // a view writes the map it shows
+  MapView<FloatCell> view(tiled, IntPoint(40, 30), IntPoint(140, 90));
+  for (int x = 0; x < view.getMapSizeX(); x++)
+    for (int y = 0; y < view.getMapSizeY(); y++) {
+      view.cell(x, y) = x + y;
+      expected.cell(x+40, y+30) = x + y;
+    }
+  errors += compare("MapView", tiled, expected);
+  if (view.map2world(0, 0) != tiled.map2world(40, 30)) {
+    carmen_warn("MapView is misplaced\n");
+    errors++;
+  }
+  view.moveView(-40, 10);
+  if (view.getFrom() != IntPoint(0, 40) ||
+      (float) view.cell(50, 5) != (float) tiled.cell(50, 45)) {
+    carmen_warn("MapView did not move\n");
+    errors++;
+  }
+
+  return errors;
+}
+
+template<class MAP>
+static void benchmark(const char* name, MAP& map, bool copying) {
+  int sizeX = map.getMapSizeX(), sizeY = map.getMapSizeY();
+  long count = 0;
+
+  double t = carmen_get_time();
+  for (int x = 0; x < sizeX; x++)
+    for (int y = 0; y < sizeY; y++)
+      map.cell(x, y) = (float) (x ^ y);
+  double fill = carmen_get_time() - t;
+
+  t = carmen_get_time();
+  for (int x = 0; x < sizeX; x++)
+    for (int y = 0; y < sizeY; y++)
+      count += (float) map.cell(x, y) >= 1000.0;
+  double iterate = carmen_get_time() - t;
+
+  t = carmen_get_time();
+  if (copying)
+    map.AbstractMap<FloatCell>::moveMap(37, -23);
+  else
+    map.moveMap(37, -23);
+  double shift = carmen_get_time() - t;
+
+  printf("%-22s fill %7.1f Mcells/s  iterate %7.1f Mcells/s  "
+         "shift %8.2f ms  (%ld)\n", name, sizeX*(double) sizeY/fill/1e6,
+         sizeX*(double) sizeY/iterate/1e6, shift*1e3, count);
+}
+
+// the same tile by tile, through the columns of the tiles; the map
+// starts at a tile, so blocks of CARMEN_CPP_TILE_SIZE columns are tiles
+static void benchmarkColumns(const char* name, TiledFloatMap& map) {
+  int sizeX = map.getMapSizeX(), sizeY = map.getMapSizeY(), length;
+  long count = 0;
+
+  double t = carmen_get_time();
+  for (int x0 = 0; x0 < sizeX; x0 += CARMEN_CPP_TILE_SIZE)
+    for (int y = 0; y < sizeY; y += length)
+      for (int x = x0; x < sizeX && x < x0 + CARMEN_CPP_TILE_SIZE; x++) {
+        FloatCell* column = map.getColumn(x, y, &length);
+        for (int i = 0; i < length; i++)
+          column[i] = (float) (x ^ (y+i));
+      }
+  double fill = carmen_get_time() - t;
+
+  const TiledFloatMap& constMap = map;
+  t = carmen_get_time();
+  for (int x0 = 0; x0 < sizeX; x0 += CARMEN_CPP_TILE_SIZE)
+    for (int y = 0; y < sizeY; y += length)
+      for (int x = x0; x < sizeX && x < x0 + CARMEN_CPP_TILE_SIZE; x++) {
+        const FloatCell* column = constMap.getColumn(x, y, &length);
+        for (int i = 0; column != NULL && i < length; i++)
+          count += (float) column[i] >= 1000.0;
+      }
+  double iterate = carmen_get_time() - t;
+
+  t = carmen_get_time();
+  map.moveMap(37, -23);
+  double shift = carmen_get_time() - t;
+
+  printf("%-22s fill %7.1f Mcells/s  iterate %7.1f Mcells/s  "
+         "shift %8.2f ms  (%ld)\n", name, sizeX*(double) sizeY/fill/1e6,
+         sizeX*(double) sizeY/iterate/1e6, shift*1e3, count);
+}
+
+int main(int argc, char** argv) {
+  int size = 10000, errors;
+
+  if (argc > 1)
+    size = atoi(argv[1]);
+  carmen_randomize(&argc, &argv);
+
+  errors = testMoves();
+
+  MapConfig cfg(size, size, 0.05, Point(0.0, 0.0));
+  {
+    FloatMap map(cfg);
+    benchmark("GenericMap, copying", map, true);
+  }
+  {
+    FloatMap map(cfg);
+    benchmark("GenericMap", map, false);
+  }
+  {
+    TiledFloatMap map(cfg);
+    benchmark("TiledMap", map, false);
+  }
+  {
+    TiledFloatMap map(cfg);
+    benchmarkColumns("TiledMap, columns", map);
+  }
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
@@ -0,0 +1,279 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+
+/*************************************
+ * checks that grid rays visit the   *
+ * cells a segment passes, that many *
+ * rays cast together visit the same *
+ * cells as one at a time, and times *
+ * scans cast with Bresenham lines,  *
+ * one ray at a time and in batches  *
+ *************************************/
+
+#include "global.h"
+
+#define GRID_SIZE     200
+#define NUM_RAYS      2000
+#define MAP_SIZE      2000
+#define NUM_BEAMS     361
+#define NUM_SCANS     2000
+#define MAX_RANGE     800
+
+static int
+check(int condition, char *what)
+{
+  if (!condition)
+    carmen_warn("FAILED: %s\n", what);
+  return condition ? 0 : 1;
+}
+
+/* The cells of a segment: 4-connected from the cell of the start to the
+   cell of the end, each entered where the segment enters it. */
+static int
+check_segment(double x1, double y1, double x2, double y2)
+{
+  carmen_grid_ray_t ray;
+  double length = hypot(x2-x1, y2-y1), t, x, y;
+  int num_cells = 1, last_x, last_y, errors = 0;
+
+  carmen_grid_ray_init_segment(&ray, x1, y1, x2, y2);
+  if (ray.x != floor(x1) || ray.y != floor(y1))
+    errors++;
+  do {
+    t = ray.t+1e-9;
+    x = x1+(x2-x1)*t/length;
+    y = y1+(y2-y1)*t/length;
+    if (floor(x) != ray.x || floor(y) != ray.y)
+      errors++;
+    last_x = ray.x;
+    last_y = ray.y;
+    if (!carmen_grid_ray_next(&ray))
+      break;
+    num_cells++;
+    if (abs(ray.x-last_x)+abs(ray.y-last_y) != 1)
+      errors++;
+  } while (1);
+
+  if (ray.x != floor(x2) || ray.y != floor(y2) ||
+      num_cells != fabs(floor(x2)-floor(x1))+fabs(floor(y2)-floor(y1))+1)
+    errors++;
+  return errors;
+}
+
+/* A cell that stops rays, the same for every ray. */
+carmen_inline static int
+is_wall(int x, int y)
+{
+  return ((x*7919+y*104729) % 97) == 0;
+}
+
+/* Casts rays one at a time and together, with and without walls, and
+   compares the cells and where the rays end. */
+static int
+check_batch(carmen_grid_rays_p rays)
+{
+  static double x[NUM_RAYS], y[NUM_RAYS], theta[NUM_RAYS], length[NUM_RAYS];
+  static unsigned int hash[NUM_RAYS], batch_hash[NUM_RAYS];
+  static double t_stop[NUM_RAYS];
+  carmen_grid_ray_t ray;
+  int i, r, walls, last, errors = 0;
+
+  for (i = 0; i < NUM_RAYS; i++) {
+    x[i] = carmen_uniform_random(-10, GRID_SIZE+10);
+    y[i] = carmen_uniform_random(-10, GRID_SIZE+10);
+    theta[i] = carmen_uniform_random(-M_PI, M_PI);
+    length[i] = carmen_uniform_random(0, GRID_SIZE);
+  }
+
+  for (walls = 0; walls <= 1; walls++) {
+    for (i = 0; i < NUM_RAYS; i++) {
+      hash[i] = 0;
+      batch_hash[i] = 0;
+      t_stop[i] = 0;
+      carmen_grid_ray_init(&ray, x[i], y[i], theta[i], length[i]);
+      if (ray.x < 0 || ray.x >= GRID_SIZE || ray.y < 0 || ray.y >= GRID_SIZE)
+	continue;
+      do {
+	t_stop[i] = ray.t;
+	if (ray.x < 0 || ray.x >= GRID_SIZE || 
+	    ray.y < 0 || ray.y >= GRID_SIZE)
+	  break;
+	hash[i] = hash[i]*31+ray.x*GRID_SIZE+ray.y+1;
+	if (walls && is_wall(ray.x, ray.y))
+	  break;
+	t_stop[i] = ray.t_end;
+      } while (carmen_grid_ray_next(&ray));
+    }
+
+    carmen_grid_rays_reset(rays, GRID_SIZE, GRID_SIZE);
+    for (i = 0; i < NUM_RAYS; i++)
+      errors += carmen_grid_rays_add(rays, x[i], y[i], theta[i], 
+				     length[i]) != i;
+    last = -1;
+    while (carmen_grid_rays_next(rays, &ray, &r)) {
+      if (r <= last)
+	errors++;
+      last = r;
+      do {
+	batch_hash[r] = batch_hash[r]*31+ray.x*GRID_SIZE+ray.y+1;
+	if (walls && is_wall(ray.x, ray.y)) {
+	  carmen_grid_ray_stop(&ray);
+	  break;
+	}
+      } while (carmen_grid_rays_step(rays, &ray));
+    }
+
+    for (i = 0; i < NUM_RAYS; i++)
+      if (hash[i] != batch_hash[i] || 
+	  fabs(rays->t_stop[i]-t_stop[i]) > 1e-9)
+	errors++;
+  }
+
+  return errors;
+}
+
+/* Occupied cells scattered over a large map. */
+static unsigned char *
+make_map(void)
+{
+  unsigned char *map;
+  int i;
+
+  map = (unsigned char *)calloc(MAP_SIZE*MAP_SIZE, 1);
+  carmen_test_alloc(map);
+  for (i = 0; i < MAP_SIZE*MAP_SIZE/500; i++)
+    map[carmen_int_random(MAP_SIZE*MAP_SIZE)] = 1;
+  return map;
+}
+
+carmen_inline static int
+is_free(unsigned char *map, int x, int y)
+{
+  return x >= 0 && x < MAP_SIZE && y >= 0 && y < MAP_SIZE && 
+    !map[x*MAP_SIZE+y];
+}
+
+static void
+benchmark(unsigned char *map, carmen_grid_rays_p rays)
+{
+  static double x[NUM_SCANS], y[NUM_SCANS], theta[NUM_SCANS];
+  carmen_bresenham_param_t params;
+  carmen_grid_ray_t ray;
+  double start, bresenham_time, ray_time, rays_time;
+  long bresenham_cells = 0, ray_cells = 0, rays_cells = 0;
+  int scan, beam, cx, cy, i;
+
+  for (scan = 0; scan < NUM_SCANS; scan++) {
+    do {
+      x[scan] = carmen_uniform_random(0, MAP_SIZE);
+      y[scan] = carmen_uniform_random(0, MAP_SIZE);
+    } while (!is_free(map, x[scan], y[scan]));
+    theta[scan] = carmen_uniform_random(-M_PI, M_PI);
+  }
+
+  start = carmen_get_time();
+  for (scan = 0; scan < NUM_SCANS; scan++)
+    for (beam = 0; beam < NUM_BEAMS; beam++) {
+      carmen_get_bresenham_parameters
+	(x[scan], y[scan], x[scan]+MAX_RANGE*cos(theta[scan]+beam*M_PI/360),
+	 y[scan]+MAX_RANGE*sin(theta[scan]+beam*M_PI/360), &params);
+      do {
+	carmen_get_current_point(&params, &cx, &cy);
+	bresenham_cells++;
+      } while (is_free(map, cx, cy) && carmen_get_next_point(&params));
+    }
+  bresenham_time = carmen_get_time()-start;
+
+  start = carmen_get_time();
+  for (scan = 0; scan < NUM_SCANS; scan++)
+    for (beam = 0; beam < NUM_BEAMS; beam++) {
+      carmen_grid_ray_init(&ray, x[scan], y[scan], 
+			   theta[scan]+beam*M_PI/360, MAX_RANGE);
+      do
+	ray_cells++;
+      while (is_free(map, ray.x, ray.y) && carmen_grid_ray_next(&ray));
+    }
+  ray_time = carmen_get_time()-start;
+
+  start = carmen_get_time();
+  for (scan = 0; scan < NUM_SCANS; scan++) {
+    carmen_grid_rays_reset(rays, MAP_SIZE, MAP_SIZE);
+    for (beam = 0; beam < NUM_BEAMS; beam++)
+      carmen_grid_rays_add(rays, x[scan], y[scan], theta[scan]+beam*M_PI/360,
+			   MAX_RANGE);
+    while (carmen_grid_rays_next(rays, &ray, &i))
+      do {
+	rays_cells++;
+	if (map[ray.x*MAP_SIZE+ray.y]) {
+	  carmen_grid_ray_stop(&ray);
+	  break;
+	}
+      } while (carmen_grid_rays_step(rays, &ray));
+  }
+  rays_time = carmen_get_time()-start;
+
+  printf("Bresenham    %8.0f scans/s %7.1f Mcells/s\n", 
+	 NUM_SCANS/bresenham_time, bresenham_cells/bresenham_time/1e6);
+  printf("one ray      %8.0f scans/s %7.1f Mcells/s\n", 
+	 NUM_SCANS/ray_time, ray_cells/ray_time/1e6);
+  printf("%d rays    %8.0f scans/s %7.1f Mcells/s\n", NUM_BEAMS,
+	 NUM_SCANS/rays_time, rays_cells/rays_time/1e6);
+}
+
+int
+main(int argc, char **argv)
+{
+  carmen_grid_rays_p rays;
+  unsigned char *map;
+  int i, errors = 0, segment_errors = 0;
+
+  carmen_randomize(&argc, &argv);
+
+  for (i = 0; i < 10000; i++)
+    segment_errors += check_segment(carmen_uniform_random(-50, 50),
+				    carmen_uniform_random(-50, 50),
+				    carmen_uniform_random(-50, 50),
+				    carmen_uniform_random(-50, 50));
+  errors += check(segment_errors == 0, "cells of segments");
+
+  rays = carmen_grid_rays_new();
+  errors += check(check_batch(rays) == 0, "rays cast together");
+
+  map = make_map();
+  benchmark(map, rays);
+  free(map);
+  carmen_grid_rays_free(rays);
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
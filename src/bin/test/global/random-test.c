@@ -0,0 +1,112 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/*************************************
+ * checks that random streams repeat *
+ * with the same seed, and the       *
+ * moments of their samples          *
+ *************************************/
+
+#include "global.h"
+
+#define NUM_SAMPLES   1000001
+
+static int
+check_moments(char *name, double *samples, int num_samples)
+{
+  double mean = 0, var = 0;
+  int i;
+
+  for (i = 0; i < num_samples; i++)
+    mean += samples[i];
+  mean /= num_samples;
+  for (i = 0; i < num_samples; i++)
+    var += carmen_square(samples[i] - mean);
+  var /= num_samples;
+
+  if (fabs(mean) > 0.01 || fabs(var - 1.0) > 0.01) {
+    carmen_warn("%s: mean %f variance %f\n", name, mean, var);
+    return 1;
+  }
+  return 0;
+}
+
+int
+main(void)
+{
+  carmen_random_t rng, other;
+  double *samples, t, u;
+  int i, errors = 0;
+
+  samples = (double *)calloc(NUM_SAMPLES, sizeof(double));
+  carmen_test_alloc(samples);
+
+  carmen_random_seed(&rng, 42);
+  carmen_random_seed(&other, 42);
+  for (i = 0; i < 1000; i++)
+    if (carmen_random_next(&rng) != carmen_random_next(&other))
+      errors++;
+  carmen_random_seed(&other, 43);
+  if (carmen_random_next(&rng) == carmen_random_next(&other))
+    errors++;
+  if (errors)
+    carmen_warn("seeded streams differ\n");
+
+  for (i = 0; i < NUM_SAMPLES; i++) {
+    u = carmen_random_uniform(&rng, -1.0, 3.0);
+    if (u < -1.0 || u >= 3.0)
+      errors++;
+    samples[i] = (u - 1.0) * sqrt(3.0) / 2.0;
+  }
+  errors += check_moments("uniform", samples, NUM_SAMPLES);
+
+  for (i = 0; i < NUM_SAMPLES; i++)
+    samples[i] = carmen_random_gaussian(&rng, 0.0, 1.0);
+  errors += check_moments("gaussian", samples, NUM_SAMPLES);
+
+  t = carmen_get_time();
+  carmen_random_gaussians(&rng, samples, NUM_SAMPLES);
+  t = carmen_get_time() - t;
+  errors += check_moments("gaussians", samples, NUM_SAMPLES);
+  printf("carmen_random_gaussians: %5.1f ns/sample\n", t * 1e9 / NUM_SAMPLES);
+
+  t = carmen_get_time();
+  for (i = 0; i < NUM_SAMPLES; i++)
+    samples[i] = carmen_gaussian_random(0.0, 1.0);
+  t = carmen_get_time() - t;
+  printf("carmen_gaussian_random:  %5.1f ns/sample\n", t * 1e9 / NUM_SAMPLES);
+
+  free(samples);
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
@@ -70,6 +70,7 @@ int main(int argc, char **argv)
   for(i=0; i<num_laser_devices;i++)
     carmen_laser_define_laser_message(i);
 
+  carmen_laser_message_queue_init(&queue);
   laser_thread = calloc(sizeof(pthread_t), num_laser_devices);
 
   for(i=0; i<num_laser_devices;i++) {
@@ -136,6 +137,7 @@ int main(int argc, char **argv)
     //cleanup phase
     fprintf(stderr, "cleanup laser %d\n", i);
   }    
+  carmen_laser_message_queue_destroy(&queue);
   
   return 0;
 }
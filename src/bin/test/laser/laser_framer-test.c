@@ -0,0 +1,256 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <termios.h>
+
+#include "global.h"
+
+#include "sick_laser.h"
+#include "hokuyourg.h"
+
+/* Feeds SICK telegrams and Hokuyo packets, mixed with noise and split
+   at random, through a pseudo terminal into the framer, and compares
+   the checksum with the original bitwise one. */
+
+#define NUM_PACKETS 2000
+#define PACKET_DATA 732
+#define STX         0x02
+
+typedef struct {
+  int fd;
+  unsigned char* stream;
+  int size;
+} writer_t;
+
+/* the checksum as the SICK manual describes it */
+unsigned short reference_checksum(const unsigned char* data, int size){
+  unsigned char abData[2]={0, 0};
+  unsigned short crc=0;
+
+  while (size--){
+    abData[1]=abData[0];
+    abData[0]=*data++;
+    if (crc & 0x8000)
+      crc=((crc&0x7fff)<<1)^0x8005;
+    else
+      crc<<=1;
+    crc^=abData[0]|(abData[1]<<8);
+  }
+  return crc;
+}
+
+int make_telegram(unsigned char* t, int index, int size, int corrupt){
+  unsigned short crc;
+  int i;
+
+  t[0]=STX;
+  t[1]=0x80;
+  t[2]=size&0xff;
+  t[3]=size>>8;
+  t[4]=index&0xff;
+  t[5]=index>>8;
+  for (i=2; i<size; i++)
+    t[4+i]=rand();
+  crc=reference_checksum(t, size+4);
+  t[size+4]=crc&0xff;
+  t[size+5]=(crc>>8)^(corrupt ? 0x10 : 0);
+  return size+6;
+}
+
+void* writer_fn(writer_t* writer){
+  int written=0, n, val;
+
+  while (written<writer->size){
+    n=1+rand()%1500;
+    if (n>writer->size-written)
+      n=writer->size-written;
+    val=write(writer->fd, writer->stream+written, n);
+    if (val<0){
+      perror("write");
+      break;
+    }
+    written+=val;
+    if (rand()%4==0)
+      usleep(200);
+  }
+  return 0;
+}
+
+int open_pty(int* master, int* slave){
+  struct termios tio;
+
+  *master=posix_openpt(O_RDWR|O_NOCTTY);
+  if (*master<0 || grantpt(*master) || unlockpt(*master))
+    return -1;
+  *slave=open(ptsname(*master), O_RDWR|O_NOCTTY);
+  if (*slave<0)
+    return -1;
+  tcgetattr(*slave, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(*slave, TCSANOW, &tio);
+  return 0;
+}
+
+int test_checksum(void){
+  unsigned char data[4096];
+  double t, t_reference=0, t_sliced=0;
+  unsigned int sum=0;
+  int i, k, size, errors=0;
+
+  for (i=0; i<4096; i++)
+    data[i]=rand();
+  for (size=0; size<64; size++)
+    if (sick_compute_checksum(data+size, size)!=reference_checksum(data+size, size)){
+      fprintf(stderr, "checksum of %d bytes differs\n", size);
+      errors++;
+    }
+
+  for (k=0; k<2000; k++){
+    t=carmen_get_time();
+    sum+=reference_checksum(data, PACKET_DATA+4);
+    t_reference+=carmen_get_time()-t;
+    t=carmen_get_time();
+    sum+=sick_compute_checksum(data, PACKET_DATA+4);
+    t_sliced+=carmen_get_time()-t;
+  }
+  printf("checksum of %d bytes: bitwise %.2f us, slice-by-8 %.2f us (%u)\n", PACKET_DATA+4,
+	 1e6*t_reference/k, 1e6*t_sliced/k, sum&1);
+  return errors;
+}
+
+int test_sick(void){
+  sick_laser_t sick;
+  writer_t writer;
+  pthread_t thread;
+  unsigned char reply[2048];
+  unsigned char* stream;
+  struct timeval tv, last={0, 0};
+  int master, i, size=0, expected=0, received=0, errors=0;
+  double start;
+
+  stream=malloc(NUM_PACKETS*(PACKET_DATA+6+32));
+  carmen_test_alloc(stream);
+  for (i=0; i<NUM_PACKETS; i++){
+    /* noise that looks like the start of a telegram */
+    if (i%10==3){
+      stream[size++]=STX;
+      stream[size++]=0x80;
+      stream[size++]=0xff;
+      stream[size++]=0xff;
+    }
+    if (i%10==5)
+      stream[size++]=STX;
+    if (i%10==7){
+      size+=make_telegram(stream+size, i, PACKET_DATA, 1);
+      continue;
+    }
+    size+=make_telegram(stream+size, i, PACKET_DATA, 0);
+    expected++;
+  }
+
+  memset(&sick, 0, sizeof(sick));
+  if (open_pty(&master, &sick.fd)<0){
+    perror("pty");
+    return 1;
+  }
+  carmen_laser_framer_init(&sick.framer, sick.fd);
+  writer.fd=master;
+  writer.stream=stream;
+  writer.size=size;
+  start=carmen_get_time();
+  pthread_create(&thread, NULL, (void*(*)(void*))writer_fn, &writer);
+
+  i=-1;
+  while (sick_wait_packet_ts(&sick, reply, &tv)){
+    int index=reply[4]|(reply[5]<<8);
+    if (index<=i || index%10==7 || reply[2]+(reply[3]<<8)!=PACKET_DATA){
+      fprintf(stderr, "unexpected telegram %d after %d\n", index, i);
+      errors++;
+    }
+    if (timercmp(&tv, &last, <)){
+      fprintf(stderr, "telegram %d arrived before the one before\n", index);
+      errors++;
+    }
+    last=tv;
+    i=index;
+    received++;
+  }
+  pthread_join(thread, NULL);
+
+  printf("sick:    %d of %d telegrams in %.2f s, %u reads, %u bytes skipped\n", received, expected,
+	 carmen_get_time()-start, sick.framer.reads, sick.framer.skipped);
+  if (received!=expected){
+    fprintf(stderr, "received %d telegrams, expected %d\n", received, expected);
+    errors++;
+  }
+
+  close(sick.fd);
+  close(master);
+  free(stream);
+  return errors;
+}
+
+int test_hokuyo(void){
+  HokuyoURG urg;
+  writer_t writer;
+  pthread_t thread;
+  char buf[URG_BUFSIZE];
+  char* stream;
+  int master, i, size=0, received=0, errors=0;
+
+  stream=malloc(NUM_PACKETS*64);
+  carmen_test_alloc(stream);
+  for (i=0; i<NUM_PACKETS; i++)
+    size+=sprintf(stream+size, "MD0044072500001\n99b\n%05d\n0C0C0C\n\n", i);
+
+  memset(&urg, 0, sizeof(urg));
+  if (open_pty(&master, &urg.fd)<0){
+    perror("pty");
+    return 1;
+  }
+  carmen_laser_framer_init(&urg.framer, urg.fd);
+  writer.fd=master;
+  writer.stream=(unsigned char*)stream;
+  writer.size=size;
+  pthread_create(&thread, NULL, (void*(*)(void*))writer_fn, &writer);
+
+  while (hokuyo_readPacket(&urg, buf, URG_BUFSIZE, 10)>0){
+    int index=atoi(buf+20);
+    if (index!=received || strncmp(buf, "MD", 2) || buf[strlen(buf)-2]!='\n'){
+      fprintf(stderr, "unexpected packet %d, expected %d\n", index, received);
+      errors++;
+    }
+    received++;
+  }
+  pthread_join(thread, NULL);
+
+  printf("hokuyo:  %d of %d packets, %u reads\n", received, NUM_PACKETS, urg.framer.reads);
+  if (received!=NUM_PACKETS){
+    fprintf(stderr, "received %d packets, expected %d\n", received, NUM_PACKETS);
+    errors++;
+  }
+
+  close(urg.fd);
+  close(master);
+  free(stream);
+  return errors;
+}
+
+int main(void){
+  int errors=0;
+
+  srand(1);
+  errors+=test_checksum();
+  errors+=test_sick();
+  errors+=test_hokuyo();
+
+  if (errors){
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include "global.h"
+
+#include "carmen_laser_message_queue.h"
+
+/* Two lasers feed their queues, which share one wakeup, while the main
+   thread drains them as laser.c does. Measures the time from enqueueing
+   a scan to the point where it would be published, and checks that
+   every scan is either published or counted as dropped. */
+
+#define NUM_LASERS   2
+#define NUM_SCANS    20000
+#define NUM_READINGS 541
+
+typedef struct {
+  int id;
+  int period_us;
+  int sent;
+} producer_t;
+
+carmen_laser_message_queue_t queues[NUM_LASERS];
+volatile int producers_done=0;
+
+double* latencies;
+int num_latencies=0;
+int last_scan[NUM_LASERS];
+int out_of_order=0;
+
+void* producer_fn(producer_t* producer){
+  carmen_laser_message_queue_t* queue=queues+producer->id;
+  carmen_laser_laser_static_message* m;
+  uint64_t one=1;
+  int i, j;
+
+  for (i=0; i<NUM_SCANS; i++){
+    m=carmen_laser_message_queue_acquire(queue);
+    if (m){
+      m->id=producer->id;
+      m->num_readings=NUM_READINGS;
+      m->num_remissions=0;
+      for (j=0; j<NUM_READINGS; j++)
+	m->range[j]=i;
+      m->timestamp=carmen_get_time();
+      carmen_laser_message_queue_commit(queue);
+    }
+    producer->sent++;
+    if (producer->period_us>0)
+      usleep(producer->period_us);
+  }
+  __atomic_add_fetch(&producers_done, 1, __ATOMIC_SEQ_CST);
+  if (write(queues[0].wakeup->fd, &one, sizeof(one))<0)
+    perror("write");
+  return 0;
+}
+
+void publish(carmen_laser_laser_static_message* m, void* data __attribute__((unused))){
+  int scan=(int)m->range[0];
+
+  latencies[num_latencies++]=carmen_get_time()-m->timestamp;
+  if (scan<=last_scan[m->id] || m->range[NUM_READINGS-1]!=scan)
+    out_of_order++;
+  last_scan[m->id]=scan;
+}
+
+int compare_doubles(const void* a, const void* b){
+  double da=*(const double*)a, db=*(const double*)b;
+  return (da>db)-(da<db);
+}
+
+int run(char* name, int period_us, int consumer_delay_us){
+  producer_t producers[NUM_LASERS];
+  pthread_t threads[NUM_LASERS];
+  unsigned int dropped=0;
+  int i, sent=0, drained, errors=0;
+  double sum=0;
+
+  for (i=0; i<NUM_LASERS; i++){
+    carmen_laser_message_queue_init(queues+i);
+    carmen_laser_message_queue_share_wakeup(queues+i, queues);
+    last_scan[i]=-1;
+  }
+  num_latencies=0;
+  out_of_order=0;
+  producers_done=0;
+
+  for (i=0; i<NUM_LASERS; i++){
+    producers[i].id=i;
+    producers[i].period_us=period_us;
+    producers[i].sent=0;
+    pthread_create(threads+i, NULL, (void*(*)(void*))producer_fn, producers+i);
+  }
+
+  for (;;){
+    drained=0;
+    for (i=0; i<NUM_LASERS; i++)
+      drained+=carmen_laser_message_queue_drain(queues+i, publish, NULL, 0);
+    if (consumer_delay_us>0 && drained>0)
+      usleep(consumer_delay_us);
+    if (!drained){
+      if (__atomic_load_n(&producers_done, __ATOMIC_SEQ_CST)==NUM_LASERS)
+	break;
+      carmen_laser_message_queue_wait(queues, NUM_LASERS);
+    }
+  }
+
+  for (i=0; i<NUM_LASERS; i++)
+    pthread_join(threads[i], NULL);
+  for (i=0; i<NUM_LASERS; i++){
+    sent+=producers[i].sent;
+    dropped+=carmen_laser_message_queue_dropped(queues+i);
+    drained=carmen_laser_message_queue_drain(queues+i, publish, NULL, 0);
+    if (drained){
+      fprintf(stderr, "%s: %d scans left in queue %d\n", name, drained, i);
+      errors++;
+    }
+    carmen_laser_message_queue_destroy(queues+i);
+  }
+
+  for (i=0; i<num_latencies; i++)
+    sum+=latencies[i];
+  qsort(latencies, num_latencies, sizeof(double), compare_doubles);
+  if (num_latencies>0)
+    printf("%-10s published %6d, dropped %6u, latency mean %7.1f us, p99 %7.1f us, max %8.1f us\n",
+	   name, num_latencies, dropped, 1e6*sum/num_latencies,
+	   1e6*latencies[(int)(0.99*(num_latencies-1))], 1e6*latencies[num_latencies-1]);
+
+  if (num_latencies+(int)dropped!=sent){
+    fprintf(stderr, "%s: sent %d scans, published %d and dropped %u\n", name, sent, num_latencies, dropped);
+    errors++;
+  }
+  if (out_of_order){
+    fprintf(stderr, "%s: %d scans out of order or torn\n", name, out_of_order);
+    errors++;
+  }
+  return errors;
+}
+
+void interrupt_handler(int sig __attribute__((unused))){
+  carmen_laser_message_queue_interrupt(queues);
+}
+
+/* Ctrl-C with no scan coming: the handler is installed with signal(),
+   as in laser.c, so the read on the eventfd is restarted and only the
+   interrupt ends the wait. Hangs if it does not. */
+int run_interrupt(void){
+  double start;
+  int i;
+
+  for (i=0; i<NUM_LASERS; i++){
+    carmen_laser_message_queue_init(queues+i);
+    carmen_laser_message_queue_share_wakeup(queues+i, queues);
+  }
+  signal(SIGALRM, interrupt_handler);
+  start=carmen_get_wall_time();
+  ualarm(200000, 0);
+  carmen_laser_message_queue_wait(queues, NUM_LASERS);
+  printf("interrupt: wait ended after %.3f s\n", carmen_get_wall_time()-start);
+  signal(SIGALRM, SIG_DFL);
+  for (i=0; i<NUM_LASERS; i++)
+    carmen_laser_message_queue_destroy(queues+i);
+  return 0;
+}
+
+int main(void){
+  int errors=0;
+
+  latencies=calloc(NUM_LASERS*NUM_SCANS, sizeof(double));
+  carmen_test_alloc(latencies);
+
+  /* lasers at 4 kHz, a consumer that keeps up and sleeps in between */
+  errors+=run("paced", 250, 0);
+  /* as fast as the lasers can write */
+  errors+=run("burst", 0, 0);
+  /* a consumer that is too slow, so the queues overflow */
+  errors+=run("overflow", 0, 200);
+  errors+=run_interrupt();
+
+  free(latencies);
+  if (errors){
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
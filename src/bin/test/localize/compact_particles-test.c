@@ -0,0 +1,132 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/*************************************
+ * encodes a particle cloud into the *
+ * compact particle message and      *
+ * checks the decoded poses          *
+ *************************************/
+
+#include "global.h"
+#include "localize_interface.h"
+
+#define NUM_PARTICLES   5000
+#define MAX_PARTICLES   500
+
+static int
+check_decoded(carmen_localize_particle_ipc_p particles,
+	      carmen_localize_compact_particle_message *msg)
+{
+  carmen_localize_particle_ipc_t decoded[MAX_PARTICLES];
+  carmen_localize_particle_ipc_p particle;
+  int i, errors = 0;
+
+  carmen_localize_decode_compact_particles(msg, decoded);
+  for (i = 0; i < msg->num_particles; i++) {
+    particle = particles + i * (NUM_PARTICLES / MAX_PARTICLES);
+    if (fabs(decoded[i].x - particle->x) > msg->xy_resolution ||
+	fabs(decoded[i].y - particle->y) > msg->xy_resolution ||
+	fabs(carmen_normalize_theta(decoded[i].theta - particle->theta)) >
+	CARMEN_LOCALIZE_COMPACT_THETA_RESOLUTION ||
+	decoded[i].weight > 0.0) {
+      if (errors++ < 5)
+	carmen_warn("particle %d: %f %f %f, expected %f %f %f\n", i,
+		    decoded[i].x, decoded[i].y, decoded[i].theta,
+		    particle->x, particle->y, particle->theta);
+    }
+  }
+  return errors;
+}
+
+int
+main(int argc, char **argv)
+{
+  carmen_localize_particle_ipc_t particles[NUM_PARTICLES];
+  carmen_localize_compact_particle_t compact[MAX_PARTICLES];
+  carmen_localize_compact_particle_message msg;
+  int i, errors = 0;
+
+  carmen_randomize(&argc, &argv);
+
+  for (i = 0; i < NUM_PARTICLES; i++) {
+    particles[i].x = 12.0 + carmen_gaussian_random(0, 2.0);
+    particles[i].y = -3.0 + carmen_gaussian_random(0, 2.0);
+    particles[i].theta = carmen_uniform_random(-M_PI, M_PI);
+    particles[i].weight = carmen_uniform_random(-50.0, 0.0);
+  }
+
+  msg.particles = compact;
+  msg.globalpos.x = 12.0;
+  msg.globalpos.y = -3.0;
+  msg.globalpos.theta = 0.0;
+  carmen_localize_encode_compact_particles(particles, NUM_PARTICLES,
+					   MAX_PARTICLES, &msg);
+  if (msg.num_particles != MAX_PARTICLES ||
+      msg.filter_particles != NUM_PARTICLES) {
+    carmen_warn("encoded %d of %d particles\n", msg.num_particles,
+		msg.filter_particles);
+    errors++;
+  }
+  if (msg.xy_resolution != CARMEN_LOCALIZE_COMPACT_XY_RESOLUTION) {
+    carmen_warn("resolution %f for a tight cloud\n", msg.xy_resolution);
+    errors++;
+  }
+  errors += check_decoded(particles, &msg);
+
+  /* global localization: particles all over a large map no longer fit
+     into 16 bits at full resolution */
+  particles[0].x = 12.0 + 1000.0;
+  particles[NUM_PARTICLES / 2].y = -3.0 - 2500.0;
+  carmen_localize_encode_compact_particles(particles, NUM_PARTICLES,
+					   MAX_PARTICLES, &msg);
+  if (msg.xy_resolution <= CARMEN_LOCALIZE_COMPACT_XY_RESOLUTION ||
+      msg.xy_resolution > 2500.0 / 32767.0 + 1e-9) {
+    carmen_warn("resolution %f for a 2500 m cloud\n", msg.xy_resolution);
+    errors++;
+  }
+  errors += check_decoded(particles, &msg);
+
+  /* fewer particles than allowed: all of them */
+  carmen_localize_encode_compact_particles(particles, 10, MAX_PARTICLES,
+					   &msg);
+  if (msg.num_particles != 10) {
+    carmen_warn("encoded %d of 10 particles\n", msg.num_particles);
+    errors++;
+  }
+
+  printf("%d particles in %d bytes instead of %d\n", MAX_PARTICLES,
+	 (int)(MAX_PARTICLES * sizeof(carmen_localize_compact_particle_t)),
+	 (int)(NUM_PARTICLES * sizeof(carmen_localize_particle_ipc_t)));
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
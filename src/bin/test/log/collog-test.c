@@ -0,0 +1,300 @@
+ /*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include "global.h"
+
+#include "readlog.h"
+#include "writelog.h"
+
+/* Writes a synthetic carmen log, converts it into a columnar log and
+   checks that reading the columnar log returns the same lines and laser
+   messages. Reports file sizes and the time needed to index and read
+   both files. */
+
+#define NUM_SCANS         20000
+#define NUM_BEAMS         361
+#define MAX_LINE_LENGTH   100000
+
+static void
+write_ascii_log(char *filename)
+{
+  carmen_FILE *outfile;
+  carmen_robot_laser_message laser;
+  carmen_base_odometry_message odometry;
+  double timestamp = 1000.0, angle;
+  int i, j;
+
+  outfile = carmen_fopen(filename, "w");
+  if (outfile == NULL)
+    carmen_die("Error: could not open file %s for writing.\n", filename);
+
+  carmen_logwrite_write_header(outfile);
+  carmen_logwrite_write_param("robot", "frontlaser_offset", "0.2", timestamp,
+			      "localhost", outfile, 0.0);
+
+  memset(&laser, 0, sizeof(carmen_robot_laser_message));
+  laser.config.fov = M_PI;
+  laser.config.start_angle = -M_PI/2;
+  laser.config.angular_resolution = M_PI/(NUM_BEAMS - 1);
+  laser.config.maximum_range = 81.0;
+  laser.config.accuracy = 0.01;
+  laser.num_readings = NUM_BEAMS;
+  laser.range = (float *)calloc(NUM_BEAMS, sizeof(float));
+  carmen_test_alloc(laser.range);
+  laser.host = "localhost";
+
+  memset(&odometry, 0, sizeof(carmen_base_odometry_message));
+  odometry.host = "localhost";
+
+  for (i = 0; i < NUM_SCANS; i++) {
+    odometry.x = 0.01*i;
+    odometry.theta = carmen_normalize_theta(0.001*i);
+    odometry.tv = 0.3;
+    odometry.timestamp = timestamp + 0.05*i;
+    carmen_logwrite_write_odometry(&odometry, outfile, 0.05*i);
+
+    /* a rectangular room seen from a moving robot */
+    for (j = 0; j < NUM_BEAMS; j++) {
+      angle = laser.config.start_angle + j*laser.config.angular_resolution + 
+	odometry.theta;
+      laser.range[j] = carmen_fmin(fabs(4.0/cos(angle)), 
+				   fabs(7.5/sin(angle))) +
+	carmen_gaussian_random(0.0, 0.01);
+    }
+    /* readings beyond 65.535 m are kept in the text column */
+    if (i % 1000 == 0)
+      laser.range[0] = 81.0;
+    laser.robot_pose.x = odometry.x;
+    laser.robot_pose.theta = odometry.theta;
+    laser.laser_pose = laser.robot_pose;
+    laser.timestamp = timestamp + 0.05*i + 0.01;
+    carmen_logwrite_write_robot_laser(&laser, 1, outfile, 0.05*i + 0.01);
+  }
+  carmen_fclose(outfile);
+  free(laser.range);
+}
+
+static void
+convert_log(char *infilename, char *outfilename)
+{
+  carmen_FILE *infile;
+  carmen_logfile_index_p index;
+  carmen_collog_writer_p writer;
+  char *line;
+  int i;
+
+  infile = carmen_fopen(infilename, "r");
+  writer = carmen_collog_writer_open(outfilename);
+  if (infile == NULL || writer == NULL)
+    carmen_die("Error: could not convert %s.\n", infilename);
+
+  line = (char *)malloc(MAX_LINE_LENGTH);
+  carmen_test_alloc(line);
+  index = carmen_logfile_index_messages(infile);
+  for (i = 0; i < index->num_messages; i++) {
+    carmen_logfile_read_line(index, infile, i, MAX_LINE_LENGTH, line);
+    if (carmen_collog_write_line(writer, line) < 0)
+      carmen_die("Error: could not write %s.\n", outfilename);
+  }
+  if (carmen_collog_writer_close(writer) < 0)
+    carmen_die("Error: could not write %s.\n", outfilename);
+
+  carmen_logfile_free_index(&index);
+  carmen_fclose(infile);
+  free(line);
+}
+
+static void
+compare_lasers(int message, carmen_robot_laser_message *ascii,
+	       carmen_robot_laser_message *columnar)
+{
+  if (ascii->num_readings != columnar->num_readings ||
+      memcmp(ascii->range, columnar->range, 
+	     ascii->num_readings*sizeof(float)) != 0 ||
+      ascii->num_remissions != columnar->num_remissions ||
+      ascii->laser_pose.x != columnar->laser_pose.x ||
+      ascii->robot_pose.theta != columnar->robot_pose.theta ||
+      ascii->config.fov != columnar->config.fov ||
+      ascii->timestamp != columnar->timestamp ||
+      strcmp(ascii->host, columnar->host) != 0)
+    carmen_die("Error: laser message %d differs.\n", message);
+}
+
+/* checks that the columnar log returns the lines of the ascii log, and
+   that lasers decoded from its columns equal the parsed ascii lasers */
+static void
+compare_logs(char *ascii_filename, char *columnar_filename)
+{
+  carmen_FILE *infile[2];
+  carmen_logfile_index_p index[2];
+  carmen_robot_laser_message laser[2];
+  char *line[2];
+  int i, j;
+
+  for (j = 0; j < 2; j++) {
+    infile[j] = carmen_fopen(j == 0 ? ascii_filename : columnar_filename, 
+			     "r");
+    index[j] = carmen_logfile_index_messages(infile[j]);
+    memset(laser + j, 0, sizeof(carmen_robot_laser_message));
+    line[j] = (char *)malloc(MAX_LINE_LENGTH);
+    carmen_test_alloc(line[j]);
+  }
+  if (index[0]->num_messages != index[1]->num_messages)
+    carmen_die("Error: %d instead of %d messages.\n", 
+	       index[1]->num_messages, index[0]->num_messages);
+
+  for (i = 0; i < index[0]->num_messages; i++) {
+    for (j = 0; j < 2; j++)
+      carmen_logfile_read_line(index[j], infile[j], i, MAX_LINE_LENGTH, 
+			       line[j]);
+    if (strcmp(line[0], line[1]) != 0)
+      carmen_die("Error: message %d differs:\n%s\n%s\n", i, line[0], 
+		 line[1]);
+    if (strncmp(line[0], "ROBOTLASER1 ", 12) != 0)
+      continue;
+    for (j = 0; j < 2; j++)
+      if (carmen_logfile_read_robot_laser_message(index[j], infile[j], i,
+						  MAX_LINE_LENGTH, line[j],
+						  laser + j) < 0)
+	carmen_die("Error: message %d is no laser message.\n", i);
+    compare_lasers(i, laser, laser + 1);
+  }
+
+  for (j = 0; j < 2; j++) {
+    carmen_logfile_free_index(index + j);
+    carmen_fclose(infile[j]);
+    free(line[j]);
+    free(laser[j].range);
+    free(laser[j].tooclose);
+    free(laser[j].remission);
+    free(laser[j].host);
+  }
+}
+
+/* reads a log the way a tool does: lasers into their message, anything
+   else as a line */
+static double
+parse_log(char *filename)
+{
+  carmen_FILE *infile;
+  carmen_logfile_index_p index;
+  carmen_robot_laser_message laser;
+  char *line;
+  double start_time;
+  int i;
+
+  memset(&laser, 0, sizeof(carmen_robot_laser_message));
+  line = (char *)malloc(MAX_LINE_LENGTH);
+  carmen_test_alloc(line);
+
+  start_time = carmen_get_wall_time();
+  infile = carmen_fopen(filename, "r");
+  index = carmen_logfile_index_messages(infile);
+  for (i = 0; i < index->num_messages; i++)
+    if (carmen_logfile_read_robot_laser_message(index, infile, i, 
+						MAX_LINE_LENGTH, line,
+						&laser) < 0)
+      carmen_logfile_read_line(index, infile, i, MAX_LINE_LENGTH, line);
+
+  carmen_logfile_free_index(&index);
+  carmen_fclose(infile);
+  free(line);
+
+  return carmen_get_wall_time() - start_time;
+}
+
+static off_t
+file_size(char *filename)
+{
+  struct stat stat_buf;
+
+  if (stat(filename, &stat_buf) < 0)
+    return 0;
+  return stat_buf.st_size;
+}
+
+int 
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused)))
+{
+  char *ascii_filename = "/tmp/collog-test.clf";
+  char *columnar_filename = "/tmp/collog-test" CARMEN_COLLOG_EXTENSION;
+  carmen_collog_reader_p reader;
+  carmen_FILE *infile;
+  double ascii_time, columnar_time, timestamp;
+  unsigned char block_size[4];
+  FILE *fp;
+  int num_messages, message;
+
+  carmen_randomize(&argc, &argv);
+
+  write_ascii_log(ascii_filename);
+  convert_log(ascii_filename, columnar_filename);
+
+  infile = carmen_fopen(columnar_filename, "r");
+  reader = carmen_collog_reader_open(infile);
+  if (reader == NULL)
+    carmen_die("Error: %s is no columnar log.\n", columnar_filename);
+  num_messages = carmen_collog_num_messages(reader);
+
+  /* time index: the first laser message logged after 500 s */
+  message = carmen_collog_find_timestamp(reader, 500.0);
+  timestamp = carmen_collog_message_timestamp(reader, message);
+  if (timestamp < 500.0 || 
+      carmen_collog_message_timestamp(reader, message - 1) >= 500.0)
+    carmen_die("Error: time index returned message %d at %f.\n", message,
+	       timestamp);
+  carmen_collog_reader_free(reader);
+  carmen_fclose(infile);
+
+  /* the block size after the magic is little-endian on every host */
+  fp = fopen(columnar_filename, "r");
+  if (fp == NULL || fseek(fp, 16, SEEK_SET) < 0 || 
+      fread(block_size, 1, 4, fp) != 4 ||
+      block_size[0] != (CARMEN_COLLOG_BLOCK_SIZE & 0xff) ||
+      block_size[1] != (CARMEN_COLLOG_BLOCK_SIZE >> 8) ||
+      block_size[2] != 0 || block_size[3] != 0)
+    carmen_die("Error: block size is not stored little-endian.\n");
+  fclose(fp);
+
+  compare_logs(ascii_filename, columnar_filename);
+  ascii_time = parse_log(ascii_filename);
+  columnar_time = parse_log(columnar_filename);
+
+  carmen_warn("%d messages, all lines and lasers identical\n", 
+	      num_messages);
+  carmen_warn("ascii log:    %8.1f MB, read and parsed in %.2f s\n",
+	      file_size(ascii_filename) / 1048576.0, ascii_time);
+  carmen_warn("columnar log: %8.1f MB, read and parsed in %.2f s\n",
+	      file_size(columnar_filename) / 1048576.0, columnar_time);
+  carmen_warn("compression:  %8.1fx\n", (double)file_size(ascii_filename) /
+	      file_size(columnar_filename));
+
+  unlink(ascii_filename);
+  unlink(columnar_filename);
+  return 0;
+}
@@ -0,0 +1,233 @@
+ /*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include "global.h"
+
+#include "readlog.h"
+#include "writelog.h"
+
+/* Writes three hours of synthetic odometry into two logs, recorded by
+   loggers started five seconds apart. Checks seeking by time, that the
+   stored index matches a freshly built one, and the order in which the
+   two logs are merged. Reports the time needed to index, to load the
+   stored index and to seek. */
+
+#define LOG_RATE          20.0
+#define LOG_LENGTH        (3*3600.0)
+#define LOGGER_OFFSET     5.0
+#define MAX_LINE_LENGTH   100000
+
+static void
+write_log(char *filename, double start_time)
+{
+  carmen_FILE *outfile;
+  carmen_base_odometry_message odometry;
+  int i;
+
+  outfile = carmen_fopen(filename, "w");
+  if (outfile == NULL)
+    carmen_die("Error: could not open file %s for writing.\n", filename);
+
+  carmen_logwrite_write_header(outfile);
+  memset(&odometry, 0, sizeof(carmen_base_odometry_message));
+  odometry.host = "localhost";
+  for (i = 0; i < LOG_LENGTH*LOG_RATE; i++) {
+    odometry.x = 0.01*i;
+    odometry.tv = 0.2;
+    odometry.timestamp = start_time + i/LOG_RATE;
+    carmen_logwrite_write_odometry(&odometry, outfile, i/LOG_RATE);
+  }
+  carmen_fclose(outfile);
+}
+
+static carmen_logfile_index_p
+index_log(char *filename, carmen_FILE **infile, double *time)
+{
+  carmen_logfile_index_p index;
+
+  *time = carmen_get_time();
+  *infile = carmen_fopen(filename, "r");
+  if (*infile == NULL)
+    carmen_die("Error: could not open file %s for reading.\n", filename);
+  index = carmen_logfile_index_messages_cached(*infile, filename);
+  *time = carmen_get_time() - *time;
+  return index;
+}
+
+static int
+check_index(carmen_logfile_index_p index, carmen_logfile_index_p expected)
+{
+  int i;
+
+  if (index->num_messages != expected->num_messages ||
+      index->start_time != expected->start_time) {
+    carmen_warn("stored index has %d messages from %f, expected %d from %f\n",
+		index->num_messages, index->start_time,
+		expected->num_messages, expected->start_time);
+    return 1;
+  }
+  for (i = 0; i < index->num_messages; i++)
+    if (index->offset[i] != expected->offset[i] ||
+	index->timestamp[i] != expected->timestamp[i]) {
+      carmen_warn("stored index differs at message %d\n", i);
+      return 1;
+    }
+  return 0;
+}
+
+static int
+check_seek(carmen_logfile_index_p index, carmen_FILE *infile, double time)
+{
+  char line[MAX_LINE_LENGTH];
+  int message, errors = 0;
+  double timestamp;
+
+  message = carmen_logfile_find_timestamp(index, time);
+  if (message > 0 && carmen_logfile_message_timestamp(index, message - 1) >= 
+      time)
+    errors++;
+  if (message < index->num_messages && 
+      carmen_logfile_message_timestamp(index, message) < time)
+    errors++;
+
+  /* the message read agrees with the index */
+  if (message < index->num_messages) {
+    carmen_logfile_read_line(index, infile, message, MAX_LINE_LENGTH, line);
+    timestamp = atof(strrchr(line, ' '));
+    if (fabs(timestamp - carmen_logfile_message_timestamp(index, message)) > 
+	1e-6)
+      errors++;
+  }
+  if (errors)
+    carmen_warn("seek to %f found message %d\n", time, message);
+  return errors;
+}
+
+static int
+check_merge(carmen_logfile_index_p *index)
+{
+  carmen_logfile_merge_p merge;
+  int log, message, expected[2] = {0, 0}, count[2] = {0, 0}, errors = 0;
+  double time, last_time = -1;
+
+  merge = carmen_logfile_merge_new(2, index);
+  if (fabs(merge->offset[1] - merge->offset[0] - LOGGER_OFFSET) > 1e-6) {
+    carmen_warn("logs are %f s apart, expected %f s\n", 
+		merge->offset[1] - merge->offset[0], LOGGER_OFFSET);
+    errors++;
+  }
+
+  while (carmen_logfile_merge_next(merge, &log, &message, &time)) {
+    if (time < last_time || message != expected[log]) {
+      if (errors++ < 5)
+	carmen_warn("merge went to message %d of log %d at %f\n", message,
+		    log, time);
+    }
+    expected[log] = message + 1;
+    count[log]++;
+    last_time = time;
+  }
+  if (count[0] != index[0]->num_messages || 
+      count[1] != index[1]->num_messages) {
+    carmen_warn("merge returned %d and %d messages\n", count[0], count[1]);
+    errors++;
+  }
+
+  /* both logs continue at the same point of the timeline */
+  carmen_logfile_merge_seek(merge, 47*60.0);
+  carmen_logfile_merge_next(merge, &log, &message, &time);
+  if (log != 0 || fabs(time - 47*60.0) > 1e-6 ||
+      fabs(carmen_logfile_message_timestamp(index[1], merge->next[1]) - 
+	   (47*60.0 - LOGGER_OFFSET)) > 1e-6) {
+    carmen_warn("merge seek to minute 47 went to %f\n", time);
+    errors++;
+  }
+
+  carmen_logfile_merge_free(merge);
+  return errors;
+}
+
+int 
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused)))
+{
+  char filenames[2][32] = {"/tmp/logindex-test-1XXXXXX", 
+			   "/tmp/logindex-test-2XXXXXX"};
+  carmen_logfile_index_p index[2], stored;
+  carmen_FILE *infile[2], *stored_infile;
+  double index_time, stored_time, seek_time;
+  char *index_filename;
+  int fd, i, errors = 0;
+
+  carmen_randomize(&argc, &argv);
+
+  for (i = 0; i < 2; i++) {
+    fd = mkstemp(filenames[i]);
+    if (fd < 0)
+      carmen_die_syserror("Could not create %s", filenames[i]);
+    close(fd);
+    write_log(filenames[i], 1000.0 + i*LOGGER_OFFSET);
+    index[i] = index_log(filenames[i], &infile[i], &index_time);
+  }
+
+  stored = index_log(filenames[0], &stored_infile, &stored_time);
+  errors += check_index(stored, index[0]);
+  carmen_logfile_free_index(&stored);
+  carmen_fclose(stored_infile);
+
+  errors += check_seek(index[0], infile[0], -1.0);
+  errors += check_seek(index[0], infile[0], LOG_LENGTH + 1.0);
+  seek_time = carmen_get_time();
+  errors += check_seek(index[0], infile[0], 47*60.0);
+  seek_time = carmen_get_time() - seek_time;
+  for (i = 0; i < 1000; i++)
+    errors += check_seek(index[0], infile[0], 
+			 carmen_uniform_random(0, LOG_LENGTH));
+
+  errors += check_merge(index);
+
+  printf("%d messages: indexed in %.3f s, stored index loaded in %.3f s, "
+	 "seek to minute 47 in %.3f ms\n", index[0]->num_messages,
+	 index_time, stored_time, seek_time*1e3);
+
+  for (i = 0; i < 2; i++) {
+    carmen_logfile_free_index(&index[i]);
+    carmen_fclose(infile[i]);
+    index_filename = carmen_new_string("%s%s", filenames[i],
+				       CARMEN_LOGFILE_INDEX_EXTENSION);
+    unlink(index_filename);
+    free(index_filename);
+    unlink(filenames[i]);
+  }
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
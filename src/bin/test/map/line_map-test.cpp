@@ -0,0 +1,209 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include <float.h>
+
+#include "global.h"
+
+#include "line_map.h"
+
+// Builds a line map from a long simulated log of a corridor lined with 
+// rooms, checks that every mapped segment lies on a wall, and reports the
+// time per scan as the map grows.
+
+#define CORRIDOR_LENGTH 2000.0
+#define ROOM_WIDTH      4.0
+#define DOOR_WIDTH      1.0
+#define NUM_BEAMS       181
+#define STEP            0.2
+#define BLOCK_SIZE      500
+
+extern carmen_linemapping_parameters_t carmen_linemapping_params_global;
+
+static carmen_linemapping_segment_t *walls = NULL;
+static int num_walls = 0, max_walls = 0;
+
+static void
+add_wall(double x1, double y1, double x2, double y2)
+{
+  if(num_walls == max_walls){
+    max_walls = 2*max_walls + 64;
+    walls = (carmen_linemapping_segment_t *)
+      realloc(walls, max_walls*sizeof(carmen_linemapping_segment_t));
+    carmen_test_alloc(walls);
+  }
+  walls[num_walls].p1.x = x1;
+  walls[num_walls].p1.y = y1;
+  walls[num_walls].p2.x = x2;
+  walls[num_walls].p2.y = y2;
+  walls[num_walls].weight = 1;
+  num_walls++;
+}
+
+#define WALLS_PER_ROOM  6
+
+static void
+build_corridor(void)
+{
+  add_wall(0, -4.0, 0, 4.0);
+  add_wall(CORRIDOR_LENGTH, -4.0, CORRIDOR_LENGTH, 4.0);
+  for(double x=0; x<CORRIDOR_LENGTH; x+=ROOM_WIDTH){
+    for(int side=-1; side<=1; side+=2){
+      // corridor wall with a door into each room
+      add_wall(x, side*1.0, x+ROOM_WIDTH-DOOR_WIDTH, side*1.0);
+      // back wall and divider of the room
+      add_wall(x, side*4.0, x+ROOM_WIDTH, side*4.0);
+      add_wall(x, side*1.0, x, side*4.0);
+    }
+  }
+}
+
+static double
+intersect_wall(const carmen_linemapping_segment_t *w, double x, double y, 
+	       double dx, double dy, double range)
+{
+  double ex = w->p2.x - w->p1.x, ey = w->p2.y - w->p1.y;
+  double denominator = dx*ey - dy*ex;
+  if(fabs(denominator) < 1e-12)
+    return range;
+  double t = ((w->p1.x - x)*ey - (w->p1.y - y)*ex) / denominator;
+  double u = ((w->p1.x - x)*dy - (w->p1.y - y)*dx) / denominator;
+  if(t > 0 && t < range && u >= 0 && u <= 1)
+    return t;
+  return range;
+}
+
+static double
+cast_ray(double x, double y, double theta, double max_range)
+{
+  double dx = cos(theta), dy = sin(theta), range = max_range;
+
+  // the end walls, then the walls of the rooms within range
+  range = intersect_wall(&walls[0], x, y, dx, dy, range);
+  range = intersect_wall(&walls[1], x, y, dx, dy, range);
+  int first = 2 + (int)carmen_fmax(0, floor((x - max_range) / ROOM_WIDTH))*WALLS_PER_ROOM;
+  int last = 2 + (int)floor((x + max_range) / ROOM_WIDTH + 1)*WALLS_PER_ROOM;
+  for(int i=first; i<last && i<num_walls; i++)
+    range = intersect_wall(&walls[i], x, y, dx, dy, range);
+  return range;
+}
+
+static double
+distance_to_walls(const carmen_point_t *p)
+{
+  double best = DBL_MAX;
+
+  for(int i=0; i<num_walls; i++)
+    best = fmin(best, carmen_linemapping_distance_point_linesegment(&walls[i], p));
+  return best;
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused)))
+{
+  carmen_linemapping_parameters_t *param = &carmen_linemapping_params_global;
+  carmen_linemapping_segment_set_t linemap;
+  carmen_robot_laser_message scan;
+  float range[NUM_BEAMS];
+  double start, block_time = 0, total_time = 0;
+  int num_scans = (int)(CORRIDOR_LENGTH / STEP) - 10, errors = 0;
+
+  // the defaults of carmen.ini
+  param->laser_max_length = 6.0;
+  param->sam_tolerance = 0.1;
+  param->sam_max_gap = 0.3;
+  param->sam_min_length = 0.4;
+  param->sam_min_num = 5;
+  param->sam_use_fit_split = 0;
+  param->merge_max_dist = 0.1;
+  param->merge_min_relative_overlap = 0.2;
+  param->merge_overlap_min_length = 0.2;
+  param->merge_uniformly_distribute_dist = 0.05;
+
+  carmen_randomize(&argc, &argv);
+  build_corridor();
+
+  memset(&scan, 0, sizeof(carmen_robot_laser_message));
+  scan.num_readings = NUM_BEAMS;
+  scan.range = range;
+  scan.config.start_angle = -M_PI/2;
+  scan.config.angular_resolution = M_PI/(NUM_BEAMS-1);
+  scan.config.fov = M_PI;
+  scan.config.maximum_range = 8.0;
+
+  linemap.num_segs = 0;
+  linemap.segs = NULL;
+  linemap.index = NULL;
+
+  for(int i=0; i<num_scans; i++){
+    scan.laser_pose.x = 1.0 + i*STEP;
+    scan.laser_pose.y = 0.3*sin(i*0.05);
+    scan.laser_pose.theta = ((i/50) % 2) ? M_PI : 0.0;
+    for(int b=0; b<NUM_BEAMS; b++)
+      range[b] = cast_ray(scan.laser_pose.x, scan.laser_pose.y, 
+			  scan.laser_pose.theta + scan.config.start_angle + 
+			  b*scan.config.angular_resolution, 8.0) + 
+	carmen_gaussian_random(0, 0.01);
+
+    start = carmen_get_time();
+    if(i == 0)
+      linemap = carmen_linemapping_get_segments_from_scan(&scan, false);
+    else
+      carmen_linemapping_update_linemap(&linemap, &scan);
+    block_time += carmen_get_time() - start;
+
+    if((i+1) % BLOCK_SIZE == 0){
+      printf("scans %5d-%5d: %6.3f ms/scan, %5d segments\n", i+1-BLOCK_SIZE, i, 
+	     1000.0*block_time / BLOCK_SIZE, linemap.num_segs);
+      total_time += block_time;
+      block_time = 0;
+    }
+  }
+  total_time += block_time;
+  printf("%d scans mapped in %.2f s, %d segments for %d walls\n", num_scans, 
+	 total_time, linemap.num_segs, num_walls);
+
+  for(int i=0; i<linemap.num_segs; i++){
+    if(linemap.segs[i].weight == 0 || 
+       distance_to_walls(&linemap.segs[i].p1) > 0.15 || 
+       distance_to_walls(&linemap.segs[i].p2) > 0.15){
+      if(errors < 10)
+	printf("segment %d (%.2f %.2f)-(%.2f %.2f) is not on a wall\n", i, 
+	       linemap.segs[i].p1.x, linemap.segs[i].p1.y, 
+	       linemap.segs[i].p2.x, linemap.segs[i].p2.y);
+      errors++;
+    }
+  }
+  carmen_linemapping_free_segments(&linemap);
+
+  if(errors > 0){
+    printf("%d segments are not on a wall\n", errors);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,361 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/*************************************
+ * checks the compact map encodings, *
+ * their map file chunk and the      *
+ * compact ray casting and c-space   *
+ * paths against the float map       *
+ *************************************/
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "global.h"
+#include "map_io.h"
+#include "map_util.h"
+#include "geometry.h"
+#include "raycast.h"
+
+#define MAP_SIZE      1500
+#define NUM_RAYS      20000
+
+static double
+get_time(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/* Free cells stay below 0.1 and occupied ones above 0.9, so that every
+   encoding and every consumer agrees on which cells are free. */
+static void
+make_map(carmen_map_p map, int x_size, int y_size)
+{
+  int x, y;
+  double r;
+
+  map->config.x_size = x_size;
+  map->config.y_size = y_size;
+  map->config.resolution = 0.05;
+  map->config.map_name = "test";
+  map->complete_map = (float *)calloc(x_size*y_size, sizeof(float));
+  carmen_test_alloc(map->complete_map);
+  map->map = (float **)calloc(x_size, sizeof(float *));
+  carmen_test_alloc(map->map);
+
+  for (x = 0; x < x_size; x++) {
+    map->map[x] = map->complete_map+x*y_size;
+    for (y = 0; y < y_size; y++) {
+      r = carmen_uniform_random(0, 1);
+      if (x % 151 < 3 || y % 113 < 3 || r < 0.002)
+	map->map[x][y] = 0.9 + 0.1*carmen_uniform_random(0, 1);
+      else if (r < 0.05)
+	map->map[x][y] = -1;
+      else
+	map->map[x][y] = 0.08*carmen_uniform_random(0, 1);
+    }
+  }
+}
+
+static int
+check_encoding(carmen_map_p map, carmen_compact_map_p compact)
+{
+  int x, y, errors = 0;
+  float value, expected;
+  double tolerance;
+
+  tolerance = (compact->encoding == CARMEN_MAP_ENCODING_U8) ? 
+    0.5/CARMEN_MAP_U8_MAX + 1e-6 : 0;
+
+  for (x = 0; x < map->config.x_size; x++)
+    for (y = 0; y < map->config.y_size; y++) {
+      value = carmen_map_util_compact_map_get(compact, x, y);
+      expected = map->map[x][y];
+      if (compact->encoding == CARMEN_MAP_ENCODING_BITMAP && expected >= 0)
+	expected = (expected > compact->occupied_threshold) ? 1.0 : 0.0;
+      if ((expected < 0) != (value < 0) || 
+	  (expected >= 0 && fabs(value - expected) > tolerance)) {
+	if (errors++ < 5)
+	  carmen_warn("encoding %d cell (%d, %d): %f, expected %f\n",
+		      compact->encoding, x, y, value, expected);
+      }
+    }
+
+  return errors;
+}
+
+static int
+check_accessors(carmen_map_config_t config)
+{
+  carmen_compact_map_p compact;
+  int encoding, x, y, errors = 0;
+  float value;
+
+  for (encoding = CARMEN_MAP_ENCODING_U8; 
+       encoding <= CARMEN_MAP_ENCODING_BITMAP; encoding++) {
+    compact = carmen_map_util_new_compact_map(config, encoding, 0.5);
+    for (x = 0; x < 3; x++)
+      for (y = 0; y < 7; y++)
+	if (carmen_map_util_compact_map_get(compact, x, y) != -1)
+	  errors++;
+    carmen_map_util_compact_map_set(compact, 1, 5, 1.0);
+    carmen_map_util_compact_map_set(compact, 1, 6, 0.0);
+    carmen_map_util_compact_map_set(compact, 1, 4, -1);
+    value = carmen_map_util_compact_map_get(compact, 1, 5);
+    if (value != 1.0)
+      errors++;
+    if (carmen_map_util_compact_map_get(compact, 1, 6) != 0.0 ||
+	carmen_map_util_compact_map_get(compact, 1, 4) != -1 ||
+	carmen_map_util_compact_map_get(compact, 1, 7) != -1 ||
+	carmen_map_util_compact_map_get(compact, 0, 5) != -1 ||
+	carmen_map_util_compact_map_get(compact, 2, 5) != -1)
+      errors++;
+    carmen_map_util_free_compact_map(compact);
+  }
+  if (errors)
+    carmen_warn("compact map accessors failed\n");
+
+  return errors;
+}
+
+/* With pyramid levels, the file is laid out like one compacted by
+   maptool: the named gridmap chunks of the levels come before the
+   compact gridmap. Readers of the map must not take a level for it. */
+static int
+check_file(carmen_map_p map, carmen_compact_map_p compact, int pyramid)
+{
+  char filename[] = "/tmp/map_compact-testXXXXXX";
+  carmen_FILE *fp;
+  carmen_compact_map_p read_compact;
+  carmen_map_t read_map;
+  carmen_map_config_t config;
+  carmen_map_pyramid_p levels = NULL;
+  carmen_map_t level;
+  int fd, x, y, errors = 0;
+
+  fd = mkstemp(filename);
+  if (fd < 0)
+    carmen_die_syserror("Could not create %s", filename);
+  close(fd);
+
+  fp = carmen_fopen(filename, "w");
+  carmen_map_write_id(fp);
+  carmen_map_write_creator_chunk(fp, "map_compact-test", "compact");
+  if (pyramid) {
+    levels = carmen_map_util_build_pyramid(map, 3, CARMEN_MAP_REDUCE_MAX, 0);
+    carmen_map_write_pyramid_chunks(fp, "test", levels);
+  }
+  carmen_map_write_compact_gridmap_chunk(fp, compact);
+  carmen_fclose(fp);
+
+  if (carmen_map_read_compact_gridmap_chunk(filename, &read_compact) < 0)
+    carmen_die("Could not read the compact gridmap back\n");
+  if (read_compact->encoding != compact->encoding ||
+      read_compact->column_bytes != compact->column_bytes ||
+      memcmp(read_compact->data, compact->data, 
+	     compact->config.x_size*compact->column_bytes))
+    errors++;
+  carmen_map_util_free_compact_map(read_compact);
+
+  /* readers of plain gridmaps fall back to the compact chunk */
+  if (carmen_map_read_gridmap_config(filename, &config) < 0 ||
+      config.x_size != map->config.x_size || 
+      config.y_size != map->config.y_size)
+    errors++;
+  if (carmen_map_read_gridmap_chunk(filename, &read_map) < 0)
+    carmen_die("Could not read the compact gridmap as a gridmap\n");
+  if (read_map.config.x_size != map->config.x_size ||
+      read_map.config.y_size != map->config.y_size)
+    errors++;
+  else
+    for (x = 0; x < map->config.x_size; x++)
+      for (y = 0; y < map->config.y_size; y++)
+	if (read_map.map[x][y] != 
+	    carmen_map_util_compact_map_get(compact, x, y))
+	  errors++;
+  free(read_map.map);
+  free(read_map.complete_map);
+
+  if (pyramid) {
+    if (carmen_map_read_pyramid_level(filename, "test", 2, &level) < 0 ||
+	level.config.x_size != levels->level[2].config.x_size ||
+	memcmp(level.complete_map, levels->level[2].complete_map,
+	       level.config.x_size*level.config.y_size*sizeof(float)))
+      errors++;
+    else {
+      free(level.map);
+      free(level.complete_map);
+    }
+    carmen_map_util_free_pyramid(levels);
+  }
+
+  if (errors)
+    carmen_warn("encoding %d%s: map file round trip failed\n", 
+		compact->encoding, pyramid ? " with pyramid" : "");
+  unlink(filename);
+  return errors;
+}
+
+static int
+check_raycast(carmen_map_p map, carmen_compact_map_p u8, 
+	      carmen_compact_map_p bitmap)
+{
+  carmen_geometry_raycast_p raycast;
+  carmen_traj_point_t *poses;
+  double *theta, *expected, t, distance;
+  int i, errors = 0;
+
+  poses = (carmen_traj_point_t *)calloc(NUM_RAYS, sizeof(carmen_traj_point_t));
+  carmen_test_alloc(poses);
+  theta = (double *)calloc(NUM_RAYS, sizeof(double));
+  carmen_test_alloc(theta);
+  expected = (double *)calloc(NUM_RAYS, sizeof(double));
+  carmen_test_alloc(expected);
+  for (i = 0; i < NUM_RAYS; i++) {
+    poses[i].x = carmen_uniform_random(0, map->config.x_size) * 
+      map->config.resolution;
+    poses[i].y = carmen_uniform_random(0, map->config.y_size) * 
+      map->config.resolution;
+    theta[i] = carmen_uniform_random(-M_PI, M_PI);
+  }
+
+  raycast = carmen_geometry_raycast_new(0);
+
+  t = get_time();
+  carmen_geometry_raycast_set_map(raycast, map);
+  printf("clearance from float map:  %6.1f ms\n", (get_time() - t) * 1e3);
+  for (i = 0; i < NUM_RAYS; i++)
+    expected[i] = carmen_geometry_raycast_distance(raycast, poses+i, 
+						   theta[i], 0.0);
+
+  t = get_time();
+  carmen_geometry_raycast_set_compact_map(raycast, u8);
+  printf("clearance from u8 map:     %6.1f ms\n", (get_time() - t) * 1e3);
+  for (i = 0; i < NUM_RAYS; i++) {
+    distance = carmen_geometry_raycast_distance(raycast, poses+i, theta[i],
+						0.0);
+    if (distance != expected[i] && errors++ < 5)
+      carmen_warn("u8 ray %d: %f, expected %f\n", i, distance, expected[i]);
+  }
+
+  t = get_time();
+  carmen_geometry_raycast_set_compact_map(raycast, bitmap);
+  printf("clearance from bitmap map: %6.1f ms\n", (get_time() - t) * 1e3);
+  for (i = 0; i < NUM_RAYS; i++) {
+    distance = carmen_geometry_raycast_distance(raycast, poses+i, theta[i],
+						0.0);
+    if (distance != expected[i] && errors++ < 5)
+      carmen_warn("bitmap ray %d: %f, expected %f\n", i, distance, 
+		  expected[i]);
+  }
+
+  carmen_geometry_raycast_free(raycast);
+  free(poses);
+  free(theta);
+  free(expected);
+  return errors;
+}
+
+static int
+check_cspace(carmen_map_p map, carmen_compact_map_p compact, 
+	     carmen_robot_config_t *robot_conf)
+{
+  carmen_map_t cspace;
+  int errors;
+  double t;
+
+  t = get_time();
+  carmen_geometry_compact_map_to_cspace(compact, robot_conf, &cspace);
+  printf("c-space from encoding %d:   %6.1f ms\n", compact->encoding,
+	 (get_time() - t) * 1e3);
+
+  errors = memcmp(cspace.complete_map, map->complete_map, 
+		  map->config.x_size*map->config.y_size*sizeof(float)) != 0;
+  if (errors)
+    carmen_warn("encoding %d: c-space differs\n", compact->encoding);
+
+  free(cspace.map);
+  free(cspace.complete_map);
+  return errors;
+}
+
+int 
+main(int argc, char **argv)
+{
+  carmen_map_t map;
+  carmen_compact_map_p u8, bitmap;
+  carmen_robot_config_t robot_conf;
+  double t;
+  int errors = 0;
+
+  carmen_randomize(&argc, &argv);
+
+  /* odd sizes leave a partially used byte at the end of bitmap columns */
+  make_map(&map, MAP_SIZE+1, MAP_SIZE+3);
+
+  t = get_time();
+  u8 = carmen_map_util_compact_map(&map, CARMEN_MAP_ENCODING_U8, 0.0);
+  printf("u8 conversion:             %6.1f ms\n", (get_time() - t) * 1e3);
+  t = get_time();
+  bitmap = carmen_map_util_compact_map(&map, CARMEN_MAP_ENCODING_BITMAP, 
+				       CARMEN_GEOMETRY_RAYCAST_OCCUPIED);
+  printf("bitmap conversion:         %6.1f ms\n", (get_time() - t) * 1e3);
+  printf("cells take %d bytes as floats, %d as u8, %d as bitmap\n", 
+	 map.config.x_size*map.config.y_size*(int)sizeof(float),
+	 map.config.x_size*u8->column_bytes, 
+	 map.config.x_size*bitmap->column_bytes);
+
+  errors += check_encoding(&map, u8);
+  errors += check_encoding(&map, bitmap);
+  errors += check_accessors(map.config);
+  errors += check_file(&map, u8, 0);
+  errors += check_file(&map, bitmap, 0);
+  errors += check_file(&map, u8, 1);
+  errors += check_raycast(&map, u8, bitmap);
+
+  memset(&robot_conf, 0, sizeof(carmen_robot_config_t));
+  robot_conf.width = 0.5;
+  t = get_time();
+  carmen_geometry_map_to_cspace(&map, &robot_conf);
+  printf("c-space from float map:    %6.1f ms\n", (get_time() - t) * 1e3);
+  errors += check_cspace(&map, u8, &robot_conf);
+  errors += check_cspace(&map, bitmap, &robot_conf);
+
+  carmen_map_util_free_compact_map(u8);
+  carmen_map_util_free_compact_map(bitmap);
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
@@ -0,0 +1,266 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/*************************************
+ * checks the distance transform and *
+ * the c-space built on it against   *
+ * brute-force distances             *
+ *************************************/
+
+#include <float.h>
+#include <sys/time.h>
+
+#include "global.h"
+#include "map_util.h"
+#include "geometry.h"
+
+#define MAP_X_SIZE      301
+#define MAP_Y_SIZE      257
+#define LARGE_MAP_SIZE  2000
+
+static double
+get_time(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void
+alloc_map(carmen_map_p map, int x_size, int y_size)
+{
+  int x;
+
+  map->config.x_size = x_size;
+  map->config.y_size = y_size;
+  map->config.resolution = 0.05;
+  map->config.map_name = "test";
+  map->complete_map = (float *)calloc(x_size*y_size, sizeof(float));
+  carmen_test_alloc(map->complete_map);
+  map->map = (float **)calloc(x_size, sizeof(float *));
+  carmen_test_alloc(map->map);
+  for (x = 0; x < x_size; x++)
+    map->map[x] = map->complete_map+x*y_size;
+}
+
+static void
+free_map(carmen_map_p map)
+{
+  free(map->map);
+  free(map->complete_map);
+}
+
+/* Sparse random obstacles and unknown cells, plus a few walls. */
+static void
+make_map(carmen_map_p map, int x_size, int y_size)
+{
+  int x, y;
+  double r;
+
+  alloc_map(map, x_size, y_size);
+  for (x = 0; x < x_size; x++)
+    for (y = 0; y < y_size; y++) {
+      r = carmen_uniform_random(0, 1);
+      if ((x % 97 == 5 && y % 50 > 10) || r < 0.002)
+	map->map[x][y] = 0.5 + 0.5*carmen_uniform_random(0, 1);
+      else if (r < 0.004)
+	map->map[x][y] = -1;
+      else
+	map->map[x][y] = 0.09*carmen_uniform_random(0, 1);
+    }
+}
+
+static void
+brute_force_distance(carmen_map_p map, float free_threshold,
+		     carmen_map_p distance)
+{
+  int *obstacle_x, *obstacle_y, num_obstacles = 0;
+  int x, y, i;
+  double d, best;
+
+  obstacle_x = (int *)calloc(map->config.x_size*map->config.y_size,
+			     sizeof(int));
+  carmen_test_alloc(obstacle_x);
+  obstacle_y = (int *)calloc(map->config.x_size*map->config.y_size,
+			     sizeof(int));
+  carmen_test_alloc(obstacle_y);
+  for (x = 0; x < map->config.x_size; x++)
+    for (y = 0; y < map->config.y_size; y++)
+      if (!(map->map[x][y] >= 0 && map->map[x][y] < free_threshold)) {
+	obstacle_x[num_obstacles] = x;
+	obstacle_y[num_obstacles++] = y;
+      }
+
+  alloc_map(distance, map->config.x_size, map->config.y_size);
+  for (x = 0; x < map->config.x_size; x++)
+    for (y = 0; y < map->config.y_size; y++) {
+      best = DBL_MAX;
+      for (i = 0; i < num_obstacles; i++) {
+	d = carmen_square(x-obstacle_x[i])+carmen_square(y-obstacle_y[i]);
+	if (d < best)
+	  best = d;
+      }
+      distance->map[x][y] = sqrt(best)*map->config.resolution;
+    }
+
+  free(obstacle_x);
+  free(obstacle_y);
+}
+
+static int
+compare(char *name, carmen_map_p distance, carmen_map_p expected,
+	int x_start, int y_start, int x_end, int y_end, double max_distance)
+{
+  int x, y, errors = 0;
+  double value;
+
+  for (x = x_start; x < x_end; x++)
+    for (y = y_start; y < y_end; y++) {
+      value = expected->map[x][y];
+      if (max_distance > 0 && value > max_distance)
+	value = max_distance;
+      if (fabs(distance->map[x][y] - value) > 1e-4) {
+	if (errors++ < 5)
+	  carmen_warn("%s cell (%d, %d): %f, expected %f\n", name, x, y,
+		      distance->map[x][y], value);
+      }
+    }
+
+  return errors;
+}
+
+static int
+check_cspace(carmen_map_p map, carmen_map_p expected,
+	     carmen_robot_config_t *robot_conf)
+{
+  carmen_map_t cspace;
+  double inscribed, circumscribed;
+  int x, y, errors = 0;
+  float value;
+
+  alloc_map(&cspace, map->config.x_size, map->config.y_size);
+  memcpy(cspace.complete_map, map->complete_map,
+	 map->config.x_size*map->config.y_size*sizeof(float));
+  carmen_geometry_map_to_cspace(&cspace, robot_conf);
+
+  carmen_map_util_footprint_radii(robot_conf, map->config.resolution,
+				  &inscribed, &circumscribed);
+  for (x = 0; x < map->config.x_size; x++)
+    for (y = 0; y < map->config.y_size; y++) {
+      value = expected->map[x][y] <= inscribed ? 1.0 : 0.0;
+      if (cspace.map[x][y] != value && errors++ < 5)
+	carmen_warn("c-space %s cell (%d, %d): %f, expected %f\n",
+		    robot_conf->rectangular ? "rectangular" : "circular",
+		    x, y, cspace.map[x][y], value);
+    }
+
+  free_map(&cspace);
+  return errors;
+}
+
+int
+main(int argc, char **argv)
+{
+  carmen_map_t map, distance, expected;
+  carmen_robot_config_t robot_conf;
+  int x, y, errors = 0;
+  double t;
+
+  carmen_randomize(&argc, &argv);
+
+  make_map(&map, MAP_X_SIZE, MAP_Y_SIZE);
+  brute_force_distance(&map, 0.1, &expected);
+
+  alloc_map(&distance, MAP_X_SIZE, MAP_Y_SIZE);
+  carmen_map_util_distance_transform(&map, 0.1, &distance);
+  errors += compare("full", &distance, &expected, 0, 0,
+		    MAP_X_SIZE, MAP_Y_SIZE, 0);
+
+  /* only the region changes, and only up to max_distance */
+  for (x = 0; x < MAP_X_SIZE*MAP_Y_SIZE; x++)
+    distance.complete_map[x] = -2;
+  carmen_map_util_distance_transform_region(&map, 0.1, &distance,
+					    40, 70, 180, 150, 0.4);
+  errors += compare("region", &distance, &expected, 40, 70, 180, 150, 0.4);
+  for (x = 0; x < MAP_X_SIZE; x++)
+    for (y = 0; y < MAP_Y_SIZE; y++)
+      if ((x < 40 || x >= 180 || y < 70 || y >= 150) &&
+	  distance.map[x][y] != -2 && errors++ < 5)
+	carmen_warn("region wrote cell (%d, %d)\n", x, y);
+
+  /* in place */
+  memcpy(distance.complete_map, map.complete_map,
+	 MAP_X_SIZE*MAP_Y_SIZE*sizeof(float));
+  carmen_map_util_distance_transform(&distance, 0.1, &distance);
+  errors += compare("in place", &distance, &expected, 0, 0,
+		    MAP_X_SIZE, MAP_Y_SIZE, 0);
+
+  memset(&robot_conf, 0, sizeof(carmen_robot_config_t));
+  robot_conf.width = 0.5;
+  robot_conf.length = 0.7;
+  errors += check_cspace(&map, &expected, &robot_conf);
+  robot_conf.rectangular = 1;
+  robot_conf.width = 0.8;
+  robot_conf.length = 0.4;
+  errors += check_cspace(&map, &expected, &robot_conf);
+
+  /* without obstacles, everything is further than the map diagonal */
+  for (x = 0; x < MAP_X_SIZE*MAP_Y_SIZE; x++)
+    distance.complete_map[x] = 0.0;
+  carmen_map_util_distance_transform(&distance, 0.1, &distance);
+  for (x = 0; x < MAP_X_SIZE*MAP_Y_SIZE; x++)
+    if (distance.complete_map[x] <= hypot(MAP_X_SIZE, MAP_Y_SIZE)*0.05 &&
+	errors++ < 5)
+      carmen_warn("empty map cell %d: %f\n", x, distance.complete_map[x]);
+
+  free_map(&distance);
+  free_map(&expected);
+  free_map(&map);
+
+  make_map(&map, LARGE_MAP_SIZE, LARGE_MAP_SIZE);
+  alloc_map(&distance, LARGE_MAP_SIZE, LARGE_MAP_SIZE);
+  t = get_time();
+  carmen_map_util_distance_transform(&map, 0.1, &distance);
+  printf("%dx%d distance transform: %6.1f ms\n", LARGE_MAP_SIZE,
+	 LARGE_MAP_SIZE, (get_time() - t) * 1e3);
+  robot_conf.rectangular = 0;
+  t = get_time();
+  carmen_geometry_map_to_cspace(&map, &robot_conf);
+  printf("%dx%d c-space:            %6.1f ms\n", LARGE_MAP_SIZE,
+	 LARGE_MAP_SIZE, (get_time() - t) * 1e3);
+  free_map(&distance);
+  free_map(&map);
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
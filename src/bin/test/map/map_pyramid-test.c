@@ -0,0 +1,307 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/*************************************
+ * checks map pyramid levels and the *
+ * resolution change against direct  *
+ * per-cell evaluation, and times    *
+ * both on a synthetic map           *
+ *************************************/
+
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "global.h"
+#include "map_io.h"
+#include "map_util.h"
+
+#define MAP_SIZE      2000
+#define NUM_LEVELS    6
+
+static double
+get_time(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void
+make_map(carmen_map_p map, int x_size, int y_size)
+{
+  int x, y;
+  double r;
+
+  map->config.x_size = x_size;
+  map->config.y_size = y_size;
+  map->config.resolution = 0.1;
+  map->config.map_name = "test";
+  map->complete_map = (float *)calloc(x_size*y_size, sizeof(float));
+  carmen_test_alloc(map->complete_map);
+  map->map = (float **)calloc(x_size, sizeof(float *));
+  carmen_test_alloc(map->map);
+
+  for (x = 0; x < x_size; x++) {
+    map->map[x] = map->complete_map+x*y_size;
+    for (y = 0; y < y_size; y++) {
+      r = carmen_uniform_random(0, 1);
+      if (x % 97 < 3 || y % 131 < 2)
+	map->map[x][y] = 0.9 + 0.1*r;
+      else if (r < 0.1)
+	map->map[x][y] = -1;
+      else
+	map->map[x][y] = 0.2*r;
+    }
+  }
+}
+
+static float
+cubic_bspline(float x)
+{
+  float r = 0;
+
+  if (x + 2 > 0) r += pow(x + 2, 3);
+  if (x + 1 > 0) r -= 4*pow(x + 1, 3);
+  if (x > 0) r += 6*pow(x, 3);
+  if (x - 1 > 0) r -= 4*pow(x - 1, 3);
+  return r / 6.0;
+}
+
+/* one 4x4 kernel evaluation per output cell */
+static void
+change_resolution_direct(carmen_map_p map, carmen_map_p new_map, 
+			 double new_resolution)
+{
+  float scale = map->config.resolution / new_resolution;
+  float f_x, f_y, a, b, value;
+  int x, y, m, n, i_x, i_y, sx, sy;
+
+  for (x = 0; x < new_map->config.x_size; x++) {
+    f_x = x / scale;
+    i_x = carmen_trunc(f_x);
+    b = f_x - i_x;
+    for (y = 0; y < new_map->config.y_size; y++) {
+      f_y = y / scale;
+      i_y = carmen_trunc(f_y);
+      a = f_y - i_y;
+      value = 0;
+      for (m = -1; m < 3; m++)
+	for (n = -1; n < 3; n++) {
+	  sx = carmen_clamp(0, i_x+n, map->config.x_size-1);
+	  sy = carmen_clamp(0, i_y+m, map->config.y_size-1);
+	  value += map->map[sx][sy] * cubic_bspline(m - a) * 
+	    cubic_bspline(n - b);
+	}
+      if (value < 0)
+	value = -1;
+      if (value > 1.0)
+	value = 1.0;
+      new_map->map[x][y] = value;
+    }
+  }
+}
+
+static float
+reduce_block(carmen_map_p map, int x0, int y0, int block, 
+	     carmen_map_reducer_t reducer)
+{
+  double sum = 0, result = 0;
+  int x, y, n = 0;
+  float v;
+
+  for (x = x0; x < x0+block && x < map->config.x_size; x++)
+    for (y = y0; y < y0+block && y < map->config.y_size; y++) {
+      v = map->map[x][y];
+      if (v < 0)
+	continue;
+      if (n == 0 || (reducer == CARMEN_MAP_REDUCE_MIN && v < result) ||
+	  (reducer == CARMEN_MAP_REDUCE_MAX && v > result))
+	result = v;
+      sum += v;
+      n++;
+    }
+
+  if (n == 0)
+    return -1;
+  return (reducer == CARMEN_MAP_REDUCE_MEAN) ? sum / n : result;
+}
+
+static int
+check_pyramid(carmen_map_p map, carmen_map_pyramid_p pyramid)
+{
+  carmen_map_p level;
+  int i, x, y, block, errors = 0;
+  double tolerance;
+  float expected;
+
+  for (i = 1; i < pyramid->num_levels; i++) {
+    level = &pyramid->level[i];
+    block = 1 << i;
+    /* the mean is taken over means of sub-blocks, which only equals
+       the flat mean when all sub-blocks have the same number of known
+       cells, so it is only checked on the first level */
+    if (pyramid->reducer == CARMEN_MAP_REDUCE_MEAN && i > 1)
+      break;
+    tolerance = (pyramid->reducer == CARMEN_MAP_REDUCE_MEAN) ? 1e-5 : 0;
+    for (x = 0; x < level->config.x_size; x++)
+      for (y = 0; y < level->config.y_size; y++) {
+	expected = reduce_block(map, x*block, y*block, block, 
+				pyramid->reducer);
+	if (fabs(level->map[x][y] - expected) > tolerance && errors++ < 5)
+	  carmen_warn("level %d cell (%d, %d): %f, expected %f\n", i, x, y,
+		      level->map[x][y], expected);
+      }
+  }
+
+  return errors;
+}
+
+static int
+check_file_roundtrip(carmen_map_pyramid_p pyramid)
+{
+  char filename[] = "/tmp/map_pyramid-testXXXXXX";
+  carmen_FILE *fp;
+  carmen_map_t level;
+  int fd, i, errors = 0;
+
+  fd = mkstemp(filename);
+  if (fd < 0)
+    carmen_die_syserror("Could not create %s", filename);
+  close(fd);
+
+  fp = carmen_fopen(filename, "w");
+  carmen_map_write_id(fp);
+  carmen_map_write_creator_chunk(fp, "map_pyramid-test", "pyramid");
+  carmen_map_write_gridmap_chunk(fp, pyramid->level[0].map, 
+				 pyramid->level[0].config.x_size, 
+				 pyramid->level[0].config.y_size,
+				 pyramid->level[0].config.resolution);
+  carmen_map_write_pyramid_chunks(fp, "pyramid-max", pyramid);
+  carmen_fclose(fp);
+
+  for (i = 1; i < pyramid->num_levels; i++) {
+    if (carmen_map_read_pyramid_level(filename, "pyramid-max", i, 
+				      &level) < 0) {
+      errors++;
+      continue;
+    }
+    if (level.config.x_size != pyramid->level[i].config.x_size ||
+	level.config.y_size != pyramid->level[i].config.y_size ||
+	fabs(level.config.resolution - 
+	     pyramid->level[i].config.resolution) > 1e-6 ||
+	memcmp(level.complete_map, pyramid->level[i].complete_map,
+	       level.config.x_size*level.config.y_size*sizeof(float))) {
+      carmen_warn("level %d differs after reading it back\n", i);
+      errors++;
+    }
+    free(level.map);
+    free(level.complete_map);
+  }
+  if (carmen_map_read_pyramid_level(filename, "pyramid-max", 
+				    pyramid->num_levels, &level) == 0)
+    errors++;
+
+  unlink(filename);
+  return errors;
+}
+
+int 
+main(int argc, char **argv)
+{
+  carmen_map_t map, direct;
+  carmen_map_pyramid_p pyramid;
+  carmen_map_reducer_t reducer;
+  char *reducer_name[] = {"mean", "min", "max"};
+  double t, max_error = 0;
+  int x, y, errors = 0;
+
+  carmen_randomize(&argc, &argv);
+
+  /* odd sizes exercise the partial blocks at the far borders */
+  make_map(&map, 397, 251);
+  for (reducer = CARMEN_MAP_REDUCE_MEAN; reducer <= CARMEN_MAP_REDUCE_MAX; 
+       reducer++) {
+    pyramid = carmen_map_util_build_pyramid(&map, NUM_LEVELS, reducer, 0);
+    errors += check_pyramid(&map, pyramid);
+    if (reducer == CARMEN_MAP_REDUCE_MAX)
+      errors += check_file_roundtrip(pyramid);
+    carmen_map_util_free_pyramid(pyramid);
+  }
+  free(map.map);
+  free(map.complete_map);
+
+  make_map(&map, MAP_SIZE, MAP_SIZE);
+  for (reducer = CARMEN_MAP_REDUCE_MEAN; reducer <= CARMEN_MAP_REDUCE_MAX; 
+       reducer++) {
+    t = get_time();
+    pyramid = carmen_map_util_build_pyramid(&map, NUM_LEVELS, reducer, 0);
+    printf("%d-level %s pyramid of %d x %d map: %.1f ms\n", NUM_LEVELS, 
+	   reducer_name[reducer], MAP_SIZE, MAP_SIZE, 
+	   (get_time() - t) * 1e3);
+    carmen_map_util_free_pyramid(pyramid);
+  }
+
+  direct.config = map.config;
+  direct.config.x_size = MAP_SIZE*map.config.resolution/0.25;
+  direct.config.y_size = MAP_SIZE*map.config.resolution/0.25;
+  direct.config.resolution = 0.25;
+  direct.complete_map = (float *)
+    calloc(direct.config.x_size*direct.config.y_size, sizeof(float));
+  carmen_test_alloc(direct.complete_map);
+  direct.map = (float **)calloc(direct.config.x_size, sizeof(float *));
+  carmen_test_alloc(direct.map);
+  for (x = 0; x < direct.config.x_size; x++)
+    direct.map[x] = direct.complete_map+x*direct.config.y_size;
+
+  t = get_time();
+  change_resolution_direct(&map, &direct, 0.25);
+  printf("per-cell resample to 0.25 m: %.1f ms\n", (get_time() - t) * 1e3);
+
+  t = get_time();
+  carmen_map_util_change_resolution(&map, 0.25);
+  printf("separable resample to 0.25 m: %.1f ms\n", (get_time() - t) * 1e3);
+
+  if (map.config.x_size != direct.config.x_size ||
+      map.config.y_size != direct.config.y_size)
+    carmen_die("resampled map has the wrong size\n");
+  for (x = 0; x < map.config.x_size; x++)
+    for (y = 0; y < map.config.y_size; y++)
+      max_error = carmen_fmax(max_error, 
+			      fabs(map.map[x][y] - direct.map[x][y]));
+  printf("largest resampling difference: %g\n", max_error);
+  if (max_error > 1e-4)
+    errors++;
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
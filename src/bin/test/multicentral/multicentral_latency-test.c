@@ -0,0 +1,166 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include <sys/wait.h>
+
+#include "global.h"
+#include "multicentral.h"
+
+/* Measures how long a message waits between being published on one of
+   several centrals and being handled by carmen_multicentral_ipc_sleep().
+   Run it with the same -central list as any multicentral program, e.g. 
+   with a file listing localhost:1381 and localhost:1382 and a central 
+   started with -p1381 and another with -p1382. One publisher per central
+   is started as a child process. */
+
+#define NUM_PINGS     200
+#define PING_PERIOD   0.023
+#define SLEEP_TIME    0.1
+
+#define PING_NAME     "carmen_multicentral_test_ping"
+#define PING_FMT      "{double,int}"
+
+typedef struct {
+  double timestamp;
+  int sequence;
+} ping_message;
+
+static double *latency = NULL;
+static int num_latencies = 0, max_latencies = 0;
+
+static void
+ping_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
+	     void *clientData __attribute__ ((unused)))
+{
+  ping_message ping;
+  double now = carmen_get_wall_time();
+
+  IPC_unmarshallData(IPC_msgInstanceFormatter(msgRef), callData, &ping,
+		     sizeof(ping_message));
+  IPC_freeByteArray(callData);
+
+  if (num_latencies < max_latencies)
+    latency[num_latencies++] = now - ping.timestamp;
+}
+
+static void
+subscribe_messages(void)
+{
+  IPC_defineMsg(PING_NAME, IPC_VARIABLE_LENGTH, PING_FMT);
+  IPC_subscribe(PING_NAME, ping_handler, NULL);
+  IPC_setMsgQueueLength(PING_NAME, NUM_PINGS);
+}
+
+static void
+publish_pings(char *module_name, char *host)
+{
+  ping_message ping;
+  int i;
+
+  if (IPC_connectModule(module_name, host) != IPC_OK)
+    carmen_die("Could not connect to central %s\n", host);
+  IPC_defineMsg(PING_NAME, IPC_VARIABLE_LENGTH, PING_FMT);
+
+  /* give the subscriber time to settle */
+  usleep(500000);
+  for (i = 0; i < NUM_PINGS; i++) {
+    /* stagger the pings so they arrive at random points of the sleep */
+    usleep((int)(carmen_uniform_random(0.5, 1.5) * PING_PERIOD * 1e6));
+    ping.timestamp = carmen_get_wall_time();
+    ping.sequence = i;
+    IPC_publishData(PING_NAME, &ping);
+  }
+  IPC_disconnect();
+}
+
+static int
+compare_latencies(const void *a, const void *b)
+{
+  double difference = *(double *)a - *(double *)b;
+
+  return (difference > 0) - (difference < 0);
+}
+
+int
+main(int argc, char **argv)
+{
+  carmen_centrallist_p centrallist;
+  double mean = 0, end_time;
+  int i, num_connected = 0;
+
+  if (argc == 3 && strcmp(argv[1], "-publish") == 0) {
+    carmen_randomize(&argc, &argv);
+    publish_pings(carmen_new_string("ping-%d", getpid()), argv[2]);
+    return 0;
+  }
+
+  centrallist = carmen_multicentral_initialize(argc, argv, NULL);
+  carmen_multicentral_subscribe_messages(centrallist, subscribe_messages);
+
+  for (i = 0; i < centrallist->num_centrals; i++)
+    if (centrallist->central[i].connected) {
+      num_connected++;
+      if (fork() == 0) {
+	execl(argv[0], argv[0], "-publish", centrallist->central[i].host, 
+	      (char *)NULL);
+	carmen_die("Could not start publisher: %s\n", strerror(errno));
+      }
+    }
+
+  max_latencies = num_connected * NUM_PINGS;
+  latency = (double *)calloc(max_latencies, sizeof(double));
+  carmen_test_alloc(latency);
+
+  end_time = carmen_get_wall_time() + 2.0 + 2 * NUM_PINGS * PING_PERIOD;
+  while (num_latencies < max_latencies && carmen_get_wall_time() < end_time)
+    carmen_multicentral_ipc_sleep(centrallist, SLEEP_TIME);
+  while (wait(NULL) > 0);
+
+  if (num_latencies == 0)
+    carmen_die("No pings received\n");
+
+  qsort(latency, num_latencies, sizeof(double), compare_latencies);
+  for (i = 0; i < num_latencies; i++)
+    mean += latency[i] / num_latencies;
+
+  printf("%d centrals, %d of %d pings received\n", num_connected, 
+	 num_latencies, max_latencies);
+  printf("latency: mean %.3f ms, median %.3f ms, 99%% %.3f ms, "
+	 "max %.3f ms\n", 1000 * mean, 1000 * latency[num_latencies / 2],
+	 1000 * latency[(int)(0.99 * (num_latencies - 1))], 
+	 1000 * latency[num_latencies - 1]);
+
+  /* polling the centrals in turn made pings wait for a good part of the
+     sleep time */
+  if (num_latencies < max_latencies || 
+      latency[num_latencies / 2] > SLEEP_TIME / 10) {
+    printf("FAILED\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,198 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/*************************************
+ * plans routes over a small         *
+ * synthetic hmap: a lobby with a    *
+ * door to an office, an elevator to *
+ * a second floor, and an isolated   *
+ * closet                            *
+ *************************************/
+
+#include "global.h"
+#include "hmap_planner.h"
+
+#define LOBBY    0
+#define OFFICE   1
+#define FLOOR2   2
+#define CLOSET   3
+
+#define MAP_X_SIZE   200
+#define MAP_Y_SIZE   100
+
+static char *zone_names[] = {"lobby", "office", "floor2", "closet"};
+static int num_loads[4];
+
+/* 20 m x 10 m of free space inside a wall. */
+static carmen_map_p
+load_zone(char *zone_name, void *data __attribute__ ((unused)))
+{
+  carmen_map_p map;
+  int x, y, zone;
+
+  for (zone = 0; zone < 4; zone++)
+    if (!strcmp(zone_names[zone], zone_name))
+      break;
+  num_loads[zone]++;
+
+  map = (carmen_map_p)calloc(1, sizeof(carmen_map_t));
+  carmen_test_alloc(map);
+  map->config.x_size = MAP_X_SIZE;
+  map->config.y_size = MAP_Y_SIZE;
+  map->config.resolution = 0.1;
+  map->config.map_name = zone_name;
+  map->complete_map = (float *)calloc(MAP_X_SIZE*MAP_Y_SIZE, sizeof(float));
+  carmen_test_alloc(map->complete_map);
+  map->map = (float **)calloc(MAP_X_SIZE, sizeof(float *));
+  carmen_test_alloc(map->map);
+  for (x = 0; x < MAP_X_SIZE; x++) {
+    map->map[x] = map->complete_map+x*MAP_Y_SIZE;
+    for (y = 0; y < MAP_Y_SIZE; y++)
+      if (x == 0 || y == 0 || x == MAP_X_SIZE-1 || y == MAP_Y_SIZE-1)
+	map->map[x][y] = 1.0;
+  }
+
+  return map;
+}
+
+static void
+make_hmap(carmen_hmap_p hmap)
+{
+  static int door_keys[2] = {LOBBY, OFFICE};
+  static int elevator_keys[2] = {LOBBY, FLOOR2};
+  static carmen_point_t door_points[4] = {{18, 4, 0}, {18, 6, 0},
+					  {2, 4, 0}, {2, 6, 0}};
+  static carmen_point_t elevator_points[2] = {{3, 5, 0}, {3, 5, 0}};
+  static carmen_hmap_link_t links[2];
+
+  links[0].type = CARMEN_HMAP_LINK_DOOR;
+  links[0].degree = 2;
+  links[0].keys = door_keys;
+  links[0].num_points = 4;
+  links[0].points = door_points;
+  links[1].type = CARMEN_HMAP_LINK_ELEVATOR;
+  links[1].degree = 2;
+  links[1].keys = elevator_keys;
+  links[1].num_points = 2;
+  links[1].points = elevator_points;
+
+  hmap->num_zones = 4;
+  hmap->zone_names = zone_names;
+  hmap->num_links = 2;
+  hmap->links = links;
+}
+
+static int
+check(int condition, char *what)
+{
+  if (!condition)
+    carmen_warn("FAILED: %s\n", what);
+  return condition ? 0 : 1;
+}
+
+int
+main(void)
+{
+  carmen_hmap_t hmap;
+  carmen_robot_config_t robot_conf;
+  carmen_hmap_planner_p planner;
+  carmen_hmap_route_t route;
+  carmen_map_config_t config;
+  carmen_point_t start = {10, 5, 0}, goal = {10, 5, M_PI/2};
+  double *costs;
+  int zone, errors = 0;
+
+  make_hmap(&hmap);
+  memset(&robot_conf, 0, sizeof(carmen_robot_config_t));
+  robot_conf.width = 0.5;
+  robot_conf.length = 0.5;
+  planner = carmen_hmap_planner_new(&hmap, &robot_conf, load_zone, NULL);
+
+  /* nothing is built yet, so the first route may be estimated */
+  errors += check(carmen_hmap_planner_plan(planner, LOBBY, &start, OFFICE,
+					   &goal, &route) == 0,
+		  "route to the office");
+  errors += check(route.num_legs == 2 && route.legs[0].zone == LOBBY &&
+		  route.legs[0].link == 0 && route.legs[1].zone == OFFICE &&
+		  route.legs[1].link == -1, "legs through the door");
+  carmen_hmap_planner_free_route(&route);
+
+  for (zone = LOBBY; zone <= OFFICE; zone++)
+    errors += check(carmen_hmap_planner_wait_zone(planner, zone) == 0,
+		    "zone ready");
+
+  errors += check(carmen_hmap_planner_plan(planner, LOBBY, &start, OFFICE,
+					   &goal, &route) == 0,
+		  "route to the office");
+  errors += check(!route.estimated, "exact route");
+  errors += check(fabs(route.cost - 16.0) < 1e-6,
+		  "route cost is the free path length");
+  errors += check(fabs(route.legs[0].goal.x - 18.0 -
+		       CARMEN_HMAP_PLANNER_DOOR_OVERSHOOT) < 1e-6 &&
+		  fabs(route.legs[0].goal.y - 5.0) < 1e-6,
+		  "first leg ends past the door");
+  errors += check(route.legs[1].start.x == 2.0 &&
+		  route.legs[1].goal.theta == goal.theta,
+		  "second leg ends at the goal");
+  carmen_hmap_planner_free_route(&route);
+
+  errors += check(carmen_hmap_planner_plan(planner, LOBBY, &start, FLOOR2,
+					   &goal, &route) == 0,
+		  "route upstairs");
+  errors += check(route.num_legs == 2 && route.legs[0].link == 1 &&
+		  route.legs[1].zone == FLOOR2, "legs through the elevator");
+  errors += check(route.cost >= CARMEN_HMAP_PLANNER_ELEVATOR_COST,
+		  "elevator ride is paid for");
+  carmen_hmap_planner_free_route(&route);
+
+  errors += check(carmen_hmap_planner_plan(planner, LOBBY, &start, LOBBY,
+					   &goal, &route) == 0 &&
+		  route.num_legs == 1 && route.cost < 1e-6,
+		  "route within a zone");
+  carmen_hmap_planner_free_route(&route);
+
+  errors += check(carmen_hmap_planner_plan(planner, LOBBY, &start, CLOSET,
+					   &goal, &route) < 0,
+		  "no route to the closet");
+
+  costs = carmen_hmap_planner_zone_costs(planner, LOBBY, &config);
+  errors += check(costs != NULL && config.x_size == MAP_X_SIZE &&
+		  costs[0] >= 1.0 && costs[50*MAP_Y_SIZE+50] < 0.5,
+		  "zone costs");
+  errors += check(num_loads[LOBBY] == 1 && num_loads[OFFICE] == 1,
+		  "zones are loaded once");
+
+  carmen_hmap_planner_free(planner);
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
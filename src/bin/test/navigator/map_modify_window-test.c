@@ -0,0 +1,334 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+
+/*************************************
+ * drives a laser through a room     *
+ * with people walking by and checks *
+ * that the planner map only keeps   *
+ * the last scans, that the changed  *
+ * cells are in the dirty regions    *
+ * and that costs rebuilt from them  *
+ * match costs built from scratch    *
+ *************************************/
+
+#include "global.h"
+#include "map_modify.h"
+#include "conventional.h"
+#include "planner.h"
+#include "map_interface.h"
+
+#define MAP_SIZE         400
+#define RESOLUTION       0.05
+#define NUM_BEAMS        361
+#define MAX_RANGE        8.0
+#define NUM_SCANS        500
+#define NUM_PEOPLE       4
+/* LASER_HISTORY_LENGTH of map_modify.c */
+#define WINDOW           5
+
+static carmen_map_p
+new_map(void)
+{
+  carmen_map_p map;
+  int x;
+
+  map = (carmen_map_p)calloc(1, sizeof(carmen_map_t));
+  carmen_test_alloc(map);
+  map->config.x_size = MAP_SIZE;
+  map->config.y_size = MAP_SIZE;
+  map->config.resolution = RESOLUTION;
+  map->complete_map = (float *)calloc(MAP_SIZE*MAP_SIZE, sizeof(float));
+  carmen_test_alloc(map->complete_map);
+  map->map = (float **)calloc(MAP_SIZE, sizeof(float *));
+  carmen_test_alloc(map->map);
+  for (x = 0; x < MAP_SIZE; x++)
+    map->map[x] = map->complete_map+x*MAP_SIZE;
+
+  return map;
+}
+
+/* a room with a wall and a few boxes, the rest is free */
+static carmen_map_p
+make_room(void)
+{
+  carmen_map_p map = new_map();
+  int x, y, box;
+
+  for (x = 0; x < MAP_SIZE; x++)
+    for (y = 0; y < MAP_SIZE; y++) {
+      if (x < 2 || y < 2 || x >= MAP_SIZE-2 || y >= MAP_SIZE-2 ||
+	  (x == MAP_SIZE/2 && y < MAP_SIZE/2))
+	map->map[x][y] = 1.0;
+      for (box = 0; box < 5; box++)
+	if (abs(x-60-box*70) < 6 && abs(y-300+box*20) < 6)
+	  map->map[x][y] = 1.0;
+    }
+
+  return map;
+}
+
+static void
+copy_map(carmen_map_p dest, carmen_map_p src)
+{
+  memcpy(dest->complete_map, src->complete_map, 
+	 MAP_SIZE*MAP_SIZE*sizeof(float));
+}
+
+/* Ranges from pose in the room at the time of a scan, with people
+   walking by. */
+static void
+make_scan(carmen_map_p room, int scan, carmen_point_t *pose, float *range)
+{
+  double angle, r, wx, wy, px[NUM_PEOPLE], py[NUM_PEOPLE];
+  int i, x, y, person, hit;
+
+  for (person = 0; person < NUM_PEOPLE; person++) {
+    px[person] = 2.0+fmod(scan*0.04*(person+1)+person*5.0, 16.0);
+    py[person] = 3.0+person*2.5;
+  }
+
+  for (i = 0; i < NUM_BEAMS; i++) {
+    angle = pose->theta-M_PI/2+i*M_PI/(NUM_BEAMS-1);
+    for (r = 0, hit = 0; r < MAX_RANGE && !hit; r += RESOLUTION/2) {
+      wx = pose->x+r*cos(angle);
+      wy = pose->y+r*sin(angle);
+      x = carmen_round(wx/RESOLUTION);
+      y = carmen_round(wy/RESOLUTION);
+      if (x < 0 || y < 0 || x >= MAP_SIZE || y >= MAP_SIZE ||
+	  room->map[x][y] >= 0.9)
+	break;
+      for (person = 0; person < NUM_PEOPLE; person++)
+	if ((wx-px[person])*(wx-px[person])+(wy-py[person])*(wy-py[person]) <
+	    0.25*0.25)
+	  hit = 1;
+    }
+    range[i] = r < MAX_RANGE ? r : MAX_RANGE;
+  }
+}
+
+static void
+init_laser(carmen_robot_laser_message *laser, float *range)
+{
+  memset(laser, 0, sizeof(carmen_robot_laser_message));
+  laser->config.start_angle = -M_PI/2;
+  laser->config.fov = M_PI;
+  laser->config.angular_resolution = M_PI/(NUM_BEAMS-1);
+  laser->config.maximum_range = MAX_RANGE;
+  laser->num_readings = NUM_BEAMS;
+  laser->range = range;
+}
+
+/* along the free half of the room and back */
+static void
+robot_pose(int scan, carmen_point_t *pose)
+{
+  double s = (scan % 200)/200.0;
+
+  pose->x = 5.0+10.0*(s < 0.5 ? 2*s : 2-2*s);
+  pose->y = 4.0+6.0*s;
+  pose->theta = carmen_normalize_theta(scan*0.05);
+}
+
+static int
+check(int condition, char *what)
+{
+  if (!condition)
+    carmen_warn("FAILED: %s\n", what);
+  return condition ? 0 : 1;
+}
+
+static int
+num_differences(carmen_map_p map, carmen_map_p other)
+{
+  int index, count = 0;
+
+  for (index = 0; index < MAP_SIZE*MAP_SIZE; index++)
+    if (map->complete_map[index] != other->complete_map[index])
+      count++;
+  return count;
+}
+
+/* Every changed cell is in exactly one dirty region, and no region
+   reaches outside the map. */
+static int
+check_dirty(carmen_map_p before, carmen_map_p after, unsigned char *covered)
+{
+  int num_rects, *rects, *rect;
+  int index, x, y, errors = 0;
+
+  memset(covered, 0, MAP_SIZE*MAP_SIZE);
+  rects = map_modify_get_dirty(&num_rects);
+  for (index = 0; index < num_rects; index++) {
+    rect = rects+4*index;
+    if (rect[0] < 0 || rect[1] < 0 || rect[2] > MAP_SIZE || 
+	rect[3] > MAP_SIZE || rect[0] >= rect[2] || rect[1] >= rect[3])
+      errors++;
+    else
+      for (x = rect[0]; x < rect[2]; x++)
+	for (y = rect[1]; y < rect[3]; y++)
+	  if (covered[x*MAP_SIZE+y]++)
+	    errors++;
+  }
+
+  for (index = 0; index < MAP_SIZE*MAP_SIZE; index++)
+    if (before->complete_map[index] != after->complete_map[index] &&
+	!covered[index])
+      errors++;
+
+  return errors;
+}
+
+int
+main(void)
+{
+  carmen_map_p room, true_map, modify_map, before, snapshot, planner_map;
+  carmen_navigator_config_t nav_conf;
+  carmen_robot_config_t robot_conf;
+  carmen_robot_laser_message laser;
+  carmen_world_point_t world_point;
+  carmen_map_point_t map_point;
+  float ranges[NUM_SCANS][NUM_BEAMS];
+  unsigned char *covered;
+  double *costs, start, update_time = 0, cost_time = 0;
+  int scan, index, dirty_errors = 0, num_changed = 0, num_kept, errors = 0;
+
+  memset(&nav_conf, 0, sizeof(carmen_navigator_config_t));
+  nav_conf.num_lasers_to_use = NUM_BEAMS;
+  nav_conf.map_update_radius = 4.0;
+  nav_conf.map_update_obstacles = 1;
+  nav_conf.map_update_freespace = 1;
+  memset(&robot_conf, 0, sizeof(carmen_robot_config_t));
+  robot_conf.width = 0.5;
+  robot_conf.length = 0.5;
+
+  room = make_room();
+  true_map = make_room();
+  modify_map = make_room();
+  before = new_map();
+  snapshot = new_map();
+  covered = (unsigned char *)calloc(MAP_SIZE*MAP_SIZE, 1);
+  carmen_test_alloc(covered);
+  init_laser(&laser, NULL);
+  world_point.map = modify_map;
+
+  for (scan = 0; scan < NUM_SCANS; scan++) {
+    robot_pose(scan, &world_point.pose);
+    make_scan(room, scan, &world_point.pose, ranges[scan]);
+    laser.range = ranges[scan];
+
+    copy_map(before, modify_map);
+    start = carmen_get_time();
+    map_modify_update(&laser, &nav_conf, &world_point, true_map, modify_map);
+    update_time += carmen_get_time()-start;
+    num_changed += num_differences(before, modify_map);
+    dirty_errors += check_dirty(before, modify_map, covered);
+  }
+  errors += check(dirty_errors == 0, "changed cells are dirty");
+  errors += check(num_differences(modify_map, true_map) > 0, 
+		  "passers-by are obstacles");
+
+  /* the same map from the last scans only */
+  copy_map(snapshot, modify_map);
+  map_modify_clear(true_map, modify_map);
+  for (scan = NUM_SCANS-WINDOW; scan < NUM_SCANS; scan++) {
+    robot_pose(scan, &world_point.pose);
+    laser.range = ranges[scan];
+    map_modify_update(&laser, &nav_conf, &world_point, true_map, modify_map);
+  }
+  errors += check(num_differences(modify_map, snapshot) == 0,
+		  "map keeps the last scans");
+
+  /* nobody around, the passers-by are forgotten */
+  for (scan = 0; scan < WINDOW; scan++) {
+        for (index = 0; index < NUM_BEAMS; index++)
+      ranges[0][index] = MAX_RANGE;
+    laser.range = ranges[0];
+    copy_map(before, modify_map);
+    map_modify_update(&laser, &nav_conf, &world_point, true_map, modify_map);
+    errors += check(check_dirty(before, modify_map, covered) == 0,
+		    "cleared cells are dirty");
+  }
+  errors += check(num_differences(modify_map, true_map) == 0,
+		  "window ages out");
+
+  /* costs of the planner, rebuilt where the scans changed the map */
+  planner_map = make_room();
+  carmen_planner_set_map(planner_map, &robot_conf);
+  world_point.map = planner_map;
+  for (scan = 0; scan < NUM_SCANS; scan++) {
+    robot_pose(scan, &laser.laser_pose);
+    make_scan(room, scan, &laser.laser_pose, ranges[scan]);
+    laser.range = ranges[scan];
+    start = carmen_get_time();
+    carmen_planner_update_map(&laser, &nav_conf, &robot_conf);
+    cost_time += carmen_get_time()-start;
+  }
+
+  costs = (double *)calloc(MAP_SIZE*MAP_SIZE, sizeof(double));
+  carmen_test_alloc(costs);
+  memcpy(costs, carmen_conventional_get_costs_ptr(), 
+	 MAP_SIZE*MAP_SIZE*sizeof(double));
+  carmen_conventional_build_costs(&robot_conf, NULL, NULL);
+  for (index = 0; index < MAP_SIZE*MAP_SIZE; index++)
+    if (costs[index] != carmen_conventional_get_costs_ptr()[index])
+      break;
+  errors += check(index == MAP_SIZE*MAP_SIZE, "costs are up to date");
+
+  /* supplied costs stay where the scans did not change the map */
+  carmen_conventional_end_planner();
+  for (index = 0; index < MAP_SIZE*MAP_SIZE; index++)
+    costs[index] = 0.125;
+  carmen_planner_set_map_with_costs(planner_map, costs);
+  carmen_planner_update_map(&laser, &nav_conf, &robot_conf);
+  num_kept = 0;
+  for (index = 0; index < MAP_SIZE*MAP_SIZE; index++)
+    if (carmen_conventional_get_costs_ptr()[index] == 0.125)
+      num_kept++;
+  errors += check(num_kept > MAP_SIZE*MAP_SIZE/2, "supplied costs are kept");
+
+  /* what rebuilding the costs around the robot took */
+  world_point.pose = laser.laser_pose;
+  carmen_world_to_map(&world_point, &map_point);
+  start = carmen_get_time();
+  for (scan = 0; scan < 20; scan++)
+    carmen_conventional_build_costs(&robot_conf, &map_point, &nav_conf);
+  
+  printf("%.1f us per scan, %.1f cells changed per scan\n",
+	 update_time/NUM_SCANS*1e6, num_changed/(double)NUM_SCANS);
+  printf("%.1f us per scan with costs, %.1f us to build costs around "
+	 "the robot\n", cost_time/NUM_SCANS*1e6, 
+	 (carmen_get_time()-start)/20*1e6);
+
+  if (errors) {
+    printf("FAILED (%d errors)\n", errors);
+    return 1;
+  }
+  printf("passed\n");
+  return 0;
+}
@@ -0,0 +1,171 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include "global.h"
+#include "geometry.h"
+
+#include "robot_collision.h"
+
+#define NUM_BEAMS 1081
+#define NUM_SCANS 2000
+
+static double
+reference_max_velocity(float *range, double start_angle, double resolution,
+		       double x_offset, double y_offset, double tv, double rv,
+		       carmen_robot_config_t *robot_config, char *tooclose)
+{
+  carmen_traj_point_t robot_posn, obstacle_pt;
+  double max_velocity = robot_config->max_t_vel, velocity;
+  int i;
+
+  robot_posn.x = 0;
+  robot_posn.y = 0;
+  robot_posn.theta = 0;
+  robot_posn.t_vel = tv;
+  robot_posn.r_vel = rv;
+
+  for (i = 0; i < NUM_BEAMS; i++) {
+    obstacle_pt.x = x_offset + range[i] * cos(start_angle + i * resolution);
+    obstacle_pt.y = y_offset + range[i] * sin(start_angle + i * resolution);
+    carmen_geometry_move_pt_to_rotating_ref_frame(&obstacle_pt, tv, rv);
+    velocity = carmen_geometry_compute_velocity(robot_posn, obstacle_pt,
+						robot_config);
+    if (velocity < robot_config->max_t_vel) {
+      if (velocity < max_velocity)
+	max_velocity = velocity;
+      tooclose[i] = 1;
+    }
+  }
+
+  return max_velocity;
+}
+
+/* Compares the batched velocity limit to the per-beam checks for a
+   laser mounted at (x_offset, y_offset) and turned by angular_offset.
+   Returns the number of scans that differ. */
+static int
+check_laser(char *name, double angular_offset, double x_offset,
+	    double y_offset, carmen_robot_config_t *robot_config)
+{
+  carmen_robot_beam_table_t beams;
+  float range[NUM_BEAMS];
+  char tooclose[NUM_BEAMS], reference_tooclose[NUM_BEAMS];
+  double tv, rv, start_angle = -0.75 * M_PI + angular_offset;
+  double resolution = 1.5 * M_PI / (NUM_BEAMS - 1);
+  double velocity, reference_velocity, time, reference_time;
+  long candidates = 0;
+  int scan, i, mismatches = 0;
+
+  memset(&beams, 0, sizeof(carmen_robot_beam_table_t));
+
+  time = reference_time = 0;
+  for (scan = 0; scan < NUM_SCANS; scan++) {
+    double corridor = carmen_uniform_random(0.6, 5.0);
+
+    /* A corridor with some clutter around the laser */
+    for (i = 0; i < NUM_BEAMS; i++) {
+      double s = fabs(sin(start_angle + i * resolution));
+      range[i] = (s > 0.05) ? corridor / s : 20.0;
+      if (range[i] > 20.0)
+	range[i] = 20.0;
+      if (carmen_uniform_random(0, 1) < 0.05)
+	range[i] = carmen_uniform_random(0.1, range[i]);
+    }
+    tv = carmen_uniform_random(-robot_config->max_t_vel,
+			       robot_config->max_t_vel);
+    rv = carmen_uniform_random(-0.8, 0.8);
+
+    memset(tooclose, 0, NUM_BEAMS);
+    memset(reference_tooclose, 0, NUM_BEAMS);
+
+    reference_time -= carmen_get_time();
+    reference_velocity = reference_max_velocity
+      (range, start_angle, resolution, x_offset, y_offset, tv, rv,
+       robot_config, reference_tooclose);
+    reference_time += carmen_get_time();
+
+    time -= carmen_get_time();
+    carmen_robot_collision_update_beams(&beams, NUM_BEAMS, start_angle,
+					resolution);
+    velocity = carmen_robot_collision_max_velocity
+      (&beams, range, x_offset, y_offset, tv, rv, robot_config, tooclose);
+    time += carmen_get_time();
+    candidates += beams.num_candidates;
+
+    if (fabs(velocity - reference_velocity) > 1e-9 ||
+	memcmp(tooclose, reference_tooclose, NUM_BEAMS)) {
+      carmen_warn("%s laser, scan %d (tv %.3f rv %.3f): velocity %f, "
+		  "expected %f\n", name, scan, tv, rv, velocity,
+		  reference_velocity);
+      mismatches++;
+    }
+  }
+
+  carmen_warn("%s laser: %d scans of %d beams, %.1f%% of the beams in the "
+	      "stopping envelope\n", name, NUM_SCANS, NUM_BEAMS,
+	      100.0 * candidates / ((double)NUM_SCANS * NUM_BEAMS));
+  carmen_warn("%s laser: per-beam checks: %.1f us/scan, batched: "
+	      "%.1f us/scan\n", name, 1e6 * reference_time / NUM_SCANS,
+	      1e6 * time / NUM_SCANS);
+
+  carmen_robot_collision_free_beams(&beams);
+
+  return mismatches;
+}
+
+int
+main(int argc __attribute__ ((unused)), char **argv __attribute__ ((unused)))
+{
+  carmen_robot_config_t robot_config;
+  int mismatches = 0;
+
+  memset(&robot_config, 0, sizeof(carmen_robot_config_t));
+  robot_config.max_t_vel = 1.0;
+  robot_config.max_r_vel = 1.0;
+  robot_config.acceleration = 0.5;
+  robot_config.reaction_time = 0.1;
+  robot_config.approach_dist = 0.2;
+  robot_config.side_dist = 0.1;
+  robot_config.length = 0.6;
+  robot_config.width = 0.5;
+
+  carmen_randomize(&argc, &argv);
+
+  mismatches += check_laser("front", 0.0, 0.2, 0.0, &robot_config);
+  /* mounted behind the center, looking forward */
+  mismatches += check_laser("set back", 0.0, -0.1, 0.05, &robot_config);
+  /* rear laser, turned around and mounted at a negative offset */
+  mismatches += check_laser("rear", M_PI, -0.2, 0.0, &robot_config);
+
+  if (mismatches > 0) {
+    carmen_warn("%d scans differ from the per-beam checks\n", mismatches);
+    return -1;
+  }
+
+  return 0;
+}
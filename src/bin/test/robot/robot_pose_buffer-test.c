@@ -0,0 +1,300 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include "global.h"
+
+#include "robot_pose_buffer.h"
+
+#define NUM_ODOMETRY 20000
+#define NUM_QUERIES 200000
+
+/* The interpolation robot_main.c used before the pose buffer: the history
+   is shifted for every new reading and searched linearly. */
+
+static carmen_robot_pose_stamp_t *reference_history;
+static int reference_size;
+
+static void
+reference_add(carmen_robot_pose_stamp_p pose)
+{
+  int i;
+
+  for (i = 0; i < reference_size - 1; i++)
+    reference_history[i] = reference_history[i + 1];
+  reference_history[reference_size - 1] = *pose;
+}
+
+static double
+reference_get_fraction(double timestamp, int *low, int *high)
+{
+  int i;
+
+  *low = 0;
+  *high = 1;
+  for (i = 0; i < reference_size; i++)
+    if (timestamp < reference_history[i].timestamp) {
+      if (i == 0) {
+	*low = 0;
+	*high = 1;
+      } else {
+	*low = i - 1;
+	*high = i;
+      }
+      break;
+    }
+
+  if (i == reference_size) {
+    *low = i - 2;
+    *high = i - 1;
+  }
+
+  return (timestamp - reference_history[*low].timestamp) /
+    (reference_history[*high].timestamp - reference_history[*low].timestamp);
+}
+
+static void
+reference_interpolate(double timestamp, carmen_robot_pose_stamp_p pose)
+{
+  carmen_robot_pose_stamp_p p1, p2;
+  double fraction;
+  int low, high;
+
+  fraction = reference_get_fraction(timestamp, &low, &high);
+  p1 = reference_history + low;
+  p2 = reference_history + high;
+
+  pose->x = p1->x + fraction * (p2->x - p1->x);
+  pose->y = p1->y + fraction * (p2->y - p1->y);
+  pose->theta = carmen_normalize_theta
+    (p1->theta + fraction * carmen_normalize_theta(p2->theta - p1->theta));
+}
+
+/* Odometry of a robot driving arcs of constant velocity, switching to a
+   new arc once a second */
+
+#define NUM_ARCS 4001
+
+static carmen_robot_pose_stamp_t arcs[NUM_ARCS];
+
+static void
+arc_pose(carmen_robot_pose_stamp_p start, double dt,
+	 carmen_robot_pose_stamp_p pose)
+{
+  pose->theta = start->theta + start->rv * dt;
+  if (start->rv == 0) {
+    pose->x = start->x + start->tv * dt * cos(start->theta);
+    pose->y = start->y + start->tv * dt * sin(start->theta);
+  } else {
+    pose->x = start->x + start->tv / start->rv *
+      (sin(pose->theta) - sin(start->theta));
+    pose->y = start->y - start->tv / start->rv *
+      (cos(pose->theta) - cos(start->theta));
+  }
+  pose->theta = carmen_normalize_theta(pose->theta);
+  pose->tv = start->tv;
+  pose->rv = start->rv;
+  pose->timestamp = start->timestamp + dt;
+}
+
+static void
+generate_arcs(void)
+{
+  int i;
+
+  memset(arcs, 0, sizeof(arcs));
+  for (i = 0; i < NUM_ARCS; i++) {
+    if (i > 0)
+      arc_pose(arcs + i - 1, 1.0, arcs + i);
+    arcs[i].tv = carmen_uniform_random(0, 2.0);
+    arcs[i].rv = (carmen_uniform_random(0, 1) < 0.3) ? 0 :
+      carmen_uniform_random(-2.0, 2.0);
+  }
+}
+
+static void
+true_pose(double t, carmen_robot_pose_stamp_p pose)
+{
+  int arc = carmen_clamp(0, (int)floor(t), NUM_ARCS - 1);
+
+  arc_pose(arcs + arc, t - arc, pose);
+}
+
+static double
+position_error(carmen_robot_pose_stamp_p p1, carmen_robot_pose_stamp_p p2)
+{
+  return hypot(p1->x - p2->x, p1->y - p2->y);
+}
+
+static int
+test_correctness(void)
+{
+  carmen_robot_pose_buffer_p buffer;
+  carmen_robot_pose_stamp_t odometry[NUM_ODOMETRY], pose, reference, truth;
+  carmen_point_t beams[181];
+  double t, fraction, reference_fraction, error, reference_error;
+  double max_error = 0, max_reference_error = 0;
+  int i, j, low, high, reference_low, reference_high, failures = 0;
+
+  reference_size = 5;
+  reference_history = (carmen_robot_pose_stamp_p)
+    calloc(reference_size, sizeof(carmen_robot_pose_stamp_t));
+  carmen_test_alloc(reference_history);
+  buffer = carmen_robot_pose_buffer_new(reference_size);
+
+  /* 50 Hz odometry with some jitter */
+  for (i = 0; i < NUM_ODOMETRY; i++)
+    true_pose(i * 0.02 + carmen_uniform_random(0, 0.005), odometry + i);
+
+  for (i = 0; i < NUM_ODOMETRY; i++) {
+    reference_add(odometry + i);
+    carmen_robot_pose_buffer_add(buffer, odometry + i);
+    if (i < reference_size)
+      continue;
+
+    /* Same brackets as the linear search */
+    t = odometry[i].timestamp + carmen_uniform_random(-0.1, 0.02);
+    reference_fraction = reference_get_fraction(t, &reference_low,
+						&reference_high);
+    carmen_robot_pose_buffer_find(buffer, t, &low, &high, &fraction);
+    if (low != reference_low || high != reference_high ||
+	fabs(fraction - reference_fraction) > 1e-12) {
+      carmen_warn("Bracket of %f is %d-%d (%f), expected %d-%d (%f)\n", t,
+		  low, high, fraction, reference_low, reference_high,
+		  reference_fraction);
+      failures++;
+    }
+
+    /* Interpolation between readings on the same arc is exact */
+    t = carmen_uniform_random(odometry[i - 1].timestamp, odometry[i].timestamp);
+    if (floor(odometry[i - 1].timestamp) != floor(odometry[i].timestamp))
+      continue;
+    true_pose(t, &truth);
+    carmen_robot_pose_buffer_interpolate(buffer, t, &pose);
+    reference_interpolate(t, &reference);
+    error = position_error(&pose, &truth) +
+      fabs(carmen_normalize_theta(pose.theta - truth.theta));
+    reference_error = position_error(&reference, &truth);
+    max_error = carmen_fmax(max_error, error);
+    max_reference_error = carmen_fmax(max_reference_error, reference_error);
+    if (error > 1e-9) {
+      carmen_warn("Pose at %f is off by %g\n", t, error);
+      failures++;
+    }
+
+    /* Per-beam poses of a scan taken between the last readings */
+    carmen_robot_pose_buffer_interpolate_beams
+      (buffer, odometry[i - 3].timestamp, (t - odometry[i - 3].timestamp) / 180,
+       181, beams);
+    for (j = 0; j < 181; j += 30) {
+      carmen_robot_pose_buffer_interpolate
+	(buffer, odometry[i - 3].timestamp +
+	 j * (t - odometry[i - 3].timestamp) / 180, &pose);
+      if (hypot(pose.x - beams[j].x, pose.y - beams[j].y) > 1e-9) {
+	carmen_warn("Beam %d of scan at %f is off\n", j, t);
+	failures++;
+      }
+    }
+  }
+
+  carmen_warn("Maximum interpolation error %g m, linear interpolation "
+	      "%g m\n", max_error, max_reference_error);
+
+  carmen_robot_pose_buffer_free(buffer);
+  free(reference_history);
+
+  return failures;
+}
+
+static void
+benchmark(int size)
+{
+  carmen_robot_pose_buffer_p buffer;
+  carmen_robot_pose_stamp_t pose;
+  double time, reference_time, t;
+  int i;
+
+  reference_size = size;
+  reference_history = (carmen_robot_pose_stamp_p)
+    calloc(reference_size, sizeof(carmen_robot_pose_stamp_t));
+  carmen_test_alloc(reference_history);
+  buffer = carmen_robot_pose_buffer_new(size);
+
+  /* One reading and one query per laser scan, looking 50 ms back */
+  reference_time = carmen_get_time();
+  for (i = 0; i < NUM_QUERIES; i++) {
+    true_pose(i * 0.02, &pose);
+    reference_add(&pose);
+    if (i >= size)
+      reference_interpolate(i * 0.02 - 0.05, &pose);
+  }
+  reference_time = carmen_get_time() - reference_time;
+
+  time = carmen_get_time();
+  for (i = 0; i < NUM_QUERIES; i++) {
+    true_pose(i * 0.02, &pose);
+    carmen_robot_pose_buffer_add(buffer, &pose);
+    if (i >= size)
+      carmen_robot_pose_buffer_interpolate(buffer, i * 0.02 - 0.05, &pose);
+  }
+  time = carmen_get_time() - time;
+
+  t = carmen_get_time();
+  for (i = 0; i < NUM_QUERIES; i++)
+    true_pose(i * 0.02, &pose);
+  t = carmen_get_time() - t;
+
+  carmen_warn("History of %4d: shifted array %8.1f ns, pose buffer %6.1f ns "
+	      "per reading\n", size,
+	      1e9 * (reference_time - t) / NUM_QUERIES,
+	      1e9 * (time - t) / NUM_QUERIES);
+
+  carmen_robot_pose_buffer_free(buffer);
+  free(reference_history);
+}
+
+int
+main(int argc, char **argv)
+{
+  int failures;
+
+  carmen_randomize(&argc, &argv);
+  generate_arcs();
+
+  failures = test_correctness();
+
+  benchmark(5);
+  benchmark(50);
+  benchmark(500);
+
+  if (failures > 0) {
+    carmen_warn("%d checks failed\n", failures);
+    return -1;
+  }
+
+  return 0;
+}
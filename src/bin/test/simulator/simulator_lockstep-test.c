@@ -0,0 +1,154 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/* Benchmark scenario for the simulator's lockstep mode: drives the
+   simulated robot with a simple wall-avoiding wander behaviour for a
+   given mission time and reports how much faster than real time the
+   mission completed. Run the simulator with simulator_lockstep on and
+   simulator_lockstep_consumers set to the number of acknowledging
+   modules (1 if this is the only one). */
+
+#include "global.h"
+
+#include "param_interface.h"
+#include "base_interface.h"
+#include "laser_interface.h"
+#include "simulator_interface.h"
+
+#define CRUISE_VELOCITY       0.5
+#define TURN_VELOCITY         0.6
+#define SAFETY_DISTANCE       1.0
+
+carmen_laser_laser_message laser;
+carmen_simulator_clock_message simulator_clock;
+
+int have_laser = 0;
+double mission_time = 3600.0;
+double start_time = -1, start_wall_time = -1;
+double distance = 0.0;
+int num_steps = 0;
+
+void laser_handler(void)
+{
+  have_laser = 1;
+}
+
+void send_velocity(double tv, double rv)
+{
+  IPC_RETURN_TYPE err;
+  carmen_base_velocity_message vel;
+
+  vel.tv = tv;
+  vel.rv = rv;
+  vel.timestamp = carmen_get_time();
+  vel.host = carmen_get_host();
+
+  err = IPC_publishData(CARMEN_BASE_VELOCITY_NAME, &vel);
+  carmen_test_ipc(err, "Could not publish", CARMEN_BASE_VELOCITY_NAME);
+}
+
+void clock_handler(void)
+{
+  double min_range, simulated_time, wall_time;
+  int i, obstacle_left = 0;
+
+  if (start_time < 0) {
+    start_time = simulator_clock.timestamp;
+    start_wall_time = carmen_get_wall_time();
+  }
+  num_steps++;
+
+  if (have_laser) {
+    min_range = laser.config.maximum_range;
+    for (i = laser.num_readings / 4; i < 3 * laser.num_readings / 4; i++)
+      if (laser.range[i] < min_range) {
+	min_range = laser.range[i];
+	obstacle_left = (i > laser.num_readings / 2);
+      }
+
+    if (min_range < SAFETY_DISTANCE)
+      send_velocity(0.0, obstacle_left ? -TURN_VELOCITY : TURN_VELOCITY);
+    else {
+      send_velocity(CRUISE_VELOCITY, 0.0);
+      distance += CRUISE_VELOCITY * simulator_clock.delta_t;
+    }
+  }
+
+  carmen_simulator_acknowledge_clock();
+
+  simulated_time = simulator_clock.timestamp - start_time;
+  if (simulated_time >= mission_time) {
+    send_velocity(0.0, 0.0);
+    wall_time = carmen_get_wall_time() - start_wall_time;
+    printf("mission:         %.1f s simulated, %d steps, %.1f m driven\n",
+	   simulated_time, num_steps, distance);
+    printf("wall time:       %.2f s\n", wall_time);
+    printf("speed-up:        %.1fx real time\n", 
+	   wall_time > 0 ? simulated_time / wall_time : 0.0);
+    carmen_ipc_disconnect();
+    exit(0);
+  }
+}
+
+void shutdown_module(int x)
+{
+  if (x == SIGINT)
+    {
+      carmen_ipc_disconnect();
+      printf("shut down\n");
+      exit(0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+  IPC_RETURN_TYPE err;
+
+  if (argc > 1)
+    mission_time = atof(argv[1]);
+
+  carmen_ipc_initialize(argc, argv);
+  carmen_param_check_version(argv[0]);
+
+  signal(SIGINT, shutdown_module);
+
+  err = IPC_defineMsg(CARMEN_BASE_VELOCITY_NAME, IPC_VARIABLE_LENGTH, 
+		      CARMEN_BASE_VELOCITY_FMT);
+  carmen_test_ipc_exit(err, "Could not define", CARMEN_BASE_VELOCITY_NAME);
+
+  carmen_laser_subscribe_frontlaser_message(&laser, (carmen_handler_t)
+					    laser_handler,
+					    CARMEN_SUBSCRIBE_LATEST);
+  carmen_simulator_use_simulated_clock(argv[0], 0);
+  carmen_simulator_subscribe_clock_message(&simulator_clock, 
+					   (carmen_handler_t)clock_handler,
+					   CARMEN_SUBSCRIBE_ALL);
+
+  carmen_ipc_dispatch();
+  return 0;
+}
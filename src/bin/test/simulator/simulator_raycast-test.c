@@ -0,0 +1,236 @@
+ /*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include "global.h"
+
+#include "geometry.h"
+#include "raycast.h"
+
+#define MAP_SIZE          2000
+#define MAP_RESOLUTION    0.05
+#define NUM_OBSTACLES     400
+#define NUM_POSES         200
+#define NUM_ACCURACY_POSES 10
+#define REFERENCE_STEP    0.0002
+#define NUM_BEAMS         1081
+#define MAX_RANGE         30.0
+
+#define NUM_ROBOTS        4
+#define NUM_LASERS        2
+#define LASER_FREQUENCY   75.0
+
+static carmen_map_p
+create_map(void)
+{
+  carmen_map_p map;
+  int x, y, index, x_min, y_min, width, height;
+
+  map = (carmen_map_p)calloc(1, sizeof(carmen_map_t));
+  carmen_test_alloc(map);
+
+  map->config.x_size = MAP_SIZE;
+  map->config.y_size = MAP_SIZE;
+  map->config.resolution = MAP_RESOLUTION;
+  map->complete_map = (float *)calloc(MAP_SIZE*MAP_SIZE, sizeof(float));
+  carmen_test_alloc(map->complete_map);
+  map->map = (float **)calloc(MAP_SIZE, sizeof(float *));
+  carmen_test_alloc(map->map);
+  for (x = 0; x < MAP_SIZE; x++)
+    map->map[x] = map->complete_map+x*MAP_SIZE;
+
+  for (x = 0; x < MAP_SIZE; x++)
+    for (y = 0; y < MAP_SIZE; y++)
+      if (x < 2 || y < 2 || x >= MAP_SIZE-2 || y >= MAP_SIZE-2)
+	map->map[x][y] = 1.0;
+      else if (x > MAP_SIZE/4 && x < MAP_SIZE/2 && y > MAP_SIZE/4 &&
+	       y < MAP_SIZE/2)
+	map->map[x][y] = -1.0;
+
+  for (index = 0; index < NUM_OBSTACLES; index++) {
+    x_min = carmen_int_random(MAP_SIZE-40);
+    y_min = carmen_int_random(MAP_SIZE-40);
+    width = 1+carmen_int_random(30);
+    height = 1+carmen_int_random(30);
+    for (x = x_min; x < x_min+width; x++)
+      for (y = y_min; y < y_min+height; y++)
+	map->map[x][y] = 1.0;
+  }
+
+  return map;
+}
+
+static void
+random_free_pose(carmen_map_p map, carmen_traj_point_p pose)
+{
+  memset(pose, 0, sizeof(carmen_traj_point_t));
+  do {
+    pose->x = carmen_uniform_random(0.0, MAP_SIZE*MAP_RESOLUTION);
+    pose->y = carmen_uniform_random(0.0, MAP_SIZE*MAP_RESOLUTION);
+  } while (map->map[carmen_round(pose->x/MAP_RESOLUTION)]
+	   [carmen_round(pose->y/MAP_RESOLUTION)] > 0.15);
+  pose->theta = carmen_uniform_random(-M_PI, M_PI);
+}
+
+/* Marches along the ray in small steps, using the same cell convention
+   as carmen_geometry_compute_expected_distance() */
+static double
+reference_distance(carmen_map_p map, carmen_traj_point_p pose, double theta)
+{
+  double t, x, y;
+  int map_x, map_y;
+
+  for (t = 0.0; t < MAX_RANGE; t += REFERENCE_STEP) {
+    x = pose->x+t*cos(theta);
+    y = pose->y+t*sin(theta);
+    map_x = floor(x/MAP_RESOLUTION+0.5);
+    map_y = floor(y/MAP_RESOLUTION+0.5);
+    if (map_x < 0 || map_x >= map->config.x_size ||
+	map_y < 0 || map_y >= map->config.y_size ||
+	map->map[map_x][map_y] > 0.15)
+      break;
+  }
+
+  return t;
+}
+
+static void
+test_raycast_accuracy(carmen_map_p map, carmen_geometry_raycast_p raycast)
+{
+  int index, beam, num_errors = 0, num_grid_errors = 0;
+  float ranges[NUM_BEAMS], grid[NUM_BEAMS];
+  double theta, expected;
+  carmen_traj_point_t pose;
+
+  for (index = 0; index < NUM_ACCURACY_POSES; index++) {
+    random_free_pose(map, &pose);
+
+    carmen_geometry_raycast_laser_data(raycast, ranges, &pose, -M_PI/2,
+				       M_PI/2, NUM_BEAMS, MAX_RANGE);
+    carmen_geometry_generate_laser_data(grid, &pose, -M_PI/2, M_PI/2,
+					NUM_BEAMS, map);
+
+    theta = carmen_normalize_theta(pose.theta-M_PI/2);
+    for (beam = 0; beam < NUM_BEAMS; beam++) {
+      expected = reference_distance(map, &pose, theta);
+      if (expected < MAX_RANGE) {
+	if (fabs(ranges[beam]-expected) > 2.0*REFERENCE_STEP)
+	  num_errors++;
+	if (fabs(grid[beam]-expected) > MAP_RESOLUTION)
+	  num_grid_errors++;
+      } else if (ranges[beam] <= MAX_RANGE-2.0*REFERENCE_STEP)
+	num_errors++;
+      theta = carmen_normalize_theta(theta+M_PI/NUM_BEAMS);
+    }
+  }
+
+  carmen_warn("Accuracy: %d of %d beams differ from reference, "
+	      "%d off by more than a cell with the grid walk\n", num_errors,
+	      NUM_ACCURACY_POSES*NUM_BEAMS, num_grid_errors);
+  if (num_errors > 0)
+    carmen_warn("Failed: ray caster disagrees with reference\n");
+}
+
+static void
+test_raycast_cache(carmen_map_p map, carmen_geometry_raycast_p raycast)
+{
+  int hits, misses, beam;
+  float first[NUM_BEAMS], second[NUM_BEAMS];
+  carmen_traj_point_t pose;
+
+  random_free_pose(map, &pose);
+  carmen_geometry_raycast_cache_stats(raycast, &hits, &misses);
+
+  carmen_geometry_raycast_laser_data(raycast, first, &pose, -M_PI/2,
+				     M_PI/2, NUM_BEAMS, MAX_RANGE);
+  carmen_geometry_raycast_laser_data(raycast, second, &pose, -M_PI/2,
+				     M_PI/2, NUM_BEAMS, MAX_RANGE);
+  carmen_geometry_raycast_cache_stats(raycast, &hits, &misses);
+
+  for (beam = 0; beam < NUM_BEAMS; beam++)
+    if (first[beam] != second[beam]) {
+      carmen_warn("Failed: cached scan differs at beam %d\n", beam);
+      break;
+    }
+  carmen_warn("Cache: %d hits, %d misses\n", hits, misses);
+}
+
+static void
+benchmark(carmen_map_p map, carmen_geometry_raycast_p raycast)
+{
+  int index;
+  float ranges[NUM_BEAMS];
+  carmen_traj_point_t poses[NUM_POSES];
+  double start, old_time, new_time, required_rate;
+
+  for (index = 0; index < NUM_POSES; index++)
+    random_free_pose(map, poses+index);
+
+  start = carmen_get_time();
+  for (index = 0; index < NUM_POSES; index++)
+    carmen_geometry_generate_laser_data(ranges, poses+index, -M_PI/2,
+					M_PI/2, NUM_BEAMS, map);
+  old_time = carmen_get_time()-start;
+
+  start = carmen_get_time();
+  for (index = 0; index < NUM_POSES; index++)
+    carmen_geometry_raycast_laser_data(raycast, ranges, poses+index,
+				       -M_PI/2, M_PI/2, NUM_BEAMS,
+				       MAX_RANGE);
+  new_time = carmen_get_time()-start;
+
+  required_rate = NUM_ROBOTS*NUM_LASERS*LASER_FREQUENCY;
+  carmen_warn("grid walk: %.0f scans/s, ray caster: %.0f scans/s "
+	      "(speed-up %.1f)\n", NUM_POSES/old_time, NUM_POSES/new_time,
+	      old_time/new_time);
+  carmen_warn("%d robots with %d lasers at %.0f Hz: real-time factor %.1f "
+	      "(grid walk %.1f)\n", NUM_ROBOTS, NUM_LASERS, LASER_FREQUENCY,
+	      NUM_POSES/new_time/required_rate,
+	      NUM_POSES/old_time/required_rate);
+}
+
+int main(int argc __attribute__ ((unused)),
+	 char *argv[] __attribute__ ((unused)))
+{
+  carmen_map_p map;
+  carmen_geometry_raycast_p raycast;
+
+  carmen_randomize(&argc, &argv);
+
+  map = create_map();
+  raycast = carmen_geometry_raycast_new
+    (CARMEN_GEOMETRY_RAYCAST_DEFAULT_CACHE_SIZE);
+  carmen_geometry_raycast_set_map(raycast, map);
+
+  test_raycast_accuracy(map, raycast);
+  test_raycast_cache(map, raycast);
+  benchmark(map, raycast);
+
+  carmen_geometry_raycast_free(raycast);
+
+  return 0;
+}
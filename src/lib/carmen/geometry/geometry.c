@@ -31,7 +31,10 @@
 
 #include "global.h"
 
+#include "map_util.h"
+
 #include "geometry.h"
+#include "raycast.h"
 
 #ifndef COMPILE_WITHOUT_MAP_SUPPORT
 
@@ -570,199 +573,27 @@ carmen_geometry_compute_radius_and_centre(carmen_traj_point_p prev,
   return radius;
 }
 
-static void intersect(carmen_point_t *edge1, carmen_point_t *edge2,
-		      carmen_point_t *ray3, carmen_point_t *ray4,
-		      carmen_point_t *intersect_pt)
-{
-  double slope1, slope2, intercept1, intercept2;
-  double det, a, b, x_nom, y_nom;
-
-  if (fabs(edge2->x-edge1->x) < 1e-6 &&
-      fabs(ray4->x-ray3->x) < 1e-6) {
-    if (fabs(edge2->x-ray3->x) < 1e-6) {
-      if (fabs(edge1->x - ray3->x) < fabs(edge2->x - ray3->x)) {
-	intersect_pt->x = edge1->x;
-	intersect_pt->y = edge1->y;
-      } else {
-	intersect_pt->x = edge2->x;
-	intersect_pt->y = edge2->y;
-      }
-    } else {
-      intersect_pt->x = ray4->x;
-      intersect_pt->y = ray4->y;
-    }
-    return;
-  }
-
-  // Check if the lines are parallel
-
-  slope1 = (edge2->y - edge1->y)/(edge2->x - edge1->x);
-  slope2 = (ray4->y - ray3->y)/(ray4->x - ray3->x);
-
-  if (fabs(slope1 - slope2) < 1e-6) {
-    intercept1 = edge2->y - slope1*edge2->x;
-    intercept2 = ray4->y - slope2*ray4->x;
-    if (fabs(intercept1 - intercept2)) {
-      if (hypot(edge1->x-ray3->x, edge1->y-ray3->y) < hypot(edge2->x-ray3->x, edge2->y-ray3->y)) {
-	intersect_pt->x = edge1->x;
-	intersect_pt->y = edge1->y;
-      } else {
-	intersect_pt->x = edge2->x;
-	intersect_pt->y = edge2->y;
-      }
-    }
-    else {
-      intersect_pt->x = ray4->x;
-      intersect_pt->y = ray4->y;
-    }
-
-    return;
-  }
-
-  det = (edge1->x-edge2->x)*(ray3->y-ray4->y)-(ray3->x-ray4->x)*(edge1->y-edge2->y);
-
-  a = edge1->x*edge2->y - edge2->x*edge1->y;
-  b = ray3->x*ray4->y-ray4->x*ray3->y;
-
-  x_nom = a*(ray3->x-ray4->x) - b*(edge1->x-edge2->x);
-  intersect_pt->x = x_nom/det;
-
-  y_nom = a*(ray3->y-ray4->y) - b*(edge1->y-edge2->y);
-  intersect_pt->y = y_nom/det;
-}
-
 #ifndef COMPILE_WITHOUT_MAP_SUPPORT
+/* Walks the cells the ray crosses, each cell centred at
+   index*resolution, and returns where it enters the first occupied one,
+   or leaves the map. */
 double
 carmen_geometry_compute_expected_distance(carmen_traj_point_p traj_point,
 					  double theta, carmen_map_p map)
 {
-  int x2, y2, px, py;
-  carmen_bresenham_param_t params;
-  carmen_traj_point_t obstacle;
-  double distance=0;
-  double resolution;
-  int map_x, map_y;
-  carmen_map_config_t map_defn;
-  int index;
-
-  double min_distance = DBL_MAX;
-  int best = -1;
-  carmen_point_t ray3, ray4;
-  carmen_point_t edge1, edge2;
-  carmen_point_t intersect_pt;
-
-  int x_offset[8] = {1, 1, -1, 1, -1, -1, -1, 1};
-  int y_offset[8] = {-1, 1, 1, 1, -1, 1, -1, -1};
-
-  double distance_to_obstacle, min_distance_to_obstacle = DBL_MAX;
-  int best_obstacle;
-  carmen_point_t best_intersect_obstacle_pt = {0.0, 0.0, 0.0};
-
-  map_defn = map->config;
-
-  resolution = map->config.resolution;
-
-  /* Find centre of closest occupied grid cell in map */
-
-  map_x = carmen_round(traj_point->x / resolution);
-  map_y = carmen_round(traj_point->y / resolution);
-
-  carmen_geometry_project_point(map_x, map_y, theta, &x2, &y2, map_defn);
-
-  carmen_get_bresenham_parameters(map_x, map_y, x2, y2, &params);
-  do
-    {
-      carmen_get_current_point(&params, &map_x, &map_y);
-      if(map_x < 0 || map_x >= map->config.x_size ||
-	 map_y < 0 || map_y >= map->config.y_size)
-	break;
-      if (map->map[map_x][map_y] > 0.15)
-	break;
-    }
-  while (carmen_get_next_point(&params));
-
-  ray3.x = traj_point->x;
-  ray3.y = traj_point->y;
-  ray4.x = traj_point->x + (distance+1)*cos(theta);
-  ray4.y = traj_point->y + (distance+1)*sin(theta);
-
-  for (index = 0; index < 4; index++) {
-    edge1.x = map_x*resolution+x_offset[2*index]*resolution*0.5;
-    edge1.y = map_y*resolution+y_offset[2*index]*resolution*0.5;
-
-    edge2.x = map_x*resolution+x_offset[2*index+1]*resolution*0.5;
-    edge2.y = map_y*resolution+y_offset[2*index+1]*resolution*0.5;
-
-    intersect(&edge1, &edge2, &ray3, &ray4, &intersect_pt);
-
-    distance = hypot(intersect_pt.x-traj_point->x, intersect_pt.y-traj_point->y);
-    distance_to_obstacle = hypot(intersect_pt.x - map_x*resolution,
-				 intersect_pt.y - map_y*resolution);
-
-    if (distance_to_obstacle < min_distance_to_obstacle) {
-      min_distance_to_obstacle = distance_to_obstacle;
-      best_intersect_obstacle_pt = intersect_pt;
-      best_obstacle = index;
-    }
-
-    if (index == 0 || index == 2) {
-      if (intersect_pt.y >= edge1.y && intersect_pt.y <= edge2.y && distance < min_distance ) {
-	min_distance = distance;
-	best = index;
-      }
-    } else {
-      if (intersect_pt.x >= edge1.x && intersect_pt.x <= edge2.x && distance < min_distance ) {
-	min_distance = distance;
-	best = index;
-      }
-    }
-  }
-
-  if (min_distance > DBL_MAX/2)
-    min_distance = hypot(best_intersect_obstacle_pt.x-traj_point->x,
-			 best_intersect_obstacle_pt.y-traj_point->y);
-
-  return min_distance;
-
-  /* Project map up to cm level co-ordinates, and walk backwards to find the
-     first **unoccupied** cm grid cell, to find out where the obstacle actually
-     begins. Knowing the centre of obstacles isn't always useful. */
-
-  px = carmen_round(traj_point->x * 100.0);
-  py = carmen_round(traj_point->y * 100.0);
-
-  x2 = carmen_round(px+distance*cos(theta)*100);
-  y2 = carmen_round(py+distance*sin(theta)*100);
-
-  carmen_warn("x2: %d %d px: %d %d d: %f ", x2, y2, px, py, distance);
-
-  resolution *= 100.0;
-
-  carmen_get_bresenham_parameters(x2, y2, px, py, &params);
-  obstacle.x = x2;
-  obstacle.y = y2;
-  do
-    {
-      carmen_get_current_point(&params, &px, &py);
-      map_x = carmen_round(px / resolution);
-      map_y = carmen_round(py / resolution);
-      if(map_x < 0 || map_x >= map->config.x_size ||
-	 map_y < 0 || map_y >= map->config.y_size)
-        break;
-      if (map->map[map_x][map_y] < 0.15)
-        break;
-      obstacle.x = px / 100;
-      obstacle.y = py / 100;
-
-    }
-  while (carmen_get_next_point(&params));
-
-  carmen_warn("now x2: %d %d px: %d %d d: %f\n", x2, y2, px, py, distance);
-
-  distance = carmen_distance_traj(&obstacle, traj_point);
-
-  return distance;
-
+  carmen_grid_ray_t ray;
+  double resolution = map->config.resolution;
+
+  carmen_grid_ray_init(&ray, traj_point->x/resolution+0.5, 
+		       traj_point->y/resolution+0.5, theta, DBL_MAX);
+  do {
+    if (ray.x < 0 || ray.x >= map->config.x_size ||
+	ray.y < 0 || ray.y >= map->config.y_size ||
+	map->map[ray.x][ray.y] > 0.15)
+      break;
+  } while (carmen_grid_ray_next(&ray));
+
+  return ray.t*resolution;
 }
 
 void
@@ -792,6 +623,9 @@ carmen_geometry_generate_sonar_data(double *sonar_data,
     }
 }
 
+/* The beams are cast as one batch of grid rays, each stopped at its
+   first occupied cell, so every beam ends where
+   carmen_geometry_compute_expected_distance() would. */
 void
 carmen_geometry_generate_laser_data(float *laser_data,
 				    carmen_traj_point_p traj_point,
@@ -799,10 +633,11 @@ carmen_geometry_generate_laser_data(float *laser_data,
 				    int num_points, carmen_map_p map)
 {
   int index;
-  float *laser_data_ptr;
   double theta;
   double separation;
-  double dist;
+  double resolution = map->config.resolution;
+  carmen_grid_rays_p rays;
+  carmen_grid_ray_t ray;
 
   start_theta = carmen_normalize_theta(start_theta);
   end_theta = carmen_normalize_theta(end_theta);
@@ -813,219 +648,105 @@ carmen_geometry_generate_laser_data(float *laser_data,
   else
     separation = (end_theta - start_theta)/num_points;
 
-  laser_data_ptr = laser_data;
+  rays = carmen_grid_rays_new();
+  carmen_grid_rays_reset(rays, map->config.x_size, map->config.y_size);
   for (index = 0; index < num_points; index++)
     {
-      dist = carmen_geometry_compute_expected_distance(traj_point, theta, map);
-      *(laser_data_ptr++) = dist;
+      carmen_grid_rays_add(rays, traj_point->x/resolution+0.5,
+			   traj_point->y/resolution+0.5, theta, DBL_MAX);
       theta = carmen_normalize_theta(theta+separation);
     }
-}
 
-/*
- * Development code below here : do not use
- *
- */
+  while (carmen_grid_rays_next(rays, &ray, &index))
+    do {
+      if (map->map[ray.x][ray.y] > 0.15) {
+	carmen_grid_ray_stop(&ray);
+	break;
+      }
+    } while (carmen_grid_rays_step(rays, &ray));
+
+  for (index = 0; index < num_points; index++)
+    laser_data[index] = rays->t_stop[index]*resolution;
+  carmen_grid_rays_free(rays);
+}
 
-static int num_points_to_generate=-1;
-static double ***cached_data = NULL;
-static carmen_map_p expected_map = NULL;
-static int cache_misses = 0;
-static int cache_hits = 0;
+static carmen_geometry_raycast_p fast_raycast = NULL;
+static pthread_mutex_t fast_raycast_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 void
-carmen_geometry_fast_generate_laser_data
-(float *laser_data, carmen_traj_point_p traj_point,
- double start_theta,
- double end_theta __attribute__ ((unused)),
- int num_points, carmen_map_p map)
+carmen_geometry_fast_generate_laser_data(float *laser_data,
+					 carmen_traj_point_p traj_point,
+					 double start_theta, double end_theta,
+					 int num_points, carmen_map_p map)
 {
-  int index;
-  float *laser_data_ptr;
-  double separation;
-  double dist;
-  double *dist_ptr;
-  double laser_theta;
-  int x, y;
-  int offset;
-
-  if (num_points_to_generate < 0)
-    num_points_to_generate = num_points;
-
-  if (num_points_to_generate != num_points)
-    carmen_die("You can't (yet!) call generate_laser_data with requests "
-	       "for different numbers \nof points. After the first time you "
-	       "call it, you have to use the same number of\n"
-	       "points always.\n");
-
-  if (expected_map == NULL)
-    expected_map = map;
-
-
-  if (expected_map != map)
-    carmen_die("You can't (yet!) call generate_laser_data different maps. "
-	       "After the first time\nyou call it, you have to always re-use "
-	       "the same map.\n");
-
-  if (cached_data == NULL)
-    {
-      cached_data = (double ***)
-	calloc(map->config.x_size*map->config.resolution, sizeof(double **));
-      carmen_test_alloc(cached_data);
-      memset(cached_data, 0, map->config.x_size*
-	     map->config.resolution*sizeof(double **));
-    }
-
-  x = carmen_round(traj_point->x);
-  y = carmen_round(traj_point->y);
-
-  if (cached_data[x] == NULL)
-    {
-      cached_data[x] = (double **)
-	calloc(map->config.y_size*map->config.resolution, sizeof(double *));
-      carmen_test_alloc(cached_data[x]);
-      memset(cached_data[x], 0, map->config.y_size*
-	     map->config.resolution*sizeof(double *));
-    }
-
-  if (cached_data[x][y] == NULL)
-    {
-      cache_misses++;
-      cached_data[x][y] = (double *)
-	calloc(num_points_to_generate, sizeof(double));
-      carmen_test_alloc(cached_data[x][y]);
-
-      dist_ptr = cached_data[x][y];
-      laser_theta = 0;
-      separation = 2*M_PI/num_points_to_generate;
-      for (index = 0; index < num_points_to_generate; index++)
-	{
-	  dist = carmen_geometry_compute_expected_distance
-	    (traj_point, laser_theta, map);
-	  *(dist_ptr++) = dist;
-	  laser_theta = carmen_normalize_theta(laser_theta+separation);
-	}
-    }
-  else
-    cache_hits++;
-
-  laser_data_ptr = laser_data;
-  offset = carmen_round(carmen_radians_to_degrees
-			(carmen_normalize_theta(start_theta)));
-  if (offset < 0)
-    offset += 360;
-  offset = carmen_round(offset/360.0*num_points_to_generate);
-  dist_ptr = cached_data[x][y] + offset;
-  for (index = 0; index < num_points; index++)
-    {
-      *(laser_data_ptr++) = *(dist_ptr++);
-      offset++;
-      if (offset >= num_points)
-	{
-	  offset = 0;
-	  dist_ptr = cached_data[x][y];
-	}
-    }
+  pthread_mutex_lock(&fast_raycast_mutex);
+  if (fast_raycast == NULL)
+    fast_raycast = carmen_geometry_raycast_new
+      (CARMEN_GEOMETRY_RAYCAST_DEFAULT_CACHE_SIZE);
+  carmen_geometry_raycast_set_map(fast_raycast, map);
+  carmen_geometry_raycast_laser_data(fast_raycast, laser_data, traj_point,
+				     start_theta, end_theta, num_points, 0.0);
+  pthread_mutex_unlock(&fast_raycast_mutex);
 }
 
 void
 carmen_geometry_cache_stats(int *hits, int *misses)
 {
-  *hits = cache_hits;
-  *misses = cache_misses;
+  *hits = 0;
+  *misses = 0;
+
+  if (fast_raycast != NULL)
+    carmen_geometry_raycast_cache_stats(fast_raycast, hits, misses);
 }
 
+/* Cells closer than the robot footprint to an obstacle (see
+   carmen_map_util_footprint_radii) end up impassable (1.0), all others
+   free (0.0). Unknown cells are obstacles. */
 void
 carmen_geometry_map_to_cspace(carmen_map_p map,
 			      carmen_robot_config_t *robot_conf)
 {
-  int x_index, y_index, index;
-  float *map_ptr;
-  int x, y;
-  float value = 0.0;
-  float resolution = map->config.resolution;
-  float downgrade;
-
-  // This line makes downgrade equal to the number of cells that half the
-  // robot width consumes
-  downgrade = robot_conf->width/2/resolution;
-
-  // This line makes downgrade equal to the amount to take off so that
-  // half the width of the robot away from a cell of value 1, the cell
-  // has value 0.5
-
-  downgrade = 0.5 / downgrade;
-
-  /* Loop through map, starting at top left, updating value of cell
-     as max of itself and most expensive neighbour less the cost
-     downgrade. */
+  carmen_map_util_distance_transform(map, 0.1, map);
+  carmen_map_util_distance_to_cspace(map, robot_conf);
+}
 
-  map_ptr = map->complete_map;
+void
+carmen_geometry_compact_map_to_cspace(carmen_compact_map_p map,
+				      carmen_robot_config_t *robot_conf,
+				      carmen_map_p cspace)
+{
+  float u8_value[256];
+  unsigned char *src;
+  float *map_ptr;
+  int x_index, y_index, cell;
+
+  cspace->config = map->config;
+  cspace->complete_map = (float *)
+    calloc(map->config.x_size*map->config.y_size, sizeof(float));
+  carmen_test_alloc(cspace->complete_map);
+  cspace->map = (float **)calloc(map->config.x_size, sizeof(float *));
+  carmen_test_alloc(cspace->map);
   for (x_index = 0; x_index < map->config.x_size; x_index++)
-    for (y_index = 0; y_index < map->config.y_size; y_index++) {
-      value = *map_ptr;
-      if (value >= 0 && value < 0.1)
-	value = 0.1;
-      else
-	value = 1.0;
-      *(map_ptr++) = value;
-    }
-
-  for (x_index = 1; x_index < map->config.x_size-1; x_index++)
-    {
-      map_ptr = map->map[x_index];
-      for (y_index = 1; y_index < map->config.y_size-1; y_index++, map_ptr++)
-	{
-	  for (index = 0; index < CARMEN_NUM_OFFSETS; index++)
-	    {
-	      x = x_index + carmen_geometry_x_offset[index];
-	      y = y_index + carmen_geometry_y_offset[index];
-
-	      value = map->map[x][y] - downgrade;
-	      if (value > *map_ptr)
-		*map_ptr = value;
-	    }
-	}
-    }
-
-  /* Loop through map again, starting at bottom right, updating value of
-     cell as max of itself and most expensive neighbour less the cost
-     downgrade. */
-
-  for (x_index = map->config.x_size-2; x_index >= 1; x_index--)
-    {
-      map_ptr = map->map[x_index]+map->config.y_size-1;
-      for (y_index = map->config.y_size-2; y_index >= 1; y_index--, map_ptr--)
-	{
-	  for (index = 0; index < CARMEN_NUM_OFFSETS; index++)
-	    {
-	      x = x_index + carmen_geometry_x_offset[index];
-	      y = y_index + carmen_geometry_y_offset[index];
-
-	      value = map->map[x][y] - downgrade;
-	      if (value > *map_ptr)
-		*map_ptr = value;
-	    }
-	}
-    }
-
-  /* Clamp any cell that's higher than 0.5 (close than half the width
-     of the robot as impassable. Also, fix map so that the clear space
-     is 0.0 */
+    cspace->map[x_index] = cspace->complete_map+x_index*map->config.y_size;
+
+  for (cell = 0; cell < 256; cell++)
+    u8_value[cell] = (cell != CARMEN_MAP_U8_UNKNOWN && 
+		      cell / (float)CARMEN_MAP_U8_MAX < 0.1) ? 0.0 : 1.0;
+
+  map_ptr = cspace->complete_map;
+  for (x_index = 0; x_index < map->config.x_size; x_index++) {
+    src = map->data+x_index*map->column_bytes;
+    if (map->encoding == CARMEN_MAP_ENCODING_U8)
+      for (y_index = 0; y_index < map->config.y_size; y_index++)
+	*(map_ptr++) = u8_value[src[y_index]];
+    else
+      for (y_index = 0; y_index < map->config.y_size; y_index++)
+	*(map_ptr++) = (((src[y_index >> 2] >> ((y_index & 3) << 1)) & 3) ==
+			CARMEN_MAP_CELL_FREE) ? 0.0 : 1.0;
+  }
 
-  for (x_index = 1; x_index < map->config.x_size-1; x_index++)
-    {
-      map_ptr = map->map[x_index];
-      for (y_index = 1; y_index < map->config.y_size-1; y_index++)
-	{
-	  value = *map_ptr;
-	  if (value >= 0 && value < 0.5)
-	    value = 0.0;
-	  else if (value >= 0.5)
-	    value = 1.0;
-	  *(map_ptr++) = value;
-	}
-    }
+  carmen_map_util_distance_transform(cspace, 0.1, cspace);
+  carmen_map_util_distance_to_cspace(cspace, robot_conf);
 }
 
 #endif
@@ -104,6 +104,13 @@ void carmen_geometry_generate_sonar_data(double *sonar_data, carmen_traj_point_p
 				       carmen_point_p sonar_offsets, int num_sonars,
 				       carmen_map_p map);
 
+/*
+   Same as carmen_geometry_generate_laser_data, but casts the rays on a
+   clearance map to skip free space and caches the scans of recent poses
+   (see raycast.h). Changing the map or beam configuration between calls
+   is allowed.
+*/
+
 void carmen_geometry_fast_generate_laser_data(float *laser_data, carmen_traj_point_p traj_point,
 					    double start_theta, double end_theta, int num_points, 
 					    carmen_map_p map);
@@ -118,6 +125,16 @@ extern int carmen_geometry_x_offset[];
 extern int carmen_geometry_y_offset[];
 
 void carmen_geometry_map_to_cspace(carmen_map_p map, carmen_robot_config_t *robot_conf);
+
+/*
+   Same as carmen_geometry_map_to_cspace, but reads the cells of a compact
+   map and allocates the configuration space map in cspace. Bitmap maps
+   keep the free/occupied classification they were built with.
+*/
+
+void carmen_geometry_compact_map_to_cspace(carmen_compact_map_p map,
+					   carmen_robot_config_t *robot_conf,
+					   carmen_map_p cspace);
 #endif
 
 #ifdef __cplusplus
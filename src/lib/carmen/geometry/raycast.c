@@ -0,0 +1,491 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include <float.h>
+
+#include "raycast.h"
+
+#ifndef COMPILE_WITHOUT_MAP_SUPPORT
+
+static void
+alloc_clearance(carmen_geometry_raycast_p raycast, void *map_data,
+		carmen_map_config_t config)
+{
+  raycast->map_data = map_data;
+  raycast->config = config;
+
+  free(raycast->clearance);
+  raycast->clearance = (unsigned char *)calloc(config.x_size*config.y_size,
+					       sizeof(unsigned char));
+  carmen_test_alloc(raycast->clearance);
+}
+
+/* Turns a clearance map in which occupied cells are 0 and all other
+   cells non-zero into the chessboard distance in cells of every cell to
+   the closest occupied cell, with everything outside the map considered
+   occupied. Two chamfer passes give the exact result. */
+static void
+build_clearance(carmen_geometry_raycast_p raycast)
+{
+  int x, y, x_size, y_size, value;
+  unsigned char *clearance, *column, *previous;
+
+  x_size = raycast->config.x_size;
+  y_size = raycast->config.y_size;
+  clearance = raycast->clearance;
+
+  for (x = 0; x < x_size; x++) {
+    column = clearance+x*y_size;
+    previous = column-y_size;
+    for (y = 0; y < y_size; y++) {
+      if (column[y] == 0)
+	value = 0;
+      else if (x == 0 || y == 0)
+	value = 1;
+      else {
+	value = carmen_imin(column[y-1], previous[y-1]);
+	value = carmen_imin(value, previous[y]);
+	if (y < y_size-1)
+	  value = carmen_imin(value, previous[y+1]);
+	value = carmen_imin(value+1, CARMEN_GEOMETRY_RAYCAST_MAX_CLEARANCE);
+      }
+      column[y] = value;
+    }
+  }
+
+  for (x = x_size-1; x >= 0; x--) {
+    column = clearance+x*y_size;
+    previous = column+y_size;
+    for (y = y_size-1; y >= 0; y--) {
+      if (column[y] == 0)
+	continue;
+      if (x == x_size-1 || y == y_size-1)
+	value = 1;
+      else {
+	value = carmen_imin(column[y+1], previous[y+1]);
+	value = carmen_imin(value, previous[y]);
+	if (y > 0)
+	  value = carmen_imin(value, previous[y-1]);
+	value++;
+      }
+      if (value < column[y])
+	column[y] = value;
+    }
+  }
+}
+
+static void
+build_map_clearance(carmen_geometry_raycast_p raycast, carmen_map_p map)
+{
+  unsigned char *clearance;
+  float *cell, *end;
+
+  alloc_clearance(raycast, map->complete_map, map->config);
+
+  clearance = raycast->clearance;
+  end = map->complete_map+map->config.x_size*map->config.y_size;
+  for (cell = map->complete_map; cell < end; cell++)
+    *(clearance++) = (*cell > CARMEN_GEOMETRY_RAYCAST_OCCUPIED) ? 0 : 1;
+
+  build_clearance(raycast);
+}
+
+/* Reads the compact cells directly; a bitmap map uses its own
+   free/occupied classification. */
+static void
+build_compact_map_clearance(carmen_geometry_raycast_p raycast,
+			    carmen_compact_map_p map)
+{
+  unsigned char free_cell[256];
+  unsigned char *clearance, *src;
+  int x, y, y_size = map->config.y_size;
+
+  alloc_clearance(raycast, map->data, map->config);
+
+  for (x = 0; x < 256; x++)
+    free_cell[x] = !(x != CARMEN_MAP_U8_UNKNOWN &&
+		     x / (float)CARMEN_MAP_U8_MAX > 
+		     CARMEN_GEOMETRY_RAYCAST_OCCUPIED);
+
+  clearance = raycast->clearance;
+  for (x = 0; x < map->config.x_size; x++) {
+    src = map->data+x*map->column_bytes;
+    if (map->encoding == CARMEN_MAP_ENCODING_U8)
+      for (y = 0; y < y_size; y++)
+	*(clearance++) = free_cell[src[y]];
+    else
+      for (y = 0; y < y_size; y++)
+	*(clearance++) = (((src[y >> 2] >> ((y & 3) << 1)) & 3) != 
+			  CARMEN_MAP_CELL_OCCUPIED);
+  }
+
+  build_clearance(raycast);
+}
+
+static void
+flush_cache(carmen_geometry_raycast_p raycast)
+{
+  int index;
+
+  pthread_mutex_lock(&raycast->cache_mutex);
+  for (index = 0; index < raycast->num_scans; index++)
+    free(raycast->scans[index].ranges);
+  raycast->num_scans = 0;
+  pthread_mutex_unlock(&raycast->cache_mutex);
+}
+
+/* Walks the ray cell by cell in grid coordinates, where cell (i, j) is
+   centred at (i, j)*resolution as in carmen_geometry_compute_expected_
+   distance(). The distance is measured to the boundary of the cell that
+   stops the ray. Wherever the clearance of a cell is large, the ray skips
+   ahead by that clearance instead of visiting the cells in between. */
+static double
+cast_ray(carmen_geometry_raycast_p raycast, double x, double y,
+	 double theta, double max_range)
+{
+  double resolution = raycast->config.resolution;
+  double grid_x, grid_y, dx, dy, t = 0.0, t_limit;
+  double t_max_x, t_max_y, t_delta_x, t_delta_y;
+  int x_size = raycast->config.x_size, y_size = raycast->config.y_size;
+  int cell_x, cell_y, step_x, step_y, clearance;
+
+  grid_x = x/resolution+0.5;
+  grid_y = y/resolution+0.5;
+  dx = cos(theta);
+  dy = sin(theta);
+
+  step_x = (dx > 0.0) ? 1 : ((dx < 0.0) ? -1 : 0);
+  step_y = (dy > 0.0) ? 1 : ((dy < 0.0) ? -1 : 0);
+  t_delta_x = (dx != 0.0) ? 1.0/fabs(dx) : DBL_MAX;
+  t_delta_y = (dy != 0.0) ? 1.0/fabs(dy) : DBL_MAX;
+
+  t_limit = (max_range > 0.0) ? max_range/resolution : DBL_MAX;
+
+  while (t <= t_limit) {
+    x = grid_x+t*dx;
+    y = grid_y+t*dy;
+    cell_x = floor(x);
+    cell_y = floor(y);
+    if (cell_x < 0 || cell_x >= x_size || cell_y < 0 || cell_y >= y_size)
+      break;
+
+    clearance = raycast->clearance[cell_x*y_size+cell_y];
+    if (clearance == 0)
+      break;
+    if (clearance >= CARMEN_GEOMETRY_RAYCAST_MIN_SKIP) {
+      t += clearance-2;
+      continue;
+    }
+
+    if (dx > 0.0)
+      t_max_x = t+(cell_x+1-x)*t_delta_x;
+    else if (dx < 0.0)
+      t_max_x = t+(x-cell_x)*t_delta_x;
+    else
+      t_max_x = DBL_MAX;
+
+    if (dy > 0.0)
+      t_max_y = t+(cell_y+1-y)*t_delta_y;
+    else if (dy < 0.0)
+      t_max_y = t+(y-cell_y)*t_delta_y;
+    else
+      t_max_y = DBL_MAX;
+
+    /* Plain traversal until the ray ends or reaches open space again.
+       Skipping ahead from the entry point of a cell by less than its
+       clearance cannot pass any occupied cell. */
+    do {
+      if (t_max_x < t_max_y) {
+	t = t_max_x;
+	t_max_x += t_delta_x;
+	cell_x += step_x;
+	if (cell_x < 0 || cell_x >= x_size)
+	  return t*resolution;
+      } else {
+	t = t_max_y;
+	t_max_y += t_delta_y;
+	cell_y += step_y;
+	if (cell_y < 0 || cell_y >= y_size)
+	  return t*resolution;
+      }
+
+      clearance = raycast->clearance[cell_x*y_size+cell_y];
+      if (clearance == 0)
+	return t*resolution;
+    } while (clearance < CARMEN_GEOMETRY_RAYCAST_MIN_SKIP && t <= t_limit);
+
+    if (clearance >= CARMEN_GEOMETRY_RAYCAST_MIN_SKIP)
+      t += clearance-2;
+  }
+
+  return t*resolution;
+}
+
+static void
+cast_scan(carmen_geometry_raycast_p raycast, float *laser_data,
+	  carmen_traj_point_p traj_point, double start_theta,
+	  double end_theta, int num_points, double max_range)
+{
+  int index;
+  double theta;
+  double separation;
+
+  start_theta = carmen_normalize_theta(start_theta);
+  end_theta = carmen_normalize_theta(end_theta);
+  theta = carmen_normalize_theta(start_theta + traj_point->theta);
+
+  if (end_theta <= start_theta)
+    separation = (2*M_PI + (end_theta-start_theta)) / num_points;
+  else
+    separation = (end_theta - start_theta)/num_points;
+
+  for (index = 0; index < num_points; index++) {
+    laser_data[index] = cast_ray(raycast, traj_point->x, traj_point->y,
+				 theta, max_range);
+    theta = carmen_normalize_theta(theta+separation);
+  }
+}
+
+static carmen_geometry_raycast_scan_p
+find_scan(carmen_geometry_raycast_p raycast, carmen_traj_point_p traj_point,
+	  double start_theta, double end_theta, int num_points,
+	  double max_range)
+{
+  carmen_geometry_raycast_scan_p scan;
+  int index;
+
+  for (index = 0; index < raycast->num_scans; index++) {
+    scan = raycast->scans+index;
+    if (scan->pose.x == traj_point->x && scan->pose.y == traj_point->y &&
+	scan->pose.theta == traj_point->theta &&
+	scan->start_theta == start_theta && scan->end_theta == end_theta &&
+	scan->num_points == num_points && scan->max_range == max_range)
+      return scan;
+  }
+
+  return NULL;
+}
+
+static void
+insert_scan(carmen_geometry_raycast_p raycast, float *laser_data,
+	    carmen_traj_point_p traj_point, double start_theta,
+	    double end_theta, int num_points, double max_range)
+{
+  carmen_geometry_raycast_scan_p scan;
+  int index;
+
+  if (raycast->num_scans < raycast->cache_size) {
+    scan = raycast->scans+raycast->num_scans;
+    scan->ranges = NULL;
+    scan->num_points = 0;
+    raycast->num_scans++;
+  } else {
+    scan = raycast->scans;
+    for (index = 1; index < raycast->num_scans; index++)
+      if (raycast->scans[index].last_used < scan->last_used)
+	scan = raycast->scans+index;
+  }
+
+  if (scan->num_points != num_points) {
+    scan->ranges = (float *)realloc(scan->ranges, num_points*sizeof(float));
+    carmen_test_alloc(scan->ranges);
+  }
+
+  scan->pose.x = traj_point->x;
+  scan->pose.y = traj_point->y;
+  scan->pose.theta = traj_point->theta;
+  scan->start_theta = start_theta;
+  scan->end_theta = end_theta;
+  scan->num_points = num_points;
+  scan->max_range = max_range;
+  scan->last_used = ++raycast->cache_clock;
+  memcpy(scan->ranges, laser_data, num_points*sizeof(float));
+}
+
+carmen_geometry_raycast_p
+carmen_geometry_raycast_new(int cache_size)
+{
+  carmen_geometry_raycast_p raycast;
+
+  raycast = (carmen_geometry_raycast_p)calloc
+    (1, sizeof(carmen_geometry_raycast_t));
+  carmen_test_alloc(raycast);
+
+  raycast->cache_size = cache_size;
+  if (cache_size > 0) {
+    raycast->scans = (carmen_geometry_raycast_scan_p)calloc
+      (cache_size, sizeof(carmen_geometry_raycast_scan_t));
+    carmen_test_alloc(raycast->scans);
+  }
+
+  pthread_rwlock_init(&raycast->map_lock, NULL);
+  pthread_mutex_init(&raycast->cache_mutex, NULL);
+
+  return raycast;
+}
+
+void
+carmen_geometry_raycast_free(carmen_geometry_raycast_p raycast)
+{
+  if (raycast == NULL)
+    return;
+
+  flush_cache(raycast);
+  pthread_rwlock_destroy(&raycast->map_lock);
+  pthread_mutex_destroy(&raycast->cache_mutex);
+
+  free(raycast->scans);
+  free(raycast->clearance);
+  free(raycast);
+}
+
+void
+carmen_geometry_raycast_set_map(carmen_geometry_raycast_p raycast,
+				carmen_map_p map)
+{
+  int same_map;
+
+  pthread_rwlock_rdlock(&raycast->map_lock);
+  same_map = (raycast->map_data == map->complete_map &&
+	      raycast->config.x_size == map->config.x_size &&
+	      raycast->config.y_size == map->config.y_size &&
+	      raycast->config.resolution == map->config.resolution);
+  pthread_rwlock_unlock(&raycast->map_lock);
+
+  if (!same_map)
+    carmen_geometry_raycast_update_map(raycast, map);
+}
+
+void
+carmen_geometry_raycast_update_map(carmen_geometry_raycast_p raycast,
+				   carmen_map_p map)
+{
+  pthread_rwlock_wrlock(&raycast->map_lock);
+  build_map_clearance(raycast, map);
+  flush_cache(raycast);
+  pthread_rwlock_unlock(&raycast->map_lock);
+}
+
+void
+carmen_geometry_raycast_set_compact_map(carmen_geometry_raycast_p raycast,
+					carmen_compact_map_p map)
+{
+  int same_map;
+
+  pthread_rwlock_rdlock(&raycast->map_lock);
+  same_map = (raycast->map_data == map->data &&
+	      raycast->config.x_size == map->config.x_size &&
+	      raycast->config.y_size == map->config.y_size &&
+	      raycast->config.resolution == map->config.resolution);
+  pthread_rwlock_unlock(&raycast->map_lock);
+
+  if (!same_map)
+    carmen_geometry_raycast_update_compact_map(raycast, map);
+}
+
+void
+carmen_geometry_raycast_update_compact_map(carmen_geometry_raycast_p raycast,
+					   carmen_compact_map_p map)
+{
+  pthread_rwlock_wrlock(&raycast->map_lock);
+  build_compact_map_clearance(raycast, map);
+  flush_cache(raycast);
+  pthread_rwlock_unlock(&raycast->map_lock);
+}
+
+double
+carmen_geometry_raycast_distance(carmen_geometry_raycast_p raycast,
+				 carmen_traj_point_p traj_point,
+				 double theta, double max_range)
+{
+  double distance = 0.0;
+
+  pthread_rwlock_rdlock(&raycast->map_lock);
+  if (raycast->clearance != NULL)
+    distance = cast_ray(raycast, traj_point->x, traj_point->y, theta,
+			max_range);
+  pthread_rwlock_unlock(&raycast->map_lock);
+
+  return distance;
+}
+
+void
+carmen_geometry_raycast_laser_data(carmen_geometry_raycast_p raycast,
+				   float *laser_data,
+				   carmen_traj_point_p traj_point,
+				   double start_theta, double end_theta,
+				   int num_points, double max_range)
+{
+  carmen_geometry_raycast_scan_p scan;
+
+  pthread_rwlock_rdlock(&raycast->map_lock);
+  if (raycast->clearance == NULL) {
+    memset(laser_data, 0, num_points*sizeof(float));
+    pthread_rwlock_unlock(&raycast->map_lock);
+    return;
+  }
+
+  pthread_mutex_lock(&raycast->cache_mutex);
+  scan = find_scan(raycast, traj_point, start_theta, end_theta, num_points,
+		   max_range);
+  if (scan != NULL) {
+    memcpy(laser_data, scan->ranges, num_points*sizeof(float));
+    scan->last_used = ++raycast->cache_clock;
+    raycast->cache_hits++;
+  } else
+    raycast->cache_misses++;
+  pthread_mutex_unlock(&raycast->cache_mutex);
+
+  if (scan == NULL) {
+    cast_scan(raycast, laser_data, traj_point, start_theta, end_theta,
+	      num_points, max_range);
+
+    if (raycast->cache_size > 0) {
+      pthread_mutex_lock(&raycast->cache_mutex);
+      if (find_scan(raycast, traj_point, start_theta, end_theta,
+		    num_points, max_range) == NULL)
+	insert_scan(raycast, laser_data, traj_point, start_theta, end_theta,
+		    num_points, max_range);
+      pthread_mutex_unlock(&raycast->cache_mutex);
+    }
+  }
+
+  pthread_rwlock_unlock(&raycast->map_lock);
+}
+
+void
+carmen_geometry_raycast_cache_stats(carmen_geometry_raycast_p raycast,
+				    int *hits, int *misses)
+{
+  pthread_mutex_lock(&raycast->cache_mutex);
+  *hits = raycast->cache_hits;
+  *misses = raycast->cache_misses;
+  pthread_mutex_unlock(&raycast->cache_mutex);
+}
+
+#endif
@@ -0,0 +1,141 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/** @addtogroup global libgeometry **/
+// @{
+
+/** \file raycast.h
+ * \brief Ray casting on occupancy grid maps.
+ *
+ * Casts rays through a grid map using a digital differential analyzer
+ * that skips free space based on a precomputed clearance map, i.e. the
+ * chessboard distance of every cell to the closest obstacle. Complete
+ * laser scans are kept in a bounded LRU cache keyed by the sensor pose
+ * and beam configuration.
+ * All functions may be called concurrently from multiple threads.
+ **/
+
+#ifndef CARMEN_GEOMETRY_RAYCAST_H
+#define CARMEN_GEOMETRY_RAYCAST_H
+
+#include <pthread.h>
+
+#include "global.h"
+#include "map.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Cells with an occupancy above this value stop a ray. */
+#define CARMEN_GEOMETRY_RAYCAST_OCCUPIED 0.15
+
+/** Minimum clearance in cells for skipping ahead on a ray. */
+#define CARMEN_GEOMETRY_RAYCAST_MIN_SKIP 4
+#define CARMEN_GEOMETRY_RAYCAST_MAX_CLEARANCE 255
+
+#define CARMEN_GEOMETRY_RAYCAST_DEFAULT_CACHE_SIZE 16
+
+typedef struct {
+  carmen_point_t pose;
+  double start_theta;
+  double end_theta;
+  int num_points;
+  double max_range;
+  float *ranges;
+  unsigned long last_used;
+} carmen_geometry_raycast_scan_t, *carmen_geometry_raycast_scan_p;
+
+typedef struct {
+  void *map_data;
+  carmen_map_config_t config;
+  unsigned char *clearance;
+  pthread_rwlock_t map_lock;
+
+  int cache_size;
+  int num_scans;
+  carmen_geometry_raycast_scan_p scans;
+  unsigned long cache_clock;
+  int cache_hits;
+  int cache_misses;
+  pthread_mutex_t cache_mutex;
+} carmen_geometry_raycast_t, *carmen_geometry_raycast_p;
+
+/** Creates a ray caster caching at most cache_size scans. The ray caster
+  * has no map until carmen_geometry_raycast_set_map() is called. */
+carmen_geometry_raycast_p carmen_geometry_raycast_new(int cache_size);
+
+void carmen_geometry_raycast_free(carmen_geometry_raycast_p raycast);
+
+/** Associates the ray caster with a map. The clearance map is only
+  * rebuilt and the cache flushed if the map differs from the current
+  * one, i.e. it is cheap to call this before every scan. */
+void carmen_geometry_raycast_set_map(carmen_geometry_raycast_p raycast,
+				     carmen_map_p map);
+
+/** Rebuilds the clearance map after the current map has been
+  * modified in place. */
+void carmen_geometry_raycast_update_map(carmen_geometry_raycast_p raycast,
+					carmen_map_p map);
+
+/** Same as carmen_geometry_raycast_set_map() and
+  * carmen_geometry_raycast_update_map() for a compact map, which is
+  * read directly without expanding it to floats. Bitmap maps keep the
+  * free/occupied classification they were built with. */
+void carmen_geometry_raycast_set_compact_map(carmen_geometry_raycast_p raycast,
+					     carmen_compact_map_p map);
+void 
+carmen_geometry_raycast_update_compact_map(carmen_geometry_raycast_p raycast,
+					   carmen_compact_map_p map);
+
+/** Returns the distance from the pose to the first occupied cell or the
+  * map border along theta. If max_range is positive, the ray is stopped
+  * at the first cell boundary beyond max_range and the returned distance
+  * exceeds max_range. */
+double carmen_geometry_raycast_distance(carmen_geometry_raycast_p raycast,
+					carmen_traj_point_p traj_point,
+					double theta, double max_range);
+
+/** Fills laser_data with the same beam layout as
+  * carmen_geometry_generate_laser_data(). Scans for a pose and beam
+  * configuration already in the cache are copied from there. */
+void carmen_geometry_raycast_laser_data(carmen_geometry_raycast_p raycast,
+					float *laser_data,
+					carmen_traj_point_p traj_point,
+					double start_theta, double end_theta,
+					int num_points, double max_range);
+
+void carmen_geometry_raycast_cache_stats(carmen_geometry_raycast_p raycast,
+					 int *hits, int *misses);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+// @}
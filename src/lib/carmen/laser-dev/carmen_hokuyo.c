@@ -51,7 +51,6 @@ int carmen_hokuyo_handle_sleep(carmen_laser_device_t* device __attribute__ ((unu
 int carmen_hokuyo_handle(carmen_laser_device_t* device){
   HokuyoURG* urg=(HokuyoURG*)device->device_data;
 
-  struct timeval timestamp;
   char buf[URG_BUFSIZE];
   int j;
 
@@ -64,8 +63,7 @@ int carmen_hokuyo_handle(carmen_laser_device_t* device){
     message.config=device->config;
     message.num_readings=reading.n_ranges;
     message.num_remissions=0;
-    gettimeofday(&timestamp, NULL);
-    message.timestamp=timestamp.tv_sec + 1e-6*timestamp.tv_usec;
+    message.timestamp=urg->packetTime.tv_sec + 1e-6*urg->packetTime.tv_usec;
     for (j=0; j<reading.n_ranges; j++){
       message.range[j]=0.001*reading.ranges[j];
       if (message.range[j] <= 0.02) {
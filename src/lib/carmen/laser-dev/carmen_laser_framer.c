@@ -0,0 +1,127 @@
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+#include "carmen_laser_framer.h"
+
+void carmen_laser_framer_init(carmen_laser_framer_t* framer, int fd){
+	framer->fd=fd;
+	framer->reads=0;
+	framer->skipped=0;
+	carmen_laser_framer_clear(framer);
+}
+
+void carmen_laser_framer_clear(carmen_laser_framer_t* framer){
+	framer->begin=0;
+	framer->end=0;
+	framer->num_reads=0;
+}
+
+/* takes n bytes off the front of the buffer */
+static void consume(carmen_laser_framer_t* framer, int n){
+	int i=0;
+
+	framer->begin+=n;
+	if (framer->begin>=framer->end){
+		carmen_laser_framer_clear(framer);
+		return;
+	}
+	while (i<framer->num_reads && framer->read_end[i]<=framer->begin)
+		i++;
+	if (i>0){
+		framer->num_reads-=i;
+		memmove(framer->read_end, framer->read_end+i, framer->num_reads*sizeof(int));
+		memmove(framer->read_time, framer->read_time+i, framer->num_reads*sizeof(struct timeval));
+	}
+}
+
+int carmen_laser_framer_fill(carmen_laser_framer_t* framer, int timeout){
+	struct timeval t;
+	fd_set set;
+	int i, val;
+
+	if (framer->end==CARMEN_LASER_FRAMER_BUFSIZE){
+		if (framer->begin==0)
+			return 0;
+		memmove(framer->buffer, framer->buffer+framer->begin, framer->end-framer->begin);
+		for (i=0; i<framer->num_reads; i++)
+			framer->read_end[i]-=framer->begin;
+		framer->end-=framer->begin;
+		framer->begin=0;
+	}
+
+	t.tv_sec=timeout/1000000;
+	t.tv_usec=timeout%1000000;
+	FD_ZERO(&set);
+	FD_SET(framer->fd, &set);
+	val=select(framer->fd+1, &set, NULL, NULL, &t);
+	if (val<0)
+		return errno==EINTR ? 0 : -1;
+	if (val==0)
+		return 0;
+
+	val=read(framer->fd, framer->buffer+framer->end, CARMEN_LASER_FRAMER_BUFSIZE-framer->end);
+	if (val<0)
+		return (errno==EINTR || errno==EAGAIN) ? 0 : -1;
+	if (val==0)
+		return 0;
+	framer->reads++;
+
+	/* the oldest reads are merged into the next one when there are too
+	   many, which makes them look later than they were */
+	if (framer->num_reads==CARMEN_LASER_FRAMER_MAX_READS){
+		framer->num_reads--;
+		memmove(framer->read_end, framer->read_end+1, framer->num_reads*sizeof(int));
+		memmove(framer->read_time, framer->read_time+1, framer->num_reads*sizeof(struct timeval));
+	}
+	framer->end+=val;
+	framer->read_end[framer->num_reads]=framer->end;
+	gettimeofday(framer->read_time+framer->num_reads, NULL);
+	framer->num_reads++;
+	return val;
+}
+
+int carmen_laser_framer_next(carmen_laser_framer_t* framer, carmen_laser_framer_check_t check, void* check_data,
+			     unsigned char** packet, struct timeval* arrival, int timeout){
+	int val;
+
+	for (;;){
+		while (framer->begin<framer->end){
+			val=(*check)(framer->buffer+framer->begin, framer->end-framer->begin, check_data);
+			if (val>0){
+				*packet=framer->buffer+framer->begin;
+				if (arrival)
+					*arrival=framer->read_time[0];
+				consume(framer, val);
+				return val;
+			}
+			if (val==0)
+				break;
+			framer->skipped+=-val;
+			consume(framer, -val);
+		}
+		/* a buffer full of an incomplete packet is no packet */
+		if (framer->end-framer->begin==CARMEN_LASER_FRAMER_BUFSIZE){
+			framer->skipped++;
+			consume(framer, 1);
+			continue;
+		}
+		val=carmen_laser_framer_fill(framer, timeout);
+		if (val<=0)
+			return val;
+	}
+}
+
+int carmen_laser_framer_read_byte(carmen_laser_framer_t* framer, unsigned char* c, int timeout){
+	int val;
+
+	if (framer->begin==framer->end){
+		val=carmen_laser_framer_fill(framer, timeout);
+		if (val<=0)
+			return val;
+	}
+	*c=framer->buffer[framer->begin];
+	consume(framer, 1);
+	return 1;
+}
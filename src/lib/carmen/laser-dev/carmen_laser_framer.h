@@ -0,0 +1,51 @@
+#ifndef CARMEN_LASER_FRAMER_H
+#define CARMEN_LASER_FRAMER_H
+
+#include <sys/time.h>
+
+/* Splits the byte stream of a serial laser into packets. Whatever is
+   available on the line is read at once into a buffer, and packets are
+   found in the buffer by a protocol specific check function. Each
+   packet is stamped with the time its first byte was read. */
+
+#define CARMEN_LASER_FRAMER_BUFSIZE 16384
+#define CARMEN_LASER_FRAMER_MAX_READS 64
+
+/* Looks at the size buffered bytes at data. Returns the length of the
+   packet data starts with, 0 if more bytes are needed to tell, or -n to
+   skip n bytes that cannot start a packet. */
+typedef int (*carmen_laser_framer_check_t)(const unsigned char* data, int size, void* check_data);
+
+typedef struct {
+	int fd;
+	unsigned char buffer[CARMEN_LASER_FRAMER_BUFSIZE];
+	int begin, end;
+	/* where the bytes of each read end in the buffer, and when they
+	   were read */
+	int num_reads;
+	int read_end[CARMEN_LASER_FRAMER_MAX_READS];
+	struct timeval read_time[CARMEN_LASER_FRAMER_MAX_READS];
+	/* statistics */
+	unsigned int reads, skipped;
+} carmen_laser_framer_t;
+
+void carmen_laser_framer_init(carmen_laser_framer_t* framer, int fd);
+
+/* forgets the buffered bytes */
+void carmen_laser_framer_clear(carmen_laser_framer_t* framer);
+
+/* waits up to timeout microseconds for bytes and reads all available.
+   Returns the number of bytes read, 0 on timeout, -1 on error. */
+int carmen_laser_framer_fill(carmen_laser_framer_t* framer, int timeout);
+
+/* Returns the length of the next packet and sets packet to it, inside
+   the buffer, where it stays valid until the next call. Bytes that do
+   not belong to a packet are skipped. Returns 0 if no packet completes
+   for timeout microseconds, -1 on error. */
+int carmen_laser_framer_next(carmen_laser_framer_t* framer, carmen_laser_framer_check_t check, void* check_data,
+			     unsigned char** packet, struct timeval* arrival, int timeout);
+
+/* returns 1 and the next byte, or what carmen_laser_framer_fill() does */
+int carmen_laser_framer_read_byte(carmen_laser_framer_t* framer, unsigned char* c, int timeout);
+
+#endif
@@ -1,78 +1,205 @@
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef LASER_USE_PTHREAD
+#include <stdint.h>
+#include <sys/eventfd.h>
+#endif
 #include "carmen_laser_message_queue.h"
 
+#define load(x) __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define store(x, v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+#define compare_and_swap(x, expected, v) \
+	__atomic_compare_exchange_n(&(x), &(expected), (v), 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+
 void carmen_laser_message_queue_init(carmen_laser_message_queue_t* queue){
-	queue->head=queue->tail=queue->size=0;
+	memset(queue, 0, sizeof(carmen_laser_message_queue_t));
+	queue->slots=calloc(CARMEN_LASER_MESSAGE_QUEQE_SIZE, sizeof(carmen_laser_laser_static_message));
+	if (!queue->slots){
+		fprintf(stderr, "Could not allocate the laser message queue\n");
+		exit(1);
+	}
+	queue->mask=CARMEN_LASER_MESSAGE_QUEQE_SIZE-1;
+	queue->wakeup=&queue->own_wakeup;
+	queue->own_wakeup.fd=-1;
 #ifdef LASER_USE_PTHREAD
-	pthread_mutex_init(&(queue->mutex),NULL);
-	sem_init(&(queue->semaphore),0,0);
+	queue->own_wakeup.fd=eventfd(0, 0);
+	if (queue->own_wakeup.fd<0){
+		perror("Could not create the laser message queue eventfd");
+		exit(1);
+	}
 #endif
 }
 
+void carmen_laser_message_queue_share_wakeup(carmen_laser_message_queue_t* queue, carmen_laser_message_queue_t* other){
+	queue->wakeup=other->wakeup;
+}
+
 void carmen_laser_message_queue_destroy(carmen_laser_message_queue_t* queue){
-#ifdef LASER_USE_PTHREAD
-	pthread_mutex_destroy(&(queue->mutex));
-	sem_destroy(&(queue->semaphore));
-#endif
+	if (queue->own_wakeup.fd>=0)
+		close(queue->own_wakeup.fd);
+	free(queue->slots);
+	queue->slots=NULL;
 	queue->head=queue->tail=0;
 }
 
-int carmen_laser_message_queue_add(carmen_laser_message_queue_t* queue, carmen_laser_laser_static_message* message){
-	int returnedSize;
-	int added;
-#ifdef LASER_USE_PTHREAD
-	pthread_mutex_lock(&queue->mutex);
-#endif
-	queue->readings[queue->tail++]=*message;
-	queue->size++;
-	returnedSize=queue->size;
-	added=1;
-	if (queue->size>CARMEN_LASER_MESSAGE_QUEQE_SIZE){
-		queue->size--;
-		queue->head++;
-		added=0;
+/* Returns the slot for the next scan, dropping the oldest scan if the
+   ring is full, or NULL if that slot is still being read. */
+carmen_laser_laser_static_message* carmen_laser_message_queue_acquire(carmen_laser_message_queue_t* queue){
+	unsigned int head, tail=queue->tail;
+
+	for (;;){
+		head=load(queue->head);
+		if (tail-head<=queue->mask)
+			break;
+		if (compare_and_swap(queue->head, head, head+1)){
+			__atomic_add_fetch(&queue->dropped, 1, __ATOMIC_SEQ_CST);
+			break;
+		}
+	}
+	if (load(queue->busy) && load(queue->reading)==tail-queue->mask-1){
+		__atomic_add_fetch(&queue->dropped, 1, __ATOMIC_SEQ_CST);
+		return NULL;
 	}
-	queue->head=queue->head%CARMEN_LASER_MESSAGE_QUEQE_SIZE;
-	queue->tail=queue->tail%CARMEN_LASER_MESSAGE_QUEQE_SIZE;
+	return queue->slots+(tail&queue->mask);
+}
+
+void carmen_laser_message_queue_commit(carmen_laser_message_queue_t* queue){
 #ifdef LASER_USE_PTHREAD
-	pthread_mutex_unlock(&queue->mutex);
-	if (added)
-		sem_post(&queue->semaphore);
+	uint64_t one=1;
 #endif
-	return returnedSize;
-}
 
-int carmen_laser_message_queue_get(carmen_laser_message_queue_t* queue, carmen_laser_laser_static_message* message){
-	int returnedSize;
-	if (!queue->size)
-	  return -1;
+	store(queue->tail, queue->tail+1);
 #ifdef LASER_USE_PTHREAD
-	pthread_mutex_lock(&queue->mutex);
+	if (load(queue->wakeup->sleeping))
+		if (write(queue->wakeup->fd, &one, sizeof(one))<0)
+			perror("Could not wake up the laser message queue");
 #endif
-	returnedSize=queue->size-1;
-	if (queue->size>0){
-		*message=queue->readings[queue->head++];
+}
+
+/* copies only the readings in use */
+static void copy_message(carmen_laser_laser_static_message* dest, carmen_laser_laser_static_message* src){
+	int num_readings=src->num_readings, num_remissions=src->num_remissions;
+
+	if (num_readings>CARMEN_LASER_LASER_STATIC_MESSAGE_MAXREADINGS)
+		num_readings=CARMEN_LASER_LASER_STATIC_MESSAGE_MAXREADINGS;
+	if (num_remissions>CARMEN_LASER_LASER_STATIC_MESSAGE_MAXREADINGS)
+		num_remissions=CARMEN_LASER_LASER_STATIC_MESSAGE_MAXREADINGS;
+
+	dest->id=src->id;
+	dest->config=src->config;
+	dest->num_readings=num_readings;
+	if (num_readings>0)
+		memcpy(dest->range, src->range, num_readings*sizeof(float));
+	dest->num_remissions=num_remissions;
+	if (num_remissions>0)
+		memcpy(dest->remission, src->remission, num_remissions*sizeof(float));
+	dest->timestamp=src->timestamp;
+	dest->host=src->host;
+}
+
+int carmen_laser_message_queue_add(carmen_laser_message_queue_t* queue, carmen_laser_laser_static_message* message){
+	carmen_laser_laser_static_message* slot;
+
+	slot=carmen_laser_message_queue_acquire(queue);
+	if (slot){
+		copy_message(slot, message);
+		carmen_laser_message_queue_commit(queue);
+	}
+	return carmen_laser_message_queue_size(queue);
+}
+
+/* Takes the oldest scan out of the ring; its slot is not reused until
+   it is released. */
+carmen_laser_laser_static_message* carmen_laser_message_queue_peek(carmen_laser_message_queue_t* queue){
+	unsigned int head;
+
+	for (;;){
+		head=load(queue->head);
+		if (head==load(queue->tail))
+			return NULL;
+		store(queue->reading, head);
+		store(queue->busy, 1);
+		if (compare_and_swap(queue->head, head, head+1))
+			return queue->slots+(head&queue->mask);
+		store(queue->busy, 0);
 	}
-	queue->size--;
-	if (queue->size>CARMEN_LASER_MESSAGE_QUEQE_SIZE){
-		queue->head++;
+}
+
+void carmen_laser_message_queue_release(carmen_laser_message_queue_t* queue){
+	store(queue->busy, 0);
+}
+
+int carmen_laser_message_queue_get(carmen_laser_message_queue_t* queue, carmen_laser_laser_static_message* message){
+	carmen_laser_laser_static_message* slot;
+
+	slot=carmen_laser_message_queue_peek(queue);
+	if (!slot)
+		return -1;
+	copy_message(message, slot);
+	carmen_laser_message_queue_release(queue);
+	return carmen_laser_message_queue_size(queue);
+}
+
+int carmen_laser_message_queue_drain(carmen_laser_message_queue_t* queue, carmen_laser_message_queue_handler_t handler, void* data, int max_messages){
+	carmen_laser_laser_static_message* slot;
+	int count=0;
+
+	while (max_messages<=0 || count<max_messages){
+		slot=carmen_laser_message_queue_peek(queue);
+		if (!slot)
+			break;
+		(*handler)(slot, data);
+		carmen_laser_message_queue_release(queue);
+		count++;
 	}
-	queue->head=queue->head%CARMEN_LASER_MESSAGE_QUEQE_SIZE;
-	queue->tail=queue->tail%CARMEN_LASER_MESSAGE_QUEQE_SIZE;
-#ifdef LASER_USE_PTHREAD
-	pthread_mutex_unlock(&queue->mutex);
-#endif
-	return returnedSize;
+	return count;
+}
+
+int carmen_laser_message_queue_size(carmen_laser_message_queue_t* queue){
+	return load(queue->tail)-load(queue->head);
+}
+
+unsigned int carmen_laser_message_queue_dropped(carmen_laser_message_queue_t* queue){
+	return load(queue->dropped);
 }
 
 #ifdef LASER_USE_PTHREAD
+static int any_queued(carmen_laser_message_queue_t* queues, int num_queues){
+	int i;
+	for (i=0; i<num_queues; i++)
+		if (carmen_laser_message_queue_size(queues+i)>0)
+			return 1;
+	return 0;
+}
+
+void carmen_laser_message_queue_wait(carmen_laser_message_queue_t* queues, int num_queues){
+	carmen_laser_message_queue_wakeup_t* wakeup=queues[0].wakeup;
+	uint64_t value;
+
+	if (any_queued(queues, num_queues))
+		return;
+	/* a producer that commits after this sees sleeping and writes to
+	   the eventfd */
+	store(wakeup->sleeping, 1);
+	if (!any_queued(queues, num_queues) && read(wakeup->fd, &value, sizeof(value))<0 && errno!=EINTR)
+		perror("Could not wait on the laser message queue");
+	store(wakeup->sleeping, 0);
+}
+
+void carmen_laser_message_queue_interrupt(carmen_laser_message_queue_t* queue){
+	uint64_t one=1;
+	int saved_errno=errno;
+
+	/* nothing to report a failure with that is safe in a handler */
+	if (write(queue->wakeup->fd, &one, sizeof(one))<0)
+		errno=saved_errno;
+}
+
 int carmen_laser_message_queue_wait_get(carmen_laser_message_queue_t* queue, carmen_laser_laser_static_message* message){
-  int sval;
-  sem_getvalue(&queue->semaphore, &sval);
-  sem_wait(&queue->semaphore);
-  int v=carmen_laser_message_queue_get(queue, message);
-  // fprintf(stderr, "%s, sem=%d, q=%d\n", __PRETTY_FUNCTION__, sval, v);
-  return v;
+	carmen_laser_message_queue_wait(queue, 1);
+	return carmen_laser_message_queue_get(queue, message);
 }
 #endif
-
@@ -1,31 +1,77 @@
 #ifndef CARMEN_LASER_MESSAGE_QUEUE
 #define CARMEN_LASER_MESSAGE_QUEUE
 
-#ifdef LASER_USE_PTHREAD
-#include <pthread.h>
-#include <semaphore.h>
-#endif
-
 #include "laser_messages.h"
 #include "laser_static_messages.h"
 
-#define CARMEN_LASER_MESSAGE_QUEQE_SIZE 4096
+/* A lock-free ring of laser scans for one producer (a laser thread) and
+   one consumer (the thread publishing the scans). Scans are written and
+   read in place: the producer fills the slot returned by
+   carmen_laser_message_queue_acquire() and makes it visible with
+   carmen_laser_message_queue_commit(), the consumer reads the slot
+   returned by carmen_laser_message_queue_peek() until it calls
+   carmen_laser_message_queue_release().
+
+   When the ring is full the producer drops the oldest scan. If the
+   consumer is still reading the slot the producer would need, the new
+   scan is dropped instead. Both are counted in dropped.
+
+   With LASER_USE_PTHREAD, the consumer can sleep until scans arrive.
+   The producer only signals the eventfd if the consumer sleeps, so
+   neither side makes a system call while scans keep coming. Queues
+   drained by the same consumer can share one wakeup. */
+
+/* must be a power of two */
+#define CARMEN_LASER_MESSAGE_QUEQE_SIZE 1024
 
 typedef struct {
-	carmen_laser_laser_static_message readings[CARMEN_LASER_MESSAGE_QUEQE_SIZE];
-#ifdef LASER_USE_PTHREAD
-	pthread_mutex_t mutex;
-	sem_t semaphore;
-#endif
-	int head, tail, size;
+	int fd;
+	volatile int sleeping;
+} carmen_laser_message_queue_wakeup_t;
+
+typedef struct {
+	carmen_laser_laser_static_message* slots;
+	unsigned int mask;
+	volatile unsigned int head, tail;
+	/* the slot the consumer holds, if busy */
+	volatile unsigned int reading;
+	volatile int busy;
+	volatile unsigned int dropped;
+	carmen_laser_message_queue_wakeup_t* wakeup;
+	carmen_laser_message_queue_wakeup_t own_wakeup;
 } carmen_laser_message_queue_t;
 
-int carmen_laser_message_queue_add(carmen_laser_message_queue_t* queue, carmen_laser_laser_static_message* message);
-int carmen_laser_message_queue_get(carmen_laser_message_queue_t* queue, carmen_laser_laser_static_message* message);
+typedef void (*carmen_laser_message_queue_handler_t)(carmen_laser_laser_static_message* message, void* data);
+
 void carmen_laser_message_queue_init(carmen_laser_message_queue_t* queue);
+/* queue wakes the consumer of other instead of having its own wakeup */
+void carmen_laser_message_queue_share_wakeup(carmen_laser_message_queue_t* queue, carmen_laser_message_queue_t* other);
 void carmen_laser_message_queue_destroy(carmen_laser_message_queue_t* queue);
 
+/* producer */
+carmen_laser_laser_static_message* carmen_laser_message_queue_acquire(carmen_laser_message_queue_t* queue);
+void carmen_laser_message_queue_commit(carmen_laser_message_queue_t* queue);
+int carmen_laser_message_queue_add(carmen_laser_message_queue_t* queue, carmen_laser_laser_static_message* message);
+
+/* consumer */
+carmen_laser_laser_static_message* carmen_laser_message_queue_peek(carmen_laser_message_queue_t* queue);
+void carmen_laser_message_queue_release(carmen_laser_message_queue_t* queue);
+int carmen_laser_message_queue_get(carmen_laser_message_queue_t* queue, carmen_laser_laser_static_message* message);
+/* calls handler on up to max_messages scans (all if max_messages <= 0),
+   in place, and returns how many */
+int carmen_laser_message_queue_drain(carmen_laser_message_queue_t* queue, carmen_laser_message_queue_handler_t handler, void* data, int max_messages);
+int carmen_laser_message_queue_size(carmen_laser_message_queue_t* queue);
+unsigned int carmen_laser_message_queue_dropped(carmen_laser_message_queue_t* queue);
+
 #ifdef LASER_USE_PTHREAD
+/* sleeps until one of the queues, which share the wakeup of queues[0],
+   holds a scan or carmen_laser_message_queue_interrupt() is called.
+   Signals alone do not end the wait, as handlers installed with
+   signal() restart it. Callers check the queues again. */
+void carmen_laser_message_queue_wait(carmen_laser_message_queue_t* queues, int num_queues);
+/* ends the current or next wait on the wakeup of queue. Only writes to
+   the eventfd, so it may be called from a signal handler. */
+void carmen_laser_message_queue_interrupt(carmen_laser_message_queue_t* queue);
 int carmen_laser_message_queue_wait_get(carmen_laser_message_queue_t* queue, carmen_laser_laser_static_message* message);
 #endif
 
@@ -82,8 +82,8 @@ int carmen_sick_handle(carmen_laser_device_t* device){
 	reply=sick_wait_packet_ts(sick, buffer, &timestamp);
 	if (! reply)
 		return 0;
-	int sec=timestamp.tv_sec=oldTime.tv_sec;
-	int usec=timestamp.tv_usec=oldTime.tv_usec;
+	int sec=timestamp.tv_sec-oldTime.tv_sec;
+	int usec=timestamp.tv_usec-oldTime.tv_usec;
 	double dt=sec+1e-6*usec;
 	if (timestampingReconstruction){
 	  double ett=timeTolerance/expectedPeriod;
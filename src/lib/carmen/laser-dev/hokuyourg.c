@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include "hokuyourg.h"
 #include <string.h>
 #include <fcntl.h>
@@ -92,36 +93,28 @@ void hokuyo_parseReading(HokuyoRangeReading* r, char* buffer){
 
 
 
+//packets end with an empty line
+int hokuyo_framePacket(const unsigned char* data, int size, void* check_data __attribute__((unused))){
+  const unsigned char* end=memmem(data, size, "\n\n", 2);
+  return end ? end-data+2 : 0;
+}
+
 unsigned int hokuyo_readPacket(HokuyoURG* urg, char* buf, int bufsize, int faliures){
-  int failureCount=faliures;
-  int i;
+  unsigned char* packet;
+  int size;
   if (urg->fd<=0){
     fprintf(stderr, "Invalid urg->fd\n");
     return -1;
   }
 
-  memset(buf, 0, bufsize);
-  int wasLineFeed=0;
-  char* b=buf;
-  while (1){
-    int c=read(urg->fd, b, bufsize);
-    if (! c){
-      fprintf(stderr, "null" );
-      usleep(25000);
-      failureCount--;
-    }else {
-      for (i=0; i<c; i++){
-	if (wasLineFeed && b[i]=='\n'){
-	  b++;
-	  return b-buf;
-	}
-	wasLineFeed=(b[i]=='\n');
-      }
-      b+=c;
-    }
-    if (failureCount<0)
-      return 0;
-  }
+  size=carmen_laser_framer_next(&urg->framer, hokuyo_framePacket, NULL, &packet, &urg->packetTime, 25000*(faliures+1));
+  if (size<=0)
+    return 0;
+  if (size>bufsize-1)
+    size=bufsize-1;
+  memcpy(buf, packet, size);
+  buf[size]=0;
+  return size;
 }
 
 unsigned int hokuyo_readStatus(HokuyoURG* urg, char* cmd){
@@ -154,6 +147,7 @@ int hokuyo_open(HokuyoURG* urg, const char* filename){
   urg->isInitialized=0;
   urg->isContinuous=0;
   urg->fd=open(filename, O_RDWR| O_NOCTTY | O_SYNC);
+  carmen_laser_framer_init(&urg->framer, urg->fd);
   return urg->fd;
 }
 
@@ -3,6 +3,7 @@
 
 /* needed for new carmen_inline def for gcc >= 4.3 */
 #include "global.h"
+#include "carmen_laser_framer.h"
 
 
 //#define HOKUYO_ALWAYS_IN_SCIP20
@@ -24,6 +25,9 @@ typedef struct HokuyoURG{
   int isProtocol2;
   int isContinuous;
   int isInitialized;
+  // arrival of the last packet read
+  struct timeval packetTime;
+  carmen_laser_framer_t framer;
 } HokuyoURG;
 
 // opens the urg, returns <=0 on failure
@@ -33,7 +37,7 @@ int hokuyo_open(HokuyoURG* urg, const char* filename);
 // returns <=0 on failure
 int hokuyo_init(HokuyoURG* urg);
 
-// reads a packet into the buffer
+// reads a packet into the buffer, NUL terminated
 unsigned int hokuyo_readPacket(HokuyoURG* urg, char* buf, int bufsize, int faliures);
 
 // starts the continuous mode
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <pthread.h>
 
 #include "global.h"
 
@@ -18,6 +19,9 @@
 #define CRC16_GEN_POL0                   0x80
 #define CRC16_GEN_POL1                   0x05
 
+#define SICK_MAX_PACKET_SIZE             1024
+#define SICK_READ_TIMEOUT                250000
+
 #ifdef USE_TCP862
 #include <carmen/tcp862.h>
 #define serial_configure(_fd, _baudrate, _parity) tcp862_setBaud(_fd,_baudrate)
@@ -106,24 +110,83 @@ carmen_inline unsigned char* sick_format_uint32(unsigned char* buf, unsigned int
 //END  command formatting
 
 //BEGIN communication facilities
-static unsigned short sick_compute_checksum(unsigned char *CommData, int uLen)
-{
-  unsigned char abData[2] = {0, 0};
-  unsigned short uCrc16=0;
-  
-  while(uLen--) {
-    abData[1]=abData[0];
-    abData[0] = *CommData++;
-    if(uCrc16 & 0x8000) {
-      uCrc16=(uCrc16&0x7fff)<<1;
-      uCrc16^=CRC16_GEN_POL;
-    } 
-    else {
-      uCrc16<<=1;
+/* The checksum of the SICK is not a plain CRC: the CRC register is
+   shifted once per byte and xored with the last two bytes. Both are
+   linear, so eight bytes are folded in at once with a table per byte
+   position (slice-by-8). */
+
+static unsigned short sick_crc_shift(unsigned short crc){
+  if (crc & 0x8000)
+    return ((crc&0x7fff)<<1)^CRC16_GEN_POL;
+  return crc<<1;
+}
+
+static unsigned short sick_crc_shift_n(unsigned short crc, int n){
+  while (n--)
+    crc=sick_crc_shift(crc);
+  return crc;
+}
+
+// sick_crc_table[j][b]: byte b at position j of a block of eight
+// sick_crc_table[8][b], [9][b]: the register after the block, from its
+// high and low byte before
+// sick_crc_table[10][b]: the byte before the block
+static unsigned short sick_crc_table[11][256];
+static pthread_once_t sick_crc_once=PTHREAD_ONCE_INIT;
+
+static void sick_crc_init(void){
+  int j, b;
+  for (b=0; b<256; b++){
+    for (j=0; j<8; j++){
+      sick_crc_table[j][b]=sick_crc_shift_n(b, 7-j);
+      if (j<7)
+	sick_crc_table[j][b]^=sick_crc_shift_n(b<<8, 6-j);
     }
-    uCrc16^=sick_parse_uint16(abData);
+    sick_crc_table[8][b]=sick_crc_shift_n(b<<8, 8);
+    sick_crc_table[9][b]=sick_crc_shift_n(b, 8);
+    sick_crc_table[10][b]=sick_crc_shift_n(b<<8, 7);
   }
-  return uCrc16;
+}
+
+unsigned short sick_compute_checksum(const unsigned char *data, int size)
+{
+  unsigned short crc=0;
+  unsigned char last=0;
+
+  pthread_once(&sick_crc_once, sick_crc_init);
+  for (; size>=8; size-=8, data+=8){
+    crc=sick_crc_table[8][crc>>8]^sick_crc_table[9][crc&0xff]^sick_crc_table[10][last]^
+      sick_crc_table[0][data[0]]^sick_crc_table[1][data[1]]^
+      sick_crc_table[2][data[2]]^sick_crc_table[3][data[3]]^
+      sick_crc_table[4][data[4]]^sick_crc_table[5][data[5]]^
+      sick_crc_table[6][data[6]]^sick_crc_table[7][data[7]];
+    last=data[7];
+  }
+  while (size--){
+    crc=sick_crc_shift(crc)^((last<<8)|*data);
+    last=*data++;
+  }
+  return crc;
+}
+
+int sick_frame_packet(const unsigned char* data, int size, void* check_data __attribute__((unused))){
+  const unsigned char* stx;
+  unsigned int packet_size;
+
+  if (data[0]!=STX){
+    stx=memchr(data, STX, size);
+    return stx ? -(stx-data) : -size;
+  }
+  if (size<4)
+    return 0;
+  packet_size=sick_parse_uint16((unsigned char*)data+2);
+  if (packet_size>SICK_MAX_PACKET_SIZE)
+    return -1;
+  if (size<(int)packet_size+6)
+    return 0;
+  if (sick_compute_checksum(data, packet_size+4)!=sick_parse_uint16((unsigned char*)data+packet_size+4))
+    return -1;
+  return packet_size+6;
 }
 
 //tries to synchronize with a packet
@@ -132,7 +195,7 @@ int sick_wait_ack(sick_laser_t* sick,  int max_retries){
   unsigned char c;
   ; //printf("Wait for ack...  ");
   while (j<max_retries){
-    int val=serial_readn(sick->fd, &c, 1);
+    int val=carmen_laser_framer_read_byte(&sick->framer, &c, SICK_READ_TIMEOUT);
     if(val>0){
       if (c==ACK){
 	//printf("OK\n");
@@ -149,64 +212,22 @@ int sick_wait_ack(sick_laser_t* sick,  int max_retries){
   return 0;
 }
 
+// bytes that are not part of a telegram with a valid checksum are skipped
 int sick_wait_packet_ts(sick_laser_t* sick, unsigned char* reply, struct timeval *tv ){
-  unsigned char tempBuf[8192];
-  unsigned char*t=tempBuf;
-  unsigned int packet_size=0;
-  unsigned char checksum[3];
-  unsigned short s_checksum=0;
-  unsigned short computed_checksum=0;
-  int header_found=0;
-  int val=0;
-  int maxchars=2048;
-  int chars=0;
-  while (! header_found && chars<maxchars){
-    t=tempBuf;
-    val=serial_readn(sick->fd, t, 1);
-    //printf("%02x \n", *t);
-    if (val<=0){
-      return 0;
-    }
-    if (*t==STX){
-      t++;
-      header_found=1;
-      if (tv){
-	gettimeofday(tv, NULL);
-      }
-      //fprintf(stderr,"H");
-    }
-    chars++;
-  }
-  val=serial_readn(sick->fd, t, 3); 
-  if (val<=0)
-    return 0;
-  t+=val;
-  packet_size=sick_parse_uint16(tempBuf+2);
-  //fprintf (stderr,"[%d]",(int)packet_size);
-  if (packet_size>1024){
-    //fprintf(stderr,"A");
-    return 0;
-  }
-  val=serial_readn(sick->fd, t, packet_size);
-  if (val<=0)
-    return 0;
-  //printf ("val=%d\n",val);
-  t+=packet_size;
-  val=serial_readn(sick->fd, checksum, 2);
-  if (val<=0)
+  unsigned char* packet;
+  struct timeval arrival;
+  int size;
+
+  size=carmen_laser_framer_next(&sick->framer, sick_frame_packet, NULL, &packet, &arrival, SICK_READ_TIMEOUT);
+  if (size<=0)
     return 0;
-  s_checksum=sick_parse_uint16(checksum);
-
-  computed_checksum=sick_compute_checksum(tempBuf,t-tempBuf);
-  //printf("buffer= %d\n",t-tempBuf);
-  if (computed_checksum==s_checksum){
-    memcpy(reply,tempBuf,t-tempBuf);
-    //printf ("size=%d, returned=%d\n",(int)packet_size, t-tempBuf);
-    gettimeofday(&sick->last_packet_time, NULL);
-    return t-tempBuf;
-  }
-  fprintf (stderr, " checksum error ");
-  return 0;
+  //the checksum is not returned
+  size-=2;
+  memcpy(reply, packet, size);
+  sick->last_packet_time=arrival;
+  if (tv)
+    *tv=arrival;
+  return size;
 }
 
 int sick_wait_packet(sick_laser_t* sick, unsigned char* reply){
@@ -215,30 +236,11 @@ int sick_wait_packet(sick_laser_t* sick, unsigned char* reply){
 
 
 int sick_dump_output(sick_laser_t* sick, int max_retries){
-  struct timeval t;
-  fd_set set;
   int j=0;
 
-  char buf[1024];
-
-  t.tv_sec = 1;
-  t.tv_usec = 0;
-  FD_ZERO(&set);
-  FD_SET(sick->fd, &set);
-	
   while (j<max_retries){
-    int sv = select(sick->fd + 1, &set, NULL, NULL, &t);
-    if (sv){
-      int val=read(sick->fd, buf, 1024);
-      int i=0;
-      while(val>0){
-	; //printf("%02x ", (int)(buf[i]));
-	i++;
-	val--;
-      }
-    } else {
-      ; //printf("timeout\n");
-    }
+    carmen_laser_framer_fill(&sick->framer, 1000000);
+    carmen_laser_framer_clear(&sick->framer);
     j++;
   }
   return 0;
@@ -349,6 +351,7 @@ int sick_test_baudrate(sick_laser_t* sick, int max_retries){
 #ifdef USE_TCP862
     tcp862_setBaud(sick->fd,baudrates[i]);
 #endif
+    carmen_laser_framer_clear(&sick->framer);
     fprintf (stderr, "%d ", baudrates[i]);
     while(j<max_retries){
       j++;
@@ -713,6 +716,7 @@ int sick_connect(sick_laser_t* sick, char* filename, int baudrate){
   //fprintf(stderr,"Serial Configured\n");
   
   serial_ClearInputBuffer(sick->fd);
+  carmen_laser_framer_init(&sick->framer, sick->fd);
   
   fprintf(stderr,"  Querying baudrate ................ ");
   currentbrate=sick_test_baudrate(sick, 8);
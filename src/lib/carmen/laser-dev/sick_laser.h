@@ -2,6 +2,8 @@
 #define __SICK_LASER_H__
 #include <sys/select.h>
 
+#include "carmen_laser_framer.h"
+
 typedef struct sick_laser_t{
   unsigned char password[8];
   char filename[1024];
@@ -19,6 +21,7 @@ typedef struct sick_laser_t{
   unsigned char lms_configuration[100];
   int lms_conf_size;
   struct timeval last_packet_time;
+  carmen_laser_framer_t framer;
 } sick_laser_t;
 
 int sick_connect(sick_laser_t* sick, char* filename, int baudrate);
@@ -33,6 +36,11 @@ int sick_wait_packet(sick_laser_t* sick, unsigned char* reply);
 
 int sick_wait_packet_ts(sick_laser_t* sick, unsigned char* reply, struct timeval *tv);
 
+unsigned short sick_compute_checksum(const unsigned char *data, int size);
+
+// carmen_laser_framer_check_t for telegrams: STX, address, length, data, CRC
+int sick_frame_packet(const unsigned char* data, int size, void* check_data);
+
 unsigned char sick_parse_measurement(
 	sick_laser_t* sick __attribute__((unused)),
 	unsigned int* offset,
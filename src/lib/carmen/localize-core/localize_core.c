@@ -200,9 +200,32 @@ carmen_localize_particle_filter_new(carmen_localize_param_p param)
 
   filter->param->laser_skip = 0; /* will be automatically initialized later on */
 
+  carmen_localize_seed_filter(filter, 
+			      ((unsigned long long)rand() << 31) ^ rand());
+
   return filter;
 }
 
+void
+carmen_localize_particle_filter_free(carmen_localize_particle_filter_p filter)
+{
+  int i;
+
+  for(i = 0; i < filter->param->num_particles; i++) 
+    free(filter->temp_weights[i]);  
+  free(filter->temp_weights);
+  free(filter->particles);
+  free(filter->motion_noise);
+  free(filter);
+}
+
+void
+carmen_localize_seed_filter(carmen_localize_particle_filter_p filter,
+			    unsigned long long seed)
+{
+  carmen_random_seed(&filter->rng, seed);
+}
+
 void carmen_localize_initialize_particles_uniform(carmen_localize_particle_filter_p filter,
 						  carmen_robot_laser_message *laser,
 						  carmen_localize_map_p map)
@@ -257,12 +280,14 @@ void carmen_localize_initialize_particles_uniform(carmen_localize_particle_filte
       carmen_ipc_sleep(0.001);
     }
     do {
-      point.x = carmen_uniform_random(0, map->config.x_size - 1);
-      point.y = carmen_uniform_random(0, map->config.y_size - 1);
+      point.x = carmen_random_uniform(&filter->rng, 0, 
+				      map->config.x_size - 1);
+      point.y = carmen_random_uniform(&filter->rng, 0, 
+				      map->config.y_size - 1);
     } while(map->carmen_map.map[(int)point.x][(int)point.y] > 
 	    filter->param->occupied_prob ||
 	    map->carmen_map.map[(int)point.x][(int)point.y] == -1);
-    point.theta = carmen_uniform_random(-M_PI, M_PI);
+    point.theta = carmen_random_uniform(&filter->rng, -M_PI, M_PI);
   
     prob = 0.0;
     ctheta = cos(point.theta);
@@ -344,10 +369,10 @@ void carmen_localize_initialize_particles_gaussians(carmen_localize_particle_fil
       end = (i + 1) * each;
 
     for(j = start; j < end; j++) {
-      x = carmen_gaussian_random(mean[i].x, std[i].x);
-      y = carmen_gaussian_random(mean[i].y, std[i].y);
-      theta = carmen_normalize_theta(carmen_gaussian_random(mean[i].theta, 
-							    std[i].theta));
+      x = carmen_random_gaussian(&filter->rng, mean[i].x, std[i].x);
+      y = carmen_random_gaussian(&filter->rng, mean[i].y, std[i].y);
+      theta = carmen_normalize_theta
+	(carmen_random_gaussian(&filter->rng, mean[i].theta, std[i].theta));
       filter->particles[j].x = x;
       filter->particles[j].y = y;
       filter->particles[j].theta = theta;
@@ -435,7 +460,9 @@ void carmen_localize_incorporate_odometry(carmen_localize_particle_filter_p filt
   double delta_t, delta_theta;
   double dx, dy, odom_theta;
 #ifndef OLD_MOTION_MODEL
-  double downrange, crossrange, turn;
+  double *downrange, *crossrange, *turn;
+  double direction, angle, cos_angle, sin_angle;
+  int num_particles;
 #else
   double dr1, dr2;
   double dhatr1, dhatt, dhatr2;
@@ -461,32 +488,35 @@ void carmen_localize_incorporate_odometry(carmen_localize_particle_filter_p filt
   filter->distance_travelled += delta_t;
 
 #ifndef OLD_MOTION_MODEL
-  for(i = 0; i < filter->param->num_particles; i++) {
-    downrange = 
-      carmen_localize_sample_noisy_downrange(delta_t, delta_theta, 
-					     filter->param->motion_model);
-    crossrange = 
-      carmen_localize_sample_noisy_crossrange(delta_t, delta_theta,
-					      filter->param->motion_model);
-    turn = carmen_localize_sample_noisy_turn(delta_t, delta_theta,
-					     filter->param->motion_model);
-
-    if(backwards) {
-      filter->particles[i].x -= downrange * 
-	cos(filter->particles[i].theta + turn/2.0) + 
-	crossrange * cos(filter->particles[i].theta + turn/2.0 + M_PI/2.0);
-      filter->particles[i].y -= downrange * 
-	sin(filter->particles[i].theta + turn/2.0) + 
-	crossrange * sin(filter->particles[i].theta + turn/2.0 + M_PI/2.0);
-    } else {
-      filter->particles[i].x += downrange * 
-	cos(filter->particles[i].theta + turn/2.0) + 
-      crossrange * cos(filter->particles[i].theta + turn/2.0 + M_PI/2.0);
-      filter->particles[i].y += downrange * 
-	sin(filter->particles[i].theta + turn/2.0) + 
-      crossrange * sin(filter->particles[i].theta + turn/2.0 + M_PI/2.0);
-    }
-    filter->particles[i].theta = carmen_normalize_theta(filter->particles[i].theta+turn);
+  /* draw the noise for all particles at once */
+  num_particles = filter->param->num_particles;
+  if (filter->motion_noise_size < 3 * num_particles) {
+    filter->motion_noise_size = 3 * num_particles;
+    filter->motion_noise = (double *)
+      realloc(filter->motion_noise, 
+	      filter->motion_noise_size * sizeof(double));
+    carmen_test_alloc(filter->motion_noise);
+  }
+  downrange = filter->motion_noise;
+  crossrange = downrange + num_particles;
+  turn = crossrange + num_particles;
+  carmen_localize_sample_noisy_motions(delta_t, delta_theta, 
+				       filter->param->motion_model,
+				       &filter->rng, num_particles,
+				       downrange, crossrange, turn);
+
+  /* crossrange is along theta + turn/2 + M_PI/2 */
+  direction = backwards ? -1.0 : 1.0;
+  for(i = 0; i < num_particles; i++) {
+    angle = filter->particles[i].theta + turn[i]/2.0;
+    cos_angle = cos(angle);
+    sin_angle = sin(angle);
+    filter->particles[i].x += direction *
+      (downrange[i] * cos_angle - crossrange[i] * sin_angle);
+    filter->particles[i].y += direction *
+      (downrange[i] * sin_angle + crossrange[i] * cos_angle);
+    filter->particles[i].theta = 
+      carmen_normalize_theta(filter->particles[i].theta+turn[i]);
   }
 #else
  /* The dr1/dr2 code becomes unstable if delta_t is too small. */
@@ -519,9 +549,9 @@ void carmen_localize_incorporate_odometry(carmen_localize_particle_filter_p filt
 
   /* update the positions of all of the particles */
   for(i = 0; i < filter->param->num_particles; i++) {
-    dhatr1 = carmen_gaussian_random(dr1, std_r1);
-    dhatt = carmen_gaussian_random(delta_t, std_t);
-    dhatr2 = carmen_gaussian_random(dr2, std_r2);
+    dhatr1 = carmen_random_gaussian(&filter->rng, dr1, std_r1);
+    dhatt = carmen_random_gaussian(&filter->rng, delta_t, std_t);
+    dhatr2 = carmen_random_gaussian(&filter->rng, dr2, std_r2);
     
     if(backwards) {
       filter->particles[i].x -=
@@ -739,7 +769,7 @@ void carmen_localize_resample(carmen_localize_particle_filter_p filter)
   }
 
   /* choose random starting position for low-variance walk */
-  position = carmen_uniform_random(0, weight_sum);
+  position = carmen_random_uniform(&filter->rng, 0, weight_sum);
   step_size = weight_sum / (float)filter->param->num_particles;
   which_particle = 0;
   
@@ -94,6 +94,9 @@ typedef struct {
   float **temp_weights;
   float distance_travelled;
   char laser_mask[MAX_BEAMS_PER_SCAN];
+  carmen_random_t rng;
+  double *motion_noise;
+  int motion_noise_size;
 } carmen_localize_particle_filter_t, *carmen_localize_particle_filter_p;
 
 typedef struct {
@@ -118,6 +121,16 @@ typedef struct {
 carmen_localize_particle_filter_p 
 carmen_localize_particle_filter_new(carmen_localize_param_p param);
 
+/** Free a particle filter (but not its parameters) **/
+void
+carmen_localize_particle_filter_free(carmen_localize_particle_filter_p filter);
+
+/** Restart the random stream of a filter. Filters are seeded from rand()
+    when they are created, so runs are repeatable with --seed. **/
+void
+carmen_localize_seed_filter(carmen_localize_particle_filter_p filter,
+			    unsigned long long seed);
+
 /** Creates a distribution of particles over the map based on the given observation 
  *
  *  @param filter Particle filter structure the function is applied to.
@@ -129,3 +129,44 @@ double carmen_localize_sample_noisy_turn(double delta_t, double delta_theta,
 
   return sample;
 }
+
+/* Gaussians truncated at two standard deviations, like the single
+   samples above. */
+static void sample_truncated(double mean, double std_dev, carmen_random_p rng,
+			     int num_samples, double *samples)
+{
+  int i;
+
+  if (std_dev < 1e-6) {
+    for (i = 0; i < num_samples; i++)
+      samples[i] = mean;
+    return;
+  }
+
+  carmen_random_gaussians(rng, samples, num_samples);
+  for (i = 0; i < num_samples; i++) {
+    while (fabs(samples[i]) > 2.0)
+      samples[i] = carmen_random_gaussian(rng, 0.0, 1.0);
+    samples[i] = mean + std_dev * samples[i];
+  }
+}
+
+void carmen_localize_sample_noisy_motions(double delta_t, double delta_theta,
+					  carmen_localize_motion_model_t *model,
+					  carmen_random_p rng, int num_samples,
+					  double *downrange, double *crossrange,
+					  double *turn)
+{
+  sample_truncated(delta_t*model->mean_d_d+delta_theta*model->mean_d_t,
+		   fabs(delta_t)*model->std_dev_d_d+
+		   fabs(delta_theta)*model->std_dev_d_t,
+		   rng, num_samples, downrange);
+  sample_truncated(delta_t*model->mean_c_d+delta_theta*model->mean_c_t,
+		   fabs(delta_t)*model->std_dev_c_d+
+		   fabs(delta_theta)*model->std_dev_c_t,
+		   rng, num_samples, crossrange);
+  sample_truncated(delta_t*model->mean_t_d+delta_theta*model->mean_t_t,
+		   fabs(delta_t)*model->std_dev_t_d+
+		   fabs(delta_theta)*model->std_dev_t_t,
+		   rng, num_samples, turn);
+}
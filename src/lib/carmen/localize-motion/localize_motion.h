@@ -40,6 +40,8 @@
 #ifndef CARMEN_LOCALIZE_MOTION_H
 #define CARMEN_LOCALIZE_MOTION_H
 
+#include "global.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -75,6 +77,15 @@ double carmen_localize_sample_noisy_turn(double delta_t,
 					 double delta_theta,
 					 carmen_localize_motion_model_t *model);
 
+/** Draws num_samples downrange, crossrange and turn samples at once from
+    rng, with the same distributions as the functions above. **/
+void carmen_localize_sample_noisy_motions(double delta_t, 
+					  double delta_theta,
+					  carmen_localize_motion_model_t *model,
+					  carmen_random_p rng, int num_samples,
+					  double *downrange, double *crossrange,
+					  double *turn);
+
 #ifdef __cplusplus
 }
 #endif
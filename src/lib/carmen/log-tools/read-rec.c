@@ -38,11 +38,16 @@
 #include <ctype.h>
 #include <fnmatch.h>
 
+#include "global.h"
+#include "readlog.h"
+
 #include "logtools.h"
 
 #include "logtool_defines.h"
 #include "logtool_internal.h"
 
+static int load_columnar_file( char *filename, logtools_log_data_t *rec );
+
 int
 logtools_read_logfile( logtools_log_data_t * rec, char * filename )
 {
@@ -50,7 +55,12 @@ logtools_read_logfile( logtools_log_data_t * rec, char * filename )
   char               fname[MAX_NAME_LENGTH];
 
     fprintf( stderr, "#####################################################################\n" );
-  if ( !fnmatch( "script:*", filename, 0) ) {
+  if ( carmen_collog_file_is_columnar( filename ) ) {
+    fprintf( stderr, "# INFO: read columnar carmen-file-type!\n" );
+    if (load_columnar_file( filename, rec ) !=0 )
+      return(FALSE);
+    return(TRUE);
+  } else if ( !fnmatch( "script:*", filename, 0) ) {
     fprintf( stderr, "# INFO: use script-file-type!\n" );
     strncpy( fname, &(filename[7]), MAX_NAME_LENGTH );
     inp_type = SCRIPT;
@@ -162,13 +172,68 @@ read_rec2d_file( char *filename, logtools_log_data_t *rec,  int mode )
 }
 
 
+static void
+allocate_rec_data( logtools_log_data_t *rec, int posctr, int laserctr,
+		   int gpsctr, int markerctr, int wifictr )
+{
+  int       numEntries;
+
+  numEntries =
+    posctr +
+    laserctr +
+    gpsctr +
+    markerctr +
+    wifictr + 1;
+
+  rec->numentries = 0;
+
+  rec->entry   =
+    (logtools_entry_position_t *) malloc( numEntries * sizeof(logtools_entry_position_t) );
+
+  if (posctr>0) {
+    rec->psens =
+      (logtools_possens2_data_t *) malloc( posctr * sizeof(logtools_possens2_data_t) );
+  } else
+    rec->psens = NULL;
+
+  if (laserctr>0)
+    rec->lsens =
+      (logtools_lasersens2_data_t *) malloc( laserctr * sizeof(logtools_lasersens2_data_t) );
+  else
+    rec->lsens = NULL;
+
+  if (gpsctr>0)
+    rec->gps =
+      (logtools_gps_data_t *) malloc( gpsctr * sizeof(logtools_gps_data_t) );
+  else
+    rec->gps = NULL;
+
+  if (markerctr>0)
+    rec->marker =
+      (logtools_marker_data_t *) malloc( markerctr * sizeof(logtools_marker_data_t) );
+  else
+    rec->marker = NULL;
+
+  if (wifictr>0)
+    rec->wifi =
+      (logtools_wifi_data_t *) malloc( wifictr * sizeof(logtools_wifi_data_t) );
+  else
+    rec->wifi = NULL;
+
+  rec->numpositions    = 0;
+  rec->numlaserscans   = 0;
+  rec->numgps          = 0;
+  rec->nummarkers      = 0;
+  rec->numwifi         = 0;
+}
+
 int
 load_rec2d_file( char *filename, logtools_log_data_t *rec,
 		 enum logtools_file_t type, int mode )
 {
 
   char      line[MAX_LINE_LENGTH];
-  int       FEnd, numPos, numScan;
+  int       FEnd;
   char      dummy[MAX_CMD_LENGTH];
   char      command[MAX_CMD_LENGTH];
   char    * sptr, * iline, * lptr;
@@ -177,7 +242,6 @@ load_rec2d_file( char *filename, logtools_log_data_t *rec,
   int       posctr = 0;
   int       laserctr = 0;
   int       gpsctr = 0;
-  int       numEntries = 0;
   int       markerctr = 0;
   int       wifictr = 0;
 
@@ -338,63 +402,13 @@ load_rec2d_file( char *filename, logtools_log_data_t *rec,
       fprintf( stderr, "# found %d wifi\n", wifictr );
   }
 
-  numEntries =
-    posctr +
-    laserctr +
-    gpsctr +
-    markerctr +
-    wifictr + 1;
-
-  rec->numentries = 0;
-
-  rec->entry   =
-    (logtools_entry_position_t *) malloc( numEntries * sizeof(logtools_entry_position_t) );
-
   rewind(iop);
 
-  if (posctr>0) {
-    rec->psens =
-      (logtools_possens2_data_t *) malloc( posctr * sizeof(logtools_possens2_data_t) );
-  } else
-    rec->psens = NULL;
-
-  if (laserctr>0)
-    rec->lsens =
-      (logtools_lasersens2_data_t *) malloc( laserctr * sizeof(logtools_lasersens2_data_t) );
-  else
-    rec->lsens = NULL;
-
-  if (gpsctr>0)
-    rec->gps =
-      (logtools_gps_data_t *) malloc( gpsctr * sizeof(logtools_gps_data_t) );
-  else
-    rec->gps = NULL;
-
-  if (markerctr>0)
-    rec->marker =
-      (logtools_marker_data_t *) malloc( markerctr * sizeof(logtools_marker_data_t) );
-  else
-    rec->marker = NULL;
-
-  if (wifictr>0)
-    rec->wifi =
-      (logtools_wifi_data_t *) malloc( wifictr * sizeof(logtools_wifi_data_t) );
-  else
-    rec->wifi = NULL;
-
-  numScan    = 0;
-  numPos     = 0;
-
-  rec->numpositions    = 0;
-  rec->numlaserscans   = 0;
-  rec->numgps          = 0;
-  rec->nummarkers      = 0;
-  rec->numwifi         = 0;
+  allocate_rec_data( rec, posctr, laserctr, gpsctr, markerctr, wifictr );
 
   FEnd    = 0;
   linectr = 0;
 
-
   switch (rec->info.system) {
 
   case REC:
@@ -467,3 +481,59 @@ load_rec2d_file( char *filename, logtools_log_data_t *rec,
   return(0);
 }
 
+/***********************************************************************/
+/*                                                                     */
+/*   columnar carmen logs are read line by line through readlog        */
+/*                                                                     */
+/***********************************************************************/
+
+static int
+load_columnar_file( char *filename, logtools_log_data_t *rec )
+{
+  carmen_FILE             * infile;
+  carmen_logfile_index_p    index;
+  char                      line[MAX_LINE_LENGTH];
+  const char              * command;
+  int                       i;
+  int                       posctr = 0;
+  int                       laserctr = 0;
+  int                       markerctr = 0;
+
+  fprintf( stderr, "# read file %s ...\n", filename );
+  if ((infile = carmen_fopen( filename, "r")) == NULL){
+    fprintf(stderr, "# WARNING: no file %s\n", filename );
+    return(-1);
+  }
+
+  rec->info.system = CARMEN;
+
+  index = carmen_logfile_index_messages( infile );
+  /* the message types come from the block table of the log, so
+     counting does not decompress any block */
+  for (i=0; i<index->num_messages; i++) {
+    command = carmen_collog_message_type( index->columnar, i );
+    if (!strcmp( command, "ODOM")) {
+      posctr++;
+    } else if (!strcmp( command, "FLASER") ||
+	       !strcmp( command, "RAWLASER1") ||
+	       !strcmp( command, "ROBOTLASER1") ||
+	       !strcmp( command, "ROBOTLASER2") ||
+	       !strcmp( command, "RLASER") ){
+      laserctr++;
+    } else if (!strcmp( command, "MARKER")) {
+      markerctr++;
+    }
+  }
+
+  allocate_rec_data( rec, posctr, laserctr, 0, markerctr, 0 );
+
+  for (i=0; i<index->num_messages; i++) {
+    carmen_logfile_read_line( index, infile, i, MAX_LINE_LENGTH, line );
+    if (!carmen_parse_line( line, rec, TRUE, TRUE ))
+      break;
+  }
+
+  carmen_logfile_free_index( &index );
+  carmen_fclose( infile );
+  return(0);
+}
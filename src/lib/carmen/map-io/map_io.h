@@ -32,6 +32,7 @@
 #include "carmen_stdio.h"
 #include "map.h"
 #include "map_interface.h"
+#include "map_util.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,6 +50,7 @@ extern "C" {
 #define CARMEN_MAP_CREATOR_CHUNK     32
 #define CARMEN_MAP_GLOBAL_OFFSET_CHUNK     64
 #define CARMEN_MAP_HMAP_CHUNK        3
+#define CARMEN_MAP_COMPACT_GRIDMAP_CHUNK  5
 
 #define CARMEN_MAP_NAMED_CHUNK_FLAG (1 << 7)
 #define CARMEN_MAP_CHUNK_IS_NAMED(type) ((type) & CARMEN_MAP_NAMED_CHUNK_FLAG)
@@ -82,6 +84,8 @@ int carmen_map_write_gridmap_chunk(carmen_FILE *fp, float **prob,
 int carmen_map_write_named_gridmap_chunk(carmen_FILE *fp, char *name, 
 					 float **prob, int size_x, int size_y,
 					 double resolution);
+int carmen_map_write_compact_gridmap_chunk(carmen_FILE *fp, 
+					   carmen_compact_map_p map);
 int carmen_map_write_places_chunk(carmen_FILE *fp, carmen_place_p places, 
 				  int num_places);
 int carmen_map_write_named_places_chunk(carmen_FILE *fp, char *name,
@@ -106,12 +110,20 @@ int carmen_map_write_named_global_offset_chunk(carmen_FILE *fp, char *name,
 
 int carmen_map_write_hmap_chunk(carmen_FILE *fp, carmen_hmap_p hmap);
 
+/* Pyramid levels 1 and up are stored as named gridmap chunks called
+   "<name>:<level>"; level 0 is the map's own gridmap. */
+#define CARMEN_MAP_PYRAMID_CHUNK_NAME "%s:%d"
+
+int carmen_map_write_pyramid_chunks(carmen_FILE *fp, char *name,
+				    carmen_map_pyramid_p pyramid);
+
 int carmen_map_write_to_ppm(carmen_map_p map, char *output_filename);
 
 int carmen_map_chunk_exists(char *filename, int specific_chunk);
 int carmen_map_named_chunk_exists(char *filename, int specific_chunk, 
 				  char *name);
 int carmen_map_advance_to_chunk(carmen_FILE *fp, int specific_chunk);
+int carmen_map_advance_to_unnamed_chunk(carmen_FILE *fp, int specific_chunk);
 int carmen_map_advance_to_named_chunk(carmen_FILE *fp, int specific_chunk, 
 				      char *name);
 int carmen_map_read_creator_chunk(char *filename, time_t *creation_time, 
@@ -126,6 +138,10 @@ int carmen_map_read_named_gridmap_config(char *filename, char *chunk_name,
 int carmen_map_read_gridmap_chunk(char *filename, carmen_map_p map);
 int carmen_map_read_named_gridmap_chunk(char *filename, char *chunk_name, 
 					carmen_map_p map);
+/* A map file may hold a compact gridmap instead of the float one; the
+   gridmap config and chunk readers above fall back to it. */
+int carmen_map_read_compact_gridmap_chunk(char *filename, 
+					  carmen_compact_map_p *map);
 int carmen_map_read_offlimits_chunk(char *filename, 
 				    carmen_offlimits_p *offlimits_list,
 				    int *list_length);
@@ -151,6 +167,8 @@ int carmen_map_read_named_global_offset_chunk(char *filename, char *chunk_name,
 					      *global_offset);
 
 int carmen_map_read_hmap_chunk(char *filename, carmen_hmap_p hmap);
+int carmen_map_read_pyramid_level(char *filename, char *name, int level,
+				  carmen_map_p map);
 
 int carmen_map_file(char *filename);
 int carmen_map_initialize_ipc(void);
@@ -84,6 +84,49 @@ publish_map_zone(void)
     free(msg.zone_name);
 }
 
+/* An hmap file holds one named gridmap per zone and no plain one, so
+   serve its first zone until a client changes zones. */
+static void
+select_first_zone(void)
+{
+  carmen_hmap_t hmap;
+
+  if (map_zone_name)
+    free(map_zone_name);
+  map_zone_name = NULL;
+
+  if (carmen_map_read_hmap_chunk(filename, &hmap) < 0)
+    return;
+  if (hmap.num_zones > 0)
+    map_zone_name = carmen_new_string(hmap.zone_names[0]);
+  carmen_map_free_hmap(&hmap);
+}
+
+static void
+map_zone_request_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
+			 void *clientData __attribute__ ((unused)))
+{
+  carmen_map_zone_request_message req;
+  carmen_map_zone_message msg;
+  FORMATTER_PTR formatter;
+  IPC_RETURN_TYPE err;
+
+  formatter = IPC_msgInstanceFormatter(msgRef);
+  err = IPC_unmarshallData(formatter, callData, &req,
+			   sizeof(carmen_default_message));
+  IPC_freeByteArray(callData);
+
+  carmen_test_ipc_return(err, "Could not unmarshall data",
+			 IPC_msgInstanceName(msgRef));
+
+  msg.zone_name = map_zone_name;
+  msg.timestamp = carmen_get_time();
+  msg.host = carmen_get_host();
+
+  err = IPC_respondData(msgRef, CARMEN_MAP_ZONE_NAME, &msg);
+  carmen_test_ipc(err, "Could not respond", CARMEN_MAP_ZONE_NAME);
+}
+
 static void
 change_map_zone_request_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
 				void *clientData __attribute__ ((unused)))
@@ -113,6 +156,8 @@ change_map_zone_request_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
       response.err_msg = carmen_new_string("can't find zone - %s", request.zone_name);
     else {
       response.err_msg = NULL;
+      if (map_zone_name)
+	free(map_zone_name);
       map_zone_name = carmen_new_string(request.zone_name);
       publish_map_zone();
     }
@@ -168,6 +213,39 @@ compress_map_msg(carmen_grid_map_message *map_msg, carmen_map_t *map)
 }
 #endif
 
+static void
+assemble_error_msg(carmen_grid_map_message *map_msg)
+{
+  memset(map_msg, 0, sizeof(carmen_grid_map_message));
+  map_msg->err_mesg = (char *)calloc(17, sizeof(char));
+  carmen_test_alloc(map_msg->err_mesg);
+  strcpy(map_msg->err_mesg, "Unknown error!");
+
+  map_msg->timestamp = carmen_get_time();
+  map_msg->host = carmen_get_host();
+}
+
+/* takes over map->complete_map */
+static void
+assemble_gridmap_msg(carmen_map_p map, carmen_grid_map_message *map_msg)
+{
+#ifndef NO_ZLIB
+  compress_map_msg(map_msg, map);
+#else
+  map_msg->map = (unsigned char *)map->complete_map;
+  map_msg->size = map->config.x_size * map->config.y_size*sizeof(float);
+  map_msg->compressed = 0;
+#endif
+
+  map_msg->config = map->config;
+  map_msg->err_mesg = (char *)calloc(1, sizeof(char));
+  carmen_test_alloc(map_msg->err_mesg);
+  map_msg->err_mesg[0] = '\0';
+
+  map_msg->timestamp = carmen_get_time();
+  map_msg->host = carmen_get_host();
+}
+
 static void
 assemble_named_map_msg(char *name, carmen_grid_map_message *map_msg)
 {
@@ -181,34 +259,13 @@ assemble_named_map_msg(char *name, carmen_grid_map_message *map_msg)
 
   if(ret_val < 0)
     {
-      memset(map_msg, 0, sizeof(carmen_grid_map_message));
-      map_msg->err_mesg = (char *)calloc(17, sizeof(char));
-      carmen_test_alloc(map_msg->err_mesg);
-      strcpy(map_msg->err_mesg, "Unknown error!");
-
-      map_msg->timestamp = carmen_get_time();
-      map_msg->host = carmen_get_host();
-
+      assemble_error_msg(map_msg);
       return;
     }
 
   free(map.map);
 
-#ifndef NO_ZLIB
-  compress_map_msg(map_msg, &map);
-#else
-  map_msg->map = (unsigned char *)map.complete_map;
-  map_msg->size = map.config.x_size * map.config.y_size*sizeof(float);
-  map_msg->compressed = 0;
-#endif
-
-  map_msg->config = map.config;
-  map_msg->err_mesg = (char *)calloc(1, sizeof(char));
-  carmen_test_alloc(map_msg->err_mesg);
-  map_msg->err_mesg[0] = '\0';
-
-  map_msg->timestamp = carmen_get_time();
-  map_msg->host = carmen_get_host();
+  assemble_gridmap_msg(&map, map_msg);
 }
 
 static void
@@ -269,6 +326,81 @@ named_gridmap_request_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
   free(map_msg.err_mesg);
 }
 
+/* The distance map does not depend on the robot, so it is computed
+   once per map and zone, and every client thresholds it with its own
+   footprint. */
+
+static carmen_map_t distance_map;
+
+static void
+free_distance_map(void)
+{
+  free(distance_map.complete_map);
+  free(distance_map.map);
+  memset(&distance_map, 0, sizeof(carmen_map_t));
+}
+
+static void
+assemble_distance_map_msg(carmen_grid_map_message *map_msg)
+{
+  carmen_map_t map;
+  int ret_val;
+
+  if (distance_map.complete_map == NULL) {
+    if (map_zone_name)
+      ret_val = carmen_map_read_named_gridmap_chunk(filename, map_zone_name,
+						    &distance_map);
+    else
+      ret_val = carmen_map_read_gridmap_chunk(filename, &distance_map);
+
+    if (ret_val < 0) {
+      memset(&distance_map, 0, sizeof(carmen_map_t));
+      assemble_error_msg(map_msg);
+      return;
+    }
+
+    carmen_map_util_distance_transform(&distance_map, 
+				       CARMEN_MAP_DISTANCE_FREE_THRESHOLD,
+				       &distance_map);
+  }
+
+  map.config = distance_map.config;
+  map.map = NULL;
+  map.complete_map = (float *)
+    calloc(map.config.x_size*map.config.y_size, sizeof(float));
+  carmen_test_alloc(map.complete_map);
+  memcpy(map.complete_map, distance_map.complete_map,
+	 map.config.x_size*map.config.y_size*sizeof(float));
+
+  assemble_gridmap_msg(&map, map_msg);
+}
+
+static void
+distance_map_request_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
+			     void *clientData __attribute__ ((unused)))
+{
+  carmen_distance_map_request_message req;
+  carmen_grid_map_message map_msg;
+  FORMATTER_PTR formatter;
+  IPC_RETURN_TYPE err;
+
+  formatter = IPC_msgInstanceFormatter(msgRef);
+  err = IPC_unmarshallData(formatter, callData, &req,
+			   sizeof(carmen_default_message));
+  IPC_freeByteArray(callData);
+
+  carmen_test_ipc_return(err, "Could not unmarshall data",
+			 IPC_msgInstanceName(msgRef));
+
+  assemble_distance_map_msg(&map_msg);
+
+  err = IPC_respondData(msgRef, CARMEN_MAP_DISTANCE_MAP_NAME, &map_msg);
+  carmen_test_ipc(err, "Could not respond", CARMEN_MAP_DISTANCE_MAP_NAME);
+
+  free(map_msg.map);
+  free(map_msg.err_mesg);
+}
+
 
 static void
 placelist_request_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
@@ -540,6 +672,15 @@ carmen_map_initialize_ipc(void)
 		      CARMEN_NAMED_GRIDMAP_REQUEST_FMT);
   carmen_test_ipc_exit(err, "Could not define", CARMEN_NAMED_GRIDMAP_REQUEST_NAME);
 
+  err = IPC_defineMsg(CARMEN_DISTANCE_MAP_REQUEST_NAME, IPC_VARIABLE_LENGTH,
+		      CARMEN_DEFAULT_MESSAGE_FMT);
+  carmen_test_ipc_exit(err, "Could not define", 
+		       CARMEN_DISTANCE_MAP_REQUEST_NAME);
+
+  err = IPC_defineMsg(CARMEN_MAP_DISTANCE_MAP_NAME, IPC_VARIABLE_LENGTH,
+		      CARMEN_MAP_DISTANCE_MAP_FMT);
+  carmen_test_ipc_exit(err, "Could not define", CARMEN_MAP_DISTANCE_MAP_NAME);
+
   err = IPC_defineMsg(CARMEN_PLACELIST_REQUEST_NAME, IPC_VARIABLE_LENGTH,
 		      CARMEN_DEFAULT_MESSAGE_FMT);
   carmen_test_ipc_exit(err, "Could not define", CARMEN_PLACELIST_REQUEST_NAME);
@@ -582,6 +723,11 @@ carmen_map_initialize_ipc(void)
   carmen_test_ipc(err, "Could not subscribe", CARMEN_HMAP_REQUEST_NAME);
   IPC_setMsgQueueLength(CARMEN_HMAP_REQUEST_NAME, 100);
 
+  err = IPC_subscribe(CARMEN_MAP_ZONE_REQUEST_NAME, map_zone_request_handler,
+		      NULL);
+  carmen_test_ipc(err, "Could not subscribe", CARMEN_MAP_ZONE_REQUEST_NAME);
+  IPC_setMsgQueueLength(CARMEN_MAP_ZONE_REQUEST_NAME, 100);
+
   err = IPC_subscribe(CARMEN_CHANGE_MAP_ZONE_REQUEST_NAME, change_map_zone_request_handler,
 		      NULL);
   carmen_test_ipc(err, "Could not subscribe", CARMEN_CHANGE_MAP_ZONE_REQUEST_NAME);
@@ -597,6 +743,12 @@ carmen_map_initialize_ipc(void)
   carmen_test_ipc(err, "Could not subscribe", CARMEN_NAMED_GRIDMAP_REQUEST_NAME);
   IPC_setMsgQueueLength(CARMEN_NAMED_GRIDMAP_REQUEST_NAME, 100);
 
+  err = IPC_subscribe(CARMEN_DISTANCE_MAP_REQUEST_NAME, 
+		      distance_map_request_handler, NULL);
+  carmen_test_ipc(err, "Could not subscribe", 
+		  CARMEN_DISTANCE_MAP_REQUEST_NAME);
+  IPC_setMsgQueueLength(CARMEN_DISTANCE_MAP_REQUEST_NAME, 100);
+
   err = IPC_subscribe(CARMEN_PLACELIST_REQUEST_NAME,
 		      placelist_request_handler, NULL);
   carmen_test_ipc(err, "Could not subscribe", CARMEN_PLACELIST_REQUEST_NAME);
@@ -636,6 +788,7 @@ carmen_map_publish_update(void)
   carmen_grid_map_message map_msg;
   IPC_RETURN_TYPE err;
 
+  free_distance_map();
   assemble_map_msg(&map_msg);
 
   err = IPC_publishData(CARMEN_MAP_GRIDMAP_UPDATE_NAME, &map_msg);
@@ -651,12 +804,11 @@ carmen_map_set_filename(char *new_filename)
   if (filename != NULL)
     free(filename);
 
-  map_zone_name = NULL;
-
   filename = (char *)calloc(strlen(new_filename)+1, sizeof(char));
   carmen_test_alloc(filename);
 
   strcpy(filename, new_filename);
+  select_first_zone();
   carmen_map_publish_update();
 }
 
@@ -143,12 +143,12 @@ int carmen_map_copy_comments(carmen_FILE *fp_in, carmen_FILE *fp_out)
 int carmen_map_vstrip(carmen_FILE *fp_in, carmen_FILE *fp_out,
 		      int num_chunks, ...)
 {
-  static int strip[128];
+  static int strip[256];
   int chunk_type, chunk_size, i, done = 0;
   char *buffer;
   va_list chunks;
 
-  memset(strip, 0, 128 * sizeof(int));
+  memset(strip, 0, 256 * sizeof(int));
 
   va_start(chunks, num_chunks);
   for (i = 0; i < num_chunks; i++){
@@ -324,6 +324,40 @@ int carmen_map_advance_to_chunk(carmen_FILE *fp, int specific_chunk)
   return -1;
 }
 
+/* Same as carmen_map_advance_to_chunk(), but skips named chunks, such
+   as the pyramid levels stored next to a gridmap. */
+int carmen_map_advance_to_unnamed_chunk(carmen_FILE *fp, int specific_chunk)
+{
+  int chunk_type, chunk_size, done = 0;
+
+  carmen_fseek(fp, 0, SEEK_SET);
+  if(carmen_map_read_comment_chunk(fp) < 0) {
+    fprintf(stderr, "Error: Could not read comment chunk.\n");
+    return -1;
+  }
+
+  specific_chunk &= ~(unsigned char)CARMEN_MAP_NAMED_CHUNK_FLAG;
+
+  do {
+    chunk_type = carmen_fgetc(fp);
+    if(chunk_type == EOF)
+      done = 1;
+    if(chunk_type == specific_chunk) {
+      carmen_fseek(fp, -1, SEEK_CUR);
+      return 0;
+    }
+    if(!done)
+      if(carmen_fread(&chunk_size, sizeof(int), 1, fp) < 1)
+	done = 1;
+    if(!done)
+      if(carmen_fseek(fp, chunk_size, SEEK_CUR) < 0)
+	done = 1;
+    if(!done && carmen_feof(fp))
+      done = 1;
+  } while(!done);
+  return -1;
+}
+
 int carmen_map_advance_to_named_chunk(carmen_FILE *fp, int specific_chunk,
 				      char *name)
 {
@@ -556,7 +590,11 @@ int carmen_map_read_gridmap_config(char *filename, carmen_map_config_p config)
     return -1;
   }
 
-  if(carmen_map_advance_to_chunk(fp, CARMEN_MAP_GRIDMAP_CHUNK) < 0) {
+  /* named gridmaps only if there is nothing else */
+  if(carmen_map_advance_to_unnamed_chunk(fp, CARMEN_MAP_GRIDMAP_CHUNK) < 0 &&
+     carmen_map_advance_to_unnamed_chunk(fp, 
+					 CARMEN_MAP_COMPACT_GRIDMAP_CHUNK) < 0 &&
+     carmen_map_advance_to_chunk(fp, CARMEN_MAP_GRIDMAP_CHUNK) < 0) {
     fprintf(stderr, "Error: Could not find a gridmap chunk.\n");
     fprintf(stderr, "       This file is probably not a map file.\n");
     carmen_fclose(fp);
@@ -656,6 +694,73 @@ static int carmen_map_read_gridmap_chunk_data(carmen_FILE *fp,
   return 0;
 }
 
+int carmen_map_read_compact_gridmap_chunk(char *filename, 
+					  carmen_compact_map_p *map)
+{
+  carmen_FILE *fp;
+  carmen_map_config_t config;
+  int encoding;
+  float resolution, occupied_threshold;
+
+  if(filename == NULL || map == NULL)
+    return -1;
+
+  fp = carmen_fopen(filename, "r");
+  if(fp == NULL) {
+    fprintf(stderr, "Error: could not open file %s for reading.\n",
+	    filename);
+    return -1;
+  }
+  if(carmen_map_advance_to_unnamed_chunk(fp, 
+					  CARMEN_MAP_COMPACT_GRIDMAP_CHUNK) < 0) {
+    carmen_fclose(fp);
+    return -1;
+  }
+  /* chunk type, size and description */
+  carmen_fseek(fp, 1+sizeof(int)+10, SEEK_CUR);
+
+  carmen_fread(&config.x_size, sizeof(int), 1, fp);
+  carmen_fread(&config.y_size, sizeof(int), 1, fp);
+  carmen_fread(&resolution, sizeof(float), 1, fp);
+  carmen_fread(&encoding, sizeof(int), 1, fp);
+  if(carmen_fread(&occupied_threshold, sizeof(float), 1, fp) < 1) {
+    carmen_warn("Error: Unexpected EOF.\n");
+    carmen_fclose(fp);
+    return -1;
+  }
+  config.resolution = resolution;
+  config.map_name = (char *)calloc(strlen(filename)+1, sizeof(char));
+  carmen_test_alloc(config.map_name);
+  strcpy(config.map_name, filename);
+
+  *map = carmen_map_util_new_compact_map(config, encoding, 
+					 occupied_threshold);
+  if(*map == NULL) {
+    free(config.map_name);
+    carmen_fclose(fp);
+    return -1;
+  }
+  carmen_fread((*map)->data, config.x_size*(*map)->column_bytes, 1, fp);
+
+  carmen_fclose(fp);
+  return 0;
+}
+
+static int read_gridmap_from_compact_chunk(char *filename, carmen_map_p map)
+{
+  carmen_compact_map_p compact;
+
+  if(carmen_map_read_compact_gridmap_chunk(filename, &compact) < 0) {
+    fprintf(stderr, "Error: Could not find a gridmap chunk.\n");
+    fprintf(stderr, "       This file is probably not a map file.\n");
+    return -1;
+  }
+
+  carmen_map_util_expand_compact_map(compact, map);
+  carmen_map_util_free_compact_map(compact);
+  return 0;
+}
+
 int carmen_map_read_gridmap_chunk(char *filename, carmen_map_p map)
 {
   carmen_FILE *fp;
@@ -671,11 +776,13 @@ int carmen_map_read_gridmap_chunk(char *filename, carmen_map_p map)
 	    filename);
     return -1;
   }
-  if(carmen_map_advance_to_chunk(fp, CARMEN_MAP_GRIDMAP_CHUNK) < 0) {
-    fprintf(stderr, "Error: Could not find a gridmap chunk.\n");
-    fprintf(stderr, "       This file is probably not a map file.\n");
+  /* named gridmaps only if there is nothing else */
+  if(carmen_map_advance_to_unnamed_chunk(fp, CARMEN_MAP_GRIDMAP_CHUNK) < 0 &&
+     (carmen_map_advance_to_unnamed_chunk
+      (fp, CARMEN_MAP_COMPACT_GRIDMAP_CHUNK) == 0 ||
+      carmen_map_advance_to_chunk(fp, CARMEN_MAP_GRIDMAP_CHUNK) < 0)) {
     carmen_fclose(fp);
-    return -1;
+    return read_gridmap_from_compact_chunk(filename, map);
   }
   chunk_type = carmen_fgetc(fp);
   carmen_fread(&chunk_size, sizeof(int), 1, fp);
@@ -1295,6 +1402,14 @@ int carmen_map_read_hmap_chunk(char *filename, carmen_hmap_p hmap)
   return carmen_map_read_hmap_chunk_data(fp, hmap);
 }
 
+int carmen_map_read_pyramid_level(char *filename, char *name, int level,
+				  carmen_map_p map)
+{
+  char chunk_name[128];
 
+  if (name == NULL || level < 1)
+    return -1;
 
-
+  snprintf(chunk_name, 128, CARMEN_MAP_PYRAMID_CHUNK_NAME, name, level);
+  return carmen_map_read_named_gridmap_chunk(filename, chunk_name, map);
+}
@@ -75,6 +75,10 @@ static int vchunk_size(unsigned int chunk_type, va_list ap)
     size += 12 + va_arg(ap, int) * va_arg(ap, int) * 4;
     break;
 
+  case CARMEN_MAP_COMPACT_GRIDMAP_CHUNK:
+    size += 20 + va_arg(ap, int) * va_arg(ap, int);
+    break;
+
   case CARMEN_MAP_OFFLIMITS_CHUNK:
     size += 4 + 4 + 4;
     offlimits_list = va_arg(ap, carmen_offlimits_p);
@@ -334,6 +338,28 @@ int carmen_map_write_named_gridmap_chunk(carmen_FILE *fp, char *name, float **pr
   return carmen_map_write_gridmap_chunk_data(fp, prob, size_x, size_y, resolution);
 }
 
+int carmen_map_write_compact_gridmap_chunk(carmen_FILE *fp, 
+					   carmen_compact_map_p map)
+{
+  int size;
+  float local_resolution = map->config.resolution;
+
+  carmen_fputc(CARMEN_MAP_COMPACT_GRIDMAP_CHUNK, fp);
+  size = chunk_size(CARMEN_MAP_COMPACT_GRIDMAP_CHUNK, map->config.x_size,
+		    map->column_bytes);
+  carmen_fwrite(&size, sizeof(int), 1, fp);
+  carmen_fprintf(fp, "COMPACTMAP");
+
+  carmen_fwrite(&map->config.x_size, sizeof(int), 1, fp);
+  carmen_fwrite(&map->config.y_size, sizeof(int), 1, fp);
+  carmen_fwrite(&local_resolution, sizeof(float), 1, fp);
+  carmen_fwrite(&map->encoding, sizeof(int), 1, fp);
+  carmen_fwrite(&map->occupied_threshold, sizeof(float), 1, fp);
+  carmen_fwrite(map->data, map->config.x_size*map->column_bytes, 1, fp);
+
+  return 0;
+}
+
 static int carmen_map_write_places_chunk_data(carmen_FILE *fp, carmen_place_p places, 
 					      int num_places)
 {
@@ -621,6 +647,28 @@ int carmen_map_write_hmap_chunk(carmen_FILE *fp, carmen_hmap_p hmap)
   return carmen_map_write_hmap_chunk_data(fp, hmap);
 }
 
+int carmen_map_write_pyramid_chunks(carmen_FILE *fp, char *name,
+				    carmen_map_pyramid_p pyramid)
+{
+  char chunk_name[128];
+  int level;
+
+  if (pyramid == NULL || name == NULL)
+    return -1;
+
+  for (level = 1; level < pyramid->num_levels; level++) {
+    snprintf(chunk_name, 128, CARMEN_MAP_PYRAMID_CHUNK_NAME, name, level);
+    if (carmen_map_write_named_gridmap_chunk
+	(fp, chunk_name, pyramid->level[level].map, 
+	 pyramid->level[level].config.x_size, 
+	 pyramid->level[level].config.y_size, 
+	 pyramid->level[level].config.resolution) < 0)
+      return -1;
+  }
+
+  return 0;
+}
+
 int carmen_map_write_to_ppm(carmen_map_p map, char *output_filename)
 {
   int x, y;
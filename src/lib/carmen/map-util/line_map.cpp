@@ -1,4 +1,5 @@
 #include <float.h>
+#include <limits.h>
 
 #include "line_map.h"
 
@@ -23,6 +24,14 @@ carmen_linemapping_merge_segment(carmen_linemapping_segment_set_t *set,
 				 carmen_linemapping_segment_t *segment, 
 				 int index_no_element);
 
+int
+carmen_linemapping_merge_segment_indexed(carmen_linemapping_segment_set_t *set, 
+					 carmen_linemapping_segment_t *segment);
+
+int
+carmen_linemapping_segments_mergeable(const carmen_linemapping_segment_t *segment, 
+				      const carmen_linemapping_segment_t *s_set);
+
 void                             
 carmen_linemapping_line_fitting_uniformly_distribute(carmen_linemapping_segment_t *s1, 
 						     const carmen_linemapping_segment_t *s2);
@@ -32,6 +41,283 @@ carmen_linemapping_uniformly_distribute_points_on_segment(const carmen_linemappi
 							  const carmen_linemapping_segment_t *s2);
 
 
+// spatial index
+
+// A uniform grid over the segments of a line map: every cell lists the
+// segments passing through it, so the merge candidates of a new segment
+// are found among its neighbours instead of the whole map.
+
+typedef struct{
+  int x, y;
+  int num_segs, max_segs;
+  int *segs;
+  int next;
+} carmen_linemapping_cell_t;
+
+struct carmen_linemapping_segment_index_t{
+  double cell_size;
+  int max_segs;         // allocated size of the segment array of the set
+
+  int num_buckets;      // hash table of the non-empty cells
+  int *buckets;
+  int num_cells, max_cells;
+  carmen_linemapping_cell_t *cells;
+
+  int num_candidates, max_candidates;
+  int *candidates;
+  int *visited;         // stamp of the last query that visited a segment
+  int max_visited, stamp;
+
+  int num_removed, max_removed;
+  int *removed;         // segments merged away during an update
+
+  int num_keys, max_keys;
+  int *keys;            // cell coordinates covered by a segment
+};
+
+static int
+carmen_linemapping_compare_indices_ascending(const void *a, const void *b)
+{
+  return *(const int *)a - *(const int *)b;
+}
+
+static int
+carmen_linemapping_compare_indices_descending(const void *a, const void *b)
+{
+  return *(const int *)b - *(const int *)a;
+}
+
+static int
+carmen_linemapping_compare_cell_keys(const void *a, const void *b)
+{
+  const int *k1 = (const int *)a, *k2 = (const int *)b;
+  if(k1[0] != k2[0]){ return k1[0] < k2[0] ? -1 : 1; }
+  if(k1[1] != k2[1]){ return k1[1] < k2[1] ? -1 : 1; }
+  return 0;
+}
+
+static int
+carmen_linemapping_cell_hash(const carmen_linemapping_segment_index_t *index, 
+			     int x, int y)
+{
+  return (int)(((unsigned int)x*73856093u ^ (unsigned int)y*19349663u) & 
+	       (unsigned int)(index->num_buckets - 1));
+}
+
+static void
+carmen_linemapping_index_rehash(carmen_linemapping_segment_index_t *index, 
+				int num_buckets)
+{
+  free(index->buckets);
+  index->num_buckets = num_buckets;
+  index->buckets = (int *)malloc(num_buckets*sizeof(int));
+  carmen_test_alloc(index->buckets);
+  for(int b=0; b<num_buckets; b++){ index->buckets[b] = -1; }
+  for(int c=0; c<index->num_cells; c++){
+    int b = carmen_linemapping_cell_hash(index, index->cells[c].x, index->cells[c].y);
+    index->cells[c].next = index->buckets[b];
+    index->buckets[b] = c;
+  }
+}
+
+static carmen_linemapping_cell_t *
+carmen_linemapping_index_cell(carmen_linemapping_segment_index_t *index, 
+			      int x, int y, int create)
+{
+  int b = carmen_linemapping_cell_hash(index, x, y);
+  for(int c=index->buckets[b]; c>=0; c=index->cells[c].next){
+    if(index->cells[c].x == x && index->cells[c].y == y){ return &index->cells[c]; }
+  }
+  if(!create){ return NULL; }
+
+  if(index->num_cells == index->max_cells){
+    index->max_cells = 2*index->max_cells + 64;
+    index->cells = (carmen_linemapping_cell_t *)
+      realloc(index->cells, index->max_cells*sizeof(carmen_linemapping_cell_t));
+    carmen_test_alloc(index->cells);
+  }
+  carmen_linemapping_cell_t *cell = &index->cells[index->num_cells];
+  cell->x = x;
+  cell->y = y;
+  cell->num_segs = 0;
+  cell->max_segs = 0;
+  cell->segs = NULL;
+  cell->next = index->buckets[b];
+  index->buckets[b] = index->num_cells++;
+
+  if(index->num_cells > index->num_buckets){
+    carmen_linemapping_index_rehash(index, 2*index->num_buckets);
+    return carmen_linemapping_index_cell(index, x, y, false);
+  }
+  return cell;
+}
+
+// collects the cells within 'radius' cells of 's' in 'index->keys', 
+// sampling 's' at half the cell size
+static void
+carmen_linemapping_index_segment_cells(carmen_linemapping_segment_index_t *index, 
+				       const carmen_linemapping_segment_t *s, 
+				       int radius)
+{
+  double length = carmen_linemapping_distance_point_point(&s->p1, &s->p2);
+  int num_samples = (int)ceil(length / (0.5*index->cell_size)) + 1;
+  int last_x = INT_MAX, last_y = INT_MAX;
+
+  index->num_keys = 0;
+  for(int i=0; i<num_samples; i++){
+    double t = (num_samples > 1) ? i / (double)(num_samples-1) : 0.0;
+    int x = (int)floor( (s->p1.x + t*(s->p2.x - s->p1.x)) / index->cell_size );
+    int y = (int)floor( (s->p1.y + t*(s->p2.y - s->p1.y)) / index->cell_size );
+    if(x == last_x && y == last_y){ continue; }
+    last_x = x;
+    last_y = y;
+
+    int needed = index->num_keys + (2*radius+1)*(2*radius+1);
+    if(needed > index->max_keys){
+      index->max_keys = 2*needed;
+      index->keys = (int *)realloc(index->keys, 2*index->max_keys*sizeof(int));
+      carmen_test_alloc(index->keys);
+    }
+    for(int cx=x-radius; cx<=x+radius; cx++){
+      for(int cy=y-radius; cy<=y+radius; cy++){
+	index->keys[2*index->num_keys]   = cx;
+	index->keys[2*index->num_keys+1] = cy;
+	index->num_keys++;
+      }
+    }
+  }
+
+  // neighbouring samples share cells
+  qsort(index->keys, index->num_keys, 2*sizeof(int), 
+	carmen_linemapping_compare_cell_keys);
+  int num_unique = 0;
+  for(int k=0; k<index->num_keys; k++){
+    if(num_unique > 0 && 
+       index->keys[2*k] == index->keys[2*(num_unique-1)] && 
+       index->keys[2*k+1] == index->keys[2*(num_unique-1)+1]){ continue; }
+    index->keys[2*num_unique]   = index->keys[2*k];
+    index->keys[2*num_unique+1] = index->keys[2*k+1];
+    num_unique++;
+  }
+  index->num_keys = num_unique;
+}
+
+static void
+carmen_linemapping_index_insert(carmen_linemapping_segment_index_t *index, 
+				const carmen_linemapping_segment_t *s, int id)
+{
+  carmen_linemapping_index_segment_cells(index, s, 0);
+  for(int k=0; k<index->num_keys; k++){
+    carmen_linemapping_cell_t *cell = 
+      carmen_linemapping_index_cell(index, index->keys[2*k], index->keys[2*k+1], true);
+    if(cell->num_segs == cell->max_segs){
+      cell->max_segs = 2*cell->max_segs + 4;
+      cell->segs = (int *)realloc(cell->segs, cell->max_segs*sizeof(int));
+      carmen_test_alloc(cell->segs);
+    }
+    cell->segs[cell->num_segs++] = id;
+  }
+}
+
+// 's' must not have changed since it was inserted as 'id'
+static void
+carmen_linemapping_index_remove(carmen_linemapping_segment_index_t *index, 
+				const carmen_linemapping_segment_t *s, int id)
+{
+  carmen_linemapping_index_segment_cells(index, s, 0);
+  for(int k=0; k<index->num_keys; k++){
+    carmen_linemapping_cell_t *cell = 
+      carmen_linemapping_index_cell(index, index->keys[2*k], index->keys[2*k+1], false);
+    if(cell == NULL){ continue; }
+    for(int i=0; i<cell->num_segs; i++){
+      if(cell->segs[i] == id){
+	cell->segs[i] = cell->segs[--cell->num_segs];
+	break;
+      }
+    }
+  }
+}
+
+// collects the segments that can be merged with 's' in 'index->candidates', 
+// in ascending order: a merge candidate has a point less than 'merge_max_dist' 
+// away from 's', and the samples of both segments are at most a quarter cell 
+// away from any of their points
+static int
+carmen_linemapping_index_query(carmen_linemapping_segment_index_t *index, 
+			       const carmen_linemapping_segment_t *s)
+{
+  double reach = carmen_linemapping_params_global.merge_max_dist + 
+    0.5*index->cell_size + carmen_linemapping_epsilon;
+  carmen_linemapping_index_segment_cells(index, s, (int)ceil(reach / index->cell_size));
+
+  if(index->max_visited < index->max_segs){
+    index->visited = (int *)realloc(index->visited, index->max_segs*sizeof(int));
+    carmen_test_alloc(index->visited);
+    for(int i=index->max_visited; i<index->max_segs; i++){ index->visited[i] = 0; }
+    index->max_visited = index->max_segs;
+  }
+  index->stamp++;
+
+  index->num_candidates = 0;
+  for(int k=0; k<index->num_keys; k++){
+    carmen_linemapping_cell_t *cell = 
+      carmen_linemapping_index_cell(index, index->keys[2*k], index->keys[2*k+1], false);
+    if(cell == NULL){ continue; }
+    for(int i=0; i<cell->num_segs; i++){
+      int id = cell->segs[i];
+      if(index->visited[id] == index->stamp){ continue; }
+      index->visited[id] = index->stamp;
+      if(index->num_candidates == index->max_candidates){
+	index->max_candidates = 2*index->max_candidates + 16;
+	index->candidates = (int *)realloc(index->candidates, index->max_candidates*sizeof(int));
+	carmen_test_alloc(index->candidates);
+      }
+      index->candidates[index->num_candidates++] = id;
+    }
+  }
+
+  // the brute force search prefers the lowest index among equally good 
+  // candidates
+  qsort(index->candidates, index->num_candidates, sizeof(int), 
+	carmen_linemapping_compare_indices_ascending);
+  return index->num_candidates;
+}
+
+static void
+carmen_linemapping_index_build(carmen_linemapping_segment_set_t *set)
+{
+  carmen_linemapping_segment_index_t *index = (carmen_linemapping_segment_index_t *)
+    calloc(1, sizeof(carmen_linemapping_segment_index_t));
+  carmen_test_alloc(index);
+
+  // a merge candidate is found in the cells next to the segment
+  index->cell_size = carmen_fmax(4.0*carmen_linemapping_params_global.merge_max_dist, 0.5);
+  index->max_segs = set->num_segs;
+  carmen_linemapping_index_rehash(index, 256);
+  set->index = index;
+
+  for(int i=0; i<set->num_segs; i++){
+    if(set->segs[i].weight != 0){
+      carmen_linemapping_index_insert(index, &set->segs[i], i);
+    }
+  }
+}
+
+static void
+carmen_linemapping_index_free(carmen_linemapping_segment_index_t *index)
+{
+  if(index == NULL){ return; }
+  for(int c=0; c<index->num_cells; c++){ free(index->cells[c].segs); }
+  free(index->cells);
+  free(index->buckets);
+  free(index->candidates);
+  free(index->visited);
+  free(index->removed);
+  free(index->keys);
+  free(index);
+}
+
+
 // general functions
 
 int            
@@ -110,6 +396,8 @@ void carmen_linemapping_free_segments(carmen_linemapping_segment_set_t* s) {
     free(s->segs);
   s->segs = NULL;
   s->num_segs = 0;
+  carmen_linemapping_index_free(s->index);
+  s->index = NULL;
 }
 
 // calculates the  max. distance 'max_dist' of a point 'pnt[max_index]' of the point set 'pnts[i_low] ... pnts[i_high]'
@@ -270,8 +558,10 @@ carmen_linemapping_get_segments_from_points(const carmen_linemapping_dyn_tab_poi
   // just copy the elements of 'segments_temp' into 'segments'
   carmen_linemapping_segment_set_t segments;
   segments.num_segs = segments_temp->numberOfElements();
-  segments.segs = new carmen_linemapping_segment_t[segments.num_segs];
+  segments.segs = (carmen_linemapping_segment_t *)
+    calloc(segments.num_segs + 1, sizeof(carmen_linemapping_segment_t));
   carmen_test_alloc(segments.segs);
+  segments.index = NULL;
   carmen_linemapping_segment_t** elements = segments_temp->getElements();
   for(int i=0; i<segments.num_segs; i++){ segments.segs[i] = *(elements[i]); }
 
@@ -388,54 +678,56 @@ carmen_linemapping_get_segments_from_scans(const carmen_robot_laser_message *mul
 }
 
 
-// merges the two sets of line segments 'segments_old' and 'segments_new'
-carmen_linemapping_segment_set_t* 
+// merges the set of line segments 'segments_new' into 'segments_old', in place
+void
 carmen_linemapping_merge_segment_sets(carmen_linemapping_segment_set_t *segments_old, 
 				      carmen_linemapping_segment_set_t *segments_new)
 {
+  if(segments_old->index == NULL)
+    carmen_linemapping_index_build(segments_old);
+  carmen_linemapping_segment_index_t *index = segments_old->index;
+  index->num_removed = 0;
+
   for(int i=0; i<segments_new->num_segs; i++){
     if(segments_new->segs[i].weight==0){ continue; }
 
     int merge_old = true, merge_new = false;
     while ( merge_old || merge_new ){ // merge untill nothing change
-      merge_old = carmen_linemapping_merge_segment(segments_old, &segments_new->segs[i]);
+      merge_old = carmen_linemapping_merge_segment_indexed(segments_old, &segments_new->segs[i]);
       if(merge_old || merge_new){
         merge_new = carmen_linemapping_merge_segment(segments_new, &segments_new->segs[i], i);
       }
     }
   }
 
-  int count = 0;
-  for(int i_old=0; i_old<segments_old->num_segs; i_old++)
-    if(segments_old->segs[i_old].weight!=0)
-      count++; 
-  for(int i_new=0; i_new<segments_new->num_segs; i_new++)
-    if(segments_new->segs[i_new].weight!=0)
-      count++;
-
-  carmen_linemapping_segment_set_t *merge_segments = new carmen_linemapping_segment_set_t;
-  carmen_test_alloc(merge_segments);
-  merge_segments->num_segs = count;
-  merge_segments->segs = new carmen_linemapping_segment_t[merge_segments->num_segs];
-  carmen_test_alloc(merge_segments->segs);
-
-  int index = 0;
-  for(int i_old=0; i_old<segments_old->num_segs; i_old++){
-    if(segments_old->segs[i_old].weight!=0){
-      merge_segments->segs[index] = segments_old->segs[i_old];
-      index++;
+  // fill the holes of merged old segments with the last segments; going 
+  // from the highest index down, the last segment is never a hole itself
+  qsort(index->removed, index->num_removed, sizeof(int), 
+	carmen_linemapping_compare_indices_descending);
+  for(int r=0; r<index->num_removed; r++){
+    int hole = index->removed[r], last = segments_old->num_segs-1;
+    if(hole != last){
+      carmen_linemapping_index_remove(index, &segments_old->segs[last], last);
+      segments_old->segs[hole] = segments_old->segs[last];
+      carmen_linemapping_index_insert(index, &segments_old->segs[hole], hole);
     }
+    segments_old->num_segs--;
   }
+  index->num_removed = 0;
 
   for(int i_new=0; i_new<segments_new->num_segs; i_new++){
     if(segments_new->segs[i_new].weight!=0){
-      merge_segments->segs[index] = segments_new->segs[i_new];
-      index++;
+      if(segments_old->num_segs == index->max_segs){
+	index->max_segs = 2*index->max_segs + 16;
+	segments_old->segs = (carmen_linemapping_segment_t *)
+	  realloc(segments_old->segs, index->max_segs*sizeof(carmen_linemapping_segment_t));
+	carmen_test_alloc(segments_old->segs);
+      }
+      int i_old = segments_old->num_segs++;
+      segments_old->segs[i_old] = segments_new->segs[i_new];
+      carmen_linemapping_index_insert(index, &segments_old->segs[i_old], i_old);
     }
   }
-
-  return merge_segments;
-
 }
 
 
@@ -445,15 +737,10 @@ void carmen_linemapping_update_linemap(carmen_linemapping_segment_set_t *linemap
 {
   carmen_linemapping_segment_set_t laser_segments 
     = carmen_linemapping_get_segments_from_scan(laser, false);
-  carmen_linemapping_segment_set_t *new_linemap   
-    = carmen_linemapping_merge_segment_sets(linemap, &laser_segments);
 
-  delete [] laser_segments.segs;
-
-  if(linemap->num_segs>0){ delete [] linemap->segs; }
-  linemap->num_segs = new_linemap->num_segs;
-  linemap->segs = new_linemap->segs;
+  carmen_linemapping_merge_segment_sets(linemap, &laser_segments);
 
+  carmen_linemapping_free_segments(&laser_segments);
 }
 
 
@@ -478,108 +765,64 @@ int carmen_linemapping_merge_segment(carmen_linemapping_segment_set_t *set,
     if(i==index_no_element || set->segs[i].weight==0 || segment->weight==0){ continue; }
 
     carmen_linemapping_segment_t *s_set = &(set->segs[i]);
+    if( carmen_linemapping_segments_mergeable(segment, s_set) ){
+      double a_dif = carmen_linemapping_angle_difference(segment, s_set);
+      if( a_dif < best_similar_angle ){
+	best_similar_angle = a_dif;
+	best_merge_index = i;
+      }
+    }
+  }
+  
+  if (best_merge_index>=0){ 
+    // merge the best candidate with 'segment'
+    carmen_linemapping_line_fitting_uniformly_distribute(segment, &(set->segs[best_merge_index]));
+    set->segs[best_merge_index].weight = 0;
+    return true;
+  }
+  else
+    return false; 
 
-    double dx = segment->p2.x - segment->p1.x;
-    double dy = segment->p2.y - segment->p1.y;
-    double denominator = carmen_square(dx) + carmen_square(dy);
+}
 
-    double numerator1 = carmen_square( dx*(s_set->p1.y - segment->p2.y) - dy*(s_set->p1.x - segment->p2.x) );
-    double numerator2 = carmen_square( dx*(s_set->p2.y - segment->p2.y) - dy*(s_set->p2.x - segment->p2.x) );
-    double dis_set_p1 = sqrt( numerator1/denominator );
-    double dis_set_p2 = sqrt( numerator2/denominator );
 
-    if( dis_set_p1 < carmen_linemapping_params_global.merge_max_dist && 
-	dis_set_p2 < carmen_linemapping_params_global.merge_max_dist ) { 
-      // 's_set' is close enough to the line 'segment' (not line segment!!!)
-      int overlap_set_p1 = carmen_linemapping_overlap_point_linesegment(segment, &s_set->p1);
-      int overlap_set_p2 = carmen_linemapping_overlap_point_linesegment(segment, &s_set->p2);
-      
-      if( overlap_set_p1 && overlap_set_p2 ){ 
-	// case 1: both endpoints of 's_set' overlaps -> merge
-	double a_dif = carmen_linemapping_angle_difference(segment, s_set);
-	if( a_dif < best_similar_angle ){
-	  best_similar_angle = a_dif;
-	  best_merge_index = i;
-	  continue;
-	}
-      }
-      
-      if( overlap_set_p1 || overlap_set_p2 ){ 
-	// case 2: only one endpoint of 's_set' overlaps -> test merge
-	double overlap_dist;
-	carmen_point_t point = carmen_linemapping_get_point_on_segment(segment, s_set);
-	if( overlap_set_p1 ){ 
-	  overlap_dist = carmen_linemapping_distance_point_point(&s_set->p1, &point); 
-	}
-	else                { 
-	  overlap_dist = carmen_linemapping_distance_point_point(&s_set->p2, &point); 
-	}
-	
-	double line_size = carmen_linemapping_distance_point_point(&s_set->p1, &s_set->p2);
-	if( (overlap_dist/line_size) > carmen_linemapping_params_global.merge_min_relative_overlap || 
-	    overlap_dist > carmen_linemapping_params_global.merge_overlap_min_length ){
-	  double a_dif = carmen_linemapping_angle_difference(segment, s_set);
-	  if( a_dif < best_similar_angle ){
-	    best_similar_angle = a_dif;
-	    best_merge_index = i;
-	    continue;
-	  }
-	}
-      }
-    }
-    
-    dx = s_set->p2.x - s_set->p1.x;
-    dy = s_set->p2.y - s_set->p1.y;
-    denominator = carmen_square(dx) + carmen_square(dy);
-
-    numerator1 = carmen_square( dx*(segment->p1.y - s_set->p2.y) - dy*(segment->p1.x - s_set->p2.x) );
-    numerator2 = carmen_square( dx*(segment->p2.y - s_set->p2.y) - dy*(segment->p2.x - s_set->p2.x) );
-    double dis_segment_p1 = sqrt( numerator1/denominator );
-    double dis_segment_p2 = sqrt( numerator2/denominator );
-
-    if( dis_segment_p1 < carmen_linemapping_params_global.merge_max_dist && 
-	dis_segment_p2 < carmen_linemapping_params_global.merge_max_dist ){ 
-      // 'segment' is close enough to the line 's_set' (not line segment!!!)
-      int overlap_segment_p1 = carmen_linemapping_overlap_point_linesegment(s_set, &segment->p1);
-      int overlap_segment_p2 = carmen_linemapping_overlap_point_linesegment(s_set, &segment->p2);
-
-      if(overlap_segment_p1 && overlap_segment_p2){ // case 3: both endpoints of 's_old' overlaps -> merge
-	double a_dif = carmen_linemapping_angle_difference(segment, s_set);
-	if( a_dif < best_similar_angle ){
-	  best_similar_angle = a_dif;
-	  best_merge_index = i;
-	  continue;
-	}
-      }
+// - like 'carmen_linemapping_merge_segment(set, segment)', but only the candidates 
+//   near 'segment' are taken from the spatial index of 'set'
+// - the best candidate is removed from the index, its index is remembered for 
+//   'carmen_linemapping_merge_segment_sets'
+int carmen_linemapping_merge_segment_indexed(carmen_linemapping_segment_set_t *set, 
+					     carmen_linemapping_segment_t *segment)
+{
+  carmen_linemapping_segment_index_t *index = set->index;
+  int num_candidates = carmen_linemapping_index_query(index, segment);
+
+  int best_merge_index = -1;
+  double best_similar_angle = DBL_MAX;
+  for(int c=0; c<num_candidates; c++){
+    int i = index->candidates[c];
+    if(set->segs[i].weight==0 || segment->weight==0){ continue; }
 
-      if(overlap_segment_p1 || overlap_segment_p2){ // case 4: only one endpoint of 'segment' overlaps -> test merge
-	double overlap_dist;
-	carmen_point_t point = carmen_linemapping_get_point_on_segment(s_set, segment);
-	if( overlap_segment_p1 ){ 
-	  overlap_dist = carmen_linemapping_distance_point_point(&segment->p1, &point); 
-	}
-	else                    { 
-	  overlap_dist = carmen_linemapping_distance_point_point(&segment->p2, &point); 
-	}
-
-	double line_size = carmen_linemapping_distance_point_point(&segment->p1, &segment->p2);
-	if( (overlap_dist/line_size) > carmen_linemapping_params_global.merge_min_relative_overlap || 
-	    overlap_dist > carmen_linemapping_params_global.merge_overlap_min_length ){
-	  double a_dif = carmen_linemapping_angle_difference(segment, s_set);
-	  if( a_dif < best_similar_angle ){
-	    best_similar_angle = a_dif;
-	    best_merge_index = i;
-	    continue;
-	  }
-	}
+    carmen_linemapping_segment_t *s_set = &(set->segs[i]);
+    if( carmen_linemapping_segments_mergeable(segment, s_set) ){
+      double a_dif = carmen_linemapping_angle_difference(segment, s_set);
+      if( a_dif < best_similar_angle ){
+	best_similar_angle = a_dif;
+	best_merge_index = i;
       }
     }
   }
-  
+
   if (best_merge_index>=0){ 
     // merge the best candidate with 'segment'
+    carmen_linemapping_index_remove(index, &(set->segs[best_merge_index]), best_merge_index);
     carmen_linemapping_line_fitting_uniformly_distribute(segment, &(set->segs[best_merge_index]));
     set->segs[best_merge_index].weight = 0;
+    if(index->num_removed == index->max_removed){
+      index->max_removed = 2*index->max_removed + 16;
+      index->removed = (int *)realloc(index->removed, index->max_removed*sizeof(int));
+      carmen_test_alloc(index->removed);
+    }
+    index->removed[index->num_removed++] = best_merge_index;
     return true;
   }
   else
@@ -587,6 +830,91 @@ int carmen_linemapping_merge_segment(carmen_linemapping_segment_set_t *set,
 
 }
 
+
+// returns 'true', if 's_set' is close enough to 'segment' and overlaps it far 
+// enough to be merged with it
+int carmen_linemapping_segments_mergeable(const carmen_linemapping_segment_t *segment, 
+					  const carmen_linemapping_segment_t *s_set)
+{
+  double dx = segment->p2.x - segment->p1.x;
+  double dy = segment->p2.y - segment->p1.y;
+  double denominator = carmen_square(dx) + carmen_square(dy);
+
+  double numerator1 = carmen_square( dx*(s_set->p1.y - segment->p2.y) - dy*(s_set->p1.x - segment->p2.x) );
+  double numerator2 = carmen_square( dx*(s_set->p2.y - segment->p2.y) - dy*(s_set->p2.x - segment->p2.x) );
+  double dis_set_p1 = sqrt( numerator1/denominator );
+  double dis_set_p2 = sqrt( numerator2/denominator );
+
+  if( dis_set_p1 < carmen_linemapping_params_global.merge_max_dist && 
+      dis_set_p2 < carmen_linemapping_params_global.merge_max_dist ) { 
+    // 's_set' is close enough to the line 'segment' (not line segment!!!)
+    int overlap_set_p1 = carmen_linemapping_overlap_point_linesegment(segment, &s_set->p1);
+    int overlap_set_p2 = carmen_linemapping_overlap_point_linesegment(segment, &s_set->p2);
+      
+    if( overlap_set_p1 && overlap_set_p2 ){ 
+      // case 1: both endpoints of 's_set' overlaps -> merge
+      return true;
+    }
+      
+    if( overlap_set_p1 || overlap_set_p2 ){ 
+      // case 2: only one endpoint of 's_set' overlaps -> test merge
+      double overlap_dist;
+      carmen_point_t point = carmen_linemapping_get_point_on_segment(segment, s_set);
+      if( overlap_set_p1 ){ 
+	overlap_dist = carmen_linemapping_distance_point_point(&s_set->p1, &point); 
+      }
+      else                { 
+	overlap_dist = carmen_linemapping_distance_point_point(&s_set->p2, &point); 
+      }
+	
+      double line_size = carmen_linemapping_distance_point_point(&s_set->p1, &s_set->p2);
+      if( (overlap_dist/line_size) > carmen_linemapping_params_global.merge_min_relative_overlap || 
+	  overlap_dist > carmen_linemapping_params_global.merge_overlap_min_length ){
+	return true;
+      }
+    }
+  }
+    
+  dx = s_set->p2.x - s_set->p1.x;
+  dy = s_set->p2.y - s_set->p1.y;
+  denominator = carmen_square(dx) + carmen_square(dy);
+
+  numerator1 = carmen_square( dx*(segment->p1.y - s_set->p2.y) - dy*(segment->p1.x - s_set->p2.x) );
+  numerator2 = carmen_square( dx*(segment->p2.y - s_set->p2.y) - dy*(segment->p2.x - s_set->p2.x) );
+  double dis_segment_p1 = sqrt( numerator1/denominator );
+  double dis_segment_p2 = sqrt( numerator2/denominator );
+
+  if( dis_segment_p1 < carmen_linemapping_params_global.merge_max_dist && 
+      dis_segment_p2 < carmen_linemapping_params_global.merge_max_dist ){ 
+    // 'segment' is close enough to the line 's_set' (not line segment!!!)
+    int overlap_segment_p1 = carmen_linemapping_overlap_point_linesegment(s_set, &segment->p1);
+    int overlap_segment_p2 = carmen_linemapping_overlap_point_linesegment(s_set, &segment->p2);
+
+    if(overlap_segment_p1 && overlap_segment_p2){ // case 3: both endpoints of 's_old' overlaps -> merge
+      return true;
+    }
+
+    if(overlap_segment_p1 || overlap_segment_p2){ // case 4: only one endpoint of 'segment' overlaps -> test merge
+      double overlap_dist;
+      carmen_point_t point = carmen_linemapping_get_point_on_segment(s_set, segment);
+      if( overlap_segment_p1 ){ 
+	overlap_dist = carmen_linemapping_distance_point_point(&segment->p1, &point); 
+      }
+      else                    { 
+	overlap_dist = carmen_linemapping_distance_point_point(&segment->p2, &point); 
+      }
+
+      double line_size = carmen_linemapping_distance_point_point(&segment->p1, &segment->p2);
+      if( (overlap_dist/line_size) > carmen_linemapping_params_global.merge_min_relative_overlap || 
+	  overlap_dist > carmen_linemapping_params_global.merge_overlap_min_length ){
+	return true;
+      }
+    }
+  }
+
+  return false;
+}
+
 // - merges 's1' with 's2' with a line fitting method
 // - points are uniformly distributed on the line segments
 // - number and weight of the points are calculated from the weight of the line segment
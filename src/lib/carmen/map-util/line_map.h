@@ -56,9 +56,19 @@ typedef struct{
 } carmen_linemapping_segment_t;
 
 
+typedef struct carmen_linemapping_segment_index_t 
+carmen_linemapping_segment_index_t;
+
+/** A set of line segments. The spatial index is built by 
+    carmen_linemapping_update_linemap() to find merge candidates without 
+    comparing against every segment; it must be NULL for sets that were 
+    not created by this library, and is released by 
+    carmen_linemapping_free_segments(). */
+
 typedef struct{
   int num_segs;
   carmen_linemapping_segment_t *segs;
+  carmen_linemapping_segment_index_t *index;
 } carmen_linemapping_segment_set_t;
 
 
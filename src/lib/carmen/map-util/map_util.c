@@ -26,8 +26,13 @@
  *
  ********************************************************/
 
+#include <float.h>
+#include <pthread.h>
+#include <unistd.h>
+
 #include "global.h"
 #include "map_io.h"
+#include "map_util.h"
 
 /* An implementation of bicubic image interpolation, shamelessly borrowed
    from an implementation by Blake Carlson (blake-carlson@uiowa.edu). 
@@ -73,22 +78,172 @@ cubic_bspline(float x)
   return (one_sixth * (a - (4.0 * b) + (6.0 * c) - (4.0 * d)));
 }
 
-void
-carmen_map_util_change_resolution(carmen_map_p map, double new_resolution)
+/* Column-parallel execution. Every map operation below writes whole
+   output columns (map[x] is contiguous), so the work is split into
+   contiguous column ranges, one per thread. */
+
+#define MAX_MAP_THREADS              16
+#define MIN_MAP_COLUMNS_PER_THREAD   32
+
+typedef void (*column_range_func_t)(void *data, int begin, int end);
+
+typedef struct {
+  column_range_func_t func;
+  void *data;
+  int begin, end;
+} column_range_t;
+
+static void *
+column_range_thread(void *arg)
 {
-  float *new_complete_map;
-  float **new_map;
-  carmen_map_config_t new_config;
+  column_range_t *range = (column_range_t *)arg;
+
+  range->func(range->data, range->begin, range->end);
+  return NULL;
+}
+
+static void
+for_each_column_range(int num_columns, int num_threads, 
+		      column_range_func_t func, void *data)
+{
+  pthread_t thread[MAX_MAP_THREADS];
+  column_range_t range[MAX_MAP_THREADS];
+  int started[MAX_MAP_THREADS];
+  int i;
 
-  float **padded_map;
-  float *padded_backing;
+  if (num_threads <= 0)
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (num_threads > num_columns/MIN_MAP_COLUMNS_PER_THREAD)
+    num_threads = num_columns/MIN_MAP_COLUMNS_PER_THREAD;
+  if (num_threads > MAX_MAP_THREADS)
+    num_threads = MAX_MAP_THREADS;
 
-  int padded_x_size, padded_y_size;
-  float scale_factor;
+  if (num_threads <= 1) {
+    func(data, 0, num_columns);
+    return;
+  }
+
+  for (i = 0; i < num_threads; i++) {
+    range[i].func = func;
+    range[i].data = data;
+    range[i].begin = (long)num_columns*i/num_threads;
+    range[i].end = (long)num_columns*(i+1)/num_threads;
+  }
+
+  /* The calling thread takes the first range; a range whose thread
+     cannot be started is run inline instead. */
+  for (i = 1; i < num_threads; i++) {
+    started[i] = !pthread_create(&thread[i], NULL, column_range_thread, 
+				 &range[i]);
+    if (!started[i])
+      column_range_thread(&range[i]);
+  }
+  column_range_thread(&range[0]);
+  for (i = 1; i < num_threads; i++)
+    if (started[i])
+      pthread_join(thread[i], NULL);
+}
 
+static void
+alloc_gridmap(carmen_map_p map, carmen_map_config_t config)
+{
+  int x;
+
+  map->config = config;
+  map->complete_map = (float *)calloc(config.x_size*config.y_size, 
+				      sizeof(float));
+  carmen_test_alloc(map->complete_map);
+
+  map->map = (float **)calloc(config.x_size, sizeof(float *));
+  carmen_test_alloc(map->map);
+  for (x = 0; x < config.x_size; x++)
+    map->map[x] = map->complete_map+x*config.y_size;
+}
+
+/* The 4x4 B-spline kernel is separable, so each output cell is a
+   4-tap filter over x followed by a 4-tap filter over y. The taps and
+   weights only depend on the output column (row), so they are computed
+   once per column (row) instead of once per cell. Map borders are
+   extended by replicating the outermost cells. */
+
+typedef struct {
+  carmen_map_p map;
+  carmen_map_p new_map;
+  int *x_tap, *y_tap;
+  float *x_weight, *y_weight;
+} resample_job_t;
+
+static void
+compute_bspline_taps(int new_size, int size, float scale_factor,
+		     int *tap, float *weight)
+{
+  float f, frac;
+  int i, k, n;
+
+  for (i = 0; i < new_size; i++) {
+    f = i / scale_factor;
+    k = carmen_trunc(f);
+    frac = f - k;
+    for (n = -1; n < 3; n++) {
+      tap[4*i+n+1] = carmen_clamp(0, k+n, size-1);
+      weight[4*i+n+1] = cubic_bspline((float)n - frac);
+    }
+  }
+}
+
+static void
+resample_columns(void *data, int begin, int end)
+{
+  resample_job_t *job = (resample_job_t *)data;
+  int y_size = job->map->config.y_size;
+  int new_y_size = job->new_map->config.y_size;
+  float *column, *c0, *c1, *c2, *c3, *dest;
+  float w0, w1, w2, w3, value;
+  int *tap;
+  float *weight;
   int x, y;
-  float f_x, f_y, a, b, tmp, r1, r2;
-  int i_x, i_y, m, n;
+
+  column = (float *)calloc(y_size, sizeof(float));
+  carmen_test_alloc(column);
+
+  for (x = begin; x < end; x++) {
+    tap = job->x_tap+4*x;
+    weight = job->x_weight+4*x;
+    c0 = job->map->map[tap[0]];
+    c1 = job->map->map[tap[1]];
+    c2 = job->map->map[tap[2]];
+    c3 = job->map->map[tap[3]];
+    w0 = weight[0];
+    w1 = weight[1];
+    w2 = weight[2];
+    w3 = weight[3];
+    for (y = 0; y < y_size; y++)
+      column[y] = w0*c0[y] + w1*c1[y] + w2*c2[y] + w3*c3[y];
+
+    dest = job->new_map->map[x];
+    for (y = 0; y < new_y_size; y++) {
+      tap = job->y_tap+4*y;
+      weight = job->y_weight+4*y;
+      value = weight[0]*column[tap[0]] + weight[1]*column[tap[1]] + 
+	weight[2]*column[tap[2]] + weight[3]*column[tap[3]];
+      if (value < 0)
+	value = -1;
+      if (value > 1.0)
+	value = 1.0;
+      dest[y] = value;
+    }
+  }
+
+  free(column);
+}
+
+void
+carmen_map_util_change_resolution(carmen_map_p map, double new_resolution)
+{
+  carmen_map_t new_map;
+  carmen_map_config_t new_config;
+  resample_job_t job;
+  float scale_factor;
 
   new_config.x_size = map->config.resolution/new_resolution * 
     map->config.x_size;
@@ -97,81 +252,614 @@ carmen_map_util_change_resolution(carmen_map_p map, double new_resolution)
   new_config.resolution = new_resolution;
   new_config.map_name = map->config.map_name;
 
-  new_complete_map = (float *)
-    calloc(new_config.x_size*new_config.y_size, sizeof(float));
-  carmen_test_alloc(new_complete_map);
+  alloc_gridmap(&new_map, new_config);
 
-  new_map = (float **)calloc(new_config.x_size, sizeof(float *));
-  carmen_test_alloc(new_map);
-  for (x = 0; x < new_config.x_size; x++)
-    new_map[x] = new_complete_map+x*new_config.y_size;
+  scale_factor = map->config.resolution / new_resolution;
 
-  padded_x_size = map->config.x_size+4;
-  padded_y_size = map->config.y_size+4;
+  job.map = map;
+  job.new_map = &new_map;
+  job.x_tap = (int *)calloc(4*new_config.x_size, sizeof(int));
+  carmen_test_alloc(job.x_tap);
+  job.x_weight = (float *)calloc(4*new_config.x_size, sizeof(float));
+  carmen_test_alloc(job.x_weight);
+  job.y_tap = (int *)calloc(4*new_config.y_size, sizeof(int));
+  carmen_test_alloc(job.y_tap);
+  job.y_weight = (float *)calloc(4*new_config.y_size, sizeof(float));
+  carmen_test_alloc(job.y_weight);
+
+  compute_bspline_taps(new_config.x_size, map->config.x_size, scale_factor,
+		       job.x_tap, job.x_weight);
+  compute_bspline_taps(new_config.y_size, map->config.y_size, scale_factor,
+		       job.y_tap, job.y_weight);
+
+  for_each_column_range(new_config.x_size, 0, resample_columns, &job);
+
+  free(job.x_tap);
+  free(job.x_weight);
+  free(job.y_tap);
+  free(job.y_weight);
 
-  padded_backing = (float *)calloc(padded_x_size*padded_y_size, sizeof(float));
-  carmen_test_alloc(padded_backing);
+  free(map->map);
+  free(map->complete_map);
 
-  padded_map = (float **)calloc(padded_x_size, sizeof(float *));
-  carmen_test_alloc(padded_map);
-  for (x = 0; x < padded_x_size; x++)
-    padded_map[x] = padded_backing+x*padded_y_size;
+  map->map = new_map.map;
+  map->complete_map = new_map.complete_map;
+  map->config = new_config;
+}
 
-  for (x = 2; x < padded_x_size-2; x++) {
-    memcpy(padded_map[x]+2, map->map[x-2], map->config.y_size*sizeof(float));
-    memcpy(padded_map[x], padded_map[x]+2, 2*sizeof(float));
-    memcpy(padded_map[x]+2+map->config.y_size, 
-	   padded_map[x]+map->config.y_size, 
-	   2*sizeof(float));
+/* Each pyramid level halves the resolution of the one below it. A
+   coarse cell covers a 2x2 block of fine cells and is reduced over the
+   known (non-negative) cells of that block; a block without any known
+   cell stays unknown. The reduction is separable: the two fine columns
+   are first combined element-wise into a scratch column, then adjacent
+   scratch entries are combined. A block that hangs over the map border
+   reuses its single column or row, which does not change min, max or
+   mean. */
+
+typedef struct {
+  carmen_map_p fine;
+  carmen_map_p coarse;
+  carmen_map_reducer_t reducer;
+} reduce_job_t;
+
+static void
+reduce_columns(void *data, int begin, int end)
+{
+  reduce_job_t *job = (reduce_job_t *)data;
+  int fine_x_size = job->fine->config.x_size;
+  int fine_y_size = job->fine->config.y_size;
+  int coarse_y_size = job->coarse->config.y_size;
+  float *value, *count, *a, *b, *dest;
+  float ka, kb, sum, n;
+  int x, y, y0, y1;
+
+  value = (float *)calloc(fine_y_size, sizeof(float));
+  carmen_test_alloc(value);
+  count = (float *)calloc(fine_y_size, sizeof(float));
+  carmen_test_alloc(count);
+
+  for (x = begin; x < end; x++) {
+    a = job->fine->map[2*x];
+    b = (2*x+1 < fine_x_size) ? job->fine->map[2*x+1] : a;
+    dest = job->coarse->map[x];
+
+    switch (job->reducer) {
+    case CARMEN_MAP_REDUCE_MIN:
+      for (y = 0; y < fine_y_size; y++) {
+	ka = (a[y] < 0) ? FLT_MAX : a[y];
+	kb = (b[y] < 0) ? FLT_MAX : b[y];
+	value[y] = (ka < kb) ? ka : kb;
+      }
+      for (y = 0; y < coarse_y_size; y++) {
+	y0 = 2*y;
+	y1 = (y0+1 < fine_y_size) ? y0+1 : y0;
+	sum = (value[y0] < value[y1]) ? value[y0] : value[y1];
+	dest[y] = (sum == FLT_MAX) ? -1 : sum;
+      }
+      break;
+    case CARMEN_MAP_REDUCE_MAX:
+      for (y = 0; y < fine_y_size; y++)
+	value[y] = (a[y] > b[y]) ? a[y] : b[y];
+      for (y = 0; y < coarse_y_size; y++) {
+	y0 = 2*y;
+	y1 = (y0+1 < fine_y_size) ? y0+1 : y0;
+	sum = (value[y0] > value[y1]) ? value[y0] : value[y1];
+	dest[y] = (sum < 0) ? -1 : sum;
+      }
+      break;
+    default:
+      for (y = 0; y < fine_y_size; y++) {
+	ka = (a[y] < 0) ? 0 : 1;
+	kb = (b[y] < 0) ? 0 : 1;
+	value[y] = ka*a[y] + kb*b[y];
+	count[y] = ka + kb;
+      }
+      for (y = 0; y < coarse_y_size; y++) {
+	y0 = 2*y;
+	y1 = (y0+1 < fine_y_size) ? y0+1 : y0;
+	sum = value[y0] + value[y1];
+	n = count[y0] + count[y1];
+	dest[y] = (n > 0) ? sum / n : -1;
+      }
+      break;
+    }
   }
 
-  memcpy(padded_map[0], padded_map[2], padded_y_size*sizeof(float));
-  memcpy(padded_map[1], padded_map[2], padded_y_size*sizeof(float));
+  free(value);
+  free(count);
+}
 
-  memcpy(padded_map[padded_x_size-2], padded_map[padded_x_size-3], 
-	 padded_y_size*sizeof(float));
-  memcpy(padded_map[padded_x_size-1], padded_map[padded_x_size-3], 
-	 padded_y_size*sizeof(float));
+carmen_map_pyramid_p
+carmen_map_util_build_pyramid(carmen_map_p map, int num_levels,
+			      carmen_map_reducer_t reducer, int num_threads)
+{
+  carmen_map_pyramid_p pyramid;
+  carmen_map_config_t config;
+  reduce_job_t job;
+  int level;
+
+  if (num_levels < 1)
+    num_levels = 1;
+
+  pyramid = (carmen_map_pyramid_p)calloc(1, sizeof(carmen_map_pyramid_t));
+  carmen_test_alloc(pyramid);
+  pyramid->reducer = reducer;
+  pyramid->level = (carmen_map_p)calloc(num_levels, sizeof(carmen_map_t));
+  carmen_test_alloc(pyramid->level);
+
+  alloc_gridmap(&pyramid->level[0], map->config);
+  memcpy(pyramid->level[0].complete_map, map->complete_map,
+	 map->config.x_size*map->config.y_size*sizeof(float));
+  pyramid->num_levels = 1;
+
+  for (level = 1; level < num_levels; level++) {
+    config = pyramid->level[level-1].config;
+    if (config.x_size <= 1 && config.y_size <= 1)
+      break;
+    config.x_size = (config.x_size+1)/2;
+    config.y_size = (config.y_size+1)/2;
+    config.resolution *= 2;
+    alloc_gridmap(&pyramid->level[level], config);
+
+    job.fine = &pyramid->level[level-1];
+    job.coarse = &pyramid->level[level];
+    job.reducer = reducer;
+    for_each_column_range(config.x_size, num_threads, reduce_columns, &job);
+    pyramid->num_levels++;
+  }
 
-  scale_factor = map->config.resolution / new_resolution;
+  return pyramid;
+}
 
-  for (y = 0; y < new_config.y_size; y++) {
-    f_y = y / scale_factor;
-    i_y = carmen_trunc(f_y);
-    a   = f_y - carmen_trunc(f_y);		
-    for (x = 0; x < new_config.x_size; x++) {
-      f_x = x / scale_factor;
-      i_x = carmen_trunc(f_x);
-      b   = f_x - carmen_trunc(f_x);
-        
-      // Implement EQ 14.5-3 here
-      tmp = 0.0;
-      for(m = -1; m < 3; m++) {
-	r1 = cubic_bspline((float) m - a);
-          
-	for(n = -1; n < 3; n++) {
-	  r2 = cubic_bspline(-1.0*((float)n - b)); 
-	  tmp += padded_map[i_x+n+2][i_y+m+2] * r1 * r2;
-	}
+void
+carmen_map_util_free_pyramid(carmen_map_pyramid_p pyramid)
+{
+  int level;
+
+  if (pyramid == NULL)
+    return;
+
+  for (level = 0; level < pyramid->num_levels; level++) {
+    free(pyramid->level[level].map);
+    free(pyramid->level[level].complete_map);
+  }
+  free(pyramid->level);
+  free(pyramid);
+}
+
+carmen_compact_map_p
+carmen_map_util_new_compact_map(carmen_map_config_t config, int encoding,
+				float occupied_threshold)
+{
+  carmen_compact_map_p map;
+
+  if (encoding != CARMEN_MAP_ENCODING_U8 && 
+      encoding != CARMEN_MAP_ENCODING_BITMAP) {
+    carmen_warn("Error: unknown map encoding %d\n", encoding);
+    return NULL;
+  }
+
+  map = (carmen_compact_map_p)calloc(1, sizeof(carmen_compact_map_t));
+  carmen_test_alloc(map);
+
+  map->config = config;
+  map->encoding = encoding;
+  map->occupied_threshold = occupied_threshold;
+  if (encoding == CARMEN_MAP_ENCODING_U8)
+    map->column_bytes = config.y_size;
+  else
+    map->column_bytes = (config.y_size+3)/4;
+
+  /* unknown everywhere */
+  map->data = (unsigned char *)malloc(config.x_size*map->column_bytes);
+  carmen_test_alloc(map->data);
+  memset(map->data, (encoding == CARMEN_MAP_ENCODING_U8) ? 
+	 CARMEN_MAP_U8_UNKNOWN : 0xAA, config.x_size*map->column_bytes);
+
+  return map;
+}
+
+void
+carmen_map_util_free_compact_map(carmen_compact_map_p map)
+{
+  if (map == NULL)
+    return;
+
+  free(map->data);
+  free(map);
+}
+
+static carmen_inline unsigned char
+encode_u8(float value)
+{
+  if (value < 0)
+    return CARMEN_MAP_U8_UNKNOWN;
+  if (value >= 1.0)
+    return CARMEN_MAP_U8_MAX;
+  return (unsigned char)(value*CARMEN_MAP_U8_MAX+0.5);
+}
+
+static carmen_inline int
+encode_bitmap(float value, float occupied_threshold)
+{
+  if (value < 0)
+    return CARMEN_MAP_CELL_UNKNOWN;
+  if (value > occupied_threshold)
+    return CARMEN_MAP_CELL_OCCUPIED;
+  return CARMEN_MAP_CELL_FREE;
+}
+
+float
+carmen_map_util_compact_map_get(carmen_compact_map_p map, int x, int y)
+{
+  int cell;
+
+  if (map->encoding == CARMEN_MAP_ENCODING_U8) {
+    cell = CARMEN_COMPACT_MAP_U8_CELL(map, x, y);
+    if (cell == CARMEN_MAP_U8_UNKNOWN)
+      return -1;
+    return cell / (float)CARMEN_MAP_U8_MAX;
+  }
+
+  cell = CARMEN_COMPACT_MAP_BITMAP_CELL(map, x, y);
+  if (cell == CARMEN_MAP_CELL_FREE)
+    return 0.0;
+  else if (cell == CARMEN_MAP_CELL_OCCUPIED)
+    return 1.0;
+  return -1;
+}
+
+void
+carmen_map_util_compact_map_set(carmen_compact_map_p map, int x, int y,
+				float value)
+{
+  unsigned char *byte;
+  int shift;
+
+  if (map->encoding == CARMEN_MAP_ENCODING_U8) {
+    CARMEN_COMPACT_MAP_U8_CELL(map, x, y) = encode_u8(value);
+    return;
+  }
+
+  byte = map->data+x*map->column_bytes+(y >> 2);
+  shift = (y & 3) << 1;
+  *byte = (*byte & ~(3 << shift)) | 
+    (encode_bitmap(value, map->occupied_threshold) << shift);
+}
+
+typedef struct {
+  carmen_map_p map;
+  carmen_compact_map_p compact;
+} compact_job_t;
+
+static void
+compact_columns(void *data, int begin, int end)
+{
+  compact_job_t *job = (compact_job_t *)data;
+  int y_size = job->map->config.y_size;
+  float threshold = job->compact->occupied_threshold;
+  unsigned char *dest;
+  float *column;
+  int x, y, bits;
+
+  for (x = begin; x < end; x++) {
+    column = job->map->map[x];
+    dest = job->compact->data+x*job->compact->column_bytes;
+    if (job->compact->encoding == CARMEN_MAP_ENCODING_U8) {
+      for (y = 0; y < y_size; y++)
+	dest[y] = encode_u8(column[y]);
+      continue;
+    }
+    for (y = 0; y < y_size; y += 4) {
+      bits = encode_bitmap(column[y], threshold);
+      if (y+1 < y_size)
+	bits |= encode_bitmap(column[y+1], threshold) << 2;
+      else
+	bits |= CARMEN_MAP_CELL_UNKNOWN << 2;
+      if (y+2 < y_size)
+	bits |= encode_bitmap(column[y+2], threshold) << 4;
+      else
+	bits |= CARMEN_MAP_CELL_UNKNOWN << 4;
+      if (y+3 < y_size)
+	bits |= encode_bitmap(column[y+3], threshold) << 6;
+      else
+	bits |= CARMEN_MAP_CELL_UNKNOWN << 6;
+      dest[y >> 2] = bits;
+    }
+  }
+}
+
+static void
+expand_columns(void *data, int begin, int end)
+{
+  static const float bitmap_value[4] = {0.0, 1.0, -1, -1};
+  compact_job_t *job = (compact_job_t *)data;
+  int y_size = job->map->config.y_size;
+  float u8_value[256];
+  unsigned char *src;
+  float *column;
+  int x, y;
+
+  for (y = 0; y < 256; y++)
+    u8_value[y] = (y > CARMEN_MAP_U8_MAX) ? -1 : y / (float)CARMEN_MAP_U8_MAX;
+
+  for (x = begin; x < end; x++) {
+    column = job->map->map[x];
+    src = job->compact->data+x*job->compact->column_bytes;
+    if (job->compact->encoding == CARMEN_MAP_ENCODING_U8)
+      for (y = 0; y < y_size; y++)
+	column[y] = u8_value[src[y]];
+    else
+      for (y = 0; y < y_size; y++)
+	column[y] = bitmap_value[(src[y >> 2] >> ((y & 3) << 1)) & 3];
+  }
+}
+
+carmen_compact_map_p
+carmen_map_util_compact_map(carmen_map_p map, int encoding,
+			    float occupied_threshold)
+{
+  compact_job_t job;
+
+  job.map = map;
+  job.compact = carmen_map_util_new_compact_map(map->config, encoding,
+						occupied_threshold);
+  if (job.compact == NULL)
+    return NULL;
+
+  for_each_column_range(map->config.x_size, 0, compact_columns, &job);
+
+  return job.compact;
+}
+
+void
+carmen_map_util_expand_compact_map(carmen_compact_map_p compact, 
+				   carmen_map_p map)
+{
+  compact_job_t job;
+
+  alloc_gridmap(map, compact->config);
+
+  job.map = map;
+  job.compact = compact;
+  for_each_column_range(map->config.x_size, 0, expand_columns, &job);
+}
+
+/* Exact Euclidean distance transform (Felzenszwalb and Huttenlocher):
+   squared distances are separable, so a first pass finds the distance
+   to the closest obstacle within each column and a second pass takes
+   the lower envelope of the parabolas (x-q)^2 + g(q) along each row.
+   Both passes are linear in the number of cells. Columns of the first
+   pass and blocks of rows of the second pass are split across threads.
+   The row pass gathers DISTANCE_ROW_BLOCK rows at once, so that every
+   cache line of the column-major scratch map is read only once. */
+
+#define DISTANCE_ROW_BLOCK   16
+
+typedef struct {
+  carmen_map_p map;
+  carmen_map_p distance;
+  float free_threshold;
+  int x_start, y_start, x_end, y_end;
+  int ex_start, ey_start, ex_end, ey_end;
+  float max_distance;
+  float no_obstacle;
+  float *column_distance;
+} distance_job_t;
+
+static void
+distance_columns(void *data, int begin, int end)
+{
+  distance_job_t *job = (distance_job_t *)data;
+  int height = job->ey_end-job->ey_start;
+  float *cell, *g;
+  int x, y, last;
+
+  for (x = begin; x < end; x++) {
+    cell = job->map->map[job->ex_start+x]+job->ey_start;
+    g = job->column_distance+(long)x*height;
+
+    last = -height;
+    for (y = 0; y < height; y++) {
+      if (!(cell[y] >= 0 && cell[y] < job->free_threshold))
+	last = y;
+      g[y] = y-last;
+    }
+    last = 2*height;
+    for (y = height-1; y >= 0; y--) {
+      if (g[y] == 0)
+	last = y;
+      if (last-y < g[y])
+	g[y] = last-y;
+      g[y] = g[y] >= height ? job->no_obstacle : g[y]*g[y];
+    }
+  }
+}
+
+/* Lower envelope of the parabolas rooted at (q, f[q]), evaluated at
+   the cells [begin, end) of the row. h caches f[q] + q^2. */
+static void
+distance_row(float *f, int width, int begin, int end, int *v, double *z,
+	     double *h, float *row)
+{
+  double s;
+  int k, q;
+
+  for (q = 0; q < width; q++)
+    h[q] = f[q]+(double)q*q;
+
+  k = 0;
+  v[0] = 0;
+  z[0] = -DBL_MAX;
+  z[1] = DBL_MAX;
+  for (q = 1; q < width; q++) {
+    s = (h[q]-h[v[k]])/(2*(q-v[k]));
+    while (s <= z[k]) {
+      k--;
+      s = (h[q]-h[v[k]])/(2*(q-v[k]));
+    }
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k+1] = DBL_MAX;
+  }
+
+  k = 0;
+  for (q = begin; q < end; q++) {
+    while (z[k+1] < q)
+      k++;
+    row[q-begin] = (q-v[k])*(q-v[k])+f[v[k]];
+  }
+}
+
+static void
+distance_rows(void *data, int begin, int end)
+{
+  distance_job_t *job = (distance_job_t *)data;
+  int width = job->ex_end-job->ex_start;
+  int height = job->ey_end-job->ey_start;
+  int row_width = job->x_end-job->x_start;
+  float resolution = job->distance->config.resolution;
+  float *f, *row, *g, *column, value;
+  double *z, *h;
+  int *v;
+  int y, block, b, x;
+
+  f = (float *)calloc(DISTANCE_ROW_BLOCK*width, sizeof(float));
+  carmen_test_alloc(f);
+  row = (float *)calloc(DISTANCE_ROW_BLOCK*row_width, sizeof(float));
+  carmen_test_alloc(row);
+  v = (int *)calloc(width, sizeof(int));
+  carmen_test_alloc(v);
+  z = (double *)calloc(width+1, sizeof(double));
+  carmen_test_alloc(z);
+  h = (double *)calloc(width, sizeof(double));
+  carmen_test_alloc(h);
+
+  for (y = begin; y < end; y += block) {
+    block = end-y < DISTANCE_ROW_BLOCK ? end-y : DISTANCE_ROW_BLOCK;
+
+    for (x = 0; x < width; x++) {
+      g = job->column_distance+(long)x*height+job->y_start-job->ey_start+y;
+      for (b = 0; b < block; b++)
+	f[b*width+x] = g[b];
+    }
+    for (b = 0; b < block; b++)
+      distance_row(f+b*width, width, job->x_start-job->ex_start,
+		   job->x_end-job->ex_start, v, z, h, row+b*row_width);
+
+    for (x = 0; x < row_width; x++) {
+      column = job->distance->map[job->x_start+x]+job->y_start+y;
+      for (b = 0; b < block; b++) {
+	value = sqrt(row[b*row_width+x])*resolution;
+	if (job->max_distance > 0 && value > job->max_distance)
+	  value = job->max_distance;
+	column[b] = value;
       }
+    }
+  }
+
+  free(f);
+  free(row);
+  free(v);
+  free(z);
+  free(h);
+}
+
+void
+carmen_map_util_distance_transform_region(carmen_map_p map, 
+					  float free_threshold,
+					  carmen_map_p distance,
+					  int x_start, int y_start, 
+					  int x_end, int y_end,
+					  double max_distance)
+{
+  distance_job_t job;
+  int margin, width, height;
+
+  job.map = map;
+  job.distance = distance;
+  job.free_threshold = free_threshold;
+  job.x_start = carmen_clamp(0, x_start, map->config.x_size);
+  job.y_start = carmen_clamp(0, y_start, map->config.y_size);
+  job.x_end = carmen_clamp(0, x_end, map->config.x_size);
+  job.y_end = carmen_clamp(0, y_end, map->config.y_size);
+  if (job.x_end <= job.x_start || job.y_end <= job.y_start)
+    return;
+
+  /* Obstacles further than max_distance from the region cannot bring
+     any of its cells below max_distance. */
+  if (max_distance > 0) {
+    margin = ceil(max_distance/map->config.resolution)+1;
+    job.ex_start = carmen_clamp(0, job.x_start-margin, map->config.x_size);
+    job.ey_start = carmen_clamp(0, job.y_start-margin, map->config.y_size);
+    job.ex_end = carmen_clamp(0, job.x_end+margin, map->config.x_size);
+    job.ey_end = carmen_clamp(0, job.y_end+margin, map->config.y_size);
+  } else {
+    job.ex_start = 0;
+    job.ey_start = 0;
+    job.ex_end = map->config.x_size;
+    job.ey_end = map->config.y_size;
+  }
+  job.max_distance = max_distance;
+
+  width = job.ex_end-job.ex_start;
+  height = job.ey_end-job.ey_start;
+  job.no_obstacle = (float)width*width+(float)height*height;
+  job.column_distance = (float *)calloc((long)width*height, sizeof(float));
+  carmen_test_alloc(job.column_distance);
+
+  /* The column pass reads all of map before the row pass writes
+     distance, so both may be the same map. */
+  for_each_column_range(width, 0, distance_columns, &job);
+  for_each_column_range(job.y_end-job.y_start, 0, distance_rows, &job);
+
+  free(job.column_distance);
+}
 
-      if (tmp < 0)
-	tmp = -1;
-      if (tmp > 1.0)
-	tmp = 1.0;
-      new_map[x][y] = tmp;
-    }		
+void
+carmen_map_util_distance_transform(carmen_map_p map, float free_threshold,
+				   carmen_map_p distance)
+{
+  carmen_map_util_distance_transform_region(map, free_threshold, distance,
+					    0, 0, map->config.x_size, 
+					    map->config.y_size, 0);
+}
+
+void
+carmen_map_util_footprint_radii(carmen_robot_config_t *robot_conf, 
+				double resolution, double *inscribed, 
+				double *circumscribed)
+{
+  if (robot_conf->rectangular) {
+    *inscribed = carmen_fmin(robot_conf->width, robot_conf->length)/2;
+    *circumscribed = hypot(robot_conf->width, robot_conf->length)/2;
+  } else {
+    *inscribed = robot_conf->width/2;
+    *circumscribed = robot_conf->width/2;
   }
 
-  free(padded_map);
-  free(padded_backing);
+  /* Distances are float multiples of the resolution; the slack keeps
+     a cell exactly one radius away on the colliding side. */
+  *inscribed += 1e-3*resolution;
+  *circumscribed += 1e-3*resolution;
+}
 
-  free(map->map);
-  free(map->complete_map);
+void
+carmen_map_util_distance_to_cspace(carmen_map_p distance, 
+				   carmen_robot_config_t *robot_conf)
+{
+  double inscribed, circumscribed;
+  float *cell;
+  long index, num_cells;
 
-  map->map = new_map;
-  map->complete_map = new_complete_map;
-  map->config = new_config;
+  carmen_map_util_footprint_radii(robot_conf, distance->config.resolution,
+				  &inscribed, &circumscribed);
+
+  cell = distance->complete_map;
+  num_cells = (long)distance->config.x_size*distance->config.y_size;
+  for (index = 0; index < num_cells; index++)
+    cell[index] = cell[index] <= inscribed ? 1.0 : 0.0;
 }
 
 
@@ -29,7 +29,107 @@
 #ifndef CARMEN_MAP_UTIL_H
 #define CARMEN_MAP_UTIL_H
 
+#include "map.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Reducers for combining a block of map cells into one coarser cell.
+    MIN and MAX keep the most optimistic and the most conservative
+    occupancy of the block, MEAN its average. Unknown (negative) cells
+    are ignored.
+  */
+typedef enum {
+  CARMEN_MAP_REDUCE_MEAN,
+  CARMEN_MAP_REDUCE_MIN,
+  CARMEN_MAP_REDUCE_MAX
+} carmen_map_reducer_t;
+
+/** A stack of gridmaps at successively halved resolutions. level[0]
+    is a copy of the source map, level[i] has 2^i times its resolution
+    (cell size).
+  */
+typedef struct {
+  int num_levels;
+  carmen_map_reducer_t reducer;
+  carmen_map_p level;
+} carmen_map_pyramid_t, *carmen_map_pyramid_p;
+
 void carmen_map_util_change_resolution(carmen_map_p map, double new_resolution);
+
+/** Builds up to num_levels pyramid levels of map in one pass. Stops
+    early once a level is a single cell. num_threads <= 0 uses all
+    online processors.
+  */
+carmen_map_pyramid_p 
+carmen_map_util_build_pyramid(carmen_map_p map, int num_levels,
+			      carmen_map_reducer_t reducer, int num_threads);
+void carmen_map_util_free_pyramid(carmen_map_pyramid_p pyramid);
+
+/** Allocates a compact map (see carmen_compact_map_t) with every cell
+    unknown. Returns NULL for an unknown encoding.
+  */
+carmen_compact_map_p 
+carmen_map_util_new_compact_map(carmen_map_config_t config, int encoding,
+				float occupied_threshold);
+void carmen_map_util_free_compact_map(carmen_compact_map_p map);
+
+/** Converts map to the given compact encoding. occupied_threshold is
+    only used by CARMEN_MAP_ENCODING_BITMAP.
+  */
+carmen_compact_map_p 
+carmen_map_util_compact_map(carmen_map_p map, int encoding,
+			    float occupied_threshold);
+
+/** Allocates map and fills it with the cells of compact, decoded to
+    the usual occupancy values (-1 for unknown).
+  */
+void carmen_map_util_expand_compact_map(carmen_compact_map_p compact, 
+					carmen_map_p map);
+
+/** Cell accessors with the same values as carmen_map_t::map[x][y]. */
+float carmen_map_util_compact_map_get(carmen_compact_map_p map, int x, int y);
+void carmen_map_util_compact_map_set(carmen_compact_map_p map, int x, int y,
+				     float value);
+
+/** Exact Euclidean distance transform. Every cell of distance gets the
+    distance in metres from its centre to the centre of the closest
+    obstacle of map, i.e. the closest cell that is unknown or not below
+    free_threshold. Without any obstacle, cells get more than the
+    length of the map diagonal. distance must have the configuration of
+    map and may be map itself.
+  */
+void carmen_map_util_distance_transform(carmen_map_p map, float free_threshold,
+					carmen_map_p distance);
+
+/** Recomputes the cells [x_start, x_end) x [y_start, y_end) of distance
+    only. Obstacles further than max_distance from the region are
+    ignored, so the result is exact up to max_distance and clamped to
+    it. max_distance <= 0 takes all obstacles into account.
+  */
+void carmen_map_util_distance_transform_region(carmen_map_p map, 
+					       float free_threshold,
+					       carmen_map_p distance,
+					       int x_start, int y_start, 
+					       int x_end, int y_end,
+					       double max_distance);
+
+/** Footprint radii of a robot centred in a cell: with an obstacle at
+    most inscribed away, the robot collides in every heading, with none
+    closer than circumscribed, in no heading. Both are half the width
+    for round robots; rectangular robots use width and length.
+  */
+void carmen_map_util_footprint_radii(carmen_robot_config_t *robot_conf, 
+				     double resolution, double *inscribed,
+				     double *circumscribed);
+
+/** Turns a distance map into the configuration space of the robot, in
+    place: 1.0 where it collides in every heading, 0.0 elsewhere.
+  */
+void carmen_map_util_distance_to_cspace(carmen_map_p distance, 
+					carmen_robot_config_t *robot_conf);
+
 void carmen_minimize_gridmap(carmen_map_p map, int *x_offset, int *y_offset);
 void carmen_minimize_offlimits(carmen_offlimits_list_t *offlimits_list, 
 			       double x_offset, double y_offset);
@@ -47,4 +147,8 @@ void carmen_rotate_places(carmen_map_config_t config,
 			  carmen_map_placelist_p place_list, 
 			  int rotation);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -40,6 +40,8 @@ void (*client_exit_handler)(void);
 
 int carmen_allow_no_centrals = 0;
 
+#define MAX_MESSAGES_PER_DISPATCH 100
+
 int carmen_multicentral_ipc_connect(char *ipc_module_name, char *central_name)
 {
   IPC_RETURN_TYPE err;
@@ -290,23 +292,98 @@ void carmen_multicentral_reconnect_centrals(carmen_centrallist_p centrallist,
     }
 }
 
+/* Handles the messages waiting on one central, but not so many that the
+   other centrals starve. Returns 1 if messages may be left over. */
+
+static int dispatch_central(carmen_central_p central)
+{
+  IPC_RETURN_TYPE err;
+  int num_messages = 0;
+
+  IPC_setContext(central->context);
+  do {
+    err = IPC_listen(0);
+    num_messages++;
+  } while(err == IPC_OK && central->connected && 
+	  num_messages < MAX_MESSAGES_PER_DISPATCH);
+
+  return (err == IPC_OK && central->connected);
+}
+
 void carmen_multicentral_ipc_sleep(carmen_centrallist_p centrallist, 
 				   double sleep_time)
 {
-  int i, count = 0;
+  static fd_set *connections = NULL;
+  static int *pending = NULL;
+  static int max_centrals = 0;
+  fd_set read_set;
+  struct timeval timeout;
+  double end_time, remaining_time;
+  int i, fd, max_fd, count, ready, num_pending;
+
+  if(centrallist->num_centrals > max_centrals) {
+    connections = (fd_set *)realloc(connections, centrallist->num_centrals *
+				    sizeof(fd_set));
+    carmen_test_alloc(connections);
+    pending = (int *)realloc(pending, centrallist->num_centrals * 
+			     sizeof(int));
+    carmen_test_alloc(pending);
+    for(i = max_centrals; i < centrallist->num_centrals; i++)
+      pending[i] = 0;
+    max_centrals = centrallist->num_centrals;
+  }
 
-  for(i = 0; i < centrallist->num_centrals; i++) 
-    if(centrallist->central[i].connected) 
-      count++;
-  
-  if(count == 0)
-    usleep((int)(sleep_time * 1e6));
-  else {
-    /* handle IPC messages for each central */
+  end_time = carmen_get_wall_time() + sleep_time;
+  do {
+    /* wait on the sockets of all centrals at once, so that a message is
+       handled as soon as it arrives on any of them */
+    FD_ZERO(&read_set);
+    max_fd = -1;
+    count = 0;
+    num_pending = 0;
     for(i = 0; i < centrallist->num_centrals; i++) 
       if(centrallist->central[i].connected) {
+	num_pending += pending[i];
 	IPC_setContext(centrallist->central[i].context);
-	carmen_ipc_sleep(sleep_time / count);
+	connections[i] = IPC_getConnections();
+	for(fd = 0; fd < FD_SETSIZE; fd++)
+	  if(FD_ISSET(fd, &connections[i])) {
+	    FD_SET(fd, &read_set);
+	    if(fd > max_fd)
+	      max_fd = fd;
+	  }
+	count++;
       }
-  }
+      else
+	pending[i] = 0;
+
+    /* messages left over from the last dispatch are not signalled by
+       their sockets */
+    remaining_time = carmen_fmax(end_time - carmen_get_wall_time(), 0.0);
+    if(num_pending > 0)
+      remaining_time = 0;
+    if(count == 0) {
+      usleep((int)(remaining_time * 1e6));
+      return;
+    }
+
+    timeout.tv_sec = (int)remaining_time;
+    timeout.tv_usec = (int)((remaining_time - timeout.tv_sec) * 1e6);
+    ready = select(max_fd + 1, &read_set, NULL, NULL, &timeout);
+    if(ready < 0 && errno != EINTR) {
+      carmen_warn("MULTICENTRAL: select failed: %s\n", strerror(errno));
+      return;
+    }
+
+    /* dispatch only the centrals with pending data */
+    for(i = 0; i < centrallist->num_centrals; i++) {
+      if(!centrallist->central[i].connected)
+	continue;
+      for(fd = 0; ready > 0 && !pending[i] && fd <= max_fd; fd++)
+	if(FD_ISSET(fd, &connections[i]) && FD_ISSET(fd, &read_set))
+	  pending[i] = 1;
+      if(pending[i])
+	pending[i] = dispatch_central(&centrallist->central[i]);
+    }
+  } while(carmen_get_wall_time() < end_time);
 }
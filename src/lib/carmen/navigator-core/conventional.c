@@ -30,6 +30,7 @@
 #include <float.h>
 
 #include "global.h"
+#include "map_util.h"
 #include "navigator.h"
 #include "conventional.h"
 
@@ -42,7 +43,9 @@ extern int carmen_planner_y_offset[NUM_ACTIONS];
 #define MAX_UTILITY 1000.0
 /* How much to reduce the cost per meter.
    Kind of arbitrary, but related to MAX_UTILITY */
-#define MIN_COST 0.1
+#define MIN_COST CARMEN_CONVENTIONAL_MIN_COST
+/* Obstacle distance in metres at which the cost function reaches 0 */
+#define COST_DISTANCE 1.0
 
 struct state_struct {
   int x, y;
@@ -64,6 +67,10 @@ static int x_size, y_size;
 
 static double *costs = NULL;
 static double *utility = NULL;
+static carmen_map_t distance;
+/* the cell whose cost clear_robot_cost overrode, or -1 */
+static int robot_index = -1;
+static double robot_cost;
 
 carmen_inline static int
 is_out_of_map(int x, int y)
@@ -243,33 +250,149 @@ insert_into_queue(state_ptr new_state, queue the_queue)
     }
 }
 
-void carmen_conventional_build_costs(carmen_robot_config_t *robot_conf,
-				     carmen_map_point_t *robot_posn,
-				     carmen_navigator_config_t *navigator_conf)
+double
+carmen_conventional_distance_to_cost(double distance, double inscribed,
+				     double circumscribed)
 {
-  int x_index = 0, y_index = 0;
   double value;
-  double *cost_ptr;
-  float *map_ptr;
-  double resolution;
-  int index;
-  int x, y;
-  int x_start, y_start;
-  int x_end, y_end;
-  double robot_distance;
 
-  carmen_verbose("Building costs...");
+  /* Any cell closer than the inscribed radius is impassable in every
+     heading. Cells that only some headings of a rectangular robot
+     can occupy get the max cost of 0.5, all others a cost falling off
+     with the distance d as (1 - d)/2 down to MIN_COST. */
+
+  if (distance <= inscribed)
+    return 1.0;
+  if (distance <= circumscribed)
+    return 0.5;
+
+  value = (COST_DISTANCE - distance) / 2;
+  if (value < MIN_COST)
+    value = MIN_COST;
+  return value;
+}
 
+static void
+resize_grids(void)
+{
   if (x_size != carmen_planner_map->config.x_size ||
       y_size != carmen_planner_map->config.y_size) {
     free(costs);
     costs = NULL;
     free(utility);
     utility = NULL;
+    free(distance.complete_map);
+    distance.complete_map = NULL;
+    free(distance.map);
+    distance.map = NULL;
+    robot_index = -1;
   }
 
   x_size = carmen_planner_map->config.x_size;
   y_size = carmen_planner_map->config.y_size;
+}
+
+static void
+alloc_distance(void)
+{
+  int x_index;
+
+  if (distance.complete_map != NULL)
+    return;
+
+  distance.config = carmen_planner_map->config;
+  distance.complete_map = (float *)calloc(x_size*y_size, sizeof(float));
+  carmen_test_alloc(distance.complete_map);
+  distance.map = (float **)calloc(x_size, sizeof(float *));
+  carmen_test_alloc(distance.map);
+  for (x_index = 0; x_index < x_size; x_index++)
+    distance.map[x_index] = distance.complete_map+x_index*y_size;
+}
+
+/* The distances stay unknown until the dirty regions of an update
+   compute them, which leaves the supplied costs elsewhere alone. */
+void
+carmen_conventional_set_costs(double *new_costs)
+{
+  resize_grids();
+  alloc_distance();
+
+  if (costs == NULL) {
+    costs = (double *)calloc(x_size*y_size, sizeof(double));
+    carmen_test_alloc(costs);
+  }
+  memcpy(costs, new_costs, x_size*y_size*sizeof(double));
+  robot_index = -1;
+}
+
+/* Costs of the cells in a region, from the distances to the obstacles
+   of the planner map. Only obstacles that can raise the cost of a cell
+   above MIN_COST matter. */
+static void
+compute_costs(carmen_robot_config_t *robot_conf, int x_start, int y_start,
+	      int x_end, int y_end)
+{
+  int x_index, y_index;
+  double *cost_ptr;
+  float *distance_ptr;
+  double inscribed, circumscribed;
+
+  x_start = carmen_clamp(0, x_start, x_size);
+  y_start = carmen_clamp(0, y_start, y_size);
+  x_end = carmen_clamp(0, x_end, x_size);
+  y_end = carmen_clamp(0, y_end, y_size);
+
+  /* Distance from every cell to the closest cell that is not empty
+     (at least MIN_COST, or unknown). */
+
+  carmen_map_util_footprint_radii(robot_conf, 
+				  carmen_planner_map->config.resolution,
+				  &inscribed, &circumscribed);
+  carmen_map_util_distance_transform_region(carmen_planner_map, MIN_COST,
+					    &distance, x_start, y_start,
+					    x_end, y_end, 
+					    COST_DISTANCE+circumscribed);
+
+  for (x_index = x_start; x_index < x_end; x_index++) {
+    cost_ptr = costs+x_index*y_size+y_start;
+    distance_ptr = distance.map[x_index]+y_start;
+    for (y_index = y_start; y_index < y_end; y_index++)
+      *(cost_ptr++) = carmen_conventional_distance_to_cost
+	(*(distance_ptr++), inscribed, circumscribed);
+  }
+}
+
+/* The cell of the robot is never an obstacle to the planner. */
+static void
+clear_robot_cost(carmen_map_point_t *robot_posn)
+{
+  int x_index, y_index;
+
+  robot_index = -1;
+  if (robot_posn == NULL)
+    return;
+
+  x_index = robot_posn->x / carmen_planner_map->config.resolution;
+  y_index = robot_posn->y / carmen_planner_map->config.resolution;
+
+  if (x_index >= 0 && x_index < x_size && y_index >= 0 && y_index < y_size) {
+    robot_index = x_index*y_size+y_index;
+    robot_cost = costs[robot_index];
+    costs[robot_index] = MIN_COST;
+  }
+}
+
+void carmen_conventional_build_costs(carmen_robot_config_t *robot_conf,
+				     carmen_map_point_t *robot_posn,
+				     carmen_navigator_config_t *navigator_conf)
+{
+  int index;
+  int x_start, y_start;
+  int x_end, y_end;
+
+  carmen_verbose("Building costs...");
+
+  resize_grids();
 
   if (costs == NULL) {
     costs = (double *)calloc(x_size*y_size, sizeof(double));
@@ -278,128 +401,87 @@ void carmen_conventional_build_costs(carmen_robot_config_t *robot_conf,
       costs[index] = carmen_planner_map->complete_map[index];
   }
 
-  resolution = carmen_planner_map->config.resolution;
+  alloc_distance();
 
   if (robot_posn && navigator_conf) {
     x_start = robot_posn->x - navigator_conf->map_update_radius/
       robot_posn->map->config.resolution;
-    x_start = carmen_clamp(0, x_start, x_size);
     y_start = robot_posn->y - navigator_conf->map_update_radius/
       robot_posn->map->config.resolution;
-    y_start = carmen_clamp(0, y_start, y_size);
     x_end = robot_posn->x + navigator_conf->map_update_radius/
       robot_posn->map->config.resolution;
-    x_end = carmen_clamp(0, x_end, x_size);
     y_end = robot_posn->y + navigator_conf->map_update_radius/
       robot_posn->map->config.resolution;
-    y_end = carmen_clamp(0, y_end, y_size);
-
-    cost_ptr = costs+x_start*y_size;
-    map_ptr = carmen_planner_map->complete_map+x_start*y_size;
-    for (x_index = x_start; x_index < x_end; x_index++) {
-      for (y_index = y_start; y_index < y_end; y_index++)
-	cost_ptr[y_index] = map_ptr[y_index];
-      cost_ptr += y_size;
-      map_ptr += y_size;
-    }
   } else {
     x_start = 0;
     y_start = 0;
     x_end = x_size;
     y_end = y_size;
-
-    for (index = 0; index < x_size*y_size; index++)
-      costs[index] = carmen_planner_map->complete_map[index];
   }
 
+  compute_costs(robot_conf, x_start, y_start, x_end, y_end);
+  clear_robot_cost(robot_posn);
 
-  /* Initialize cost function to match map, where empty cells have
-     MIN_COST cost and filled cells have MAX_UTILITY cost */
-
-  for (x_index = x_start; x_index < x_end; x_index++) {
-    cost_ptr = costs+x_index*y_size+y_start;
-    for (y_index = y_start; y_index < y_end; y_index++) {
-      value = *(cost_ptr);
-      if (value >= 0 && value < MIN_COST)
-	value = MIN_COST;
-      else
-	value = MAX_UTILITY;
-      *(cost_ptr++) = value;
-    }
-  }
-
-  /* Loop through cost map, starting at top left, updating cost of cell
-     as max of itself and most expensive neighbour less the cost
-     downgrade. */
+  carmen_verbose("done\n");
+}
 
-  for (x_index = x_start; x_index < x_end; x_index++) {
-    cost_ptr = costs+x_index*y_size+y_start;
-    for (y_index = y_start; y_index < y_end; y_index++, cost_ptr++) {
-      if (x_index < 1 || x_index >= x_size-1 || y_index < 1 ||
-	  y_index >= y_size-1)
-	continue;
+void 
+carmen_conventional_update_costs(carmen_robot_config_t *robot_conf,
+				 carmen_map_point_t *robot_posn,
+				 int num_regions, int *regions)
+{
+  double inscribed, circumscribed;
+  int margin, index, *region;
+  int x_start, y_start, x_end, y_end;
+  double area, bounds_area;
 
-      for (index = 0; index < NUM_ACTIONS; index++) {
-	x = x_index + carmen_planner_x_offset[index];
-	y = y_index + carmen_planner_y_offset[index];
+  resize_grids();
 
-	value = *(costs+x*y_size+y) - resolution*MAX_UTILITY;
-	if (value > *cost_ptr)
-	  *cost_ptr = value;
-      }
-    }
+  if (costs == NULL) {
+    carmen_conventional_build_costs(robot_conf, NULL, NULL);
+    clear_robot_cost(robot_posn);
+    return;
   }
-
-  /* Loop through cost map again, starting at bottom right, updating cost of
-     cell as max of itself and most expensive neighbour less the cost
-     downgrade. */
-
-  for (x_index = x_end-1; x_index >= x_start; x_index--) {
-    cost_ptr = costs+x_index*y_size+y_end-1;
-    for (y_index = y_end-1; y_index >= y_start; y_index--, cost_ptr--) {
-      if (x_index < 1 || x_index >= x_size-1 || y_index < 1 ||
-	  y_index >= y_size-1)
-	continue;
-
-      for (index = 0; index < NUM_ACTIONS; index++) {
-	x = x_index + carmen_planner_x_offset[index];
-	y = y_index + carmen_planner_y_offset[index];
-
-	value = *(costs+x*y_size+y) - resolution*MAX_UTILITY;
-	if (value > *cost_ptr)
-	  *cost_ptr = value;
-      }
-    }
+  alloc_distance();
+
+  carmen_map_util_footprint_radii(robot_conf, 
+				  carmen_planner_map->config.resolution,
+				  &inscribed, &circumscribed);
+  if (robot_index >= 0)
+    costs[robot_index] = robot_cost;
+
+  /* A changed cell changes the distances up to the cost distance
+     around it. Where the grown regions overlap a lot, one pass over
+     their bounds is cheaper. */
+  margin = ceil((COST_DISTANCE+circumscribed)/
+		carmen_planner_map->config.resolution)+1;
+  x_start = x_size;
+  y_start = y_size;
+  x_end = 0;
+  y_end = 0;
+  area = 0;
+  for (index = 0; index < num_regions; index++) {
+    region = regions+4*index;
+    x_start = carmen_imin(x_start, region[0]);
+    y_start = carmen_imin(y_start, region[1]);
+    x_end = carmen_imax(x_end, region[2]);
+    y_end = carmen_imax(y_end, region[3]);
+    area += (double)(region[2]-region[0]+2*margin)*
+      (region[3]-region[1]+2*margin);
   }
-
-  robot_distance = robot_conf->width/2*MAX_UTILITY;
-
-  /* Clamp any cell that's closer than the robot width to be
-     impassable. Also, rescale cost function so that the max cost
-     is 0.5 */
-
-  for (x_index = x_start; x_index < x_end; x_index++) {
-    cost_ptr = costs+x_index*y_size+y_start;
-    for (y_index = y_start; y_index < y_end; y_index++) {
-      value = *(cost_ptr);
-      if (value < MAX_UTILITY - robot_distance) {
-	value = value / (2*MAX_UTILITY);
-	if (value < MIN_COST)
-	  value = MIN_COST;
-      } else
-	value = 1.0;
-      *(cost_ptr++) = value;
+  bounds_area = (double)(x_end-x_start+2*margin)*(y_end-y_start+2*margin);
+
+  if (num_regions > 1 && area > bounds_area)
+    compute_costs(robot_conf, x_start-margin, y_start-margin,
+		  x_end+margin, y_end+margin);
+  else
+    for (index = 0; index < num_regions; index++) {
+      region = regions+4*index;
+      compute_costs(robot_conf, region[0]-margin, region[1]-margin,
+		    region[2]+margin, region[3]+margin);
     }
-  }
-
-  if (robot_posn != NULL) {
-    x_index = robot_posn->x / carmen_planner_map->config.resolution;
-    y_index = robot_posn->y / carmen_planner_map->config.resolution;
 
-    if (x_index >= 0 && x_index < x_size && y_index >= 0 && y_index < y_size)
-      *(costs+x_index*y_size+y_index) = MIN_COST;
-  }
-  carmen_verbose("done\n");
+  clear_robot_cost(robot_posn);
 }
 
 double
@@ -608,10 +690,16 @@ carmen_conventional_find_best_action(carmen_map_point_p curpoint)
 void
 carmen_conventional_end_planner(void)
 {
-  if (costs != NULL)
-    free(costs);
-  if (utility != NULL)
-    free(utility);
-
+  free(costs);
+  costs = NULL;
+  free(utility);
+  utility = NULL;
+  robot_index = -1;
+  if (distance.complete_map != NULL) {
+    free(distance.complete_map);
+    free(distance.map);
+    distance.complete_map = NULL;
+    distance.map = NULL;
+  }
 }
 
@@ -44,6 +44,9 @@
 extern "C" {
 #endif
 
+  /** Cost of a cell in free space, far from any obstacle. **/
+#define CARMEN_CONVENTIONAL_MIN_COST 0.1
+
   /** Computes the utility function using dynamic programming. 
       carmen_conventional_build_costs must have been
       called first. **/ 
@@ -72,6 +75,24 @@ extern "C" {
   void carmen_conventional_build_costs(carmen_robot_config_t *robot_conf,
 				       carmen_map_point_t *robot_posn,
 				       carmen_navigator_config_t *navigator_conf);
+  /** Rebuilds the costs that changes of the planner map within the
+      given regions can affect, e.g. the rectangles of
+      map_modify_get_dirty. regions holds num_regions rectangles of map
+      cells as x_start, y_start, x_end, y_end, the end excluded. Builds
+      all costs if none were built for the planner map yet. **/
+  void carmen_conventional_update_costs(carmen_robot_config_t *robot_conf,
+					carmen_map_point_t *robot_posn,
+					int num_regions, int *regions);
+  /** The cost of a cell at the given distance from the closest
+      obstacle, for a footprint with the given inscribed and circumscribed
+      radii (see carmen_map_util_footprint_radii). Cells with a cost of
+      1.0 are impassable. **/
+  double carmen_conventional_distance_to_cost(double distance, 
+					      double inscribed,
+					      double circumscribed);
+  /** Installs a cost map that was built in advance for the current
+      planner map, e.g. by the hmap planner, instead of building it. **/
+  void carmen_conventional_set_costs(double *new_costs);
 
 #ifdef __cplusplus
 }
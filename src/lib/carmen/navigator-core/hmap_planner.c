@@ -0,0 +1,822 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include <float.h>
+#include <pthread.h>
+
+#include "global.h"
+#include "map_interface.h"
+#include "map_util.h"
+#include "navigator.h"
+#include "conventional.h"
+#include "hmap_planner.h"
+
+#define ZONE_EMPTY    0
+#define ZONE_QUEUED   1
+#define ZONE_READY    2
+#define ZONE_FAILED   3
+
+/* A portal is one side of a link: the place where a robot in zone
+   enters the link. Doors have two posts per side and the portal is
+   the middle of the door; elevators have a single point per floor. */
+
+typedef struct {
+  int link, side, zone;
+  carmen_point_t point;
+  int num_posts;
+  carmen_point_t post[2];
+} portal_t;
+
+typedef struct {
+  int state;
+  carmen_map_p map;
+  double *costs;
+  int num_portals;
+  int *portals;
+  double *portal_costs;
+} zone_t;
+
+struct carmen_hmap_planner_t {
+  carmen_hmap_p hmap;
+  carmen_robot_config_t robot_conf;
+  carmen_hmap_planner_load_t load;
+  void *load_data;
+
+  int num_portals;
+  portal_t *portals;
+  zone_t *zones;
+
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t queued, ready;
+  int *queue;
+  int queue_length;
+  int shutdown;
+};
+
+int
+carmen_hmap_find_zone(carmen_hmap_p hmap, char *zone_name)
+{
+  int zone;
+
+  for (zone = 0; zone < hmap->num_zones; zone++)
+    if (!strcmp(hmap->zone_names[zone], zone_name))
+      return zone;
+
+  return -1;
+}
+
+/* Grid search */
+
+typedef struct {
+  int size, capacity;
+  double *cost;
+  int *cell;
+} heap_t;
+
+static void
+heap_push(heap_t *heap, double cost, int cell)
+{
+  int i, parent;
+
+  if (heap->size == heap->capacity) {
+    heap->capacity = heap->capacity ? 2*heap->capacity : 1024;
+    heap->cost = (double *)realloc(heap->cost,
+				   heap->capacity*sizeof(double));
+    carmen_test_alloc(heap->cost);
+    heap->cell = (int *)realloc(heap->cell, heap->capacity*sizeof(int));
+    carmen_test_alloc(heap->cell);
+  }
+
+  for (i = heap->size++; i > 0; i = parent) {
+    parent = (i-1)/2;
+    if (heap->cost[parent] <= cost)
+      break;
+    heap->cost[i] = heap->cost[parent];
+    heap->cell[i] = heap->cell[parent];
+  }
+  heap->cost[i] = cost;
+  heap->cell[i] = cell;
+}
+
+static int
+heap_pop(heap_t *heap, double *cost)
+{
+  double last_cost;
+  int cell, last_cell, i, child;
+
+  cell = heap->cell[0];
+  *cost = heap->cost[0];
+
+  last_cost = heap->cost[--heap->size];
+  last_cell = heap->cell[heap->size];
+  for (i = 0; 2*i+1 < heap->size; i = child) {
+    child = 2*i+1;
+    if (child+1 < heap->size && heap->cost[child+1] < heap->cost[child])
+      child++;
+    if (last_cost <= heap->cost[child])
+      break;
+    heap->cost[i] = heap->cost[child];
+    heap->cell[i] = heap->cell[child];
+  }
+  heap->cost[i] = last_cost;
+  heap->cell[i] = last_cell;
+
+  return cell;
+}
+
+static int
+point_to_cell(carmen_map_p map, carmen_point_p point)
+{
+  int x, y;
+
+  x = carmen_round(point->x / map->config.resolution);
+  y = carmen_round(point->y / map->config.resolution);
+  if (x < 0 || x >= map->config.x_size || y < 0 || y >= map->config.y_size)
+    return -1;
+
+  return x*map->config.y_size+y;
+}
+
+/* Dijkstra from the start cell over the 8-connected cost map. Entering
+   a cell costs the step length times its cost relative to free space;
+   impassable cells are never entered, although the search may start
+   in one. Stops as soon as all target cells are settled. */
+static void
+grid_search(zone_t *zone, int start, int *targets, int num_targets,
+	    double *field)
+{
+  static const int dx[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+  static const int dy[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+  int x_size = zone->map->config.x_size, y_size = zone->map->config.y_size;
+  double resolution = zone->map->config.resolution;
+  double step[8], cost, new_cost;
+  heap_t heap = {0, 0, NULL, NULL};
+  int i, cell, x, y, nx, ny, next, remaining;
+
+  for (i = 0; i < x_size*y_size; i++)
+    field[i] = DBL_MAX;
+  for (i = 0; i < 8; i++)
+    step[i] = (dx[i] && dy[i] ? M_SQRT2 : 1.0)*resolution/
+      CARMEN_CONVENTIONAL_MIN_COST;
+
+  remaining = 0;
+  for (i = 0; i < num_targets; i++)
+    if (targets[i] >= 0)
+      remaining++;
+
+  field[start] = 0;
+  heap_push(&heap, 0, start);
+  while (heap.size > 0) {
+    cell = heap_pop(&heap, &cost);
+    if (cost > field[cell])
+      continue;
+
+    for (i = 0; i < num_targets; i++)
+      if (targets[i] == cell)
+	remaining--;
+    if (num_targets > 0 && remaining <= 0)
+      break;
+
+    x = cell / y_size;
+    y = cell % y_size;
+    for (i = 0; i < 8; i++) {
+      nx = x+dx[i];
+      ny = y+dy[i];
+      if (nx < 0 || nx >= x_size || ny < 0 || ny >= y_size)
+	continue;
+      next = nx*y_size+ny;
+      if (zone->costs[next] >= 1.0)
+	continue;
+      new_cost = cost+step[i]*zone->costs[next];
+      if (new_cost < field[next]) {
+	field[next] = new_cost;
+	heap_push(&heap, new_cost, next);
+      }
+    }
+  }
+
+  free(heap.cost);
+  free(heap.cell);
+}
+
+/* Background thread */
+
+static void
+build_zone(carmen_hmap_planner_p planner, zone_t *zone)
+{
+  carmen_map_t distance;
+  double inscribed, circumscribed, *field;
+  int *targets, num_cells, i, j, n = zone->num_portals;
+
+  num_cells = zone->map->config.x_size*zone->map->config.y_size;
+
+  distance.config = zone->map->config;
+  distance.complete_map = (float *)calloc(num_cells, sizeof(float));
+  carmen_test_alloc(distance.complete_map);
+  distance.map = (float **)calloc(distance.config.x_size, sizeof(float *));
+  carmen_test_alloc(distance.map);
+  for (i = 0; i < distance.config.x_size; i++)
+    distance.map[i] = distance.complete_map+i*distance.config.y_size;
+
+  carmen_map_util_distance_transform(zone->map, CARMEN_CONVENTIONAL_MIN_COST,
+				     &distance);
+  carmen_map_util_footprint_radii(&planner->robot_conf,
+				  distance.config.resolution,
+				  &inscribed, &circumscribed);
+
+  zone->costs = (double *)calloc(num_cells, sizeof(double));
+  carmen_test_alloc(zone->costs);
+  for (i = 0; i < num_cells; i++)
+    zone->costs[i] = carmen_conventional_distance_to_cost
+      (distance.complete_map[i], inscribed, circumscribed);
+  free(distance.complete_map);
+  free(distance.map);
+
+  zone->portal_costs = (double *)calloc(n*n+1, sizeof(double));
+  carmen_test_alloc(zone->portal_costs);
+  targets = (int *)calloc(n+1, sizeof(int));
+  carmen_test_alloc(targets);
+  field = (double *)calloc(num_cells, sizeof(double));
+  carmen_test_alloc(field);
+
+  for (i = 0; i < n; i++)
+    targets[i] = point_to_cell(zone->map,
+			       &planner->portals[zone->portals[i]].point);
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < n; j++)
+      zone->portal_costs[i*n+j] = DBL_MAX;
+    if (targets[i] < 0)
+      continue;
+    grid_search(zone, targets[i], targets, n, field);
+    for (j = 0; j < n; j++)
+      if (targets[j] >= 0)
+	zone->portal_costs[i*n+j] = field[targets[j]];
+  }
+
+  free(targets);
+  free(field);
+}
+
+static void *
+zone_thread(void *arg)
+{
+  carmen_hmap_planner_p planner = (carmen_hmap_planner_p)arg;
+  zone_t *zone;
+
+  pthread_mutex_lock(&planner->mutex);
+  while (!planner->shutdown) {
+    if (planner->queue_length == 0) {
+      pthread_cond_wait(&planner->queued, &planner->mutex);
+      continue;
+    }
+    zone = &planner->zones[planner->queue[0]];
+    planner->queue_length--;
+    memmove(planner->queue, planner->queue+1,
+	    planner->queue_length*sizeof(int));
+    pthread_mutex_unlock(&planner->mutex);
+
+    build_zone(planner, zone);
+
+    pthread_mutex_lock(&planner->mutex);
+    zone->state = ZONE_READY;
+    pthread_cond_broadcast(&planner->ready);
+  }
+  pthread_mutex_unlock(&planner->mutex);
+
+  return NULL;
+}
+
+/* Planner */
+
+static void
+find_portals(carmen_hmap_planner_p planner)
+{
+  carmen_hmap_p hmap = planner->hmap;
+  carmen_hmap_link_p link;
+  portal_t *portal;
+  zone_t *zone;
+  int i, j, n;
+
+  for (i = 0; i < hmap->num_links; i++)
+    planner->num_portals += hmap->links[i].degree;
+  planner->portals = (portal_t *)calloc(planner->num_portals+1,
+					sizeof(portal_t));
+  carmen_test_alloc(planner->portals);
+
+  portal = planner->portals;
+  for (i = 0; i < hmap->num_links; i++) {
+    link = &hmap->links[i];
+    n = link->num_points / link->degree;
+    for (j = 0; j < link->degree; j++, portal++) {
+      portal->link = i;
+      portal->side = j;
+      portal->zone = link->keys[j];
+      if (n >= 2) {
+	portal->num_posts = 2;
+	portal->post[0] = link->points[j*n];
+	portal->post[1] = link->points[j*n+1];
+	portal->point.x = (portal->post[0].x + portal->post[1].x) / 2.0;
+	portal->point.y = (portal->post[0].y + portal->post[1].y) / 2.0;
+	portal->point.theta = atan2(portal->post[1].y - portal->post[0].y,
+				    portal->post[1].x - portal->post[0].x);
+      } else
+	portal->point = link->points[j*n];
+
+      zone = &planner->zones[portal->zone];
+      zone->portals[zone->num_portals++] = portal-planner->portals;
+    }
+  }
+}
+
+carmen_hmap_planner_p
+carmen_hmap_planner_new(carmen_hmap_p hmap, carmen_robot_config_t *robot_conf,
+			carmen_hmap_planner_load_t load, void *load_data)
+{
+  carmen_hmap_planner_p planner;
+  int i, num_sides = 0;
+
+  planner = (carmen_hmap_planner_p)calloc(1,
+					  sizeof(struct carmen_hmap_planner_t));
+  carmen_test_alloc(planner);
+
+  planner->hmap = hmap;
+  planner->robot_conf = *robot_conf;
+  planner->load = load;
+  planner->load_data = load_data;
+
+  for (i = 0; i < hmap->num_links; i++)
+    num_sides += hmap->links[i].degree;
+  planner->zones = (zone_t *)calloc(hmap->num_zones, sizeof(zone_t));
+  carmen_test_alloc(planner->zones);
+  for (i = 0; i < hmap->num_zones; i++) {
+    planner->zones[i].portals = (int *)calloc(num_sides+1, sizeof(int));
+    carmen_test_alloc(planner->zones[i].portals);
+  }
+  find_portals(planner);
+
+  planner->queue = (int *)calloc(hmap->num_zones, sizeof(int));
+  carmen_test_alloc(planner->queue);
+  pthread_mutex_init(&planner->mutex, NULL);
+  pthread_cond_init(&planner->queued, NULL);
+  pthread_cond_init(&planner->ready, NULL);
+  if (pthread_create(&planner->thread, NULL, zone_thread, planner))
+    carmen_die("Could not start the hmap planner thread\n");
+
+  return planner;
+}
+
+void
+carmen_hmap_planner_free(carmen_hmap_planner_p planner)
+{
+  zone_t *zone;
+  int i;
+
+  pthread_mutex_lock(&planner->mutex);
+  planner->shutdown = 1;
+  pthread_cond_signal(&planner->queued);
+  pthread_mutex_unlock(&planner->mutex);
+  pthread_join(planner->thread, NULL);
+
+  /* zones still queued were never built */
+  for (i = 0; i < planner->hmap->num_zones; i++) {
+    zone = &planner->zones[i];
+    if (zone->map)
+      carmen_map_destroy(&zone->map);
+    free(zone->costs);
+    free(zone->portals);
+    free(zone->portal_costs);
+  }
+
+  pthread_mutex_destroy(&planner->mutex);
+  pthread_cond_destroy(&planner->queued);
+  pthread_cond_destroy(&planner->ready);
+  free(planner->queue);
+  free(planner->zones);
+  free(planner->portals);
+  free(planner);
+}
+
+int
+carmen_hmap_planner_prefetch(carmen_hmap_planner_p planner, int zone_index)
+{
+  zone_t *zone;
+  carmen_map_p map;
+  int state;
+
+  if (zone_index < 0 || zone_index >= planner->hmap->num_zones)
+    return -1;
+  zone = &planner->zones[zone_index];
+
+  pthread_mutex_lock(&planner->mutex);
+  state = zone->state;
+  pthread_mutex_unlock(&planner->mutex);
+  if (state == ZONE_FAILED)
+    return -1;
+  if (state != ZONE_EMPTY)
+    return 0;
+
+  /* only this thread moves a zone out of ZONE_EMPTY */
+  map = planner->load(planner->hmap->zone_names[zone_index],
+		      planner->load_data);
+
+  pthread_mutex_lock(&planner->mutex);
+  if (map == NULL)
+    zone->state = ZONE_FAILED;
+  else {
+    zone->map = map;
+    zone->state = ZONE_QUEUED;
+    planner->queue[planner->queue_length++] = zone_index;
+    pthread_cond_signal(&planner->queued);
+  }
+  pthread_mutex_unlock(&planner->mutex);
+
+  return map == NULL ? -1 : 0;
+}
+
+int
+carmen_hmap_planner_zone_ready(carmen_hmap_planner_p planner, int zone)
+{
+  int state;
+
+  if (zone < 0 || zone >= planner->hmap->num_zones)
+    return 0;
+
+  pthread_mutex_lock(&planner->mutex);
+  state = planner->zones[zone].state;
+  pthread_mutex_unlock(&planner->mutex);
+
+  return state == ZONE_READY;
+}
+
+int
+carmen_hmap_planner_wait_zone(carmen_hmap_planner_p planner, int zone)
+{
+  int state;
+
+  if (zone < 0 || zone >= planner->hmap->num_zones)
+    return -1;
+
+  pthread_mutex_lock(&planner->mutex);
+  while (planner->zones[zone].state == ZONE_QUEUED)
+    pthread_cond_wait(&planner->ready, &planner->mutex);
+  state = planner->zones[zone].state;
+  pthread_mutex_unlock(&planner->mutex);
+
+  return state == ZONE_READY ? 0 : -1;
+}
+
+double *
+carmen_hmap_planner_zone_costs(carmen_hmap_planner_p planner, int zone,
+			       carmen_map_config_p config)
+{
+  if (!carmen_hmap_planner_zone_ready(planner, zone))
+    return NULL;
+
+  if (config)
+    *config = planner->zones[zone].map->config;
+  return planner->zones[zone].costs;
+}
+
+/* Route search. Nodes are the portals, followed by the start and the
+   goal. */
+
+typedef struct {
+  carmen_hmap_planner_p planner;
+  int num_nodes, start, goal;
+  int start_zone, goal_zone;
+  carmen_point_t start_point, goal_point;
+  double *start_costs, *goal_costs;
+  int estimated;
+} route_search_t;
+
+static int
+node_zone(route_search_t *search, int node)
+{
+  if (node == search->start)
+    return search->start_zone;
+  if (node == search->goal)
+    return search->goal_zone;
+  return search->planner->portals[node].zone;
+}
+
+static carmen_point_p
+node_point(route_search_t *search, int node)
+{
+  if (node == search->start)
+    return &search->start_point;
+  if (node == search->goal)
+    return &search->goal_point;
+  return &search->planner->portals[node].point;
+}
+
+static int
+zone_portal_index(zone_t *zone, int portal)
+{
+  int i;
+
+  for (i = 0; i < zone->num_portals; i++)
+    if (zone->portals[i] == portal)
+      return i;
+  return -1;
+}
+
+/* Costs from an end point of the route to every portal of its zone, and
+   to the other end point (last entry) if it is in the same zone. */
+static double *
+end_point_costs(route_search_t *search, int zone_index,
+		carmen_point_p point, carmen_point_p other_point,
+		int other_zone)
+{
+  carmen_hmap_planner_p planner = search->planner;
+  zone_t *zone = &planner->zones[zone_index];
+  double *costs, *field;
+  int *targets, start, i, n = zone->num_portals;
+
+  costs = (double *)calloc(n+1, sizeof(double));
+  carmen_test_alloc(costs);
+
+  if (!carmen_hmap_planner_zone_ready(planner, zone_index)) {
+    search->estimated = 1;
+    for (i = 0; i < n; i++)
+      costs[i] = carmen_distance(point, &planner->portals[zone->portals[i]].
+				 point);
+    costs[n] = other_zone == zone_index ?
+      carmen_distance(point, other_point) : DBL_MAX;
+    return costs;
+  }
+
+  for (i = 0; i <= n; i++)
+    costs[i] = DBL_MAX;
+  start = point_to_cell(zone->map, point);
+  if (start < 0)
+    return costs;
+
+  targets = (int *)calloc(n+1, sizeof(int));
+  carmen_test_alloc(targets);
+  for (i = 0; i < n; i++)
+    targets[i] = point_to_cell(zone->map,
+			       &planner->portals[zone->portals[i]].point);
+  targets[n] = other_zone == zone_index ?
+    point_to_cell(zone->map, other_point) : -1;
+
+  field = (double *)calloc(zone->map->config.x_size*zone->map->config.y_size,
+			   sizeof(double));
+  carmen_test_alloc(field);
+  grid_search(zone, start, targets, n+1, field);
+  for (i = 0; i <= n; i++)
+    if (targets[i] >= 0)
+      costs[i] = field[targets[i]];
+
+  free(field);
+  free(targets);
+  return costs;
+}
+
+/* Cost of going from node u to node v within their common zone */
+static double
+zone_edge_cost(route_search_t *search, int u, int v)
+{
+  carmen_hmap_planner_p planner = search->planner;
+  zone_t *zone;
+  int zone_index, i, j;
+
+  if (u == search->goal || v == search->start)
+    return DBL_MAX;
+  if (u == search->start && v == search->goal)
+    return search->start_costs[planner->zones[search->start_zone].
+			       num_portals];
+
+  zone_index = node_zone(search, u);
+  zone = &planner->zones[zone_index];
+  if (u == search->start)
+    return search->start_costs[zone_portal_index(zone, v)];
+  if (v == search->goal)
+    return search->goal_costs[zone_portal_index(zone, u)];
+
+  if (!carmen_hmap_planner_zone_ready(planner, zone_index)) {
+    search->estimated = 1;
+    return carmen_distance(node_point(search, u), node_point(search, v));
+  }
+  i = zone_portal_index(zone, u);
+  j = zone_portal_index(zone, v);
+  return zone->portal_costs[i*zone->num_portals+j];
+}
+
+/* Cost of taking a link from portal u to portal v, or DBL_MAX */
+static double
+link_edge_cost(route_search_t *search, int u, int v)
+{
+  portal_t *a, *b;
+
+  if (u >= search->planner->num_portals || v >= search->planner->num_portals)
+    return DBL_MAX;
+  a = &search->planner->portals[u];
+  b = &search->planner->portals[v];
+  if (a->link != b->link || a->side == b->side)
+    return DBL_MAX;
+  if (search->planner->hmap->links[a->link].type == CARMEN_HMAP_LINK_ELEVATOR)
+    return CARMEN_HMAP_PLANNER_ELEVATOR_COST;
+  return 0;
+}
+
+static void
+door_overshoot(portal_t *portal, carmen_point_p from, carmen_point_p goal)
+{
+  double nx, ny, length;
+
+  *goal = portal->point;
+  if (portal->num_posts < 2)
+    return;
+
+  nx = -(portal->post[1].y - portal->post[0].y);
+  ny = portal->post[1].x - portal->post[0].x;
+  length = hypot(nx, ny);
+  if (length == 0)
+    return;
+  if (nx*(from->x - portal->point.x) + ny*(from->y - portal->point.y) > 0)
+    length = -length;
+  goal->x += nx/length*CARMEN_HMAP_PLANNER_DOOR_OVERSHOOT;
+  goal->y += ny/length*CARMEN_HMAP_PLANNER_DOOR_OVERSHOOT;
+}
+
+static void
+build_route(route_search_t *search, int *previous, int *via_link,
+	    double *cost, carmen_hmap_route_p route)
+{
+  carmen_hmap_planner_p planner = search->planner;
+  carmen_hmap_leg_p leg;
+  int *path, length = 0, node, i;
+  double leg_start_cost = 0;
+
+  path = (int *)calloc(search->num_nodes, sizeof(int));
+  carmen_test_alloc(path);
+  for (node = search->goal; node >= 0; node = previous[node])
+    path[length++] = node;
+
+  route->legs = (carmen_hmap_leg_p)calloc(length, sizeof(carmen_hmap_leg_t));
+  carmen_test_alloc(route->legs);
+  route->num_legs = 0;
+  route->cost = cost[search->goal];
+
+  /* path runs backwards from the goal; consecutive zone edges in the
+     same zone are merged into one leg */
+  leg = NULL;
+  for (i = length-1; i > 0; i--) {
+    if (via_link[path[i-1]]) {
+      if (leg == NULL)
+	continue;
+      leg->link = planner->portals[path[i]].link;
+      door_overshoot(&planner->portals[path[i]], &leg->start, &leg->goal);
+      leg->cost = cost[path[i]] - leg_start_cost;
+      leg = NULL;
+      leg_start_cost = cost[path[i-1]];
+      continue;
+    }
+    if (leg == NULL) {
+      leg = &route->legs[route->num_legs++];
+      leg->zone = node_zone(search, path[i]);
+      leg->start = *node_point(search, path[i]);
+    }
+    leg->goal = *node_point(search, path[i-1]);
+    leg->link = -1;
+    leg->cost = cost[path[i-1]] - leg_start_cost;
+  }
+
+  free(path);
+}
+
+int
+carmen_hmap_planner_plan(carmen_hmap_planner_p planner,
+			 int start_zone, carmen_point_p start,
+			 int goal_zone, carmen_point_p goal,
+			 carmen_hmap_route_p route)
+{
+  route_search_t search;
+  double *cost, edge;
+  int *previous, *via_link, *done;
+  int i, u, v, zone;
+
+  memset(route, 0, sizeof(carmen_hmap_route_t));
+  if (start_zone < 0 || start_zone >= planner->hmap->num_zones ||
+      goal_zone < 0 || goal_zone >= planner->hmap->num_zones)
+    return -1;
+
+  carmen_hmap_planner_prefetch(planner, start_zone);
+  carmen_hmap_planner_prefetch(planner, goal_zone);
+
+  search.planner = planner;
+  search.num_nodes = planner->num_portals+2;
+  search.start = planner->num_portals;
+  search.goal = planner->num_portals+1;
+  search.start_zone = start_zone;
+  search.goal_zone = goal_zone;
+  search.start_point = *start;
+  search.goal_point = *goal;
+  search.estimated = 0;
+  search.start_costs = end_point_costs(&search, start_zone, start, goal,
+				       goal_zone);
+  search.goal_costs = end_point_costs(&search, goal_zone, goal, start,
+				      start_zone);
+
+  cost = (double *)calloc(search.num_nodes, sizeof(double));
+  carmen_test_alloc(cost);
+  previous = (int *)calloc(search.num_nodes, sizeof(int));
+  carmen_test_alloc(previous);
+  via_link = (int *)calloc(search.num_nodes, sizeof(int));
+  carmen_test_alloc(via_link);
+  done = (int *)calloc(search.num_nodes, sizeof(int));
+  carmen_test_alloc(done);
+
+  /* The graph has a handful of nodes per zone, so a plain O(n^2)
+     Dijkstra is all it takes. */
+  for (i = 0; i < search.num_nodes; i++) {
+    cost[i] = DBL_MAX;
+    previous[i] = -1;
+  }
+  cost[search.start] = 0;
+
+  for (;;) {
+    u = -1;
+    for (i = 0; i < search.num_nodes; i++)
+      if (!done[i] && cost[i] < DBL_MAX && (u < 0 || cost[i] < cost[u]))
+	u = i;
+    if (u < 0 || u == search.goal)
+      break;
+    done[u] = 1;
+
+    zone = node_zone(&search, u);
+    for (v = 0; v < search.num_nodes; v++) {
+      if (done[v] || v == u)
+	continue;
+      edge = DBL_MAX;
+      if (node_zone(&search, v) == zone)
+	edge = zone_edge_cost(&search, u, v);
+      if (edge < DBL_MAX && cost[u]+edge < cost[v]) {
+	cost[v] = cost[u]+edge;
+	previous[v] = u;
+	via_link[v] = 0;
+      }
+      edge = link_edge_cost(&search, u, v);
+      if (edge < DBL_MAX && cost[u]+edge < cost[v]) {
+	cost[v] = cost[u]+edge;
+	previous[v] = u;
+	via_link[v] = 1;
+      }
+    }
+  }
+
+  if (cost[search.goal] < DBL_MAX) {
+    build_route(&search, previous, via_link, cost, route);
+    route->estimated = search.estimated;
+    for (i = 0; i < route->num_legs; i++)
+      carmen_hmap_planner_prefetch(planner, route->legs[i].zone);
+  }
+
+  free(search.start_costs);
+  free(search.goal_costs);
+  free(cost);
+  free(previous);
+  free(via_link);
+  free(done);
+
+  return route->num_legs > 0 ? 0 : -1;
+}
+
+carmen_hmap_p
+carmen_hmap_planner_get_hmap(carmen_hmap_planner_p planner)
+{
+  return planner->hmap;
+}
+
+void
+carmen_hmap_planner_free_route(carmen_hmap_route_p route)
+{
+  free(route->legs);
+  memset(route, 0, sizeof(carmen_hmap_route_t));
+}
@@ -0,0 +1,152 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/** @addtogroup navigator **/
+// @{
+
+/** \file hmap_planner.h
+ * \brief Route planning across the zones of a hierarchical map.
+ *
+ * The zones of a carmen_hmap_t are connected by doors and elevators
+ * (carmen_hmap_link_t). A route is found by a graph search over the
+ * places where links are entered (portals). Edges within a zone cost
+ * the shortest grid path between two portals on the cost map of the
+ * conventional planner. These costs are computed once per zone, in a
+ * background thread, and cached together with the cost map itself.
+ * The route is then followed leg by leg with the grid planner of the
+ * active zone.
+ *
+ * Costs are in metres of free space: a step through a cell costs its
+ * length times the cell cost over CARMEN_CONVENTIONAL_MIN_COST.
+ **/
+
+#ifndef HMAP_PLANNER_H
+#define HMAP_PLANNER_H
+
+#include "global.h"
+#include "map.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /** Cost of riding an elevator, whatever the floors. The keys of an
+      elevator link name its zones, not how far apart they are. **/
+#define CARMEN_HMAP_PLANNER_ELEVATOR_COST   20.0
+
+  /** How far past the door line a leg that ends at a door aims, so
+      that the robot crosses the door before the leg is complete. **/
+#define CARMEN_HMAP_PLANNER_DOOR_OVERSHOOT  1.0
+
+  /** Loads the gridmap of a zone. Called from the thread that asks for
+      the zone (never from the background thread), so it may use IPC.
+      The planner takes over the returned map. **/
+
+  typedef carmen_map_p (*carmen_hmap_planner_load_t)(char *zone_name,
+						     void *data);
+
+  /** One leg of a route: a path within a single zone. **/
+
+  typedef struct {
+    int zone;               /**< index into hmap.zone_names */
+    carmen_point_t start;   /**< in the coordinates of the zone */
+    carmen_point_t goal;    /**< in the coordinates of the zone */
+    int link;               /**< link taken at the end of the leg, or -1
+			       for the last leg */
+    double cost;
+  } carmen_hmap_leg_t, *carmen_hmap_leg_p;
+
+  typedef struct {
+    int num_legs;
+    carmen_hmap_leg_p legs;
+    double cost;
+    int estimated;          /**< some zones were not ready yet, and
+			       straight-line distances were used */
+  } carmen_hmap_route_t, *carmen_hmap_route_p;
+
+  typedef struct carmen_hmap_planner_t *carmen_hmap_planner_p;
+
+  /** Returns the index of the zone with the given name, or -1. **/
+
+  int carmen_hmap_find_zone(carmen_hmap_p hmap, char *zone_name);
+
+  /** Creates a planner for hmap, which must outlive it. Starts the
+      background thread. **/
+
+  carmen_hmap_planner_p
+  carmen_hmap_planner_new(carmen_hmap_p hmap,
+			  carmen_robot_config_t *robot_conf,
+			  carmen_hmap_planner_load_t load, void *load_data);
+
+  void carmen_hmap_planner_free(carmen_hmap_planner_p planner);
+
+  carmen_hmap_p carmen_hmap_planner_get_hmap(carmen_hmap_planner_p planner);
+
+  /** Loads the map of zone (in the calling thread) unless it is
+      already loaded, and queues the zone for the background thread,
+      which builds its cost map and portal costs. Returns -1 if the map
+      could not be loaded. **/
+
+  int carmen_hmap_planner_prefetch(carmen_hmap_planner_p planner, int zone);
+
+  /** Returns 1 once the cost map and portal costs of zone are built. **/
+
+  int carmen_hmap_planner_zone_ready(carmen_hmap_planner_p planner, int zone);
+
+  /** Blocks until zone is ready. Returns -1 if it was never prefetched
+      or could not be loaded. **/
+
+  int carmen_hmap_planner_wait_zone(carmen_hmap_planner_p planner, int zone);
+
+  /** Returns the cost map of a ready zone (in the layout of
+      carmen_conventional_get_costs_ptr) and the configuration of its map,
+      or NULL if the zone is not ready. **/
+
+  double *carmen_hmap_planner_zone_costs(carmen_hmap_planner_p planner,
+					 int zone,
+					 carmen_map_config_p config);
+
+  /** Plans a route from start in start_zone to goal in goal_zone and
+      prefetches every zone the route passes. Never blocks on a zone:
+      zones that are not ready are crossed at straight-line cost, and
+      route->estimated is set. Planning again once they are ready gives
+      the exact route. Returns -1 if no route exists. **/
+
+  int carmen_hmap_planner_plan(carmen_hmap_planner_p planner,
+			       int start_zone, carmen_point_p start,
+			       int goal_zone, carmen_point_p goal,
+			       carmen_hmap_route_p route);
+
+  void carmen_hmap_planner_free_route(carmen_hmap_route_p route);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+// @}
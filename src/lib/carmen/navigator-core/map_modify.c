@@ -32,21 +32,55 @@
 
 #include "map_interface.h"
 
+/* The scans of the window. Each scan keeps the cells it marked, and
+   every cell counts the scans of the window that marked it filled or
+   cleared. A cell is filled if a scan filled it and no newer scan
+   cleared it, otherwise it has its value in the true map. A new scan
+   and the scan it pushes out of the window therefore only touch their
+   own cells, and modify_map is written where a value changes. */
+
 #define LASER_HISTORY_LENGTH 5
 
 #define EMPTY 0.01
 #define FILLED .9
 #define UNKNOWN -1
 
+/* changed cells are collected in tiles of 16 x 16 cells */
+#define TILE_BITS 4
+#define TILE_SIZE (1 << TILE_BITS)
+
 typedef struct {
   int x, y;
-  double value;
+  int filled;
 } grid_cell_t, *grid_cell_p;
 
-static grid_cell_p *laser_scan;
-static int *scan_size;
-static int *max_scan_size;
+typedef struct {
+  grid_cell_p cells;
+  int num_cells, max_cells;
+} scan_t;
+
+/* Scans are numbered modulo 2^16, which is plenty to tell the newest
+   of the scans in the window. */
+typedef struct {
+  unsigned char filled, cleared;
+  unsigned short filled_scan, cleared_scan;
+} cell_count_t;
+
+static scan_t laser_scan[LASER_HISTORY_LENGTH];
 static int current_data_set = 0;
+static unsigned short current_scan = 0;
+
+static cell_count_t *cell_count = NULL;
+static float *counted_map = NULL;
+static int x_size, y_size;
+
+static unsigned char *dirty_tile = NULL;
+static int *dirty_tiles = NULL;
+static int num_dirty_tiles = 0;
+static int tiles_x, tiles_y;
+
+static int *dirty_rects = NULL;
+static int num_dirty_rects = 0, max_dirty_rects = 0;
 
 carmen_inline static int
 is_empty(double value)
@@ -70,152 +104,153 @@ is_in_map(int x, int y, carmen_map_p map)
   return 1;
 }
 
-static int
-point_exists(int x, int y, double value)
+carmen_inline static int
+is_newer(unsigned short scan, unsigned short other)
 {
-  int num_points = scan_size[current_data_set];
-  grid_cell_p cell = laser_scan[current_data_set];
-  int index;
-
-  if (num_points == 0)
-    return 0;
+  return (short)(scan-other) > 0;
+}
 
-  for (index = num_points-1; index >= 0; index--) {
-    if (x == cell[index].x && y == cell[index].y &&
-	fabs(value - cell[index].value) < .01)
-      return 1;
-  }
+static void
+reset_window(carmen_map_p modify_map)
+{
+  int index;
 
-  return 0;
+  for (index = 0; index < LASER_HISTORY_LENGTH; index++)
+    laser_scan[index].num_cells = 0;
+  current_data_set = 0;
+  num_dirty_tiles = 0;
+  num_dirty_rects = 0;
+
+  if (cell_count == NULL || x_size != modify_map->config.x_size ||
+      y_size != modify_map->config.y_size) {
+    free(cell_count);
+    free(dirty_tile);
+    free(dirty_tiles);
+
+    x_size = modify_map->config.x_size;
+    y_size = modify_map->config.y_size;
+    cell_count = (cell_count_t *)calloc((long)x_size*y_size,
+					sizeof(cell_count_t));
+    carmen_test_alloc(cell_count);
+
+    tiles_x = (x_size+TILE_SIZE-1) >> TILE_BITS;
+    tiles_y = (y_size+TILE_SIZE-1) >> TILE_BITS;
+    dirty_tile = (unsigned char *)calloc(tiles_x*tiles_y, 1);
+    carmen_test_alloc(dirty_tile);
+    dirty_tiles = (int *)calloc(tiles_x*tiles_y, sizeof(int));
+    carmen_test_alloc(dirty_tiles);
+  } else
+    memset(cell_count, 0, (long)x_size*y_size*sizeof(cell_count_t));
+
+  counted_map = modify_map->complete_map;
 }
 
 static void
-add_filled_point(int x, int y, carmen_map_p true_map, carmen_map_p modify_map)
+update_cell(int x, int y, cell_count_t *count, carmen_map_p true_map,
+	    carmen_map_p modify_map)
 {
-  int num_points;
-  grid_cell_p cell_list;
-  double value;
+  float value;
+  int tile;
 
-  if (!is_in_map(x, y, modify_map))
-    return;
+  if (count->filled && (!count->cleared ||
+			!is_newer(count->cleared_scan, count->filled_scan)))
+    value = FILLED;
+  else
+    value = true_map->map[x][y];
 
-  value = true_map->map[x][y];
-  if (is_filled(value))
+  if (modify_map->map[x][y] == value)
     return;
+  modify_map->map[x][y] = value;
 
-  /*   if (point_exists(x, y, FILLED)) */
-  /*     return; */
-
-  num_points = scan_size[current_data_set];
-  if (num_points == max_scan_size[current_data_set]) {
-    max_scan_size[current_data_set] *= 2;
-    laser_scan[current_data_set] =
-      realloc(laser_scan[current_data_set],
-	      max_scan_size[current_data_set]*sizeof(grid_cell_t));
-    carmen_test_alloc(laser_scan[current_data_set]);
+  tile = (x >> TILE_BITS)*tiles_y+(y >> TILE_BITS);
+  if (!dirty_tile[tile]) {
+    dirty_tile[tile] = 1;
+    dirty_tiles[num_dirty_tiles++] = tile;
   }
-
-  cell_list = laser_scan[current_data_set];
-  value = FILLED;
-  /*      carmen_warn("Filling point %d (%d) %d %d\n", num_points, */
-  /*  	 current_data_set, x, y); */
-  cell_list[num_points].x = x;
-  cell_list[num_points].y = y;
-  cell_list[num_points].value = value;
-  scan_size[current_data_set]++;
-  modify_map->map[x][y] = 2.0;
 }
 
 static void
-add_clear_point(int x, int y, carmen_map_p true_map, carmen_map_p modify_map)
+add_point(int x, int y, int filled, carmen_map_p true_map,
+	  carmen_map_p modify_map)
 {
-  int num_points = scan_size[current_data_set];
-  grid_cell_p cell_list;
-  double value;
+  cell_count_t *count = cell_count+(long)x*y_size+y;
+  scan_t *scan = laser_scan+current_data_set;
 
-  if (!is_in_map(x, y, modify_map))
-    return;
+  if (filled) {
+    if (count->filled && count->filled_scan == current_scan)
+      return;
+    count->filled++;
+    count->filled_scan = current_scan;
+  } else {
+    if (count->cleared && count->cleared_scan == current_scan)
+      return;
+    count->cleared++;
+    count->cleared_scan = current_scan;
+  }
 
-  value = true_map->map[x][y];
+  if (scan->num_cells == scan->max_cells) {
+    scan->max_cells = scan->max_cells ? 2*scan->max_cells : 200;
+    scan->cells = (grid_cell_p)realloc(scan->cells, scan->max_cells*
+				       sizeof(grid_cell_t));
+    carmen_test_alloc(scan->cells);
+  }
+  scan->cells[scan->num_cells].x = x;
+  scan->cells[scan->num_cells].y = y;
+  scan->cells[scan->num_cells].filled = filled;
+  scan->num_cells++;
 
-  /*   if (is_empty(value))  */
-  /* 		return; */
+  update_cell(x, y, count, true_map, modify_map);
+}
 
-  if (point_exists(x, y, EMPTY))
+static void
+add_filled_point(int x, int y, carmen_map_p true_map, carmen_map_p modify_map)
+{
+  if (!is_in_map(x, y, modify_map))
     return;
 
-  if (num_points == max_scan_size[current_data_set]) {
-    max_scan_size[current_data_set] *= 2;
-    laser_scan[current_data_set] =
-      realloc(laser_scan[current_data_set],
-	      max_scan_size[current_data_set]*sizeof(grid_cell_t));
-    carmen_test_alloc(laser_scan[current_data_set]);
-  }
+  if (is_filled(true_map->map[x][y]))
+    return;
 
-  cell_list = laser_scan[current_data_set];
-  value = EMPTY;
-  cell_list[num_points].x = x;
-  cell_list[num_points].y = y;
-  cell_list[num_points].value = value;
-  scan_size[current_data_set]++;
-  modify_map->map[x][y] = value;
+  add_point(x, y, 1, true_map, modify_map);
 }
 
+/* Pushes the oldest scan out of the window. Its cells are the only ones
+   whose value can change. If it was the newest scan to mark a cell, it
+   was the only one, so the newest scan of a count that stays above zero
+   remains in the window. */
 static void
 update_existing_data(carmen_map_p true_map, carmen_map_p modify_map)
 {
+  scan_t *scan;
   grid_cell_p cell;
-  int num_changed_points;
+  cell_count_t *count;
   int index;
-  double value;
-  int list_index;
 
   current_data_set = (current_data_set+1) % LASER_HISTORY_LENGTH;
-
-  if (laser_scan[current_data_set] == NULL) {
-    laser_scan[current_data_set] =
-      (grid_cell_p)calloc(200, sizeof(grid_cell_t));
-    carmen_test_alloc(laser_scan[current_data_set]);
-    max_scan_size[current_data_set] = 200;
-    scan_size[current_data_set] = 0;
-  }
-
-  /* The oldest scan is erased here */
-  cell = laser_scan[current_data_set];
-
-  num_changed_points = scan_size[current_data_set];
-  cell = laser_scan[current_data_set];
-  for (index = 0; index < num_changed_points; index++) {
-    value = true_map->map[cell->x][cell->y];
-    modify_map->map[cell->x][cell->y] = value;
+  current_scan++;
+
+  scan = laser_scan+current_data_set;
+  cell = scan->cells;
+  for (index = 0; index < scan->num_cells; index++) {
+    count = cell_count+(long)cell->x*y_size+cell->y;
+    if (cell->filled)
+      count->filled--;
+    else
+      count->cleared--;
+    update_cell(cell->x, cell->y, count, true_map, modify_map);
     cell++;
   }
-  scan_size[current_data_set] = 0;
-
-  /* The other scans are recopied in here */
-
-  for (list_index = 0; list_index < LASER_HISTORY_LENGTH; list_index++) {
-    cell = laser_scan[list_index];
-    if (cell == NULL)
-      continue;
-    num_changed_points = scan_size[list_index];
-    for (index = 0; index < num_changed_points; index++) {
-      modify_map->map[cell->x][cell->y] = cell->value;
-      /*        carmen_warn("Filling point %d of %d in list %d: %d %d\n", index, */
-      /*  	   num_changed_points, list_index, cell->x, cell->y); */
-      cell++;
-    }
-  }
+  scan->num_cells = 0;
 }
 
+/* Free space only matters where the true map is empty and a scan of
+   the window filled the cell. */
 void
 trace_laser(int x_1, int y_1, int x_2, int y_2, carmen_map_p true_map,
 	    carmen_map_p modify_map)
 {
   carmen_bresenham_param_t params;
   int X, Y;
-  double true_map_value;
-  double modified_map_value;
 
   carmen_get_bresenham_parameters(x_1, y_1, x_2, y_2, &params);
 
@@ -223,14 +258,74 @@ trace_laser(int x_1, int y_1, int x_2, int y_2, carmen_map_p true_map,
     carmen_get_current_point(&params, &X, &Y);
     if (!is_in_map(X, Y, modify_map))
       break;
-    true_map_value = true_map->map[X][Y];
-    modified_map_value = modify_map->map[X][Y];
 
-    if (!is_empty(modified_map_value)  &&   is_empty(true_map_value))
-      add_clear_point(X, Y, true_map, modify_map);
+    if (cell_count[(long)X*y_size+Y].filled && 
+	is_empty(true_map->map[X][Y]))
+      add_point(X, Y, 0, true_map, modify_map);
   } while (carmen_get_next_point(&params));
 }
 
+static void
+add_dirty_rect(int x_start, int y_start, int x_end, int y_end)
+{
+  int *rect;
+
+  if (num_dirty_rects == max_dirty_rects) {
+    max_dirty_rects = max_dirty_rects ? 2*max_dirty_rects : 16;
+    dirty_rects = (int *)realloc(dirty_rects, 4*max_dirty_rects*sizeof(int));
+    carmen_test_alloc(dirty_rects);
+  }
+  rect = dirty_rects+4*num_dirty_rects++;
+  rect[0] = x_start;
+  rect[1] = y_start;
+  rect[2] = x_end;
+  rect[3] = y_end;
+}
+
+static int
+compare_tiles(const void *a, const void *b)
+{
+  return *(const int *)a - *(const int *)b;
+}
+
+/* Runs of dirty tiles along y become rectangles, which grow along x
+   while the next column of tiles has the same run. */
+static void
+build_dirty_rects(void)
+{
+  int index, next, rect;
+  int x_start, y_start, x_end, y_end;
+
+  num_dirty_rects = 0;
+  qsort(dirty_tiles, num_dirty_tiles, sizeof(int), compare_tiles);
+
+  for (index = 0; index < num_dirty_tiles; index = next) {
+    for (next = index+1; next < num_dirty_tiles &&
+	   dirty_tiles[next] == dirty_tiles[next-1]+1 &&
+	   dirty_tiles[next] % tiles_y != 0; next++);
+
+    x_start = (dirty_tiles[index]/tiles_y) << TILE_BITS;
+    y_start = (dirty_tiles[index] % tiles_y) << TILE_BITS;
+    x_end = carmen_imin(x_start+TILE_SIZE, x_size);
+    y_end = carmen_imin(((dirty_tiles[next-1] % tiles_y)+1) << TILE_BITS,
+			y_size);
+
+    for (rect = num_dirty_rects-1; rect >= 0; rect--)
+      if (dirty_rects[4*rect+2] == x_start &&
+	  dirty_rects[4*rect+1] == y_start &&
+	  dirty_rects[4*rect+3] == y_end)
+	break;
+    if (rect >= 0)
+      dirty_rects[4*rect+2] = x_end;
+    else
+      add_dirty_rect(x_start, y_start, x_end, y_end);
+  }
+
+  for (index = 0; index < num_dirty_tiles; index++)
+    dirty_tile[dirty_tiles[index]] = 0;
+  num_dirty_tiles = 0;
+}
+
 void
 map_modify_update(carmen_robot_laser_message *laser_msg,
 		  carmen_navigator_config_t *config,
@@ -248,6 +343,8 @@ map_modify_update(carmen_robot_laser_message *laser_msg,
 
   int maxrange_beam;
 
+  num_dirty_rects = 0;
+
   if (!config->map_update_freespace &&  !config->map_update_obstacles)
     return;
 
@@ -257,16 +354,11 @@ map_modify_update(carmen_robot_laser_message *laser_msg,
       return;
     }
 
-  if (laser_scan == NULL) {
-    laser_scan = (grid_cell_p *)calloc(LASER_HISTORY_LENGTH, sizeof(grid_cell_p));
-    carmen_test_alloc(laser_scan);
-
-    scan_size = (int *)calloc(LASER_HISTORY_LENGTH, sizeof(int));
-    carmen_test_alloc(scan_size);
-
-    max_scan_size = (int *)calloc(LASER_HISTORY_LENGTH, sizeof(int));
-    carmen_test_alloc(max_scan_size);
-  }
+  /* scans of another map do not belong to this one */
+  if (cell_count == NULL || counted_map != modify_map->complete_map ||
+      x_size != modify_map->config.x_size ||
+      y_size != modify_map->config.y_size)
+    reset_window(modify_map);
 
   update_existing_data(true_map, modify_map);
 
@@ -333,21 +425,25 @@ map_modify_update(carmen_robot_laser_message *laser_msg,
     }
     angle += separation;
   }
+
+  build_dirty_rects();
+}
+
+int *
+map_modify_get_dirty(int *num_rects)
+{
+  *num_rects = num_dirty_rects;
+  return dirty_rects;
 }
 
 void
 map_modify_clear(carmen_map_p true_map, carmen_map_p modify_map)
 {
-  int index;
-
-  if (scan_size == NULL)
+  if (cell_count == NULL)
     return;
 
-  for (index = 0; index < LASER_HISTORY_LENGTH; index++)
-    scan_size[index] = 0;
-
   memcpy(modify_map->complete_map, true_map->complete_map,
 	 true_map->config.x_size*true_map->config.y_size*sizeof(float));
 
-  current_data_set = 0;
+  reset_window(modify_map);
 }
@@ -42,6 +42,11 @@ extern "C" {
 			 carmen_map_p true_map, carmen_map_p modify_map);
   void map_modify_clear(carmen_map_p true_map, carmen_map_p modify_map);
 
+  /* The cells of modify_map the last map_modify_update changed, as
+     num_rects rectangles x_start, y_start, x_end, y_end (end excluded)
+     that do not overlap. Valid until the next update or clear. */
+  int *map_modify_get_dirty(int *num_rects);
+
 #ifdef __cplusplus
 }
 #endif
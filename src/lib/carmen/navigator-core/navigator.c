@@ -42,6 +42,45 @@ int autonomous_status = 0;
 
 carmen_traj_point_t robot_position;
 
+static carmen_hmap_planner_p hmap_planner = NULL;
+static int current_zone = -1;
+static carmen_hmap_route_t route = {0, NULL, 0, 0};
+static int route_leg = 0;
+
+static void
+clear_route(void)
+{
+  carmen_hmap_planner_free_route(&route);
+  route_leg = 0;
+}
+
+/* Legs that end at a link only need to get there; the last leg ends at
+   the goal pose. */
+static void
+set_leg_goal(void)
+{
+  carmen_hmap_leg_p leg = route.legs+route_leg;
+
+  carmen_planner_update_goal(&leg->goal, leg->link >= 0, &nav_config);
+}
+
+static int
+plan_route(int start_zone, carmen_point_p start, int goal_zone,
+	   carmen_point_p goal)
+{
+  carmen_hmap_route_t new_route;
+
+  if (carmen_hmap_planner_plan(hmap_planner, start_zone, start, goal_zone,
+			       goal, &new_route) < 0)
+    return -1;
+
+  clear_route();
+  route = new_route;
+  set_leg_goal();
+
+  return 0;
+}
+
 carmen_map_placelist_p
 carmen_navigator_get_places(void)
 {
@@ -62,12 +101,14 @@ carmen_navigator_goal(double x, double y)
   point.x = x;
   point.y = y;
 
+  clear_route();
   carmen_planner_update_goal(&point, 1, &nav_config);
 }
 
 void
 carmen_navigator_goal_triplet(carmen_point_p point)
 {
+  clear_route();
   carmen_planner_update_goal(point, 0, &nav_config);
 }
 
@@ -86,6 +127,7 @@ carmen_navigator_goal_place(char *name)
   if (index == placelist.num_places)
     return -1;
 
+  clear_route();
   goal.x = placelist.places[index].x;
   goal.y = placelist.places[index].y;
 
@@ -100,6 +142,73 @@ carmen_navigator_goal_place(char *name)
   return 0;
 }
 
+void
+carmen_navigator_set_hmap_planner(carmen_hmap_planner_p planner)
+{
+  clear_route();
+  hmap_planner = planner;
+}
+
+int
+carmen_navigator_goal_zone(char *zone_name, carmen_point_p goal)
+{
+  carmen_point_t start;
+  int zone;
+
+  if (hmap_planner == NULL || current_zone < 0)
+    return -1;
+
+  zone = carmen_hmap_find_zone(carmen_hmap_planner_get_hmap(hmap_planner),
+			       zone_name);
+  if (zone < 0)
+    return -1;
+
+  start.x = robot_position.x;
+  start.y = robot_position.y;
+  start.theta = robot_position.theta;
+
+  return plan_route(current_zone, &start, zone, goal);
+}
+
+/* Called when the robot has passed a link. The rest of the route is
+   planned again from where the next leg starts, now that more zones are
+   likely to be ready. */
+void
+carmen_navigator_change_zone(char *zone_name)
+{
+  carmen_hmap_leg_t *last;
+  carmen_point_t start, goal;
+  int leg, goal_zone;
+
+  if (hmap_planner == NULL)
+    return;
+
+  current_zone =
+    carmen_hmap_find_zone(carmen_hmap_planner_get_hmap(hmap_planner),
+			  zone_name);
+  if (route.num_legs == 0)
+    return;
+
+  for (leg = route_leg+1; leg < route.num_legs; leg++)
+    if (route.legs[leg].zone == current_zone)
+      break;
+
+  if (leg == route.num_legs) {
+    carmen_warn("Left the route in zone %s\n", zone_name);
+    clear_route();
+    return;
+  }
+
+  last = route.legs+route.num_legs-1;
+  goal_zone = last->zone;
+  goal = last->goal;
+  start = route.legs[leg].start;
+  if (plan_route(current_zone, &start, goal_zone, &goal) < 0) {
+    route_leg = leg;
+    set_leg_goal();
+  }
+}
+
 void
 carmen_navigator_start_autonomous(void)
 {
@@ -143,8 +252,16 @@ generate_next_motion_command(void)
 
   /* goal is reached */
 
+  if (waypoint_status > 0 && route_leg < route.num_legs-1)
+    {
+      /* end of a leg: wait at the link until the zone changes */
+      carmen_robot_velocity_command(0, 0);
+      return;
+    }
+
   if (waypoint_status > 0)
     {
+      clear_route();
       autonomous_status = 0;
       carmen_navigator_publish_autonomous_stopped
   (CARMEN_NAVIGATOR_GOAL_REACHED_v);
@@ -36,6 +36,7 @@ extern "C" {
 #include "global.h"
 
 #include "localize_messages.h"
+#include "hmap_planner.h"
 
 typedef struct {
   int num_lasers_to_use;
@@ -65,10 +66,17 @@ extern carmen_traj_point_t robot_position;
 void carmen_navigator_goal_triplet(carmen_point_p point);
 void carmen_navigator_goal(double x, double y);
 int carmen_navigator_goal_place(char *name);
+int carmen_navigator_goal_zone(char *zone_name, carmen_point_p goal);
 void carmen_navigator_set_max_velocity(double vel);
 carmen_map_placelist_p carmen_navigator_get_places(void);
 int carmen_navigator_autonomous_status(void);
 
+/* Routes across the zones of a hierarchical map. The planner is owned by
+   the caller; change_zone must be called whenever the map server changes
+   the map zone. */
+void carmen_navigator_set_hmap_planner(carmen_hmap_planner_p planner);
+void carmen_navigator_change_zone(char *zone_name);
+
 void carmen_navigator_start_autonomous(void);
 void carmen_navigator_stop_autonomous(void);
 
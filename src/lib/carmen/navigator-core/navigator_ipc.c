@@ -277,6 +277,49 @@ static void navigator_set_goal_place_handler(MSG_INSTANCE msgRef,
     free(response.error);
 }
 
+static void navigator_set_goal_zone_handler(MSG_INSTANCE msgRef,
+					    BYTE_ARRAY callData,
+					    void *clientData
+					    __attribute__ ((unused)))
+{
+  carmen_navigator_set_goal_zone_message zone_msg;
+  carmen_navigator_return_code_message response;
+  FORMATTER_PTR formatter;
+  IPC_RETURN_TYPE err = IPC_OK;
+  int return_code;
+
+  formatter = IPC_msgInstanceFormatter(msgRef);
+  err = IPC_unmarshallData(formatter, callData, &zone_msg,
+			   sizeof(carmen_navigator_set_goal_zone_message));
+  IPC_freeByteArray(callData);
+
+  carmen_test_ipc_return(err, "Could not unmarshall",
+			 IPC_msgInstanceName(msgRef));
+
+  return_code = carmen_navigator_goal_zone(zone_msg.zone_name,
+					   &zone_msg.goal);
+
+  if (return_code == 0) {
+    response.code = 0;
+    response.error = NULL;
+  } else {
+    response.code = 1;
+    response.error = carmen_new_string("No route to zone %s",
+				       zone_msg.zone_name);
+  }
+
+  response.timestamp = carmen_get_time();
+  response.host = carmen_get_host();
+
+  err = IPC_respondData(msgRef, CARMEN_NAVIGATOR_RETURN_CODE_NAME, &response);
+  carmen_test_ipc(err, "Could not respond", CARMEN_NAVIGATOR_RETURN_CODE_NAME);
+
+  if (response.error != NULL)
+    free(response.error);
+  free(zone_msg.zone_name);
+  free(zone_msg.host);
+}
+
 static void navigator_stop_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
 				   void *clientData __attribute__ ((unused)))
 {
@@ -413,6 +456,12 @@ int carmen_navigator_initialize_ipc(void)
   carmen_test_ipc_exit(err, "Could not define message",
 		       CARMEN_NAVIGATOR_SET_GOAL_PLACE_NAME);
 
+  err = IPC_defineMsg(CARMEN_NAVIGATOR_SET_GOAL_ZONE_NAME,
+		      IPC_VARIABLE_LENGTH,
+		      CARMEN_NAVIGATOR_SET_GOAL_ZONE_FMT);
+  carmen_test_ipc_exit(err, "Could not define message",
+		       CARMEN_NAVIGATOR_SET_GOAL_ZONE_NAME);
+
   err = IPC_defineMsg(CARMEN_NAVIGATOR_STOP_NAME, IPC_VARIABLE_LENGTH,
 		      CARMEN_DEFAULT_MESSAGE_FMT);
   carmen_test_ipc_exit(err, "Could not define message",
@@ -475,6 +524,12 @@ int carmen_navigator_initialize_ipc(void)
 		       CARMEN_NAVIGATOR_SET_GOAL_PLACE_NAME);
   IPC_setMsgQueueLength(CARMEN_NAVIGATOR_SET_GOAL_PLACE_NAME, 1);
 
+  err = IPC_subscribe(CARMEN_NAVIGATOR_SET_GOAL_ZONE_NAME,
+		      navigator_set_goal_zone_handler, NULL);
+  carmen_test_ipc_exit(err, "Could not subcribe message",
+		       CARMEN_NAVIGATOR_SET_GOAL_ZONE_NAME);
+  IPC_setMsgQueueLength(CARMEN_NAVIGATOR_SET_GOAL_ZONE_NAME, 1);
+
   err = IPC_subscribe(CARMEN_NAVIGATOR_GO_NAME, navigator_go_handler, NULL);
   carmen_test_ipc_exit(err, "Could not subcribe message",
 		       CARMEN_NAVIGATOR_GO_NAME);
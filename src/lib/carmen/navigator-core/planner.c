@@ -443,6 +443,20 @@ carmen_planner_set_map(carmen_map_p new_map, carmen_robot_config_t *robot_conf)
   carmen_conventional_build_costs(robot_conf, NULL, NULL);
 }
 
+void
+carmen_planner_set_map_with_costs(carmen_map_p new_map, double *costs)
+{
+  carmen_planner_map = new_map;
+
+  if (true_map != NULL)
+    carmen_map_destroy(&true_map);
+
+  true_map = carmen_map_copy(carmen_planner_map);
+
+  map_modify_clear(true_map, carmen_planner_map);
+  carmen_conventional_set_costs(costs);
+}
+
 
 void
 carmen_planner_reset_map(carmen_robot_config_t *robot_conf)
@@ -458,6 +472,7 @@ carmen_planner_update_map(carmen_robot_laser_message *laser_msg,
 {
   carmen_world_point_t world_point;
   carmen_map_point_t map_point;
+  int num_regions, *regions;
 
   if (carmen_planner_map == NULL)
     return;
@@ -470,9 +485,11 @@ carmen_planner_update_map(carmen_robot_laser_message *laser_msg,
   /// CYRILL: HIER UEBERGABE AENDERN! (laser cfg)
 
   map_modify_update(laser_msg, nav_conf, &world_point, true_map, carmen_planner_map);
+  regions = map_modify_get_dirty(&num_regions);
 
   carmen_world_to_map(&world_point, &map_point);
-  carmen_conventional_build_costs(robot_conf, &map_point, nav_conf);
+  carmen_conventional_update_costs(robot_conf, &map_point, num_regions,
+				   regions);
 
   if (!goal_set)
     return;
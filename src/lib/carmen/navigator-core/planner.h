@@ -106,6 +106,11 @@ extern "C" {
   void carmen_planner_set_map(carmen_map_p map,
 			      carmen_robot_config_t *robot_conf);
 
+  /** Same as carmen_planner_set_map, but with a cost map that was
+      built in advance for new_map (see carmen_hmap_planner_zone_costs). **/
+
+  void carmen_planner_set_map_with_costs(carmen_map_p new_map, double *costs);
+
   /** Clears any local modifications the planner may have made to
       its internal map. **/
 
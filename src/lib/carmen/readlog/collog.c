@@ -0,0 +1,1032 @@
+ /*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include <stdint.h>
+#ifndef NO_ZLIB
+#include <zlib.h>
+#endif
+
+#include "global.h"
+#include "collog.h"
+
+/* File layout:
+ *
+ *   header   magic, block size
+ *   blocks   block header followed by the timestamp, text and range
+ *            columns
+ *   footer   message type names, block table, compressed sequence of
+ *            message types in log order
+ *   trailer  offset of the footer, end magic
+ *
+ * The text column holds the lines with their range readings cut out;
+ * the range column holds the readings in millimeters, delta coded along
+ * the scan, zig-zag mapped and split into a low and a high byte plane.
+ *
+ * All integers and doubles are little-endian. Big-endian hosts swap
+ * them after building a column and after reading one.
+ */
+
+#define COLLOG_MAGIC            "CARMEN COLLOG 1\n"
+#define COLLOG_MAGIC_LENGTH     16
+#define COLLOG_END_MAGIC        "CCLFEND\n"
+#define COLLOG_END_MAGIC_LENGTH 8
+#define COLLOG_BLOCK_MAGIC      "CBLK"
+#define COLLOG_FOOTER_MAGIC     "CFTR"
+
+#define COLLOG_TIMESTAMPS       0
+#define COLLOG_TEXT             1
+#define COLLOG_RANGES           2
+#define COLLOG_NUM_COLUMNS      3
+
+#define COLLOG_STORED           0
+#define COLLOG_DEFLATED         1
+
+#define COLLOG_NO_SPLIT         0xffffffffu
+#define COLLOG_MAX_TYPE_LENGTH  64
+#define COLLOG_MAX_TYPES        65535
+#define COLLOG_MAX_RANGE        65535
+
+typedef struct {
+  unsigned int method, raw_size, stored_size;
+} collog_column_header_t;
+
+typedef struct {
+  char name[COLLOG_MAX_TYPE_LENGTH];
+  int num_records;
+  double timestamps[CARMEN_COLLOG_BLOCK_SIZE];
+  unsigned int text_offsets[CARMEN_COLLOG_BLOCK_SIZE + 1];
+  unsigned int split[CARMEN_COLLOG_BLOCK_SIZE];
+  unsigned int num_ranges[CARMEN_COLLOG_BLOCK_SIZE];
+  char *text;
+  unsigned int max_text;
+  unsigned short *ranges;
+  unsigned int total_ranges, max_ranges;
+} collog_stream_t;
+
+typedef struct {
+  int64_t offset;
+  int type, num_records;
+  double start_timestamp, end_timestamp;
+} collog_block_info_t;
+
+struct carmen_collog_writer {
+  FILE *fp;
+  int num_types;
+  collog_stream_t **types;
+  int num_blocks, max_blocks;
+  collog_block_info_t *blocks;
+  int num_messages, max_messages;
+  unsigned short *order;
+  double last_timestamp;
+  int error;
+};
+
+typedef struct {
+  collog_block_info_t info;
+  int header_read;
+  collog_column_header_t columns[COLLOG_NUM_COLUMNS];
+  int64_t column_offsets[COLLOG_NUM_COLUMNS];
+  double *timestamps;
+  unsigned char *text_column;
+  unsigned int *text_offsets, *split;
+  char *text;
+  unsigned char *range_column;
+  unsigned int *num_ranges, *range_offsets;
+  unsigned char *low, *high;
+} collog_block_t;
+
+struct carmen_collog_reader {
+  carmen_FILE *infile;
+  int block_size;
+  int num_types;
+  char **type_names;
+  int *decoded_block;
+  int num_blocks;
+  collog_block_t *blocks;
+  int num_messages;
+  int *message_block, *message_record;
+};
+
+/* messages with range readings and the position of the token that
+   holds the number of readings */
+static struct {
+  const char *name;
+  int count_token;
+} range_messages[] = {
+  {"RAWLASER1", 8}, {"RAWLASER2", 8}, {"RAWLASER3", 8}, {"RAWLASER4", 8},
+  {"ROBOTLASER1", 8}, {"ROBOTLASER2", 8},
+  {"FLASER", 1}, {"RLASER", 1}, {"LASER3", 1}, {"LASER4", 1}
+};
+
+/* formats a range in millimeters the way "%.3f" formats it in meters */
+static int
+format_range(unsigned int range, char *s)
+{
+  unsigned int meters = range / 1000, millimeters = range % 1000;
+  int n = 0;
+
+  if (meters >= 10)
+    s[n++] = '0' + meters / 10;
+  s[n++] = '0' + meters % 10;
+  s[n++] = '.';
+  s[n++] = '0' + millimeters / 100;
+  s[n++] = '0' + millimeters / 10 % 10;
+  s[n++] = '0' + millimeters % 10;
+
+  return n;
+}
+
+/* converts count values of size bytes between host byte order and the
+   little-endian order of the file, in place */
+static void
+little_endian(void *data, int size, int count)
+{
+  static const unsigned int one = 1;
+  unsigned char *value = (unsigned char *)data, swap;
+  int i, j;
+
+  if (*(const unsigned char *)&one == 1)
+    return;
+
+  for (i = 0; i < count; i++, value += size)
+    for (j = 0; j < size / 2; j++) {
+      swap = value[j];
+      value[j] = value[size - 1 - j];
+      value[size - 1 - j] = swap;
+    }
+}
+
+static unsigned short
+zigzag_encode(unsigned int range, unsigned int previous)
+{
+  short delta = (short)(unsigned short)(range - previous);
+
+  return (unsigned short)((delta << 1) ^ (delta >> 15));
+}
+
+static unsigned int
+zigzag_decode(unsigned short code, unsigned int previous)
+{
+  int delta = (code >> 1) ^ -(code & 1);
+
+  return (previous + delta) & 0xffff;
+}
+
+static int
+count_range_token(const char *type)
+{
+  int i;
+
+  for (i = 0; i < (int)(sizeof(range_messages)/sizeof(range_messages[0])); i++)
+    if (strcmp(type, range_messages[i].name) == 0)
+      return range_messages[i].count_token;
+  return -1;
+}
+
+int
+carmen_collog_is_columnar(carmen_FILE *infile)
+{
+  char magic[COLLOG_MAGIC_LENGTH];
+  int columnar;
+
+  if (infile->compressed)
+    return 0;
+
+  carmen_fseek(infile, 0L, SEEK_SET);
+  columnar = (carmen_fread(magic, 1, COLLOG_MAGIC_LENGTH, infile) == 
+	      COLLOG_MAGIC_LENGTH && 
+	      memcmp(magic, COLLOG_MAGIC, COLLOG_MAGIC_LENGTH) == 0);
+  carmen_fseek(infile, 0L, SEEK_SET);
+
+  return columnar;
+}
+
+int
+carmen_collog_file_is_columnar(const char *filename)
+{
+  char magic[COLLOG_MAGIC_LENGTH];
+  FILE *fp;
+  int columnar;
+
+  fp = fopen(filename, "r");
+  if (fp == NULL)
+    return 0;
+  columnar = (fread(magic, 1, COLLOG_MAGIC_LENGTH, fp) == 
+	      COLLOG_MAGIC_LENGTH && 
+	      memcmp(magic, COLLOG_MAGIC, COLLOG_MAGIC_LENGTH) == 0);
+  fclose(fp);
+
+  return columnar;
+}
+
+/* writer */
+
+static void
+write_data(carmen_collog_writer_p writer, const void *data, size_t size)
+{
+  if (size > 0 && fwrite(data, 1, size, writer->fp) != size)
+    writer->error = 1;
+}
+
+static void
+write_value(carmen_collog_writer_p writer, const void *value, int size)
+{
+  unsigned char buffer[sizeof(int64_t)];
+
+  memcpy(buffer, value, size);
+  little_endian(buffer, size, 1);
+  write_data(writer, buffer, size);
+}
+
+static void
+write_column(carmen_collog_writer_p writer, const void *data, 
+	     unsigned int size, collog_column_header_t *header, 
+	     unsigned char **stored)
+{
+  header->method = COLLOG_STORED;
+  header->raw_size = size;
+  header->stored_size = size;
+  *stored = (unsigned char *)data;
+
+#ifndef NO_ZLIB
+  if (size > 0) {
+    uLongf length = compressBound(size);
+    unsigned char *buffer = (unsigned char *)malloc(length);
+    carmen_test_alloc(buffer);
+
+    if (compress2(buffer, &length, (const Bytef *)data, size, 6) == Z_OK && 
+	length < size) {
+      header->method = COLLOG_DEFLATED;
+      header->stored_size = length;
+      *stored = buffer;
+    }
+    else
+      free(buffer);
+  }
+#endif
+}
+
+static void
+flush_stream(carmen_collog_writer_p writer, int type)
+{
+  collog_stream_t *stream = writer->types[type];
+  collog_column_header_t headers[COLLOG_NUM_COLUMNS];
+  collog_column_header_t file_headers[COLLOG_NUM_COLUMNS];
+  unsigned char *raw[COLLOG_NUM_COLUMNS], *stored[COLLOG_NUM_COLUMNS];
+  unsigned int raw_size[COLLOG_NUM_COLUMNS];
+  collog_block_info_t *block;
+  unsigned char *column;
+  unsigned int i, n = stream->num_records, text_size;
+
+  if (n == 0)
+    return;
+
+  if (writer->num_blocks == writer->max_blocks) {
+    writer->max_blocks += 256;
+    writer->blocks = (collog_block_info_t *)
+      realloc(writer->blocks, writer->max_blocks*sizeof(collog_block_info_t));
+    carmen_test_alloc(writer->blocks);
+  }
+  block = writer->blocks + writer->num_blocks++;
+  block->offset = ftello(writer->fp);
+  block->type = type;
+  block->num_records = n;
+  block->start_timestamp = stream->timestamps[0];
+  block->end_timestamp = stream->timestamps[n - 1];
+
+  little_endian(stream->timestamps, sizeof(double), n);
+  raw[COLLOG_TIMESTAMPS] = (unsigned char *)stream->timestamps;
+  raw_size[COLLOG_TIMESTAMPS] = n*sizeof(double);
+
+  text_size = stream->text_offsets[n];
+  raw_size[COLLOG_TEXT] = (2*n + 1)*sizeof(unsigned int) + text_size;
+  column = (unsigned char *)malloc(raw_size[COLLOG_TEXT]);
+  carmen_test_alloc(column);
+  memcpy(column, stream->text_offsets, (n + 1)*sizeof(unsigned int));
+  memcpy(column + (n + 1)*sizeof(unsigned int), stream->split, 
+	 n*sizeof(unsigned int));
+  little_endian(column, sizeof(unsigned int), 2*n + 1);
+  memcpy(column + (2*n + 1)*sizeof(unsigned int), stream->text, text_size);
+  raw[COLLOG_TEXT] = column;
+
+  raw_size[COLLOG_RANGES] = n*sizeof(unsigned int) + 2*stream->total_ranges;
+  column = (unsigned char *)malloc(raw_size[COLLOG_RANGES] + 1);
+  carmen_test_alloc(column);
+  memcpy(column, stream->num_ranges, n*sizeof(unsigned int));
+  little_endian(column, sizeof(unsigned int), n);
+  for (i = 0; i < stream->total_ranges; i++) {
+    column[n*sizeof(unsigned int) + i] = stream->ranges[i] & 0xff;
+    column[n*sizeof(unsigned int) + stream->total_ranges + i] = 
+      stream->ranges[i] >> 8;
+  }
+  raw[COLLOG_RANGES] = column;
+
+  for (i = 0; i < COLLOG_NUM_COLUMNS; i++)
+    write_column(writer, raw[i], raw_size[i], headers + i, stored + i);
+
+  write_data(writer, COLLOG_BLOCK_MAGIC, 4);
+  write_value(writer, &block->type, sizeof(int));
+  write_value(writer, &block->num_records, sizeof(int));
+  memcpy(file_headers, headers, sizeof(headers));
+  little_endian(file_headers, sizeof(unsigned int), 3*COLLOG_NUM_COLUMNS);
+  write_data(writer, file_headers, sizeof(file_headers));
+  for (i = 0; i < COLLOG_NUM_COLUMNS; i++) {
+    write_data(writer, stored[i], headers[i].stored_size);
+    if (stored[i] != raw[i])
+      free(stored[i]);
+  }
+  free(raw[COLLOG_TEXT]);
+  free(raw[COLLOG_RANGES]);
+
+  stream->num_records = 0;
+  stream->text_offsets[0] = 0;
+  stream->total_ranges = 0;
+}
+
+static int
+find_type(carmen_collog_writer_p writer, const char *name)
+{
+  collog_stream_t *stream;
+  int i;
+
+  for (i = writer->num_types - 1; i >= 0; i--)
+    if (strcmp(writer->types[i]->name, name) == 0)
+      return i;
+
+  if (writer->num_types == COLLOG_MAX_TYPES)
+    return -1;
+
+  writer->types = (collog_stream_t **)
+    realloc(writer->types, (writer->num_types + 1)*sizeof(collog_stream_t *));
+  carmen_test_alloc(writer->types);
+  stream = (collog_stream_t *)calloc(1, sizeof(collog_stream_t));
+  carmen_test_alloc(stream);
+  strcpy(stream->name, name);
+  writer->types[writer->num_types] = stream;
+
+  return writer->num_types++;
+}
+
+carmen_collog_writer_p
+carmen_collog_writer_open(const char *filename)
+{
+  carmen_collog_writer_p writer;
+  int block_size = CARMEN_COLLOG_BLOCK_SIZE;
+
+  writer = (carmen_collog_writer_p)calloc(1, sizeof(carmen_collog_writer_t));
+  carmen_test_alloc(writer);
+
+  writer->fp = fopen(filename, "w");
+  if (writer->fp == NULL) {
+    free(writer);
+    return NULL;
+  }
+  write_data(writer, COLLOG_MAGIC, COLLOG_MAGIC_LENGTH);
+  write_value(writer, &block_size, sizeof(int));
+
+  return writer;
+}
+
+/* cuts the range readings out of a line if every reading can be 
+   reproduced from its value in millimeters */
+static int
+split_ranges(collog_stream_t *stream, const char *line, int count_token, 
+	     unsigned int *split, unsigned int *end)
+{
+  const char *s = line, *token;
+  char *token_end, formatted[32];
+  unsigned int previous = 0, range;
+  int i, num_ranges, length;
+  double value;
+
+  for (i = 0; i < count_token; i++) {
+    s = strchr(s, ' ');
+    if (s == NULL)
+      return -1;
+    s++;
+  }
+  num_ranges = strtol(s, &token_end, 10);
+  if (token_end == s || *token_end != ' ' || num_ranges < 0 || 
+      num_ranges > 1000000)
+    return -1;
+  s = token_end + 1;
+  *split = s - line;
+
+  if (stream->total_ranges + num_ranges > stream->max_ranges) {
+    stream->max_ranges = 2*(stream->total_ranges + num_ranges);
+    stream->ranges = (unsigned short *)
+      realloc(stream->ranges, stream->max_ranges*sizeof(unsigned short));
+    carmen_test_alloc(stream->ranges);
+  }
+
+  for (i = 0; i < num_ranges; i++) {
+    token = s;
+    value = strtod(token, &token_end);
+    if (token_end == token || *token_end != ' ')
+      return -1;
+    length = token_end - token;
+    if (value < 0 || value*1000.0 > COLLOG_MAX_RANGE + 0.5)
+      return -1;
+    range = (unsigned int)floor(value*1000.0 + 0.5);
+    if (format_range(range, formatted) != length || 
+	memcmp(formatted, token, length) != 0)
+      return -1;
+    stream->ranges[stream->total_ranges + i] = zigzag_encode(range, previous);
+    previous = range;
+    s = token_end + 1;
+  }
+  *end = s - line;
+
+  return num_ranges;
+}
+
+static double
+line_timestamp(const char *line, double previous)
+{
+  const char *s;
+  char *end;
+  double timestamp;
+  int length = strlen(line);
+
+  if (line[0] == '#')
+    return previous;
+  while (length > 0 && isspace((unsigned char)line[length - 1]))
+    length--;
+  s = line + length;
+  while (s > line && !isspace((unsigned char)s[-1]))
+    s--;
+  if (s == line + length)
+    return previous;
+  timestamp = strtod(s, &end);
+  if (end != line + length)
+    return previous;
+  return timestamp;
+}
+
+int
+carmen_collog_write_line(carmen_collog_writer_p writer, const char *line)
+{
+  char name[COLLOG_MAX_TYPE_LENGTH];
+  collog_stream_t *stream;
+  unsigned int split = COLLOG_NO_SPLIT, end = 0, n, length, text_length;
+  int type, count_token, num_ranges = 0;
+
+  length = strcspn(line, " \r\n");
+  if (length >= COLLOG_MAX_TYPE_LENGTH)
+    length = COLLOG_MAX_TYPE_LENGTH - 1;
+  strncpy(name, line, length);
+  name[length] = '\0';
+
+  type = find_type(writer, name);
+  if (type < 0)
+    return -1;
+  stream = writer->types[type];
+  n = stream->num_records;
+
+  count_token = count_range_token(name);
+  if (count_token > 0) {
+    num_ranges = split_ranges(stream, line, count_token, &split, &end);
+    if (num_ranges < 0) {
+      num_ranges = 0;
+      split = COLLOG_NO_SPLIT;
+    }
+  }
+
+  length = strlen(line);
+  text_length = length;
+  if (split != COLLOG_NO_SPLIT)
+    text_length -= end - split;
+  if (stream->text_offsets[n] + text_length > stream->max_text) {
+    stream->max_text = 2*(stream->text_offsets[n] + text_length);
+    stream->text = (char *)realloc(stream->text, stream->max_text);
+    carmen_test_alloc(stream->text);
+  }
+  if (split == COLLOG_NO_SPLIT)
+    memcpy(stream->text + stream->text_offsets[n], line, length);
+  else {
+    memcpy(stream->text + stream->text_offsets[n], line, split);
+    memcpy(stream->text + stream->text_offsets[n] + split, line + end, 
+	   length - end);
+  }
+  stream->text_offsets[n + 1] = stream->text_offsets[n] + text_length;
+  stream->split[n] = split;
+  stream->num_ranges[n] = num_ranges;
+  stream->total_ranges += num_ranges;
+
+  writer->last_timestamp = line_timestamp(line, writer->last_timestamp);
+  stream->timestamps[n] = writer->last_timestamp;
+  stream->num_records++;
+
+  if (writer->num_messages == writer->max_messages) {
+    writer->max_messages += 65536;
+    writer->order = (unsigned short *)
+      realloc(writer->order, writer->max_messages*sizeof(unsigned short));
+    carmen_test_alloc(writer->order);
+  }
+  writer->order[writer->num_messages++] = type;
+
+  if (stream->num_records == CARMEN_COLLOG_BLOCK_SIZE)
+    flush_stream(writer, type);
+
+  return writer->error ? -1 : 0;
+}
+
+int
+carmen_collog_writer_close(carmen_collog_writer_p writer)
+{
+  collog_column_header_t header;
+  unsigned char *stored;
+  int64_t footer_offset;
+  int i, length, error;
+
+  for (i = 0; i < writer->num_types; i++)
+    flush_stream(writer, i);
+
+  footer_offset = ftello(writer->fp);
+  write_data(writer, COLLOG_FOOTER_MAGIC, 4);
+  write_value(writer, &writer->num_types, sizeof(int));
+  for (i = 0; i < writer->num_types; i++) {
+    length = strlen(writer->types[i]->name);
+    write_value(writer, &length, sizeof(int));
+    write_data(writer, writer->types[i]->name, length);
+  }
+  write_value(writer, &writer->num_blocks, sizeof(int));
+  for (i = 0; i < writer->num_blocks; i++) {
+    write_value(writer, &writer->blocks[i].offset, sizeof(int64_t));
+    write_value(writer, &writer->blocks[i].type, sizeof(int));
+    write_value(writer, &writer->blocks[i].num_records, sizeof(int));
+    write_value(writer, &writer->blocks[i].start_timestamp, sizeof(double));
+    write_value(writer, &writer->blocks[i].end_timestamp, sizeof(double));
+  }
+  write_value(writer, &writer->num_messages, sizeof(int));
+  little_endian(writer->order, sizeof(unsigned short), writer->num_messages);
+  write_column(writer, writer->order, 
+	       writer->num_messages*sizeof(unsigned short), &header, &stored);
+  length = header.stored_size;
+  little_endian(&header, sizeof(unsigned int), 3);
+  write_data(writer, &header, sizeof(header));
+  write_data(writer, stored, length);
+  if (stored != (unsigned char *)writer->order)
+    free(stored);
+
+  write_value(writer, &footer_offset, sizeof(int64_t));
+  write_data(writer, COLLOG_END_MAGIC, COLLOG_END_MAGIC_LENGTH);
+
+  error = writer->error;
+  if (fclose(writer->fp) != 0)
+    error = 1;
+
+  for (i = 0; i < writer->num_types; i++) {
+    free(writer->types[i]->text);
+    free(writer->types[i]->ranges);
+    free(writer->types[i]);
+  }
+  free(writer->types);
+  free(writer->blocks);
+  free(writer->order);
+  free(writer);
+
+  return error ? -1 : 0;
+}
+
+/* reader */
+
+static int
+read_data(carmen_collog_reader_p reader, void *data, size_t size)
+{
+  return (size == 0 || 
+	  carmen_fread(data, 1, size, reader->infile) == size) ? 0 : -1;
+}
+
+static int
+read_value(carmen_collog_reader_p reader, void *value, int size)
+{
+  if (read_data(reader, value, size) < 0)
+    return -1;
+  little_endian(value, size, 1);
+  return 0;
+}
+
+static unsigned char *
+read_column(carmen_collog_reader_p reader, 
+	    collog_column_header_t *header)
+{
+  unsigned char *stored, *raw;
+
+  stored = (unsigned char *)malloc(header->stored_size + 1);
+  carmen_test_alloc(stored);
+  if (read_data(reader, stored, header->stored_size) < 0)
+    carmen_die("Error: columnar log is truncated.\n");
+  if (header->method == COLLOG_STORED)
+    return stored;
+
+#ifndef NO_ZLIB
+  if (header->method == COLLOG_DEFLATED) {
+    uLongf length = header->raw_size;
+
+    raw = (unsigned char *)malloc(header->raw_size + 1);
+    carmen_test_alloc(raw);
+    if (uncompress(raw, &length, stored, header->stored_size) != Z_OK ||
+	length != header->raw_size)
+      carmen_die("Error: corrupt block in columnar log.\n");
+    free(stored);
+    return raw;
+  }
+#endif
+  carmen_die("Error: unsupported compression in columnar log.\n");
+  return NULL;
+}
+
+static void
+free_block_data(collog_block_t *block)
+{
+  free(block->timestamps);
+  free(block->text_column);
+  free(block->range_column);
+  free(block->range_offsets);
+  block->timestamps = NULL;
+  block->text_column = NULL;
+  block->range_column = NULL;
+  block->range_offsets = NULL;
+}
+
+static collog_block_t *
+load_block(carmen_collog_reader_p reader, int block_num, int column)
+{
+  collog_block_t *block = reader->blocks + block_num;
+  int type = block->info.type, i, n = block->info.num_records;
+  char magic[4];
+
+  /* keep the decoded columns of one block per message type */
+  if (reader->decoded_block[type] != block_num) {
+    if (reader->decoded_block[type] >= 0)
+      free_block_data(reader->blocks + reader->decoded_block[type]);
+    reader->decoded_block[type] = block_num;
+  }
+
+  if (!block->header_read) {
+    carmen_fseek(reader->infile, block->info.offset, SEEK_SET);
+    if (read_data(reader, magic, 4) < 0 || 
+	memcmp(magic, COLLOG_BLOCK_MAGIC, 4) != 0 ||
+	read_value(reader, &i, sizeof(int)) < 0 || i != type ||
+	read_value(reader, &i, sizeof(int)) < 0 || i != n ||
+	read_data(reader, block->columns, sizeof(block->columns)) < 0)
+      carmen_die("Error: corrupt block in columnar log.\n");
+    little_endian(block->columns, sizeof(unsigned int), 
+		  3*COLLOG_NUM_COLUMNS);
+    block->column_offsets[0] = block->info.offset + 4 + 2*sizeof(int) + 
+      sizeof(block->columns);
+    for (i = 1; i < COLLOG_NUM_COLUMNS; i++)
+      block->column_offsets[i] = block->column_offsets[i - 1] + 
+	block->columns[i - 1].stored_size;
+    block->header_read = 1;
+  }
+
+  if (column == COLLOG_TIMESTAMPS && block->timestamps == NULL) {
+    carmen_fseek(reader->infile, block->column_offsets[column], SEEK_SET);
+    block->timestamps = (double *)
+      read_column(reader, block->columns + column);
+    little_endian(block->timestamps, sizeof(double), n);
+  }
+  else if (column == COLLOG_TEXT && block->text_column == NULL) {
+    carmen_fseek(reader->infile, block->column_offsets[column], SEEK_SET);
+    block->text_column = read_column(reader, block->columns + column);
+    little_endian(block->text_column, sizeof(unsigned int), 2*n + 1);
+    block->text_offsets = (unsigned int *)block->text_column;
+    block->split = block->text_offsets + n + 1;
+    block->text = (char *)(block->split + n);
+  }
+  else if (column == COLLOG_RANGES && block->range_column == NULL) {
+    carmen_fseek(reader->infile, block->column_offsets[column], SEEK_SET);
+    block->range_column = read_column(reader, block->columns + column);
+    little_endian(block->range_column, sizeof(unsigned int), n);
+    block->num_ranges = (unsigned int *)block->range_column;
+    block->range_offsets = (unsigned int *)
+      calloc(n + 1, sizeof(unsigned int));
+    carmen_test_alloc(block->range_offsets);
+    for (i = 0; i < n; i++)
+      block->range_offsets[i + 1] = block->range_offsets[i] + 
+	block->num_ranges[i];
+    block->low = block->range_column + n*sizeof(unsigned int);
+    block->high = block->low + block->range_offsets[n];
+  }
+
+  return block;
+}
+
+carmen_collog_reader_p
+carmen_collog_reader_open(carmen_FILE *infile)
+{
+  carmen_collog_reader_p reader;
+  collog_column_header_t header;
+  unsigned short *order;
+  int64_t footer_offset;
+  char magic[COLLOG_MAGIC_LENGTH];
+  int i, length, *count, **type_blocks, *num_type_blocks, type, occurrence;
+
+  if (!carmen_collog_is_columnar(infile))
+    return NULL;
+
+  reader = (carmen_collog_reader_p)calloc(1, sizeof(carmen_collog_reader_t));
+  carmen_test_alloc(reader);
+  reader->infile = infile;
+
+  carmen_fseek(infile, COLLOG_MAGIC_LENGTH, SEEK_SET);
+  if (read_value(reader, &reader->block_size, sizeof(int)) < 0 ||
+      reader->block_size <= 0)
+    carmen_die("Error: corrupt columnar log header.\n");
+
+  if (carmen_fseek(infile, -(off_t)(sizeof(int64_t) + 
+				    COLLOG_END_MAGIC_LENGTH), SEEK_END) < 0 ||
+      read_value(reader, &footer_offset, sizeof(int64_t)) < 0 ||
+      read_data(reader, magic, COLLOG_END_MAGIC_LENGTH) < 0 ||
+      memcmp(magic, COLLOG_END_MAGIC, COLLOG_END_MAGIC_LENGTH) != 0)
+    carmen_die("Error: columnar log is incomplete.\n");
+
+  carmen_fseek(infile, footer_offset, SEEK_SET);
+  if (read_data(reader, magic, 4) < 0 || 
+      memcmp(magic, COLLOG_FOOTER_MAGIC, 4) != 0 ||
+      read_value(reader, &reader->num_types, sizeof(int)) < 0)
+    carmen_die("Error: corrupt columnar log footer.\n");
+
+  reader->type_names = (char **)calloc(reader->num_types, sizeof(char *));
+  carmen_test_alloc(reader->type_names);
+  reader->decoded_block = (int *)malloc(reader->num_types*sizeof(int));
+  carmen_test_alloc(reader->decoded_block);
+  for (i = 0; i < reader->num_types; i++) {
+    if (read_value(reader, &length, sizeof(int)) < 0 || length < 0 ||
+	length >= COLLOG_MAX_TYPE_LENGTH)
+      carmen_die("Error: corrupt columnar log footer.\n");
+    reader->type_names[i] = (char *)calloc(length + 1, 1);
+    carmen_test_alloc(reader->type_names[i]);
+    read_data(reader, reader->type_names[i], length);
+    reader->decoded_block[i] = -1;
+  }
+
+  if (read_value(reader, &reader->num_blocks, sizeof(int)) < 0)
+    carmen_die("Error: corrupt columnar log footer.\n");
+  reader->blocks = (collog_block_t *)
+    calloc(reader->num_blocks, sizeof(collog_block_t));
+  carmen_test_alloc(reader->blocks);
+  for (i = 0; i < reader->num_blocks; i++) {
+    collog_block_info_t *info = &reader->blocks[i].info;
+    if (read_value(reader, &info->offset, sizeof(int64_t)) < 0 ||
+	read_value(reader, &info->type, sizeof(int)) < 0 ||
+	read_value(reader, &info->num_records, sizeof(int)) < 0 ||
+	read_value(reader, &info->start_timestamp, sizeof(double)) < 0 ||
+	read_value(reader, &info->end_timestamp, sizeof(double)) < 0 ||
+	info->type < 0 || info->type >= reader->num_types)
+      carmen_die("Error: corrupt columnar log footer.\n");
+  }
+
+  if (read_value(reader, &reader->num_messages, sizeof(int)) < 0 ||
+      read_data(reader, &header, sizeof(header)) < 0)
+    carmen_die("Error: corrupt columnar log footer.\n");
+  little_endian(&header, sizeof(unsigned int), 3);
+  order = (unsigned short *)read_column(reader, &header);
+  little_endian(order, sizeof(unsigned short), reader->num_messages);
+
+  /* map every message to its block, using that the blocks of a message
+     type are full except for the last one */
+  count = (int *)calloc(reader->num_types, sizeof(int));
+  carmen_test_alloc(count);
+  num_type_blocks = (int *)calloc(reader->num_types, sizeof(int));
+  carmen_test_alloc(num_type_blocks);
+  type_blocks = (int **)calloc(reader->num_types, sizeof(int *));
+  carmen_test_alloc(type_blocks);
+  for (i = 0; i < reader->num_blocks; i++)
+    num_type_blocks[reader->blocks[i].info.type]++;
+  for (i = 0; i < reader->num_types; i++) {
+    type_blocks[i] = (int *)calloc(num_type_blocks[i] + 1, sizeof(int));
+    carmen_test_alloc(type_blocks[i]);
+    num_type_blocks[i] = 0;
+  }
+  for (i = 0; i < reader->num_blocks; i++) {
+    type = reader->blocks[i].info.type;
+    type_blocks[type][num_type_blocks[type]++] = i;
+  }
+
+  reader->message_block = (int *)malloc(reader->num_messages*sizeof(int));
+  carmen_test_alloc(reader->message_block);
+  reader->message_record = (int *)malloc(reader->num_messages*sizeof(int));
+  carmen_test_alloc(reader->message_record);
+  for (i = 0; i < reader->num_messages; i++) {
+    type = order[i];
+    occurrence = count[type]++;
+    if (type >= reader->num_types || 
+	occurrence / reader->block_size >= num_type_blocks[type])
+      carmen_die("Error: corrupt columnar log footer.\n");
+    reader->message_block[i] = 
+      type_blocks[type][occurrence / reader->block_size];
+    reader->message_record[i] = occurrence % reader->block_size;
+  }
+
+  for (i = 0; i < reader->num_types; i++)
+    free(type_blocks[i]);
+  free(type_blocks);
+  free(num_type_blocks);
+  free(count);
+  free(order);
+
+  return reader;
+}
+
+void
+carmen_collog_reader_free(carmen_collog_reader_p reader)
+{
+  int i;
+
+  if (reader == NULL)
+    return;
+
+  for (i = 0; i < reader->num_blocks; i++)
+    free_block_data(reader->blocks + i);
+  for (i = 0; i < reader->num_types; i++)
+    free(reader->type_names[i]);
+  free(reader->type_names);
+  free(reader->decoded_block);
+  free(reader->blocks);
+  free(reader->message_block);
+  free(reader->message_record);
+  free(reader);
+}
+
+int
+carmen_collog_num_messages(carmen_collog_reader_p reader)
+{
+  return reader->num_messages;
+}
+
+int
+carmen_collog_read_line(carmen_collog_reader_p reader, int message_num, 
+			int max_line_length, char *line)
+{
+  collog_block_t *block;
+  unsigned int record, start, length, split, range, previous = 0, i;
+  int n = 0;
+
+  if (message_num < 0 || message_num >= reader->num_messages) {
+    line[0] = '\0';
+    return 0;
+  }
+
+  block = load_block(reader, reader->message_block[message_num], 
+		     COLLOG_TEXT);
+  record = reader->message_record[message_num];
+  start = block->text_offsets[record];
+  length = block->text_offsets[record + 1] - start;
+  split = block->split[record];
+
+  if (split == COLLOG_NO_SPLIT) {
+    if ((int)length >= max_line_length)
+      carmen_die("Error: exceed maximum line length.\n");
+    memcpy(line, block->text + start, length);
+    line[length] = '\0';
+    return length;
+  }
+
+  load_block(reader, reader->message_block[message_num], COLLOG_RANGES);
+  if ((int)(length + 7*block->num_ranges[record]) >= max_line_length)
+    carmen_die("Error: exceed maximum line length.\n");
+
+  memcpy(line, block->text + start, split);
+  n = split;
+  for (i = block->range_offsets[record]; 
+       i < block->range_offsets[record + 1]; i++) {
+    range = zigzag_decode(block->low[i] | (block->high[i] << 8), previous);
+    n += format_range(range, line + n);
+    line[n++] = ' ';
+    previous = range;
+  }
+  memcpy(line + n, block->text + start + split, length - split);
+  n += length - split;
+  line[n] = '\0';
+
+  return n;
+}
+
+const char *
+carmen_collog_message_type(carmen_collog_reader_p reader, int message_num)
+{
+  collog_block_t *block;
+
+  if (message_num < 0 || message_num >= reader->num_messages)
+    return "";
+
+  block = reader->blocks + reader->message_block[message_num];
+  return reader->type_names[block->info.type];
+}
+
+int
+carmen_collog_read_text(carmen_collog_reader_p reader, int message_num, 
+			int max_line_length, char *text, 
+			int *ranges_in_column)
+{
+  collog_block_t *block;
+  unsigned int record, start, length;
+
+  *ranges_in_column = 0;
+  if (message_num < 0 || message_num >= reader->num_messages) {
+    text[0] = '\0';
+    return 0;
+  }
+
+  block = load_block(reader, reader->message_block[message_num], 
+		     COLLOG_TEXT);
+  record = reader->message_record[message_num];
+  start = block->text_offsets[record];
+  length = block->text_offsets[record + 1] - start;
+  if ((int)length >= max_line_length)
+    carmen_die("Error: exceed maximum line length.\n");
+
+  memcpy(text, block->text + start, length);
+  text[length] = '\0';
+  *ranges_in_column = (block->split[record] != COLLOG_NO_SPLIT);
+
+  return length;
+}
+
+int
+carmen_collog_read_ranges(carmen_collog_reader_p reader, int message_num, 
+			  int max_ranges, float *range)
+{
+  collog_block_t *block;
+  unsigned int record, first, previous = 0, i;
+  int n;
+
+  if (message_num < 0 || message_num >= reader->num_messages)
+    return 0;
+
+  block = load_block(reader, reader->message_block[message_num], 
+		     COLLOG_RANGES);
+  record = reader->message_record[message_num];
+  first = block->range_offsets[record];
+  n = block->num_ranges[record];
+  if (n > max_ranges)
+    carmen_die("Error: message %d has %d instead of %d range readings.\n",
+	       message_num, n, max_ranges);
+
+  for (i = 0; i < (unsigned int)n; i++) {
+    previous = zigzag_decode(block->low[first + i] | 
+			     (block->high[first + i] << 8), previous);
+    range[i] = previous / 1000.0;
+  }
+
+  return n;
+}
+
+double
+carmen_collog_message_timestamp(carmen_collog_reader_p reader, 
+				int message_num)
+{
+  collog_block_t *block;
+
+  if (message_num < 0 || message_num >= reader->num_messages)
+    return 0.0;
+
+  block = load_block(reader, reader->message_block[message_num], 
+		     COLLOG_TIMESTAMPS);
+  return block->timestamps[reader->message_record[message_num]];
+}
+
+int
+carmen_collog_find_timestamp(carmen_collog_reader_p reader, 
+			     double timestamp)
+{
+  int low = 0, high = reader->num_messages, middle;
+
+  while (low < high) {
+    middle = (low + high) / 2;
+    if (carmen_collog_message_timestamp(reader, middle) < timestamp)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return low;
+}
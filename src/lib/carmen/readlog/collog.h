@@ -0,0 +1,157 @@
+ /*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/** @addtogroup logger libreadlog **/
+// @{
+
+/** 
+ * \file collog.h 
+ * \brief Columnar binary log files.
+ *
+ * A columnar log stores the lines of a carmen log file grouped into
+ * blocks of messages of the same type. Each block keeps the logger
+ * timestamps, the message text and the laser range readings in
+ * separately compressed columns. Ranges written with millimeter
+ * precision are stored as 16 bit integers, delta coded along the
+ * scan. A block table and the message order at the end of the file
+ * allow to index a log without decompressing any block, and a block
+ * is only decompressed when one of its messages is read. Its range
+ * column is only decoded for messages that carry ranges.
+ *
+ * Conversion is lossless: reading a columnar log returns exactly the
+ * lines it was written from. Readers that want messages rather than
+ * lines take the text of a message with its ranges cut out
+ * (carmen_collog_read_text) and decode the ranges straight into the
+ * message (carmen_collog_read_ranges), so the ranges are never formatted
+ * and parsed again. readlog does this in
+ * carmen_logfile_read_robot_laser_message and
+ * carmen_logfile_read_laser_laser_message.
+ *
+ * Values are stored little-endian, so a log written on one machine can
+ * be read on any other.
+ **/
+
+#ifndef CARMEN_COLLOG_H
+#define CARMEN_COLLOG_H
+
+#include "carmen_stdio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CARMEN_COLLOG_EXTENSION ".cclf"
+
+/** Number of messages in a full block. **/
+#define CARMEN_COLLOG_BLOCK_SIZE 512
+
+typedef struct carmen_collog_writer carmen_collog_writer_t, 
+  *carmen_collog_writer_p;
+
+typedef struct carmen_collog_reader carmen_collog_reader_t, 
+  *carmen_collog_reader_p;
+
+/** Checks whether an opened log file is a columnar log. The file
+ * position is reset to the start of the file.
+ **/
+int carmen_collog_is_columnar(carmen_FILE *infile);
+
+/** Checks whether the named file is a columnar log. **/
+int carmen_collog_file_is_columnar(const char *filename);
+
+/** Creates a new columnar log. 
+ * @returns A pointer to the writer or NULL if the file could not be
+ * opened.
+ **/
+carmen_collog_writer_p carmen_collog_writer_open(const char *filename);
+
+/** Appends a line of a carmen log file, including its line break. **/
+int carmen_collog_write_line(carmen_collog_writer_p writer, const char *line);
+
+/** Writes all pending blocks and the block table and closes the file.
+ * @returns 0 on success, -1 on errors.
+ **/
+int carmen_collog_writer_close(carmen_collog_writer_p writer);
+
+/** Reads the block table of a columnar log. No block is decompressed.
+ * @returns A pointer to the reader or NULL if infile is no columnar log.
+ **/
+carmen_collog_reader_p carmen_collog_reader_open(carmen_FILE *infile);
+
+void carmen_collog_reader_free(carmen_collog_reader_p reader);
+
+int carmen_collog_num_messages(carmen_collog_reader_p reader);
+
+/** Reads the line of a message, in the format of carmen_logfile_read_line.
+ * @returns Number of read bytes.
+ **/
+int carmen_collog_read_line(carmen_collog_reader_p reader, int message_num, 
+			    int max_line_length, char *line);
+
+/** Message type (the first word of its line). No block is decompressed. **/
+const char *carmen_collog_message_type(carmen_collog_reader_p reader, 
+				       int message_num);
+
+/** Reads the line of a message like carmen_collog_read_line, but leaves
+ * out the range readings if they are stored in the range column. The
+ * text then continues right after the number of readings.
+ * @param ranges_in_column Set to 1 if the readings were left out, and
+ * to 0 if they are part of the text.
+ * @returns Number of read bytes.
+ **/
+int carmen_collog_read_text(carmen_collog_reader_p reader, int message_num, 
+			    int max_line_length, char *text, 
+			    int *ranges_in_column);
+
+/** Decodes the range readings of a message, in meters, into range.
+ * Only the range column of its block is decompressed.
+ * @returns Number of readings, 0 for messages without readings in the
+ * range column.
+ **/
+int carmen_collog_read_ranges(carmen_collog_reader_p reader, int message_num, 
+			      int max_ranges, float *range);
+
+/** Logger timestamp of a message. Only the timestamp column of its
+ * block is decompressed. Lines without timestamp, such as comments,
+ * inherit the timestamp of the preceding message.
+ **/
+double carmen_collog_message_timestamp(carmen_collog_reader_p reader, 
+				       int message_num);
+
+/** Finds the first message with a logger timestamp not less than
+ * timestamp, assuming that logger timestamps do not decrease.
+ **/
+int carmen_collog_find_timestamp(carmen_collog_reader_p reader, 
+				 double timestamp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+// @}
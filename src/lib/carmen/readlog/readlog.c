@@ -54,6 +54,41 @@ off_t carmen_logfile_uncompressed_length(carmen_FILE *infile)
   }
 }
 
+#define LOGFILE_TAIL_LENGTH      256
+#define LOGFILE_MAX_LINE_LENGTH  100000
+
+/* Parses the last words of a line, "... ipc_timestamp ipc_hostname
+   logger_timestamp". The tail may start in the middle of a word, which
+   does not matter as long as it holds these three. There must be room
+   for a terminating '\0' after length characters. */
+static int logfile_tail_timestamp(char *tail, int length, 
+				  double *logger_timestamp, 
+				  double *ipc_timestamp)
+{
+  char *word[3], *end;
+  int i = length, w;
+
+  tail[length] = '\0';
+  for(w = 0; w < 3; w++) {
+    while(i > 0 && isspace((unsigned char)tail[i - 1]))
+      tail[--i] = '\0';
+    if(i == 0)
+      return 0;
+    while(i > 0 && !isspace((unsigned char)tail[i - 1]))
+      i--;
+    if(i == 0)
+      return 0;
+    word[w] = tail + i;
+  }
+  *logger_timestamp = strtod(word[0], &end);
+  if(end == word[0] || *end != '\0')
+    return 0;
+  *ipc_timestamp = strtod(word[2], &end);
+  if(end == word[2] || *end != '\0')
+    return 0;
+  return 1;
+}
+
 /** 
  * Builds the index structure used for parsing a carmen log file. 
  **/
@@ -62,6 +97,9 @@ carmen_logfile_index_p carmen_logfile_index_messages(carmen_FILE *infile)
   carmen_logfile_index_p index;
   int i, found_linebreak = 1, nread, max_messages;
   off_t file_length = 0, file_position = 0, total_bytes, read_count = 0;
+  char tail[LOGFILE_TAIL_LENGTH], *line;
+  int tail_length = 0, comment = 0, found_start = 0;
+  double timestamp = 0, logger_timestamp, ipc_timestamp;
 
   unsigned char buffer[10000];
 
@@ -69,6 +107,29 @@ carmen_logfile_index_p carmen_logfile_index_messages(carmen_FILE *infile)
   index = (carmen_logfile_index_p)calloc(1, sizeof(carmen_logfile_index_t));
   carmen_test_alloc(index);
 
+  /* columnar logs carry their own index */
+  index->columnar = carmen_collog_reader_open(infile);
+  if(index->columnar != NULL) {
+    index->num_messages = carmen_collog_num_messages(index->columnar);
+    line = (char *)malloc(LOGFILE_MAX_LINE_LENGTH);
+    carmen_test_alloc(line);
+    for(i = 0; i < index->num_messages && i < 1000; i++) {
+      nread = carmen_collog_read_line(index->columnar, i, 
+				      LOGFILE_MAX_LINE_LENGTH, line);
+      if(nread > 0 && line[0] != '#' &&
+	 logfile_tail_timestamp(line, nread, &logger_timestamp,
+				&ipc_timestamp)) {
+	index->start_time = ipc_timestamp - logger_timestamp;
+	break;
+      }
+    }
+    free(line);
+    fprintf(stderr, "\rIndexing messages (100%%) - %d messages found "
+	    "in columnar log.\n", index->num_messages);
+    index->current_position = 0;
+    return index;
+  }
+
   /* compute the total length of the uncompressed logfile. */
   fprintf(stderr, "\n\rIndexing messages (0%%)    ");
   file_length = carmen_logfile_uncompressed_length(infile);
@@ -78,6 +139,8 @@ carmen_logfile_index_p carmen_logfile_index_messages(carmen_FILE *infile)
   max_messages = 10000;
   index->offset = (off_t*)calloc(max_messages, sizeof(off_t));
   carmen_test_alloc(index->offset);
+  index->timestamp = (double*)calloc(max_messages, sizeof(double));
+  carmen_test_alloc(index->timestamp);
 
   carmen_fseek(infile, 0L, SEEK_SET);
 
@@ -103,12 +166,38 @@ carmen_logfile_index_p carmen_logfile_index_messages(carmen_FILE *infile)
 	    index->offset = (off_t*)realloc(index->offset, max_messages *
 						sizeof(off_t));
 	    carmen_test_alloc(index->offset);
+	    index->timestamp = (double*)realloc(index->timestamp, 
+						max_messages * sizeof(double));
+	    carmen_test_alloc(index->timestamp);
 	  }
 	  index->offset[index->num_messages] = total_bytes + i;
 	  index->num_messages++;
+	  comment = (buffer[i] == '#');
+	  tail_length = 0;
         }
-        if(buffer[i] == '\n')
+	if(found_linebreak)
+	  continue;
+        if(buffer[i] == '\n') {
           found_linebreak = 1;
+	  if(!comment && logfile_tail_timestamp(tail, tail_length, 
+						&logger_timestamp,
+						&ipc_timestamp)) {
+	    timestamp = logger_timestamp;
+	    if(!found_start) {
+	      index->start_time = ipc_timestamp - logger_timestamp;
+	      found_start = 1;
+	    }
+	  }
+	  index->timestamp[index->num_messages - 1] = timestamp;
+	  continue;
+	}
+	/* keep the last part of the line, where the timestamps are */
+	if(tail_length == LOGFILE_TAIL_LENGTH - 1) {
+	  memmove(tail, tail + LOGFILE_TAIL_LENGTH / 2, 
+		  LOGFILE_TAIL_LENGTH / 2 - 1);
+	  tail_length = LOGFILE_TAIL_LENGTH / 2 - 1;
+	}
+	tail[tail_length++] = buffer[i];
       }
       total_bytes += nread;
     }
@@ -123,6 +212,16 @@ carmen_logfile_index_p carmen_logfile_index_messages(carmen_FILE *infile)
     carmen_test_alloc(index->offset);
   }
   index->offset[index->num_messages] = total_bytes;
+  /* the last line may lack a linebreak */
+  if(!found_linebreak) {
+    if(!comment && logfile_tail_timestamp(tail, tail_length, 
+					  &logger_timestamp, &ipc_timestamp)) {
+      timestamp = logger_timestamp;
+      if(!found_start)
+	index->start_time = ipc_timestamp - logger_timestamp;
+    }
+    index->timestamp[index->num_messages - 1] = timestamp;
+  }
 
   fprintf(stderr, "\rIndexing messages (100%%) - %d messages found.      \n",
 	  index->num_messages);
@@ -141,10 +240,297 @@ void carmen_logfile_free_index(carmen_logfile_index_p* pindex) {
   if ( (*pindex)->offset != NULL) {
     free( (*pindex)->offset);
   }
+  if ( (*pindex)->timestamp != NULL) {
+    free( (*pindex)->timestamp);
+  }
+  carmen_collog_reader_free((*pindex)->columnar);
   free(*pindex);
   (*pindex) = NULL;
 }
 
+#define LOGFILE_INDEX_MAGIC    "CARMENIX"
+#define LOGFILE_INDEX_VERSION  1
+
+/* Header of a stored index. It is followed by num_messages + 1 offsets
+   and num_messages timestamps, all in host byte order, as the index is
+   only a cache of the log next to it. */
+typedef struct {
+  char magic[8];
+  int version;
+  int offset_size;
+  long long log_size;
+  long long log_mtime;
+  int num_messages;
+  int pad;
+  double start_time;
+} logfile_index_header_t;
+
+static char *logfile_index_filename(const char *filename)
+{
+  char *index_filename;
+
+  index_filename = (char *)calloc(strlen(filename) + 
+				  strlen(CARMEN_LOGFILE_INDEX_EXTENSION) + 5,
+				  1);
+  carmen_test_alloc(index_filename);
+  sprintf(index_filename, "%s%s", filename, CARMEN_LOGFILE_INDEX_EXTENSION);
+  return index_filename;
+}
+
+static void logfile_index_header(logfile_index_header_t *header, 
+				 struct stat *log_stat, int num_messages)
+{
+  memset(header, 0, sizeof(logfile_index_header_t));
+  memcpy(header->magic, LOGFILE_INDEX_MAGIC, 8);
+  header->version = LOGFILE_INDEX_VERSION;
+  header->offset_size = sizeof(off_t);
+  header->log_size = log_stat->st_size;
+  header->log_mtime = log_stat->st_mtime;
+  header->num_messages = num_messages;
+}
+
+static carmen_logfile_index_p logfile_load_index(const char *index_filename,
+						 struct stat *log_stat)
+{
+  logfile_index_header_t header, expected;
+  carmen_logfile_index_p index;
+  FILE *fp;
+  int n;
+
+  fp = fopen(index_filename, "r");
+  if(fp == NULL)
+    return NULL;
+  if(fread(&header, sizeof(logfile_index_header_t), 1, fp) != 1) {
+    fclose(fp);
+    return NULL;
+  }
+  logfile_index_header(&expected, log_stat, header.num_messages);
+  expected.start_time = header.start_time;
+  if(memcmp(&header, &expected, sizeof(logfile_index_header_t)) != 0 ||
+     header.num_messages < 0) {
+    fclose(fp);
+    return NULL;
+  }
+
+  n = header.num_messages;
+  index = (carmen_logfile_index_p)calloc(1, sizeof(carmen_logfile_index_t));
+  carmen_test_alloc(index);
+  index->num_messages = n;
+  index->start_time = header.start_time;
+  index->offset = (off_t*)calloc(n + 1, sizeof(off_t));
+  carmen_test_alloc(index->offset);
+  index->timestamp = (double*)calloc(n + 1, sizeof(double));
+  carmen_test_alloc(index->timestamp);
+  if(fread(index->offset, sizeof(off_t), n + 1, fp) != (size_t)n + 1 ||
+     fread(index->timestamp, sizeof(double), n, fp) != (size_t)n) {
+    fclose(fp);
+    carmen_logfile_free_index(&index);
+    return NULL;
+  }
+  fclose(fp);
+  return index;
+}
+
+/* Writes to a temporary file first, so that a reader never sees half an
+   index. A log in a read-only directory simply goes without. */
+static void logfile_save_index(carmen_logfile_index_p index, 
+			       const char *index_filename, 
+			       struct stat *log_stat)
+{
+  logfile_index_header_t header;
+  char *temp_filename;
+  FILE *fp;
+  int n = index->num_messages, err;
+
+  temp_filename = (char *)calloc(strlen(index_filename) + 32, 1);
+  carmen_test_alloc(temp_filename);
+  sprintf(temp_filename, "%s.%d", index_filename, (int)getpid());
+  fp = fopen(temp_filename, "w");
+  if(fp == NULL) {
+    free(temp_filename);
+    return;
+  }
+  logfile_index_header(&header, log_stat, n);
+  header.start_time = index->start_time;
+  err = (fwrite(&header, sizeof(logfile_index_header_t), 1, fp) != 1 ||
+	 fwrite(index->offset, sizeof(off_t), n + 1, fp) != (size_t)n + 1 ||
+	 fwrite(index->timestamp, sizeof(double), n, fp) != (size_t)n);
+  err |= (fclose(fp) != 0);
+  if(err || rename(temp_filename, index_filename) != 0)
+    unlink(temp_filename);
+  free(temp_filename);
+}
+
+carmen_logfile_index_p carmen_logfile_index_messages_cached(carmen_FILE *infile,
+							     const char *filename)
+{
+  carmen_logfile_index_p index;
+  struct stat log_stat;
+  char *index_filename;
+
+  if(filename == NULL || stat(filename, &log_stat) != 0 ||
+     carmen_collog_is_columnar(infile))
+    return carmen_logfile_index_messages(infile);
+
+  index_filename = logfile_index_filename(filename);
+  index = logfile_load_index(index_filename, &log_stat);
+  if(index != NULL) {
+    fprintf(stderr, "\rIndexing messages (100%%) - %d messages found "
+	    "in %s.\n", index->num_messages, index_filename);
+    carmen_fseek(infile, 0L, SEEK_SET);
+  }
+  else {
+    index = carmen_logfile_index_messages(infile);
+    logfile_save_index(index, index_filename, &log_stat);
+  }
+  free(index_filename);
+  return index;
+}
+
+double carmen_logfile_message_timestamp(carmen_logfile_index_p index,
+					int message_num)
+{
+  if(message_num < 0 || message_num >= index->num_messages)
+    return 0;
+  if(index->columnar != NULL)
+    return carmen_collog_message_timestamp(index->columnar, message_num);
+  return index->timestamp[message_num];
+}
+
+int carmen_logfile_find_timestamp(carmen_logfile_index_p index, 
+				  double timestamp)
+{
+  int low = 0, high = index->num_messages, middle;
+
+  if(index->columnar != NULL)
+    return carmen_collog_find_timestamp(index->columnar, timestamp);
+
+  while(low < high) {
+    middle = low + (high - low) / 2;
+    if(index->timestamp[middle] < timestamp)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low;
+}
+
+static int logfile_merge_before(carmen_logfile_merge_p merge, int a, int b)
+{
+  double time_a, time_b;
+
+  time_a = carmen_logfile_merge_time(merge, a, merge->next[a]);
+  time_b = carmen_logfile_merge_time(merge, b, merge->next[b]);
+  /* logs given first win ties, so the order is deterministic */
+  return time_a < time_b || (time_a == time_b && a < b);
+}
+
+static void logfile_merge_sift_down(carmen_logfile_merge_p merge, int i)
+{
+  int child, log;
+
+  while((child = 2 * i + 1) < merge->heap_size) {
+    if(child + 1 < merge->heap_size &&
+       logfile_merge_before(merge, merge->heap[child + 1], merge->heap[child]))
+      child++;
+    if(!logfile_merge_before(merge, merge->heap[child], merge->heap[i]))
+      break;
+    log = merge->heap[i];
+    merge->heap[i] = merge->heap[child];
+    merge->heap[child] = log;
+    i = child;
+  }
+}
+
+carmen_logfile_merge_p carmen_logfile_merge_new(int num_logs, 
+						carmen_logfile_index_p *index)
+{
+  carmen_logfile_merge_p merge;
+  double first_start = 0;
+  int i, found_start = 0;
+
+  merge = (carmen_logfile_merge_p)calloc(1, sizeof(carmen_logfile_merge_t));
+  carmen_test_alloc(merge);
+  merge->num_logs = num_logs;
+  merge->index = (carmen_logfile_index_p *)
+    calloc(num_logs, sizeof(carmen_logfile_index_p));
+  carmen_test_alloc(merge->index);
+  merge->offset = (double *)calloc(num_logs, sizeof(double));
+  carmen_test_alloc(merge->offset);
+  merge->next = (int *)calloc(num_logs, sizeof(int));
+  carmen_test_alloc(merge->next);
+  merge->heap = (int *)calloc(num_logs, sizeof(int));
+  carmen_test_alloc(merge->heap);
+
+  for(i = 0; i < num_logs; i++) {
+    merge->index[i] = index[i];
+    if(index[i]->start_time != 0 &&
+       (!found_start || index[i]->start_time < first_start)) {
+      first_start = index[i]->start_time;
+      found_start = 1;
+    }
+  }
+  /* logs without IPC timestamps start with the timeline */
+  for(i = 0; i < num_logs; i++)
+    if(index[i]->start_time != 0)
+      merge->offset[i] = index[i]->start_time - first_start;
+
+  carmen_logfile_merge_seek(merge, 0);
+  return merge;
+}
+
+void carmen_logfile_merge_free(carmen_logfile_merge_p merge)
+{
+  if(merge == NULL)
+    return;
+  free(merge->index);
+  free(merge->offset);
+  free(merge->next);
+  free(merge->heap);
+  free(merge);
+}
+
+double carmen_logfile_merge_time(carmen_logfile_merge_p merge, int log, 
+				 int message_num)
+{
+  return merge->offset[log] + 
+    carmen_logfile_message_timestamp(merge->index[log], message_num);
+}
+
+void carmen_logfile_merge_seek(carmen_logfile_merge_p merge, double time)
+{
+  int i;
+
+  merge->heap_size = 0;
+  for(i = 0; i < merge->num_logs; i++) {
+    merge->next[i] = carmen_logfile_find_timestamp(merge->index[i], 
+						   time - merge->offset[i]);
+    if(merge->next[i] < merge->index[i]->num_messages)
+      merge->heap[merge->heap_size++] = i;
+  }
+  for(i = merge->heap_size / 2 - 1; i >= 0; i--)
+    logfile_merge_sift_down(merge, i);
+}
+
+int carmen_logfile_merge_next(carmen_logfile_merge_p merge, int *log,
+			      int *message_num, double *time)
+{
+  int first;
+
+  if(merge->heap_size == 0)
+    return 0;
+  first = merge->heap[0];
+  *log = first;
+  *message_num = merge->next[first];
+  *time = carmen_logfile_merge_time(merge, first, merge->next[first]);
+
+  merge->next[first]++;
+  if(merge->next[first] >= merge->index[first]->num_messages)
+    merge->heap[0] = merge->heap[--merge->heap_size];
+  logfile_merge_sift_down(merge, 0);
+  return 1;
+}
+
 int carmen_logfile_eof(carmen_logfile_index_p index)
 {
   if(index->current_position > index->num_messages - 1)
@@ -162,6 +548,13 @@ int carmen_logfile_read_line(carmen_logfile_index_p index, carmen_FILE *infile,
 			     int message_num, int max_line_length, char *line)
 {
   size_t nread;
+
+  if(index->columnar != NULL) {
+    nread = carmen_collog_read_line(index->columnar, message_num,
+				    max_line_length, line);
+    index->current_position = message_num + 1;
+    return nread;
+  }
   
   /* are we moving sequentially through the logfile?  If not, fseek */
   if(message_num != index->current_position) {
@@ -230,6 +623,27 @@ void copy_host_string(char **host, char **string)
 #define CLF_READ_INT(str) (int)strtol(*(str), (str), 10)
 #define CLF_READ_CHAR(str) (char) ( ( (*str)++)[0] )
 
+/* The laser parsers take the range readings from the text, or from the
+   range column of a columnar log if they were cut out of the text. */
+typedef struct {
+  carmen_collog_reader_p columnar;
+  int message_num;
+} logfile_ranges_t, *logfile_ranges_p;
+
+static char *read_ranges(char *current_pos, int num_readings, float *range,
+			 logfile_ranges_p ranges)
+{
+  int i;
+
+  if(ranges != NULL)
+    carmen_collog_read_ranges(ranges->columnar, ranges->message_num, 
+			      num_readings, range);
+  else
+    for(i = 0; i < num_readings; i++)
+      range[i] = CLF_READ_DOUBLE(&current_pos);
+  return current_pos;
+}
+
 char *carmen_string_to_base_odometry_message(char *string,
 					     carmen_base_odometry_message
 					     *odometry)
@@ -334,12 +748,12 @@ double carmen_laser_guess_angle_increment(int num_beams)
       ((double) (num_beams-1));
 }
 
-char *carmen_string_to_laser_laser_message_orig(char *string,
+static char *string_to_laser_laser_message_orig(char *string,
 						carmen_laser_laser_message
-						*laser)
+						*laser, logfile_ranges_p ranges)
 {
   char *current_pos = string;
-  int i, num_readings;
+  int num_readings;
 
   if (strncmp(current_pos, "LASER", 5) == 0)
     current_pos = carmen_next_word(current_pos); 
@@ -352,8 +766,8 @@ char *carmen_string_to_laser_laser_message_orig(char *string,
 				    sizeof(float));
     carmen_test_alloc(laser->range);
   }
-  for(i = 0; i < laser->num_readings; i++)
-    laser->range[i] = CLF_READ_DOUBLE(&current_pos);
+  current_pos = read_ranges(current_pos, laser->num_readings, laser->range,
+			    ranges);
   laser->timestamp = CLF_READ_DOUBLE(&current_pos);
   copy_host_string(&laser->host, &current_pos);
 
@@ -374,9 +788,9 @@ char *carmen_string_to_laser_laser_message_orig(char *string,
   return current_pos;
 }
 
-char *carmen_string_to_robot_laser_message_orig(char *string,
+static char *string_to_robot_laser_message_orig(char *string,
 						carmen_robot_laser_message
-						*laser)
+						*laser, logfile_ranges_p ranges)
 {
   char *current_pos = string;
   int i, num_readings;
@@ -394,10 +808,10 @@ char *carmen_string_to_robot_laser_message_orig(char *string,
     laser->tooclose = (char *)realloc(laser->tooclose, laser->num_readings);
     carmen_test_alloc(laser->tooclose);
   }
-  for(i = 0; i < laser->num_readings; i++) {
-    laser->range[i] = CLF_READ_DOUBLE(&current_pos);
+  current_pos = read_ranges(current_pos, laser->num_readings, laser->range,
+			    ranges);
+  for(i = 0; i < laser->num_readings; i++)
     laser->tooclose[i] = 0;
-  }
 
   laser->laser_pose.x = CLF_READ_DOUBLE(&current_pos);
   laser->laser_pose.y = CLF_READ_DOUBLE(&current_pos);
@@ -425,8 +839,9 @@ char *carmen_string_to_robot_laser_message_orig(char *string,
   return current_pos;
 }
 
-char *carmen_string_to_laser_laser_message(char *string,
-					   carmen_laser_laser_message *laser)
+static char *string_to_laser_laser_message(char *string,
+					   carmen_laser_laser_message *laser,
+					   logfile_ranges_p ranges)
 {
   char *current_pos = string;
   int i, num_readings, num_remissions;
@@ -453,8 +868,8 @@ char *carmen_string_to_laser_laser_message(char *string,
 				    sizeof(float));
     carmen_test_alloc(laser->range);
   }
-  for(i = 0; i < laser->num_readings; i++)
-    laser->range[i] = CLF_READ_DOUBLE(&current_pos);
+  current_pos = read_ranges(current_pos, laser->num_readings, laser->range,
+			    ranges);
 
   num_remissions = CLF_READ_INT(&current_pos);
   if(laser->num_remissions != num_remissions) {
@@ -472,8 +887,9 @@ char *carmen_string_to_laser_laser_message(char *string,
   return current_pos;
 }
 
-char *carmen_string_to_robot_laser_message(char *string,
-					   carmen_robot_laser_message *laser)
+static char *string_to_robot_laser_message(char *string,
+					   carmen_robot_laser_message *laser,
+					   logfile_ranges_p ranges)
 {
   char *current_pos = string;
   int i, num_readings, num_remissions;
@@ -507,10 +923,10 @@ char *carmen_string_to_robot_laser_message(char *string,
     
 
   }
-  for(i = 0; i < laser->num_readings; i++) {
-    laser->range[i] = CLF_READ_DOUBLE(&current_pos);
+  current_pos = read_ranges(current_pos, laser->num_readings, laser->range,
+			    ranges);
+  for(i = 0; i < laser->num_readings; i++)
     laser->tooclose[i] = 0;
-  }
 
   num_remissions = CLF_READ_INT(&current_pos);
   if(laser->num_remissions != num_remissions) {
@@ -542,6 +958,100 @@ char *carmen_string_to_robot_laser_message(char *string,
 }
 
 
+char *carmen_string_to_laser_laser_message_orig(char *string,
+						carmen_laser_laser_message
+						*laser)
+{
+  return string_to_laser_laser_message_orig(string, laser, NULL);
+}
+
+char *carmen_string_to_robot_laser_message_orig(char *string,
+						carmen_robot_laser_message
+						*laser)
+{
+  return string_to_robot_laser_message_orig(string, laser, NULL);
+}
+
+char *carmen_string_to_laser_laser_message(char *string,
+					   carmen_laser_laser_message *laser)
+{
+  return string_to_laser_laser_message(string, laser, NULL);
+}
+
+char *carmen_string_to_robot_laser_message(char *string,
+					   carmen_robot_laser_message *laser)
+{
+  return string_to_robot_laser_message(string, laser, NULL);
+}
+
+/* reads the line of a message, or for a columnar log its text and
+   where to find its ranges */
+static logfile_ranges_p logfile_read_laser_line(carmen_logfile_index_p index,
+						carmen_FILE *infile,
+						int message_num,
+						int max_line_length,
+						char *line,
+						logfile_ranges_p ranges)
+{
+  int in_column;
+
+  if(index->columnar == NULL) {
+    carmen_logfile_read_line(index, infile, message_num, max_line_length,
+			     line);
+    return NULL;
+  }
+
+  carmen_collog_read_text(index->columnar, message_num, max_line_length, 
+			  line, &in_column);
+  index->current_position = message_num + 1;
+  if(!in_column)
+    return NULL;
+  ranges->columnar = index->columnar;
+  ranges->message_num = message_num;
+  return ranges;
+}
+
+int carmen_logfile_read_laser_laser_message(carmen_logfile_index_p index,
+					    carmen_FILE *infile,
+					    int message_num,
+					    int max_line_length, char *line,
+					    carmen_laser_laser_message *laser)
+{
+  logfile_ranges_t ranges;
+  logfile_ranges_p source;
+
+  source = logfile_read_laser_line(index, infile, message_num, 
+				   max_line_length, line, &ranges);
+  if(strncmp(line, "RAWLASER", 8) == 0)
+    string_to_laser_laser_message(line, laser, source);
+  else if(strncmp(line, "LASER3 ", 7) == 0 || 
+	  strncmp(line, "LASER4 ", 7) == 0)
+    string_to_laser_laser_message_orig(line, laser, source);
+  else
+    return -1;
+  return 0;
+}
+
+int carmen_logfile_read_robot_laser_message(carmen_logfile_index_p index,
+					    carmen_FILE *infile,
+					    int message_num,
+					    int max_line_length, char *line,
+					    carmen_robot_laser_message *laser)
+{
+  logfile_ranges_t ranges;
+  logfile_ranges_p source;
+
+  source = logfile_read_laser_line(index, infile, message_num, 
+				   max_line_length, line, &ranges);
+  if(strncmp(line, "ROBOTLASER", 10) == 0)
+    string_to_robot_laser_message(line, laser, source);
+  else if(strncmp(line, "FLASER ", 7) == 0 || 
+	  strncmp(line, "RLASER ", 7) == 0)
+    string_to_robot_laser_message_orig(line, laser, source);
+  else
+    return -1;
+  return 0;
+}
 
 char *carmen_string_to_gps_gpgga_message(char *string,
 				       carmen_gps_gpgga_message *gps_msg)
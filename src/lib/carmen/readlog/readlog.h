@@ -45,6 +45,7 @@
 #define CARMEN_READLOG_H
 
 #include "carmen_stdio.h"
+#include "collog.h"
 
 #include "arm_messages.h"
 #include "base_messages.h"
@@ -65,19 +66,50 @@
 extern "C" {
 #endif
 
+/** Extension of the file an index is kept in, next to its log. **/
+#define CARMEN_LOGFILE_INDEX_EXTENSION ".cidx"
+
 /** Index structure used to process a logfile. **/
 typedef struct {
   int num_messages;     /**< Number of message in the file. **/
   int current_position; /**< Iterator to move through the file. **/
   off_t *offset;     /**< Array of indices to the messages. **/
+  double *timestamp; /**< Logger timestamp of each message. Lines
+			without, such as comments, inherit the timestamp
+			of the preceding message. **/
+  double start_time; /**< IPC time at logger timestamp 0, or 0 if the
+			log has no timestamped message. **/
+  carmen_collog_reader_p columnar; /**< Reader for columnar logs. **/
 } carmen_logfile_index_t, *carmen_logfile_index_p;
 
 /** Builds the index structure used for parsing a carmen log file. 
+ * Columnar logs (see collog.h) are recognized and read transparently.
  * @param infile  A pointer to a CARMEN_FILE.
  * @returns A pointer to the newly created index structure.
  **/
 carmen_logfile_index_p carmen_logfile_index_messages(carmen_FILE *infile);
 
+/** Like carmen_logfile_index_messages, but keeps the index of text logs
+ * in filename + CARMEN_LOGFILE_INDEX_EXTENSION and reuses it as long as
+ * the log keeps its size and modification time.
+ * @param infile  A pointer to a CARMEN_FILE.
+ * @param filename The name infile was opened with.
+ * @returns A pointer to the newly created index structure.
+ **/
+carmen_logfile_index_p carmen_logfile_index_messages_cached(carmen_FILE *infile,
+							     const char *filename);
+
+/** Logger timestamp of a message. **/
+double carmen_logfile_message_timestamp(carmen_logfile_index_p index,
+					int message_num);
+
+/** Finds the first message with a logger timestamp not less than
+ * timestamp by binary search, assuming that logger timestamps do not
+ * decrease.
+ **/
+int carmen_logfile_find_timestamp(carmen_logfile_index_p index, 
+				  double timestamp);
+
 /** Frees an index structure **/
 void carmen_logfile_free_index(carmen_logfile_index_p* pindex);
 
@@ -87,6 +119,42 @@ int carmen_logfile_eof(carmen_logfile_index_p index);
 /** Percentage of the how much data has been read **/
 float carmen_logfile_percent_read(carmen_logfile_index_p index);
 
+/** Several logs, such as logs recorded on different machines, merged
+ * into one timeline. A log is placed on the timeline by the IPC time
+ * of its logger start, so the times of all logs are comparable. The
+ * time of a message on the timeline is counted from the earliest
+ * logger start. Messages are taken in time order from a heap holding
+ * the next message of each log.
+ **/
+typedef struct {
+  int num_logs;
+  carmen_logfile_index_p *index;
+  double *offset;    /**< Timeline time at logger timestamp 0 of each log. **/
+  int *next;         /**< Next message of each log. **/
+  int *heap;         /**< Logs with messages left, earliest next first. **/
+  int heap_size;
+} carmen_logfile_merge_t, *carmen_logfile_merge_p;
+
+/** Merges the logs of index, which must outlive the merge. Starts at
+ * the beginning of the timeline. **/
+carmen_logfile_merge_p carmen_logfile_merge_new(int num_logs, 
+						carmen_logfile_index_p *index);
+
+void carmen_logfile_merge_free(carmen_logfile_merge_p merge);
+
+/** Time of a message of one of the logs on the timeline. **/
+double carmen_logfile_merge_time(carmen_logfile_merge_p merge, int log, 
+				 int message_num);
+
+/** Continues with the first messages at or after time. **/
+void carmen_logfile_merge_seek(carmen_logfile_merge_p merge, double time);
+
+/** Takes the next message of the timeline.
+ * @returns 0 once all messages were taken, 1 otherwise.
+ **/
+int carmen_logfile_merge_next(carmen_logfile_merge_p merge, int *log,
+			      int *message_num, double *time);
+
 /** Reads a line from the log file using the index structre .
  * @param index A pointer to the index structure correspondinf to infile.
  * @param infile A Carmen file pointer to the log file.
@@ -108,6 +176,30 @@ int carmen_logfile_read_line(carmen_logfile_index_p index, carmen_FILE *infile,
 int carmen_logfile_read_next_line(carmen_logfile_index_p index, carmen_FILE *infile,
 				  int max_line_length, char *line);
 
+/** Reads a RAWLASER, LASER3 or LASER4 message into laser, like
+ * carmen_logfile_read_line followed by the matching string conversion.
+ * The range readings of a columnar log are decoded from their column
+ * straight into laser->range instead of being formatted as text and
+ * parsed again.
+ * @param line Buffer of max_line_length bytes for the message text.
+ * @returns 0, or -1 if the message is none of these.
+ **/
+int carmen_logfile_read_laser_laser_message(carmen_logfile_index_p index,
+					    carmen_FILE *infile,
+					    int message_num,
+					    int max_line_length, char *line,
+					    carmen_laser_laser_message *laser);
+
+/** Reads a ROBOTLASER, FLASER or RLASER message into laser, like
+ * carmen_logfile_read_laser_laser_message.
+ * @returns 0, or -1 if the message is none of these.
+ **/
+int carmen_logfile_read_robot_laser_message(carmen_logfile_index_p index,
+					    carmen_FILE *infile,
+					    int message_num,
+					    int max_line_length, char *line,
+					    carmen_robot_laser_message *laser);
+
 /** Converts the string to an odometry message.
  * @param string A string describing the message in the carmen logfile format.
  * @param odometry A pointer to the (allocated) structure where the message should be written to.
@@ -44,9 +44,6 @@ static int bumper_count = 0;
 static int bumper_ready = 0;
 static int num_bumpers;
 
-double carmen_robot_interpolate_heading(double head1, double head2, 
-					double fraction);
-
 static void check_message_data_chunk_sizes(void)
 {
   int first = 1;
@@ -61,26 +58,15 @@ static void check_message_data_chunk_sizes(void)
       
 
 static void construct_bumper_message(carmen_robot_bumper_message *msg, 
-				     int low, int high, double fraction)
+				     carmen_robot_pose_stamp_p odometry)
 {
   int i;
 
-  msg->robot_pose.x=carmen_robot_odometry[low].x + fraction *
-    (carmen_robot_odometry[high].x - carmen_robot_odometry[low].x);
-  msg->robot_pose.y= carmen_robot_odometry[low].y + fraction *
-    (carmen_robot_odometry[high].y - carmen_robot_odometry[low].y);
-  msg->robot_pose.theta=carmen_robot_interpolate_heading
-    (carmen_robot_odometry[high].theta, 
-     carmen_robot_odometry[low].theta, fraction);
-  msg->robot_pose.theta=carmen_normalize_theta(msg->robot_pose.theta);
-
-
-  msg->tv = carmen_robot_odometry[low].tv + 
-    fraction*(carmen_robot_odometry[high].tv - 
-	      carmen_robot_odometry[low].tv);
-  msg->rv = carmen_robot_odometry[low].rv + 
-    fraction*(carmen_robot_odometry[high].rv - 
-	      carmen_robot_odometry[low].rv);
+  msg->robot_pose.x = odometry->x;
+  msg->robot_pose.y = odometry->y;
+  msg->robot_pose.theta = odometry->theta;
+  msg->tv = odometry->tv;
+  msg->rv = odometry->rv;
 
   robot_bumper.timestamp = base_bumper.timestamp;
   robot_bumper.host = base_bumper.host;
@@ -93,8 +79,7 @@ static void construct_bumper_message(carmen_robot_bumper_message *msg,
 void carmen_robot_correct_bumper_and_publish(void) 
 {  
   double bumper_skew;
-  double fraction;
-  int low, high;
+  carmen_robot_pose_stamp_t odometry;
   
   if(!bumper_ready)
     return;
@@ -109,13 +94,13 @@ void carmen_robot_correct_bumper_and_publish(void)
     return;
   }
 
-  fraction = carmen_robot_get_fraction(base_bumper.timestamp, bumper_skew,
-				       &low, &high);
-
-  if (!carmen_robot_config.interpolate_odometry)
-    fraction=0;
+  if (carmen_robot_config.interpolate_odometry)
+    carmen_robot_get_odometry(base_bumper.timestamp, bumper_skew, &odometry);
+  else
+    carmen_robot_get_previous_odometry(base_bumper.timestamp, bumper_skew,
+				       &odometry);
 
-  construct_bumper_message(&robot_bumper, low, high, fraction);
+  construct_bumper_message(&robot_bumper, &odometry);
     
   IPC_RETURN_TYPE err;
   err = IPC_publishData(CARMEN_ROBOT_BUMPER_NAME, &robot_bumper);
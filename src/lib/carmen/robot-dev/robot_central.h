@@ -41,13 +41,15 @@
 #define CARMEN_ROBOT_H
 
 #include "base_messages.h"
+#include "robot_pose_buffer.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-  // MAX_READINGS controls the number of odometry measurements we 
-  // remember for interpolating position stamps.
+  // MAX_READINGS is the default number of odometry measurements we 
+  // remember for interpolating position stamps (see the parameter
+  // robot_odometry_history_length).
 
   // Clock skew estimate is guaranteed only if sufficient odometry
   // is available, so ESTIMATES_CONVERGE is the amount of odometry
@@ -62,18 +64,19 @@ extern "C" {
 #define      CARMEN_ROBOT_MIN_ALLOWED_VELOCITY 0.03 // cm/s
 
 extern carmen_base_odometry_message carmen_robot_latest_odometry;
-extern carmen_base_odometry_message carmen_robot_odometry[CARMEN_ROBOT_MAX_READINGS];
 extern int carmen_robot_position_received;
 extern int carmen_robot_converge;
 extern carmen_robot_config_t carmen_robot_config;
 extern char *carmen_robot_host;
 
-extern double carmen_robot_collision_avoidance_frequency;
 extern double carmen_robot_sensor_time_of_last_update;
   
 
-double carmen_robot_get_fraction(double timestamp, double skew,
-				 int *low, int *high);
+void carmen_robot_get_odometry(double timestamp, double skew,
+			       carmen_robot_pose_stamp_p odometry);
+// the older of the odometry readings bracketing timestamp, as it is
+void carmen_robot_get_previous_odometry(double timestamp, double skew,
+					carmen_robot_pose_stamp_p odometry);
 int carmen_robot_get_skew(int msg_count, double *skew,
 			  carmen_running_average_t *average, char *hostname);
 void carmen_robot_update_skew(carmen_running_average_t *average, int *count, 
@@ -0,0 +1,184 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include "global.h"
+#include "geometry.h"
+
+#include "robot_collision.h"
+
+/* Extra margin on the stopping envelope, so that rounding can never
+   discard a beam that carmen_geometry_compute_velocity() would limit. */
+#define CARMEN_ROBOT_COLLISION_ENVELOPE_SLACK 0.01
+
+void
+carmen_robot_collision_update_beams(carmen_robot_beam_table_p table,
+				    int num_beams, double start_angle,
+				    double angular_resolution)
+{
+  int i;
+
+  if (table->num_beams == num_beams && table->start_angle == start_angle &&
+      table->angular_resolution == angular_resolution)
+    return;
+
+  if (table->num_beams != num_beams) {
+    carmen_robot_collision_free_beams(table);
+    if (num_beams > 0) {
+      table->cos_theta = (double *)calloc(num_beams, sizeof(double));
+      carmen_test_alloc(table->cos_theta);
+      table->sin_theta = (double *)calloc(num_beams, sizeof(double));
+      carmen_test_alloc(table->sin_theta);
+      table->x = (double *)calloc(num_beams, sizeof(double));
+      carmen_test_alloc(table->x);
+      table->y = (double *)calloc(num_beams, sizeof(double));
+      carmen_test_alloc(table->y);
+      table->candidates = (int *)calloc(num_beams, sizeof(int));
+      carmen_test_alloc(table->candidates);
+    }
+  }
+
+  table->num_beams = num_beams > 0 ? num_beams : 0;
+  table->start_angle = start_angle;
+  table->angular_resolution = angular_resolution;
+
+  for (i = 0; i < table->num_beams; i++) {
+    table->cos_theta[i] = cos(start_angle + i * angular_resolution);
+    table->sin_theta[i] = sin(start_angle + i * angular_resolution);
+  }
+}
+
+void
+carmen_robot_collision_free_beams(carmen_robot_beam_table_p table)
+{
+  free(table->cos_theta);
+  free(table->sin_theta);
+  free(table->x);
+  free(table->y);
+  free(table->candidates);
+
+  memset(table, 0, sizeof(carmen_robot_beam_table_t));
+}
+
+/* Radius around the robot beyond which no obstacle can limit the velocity.
+
+   Such an obstacle is either behind the robot, where it is ignored as long
+   as the safety distance is positive, or its path distance from the robot
+   or the side safety points exceeds the safety distance by more than
+   max_t_vel^2 / acceleration, which is the distance needed to brake from
+   max_t_vel in the worst case of compute_velocity(). A point that ends up
+   within that radius r in the rotating reference frame of turning radius R
+   was no further than min(r + 2R, r sqrt(2 + r/R)) from the robot. Returns
+   a negative value if no such radius exists. */
+
+static double
+stopping_envelope(carmen_robot_config_t *robot_config, double safety_distance,
+		  double side_distance, double tv, double rv)
+{
+  double envelope, turning_radius;
+
+  if (safety_distance <= 0 || robot_config->acceleration <= 0)
+    return -1;
+
+  envelope = safety_distance + side_distance +
+    robot_config->max_t_vel * robot_config->max_t_vel /
+    robot_config->acceleration + CARMEN_ROBOT_COLLISION_ENVELOPE_SLACK;
+
+  if (fabs(tv) > 0.01 && fabs(rv) > 0.001) {
+    turning_radius = fabs(tv / rv);
+    envelope = carmen_fmin(envelope + 2 * turning_radius,
+			   envelope * sqrt(2 + envelope / turning_radius));
+  }
+
+  return envelope;
+}
+
+double
+carmen_robot_collision_max_velocity(carmen_robot_beam_table_p table,
+				    float *range, double x_offset,
+				    double y_offset, double tv, double rv,
+				    carmen_robot_config_t *robot_config,
+				    char *tooclose)
+{
+  carmen_traj_point_t robot_posn, obstacle_pt;
+  double max_velocity, velocity;
+  double safety_distance, side_distance, envelope, envelope_sq;
+  double *cos_theta = table->cos_theta, *sin_theta = table->sin_theta;
+  double *x = table->x, *y = table->y;
+  int *candidates = table->candidates;
+  int num_beams = table->num_beams, num_candidates;
+  int i, j;
+
+  robot_posn.x = 0;
+  robot_posn.y = 0;
+  robot_posn.theta = 0;
+  robot_posn.t_vel = tv;
+  robot_posn.r_vel = rv;
+
+  max_velocity = robot_config->max_t_vel;
+
+  safety_distance =
+    carmen_geometry_compute_safety_distance(robot_config, &robot_posn);
+  side_distance = 0.5 * robot_config->width + robot_config->side_dist;
+  envelope = stopping_envelope(robot_config, safety_distance,
+			       side_distance, tv, rv);
+  envelope_sq = (envelope < 0) ? HUGE_VAL : envelope * envelope;
+
+  /* Obstacle points of all beams in the robot frame. These loops have no
+     branches, so the compiler can vectorize them. */
+
+  for (i = 0; i < num_beams; i++) {
+    x[i] = x_offset + range[i] * cos_theta[i];
+    y[i] = y_offset + range[i] * sin_theta[i];
+  }
+
+  num_candidates = 0;
+  for (i = 0; i < num_beams; i++) {
+    candidates[num_candidates] = i;
+    num_candidates += (x[i] * x[i] + y[i] * y[i] < envelope_sq);
+  }
+  table->num_candidates = num_candidates;
+
+  for (j = 0; j < num_candidates; j++) {
+    i = candidates[j];
+
+    obstacle_pt.x = x[i];
+    obstacle_pt.y = y[i];
+    carmen_geometry_move_pt_to_rotating_ref_frame(&obstacle_pt, tv, rv);
+    velocity = carmen_geometry_compute_velocity(robot_posn, obstacle_pt,
+						robot_config);
+
+    if (velocity < robot_config->max_t_vel) {
+      if (velocity < max_velocity)
+	max_velocity = velocity;
+      if (tooclose)
+	tooclose[i] = 1;
+    }
+  }
+
+  return max_velocity;
+}
@@ -0,0 +1,92 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/** @addtogroup robot librobot **/
+// @{
+
+/** \file robot_collision.h
+ * \brief Batched velocity limits for collision avoidance.
+ *
+ * Computes the highest translational velocity that keeps the robot clear
+ * of all beams of a laser scan. The beam directions are tabulated once per
+ * laser configuration. Each scan then goes through a single branch-free
+ * pass over the whole beam array which discards every reading that lies
+ * outside the robot's stopping envelope. Only the remaining beams are
+ * evaluated with carmen_geometry_compute_velocity(), so the result is the
+ * same as checking every beam individually.
+ **/
+
+#ifndef ROBOT_COLLISION_H
+#define ROBOT_COLLISION_H
+
+#include "global.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  int num_beams;
+  double start_angle;
+  double angular_resolution;
+  double *cos_theta;
+  double *sin_theta;
+  double *x;
+  double *y;
+  int *candidates;
+  int num_candidates;
+} carmen_robot_beam_table_t, *carmen_robot_beam_table_p;
+
+/** Prepares the direction tables for num_beams beams starting at
+    start_angle (including the mounting angle of the laser) and spaced by
+    angular_resolution. The tables are only recomputed if the
+    configuration has changed since the last call. **/
+void carmen_robot_collision_update_beams(carmen_robot_beam_table_p table,
+					 int num_beams, double start_angle,
+					 double angular_resolution);
+
+void carmen_robot_collision_free_beams(carmen_robot_beam_table_p table);
+
+/** Returns the maximum allowed translational velocity for the scan in
+    range, seen from a laser mounted at (x_offset, y_offset) in the robot
+    frame, while the robot moves with (tv, rv). The result is at most
+    robot_config->max_t_vel. If tooclose is not NULL, the entries of the
+    beams that limit the velocity are set to 1; the others are left
+    untouched. **/
+double carmen_robot_collision_max_velocity(carmen_robot_beam_table_p table,
+					   float *range, double x_offset,
+					   double y_offset, double tv, double rv,
+					   carmen_robot_config_t *robot_config,
+					   char *tooclose);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+// @}
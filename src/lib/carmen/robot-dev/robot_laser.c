@@ -32,6 +32,7 @@
 #include "robot_central.h"
 #include "robot_main.h"
 #include "robot_laser.h"
+#include "robot_collision.h"
 
 #include "robot_messages.h"
 
@@ -53,27 +54,21 @@ static int rearlaser_use = 1;
 static carmen_running_average_t frontlaser_average;
 static carmen_running_average_t rearlaser_average;
 
-static double carmen_robot_laser_bearing_skip_rate = 0.33;
-
 static carmen_laser_laser_message front_laser, rear_laser;
 static int front_laser_count = 0, rear_laser_count = 0;
 static int front_laser_ready = 0, rear_laser_ready = 0;
 static carmen_robot_laser_message robot_front_laser, robot_rear_laser;
+static carmen_robot_beam_table_t front_beams, rear_beams;
 
 static double max_front_velocity = 0;
 static double min_rear_velocity = -0;
 
-double carmen_robot_interpolate_heading(double head1, double head2, double fraction);
-
 static void
 publish_frontlaser_message(carmen_robot_laser_message laser_msg)
 {
   IPC_RETURN_TYPE err;
   err = IPC_publishData(CARMEN_ROBOT_FRONTLASER_NAME, &laser_msg);
   carmen_test_ipc(err, "Could not publish", CARMEN_ROBOT_FRONTLASER_NAME);
-  if(robot_front_laser.host!=NULL){
-    free(robot_front_laser.host);
-  }
 }
 
 static void
@@ -89,10 +84,8 @@ publish_rearlaser_message(carmen_robot_laser_message laser_msg)
 static int
 construct_laser_message(carmen_robot_laser_message *msg, int rear, double timestamp)
 {
-  int low;
-  int high;
   double skew;
-  double fraction;
+  carmen_robot_pose_stamp_t odometry;
   int laser_ready;
 
   if (!rear) {
@@ -112,31 +105,13 @@ construct_laser_message(carmen_robot_laser_message *msg, int rear, double timest
     }
   }
 
-  fraction = carmen_robot_get_fraction(timestamp, skew, &low, &high);
-
-  if (!carmen_robot_config.interpolate_odometry) {
-    // take the latest odometry measurement
-    fraction=0;
-    high = CARMEN_ROBOT_MAX_READINGS-1;
-    low = CARMEN_ROBOT_MAX_READINGS-1;
-  }
-
+  carmen_robot_get_odometry(timestamp, skew, &odometry);
 
-  msg->robot_pose.x=carmen_robot_odometry[low].x + fraction *
-    (carmen_robot_odometry[high].x - carmen_robot_odometry[low].x);
-  msg->robot_pose.y= carmen_robot_odometry[low].y + fraction *
-    (carmen_robot_odometry[high].y - carmen_robot_odometry[low].y);
-  msg->robot_pose.theta=carmen_robot_interpolate_heading
-    (carmen_robot_odometry[low].theta,
-     carmen_robot_odometry[high].theta, fraction);
-  msg->robot_pose.theta=carmen_normalize_theta(msg->robot_pose.theta);
-
-  msg->tv = carmen_robot_odometry[low].tv +
-    fraction*(carmen_robot_odometry[high].tv -
-	      carmen_robot_odometry[low].tv);
-  msg->rv = carmen_robot_odometry[low].rv +
-    fraction*(carmen_robot_odometry[high].rv -
-	      carmen_robot_odometry[low].rv);
+  msg->robot_pose.x = odometry.x;
+  msg->robot_pose.y = odometry.y;
+  msg->robot_pose.theta = odometry.theta;
+  msg->tv = odometry.tv;
+  msg->rv = odometry.rv;
 
   if (! rear){
     double s=sin(msg->robot_pose.theta), c=cos(msg->robot_pose.theta);
@@ -259,27 +234,24 @@ check_message_data_chunk_sizes(carmen_laser_laser_message *laser_ptr)
   }
 }
 
+/* Keeps a copy of the laser's host name, which only has to be replaced
+   if the laser server moves to another host. */
 static void
-laser_frontlaser_handler(void)
+update_host(char **host, char *laser_host)
 {
-  int i;
-  double safety_distance;
-  double theta, delta_theta;
-  carmen_traj_point_t robot_posn, obstacle_pt;
-  double max_velocity, velocity;
-
-  int tooclose = -1;
-  double tooclose_theta = 0;
-
-  int min_index;
-  //  double min_theta = 0;
-  double min_dist;
-
-
-  static double time_since_last_process = 0;
-  double skip_sum = 0;
+  if (*host != NULL && laser_host != NULL && !strcmp(*host, laser_host))
+    return;
 
+  free(*host);
+  *host = (laser_host != NULL) ? carmen_new_string(laser_host) : NULL;
+}
 
+static void
+laser_frontlaser_handler(void)
+{
+  double safety_distance;
+  carmen_traj_point_t robot_posn;
+  double max_velocity;
 
   /* We just got a new laser message. It may be that the new message contains
      a different number of laser readings than we were expecting, maybe
@@ -303,19 +275,12 @@ laser_frontlaser_handler(void)
 
   carmen_robot_sensor_time_of_last_update = carmen_get_time();
 
-  if (carmen_robot_sensor_time_of_last_update - time_since_last_process <
-      1.0/carmen_robot_collision_avoidance_frequency)
-    return;
-
-
   robot_posn.x = 0;
   robot_posn.y = 0;
   robot_posn.theta = 0;
   robot_posn.t_vel = carmen_robot_latest_odometry.tv;
   robot_posn.r_vel = carmen_robot_latest_odometry.rv;
 
-  time_since_last_process = carmen_robot_sensor_time_of_last_update;
-
   safety_distance = carmen_geometry_compute_safety_distance(&carmen_robot_config, &robot_posn);
 
   robot_front_laser.forward_safety_dist = safety_distance;
@@ -324,51 +289,19 @@ laser_frontlaser_handler(void)
   robot_front_laser.turn_axis = 1e6;
   robot_front_laser.timestamp = front_laser.timestamp;
 
-
-  robot_front_laser.host = carmen_new_string(front_laser.host);
-
-  max_velocity = carmen_robot_config.max_t_vel;
+  update_host(&robot_front_laser.host, front_laser.host);
 
   carmen_carp_set_verbose(0);
 
-  theta = front_laser.config.start_angle + frontlaser_angular_offset;
-  delta_theta = front_laser.config.angular_resolution;
-
-  skip_sum = 0.0;
-  for(i = 0; i < robot_front_laser.num_readings; i++, theta += delta_theta) {
-    skip_sum += carmen_robot_laser_bearing_skip_rate;
-    if (skip_sum > 0.95) {
-      skip_sum = 0.0;
-      robot_front_laser.tooclose[i] = -1;
-      continue;
-    }
-
-    obstacle_pt.x = frontlaser_offset     +  robot_front_laser.range[i] * cos(theta);
-    obstacle_pt.y = frontlaser_side_offset + robot_front_laser.range[i] * sin(theta);
-    carmen_geometry_move_pt_to_rotating_ref_frame
-      (&obstacle_pt, carmen_robot_latest_odometry.tv,
-       carmen_robot_latest_odometry.rv);
-    velocity = carmen_geometry_compute_velocity
-      (robot_posn, obstacle_pt, &carmen_robot_config);
-
-    if (velocity < carmen_robot_config.max_t_vel) {
-      if (velocity < max_velocity) {
-	tooclose = i;
-	tooclose_theta = theta;
-	max_velocity = velocity;
-      }
-      robot_front_laser.tooclose[i] = 1;
-    }
-  } /* End of for(i = 0; i < robot_front_laser.num_readings; i++) */
-
-  min_index = 0;
-  min_dist = robot_front_laser.range[0];
-  for(i = 1; i < robot_front_laser.num_readings; i++) {
-    if (robot_front_laser.range[i] < min_dist) {
-      min_dist = robot_front_laser.range[i];
-      min_index = i;
-    }
-  }
+  carmen_robot_collision_update_beams
+    (&front_beams, robot_front_laser.num_readings,
+     front_laser.config.start_angle + frontlaser_angular_offset,
+     front_laser.config.angular_resolution);
+  max_velocity = carmen_robot_collision_max_velocity
+    (&front_beams, robot_front_laser.range, frontlaser_offset,
+     frontlaser_side_offset, carmen_robot_latest_odometry.tv,
+     carmen_robot_latest_odometry.rv, &carmen_robot_config,
+     robot_front_laser.tooclose);
 
   front_laser_ready = 1;
 
@@ -398,17 +331,9 @@ carmen_robot_laser_min_rear_velocity(void)
 static void
 laser_rearlaser_handler(void)
 {
-  int i;
   double safety_distance;
-  double theta, delta_theta;
-  carmen_traj_point_t robot_posn, obstacle_pt;
-  double min_velocity, velocity;
-
-  int tooclose = -1;
-  double tooclose_theta = 0;
-
-  static double time_since_last_process = 0;
-  double skip_sum = 0;
+  carmen_traj_point_t robot_posn;
+  double min_velocity;
 
   /* We just got a new laser message. It may be that the new message contains
      a different number of laser readings than we were expecting, maybe
@@ -432,18 +357,12 @@ laser_rearlaser_handler(void)
 
   carmen_robot_sensor_time_of_last_update = carmen_get_time();
 
-  if (carmen_robot_sensor_time_of_last_update - time_since_last_process <
-      1.0/carmen_robot_collision_avoidance_frequency)
-    return;
-
   robot_posn.x = 0;
   robot_posn.y = 0;
   robot_posn.theta = 0;
   robot_posn.t_vel = carmen_robot_latest_odometry.tv;
   robot_posn.r_vel = carmen_robot_latest_odometry.rv;
 
-  time_since_last_process = carmen_robot_sensor_time_of_last_update;
-
   safety_distance = carmen_geometry_compute_safety_distance(&carmen_robot_config, &robot_posn);
 
   robot_rear_laser.forward_safety_dist = safety_distance;
@@ -451,43 +370,18 @@ laser_rearlaser_handler(void)
     carmen_robot_config.width / 2.0 + carmen_robot_config.side_dist;
   robot_rear_laser.turn_axis = 1e6;
   robot_rear_laser.timestamp = rear_laser.timestamp;
-  robot_rear_laser.host = carmen_new_string(rear_laser.host);
 
-  min_velocity = -carmen_robot_config.max_t_vel;
+  update_host(&robot_rear_laser.host, rear_laser.host);
 
-/*   theta = -M_PI/2;  */
-/*   delta_theta = M_PI/(robot_rear_laser.num_readings-1); */
-
-  theta = rearlaser_angular_offset + rear_laser.config.start_angle;
-  delta_theta = rear_laser.config.angular_resolution;
-
-  skip_sum = 0.0;
-  for(i = 0; i < robot_rear_laser.num_readings; i++, theta += delta_theta) {
-    skip_sum += carmen_robot_laser_bearing_skip_rate;
-    if (skip_sum > 0.95) {
-      skip_sum = 0.0;
-      robot_rear_laser.tooclose[i] = -1;
-      continue;
-    }
-
-    obstacle_pt.x = rearlaser_offset + robot_rear_laser.range[i] * cos(theta);
-    obstacle_pt.y = rearlaser_side_offset + robot_rear_laser.range[i] * sin(theta);
-    carmen_geometry_move_pt_to_rotating_ref_frame
-      (&obstacle_pt, carmen_robot_latest_odometry.tv,
-       carmen_robot_latest_odometry.rv);
-    velocity = carmen_geometry_compute_velocity
-      (robot_posn, obstacle_pt, &carmen_robot_config);
-    velocity = -velocity;
-
-    if (velocity > -carmen_robot_config.max_t_vel) {
-      if (velocity > min_velocity) {
-	tooclose = i;
-	tooclose_theta = theta;
-	min_velocity = velocity;
-      }
-      robot_rear_laser.tooclose[i] = 1;
-    }
-  } /* End of for(i = 0; i < robot_rear_laser.num_readings; i++) */
+  carmen_robot_collision_update_beams
+    (&rear_beams, robot_rear_laser.num_readings,
+     rear_laser.config.start_angle + rearlaser_angular_offset,
+     rear_laser.config.angular_resolution);
+  min_velocity = -carmen_robot_collision_max_velocity
+    (&rear_beams, robot_rear_laser.range, rearlaser_offset,
+     rearlaser_side_offset, carmen_robot_latest_odometry.tv,
+     carmen_robot_latest_odometry.rv, &carmen_robot_config,
+     robot_rear_laser.tooclose);
 
   rear_laser_ready = 1;
 
@@ -553,7 +447,6 @@ carmen_robot_add_laser_parameters(int argc, char** argv)
     {"robot", "rearlaser_angular_offset",  CARMEN_PARAM_DOUBLE, &rearlaser_angular_offset, 1, NULL},
     {"robot", "rearlaser_use",           CARMEN_PARAM_ONOFF, &rearlaser_use, 0, NULL},
     {"robot", "rearlaser_id",            CARMEN_PARAM_INT, &rearlaser_id, 0, NULL},
-    //{"robot", "laser_bearing_skip_rate", CARMEN_PARAM_DOUBLE, &carmen_robot_laser_bearing_skip_rate, 1, NULL},
   };
   num_items = sizeof(param_list)/sizeof(param_list[0]);
   carmen_param_install_params(argc, argv, param_list, num_items);
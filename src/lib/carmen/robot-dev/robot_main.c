@@ -41,15 +41,14 @@
 
 carmen_robot_config_t carmen_robot_config;
 carmen_base_odometry_message carmen_robot_latest_odometry;
-carmen_base_odometry_message carmen_robot_odometry[CARMEN_ROBOT_MAX_READINGS];
-double carmen_robot_collision_avoidance_frequency = 10.0;
 double carmen_robot_sensor_time_of_last_update = -1;
 
 
 static char *robot_host;
 static double turn_before_driving_if_heading_bigger_than = M_PI/2;
 static int odometry_count = 0;
-static double odometry_local_timestamp[CARMEN_ROBOT_MAX_READINGS];
+static int odometry_history_length = CARMEN_ROBOT_MAX_READINGS;
+static carmen_robot_pose_buffer_p odometry_history = NULL;
 static carmen_running_average_t odometry_average;
 
 #ifndef COMPILE_WITHOUT_LASER_SUPPORT
@@ -124,66 +123,41 @@ void carmen_robot_update_skew(carmen_running_average_t *average, int *count,
   carmen_running_average_add(average, carmen_get_time() - time);
 }
 
-double carmen_robot_get_fraction(double timestamp, double skew,
-				 int *low, int *high)
+void carmen_robot_get_odometry(double timestamp, double skew,
+			       carmen_robot_pose_stamp_p odometry)
 {
-  double fraction;
-  double corrected_timestamp;
-  double low_timestamp, high_timestamp;
-  double odometry_skew;
-  int i;
-
-  corrected_timestamp = timestamp+skew;
-  odometry_skew = get_odometry_skew();
-
-  *low = 0;
-  *high = 1;
-  for(i = 0; i < CARMEN_ROBOT_MAX_READINGS; i++)
-    if (corrected_timestamp < carmen_robot_odometry[i].timestamp +
-	odometry_skew) {
-      if (i == 0) {
-	*low = 0;
-	*high = 1;
-      } else {
-	*low = i-1;
-	*high = i;
-      }
-      break;
-    }
-
-  if (i == CARMEN_ROBOT_MAX_READINGS) {
-    *low = i-2;
-    *high = i-1;
-  }
+  carmen_robot_pose_stamp_p latest;
 
-  low_timestamp = carmen_robot_odometry[*low].timestamp + odometry_skew;
-  high_timestamp = carmen_robot_odometry[*high].timestamp + odometry_skew;
-
-  fraction = (corrected_timestamp - low_timestamp)/
-    (high_timestamp - low_timestamp);
+  if (carmen_robot_config.interpolate_odometry &&
+      carmen_robot_pose_buffer_interpolate(odometry_history, timestamp +
+					   skew - get_odometry_skew(),
+					   odometry))
+    return;
 
-  return fraction;
+  // take the latest odometry measurement
+  latest = carmen_robot_pose_buffer_latest(odometry_history);
+  if (latest != NULL)
+    *odometry = *latest;
+  else
+    memset(odometry, 0, sizeof(carmen_robot_pose_stamp_t));
 }
 
-double carmen_robot_interpolate_heading(double head1, double head2,
-					double fraction)
+void carmen_robot_get_previous_odometry(double timestamp, double skew,
+					carmen_robot_pose_stamp_p odometry)
 {
-  double result;
-
-  if(head1 > 0 && head2 < 0 && head1 - head2 > M_PI) {
-    head2 += 2 * M_PI;
-    result = head1 + fraction * (head2 - head1);
-    if(result > M_PI)
-      result -= 2 * M_PI;
-    return result;
-  } else if(head1 < 0 && head2 > 0 && head2 - head1 > M_PI) {
-    head1 += 2 * M_PI;
-    result = head1 + fraction * (head2 - head1);
-    if(result > M_PI)
-      result -= 2 * M_PI;
-    return result;
-  } else
-    return head1 + fraction * (head2 - head1);
+  carmen_robot_pose_stamp_p previous = NULL;
+  double fraction;
+  int low, high;
+
+  if (carmen_robot_pose_buffer_find(odometry_history, timestamp + skew -
+				    get_odometry_skew(), &low, &high,
+				    &fraction))
+    previous = carmen_robot_pose_buffer_get(odometry_history, low);
+
+  if (previous != NULL)
+    *odometry = *previous;
+  else
+    memset(odometry, 0, sizeof(carmen_robot_pose_stamp_t));
 }
 
 void carmen_robot_send_base_velocity_command(void)
@@ -245,7 +219,7 @@ void carmen_robot_stop_robot(int how)
 
 static void base_odometry_handler(void)
 {
-  int i;
+  carmen_robot_pose_stamp_t odometry;
 
   if (strcmp(robot_host, carmen_robot_latest_odometry.host) == 0)
     odometry_count = CARMEN_ROBOT_ESTIMATES_CONVERGE;
@@ -254,16 +228,15 @@ static void base_odometry_handler(void)
 
   carmen_warn("o");
 
-  for(i = 0; i < CARMEN_ROBOT_MAX_READINGS - 1; i++) {
-    carmen_robot_odometry[i] = carmen_robot_odometry[i + 1];
-    odometry_local_timestamp[i] = odometry_local_timestamp[i + 1];
-  }
-  carmen_robot_odometry[CARMEN_ROBOT_MAX_READINGS - 1] =
-    carmen_robot_latest_odometry;
-  odometry_local_timestamp[CARMEN_ROBOT_MAX_READINGS - 1] = carmen_get_time();
+  odometry.x = carmen_robot_latest_odometry.x;
+  odometry.y = carmen_robot_latest_odometry.y;
+  odometry.theta = carmen_robot_latest_odometry.theta;
+  odometry.tv = carmen_robot_latest_odometry.tv;
+  odometry.rv = carmen_robot_latest_odometry.rv;
+  odometry.timestamp = carmen_robot_latest_odometry.timestamp;
+  carmen_robot_pose_buffer_add(odometry_history, &odometry);
 
-  carmen_running_average_add(&odometry_average,
-			     odometry_local_timestamp[CARMEN_ROBOT_MAX_READINGS - 1]-
+  carmen_running_average_add(&odometry_average, carmen_get_time() -
 			     carmen_robot_latest_odometry.timestamp);
 
   if (collision_avoidance)    {
@@ -706,8 +679,6 @@ static int read_robot_parameters(int argc, char **argv)
      &robot_sensor_timeout, 1, NULL},
     {"robot", "collision_avoidance", CARMEN_PARAM_ONOFF,
      &collision_avoidance, 1, NULL},
-    {"robot", "collision_avoidance_frequency", CARMEN_PARAM_DOUBLE,
-     &carmen_robot_collision_avoidance_frequency, 1, NULL},
     {"robot", "turn_before_driving_if_heading_bigger_than_deg",
      CARMEN_PARAM_DOUBLE,
      &turn_before_driving_if_heading_bigger_than_deg, 0, NULL},
@@ -718,9 +689,25 @@ static int read_robot_parameters(int argc, char **argv)
 
 
 
+  carmen_param_t optional_param_list[] = {
+    {"robot", "odometry_history_length", CARMEN_PARAM_INT,
+     &odometry_history_length, 0, NULL}
+  };
+  int allow_unfound;
+
   num_items = sizeof(param_list)/sizeof(param_list[0]);
   carmen_param_install_params(argc, argv, param_list, num_items);
 
+  allow_unfound = carmen_param_are_unfound_variables_allowed();
+  carmen_param_allow_unfound_variables(1);
+  carmen_param_install_params(argc, argv, optional_param_list,
+			      sizeof(optional_param_list)/
+			      sizeof(optional_param_list[0]));
+  carmen_param_allow_unfound_variables(allow_unfound);
+
+  if (odometry_history_length < 2)
+    odometry_history_length = 2;
+
   if (use_sonar)
     carmen_robot_add_sonar_parameters(argv[0]);
   if (use_bumper)
@@ -747,6 +734,8 @@ int carmen_robot_start(int argc, char **argv)
   if (read_robot_parameters(argc, argv) < 0)
     return -1;
 
+  odometry_history = carmen_robot_pose_buffer_new(odometry_history_length);
+
   if (initialize_robot_ipc() < 0) {
     carmen_warn("Error: could not connect to IPC Server\n");
     return -1;;
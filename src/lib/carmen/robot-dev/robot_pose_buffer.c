@@ -0,0 +1,271 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation;
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place,
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include "global.h"
+
+#include "robot_pose_buffer.h"
+
+carmen_robot_pose_buffer_p
+carmen_robot_pose_buffer_new(int size)
+{
+  carmen_robot_pose_buffer_p buffer;
+
+  if (size < 1)
+    size = 1;
+
+  buffer = (carmen_robot_pose_buffer_p)
+    calloc(1, sizeof(carmen_robot_pose_buffer_t));
+  carmen_test_alloc(buffer);
+  buffer->poses = (carmen_robot_pose_stamp_p)
+    calloc(size, sizeof(carmen_robot_pose_stamp_t));
+  carmen_test_alloc(buffer->poses);
+  buffer->size = size;
+
+  return buffer;
+}
+
+void
+carmen_robot_pose_buffer_free(carmen_robot_pose_buffer_p buffer)
+{
+  if (buffer == NULL)
+    return;
+
+  free(buffer->poses);
+  free(buffer);
+}
+
+void
+carmen_robot_pose_buffer_clear(carmen_robot_pose_buffer_p buffer)
+{
+  buffer->num_poses = 0;
+  buffer->first = 0;
+}
+
+static carmen_inline carmen_robot_pose_stamp_p
+pose_at(carmen_robot_pose_buffer_p buffer, int i)
+{
+  i += buffer->first;
+  if (i >= buffer->size)
+    i -= buffer->size;
+
+  return buffer->poses + i;
+}
+
+void
+carmen_robot_pose_buffer_add(carmen_robot_pose_buffer_p buffer,
+			     carmen_robot_pose_stamp_p pose)
+{
+  int i;
+
+  if (buffer->num_poses == buffer->size) {
+    if (pose->timestamp < pose_at(buffer, 0)->timestamp)
+      return;
+    buffer->first = (buffer->first + 1) % buffer->size;
+    buffer->num_poses--;
+  }
+
+  /* Odometry arrives in order, so this loop hardly ever runs */
+  i = buffer->num_poses;
+  while (i > 0 && pose->timestamp < pose_at(buffer, i - 1)->timestamp) {
+    *pose_at(buffer, i) = *pose_at(buffer, i - 1);
+    i--;
+  }
+
+  *pose_at(buffer, i) = *pose;
+  buffer->num_poses++;
+}
+
+carmen_robot_pose_stamp_p
+carmen_robot_pose_buffer_get(carmen_robot_pose_buffer_p buffer, int i)
+{
+  if (i < 0 || i >= buffer->num_poses)
+    return NULL;
+
+  return pose_at(buffer, i);
+}
+
+carmen_robot_pose_stamp_p
+carmen_robot_pose_buffer_latest(carmen_robot_pose_buffer_p buffer)
+{
+  return carmen_robot_pose_buffer_get(buffer, buffer->num_poses - 1);
+}
+
+static double
+bracket_fraction(carmen_robot_pose_buffer_p buffer, double timestamp,
+		 int low, int high)
+{
+  double low_timestamp = pose_at(buffer, low)->timestamp;
+  double high_timestamp = pose_at(buffer, high)->timestamp;
+
+  if (high_timestamp == low_timestamp)
+    return 0;
+
+  return (timestamp - low_timestamp) / (high_timestamp - low_timestamp);
+}
+
+int
+carmen_robot_pose_buffer_find(carmen_robot_pose_buffer_p buffer,
+			      double timestamp, int *low, int *high,
+			      double *fraction)
+{
+  int lower, upper, middle;
+
+  if (buffer->num_poses == 0)
+    return 0;
+
+  if (buffer->num_poses == 1) {
+    *low = *high = 0;
+    *fraction = 0;
+    return 1;
+  }
+
+  /* First pose that is newer than timestamp */
+  lower = 0;
+  upper = buffer->num_poses;
+  while (lower < upper) {
+    middle = (lower + upper) / 2;
+    if (timestamp < pose_at(buffer, middle)->timestamp)
+      upper = middle;
+    else
+      lower = middle + 1;
+  }
+
+  *high = carmen_clamp(1, upper, buffer->num_poses - 1);
+  *low = *high - 1;
+  *fraction = bracket_fraction(buffer, timestamp, *low, *high);
+
+  return 1;
+}
+
+void
+carmen_robot_interpolate_pose(carmen_robot_pose_stamp_p pose1,
+			      carmen_robot_pose_stamp_p pose2,
+			      double fraction,
+			      carmen_robot_pose_stamp_p pose)
+{
+  double c = cos(pose1->theta), s = sin(pose1->theta);
+  double dx, dy, dtheta, vx, vy, a, b, phi;
+  carmen_robot_pose_stamp_t result;
+
+  /* Motion from pose1 to pose2 in the frame of pose1 */
+  dx = c * (pose2->x - pose1->x) + s * (pose2->y - pose1->y);
+  dy = -s * (pose2->x - pose1->x) + c * (pose2->y - pose1->y);
+  dtheta = carmen_normalize_theta(pose2->theta - pose1->theta);
+
+  /* Velocities (vx, vy, dtheta) that produce this motion in unit time,
+     then integrate them over the fraction of that time. */
+  if (fabs(dtheta) < 1e-9) {
+    vx = dx;
+    vy = dy;
+  } else {
+    a = sin(dtheta) / dtheta;
+    b = (1 - cos(dtheta)) / dtheta;
+    vx = (a * dx + b * dy) / (a * a + b * b);
+    vy = (a * dy - b * dx) / (a * a + b * b);
+  }
+
+  phi = fraction * dtheta;
+  if (fabs(phi) < 1e-9) {
+    a = 1;
+    b = 0;
+  } else {
+    a = sin(phi) / phi;
+    b = (1 - cos(phi)) / phi;
+  }
+  dx = fraction * (a * vx - b * vy);
+  dy = fraction * (b * vx + a * vy);
+
+  result.x = pose1->x + c * dx - s * dy;
+  result.y = pose1->y + s * dx + c * dy;
+  result.theta = carmen_normalize_theta(pose1->theta + phi);
+  result.tv = pose1->tv + fraction * (pose2->tv - pose1->tv);
+  result.rv = pose1->rv + fraction * (pose2->rv - pose1->rv);
+  result.timestamp = pose1->timestamp +
+    fraction * (pose2->timestamp - pose1->timestamp);
+
+  *pose = result;
+}
+
+int
+carmen_robot_pose_buffer_interpolate(carmen_robot_pose_buffer_p buffer,
+				     double timestamp,
+				     carmen_robot_pose_stamp_p pose)
+{
+  int low, high;
+  double fraction;
+
+  if (!carmen_robot_pose_buffer_find(buffer, timestamp, &low, &high,
+				     &fraction))
+    return 0;
+
+  carmen_robot_interpolate_pose(pose_at(buffer, low), pose_at(buffer, high),
+				fraction, pose);
+  pose->timestamp = timestamp;
+
+  return 1;
+}
+
+int
+carmen_robot_pose_buffer_interpolate_beams
+(carmen_robot_pose_buffer_p buffer, double first_timestamp,
+ double beam_interval, int num_beams, carmen_point_p poses)
+{
+  carmen_robot_pose_stamp_t pose;
+  double timestamp, fraction;
+  int i, low, high;
+
+  if (!carmen_robot_pose_buffer_find(buffer, first_timestamp, &low, &high,
+				     &fraction))
+    return 0;
+
+  for (i = 0; i < num_beams; i++) {
+    timestamp = first_timestamp + i * beam_interval;
+
+    /* The beams are ordered in time, so the bracket only moves forward */
+    if (beam_interval >= 0)
+      while (high < buffer->num_poses - 1 &&
+	     timestamp >= pose_at(buffer, high)->timestamp) {
+	low++;
+	high++;
+      }
+    else
+      while (low > 0 && timestamp < pose_at(buffer, low)->timestamp) {
+	low--;
+	high--;
+      }
+
+    fraction = bracket_fraction(buffer, timestamp, low, high);
+    carmen_robot_interpolate_pose(pose_at(buffer, low), pose_at(buffer, high),
+				  fraction, &pose);
+    poses[i].x = pose.x;
+    poses[i].y = pose.y;
+    poses[i].theta = pose.theta;
+  }
+
+  return 1;
+}
@@ -0,0 +1,118 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/** @addtogroup robot librobot **/
+// @{
+
+/** \file robot_pose_buffer.h
+ * \brief Time-indexed history of odometry poses.
+ *
+ * Keeps the most recent odometry poses in a ring buffer ordered by
+ * timestamp. Poses at arbitrary times are found by binary search and
+ * interpolated along the constant-curvature arc between the bracketing
+ * poses. This allows sensor readings, or individual beams of a laser
+ * scan, to be stamped with the pose the robot had when they were taken.
+ **/
+
+#ifndef ROBOT_POSE_BUFFER_H
+#define ROBOT_POSE_BUFFER_H
+
+#include "global.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  double x, y, theta;
+  double tv, rv;
+  double timestamp;
+} carmen_robot_pose_stamp_t, *carmen_robot_pose_stamp_p;
+
+typedef struct {
+  int size;
+  int num_poses;
+  int first;
+  carmen_robot_pose_stamp_p poses;
+} carmen_robot_pose_buffer_t, *carmen_robot_pose_buffer_p;
+
+/** Creates a buffer that remembers the last size poses. **/
+carmen_robot_pose_buffer_p carmen_robot_pose_buffer_new(int size);
+
+void carmen_robot_pose_buffer_free(carmen_robot_pose_buffer_p buffer);
+
+void carmen_robot_pose_buffer_clear(carmen_robot_pose_buffer_p buffer);
+
+/** Adds a pose, dropping the oldest one if the buffer is full. Poses
+    arriving out of order are sorted in by their timestamps. **/
+void carmen_robot_pose_buffer_add(carmen_robot_pose_buffer_p buffer,
+				  carmen_robot_pose_stamp_p pose);
+
+/** Returns the i-th pose in the buffer, the oldest one being 0, or NULL
+    if there is no such pose. **/
+carmen_robot_pose_stamp_p
+carmen_robot_pose_buffer_get(carmen_robot_pose_buffer_p buffer, int i);
+
+carmen_robot_pose_stamp_p
+carmen_robot_pose_buffer_latest(carmen_robot_pose_buffer_p buffer);
+
+/** Finds the poses low and high = low + 1 that bracket timestamp, and the
+    fraction of the way from low to high. Timestamps before the first or
+    after the last pose are bracketed by the two oldest or newest poses,
+    with a fraction outside [0, 1]. Returns 0 if the buffer is empty. **/
+int carmen_robot_pose_buffer_find(carmen_robot_pose_buffer_p buffer,
+				  double timestamp, int *low, int *high,
+				  double *fraction);
+
+/** Interpolates (or extrapolates) the pose at timestamp. Returns 0 if the
+    buffer is empty. **/
+int carmen_robot_pose_buffer_interpolate(carmen_robot_pose_buffer_p buffer,
+					 double timestamp,
+					 carmen_robot_pose_stamp_p pose);
+
+/** Interpolates the poses of num_beams beams, the first of which was
+    taken at first_timestamp and each following one beam_interval seconds
+    later. Returns 0 if the buffer is empty. **/
+int carmen_robot_pose_buffer_interpolate_beams
+(carmen_robot_pose_buffer_p buffer, double first_timestamp,
+ double beam_interval, int num_beams, carmen_point_p poses);
+
+/** Moves a fraction of the way from pose1 to pose2 along the arc of
+    constant translational and rotational velocity that connects them.
+    Velocities and timestamps are interpolated linearly. **/
+void carmen_robot_interpolate_pose(carmen_robot_pose_stamp_p pose1,
+				   carmen_robot_pose_stamp_p pose2,
+				   double fraction,
+				   carmen_robot_pose_stamp_p pose);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+// @}
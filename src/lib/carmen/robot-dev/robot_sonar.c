@@ -47,8 +47,6 @@ static double min_rear_velocity = -0;
 
 static int collision_avoidance = 0;
 
-double carmen_robot_interpolate_heading(double head1, double head2, double fraction);
-
 static void check_message_data_chunk_sizes(void)
 {
   int first=1;
@@ -76,33 +74,21 @@ static void check_message_data_chunk_sizes(void)
       
 
 static void
-construct_sonar_message(carmen_robot_sonar_message *msg, int low, int high, 
-			double fraction)
+construct_sonar_message(carmen_robot_sonar_message *msg,
+			carmen_robot_pose_stamp_p odometry)
 {
-  msg->robot_pose.x=carmen_robot_odometry[low].x + fraction *
-    (carmen_robot_odometry[high].x - carmen_robot_odometry[low].x);
-  msg->robot_pose.y= carmen_robot_odometry[low].y + fraction *
-    (carmen_robot_odometry[high].y - carmen_robot_odometry[low].y);
-  msg->robot_pose.theta=carmen_robot_interpolate_heading
-    (carmen_robot_odometry[high].theta, 
-     carmen_robot_odometry[low].theta, fraction);
-  msg->robot_pose.theta=carmen_normalize_theta(msg->robot_pose.theta);
-
-
-  msg->tv = carmen_robot_odometry[low].tv + 
-    fraction*(carmen_robot_odometry[high].tv - 
-	      carmen_robot_odometry[low].tv);
-  msg->rv = carmen_robot_odometry[low].rv + 
-    fraction*(carmen_robot_odometry[high].rv - 
-	      carmen_robot_odometry[low].rv);
+  msg->robot_pose.x = odometry->x;
+  msg->robot_pose.y = odometry->y;
+  msg->robot_pose.theta = odometry->theta;
+  msg->tv = odometry->tv;
+  msg->rv = odometry->rv;
 }
 
 void carmen_robot_correct_sonar_and_publish(void) 
 {
   
   double sonar_skew;
-  double fraction;
-  int low, high;
+  carmen_robot_pose_stamp_t odometry;
   IPC_RETURN_TYPE err;
 
   if(!sonar_ready) 
@@ -115,13 +101,13 @@ void carmen_robot_correct_sonar_and_publish(void)
     return;
   }
 
-  fraction = carmen_robot_get_fraction(base_sonar.timestamp, sonar_skew,
-				       &low, &high);
-
-  if (!carmen_robot_config.interpolate_odometry)
-    fraction=0;
+  if (carmen_robot_config.interpolate_odometry)
+    carmen_robot_get_odometry(base_sonar.timestamp, sonar_skew, &odometry);
+  else
+    carmen_robot_get_previous_odometry(base_sonar.timestamp, sonar_skew,
+				       &odometry);
 
-  construct_sonar_message(&robot_sonar, low, high, fraction);
+  construct_sonar_message(&robot_sonar, &odometry);
 
   err = IPC_publishData(CARMEN_ROBOT_SONAR_NAME, &robot_sonar);
   carmen_test_ipc_exit(err, "Could not publish", 
@@ -351,10 +351,20 @@ carmen_simulator_calc_laser_msg(carmen_laser_laser_message *laser,
 
 
 
-  carmen_geometry_generate_laser_data(laser->range, &point, laser->config.start_angle, 
-				      laser->config.start_angle+laser->config.fov, 
-				      laser_config->num_lasers, 
-				      &(simulator_config->map));
+  /* The ray caster is created on demand and rebuilds its clearance
+     map whenever the simulator receives a new map */
+  if (simulator_config->raycast == NULL)
+    simulator_config->raycast = carmen_geometry_raycast_new
+      (CARMEN_GEOMETRY_RAYCAST_DEFAULT_CACHE_SIZE);
+  carmen_geometry_raycast_set_map(simulator_config->raycast,
+				  &(simulator_config->map));
+
+  carmen_geometry_raycast_laser_data(simulator_config->raycast, laser->range,
+				     &point, laser->config.start_angle, 
+				     laser->config.start_angle+
+				     laser->config.fov, 
+				     laser_config->num_lasers, 
+				     laser_config->max_range);
 
   carmen_simulator_add_objects_to_laser(laser, simulator_config, is_rear);
 
@@ -35,6 +35,7 @@
 
 #include "localize_motion.h"
 #include "map.h"
+#include "raycast.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -82,6 +83,7 @@ typedef struct {
 #endif
 
   carmen_map_t map;
+  carmen_geometry_raycast_p raycast;
   carmen_point_t odom_pose;
   carmen_point_t true_pose;
   
@@ -72,7 +72,8 @@ class AbstractMap {
 
   void copy(const AbstractMap<CELL>& src);
   void copy(const AbstractMap<CELL>& src, const IntPoint& relative_offset);
-  void moveMap(int dx, int dy);
+  // shifts the map by dx, dy cells, cells moved in get defaultCell()
+  virtual void moveMap(int dx, int dy);
 
   void resetCells();
   void resetCells(const CELL& val);
@@ -15,11 +15,14 @@
 #include <carmen/cpp_base.h> 
 #include <carmen/cpp_imu.h> 
 #include <carmen/cpp_logfile.h> 
+#include <carmen/cpp_logreader.h> 
 
 #include <carmen/cpp_mapconfig.h> 
 #include <carmen/cpp_abstractmap.h> 
 #include <carmen/cpp_carmenmap.h> 
 #include <carmen/cpp_genericmap.h> 
+#include <carmen/cpp_tiledmap.h> 
+#include <carmen/cpp_mapview.h> 
 #include <carmen/cpp_mapdefinitions.h> 
 
 #endif
@@ -1,6 +1,8 @@
 #ifndef CARMEN_CPP_GENERIC_MAP_H
 #define CARMEN_CPP_GENERIC_MAP_H
 
+#include <algorithm>
+
 #include "cpp_point.h"
 #include "cpp_abstractmap.h"
 
@@ -18,6 +20,8 @@ class GenericMap : public AbstractMap<CELL> {
   virtual CELL& getCell(int x, int y);
   virtual CELL& getCell(int x, int y) const;
 
+  virtual void moveMap(int dx, int dy);
+
  protected:
   CELL*  m_maplinear;
   CELL** m_map;
@@ -77,13 +77,53 @@ bool GenericMap<CELL>::init(const MapConfig& cfg) {
 
 template<class CELL>
 CELL& GenericMap<CELL>::getCell(int x, int y) {
-  return m_map[x][y];
+  return m_maplinear[x*AbstractMap<CELL>::m_cfg.m_sizeY + y];
 }
 
 
 template<class CELL>
 CELL& GenericMap<CELL>::getCell(int x, int y) const {
-  return m_map[x][y];
+  return m_maplinear[x*AbstractMap<CELL>::m_cfg.m_sizeY + y];
+}
+
+// Moves whole columns in place, in the order that does not overwrite
+// cells before they are moved, instead of going through a copy.
+template<class CELL>
+void GenericMap<CELL>::moveMap(int dx, int dy) {
+  int sizeX = AbstractMap<CELL>::m_cfg.m_sizeX;
+  int sizeY = AbstractMap<CELL>::m_cfg.m_sizeY;
+
+  if (m_maplinear == NULL)
+    return;
+
+  if (abs(dx) >= sizeX || abs(dy) >= sizeY) {
+    std::fill(m_maplinear, m_maplinear + sizeX*sizeY, defaultCell());
+  }
+  else {
+    int ylength = sizeY - abs(dy);
+    int yfrom = carmen_imax(0, -dy);
+    for (int i = 0; i < sizeX - abs(dx); i++) {
+      int x = dx >= 0 ? i : sizeX - 1 - i;
+      CELL* src = m_map[x+dx] + yfrom + dy;
+      CELL* dest = m_map[x] + yfrom;
+      if (dx != 0 || dy < 0)
+	std::copy_backward(src, src + ylength, dest + ylength);
+      else
+	std::copy(src, src + ylength, dest);
+      if (dy > 0)
+	std::fill(m_map[x] + ylength, m_map[x] + sizeY, defaultCell());
+      else
+	std::fill(m_map[x], m_map[x] + yfrom, defaultCell());
+    }
+    for (int i = sizeX - abs(dx); i < sizeX; i++) {
+      int x = dx >= 0 ? i : sizeX - 1 - i;
+      std::fill(m_map[x], m_map[x] + sizeY, defaultCell());
+    }
+  }
+
+  double res = AbstractMap<CELL>::getResolution();
+  AbstractMap<CELL>::m_cfg.m_offset.x += res * ((double) dx);
+  AbstractMap<CELL>::m_cfg.m_offset.y += res * ((double) dy);
 }
 
 
@@ -32,7 +32,7 @@ bool LogFile::load(char* filename, bool verbose) {
   }
 
   /* index the logfile */
-  logfile_index = carmen_logfile_index_messages(logfile);
+  logfile_index = carmen_logfile_index_messages_cached(logfile, filename);
 
   for(int i = 0; i < logfile_index->num_messages; i++) {
     
@@ -40,31 +40,11 @@ bool LogFile::load(char* filename, bool verbose) {
     carmen_logfile_read_line(logfile_index, logfile, i, 100000, line);
 
     /* create messages */
-    if(strncmp(line, "ODOM ", 5) == 0) {
-      push_back(new OdometryMessage(line));
-    }
-    else if(strncmp(line, "RAWLASER", 8) == 0) {
-      push_back(new LaserMessage(line));
-    }
-    else if(strncmp(line, "ROBOTLASER", 10) == 0) {
-      push_back(new RobotLaserMessage(line));
-    }
-    else if(strncmp(line, "FLASER ", 7) == 0) {
-      push_back(new RobotLaserMessage(line));
-    }
-    else if(strncmp(line, "RLASER ", 7) == 0) {
-      push_back(new RobotLaserMessage(line));
-    }
-    else if(strncmp(line, "TRUEPOS ", 8) == 0) {
-      push_back(new TrueposMessage(line));
-    }
-    else if(strncmp(line, "IMU ", 4) == 0) {
-      push_back(new IMUMessage(line));
-    }
-    else if(strlen(line) > 1) {
-      push_back(new UnknownMessage(line));
-    }
+    AbstractMessage* message = LogReader::createMessage(line);
+    if (message != NULL)
+      push_back(message);
   }
+  carmen_logfile_free_index(&logfile_index);
   carmen_fclose(logfile);  
   return true;
 }
@@ -13,6 +13,7 @@
 #include "cpp_simulator.h"
 #include "cpp_imu.h"
 #include "cpp_unknownmessage.h"
+#include "cpp_logreader.h"
 
 #include "readlog.h"
 
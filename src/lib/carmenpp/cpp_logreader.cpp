@@ -0,0 +1,204 @@
+#include "cpp_logreader.h"
+
+#include <sys/mman.h>
+
+#include "cpp_laser.h"
+#include "cpp_base.h"
+#include "cpp_robot.h"
+#include "cpp_simulator.h"
+#include "cpp_imu.h"
+#include "cpp_unknownmessage.h"
+
+#define LOGREADER_MAX_LINE_LENGTH 100000
+
+LogReader::LogReader(int cacheSize) {
+  init(cacheSize);
+}
+
+LogReader::LogReader(char* filename, int cacheSize) {
+  init(cacheSize);
+  open(filename);
+}
+
+void LogReader::init(int cacheSize) {
+  m_logfile = NULL;
+  m_index = NULL;
+  m_map = NULL;
+  m_mapLength = 0;
+  m_numDecoded = 0;
+  m_slots.resize(cacheSize > 0 ? cacheSize : 1);
+  for (unsigned int i = 0; i < m_slots.size(); i++)
+    for (int j = 0; j < NumMessageTypes; j++)
+      m_slots[i].messages[j] = NULL;
+  clearCache();
+}
+
+LogReader::~LogReader() {
+  close();
+  for (unsigned int i = 0; i < m_slots.size(); i++)
+    for (int j = 0; j < NumMessageTypes; j++)
+      delete m_slots[i].messages[j];
+}
+
+bool LogReader::open(char* filename, bool verbose) {
+  struct stat stat_buf;
+
+  close();
+  m_logfile = carmen_fopen(filename, "r");
+  if (m_logfile == NULL) {
+    if (verbose)
+      carmen_warn("Error: could not open file %s for reading.\n", filename);
+    return false;
+  }
+  m_index = carmen_logfile_index_messages_cached(m_logfile, filename);
+
+  // compressed and columnar logs are read through readlog
+  if (!m_logfile->compressed && m_index->columnar == NULL &&
+      fstat(fileno(m_logfile->fp), &stat_buf) == 0 && stat_buf.st_size > 0) {
+    m_map = (char*) mmap(NULL, stat_buf.st_size, PROT_READ, MAP_SHARED,
+                         fileno(m_logfile->fp), 0);
+    if (m_map == MAP_FAILED)
+      m_map = NULL;
+    else {
+      m_mapLength = stat_buf.st_size;
+      madvise(m_map, m_mapLength, MADV_SEQUENTIAL);
+    }
+  }
+  m_line.resize(LOGREADER_MAX_LINE_LENGTH);
+  return true;
+}
+
+void LogReader::close() {
+  clearCache();
+  if (m_map != NULL)
+    munmap(m_map, m_mapLength);
+  m_map = NULL;
+  m_mapLength = 0;
+  carmen_logfile_free_index(&m_index);
+  if (m_logfile != NULL)
+    carmen_fclose(m_logfile);
+  m_logfile = NULL;
+}
+
+int LogReader::size() const {
+  if (m_index == NULL)
+    return 0;
+  return m_index->num_messages;
+}
+
+double LogReader::getTimestamp(int position) const {
+  if (m_index == NULL)
+    return 0;
+  return carmen_logfile_message_timestamp(m_index, position);
+}
+
+LogReader::const_iterator LogReader::find(double timestamp) {
+  if (m_index == NULL)
+    return end();
+  return const_iterator(this, carmen_logfile_find_timestamp(m_index,
+                                                            timestamp));
+}
+
+char* LogReader::readLine(int position) {
+  off_t start, length;
+
+  if (m_map == NULL) {
+    carmen_logfile_read_line(m_index, m_logfile, position,
+                             LOGREADER_MAX_LINE_LENGTH, &m_line[0]);
+    return &m_line[0];
+  }
+
+  start = m_index->offset[position];
+  length = m_index->offset[position+1] - start;
+  if (start + length > (off_t) m_mapLength)
+    length = start < (off_t) m_mapLength ? m_mapLength - start : 0;
+  if (length >= LOGREADER_MAX_LINE_LENGTH)
+    carmen_die("Error: exceed maximum line length.\n");
+  memcpy(&m_line[0], m_map + start, length);
+  m_line[length] = '\0';
+  return &m_line[0];
+}
+
+const AbstractMessage* LogReader::get(int position) {
+  if (position < 0 || position >= size())
+    return NULL;
+
+  std::map<int, int>::iterator cached = m_cached.find(position);
+  if (cached != m_cached.end()) {
+    Slot& slot = m_slots[cached->second];
+    m_lru.splice(m_lru.begin(), m_lru, slot.lru);
+    return slot.type == None ? NULL : slot.messages[slot.type];
+  }
+
+  int s = m_lru.back();
+  Slot& slot = m_slots[s];
+  if (slot.position >= 0)
+    m_cached.erase(slot.position);
+  m_lru.splice(m_lru.begin(), m_lru, slot.lru);
+
+  char* line = readLine(position);
+  slot.position = position;
+  slot.type = messageType(line);
+  if (slot.type != None) {
+    if (slot.messages[slot.type] == NULL)
+      slot.messages[slot.type] = createMessage(slot.type, line);
+    else
+      slot.messages[slot.type]->fromString(line);
+  }
+  m_cached[position] = s;
+  m_numDecoded++;
+  return slot.type == None ? NULL : slot.messages[slot.type];
+}
+
+void LogReader::clearCache() {
+  m_cached.clear();
+  m_lru.clear();
+  for (unsigned int i = 0; i < m_slots.size(); i++) {
+    m_slots[i].position = -1;
+    m_slots[i].type = None;
+    m_slots[i].lru = m_lru.insert(m_lru.end(), i);
+  }
+}
+
+LogReader::MessageType LogReader::messageType(const char* line) {
+  if (strncmp(line, "ODOM ", 5) == 0)
+    return Odometry;
+  else if (strncmp(line, "RAWLASER", 8) == 0)
+    return Laser;
+  else if (strncmp(line, "ROBOTLASER", 10) == 0)
+    return RobotLaser;
+  else if (strncmp(line, "FLASER ", 7) == 0)
+    return RobotLaser;
+  else if (strncmp(line, "RLASER ", 7) == 0)
+    return RobotLaser;
+  else if (strncmp(line, "TRUEPOS ", 8) == 0)
+    return Truepos;
+  else if (strncmp(line, "IMU ", 4) == 0)
+    return IMU;
+  else if (strlen(line) > 1)
+    return Unknown;
+  return None;
+}
+
+AbstractMessage* LogReader::createMessage(MessageType type, char* line) {
+  switch (type) {
+  case Odometry:
+    return new OdometryMessage(line);
+  case Laser:
+    return new LaserMessage(line);
+  case RobotLaser:
+    return new RobotLaserMessage(line);
+  case Truepos:
+    return new TrueposMessage(line);
+  case IMU:
+    return new IMUMessage(line);
+  case Unknown:
+    return new UnknownMessage(line);
+  default:
+    return NULL;
+  }
+}
+
+AbstractMessage* LogReader::createMessage(char* line) {
+  return createMessage(messageType(line), line);
+}
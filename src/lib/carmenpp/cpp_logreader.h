@@ -0,0 +1,172 @@
+#ifndef CARMEN_CPP_LOGREADER_H
+#define CARMEN_CPP_LOGREADER_H
+
+#include <list>
+#include <map>
+#include <vector>
+#include <iterator>
+
+#include "cpp_global.h"
+
+#include "cpp_abstractmessage.h"
+
+#include "readlog.h"
+
+// Reads the messages of a log on demand instead of loading them all,
+// like LogFile does. Lines are found through the readlog index (kept in
+// a .cidx file next to the log) and, for uncompressed text logs, read
+// from a memory mapping of the file. Decoded messages are kept in a
+// cache of cacheSize slots, the least recently used slot is decoded
+// into next. Each slot keeps the message objects of the types it held,
+// so decoding reuses their arrays instead of allocating new ones.
+//
+// Memory therefore does not grow with the length of the log. A
+// message returned by get() or an iterator stays valid until cacheSize
+// other messages have been decoded. Use clone() to keep it longer.
+//
+// Positions are the lines of the log. Lines LogFile would skip, such as
+// empty lines, have no message and get() returns NULL for them.
+
+class LogReader {
+ public:
+  enum MessageType {
+    Odometry,
+    Laser,
+    RobotLaser,
+    Truepos,
+    IMU,
+    Unknown,
+    NumMessageTypes,
+    None = -1
+  };
+
+  class const_iterator {
+   public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef const AbstractMessage* value_type;
+    typedef int difference_type;
+    typedef const AbstractMessage** pointer;
+    typedef const AbstractMessage* reference;
+
+    const_iterator() : m_reader(NULL), m_position(0) {}
+    const_iterator(LogReader* reader, int position) :
+      m_reader(reader), m_position(position) {}
+
+    carmen_inline const AbstractMessage* operator*() const {
+      return m_reader->get(m_position);
+    }
+    carmen_inline const AbstractMessage* operator[](int n) const {
+      return m_reader->get(m_position+n);
+    }
+    carmen_inline int getPosition() const {return m_position;}
+    carmen_inline double getTimestamp() const {
+      return m_reader->getTimestamp(m_position);
+    }
+
+    carmen_inline const_iterator& operator++() {++m_position; return *this;}
+    carmen_inline const_iterator& operator--() {--m_position; return *this;}
+    carmen_inline const_iterator operator++(int) {
+      const_iterator it = *this; ++m_position; return it;
+    }
+    carmen_inline const_iterator operator--(int) {
+      const_iterator it = *this; --m_position; return it;
+    }
+    carmen_inline const_iterator& operator+=(int n) {
+      m_position += n; return *this;
+    }
+    carmen_inline const_iterator& operator-=(int n) {
+      m_position -= n; return *this;
+    }
+    carmen_inline const_iterator operator+(int n) const {
+      return const_iterator(m_reader, m_position+n);
+    }
+    carmen_inline const_iterator operator-(int n) const {
+      return const_iterator(m_reader, m_position-n);
+    }
+    carmen_inline int operator-(const const_iterator& x) const {
+      return m_position-x.m_position;
+    }
+
+    carmen_inline bool operator==(const const_iterator& x) const {
+      return m_position == x.m_position;
+    }
+    carmen_inline bool operator!=(const const_iterator& x) const {
+      return m_position != x.m_position;
+    }
+    carmen_inline bool operator<(const const_iterator& x) const {
+      return m_position < x.m_position;
+    }
+    carmen_inline bool operator>(const const_iterator& x) const {
+      return m_position > x.m_position;
+    }
+    carmen_inline bool operator<=(const const_iterator& x) const {
+      return m_position <= x.m_position;
+    }
+    carmen_inline bool operator>=(const const_iterator& x) const {
+      return m_position >= x.m_position;
+    }
+
+   protected:
+    LogReader* m_reader;
+    int m_position;
+  };
+
+  LogReader(int cacheSize = 256);
+  LogReader(char* filename, int cacheSize = 256);
+  virtual ~LogReader();
+
+  bool open(char* filename, bool verbose = true);
+  void close();
+  carmen_inline bool isOpen() const {return m_index != NULL;}
+
+  int size() const;
+  const AbstractMessage* get(int position);
+  carmen_inline const AbstractMessage* operator[](int position) {
+    return get(position);
+  }
+
+  // logger timestamp of a position, from the index
+  double getTimestamp(int position) const;
+  // the first position at or after a logger timestamp
+  const_iterator find(double timestamp);
+
+  carmen_inline const_iterator begin() {return const_iterator(this, 0);}
+  carmen_inline const_iterator end() {return const_iterator(this, size());}
+
+  carmen_inline int getCacheSize() const {return (int) m_slots.size();}
+  carmen_inline int getNumDecoded() const {return m_numDecoded;}
+
+  static MessageType messageType(const char* line);
+  // a new message of type decoded from line, or NULL for None
+  static AbstractMessage* createMessage(MessageType type, char* line);
+  static AbstractMessage* createMessage(char* line);
+
+ protected:
+  struct Slot {
+    int position;
+    MessageType type;
+    AbstractMessage* messages[NumMessageTypes];
+    std::list<int>::iterator lru;
+  };
+
+  void init(int cacheSize);
+  char* readLine(int position);
+  void clearCache();
+
+  carmen_FILE* m_logfile;
+  carmen_logfile_index_p m_index;
+  char* m_map;
+  size_t m_mapLength;
+  std::vector<char> m_line;
+
+  std::vector<Slot> m_slots;
+  std::map<int, int> m_cached;     // position -> slot
+  std::list<int> m_lru;            // slots, most recently used first
+  int m_numDecoded;
+
+ private:
+  LogReader(const LogReader&);
+  LogReader& operator=(const LogReader&);
+};
+
+#endif
@@ -2,6 +2,8 @@
 #define CARMEN_CPP_MAP_DEFINITIONS_H
 
 #include "cpp_genericmap.h"
+#include "cpp_tiledmap.h"
+#include "cpp_mapview.h"
 
 class CharCell {
 public:
@@ -105,4 +107,10 @@ typedef GenericMap<FloatCell>    FloatMap;
 typedef GenericMap<DoubleCell>   DoubleMap;
 typedef GenericMap<RefProbCell>  RefProbMap;
 
+typedef TiledMap<CharCell>       TiledCharMap;
+typedef TiledMap<IntCell>        TiledIntMap;
+typedef TiledMap<FloatCell>      TiledFloatMap;
+typedef TiledMap<DoubleCell>     TiledDoubleMap;
+typedef TiledMap<RefProbCell>    TiledRefProbMap;
+
 #endif
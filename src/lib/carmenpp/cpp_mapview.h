@@ -0,0 +1,38 @@
+#ifndef CARMEN_CPP_MAP_VIEW_H
+#define CARMEN_CPP_MAP_VIEW_H
+
+#include "cpp_point.h"
+#include "cpp_abstractmap.h"
+
+// A rectangle of another map, used as a map of its own without copying
+// cells. Cell (0, 0) of the view is cell from of the map, and the view
+// is placed in the world where the rectangle is. Writing a cell of the
+// view writes the map, which must outlive the view.
+//
+// moveView() slides the view over the map, while moveMap() shifts the
+// cells of the map below the view, as it would for any map.
+
+template<class CELL>
+class MapView : public AbstractMap<CELL> {
+ public:
+  MapView(AbstractMap<CELL>& map, const IntPoint& from, const IntPoint& to);
+  virtual ~MapView();
+
+  // a view can not be reallocated, only a config of its size is accepted
+  virtual bool init(const MapConfig& cfg);
+  virtual const CELL& defaultCell() const;
+
+  virtual CELL& getCell(int x, int y);
+  virtual CELL& getCell(int x, int y) const;
+
+  void moveView(int dx, int dy);
+  carmen_inline IntPoint getFrom() const {return m_from;}
+
+ protected:
+  AbstractMap<CELL>* m_map;
+  IntPoint m_from;
+};
+
+#include "cpp_mapview.hxx"
+
+#endif
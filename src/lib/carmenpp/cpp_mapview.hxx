@@ -0,0 +1,42 @@
+
+template<class CELL>
+MapView<CELL>::MapView(AbstractMap<CELL>& map, const IntPoint& from, 
+		       const IntPoint& to) 
+  : AbstractMap<CELL>(MapConfig(to.x-from.x, to.y-from.y, 
+				map.getResolution(), map.map2world(from))) {
+  m_map = &map;
+  m_from = from;
+}
+
+template<class CELL>
+MapView<CELL>::~MapView() {
+}
+
+template<class CELL>
+bool MapView<CELL>::init(const MapConfig& cfg) {
+  return cfg.m_sizeX == AbstractMap<CELL>::m_cfg.m_sizeX &&
+    cfg.m_sizeY == AbstractMap<CELL>::m_cfg.m_sizeY;
+}
+
+template<class CELL>
+const CELL& MapView<CELL>::defaultCell() const {
+  return m_map->defaultCell();
+}
+
+template<class CELL>
+CELL& MapView<CELL>::getCell(int x, int y) {
+  return m_map->getCell(x + m_from.x, y + m_from.y);
+}
+
+template<class CELL>
+CELL& MapView<CELL>::getCell(int x, int y) const {
+  const AbstractMap<CELL>* map = m_map;
+  return map->getCell(x + m_from.x, y + m_from.y);
+}
+
+template<class CELL>
+void MapView<CELL>::moveView(int dx, int dy) {
+  m_from.x += dx;
+  m_from.y += dy;
+  AbstractMap<CELL>::m_cfg.m_offset = m_map->map2world(m_from);
+}
@@ -0,0 +1,72 @@
+#ifndef CARMEN_CPP_TILED_MAP_H
+#define CARMEN_CPP_TILED_MAP_H
+
+#include <algorithm>
+
+#include "cpp_point.h"
+#include "cpp_abstractmap.h"
+
+#define CARMEN_CPP_TILE_BITS   6
+#define CARMEN_CPP_TILE_SIZE   (1 << CARMEN_CPP_TILE_BITS)
+
+// A map stored in tiles of CARMEN_CPP_TILE_SIZE x CARMEN_CPP_TILE_SIZE
+// cells, each contiguous in y like GenericMap. Tiles are allocated when
+// one of their cells is written, so large, mostly unknown maps only take
+// the memory of the parts that were touched.
+//
+// The tiles are kept in a ring addressed by absolute cell coordinates,
+// so moveMap() only changes the origin of the map: tiles that leave the
+// map are freed and only the cells that move in are reset. No cell that
+// stays in the map is copied.
+//
+// The non-const getCell() allocates the tile of the cell. Use value()
+// to read cells without allocating. The const getCell() returns the
+// default cell for cells in tiles that were never written, which must
+// not be written through.
+
+template<class CELL>
+class TiledMap : public AbstractMap<CELL> {
+ public:
+  TiledMap();
+  TiledMap(const MapConfig& cfg);
+  TiledMap(const TiledMap<CELL>& src);
+  virtual ~TiledMap();
+
+  virtual bool init(const MapConfig& cfg);
+  virtual const CELL& defaultCell() const;
+
+  virtual CELL& getCell(int x, int y);
+  virtual CELL& getCell(int x, int y) const;
+  carmen_inline const CELL& value(int x, int y) const;
+
+  // For loops over many cells: the cells from (x, y) on in y that lie in
+  // one tile, *length of them, contiguous. The const version returns
+  // NULL if the tile was never written.
+  CELL* getColumn(int x, int y, int* length);
+  const CELL* getColumn(int x, int y, int* length) const;
+
+  virtual void moveMap(int dx, int dy);
+
+  // frees all tiles, so that every cell is defaultCell()
+  void clear();
+  carmen_inline int getNumTiles() const {return m_numTiles;}
+
+ protected:
+  carmen_inline int tileIndex(int ax, int ay) const;
+  carmen_inline static int cellIndex(int ax, int ay);
+  CELL* allocTile(int index);
+  void freeTile(int index);
+  void resetRegion(int axfrom, int axto, int ayfrom, int ayto);
+
+  // absolute coordinates of cell (0, 0)
+  int m_originX, m_originY;
+  // size of the ring of tiles, powers of two
+  int m_tilesX, m_tilesY;
+  CELL** m_tiles;
+  int m_numTiles;
+  CELL m_defaultCell;
+};
+
+#include "cpp_tiledmap.hxx"
+
+#endif
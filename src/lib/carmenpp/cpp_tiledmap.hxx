@@ -0,0 +1,244 @@
+
+template<class CELL>
+TiledMap<CELL>::TiledMap() : AbstractMap<CELL>() {
+  m_originX = m_originY = 0;
+  m_tilesX = m_tilesY = 0;
+  m_tiles = NULL;
+  m_numTiles = 0;
+}
+
+template<class CELL>
+TiledMap<CELL>::TiledMap(const MapConfig& cfg) 
+  : AbstractMap<CELL>() {
+  m_originX = m_originY = 0;
+  m_tilesX = m_tilesY = 0;
+  m_tiles = NULL;
+  m_numTiles = 0;
+  init(cfg);
+}
+
+template<class CELL>
+TiledMap<CELL>::TiledMap(const TiledMap<CELL>& src) 
+  : AbstractMap<CELL>() {
+  m_originX = m_originY = 0;
+  m_tilesX = m_tilesY = 0;
+  m_tiles = NULL;
+  m_numTiles = 0;
+  if (!init(src.getConfig()))
+    return;
+  m_originX = src.m_originX;
+  m_originY = src.m_originY;
+  for (int i = 0; i < m_tilesX*m_tilesY; i++)
+    if (src.m_tiles[i] != NULL)
+      std::copy(src.m_tiles[i], 
+		src.m_tiles[i] + CARMEN_CPP_TILE_SIZE*CARMEN_CPP_TILE_SIZE,
+		allocTile(i));
+}
+
+template<class CELL>
+TiledMap<CELL>::~TiledMap() {
+  clear();
+  if (m_tiles != NULL)
+    delete [] m_tiles;
+  m_tiles = NULL;
+}
+
+template<class CELL>
+bool TiledMap<CELL>::init(const MapConfig& cfg) {
+
+  // both invalid
+  if (!cfg.isValid() && !(AbstractMap<CELL>::m_cfg.isValid()))
+    return false;
+
+  clear();
+  if (m_tiles != NULL)
+    delete [] m_tiles;
+  m_tiles = NULL;
+  m_originX = m_originY = 0;
+  AbstractMap<CELL>::m_cfg = cfg;
+
+  if (!cfg.isValid())
+    return false;
+
+  // a map that is not aligned with the tiles touches one more of them
+  m_tilesX = 1;
+  while (m_tilesX < (cfg.m_sizeX-1) / CARMEN_CPP_TILE_SIZE + 2)
+    m_tilesX *= 2;
+  m_tilesY = 1;
+  while (m_tilesY < (cfg.m_sizeY-1) / CARMEN_CPP_TILE_SIZE + 2)
+    m_tilesY *= 2;
+  m_tiles = new CELL*[m_tilesX*m_tilesY];
+  carmen_test_alloc(m_tiles);
+  std::fill(m_tiles, m_tiles + m_tilesX*m_tilesY, (CELL*) NULL);
+  return true;
+}
+
+template<class CELL>
+carmen_inline int TiledMap<CELL>::tileIndex(int ax, int ay) const {
+  return ((ax >> CARMEN_CPP_TILE_BITS) & (m_tilesX-1)) * m_tilesY +
+    ((ay >> CARMEN_CPP_TILE_BITS) & (m_tilesY-1));
+}
+
+template<class CELL>
+carmen_inline int TiledMap<CELL>::cellIndex(int ax, int ay) {
+  return ((ax & (CARMEN_CPP_TILE_SIZE-1)) << CARMEN_CPP_TILE_BITS) |
+    (ay & (CARMEN_CPP_TILE_SIZE-1));
+}
+
+template<class CELL>
+CELL* TiledMap<CELL>::allocTile(int index) {
+  m_tiles[index] = new CELL[CARMEN_CPP_TILE_SIZE*CARMEN_CPP_TILE_SIZE];
+  carmen_test_alloc(m_tiles[index]);
+  std::fill(m_tiles[index], 
+	    m_tiles[index] + CARMEN_CPP_TILE_SIZE*CARMEN_CPP_TILE_SIZE, 
+	    m_defaultCell);
+  m_numTiles++;
+  return m_tiles[index];
+}
+
+template<class CELL>
+void TiledMap<CELL>::freeTile(int index) {
+  if (m_tiles[index] == NULL)
+    return;
+  delete [] m_tiles[index];
+  m_tiles[index] = NULL;
+  m_numTiles--;
+}
+
+template<class CELL>
+void TiledMap<CELL>::clear() {
+  if (m_tiles == NULL)
+    return;
+  for (int i = 0; i < m_tilesX*m_tilesY; i++)
+    freeTile(i);
+}
+
+template<class CELL>
+CELL& TiledMap<CELL>::getCell(int x, int y) {
+  int ax = x + m_originX, ay = y + m_originY;
+  int index = tileIndex(ax, ay);
+  CELL* tile = m_tiles[index];
+
+  if (tile == NULL)
+    tile = allocTile(index);
+  return tile[cellIndex(ax, ay)];
+}
+
+template<class CELL>
+CELL& TiledMap<CELL>::getCell(int x, int y) const {
+  int ax = x + m_originX, ay = y + m_originY;
+  CELL* tile = m_tiles[tileIndex(ax, ay)];
+
+  if (tile == NULL)
+    return const_cast<CELL&>(m_defaultCell);
+  return tile[cellIndex(ax, ay)];
+}
+
+template<class CELL>
+carmen_inline const CELL& TiledMap<CELL>::value(int x, int y) const {
+  int ax = x + m_originX, ay = y + m_originY;
+  const CELL* tile = m_tiles[tileIndex(ax, ay)];
+
+  if (tile == NULL)
+    return m_defaultCell;
+  return tile[cellIndex(ax, ay)];
+}
+
+template<class CELL>
+CELL* TiledMap<CELL>::getColumn(int x, int y, int* length) {
+  int ax = x + m_originX, ay = y + m_originY;
+  int index = tileIndex(ax, ay);
+  CELL* tile = m_tiles[index];
+
+  *length = carmen_imin(CARMEN_CPP_TILE_SIZE - (ay & (CARMEN_CPP_TILE_SIZE-1)),
+			AbstractMap<CELL>::m_cfg.m_sizeY - y);
+  if (tile == NULL)
+    tile = allocTile(index);
+  return tile + cellIndex(ax, ay);
+}
+
+template<class CELL>
+const CELL* TiledMap<CELL>::getColumn(int x, int y, int* length) const {
+  int ax = x + m_originX, ay = y + m_originY;
+  const CELL* tile = m_tiles[tileIndex(ax, ay)];
+
+  *length = carmen_imin(CARMEN_CPP_TILE_SIZE - (ay & (CARMEN_CPP_TILE_SIZE-1)),
+			AbstractMap<CELL>::m_cfg.m_sizeY - y);
+  if (tile == NULL)
+    return NULL;
+  return tile + cellIndex(ax, ay);
+}
+
+template<class CELL>
+const CELL& TiledMap<CELL>::defaultCell() const {
+  return m_defaultCell;
+}
+
+// resets the cells in [axfrom, axto) x [ayfrom, ayto) of allocated tiles
+template<class CELL>
+void TiledMap<CELL>::resetRegion(int axfrom, int axto, int ayfrom, int ayto) {
+  for (int ax = axfrom; ax < axto; ax++) {
+    int ay = ayfrom;
+    while (ay < ayto) {
+      int ayend = carmen_imin(ayto, (ay | (CARMEN_CPP_TILE_SIZE-1)) + 1);
+      CELL* tile = m_tiles[tileIndex(ax, ay)];
+      if (tile != NULL)
+	std::fill(tile + cellIndex(ax, ay), tile + cellIndex(ax, ayend-1) + 1,
+		  m_defaultCell);
+      ay = ayend;
+    }
+  }
+}
+
+template<class CELL>
+void TiledMap<CELL>::moveMap(int dx, int dy) {
+  int sizeX = AbstractMap<CELL>::m_cfg.m_sizeX;
+  int sizeY = AbstractMap<CELL>::m_cfg.m_sizeY;
+
+  if (m_tiles == NULL)
+    return;
+
+  if (abs(dx) >= sizeX || abs(dy) >= sizeY) {
+    clear();
+  }
+  else {
+    int oldX = m_originX, oldY = m_originY;
+    int newX = oldX + dx, newY = oldY + dy;
+
+    // No two tiles of the map share a place in the ring, so tiles are
+    // identified by the columns and rows of tiles the map covered.
+    int oldFromX = oldX >> CARMEN_CPP_TILE_BITS;
+    int oldToX = (oldX+sizeX-1) >> CARMEN_CPP_TILE_BITS;
+    int newFromX = newX >> CARMEN_CPP_TILE_BITS;
+    int newToX = (newX+sizeX-1) >> CARMEN_CPP_TILE_BITS;
+    for (int tx = oldFromX; tx <= oldToX; tx++)
+      if (tx < newFromX || tx > newToX)
+	for (int ty = 0; ty < m_tilesY; ty++)
+	  freeTile((tx & (m_tilesX-1)) * m_tilesY + ty);
+
+    int oldFromY = oldY >> CARMEN_CPP_TILE_BITS;
+    int oldToY = (oldY+sizeY-1) >> CARMEN_CPP_TILE_BITS;
+    int newFromY = newY >> CARMEN_CPP_TILE_BITS;
+    int newToY = (newY+sizeY-1) >> CARMEN_CPP_TILE_BITS;
+    for (int ty = oldFromY; ty <= oldToY; ty++)
+      if (ty < newFromY || ty > newToY)
+	for (int tx = 0; tx < m_tilesX; tx++)
+	  freeTile(tx * m_tilesY + (ty & (m_tilesY-1)));
+
+    // cells moving in may be left over in tiles that stay
+    if (dx > 0)
+      resetRegion(oldX+sizeX, newX+sizeX, newY, newY+sizeY);
+    else if (dx < 0)
+      resetRegion(newX, oldX, newY, newY+sizeY);
+    if (dy > 0)
+      resetRegion(newX, newX+sizeX, oldY+sizeY, newY+sizeY);
+    else if (dy < 0)
+      resetRegion(newX, newX+sizeX, newY, oldY);
+  }
+
+  m_originX += dx;
+  m_originY += dy;
+  double res = AbstractMap<CELL>::getResolution();
+  AbstractMap<CELL>::m_cfg.m_offset.x += res * ((double) dx);
+  AbstractMap<CELL>::m_cfg.m_offset.y += res * ((double) dy);
+}
@@ -27,6 +27,8 @@
  ********************************************************/
 
 
+#include <float.h>
+
 #include "global.h"
 
 #define        NUM_ROBOT_NAMES        7
@@ -378,8 +380,24 @@ carmen_find_robot_name(int argc, char **argv)
   return NULL;
 }
 
+int carmen_simulated_time_enabled = 0;
+double carmen_simulated_time = 0.0;
+
+void
+carmen_set_simulated_time(double t)
+{
+  carmen_simulated_time = t;
+  carmen_simulated_time_enabled = 1;
+}
+
+void
+carmen_clear_simulated_time(void)
+{
+  carmen_simulated_time_enabled = 0;
+}
+
 double 
-carmen_get_time(void)
+carmen_get_wall_time(void)
 {
   struct timeval tv;
   double t;
@@ -391,6 +409,14 @@ carmen_get_time(void)
   return t;
 }
 
+double 
+carmen_get_time(void)
+{
+  if (carmen_simulated_time_enabled)
+    return carmen_simulated_time;
+  return carmen_get_wall_time();
+}
+
 char *carmen_get_host(void) 
 {
   FILE *bin_host;
@@ -769,6 +795,181 @@ carmen_get_next_point(carmen_bresenham_param_t *params)
   return 1;
 }
 
+static void
+grid_ray_axis(double origin, double direction, int *cell, int *step,
+	      double *t_max, double *t_delta)
+{
+  *cell = floor(origin);
+  if (direction > 0) {
+    *step = 1;
+    *t_delta = 1.0/direction;
+    *t_max = (*cell+1-origin)*(*t_delta);
+  } else if (direction < 0) {
+    *step = -1;
+    *t_delta = -1.0/direction;
+    *t_max = (origin-*cell)*(*t_delta);
+  } else {
+    *step = 0;
+    *t_delta = DBL_MAX;
+    *t_max = DBL_MAX;
+  }
+}
+
+void
+carmen_grid_ray_init(carmen_grid_ray_p ray, double x, double y,
+		     double theta, double length)
+{
+  grid_ray_axis(x, cos(theta), &ray->x, &ray->step_x, &ray->t_max_x,
+		&ray->t_delta_x);
+  grid_ray_axis(y, sin(theta), &ray->y, &ray->step_y, &ray->t_max_y,
+		&ray->t_delta_y);
+  ray->t = 0;
+  ray->t_end = length;
+}
+
+void
+carmen_grid_ray_init_segment(carmen_grid_ray_p ray, double x1, double y1,
+			     double x2, double y2)
+{
+  double length = hypot(x2-x1, y2-y1);
+
+  if (length > 0) {
+    grid_ray_axis(x1, (x2-x1)/length, &ray->x, &ray->step_x, &ray->t_max_x,
+		  &ray->t_delta_x);
+    grid_ray_axis(y1, (y2-y1)/length, &ray->y, &ray->step_y, &ray->t_max_y,
+		  &ray->t_delta_y);
+  } else {
+    grid_ray_axis(x1, 0, &ray->x, &ray->step_x, &ray->t_max_x,
+		  &ray->t_delta_x);
+    grid_ray_axis(y1, 0, &ray->y, &ray->step_y, &ray->t_max_y,
+		  &ray->t_delta_y);
+  }
+  ray->t = 0;
+  ray->t_end = length;
+}
+
+carmen_inline int
+carmen_grid_ray_next(carmen_grid_ray_p ray)
+{
+  if (ray->t_max_x < ray->t_max_y) {
+    if (ray->t_max_x > ray->t_end)
+      return 0;
+    ray->t = ray->t_max_x;
+    ray->t_max_x += ray->t_delta_x;
+    ray->x += ray->step_x;
+  } else {
+    if (ray->t_max_y > ray->t_end)
+      return 0;
+    ray->t = ray->t_max_y;
+    ray->t_max_y += ray->t_delta_y;
+    ray->y += ray->step_y;
+  }
+  return 1;
+}
+
+carmen_inline void
+carmen_grid_ray_stop(carmen_grid_ray_p ray)
+{
+  ray->t_end = ray->t;
+}
+
+carmen_grid_rays_p
+carmen_grid_rays_new(void)
+{
+  carmen_grid_rays_p rays;
+
+  rays = (carmen_grid_rays_p)calloc(1, sizeof(carmen_grid_rays_t));
+  carmen_test_alloc(rays);
+  rays->index = -1;
+  return rays;
+}
+
+void
+carmen_grid_rays_free(carmen_grid_rays_p rays)
+{
+  if (rays == NULL)
+    return;
+  free(rays->rays);
+  free(rays->t_stop);
+  free(rays);
+}
+
+void
+carmen_grid_rays_reset(carmen_grid_rays_p rays, int x_size, int y_size)
+{
+  rays->x_size = x_size;
+  rays->y_size = y_size;
+  rays->num_rays = 0;
+  rays->index = -1;
+}
+
+static carmen_grid_ray_p
+grid_rays_new_ray(carmen_grid_rays_p rays)
+{
+  if (rays->num_rays == rays->max_rays) {
+    rays->max_rays = rays->max_rays ? 2*rays->max_rays : 256;
+    rays->rays = (carmen_grid_ray_p)
+      realloc(rays->rays, rays->max_rays*sizeof(carmen_grid_ray_t));
+    carmen_test_alloc(rays->rays);
+    rays->t_stop = (double *)realloc(rays->t_stop, 
+				     rays->max_rays*sizeof(double));
+    carmen_test_alloc(rays->t_stop);
+  }
+  rays->t_stop[rays->num_rays] = 0;
+  return rays->rays+rays->num_rays++;
+}
+
+int
+carmen_grid_rays_add(carmen_grid_rays_p rays, double x, double y,
+		     double theta, double length)
+{
+  carmen_grid_ray_init(grid_rays_new_ray(rays), x, y, theta, length);
+  return rays->num_rays-1;
+}
+
+int
+carmen_grid_rays_add_segment(carmen_grid_rays_p rays, double x1, double y1,
+			     double x2, double y2)
+{
+  carmen_grid_ray_init_segment(grid_rays_new_ray(rays), x1, y1, x2, y2);
+  return rays->num_rays-1;
+}
+
+int
+carmen_grid_rays_next(carmen_grid_rays_p rays, carmen_grid_ray_p ray,
+		      int *index)
+{
+  carmen_grid_ray_p next;
+
+  /* t_end was set to where the ray left the grid or was stopped */
+  if (rays->index >= 0 && rays->index < rays->num_rays)
+    rays->t_stop[rays->index] = ray->t_end;
+
+  for (rays->index++; rays->index < rays->num_rays; rays->index++) {
+    next = rays->rays+rays->index;
+    if (next->x >= 0 && next->x < rays->x_size &&
+	next->y >= 0 && next->y < rays->y_size) {
+      *ray = *next;
+      *index = rays->index;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+carmen_inline int
+carmen_grid_rays_step(carmen_grid_rays_p rays, carmen_grid_ray_p ray)
+{
+  if (!carmen_grid_ray_next(ray))
+    return 0;
+  if (ray->x < 0 || ray->x >= rays->x_size ||
+      ray->y < 0 || ray->y >= rays->y_size) {
+    ray->t_end = ray->t;
+    return 0;
+  }
+  return 1;
+}
+
 int 
 carmen_sign(double num) 
 {
@@ -906,6 +1107,103 @@ carmen_gaussian_random(double mean, double std)
   return mean + std * z;
 } 
 
+static carmen_inline unsigned long long
+rotate_left(unsigned long long x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+void
+carmen_random_seed(carmen_random_p rng, unsigned long long seed)
+{
+  unsigned long long z;
+  int i;
+
+  /* splitmix64, so that similar seeds give unrelated states */
+  for (i = 0; i < 4; i++) {
+    seed += 0x9e3779b97f4a7c15ULL;
+    z = seed;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    rng->state[i] = z ^ (z >> 31);
+  }
+  rng->have_gaussian = 0;
+}
+
+unsigned long long
+carmen_random_next(carmen_random_p rng)
+{
+  unsigned long long *s = rng->state;
+  unsigned long long result, t;
+
+  result = rotate_left(s[1] * 5, 7) * 9;
+  t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotate_left(s[3], 45);
+
+  return result;
+}
+
+/* in [0, 1) */
+static carmen_inline double
+random_unit(carmen_random_p rng)
+{
+  return (carmen_random_next(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double
+carmen_random_uniform(carmen_random_p rng, double min, double max)
+{
+  return min + random_unit(rng) * (max - min);
+}
+
+double
+carmen_random_gaussian(carmen_random_p rng, double mean, double std)
+{
+  double u, v, r;
+
+  if (rng->have_gaussian) {
+    rng->have_gaussian = 0;
+    return mean + std * rng->gaussian;
+  }
+
+  u = 1.0 - random_unit(rng);                      /* can't let u == 0 */
+  v = 2.0 * M_PI * random_unit(rng);
+  r = sqrt(-2.0 * log(u));
+  rng->gaussian = r * sin(v);
+  rng->have_gaussian = 1;
+
+  return mean + std * r * cos(v);
+}
+
+/* Box-Muller on pairs. The uniforms are drawn first, so that the
+   transform is a plain loop over the array the compiler can
+   vectorize. */
+void
+carmen_random_gaussians(carmen_random_p rng, double *samples,
+			int num_samples)
+{
+  double r, v;
+  int i;
+
+  for (i = 0; i+1 < num_samples; i += 2) {
+    samples[i] = 1.0 - random_unit(rng);
+    samples[i+1] = 2.0 * M_PI * random_unit(rng);
+  }
+  for (i = 0; i+1 < num_samples; i += 2) {
+    r = sqrt(-2.0 * log(samples[i]));
+    v = samples[i+1];
+    samples[i] = r * cos(v);
+    samples[i+1] = r * sin(v);
+  }
+  if (num_samples % 2)
+    samples[num_samples-1] = carmen_random_gaussian(rng, 0.0, 1.0);
+}
+
 int
 carmen_file_exists(const char *filename)
 {
@@ -210,7 +210,17 @@ void carmen_carp_set_verbose(int verbosity);
 int carmen_carp_get_verbose(void);
 void carmen_carp_set_output(FILE *output);
 
-extern carmen_inline double carmen_get_time(void)
+/* A process may replace the system clock by a simulated clock, e.g.
+   when the simulator runs in lockstep mode. carmen_get_time() then
+   returns the simulated time, carmen_get_wall_time() always returns
+   the system time. */
+extern int carmen_simulated_time_enabled;
+extern double carmen_simulated_time;
+
+void carmen_set_simulated_time(double t);
+void carmen_clear_simulated_time(void);
+
+extern carmen_inline double carmen_get_wall_time(void)
 {
   struct timeval tv;
   double t;
@@ -222,6 +232,13 @@ extern carmen_inline double carmen_get_time(void)
   return t;
 }
 
+extern carmen_inline double carmen_get_time(void)
+{
+  if (carmen_simulated_time_enabled)
+    return carmen_simulated_time;
+  return carmen_get_wall_time();
+}
+
 char *carmen_get_host(void);
 
 carmen_default_message *carmen_default_message_create(void);
@@ -391,6 +408,112 @@ extern carmen_inline int carmen_get_next_point(carmen_bresenham_param_t *params)
   return 1;
 }
 
+/* Traversal of the grid cells a ray passes through (Amanatides and
+   Woo). Coordinates are in cells: cell (x, y) covers [x, x+1) x
+   [y, y+1). Unlike the Bresenham lines above, the ray visits every cell
+   it touches, and t is how far along the ray, in cells, it entered the
+   current cell. */
+
+typedef struct {
+  int x, y;
+  int step_x, step_y;
+  double t, t_end;
+  double t_max_x, t_max_y;
+  double t_delta_x, t_delta_y;
+} carmen_grid_ray_t, *carmen_grid_ray_p;
+
+/* A ray from (x, y) along theta that ends after length cells. */
+void carmen_grid_ray_init(carmen_grid_ray_p ray, double x, double y,
+			  double theta, double length);
+/* A ray from (x1, y1) that ends in the cell of (x2, y2). */
+void carmen_grid_ray_init_segment(carmen_grid_ray_p ray, double x1, double y1,
+				  double x2, double y2);
+
+/* Moves the ray to its next cell. Returns 0 at the end of the ray. */
+extern carmen_inline int carmen_grid_ray_next(carmen_grid_ray_p ray)
+{
+  if (ray->t_max_x < ray->t_max_y) {
+    if (ray->t_max_x > ray->t_end)
+      return 0;
+    ray->t = ray->t_max_x;
+    ray->t_max_x += ray->t_delta_x;
+    ray->x += ray->step_x;
+  } else {
+    if (ray->t_max_y > ray->t_end)
+      return 0;
+    ray->t = ray->t_max_y;
+    ray->t_max_y += ray->t_delta_y;
+    ray->y += ray->step_y;
+  }
+  return 1;
+}
+
+/* Ends the ray in its current cell, after which carmen_grid_ray_next()
+   returns 0. */
+extern carmen_inline void carmen_grid_ray_stop(carmen_grid_ray_p ray)
+{
+  ray->t_end = ray->t;
+}
+
+/* Many rays cast one after the other, e.g. the beams of a scan, on a
+   grid of x_size x y_size cells. Rays are handed out in the cell they
+   start in and end at their length, where they leave the grid, or where
+   the caller stops them. The ray is the caller's own, so it stays in
+   registers while its cells are visited:
+
+     while (carmen_grid_rays_next(rays, &ray, &index))
+       do {
+         if (... cell ray.x, ray.y stops the ray ...) {
+           carmen_grid_ray_stop(&ray);
+           break;
+         }
+       } while (carmen_grid_rays_step(rays, &ray));
+
+   Once the next ray is asked for, t_stop of the previous one holds how
+   far it got: to the cell it was stopped in, to the grid border or its
+   length. */
+
+typedef struct {
+  int x_size, y_size;
+  int num_rays, max_rays;
+  carmen_grid_ray_p rays;
+  double *t_stop;
+  int index;
+} carmen_grid_rays_t, *carmen_grid_rays_p;
+
+carmen_grid_rays_p carmen_grid_rays_new(void);
+void carmen_grid_rays_free(carmen_grid_rays_p rays);
+/* Removes all rays, the next ones are cast on a grid of x_size x
+   y_size cells. */
+void carmen_grid_rays_reset(carmen_grid_rays_p rays, int x_size, int y_size);
+/* Same as carmen_grid_ray_init() and carmen_grid_ray_init_segment().
+   Return the number of the new ray; rays are numbered from 0 in the
+   order they were added, and handed out in that order. A ray that
+   starts outside the grid is skipped and its t_stop stays 0. */
+int carmen_grid_rays_add(carmen_grid_rays_p rays, double x, double y,
+			 double theta, double length);
+int carmen_grid_rays_add_segment(carmen_grid_rays_p rays, double x1,
+				 double y1, double x2, double y2);
+/* Records where the previous ray in *ray ended and puts the next ray
+   there. Returns 0 after the last ray. */
+int carmen_grid_rays_next(carmen_grid_rays_p rays, carmen_grid_ray_p ray,
+			  int *index);
+
+/* Moves the ray to its next cell. Returns 0 at its end or when it
+   leaves the grid. */
+extern carmen_inline int carmen_grid_rays_step(carmen_grid_rays_p rays,
+					       carmen_grid_ray_p ray)
+{
+  if (!carmen_grid_ray_next(ray))
+    return 0;
+  if (ray->x < 0 || ray->x >= rays->x_size ||
+      ray->y < 0 || ray->y >= rays->y_size) {
+    ray->t_end = ray->t;
+    return 0;
+  }
+  return 1;
+}
+
 int carmen_sign(double num);
 
 void carmen_rect_to_polar(double x, double y, double *r, double *theta);
@@ -405,6 +528,25 @@ int carmen_int_random(int max);
 double carmen_uniform_random(double min, double max);
 double carmen_gaussian_random(double mean, double std);
 
+/* A random number stream (xoshiro256**) that does not share the state of
+   rand(): the same seed gives the same sequence, and streams used from
+   different threads do not interfere. */
+
+typedef struct {
+  unsigned long long state[4];
+  int have_gaussian;
+  double gaussian;
+} carmen_random_t, *carmen_random_p;
+
+void carmen_random_seed(carmen_random_p rng, unsigned long long seed);
+unsigned long long carmen_random_next(carmen_random_p rng);
+double carmen_random_uniform(carmen_random_p rng, double min, double max);
+double carmen_random_gaussian(carmen_random_p rng, double mean, double std);
+/* Fills samples with num_samples standard normal samples. Cheaper per
+   sample than carmen_random_gaussian(). */
+void carmen_random_gaussians(carmen_random_p rng, double *samples,
+			     int num_samples);
+
 int carmen_file_exists(const char *filename);
 char *carmen_file_extension(const char *filename);
 char *carmen_file_find(const char *filename);
@@ -246,21 +246,84 @@ float carmen_map_image_to_map_color_occupancy(unsigned char r, unsigned char g,
 }
 
 #ifndef COMPILE_WITHOUT_MAP_SUPPORT
+void carmen_graphics_convert_map_value(double value, int flags,
+				       double min_val, double max_val,
+				       unsigned char *rgb)
+{
+  int rescale = (flags & CARMEN_GRAPHICS_RESCALE) && max_val >= 0;
+  int invert = flags & CARMEN_GRAPHICS_INVERT;
+  int black_and_white = flags & CARMEN_GRAPHICS_BLACK_AND_WHITE;
+
+  if (value < 0 && value > -1.5) {
+    if (black_and_white) {
+      rgb[0] = 255;
+      rgb[1] = 255;
+      rgb[2] = 255;
+    } else {
+      rgb[0] = 0;
+      rgb[1] = 0;
+      rgb[2] = 255;
+    }
+  }
+  else if (value < -1.5) { // for offlimits
+    if (black_and_white) {
+      rgb[0] = 205;
+      rgb[1] = 205;
+      rgb[2] = 205;
+    } else {
+      rgb[0] = 255;
+      rgb[1] = 0;
+      rgb[2] = 0;
+    }
+  }
+  else if(!rescale && value > 1.0) {
+    if (black_and_white) {
+      rgb[0] = 128;
+      rgb[1] = 128;
+      rgb[2] = 128;
+    } else {
+      rgb[0] = 255;
+      rgb[1] = 0;
+      rgb[2] = 0;
+    }
+  } else {
+    if (rescale)
+      value = (value - min_val) / (max_val - min_val);
+    if (!invert)
+      value = 1 - value;
+    rgb[0] = value * 255;
+    rgb[1] = value * 255;
+    rgb[2] = value * 255;
+  }
+}
+
+void carmen_graphics_get_map_range(carmen_map_p map, double *min_val,
+				   double *max_val)
+{
+  register float *data_ptr;
+  int index;
+
+  *max_val = -MAXDOUBLE;
+  *min_val = MAXDOUBLE;
+  data_ptr = map->complete_map;
+  for (index = 0; index < map->config.x_size*map->config.y_size; index++) {
+    *max_val = carmen_fmax(*max_val, *data_ptr);
+    if (*data_ptr >= 0)
+      *min_val = carmen_fmin(*min_val, *data_ptr);
+    data_ptr++;
+  }
+}
+
 unsigned char *carmen_graphics_convert_to_image(carmen_map_p map, int flags) 
 {
   register float *data_ptr;
   unsigned char *image_data = NULL;
   register unsigned char *image_ptr = NULL;
-  double value;
   int x_size, y_size;
   int x_index, y_index;
-  int index;
   double max_val = -MAXDOUBLE, min_val = MAXDOUBLE;
 
-  int rescale = flags & CARMEN_GRAPHICS_RESCALE;
-  int invert = flags & CARMEN_GRAPHICS_INVERT;
   int rotate = flags & CARMEN_GRAPHICS_ROTATE;
-  int black_and_white = flags & CARMEN_GRAPHICS_BLACK_AND_WHITE;
 
   if (map == NULL) {
     carmen_warn("carmen_graphics_convert_to_image was passed NULL map.\n");
@@ -272,68 +335,18 @@ unsigned char *carmen_graphics_convert_to_image(carmen_map_p map, int flags)
   image_data = (unsigned char *)calloc(x_size*y_size*3, sizeof(unsigned char));
   carmen_test_alloc(image_data);
 
-  if (rescale) {
-    max_val = -MAXDOUBLE;
-    min_val = MAXDOUBLE;
-    data_ptr = map->complete_map;
-    for (index = 0; index < map->config.x_size*map->config.y_size; index++) {
-      max_val = carmen_fmax(max_val, *data_ptr);
-      if (*data_ptr >= 0)
-	min_val = carmen_fmin(min_val, *data_ptr);
-      data_ptr++;
-    }
-  }
+  if (flags & CARMEN_GRAPHICS_RESCALE)
+    carmen_graphics_get_map_range(map, &min_val, &max_val);
 
-  if (max_val < 0)
-    rescale = 0;
-  
   image_ptr = image_data;
   data_ptr = map->complete_map;
   for (x_index = 0; x_index < x_size; x_index++) {
     for (y_index = 0; y_index < y_size; y_index++) {
-      value = *(data_ptr++);	    
       if (rotate)
 	image_ptr = image_data+y_index*x_size*3+x_index;
-      if (value < 0 && value > -1.5) {
-	if (black_and_white) {
-	  *(image_ptr++) = 255;
-	  *(image_ptr++) = 255;
-	  *(image_ptr++) = 255;
-	} else {
-	  *(image_ptr++) = 0;
-	  *(image_ptr++) = 0;
-	  *(image_ptr++) = 255;
-	}
-      } 
-      else if (value < -1.5) { // for offlimits
-	if (black_and_white) {
-	  *(image_ptr++) = 205;
-	  *(image_ptr++) = 205;
-	  *(image_ptr++) = 205;
-	} else {
-	  *(image_ptr++) = 255;
-	  *(image_ptr++) = 0;
-	  *(image_ptr++) = 0;
-	}
-      } 
-      else if(!rescale && value > 1.0) {
-	if (black_and_white) {
-	  *(image_ptr++) = 128;
-	  *(image_ptr++) = 128;
-	  *(image_ptr++) = 128;
-	} else {
-	  *(image_ptr++) = 255;
-	  *(image_ptr++) = 0;
-	  *(image_ptr++) = 0;
-	}
-      } else {
-	if (rescale)
-	  value = (value - min_val) / (max_val - min_val);
-	if (!invert)
-	  value = 1 - value;
-	for (index = 0; index < 3; index++)
-	  *(image_ptr++) = value * 255;
-      }
+      carmen_graphics_convert_map_value(*(data_ptr++), flags, min_val,
+					max_val, image_ptr);
+      image_ptr += 3;
     }
   }
   return image_data;
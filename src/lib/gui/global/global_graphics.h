@@ -50,6 +50,38 @@ extern "C" {
     int ok;
   } carmen_graphics_callback;
 
+  typedef void (*carmen_graphics_redraw_func_t)(gpointer data);
+
+  typedef struct {
+    int num_requests;
+    int num_coalesced;
+    int num_skipped;
+    int num_frames;
+    double frame_rate;
+    double average_frame_time;
+    double max_frame_time;
+  } carmen_graphics_redraw_stats_t, *carmen_graphics_redraw_stats_p;
+
+  /* Redraw scheduler: coalesces redraw requests into frames rendered at
+     most at max_frame_rate, and skips rendering while the widget is
+     unmapped or fully obscured. A max_frame_rate of 0 disables the
+     rate limit. */
+  typedef struct {
+    GtkWidget *widget;
+    double max_frame_rate;
+    carmen_graphics_redraw_func_t redraw_func;
+    gpointer data;
+
+    int pending;
+    int obscured;
+    guint timeout_id;
+    double time_of_first_frame;
+    double time_of_last_frame;
+    double frame_time_sum;
+
+    carmen_graphics_redraw_stats_t stats;
+  } carmen_graphics_redraw_t, *carmen_graphics_redraw_p;
+
   extern GdkColor carmen_red, carmen_blue, carmen_white, carmen_yellow, 
     carmen_green, carmen_light_blue, carmen_black, carmen_orange, 
     carmen_grey, carmen_light_grey, carmen_purple;
@@ -71,9 +103,34 @@ extern "C" {
 					   int x, int y, int w, int h);
   void carmen_graphics_write_data_as_png(unsigned char *data, 
 					 char *user_filename, int w, int h);
+  carmen_graphics_redraw_p
+  carmen_graphics_redraw_new(GtkWidget *widget, double max_frame_rate,
+			     carmen_graphics_redraw_func_t redraw_func,
+			     gpointer data);
+  void carmen_graphics_redraw_free(carmen_graphics_redraw_p redraw);
+  void carmen_graphics_redraw_request(carmen_graphics_redraw_p redraw);
+  void carmen_graphics_redraw_flush(carmen_graphics_redraw_p redraw);
+  void carmen_graphics_redraw_set_frame_rate(carmen_graphics_redraw_p redraw,
+					     double max_frame_rate);
+  void carmen_graphics_redraw_get_stats(carmen_graphics_redraw_p redraw,
+					carmen_graphics_redraw_stats_p stats);
+  void carmen_graphics_redraw_print_stats(carmen_graphics_redraw_p redraw,
+					  FILE *stream);
+
   int carmen_map_image_to_map_color_unknown(unsigned char r, unsigned char g, 
 					    unsigned char b);
 
+  #ifndef NO_JPEG
+  int carmen_graphics_jpeg_compress(const unsigned char *pixels, int width,
+				    int height, int bytes_per_pixel, 
+				    int quality, unsigned char **data, 
+				    int *data_size);
+  int carmen_graphics_jpeg_decompress(const unsigned char *data, 
+				      int data_size, unsigned char *pixels,
+				      int width, int height, 
+				      int bytes_per_pixel);
+  #endif
+
   #ifndef COMPILE_WITHOUT_MAP_SUPPORT
 
   #ifndef NO_JPEG
@@ -81,6 +138,11 @@ extern "C" {
 					 int flags);
   #endif
 
+  void carmen_graphics_convert_map_value(double value, int flags,
+					 double min_val, double max_val,
+					 unsigned char *rgb);
+  void carmen_graphics_get_map_range(carmen_map_p map, double *min_val,
+				     double *max_val);
   unsigned char *carmen_graphics_convert_to_image(carmen_map_p map, int flags);
 
   carmen_map_p carmen_pixbuf_to_map(GdkPixbuf* pixbuf, double resolution);
@@ -27,6 +27,7 @@
  ********************************************************/
 
 #include <stdio.h>
+#include <setjmp.h>
 #include <jpeglib.h>
 
 #include "global.h"
@@ -74,3 +75,193 @@ carmen_graphics_write_map_as_jpeg(char *filename, carmen_map_p map, int flags)
   fclose(outfile);
   jpeg_destroy_compress(&cinfo);
 }
+
+/* In-memory compression and decompression, e.g. for camera images. The 
+   source and destination managers are spelled out since jpeg_mem_src() 
+   and jpeg_mem_dest() are missing from older versions of libjpeg. */
+
+typedef struct {
+  struct jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+} jpeg_error_t;
+
+typedef struct {
+  struct jpeg_destination_mgr pub;
+  unsigned char *buffer;
+  int size;
+} jpeg_destination_t;
+
+static void
+jpeg_error_exit(j_common_ptr cinfo)
+{
+  longjmp(((jpeg_error_t *)cinfo->err)->setjmp_buffer, 1);
+}
+
+static void
+jpeg_output_message(j_common_ptr cinfo __attribute__ ((unused)))
+{
+}
+
+static void
+jpeg_init_destination(j_compress_ptr cinfo)
+{
+  jpeg_destination_t *dest = (jpeg_destination_t *)cinfo->dest;
+
+  dest->pub.next_output_byte = dest->buffer;
+  dest->pub.free_in_buffer = dest->size;
+}
+
+static boolean
+jpeg_empty_output_buffer(j_compress_ptr cinfo)
+{
+  jpeg_destination_t *dest = (jpeg_destination_t *)cinfo->dest;
+  int used = dest->size;
+
+  /* libjpeg asks for more room only when the whole buffer is full */
+  dest->size *= 2;
+  dest->buffer = (unsigned char *)realloc(dest->buffer, dest->size);
+  carmen_test_alloc(dest->buffer);
+  dest->pub.next_output_byte = dest->buffer + used;
+  dest->pub.free_in_buffer = dest->size - used;
+
+  return TRUE;
+}
+
+static void
+jpeg_term_destination(j_compress_ptr cinfo __attribute__ ((unused)))
+{
+}
+
+static void
+jpeg_init_source(j_decompress_ptr cinfo __attribute__ ((unused)))
+{
+}
+
+static boolean
+jpeg_fill_input_buffer(j_decompress_ptr cinfo)
+{
+  static const JOCTET eoi[2] = {0xFF, JPEG_EOI};
+
+  /* Truncated data: end the image instead of waiting for more */
+  cinfo->src->next_input_byte = eoi;
+  cinfo->src->bytes_in_buffer = 2;
+  return TRUE;
+}
+
+static void
+jpeg_skip_input_data(j_decompress_ptr cinfo, long num_bytes)
+{
+  if (num_bytes <= 0)
+    return;
+  if ((size_t)num_bytes > cinfo->src->bytes_in_buffer)
+    num_bytes = cinfo->src->bytes_in_buffer;
+  cinfo->src->next_input_byte += num_bytes;
+  cinfo->src->bytes_in_buffer -= num_bytes;
+}
+
+static void
+jpeg_term_source(j_decompress_ptr cinfo __attribute__ ((unused)))
+{
+}
+
+int
+carmen_graphics_jpeg_compress(const unsigned char *pixels, int width, 
+			      int height, int bytes_per_pixel, int quality,
+			      unsigned char **data, int *data_size)
+{
+  struct jpeg_compress_struct cinfo;
+  jpeg_error_t jerr;
+  jpeg_destination_t dest;
+  JSAMPROW row_pointer[1];
+
+  if (bytes_per_pixel != 1 && bytes_per_pixel != 3)
+    return -1;
+
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = jpeg_error_exit;
+  jerr.pub.output_message = jpeg_output_message;
+  /* dest is set before setjmp: the error path must see its buffer */
+  dest.size = width*height*bytes_per_pixel / 4 + 1024;
+  dest.buffer = (unsigned char *)malloc(dest.size);
+  carmen_test_alloc(dest.buffer);
+  dest.pub.init_destination = jpeg_init_destination;
+  dest.pub.empty_output_buffer = jpeg_empty_output_buffer;
+  dest.pub.term_destination = jpeg_term_destination;
+  if (setjmp(jerr.setjmp_buffer)) {
+    jpeg_destroy_compress(&cinfo);
+    free(dest.buffer);
+    return -1;
+  }
+  jpeg_create_compress(&cinfo);
+  cinfo.dest = &dest.pub;
+
+  cinfo.image_width = width;
+  cinfo.image_height = height;
+  cinfo.input_components = bytes_per_pixel;
+  cinfo.in_color_space = (bytes_per_pixel == 3) ? JCS_RGB : JCS_GRAYSCALE;
+  jpeg_set_defaults(&cinfo);
+  if (quality > 0)
+    jpeg_set_quality(&cinfo, quality, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+
+  while (cinfo.next_scanline < cinfo.image_height) {
+    row_pointer[0] = (JSAMPROW)(pixels + 
+				cinfo.next_scanline*width*bytes_per_pixel);
+    jpeg_write_scanlines(&cinfo, row_pointer, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+
+  *data = dest.buffer;
+  *data_size = dest.size - dest.pub.free_in_buffer;
+  jpeg_destroy_compress(&cinfo);
+
+  return 0;
+}
+
+int
+carmen_graphics_jpeg_decompress(const unsigned char *data, int data_size,
+				unsigned char *pixels, int width, int height,
+				int bytes_per_pixel)
+{
+  struct jpeg_decompress_struct cinfo;
+  jpeg_error_t jerr;
+  struct jpeg_source_mgr src;
+  JSAMPROW row_pointer[1];
+
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = jpeg_error_exit;
+  jerr.pub.output_message = jpeg_output_message;
+  if (setjmp(jerr.setjmp_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    return -1;
+  }
+  jpeg_create_decompress(&cinfo);
+
+  src.next_input_byte = data;
+  src.bytes_in_buffer = data_size;
+  src.init_source = jpeg_init_source;
+  src.fill_input_buffer = jpeg_fill_input_buffer;
+  src.skip_input_data = jpeg_skip_input_data;
+  src.resync_to_restart = jpeg_resync_to_restart;
+  src.term_source = jpeg_term_source;
+  cinfo.src = &src;
+
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = (bytes_per_pixel == 3) ? JCS_RGB : JCS_GRAYSCALE;
+  jpeg_start_decompress(&cinfo);
+  if ((int)cinfo.output_width != width || 
+      (int)cinfo.output_height != height ||
+      cinfo.output_components != bytes_per_pixel) {
+    jpeg_destroy_decompress(&cinfo);
+    return -1;
+  }
+
+  while (cinfo.output_scanline < cinfo.output_height) {
+    row_pointer[0] = pixels + cinfo.output_scanline*width*bytes_per_pixel;
+    jpeg_read_scanlines(&cinfo, row_pointer, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+
+  return 0;
+}
@@ -0,0 +1,213 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+
+#include "global_graphics.h"
+
+static int
+redraw_viewable(carmen_graphics_redraw_p redraw)
+{
+  if (redraw->widget == NULL)
+    return 1;
+
+  return (redraw->widget->window != NULL &&
+	  gdk_window_is_viewable(redraw->widget->window) &&
+	  !redraw->obscured);
+}
+
+static void
+redraw_frame(carmen_graphics_redraw_p redraw)
+{
+  double frame_start, frame_time;
+
+  frame_start = carmen_get_time();
+  redraw->pending = 0;
+  (redraw->redraw_func)(redraw->data);
+  frame_time = carmen_get_time()-frame_start;
+
+  if (redraw->stats.num_frames == 0)
+    redraw->time_of_first_frame = frame_start;
+  redraw->time_of_last_frame = frame_start;
+
+  redraw->stats.num_frames++;
+  redraw->frame_time_sum += frame_time;
+  redraw->stats.average_frame_time = redraw->frame_time_sum/
+    redraw->stats.num_frames;
+  redraw->stats.max_frame_time = carmen_fmax(redraw->stats.max_frame_time,
+					     frame_time);
+  if (redraw->stats.num_frames > 1)
+    redraw->stats.frame_rate = (redraw->stats.num_frames-1)/
+      (redraw->time_of_last_frame-redraw->time_of_first_frame);
+}
+
+static gint
+redraw_timeout(gpointer data)
+{
+  carmen_graphics_redraw_p redraw = (carmen_graphics_redraw_p)data;
+
+  redraw->timeout_id = 0;
+
+  if (redraw->pending) {
+    if (redraw_viewable(redraw))
+      redraw_frame(redraw);
+    else
+      redraw->stats.num_skipped++;
+  }
+
+  return FALSE;
+}
+
+static void
+redraw_schedule(carmen_graphics_redraw_p redraw)
+{
+  double delay = 0.0;
+
+  if (redraw->timeout_id != 0)
+    return;
+
+  if (redraw->max_frame_rate > 0.0)
+    delay = carmen_fmax(0.0, redraw->time_of_last_frame+
+			1.0/redraw->max_frame_rate-carmen_get_time());
+
+  redraw->timeout_id = gtk_timeout_add(1e3*delay, redraw_timeout, redraw);
+}
+
+static gint
+redraw_visibility_event(GtkWidget *widget __attribute__ ((unused)),
+			GdkEventVisibility *event,
+			carmen_graphics_redraw_p redraw)
+{
+  redraw->obscured = (event->state == GDK_VISIBILITY_FULLY_OBSCURED);
+
+  if (redraw->pending && !redraw->obscured)
+    redraw_schedule(redraw);
+
+  return FALSE;
+}
+
+static gint
+redraw_map_event(GtkWidget *widget __attribute__ ((unused)),
+		 GdkEvent *event __attribute__ ((unused)),
+		 carmen_graphics_redraw_p redraw)
+{
+  if (redraw->pending)
+    redraw_schedule(redraw);
+
+  return FALSE;
+}
+
+carmen_graphics_redraw_p
+carmen_graphics_redraw_new(GtkWidget *widget, double max_frame_rate,
+			   carmen_graphics_redraw_func_t redraw_func,
+			   gpointer data)
+{
+  carmen_graphics_redraw_p redraw;
+
+  redraw = (carmen_graphics_redraw_p)calloc(1,
+    sizeof(carmen_graphics_redraw_t));
+  carmen_test_alloc(redraw);
+
+  redraw->widget = widget;
+  redraw->max_frame_rate = max_frame_rate;
+  redraw->redraw_func = redraw_func;
+  redraw->data = data;
+
+  if (widget != NULL) {
+    gtk_widget_add_events(widget, GDK_VISIBILITY_NOTIFY_MASK);
+    gtk_signal_connect(GTK_OBJECT(widget), "visibility_notify_event",
+		       GTK_SIGNAL_FUNC(redraw_visibility_event), redraw);
+    gtk_signal_connect(GTK_OBJECT(widget), "map_event",
+		       GTK_SIGNAL_FUNC(redraw_map_event), redraw);
+  }
+
+  return redraw;
+}
+
+void
+carmen_graphics_redraw_free(carmen_graphics_redraw_p redraw)
+{
+  if (redraw == NULL)
+    return;
+
+  if (redraw->timeout_id != 0)
+    gtk_timeout_remove(redraw->timeout_id);
+  if (redraw->widget != NULL)
+    gtk_signal_disconnect_by_data(GTK_OBJECT(redraw->widget), redraw);
+
+  free(redraw);
+}
+
+void
+carmen_graphics_redraw_request(carmen_graphics_redraw_p redraw)
+{
+  if (redraw->pending)
+    redraw->stats.num_coalesced++;
+  redraw->pending = 1;
+  redraw->stats.num_requests++;
+
+  redraw_schedule(redraw);
+}
+
+void
+carmen_graphics_redraw_flush(carmen_graphics_redraw_p redraw)
+{
+  if (redraw->timeout_id != 0) {
+    gtk_timeout_remove(redraw->timeout_id);
+    redraw->timeout_id = 0;
+  }
+
+  if (redraw->pending && redraw_viewable(redraw))
+    redraw_frame(redraw);
+}
+
+void
+carmen_graphics_redraw_set_frame_rate(carmen_graphics_redraw_p redraw,
+				      double max_frame_rate)
+{
+  redraw->max_frame_rate = max_frame_rate;
+}
+
+void
+carmen_graphics_redraw_get_stats(carmen_graphics_redraw_p redraw,
+				 carmen_graphics_redraw_stats_p stats)
+{
+  *stats = redraw->stats;
+}
+
+void
+carmen_graphics_redraw_print_stats(carmen_graphics_redraw_p redraw,
+				   FILE *stream)
+{
+  fprintf(stream, "%d redraw requests, %d coalesced, %d frames skipped "
+	  "while hidden\n", redraw->stats.num_requests,
+	  redraw->stats.num_coalesced, redraw->stats.num_skipped);
+  fprintf(stream, "%d frames at %.1f Hz, frame time %.2f ms average, "
+	  "%.2f ms max\n", redraw->stats.num_frames, redraw->stats.frame_rate,
+	  1e3*redraw->stats.average_frame_time,
+	  1e3*redraw->stats.max_frame_time);
+}
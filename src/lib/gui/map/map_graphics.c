@@ -139,45 +139,247 @@ recover_centre(GtkMapViewer *map_view, carmen_world_point_p new_centre)
   screen_to_world(&screen, new_centre, map_view);
 }
 
-static void pixbuf_destroyed(guchar *pixels,
-			     gpointer data __attribute__ ((unused)))
+static void
+clear_tile(carmen_map_graphics_tile_p tile)
 {
-  free(pixels);
+  if (tile->pixbuf != NULL) {
+    g_object_unref(tile->pixbuf);
+    tile->pixbuf = NULL;
+  }
+  if (tile->scaled_pixbuf != NULL) {
+    g_object_unref(tile->scaled_pixbuf);
+    tile->scaled_pixbuf = NULL;
+  }
 }
 
 static void
-regenerate_map_pixmap(GtkMapViewer *map_view)
+destroy_tile_cache(GtkMapViewer *map_view)
 {
-  int x_render_size, y_render_size;
-  unsigned char *image_data;
-  GdkPixbuf *image = NULL;
-  GdkPixbuf *rotated_image = NULL;
-  GdkPixbuf *final_image = NULL;
-  double x_ratio, y_ratio;
-  double scale_to_fit_window;
-  carmen_map_config_t config;
-  double zoom;
+  carmen_map_graphics_level_p level;
+  int level_index, tile_index;
+
+  for (level_index = 0; level_index < map_view->num_levels; level_index++) {
+    level = map_view->levels+level_index;
+    for (tile_index = 0; tile_index < level->x_tiles*level->y_tiles;
+	 tile_index++)
+      clear_tile(level->tiles+tile_index);
+    free(level->tiles);
+  }
+  free(map_view->levels);
 
-  if (map_view == NULL || map_view->internal_map == NULL)
-    return;
+  map_view->levels = NULL;
+  map_view->num_levels = 0;
+}
 
-  if (map_view->current_pixbuf != NULL) {
-    g_object_unref(map_view->current_pixbuf);
-    map_view->current_pixbuf = NULL;
+/* Builds an empty mipmap pyramid for the current map. Level 0 holds one
+   pixel per map cell, each further level halves the resolution until the
+   whole map fits into a single tile. Tile rows run top-down on screen,
+   i.e. row 0 corresponds to the largest map y. */
+static void
+create_tile_cache(GtkMapViewer *map_view)
+{
+  carmen_map_graphics_level_p level;
+  int width, height;
+
+  destroy_tile_cache(map_view);
+
+  width = map_view->internal_map->config.x_size;
+  height = map_view->internal_map->config.y_size;
+
+  do {
+    map_view->levels = (carmen_map_graphics_level_p)realloc
+      (map_view->levels, (map_view->num_levels+1)*
+       sizeof(carmen_map_graphics_level_t));
+    carmen_test_alloc(map_view->levels);
+
+    level = map_view->levels+map_view->num_levels;
+    level->width = width;
+    level->height = height;
+    level->x_tiles = (width+CARMEN_MAP_GRAPHICS_TILE_SIZE-1)/
+      CARMEN_MAP_GRAPHICS_TILE_SIZE;
+    level->y_tiles = (height+CARMEN_MAP_GRAPHICS_TILE_SIZE-1)/
+      CARMEN_MAP_GRAPHICS_TILE_SIZE;
+    level->tiles = (carmen_map_graphics_tile_p)calloc
+      (level->x_tiles*level->y_tiles, sizeof(carmen_map_graphics_tile_t));
+    carmen_test_alloc(level->tiles);
+    map_view->num_levels++;
+
+    width = (width+1)/2;
+    height = (height+1)/2;
+  } while (level->x_tiles > 1 || level->y_tiles > 1);
+
+  map_view->tile_rescale_size = 0;
+  if (map_view->draw_flags & CARMEN_GRAPHICS_RESCALE)
+    carmen_graphics_get_map_range(map_view->internal_map, &map_view->min_val,
+				  &map_view->max_val);
+}
+
+/* Invalidates a tile together with all coarser tiles covering it */
+static void
+invalidate_tile(GtkMapViewer *map_view, int level_index, int x_tile,
+		int y_tile)
+{
+  carmen_map_graphics_level_p level;
+
+  for (; level_index < map_view->num_levels; level_index++) {
+    level = map_view->levels+level_index;
+    clear_tile(level->tiles+y_tile*level->x_tiles+x_tile);
+    x_tile /= 2;
+    y_tile /= 2;
   }
+}
 
-  image_data = carmen_graphics_convert_to_image(map_view->internal_map,
-						map_view->draw_flags);
+static void
+invalidate_scaled_tiles(GtkMapViewer *map_view, int all)
+{
+  carmen_map_graphics_level_p level;
+  carmen_map_graphics_tile_p tile;
+  int level_index, tile_index;
+
+  for (level_index = 0; level_index < map_view->num_levels; level_index++) {
+    level = map_view->levels+level_index;
+    for (tile_index = 0; tile_index < level->x_tiles*level->y_tiles;
+	 tile_index++) {
+      tile = level->tiles+tile_index;
+      if (tile->scaled_pixbuf != NULL &&
+	  (all || tile->frame != map_view->frame)) {
+	g_object_unref(tile->scaled_pixbuf);
+	tile->scaled_pixbuf = NULL;
+      }
+    }
+  }
+}
 
-  config = (map_view->internal_map)->config;
+static void
+render_base_tile(GtkMapViewer *map_view, GdkPixbuf *pixbuf, int x_tile,
+		 int y_tile)
+{
+  int x_index, y_index, x, y;
+  int width, height, rowstride;
+  guchar *pixels;
+  float *column;
+
+  width = gdk_pixbuf_get_width(pixbuf);
+  height = gdk_pixbuf_get_height(pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+  pixels = gdk_pixbuf_get_pixels(pixbuf);
+
+  for (x_index = 0; x_index < width; x_index++) {
+    x = x_tile*CARMEN_MAP_GRAPHICS_TILE_SIZE+x_index;
+    y = map_view->internal_map->config.y_size-1-
+      y_tile*CARMEN_MAP_GRAPHICS_TILE_SIZE;
+    column = map_view->internal_map->map[x];
+    for (y_index = 0; y_index < height; y_index++, y--)
+      carmen_graphics_convert_map_value(column[y], map_view->draw_flags,
+					map_view->min_val, map_view->max_val,
+					pixels+y_index*rowstride+3*x_index);
+  }
+}
+
+static GdkPixbuf *get_tile_pixbuf(GtkMapViewer *map_view, int level_index,
+				  int x_tile, int y_tile);
+
+/* Averages the 2x2 pixel blocks of the finer level into a tile */
+static void
+render_pyramid_tile(GtkMapViewer *map_view, GdkPixbuf *pixbuf,
+		    int level_index, int x_tile, int y_tile)
+{
+  carmen_map_graphics_level_p child_level;
+  GdkPixbuf *children[2][2];
+  guchar *child_pixels[2][2], *pixels, *pixel;
+  int child_rowstride[2][2], rowstride;
+  int width, height, x_index, y_index, x_child, y_child;
+  int x, y, dx, dy, channel, count, sum[3];
+
+  child_level = map_view->levels+level_index-1;
+  for (x_child = 0; x_child < 2; x_child++)
+    for (y_child = 0; y_child < 2; y_child++) {
+      children[x_child][y_child] = NULL;
+      if (2*x_tile+x_child < child_level->x_tiles &&
+	  2*y_tile+y_child < child_level->y_tiles) {
+	children[x_child][y_child] = get_tile_pixbuf
+	  (map_view, level_index-1, 2*x_tile+x_child, 2*y_tile+y_child);
+	child_pixels[x_child][y_child] =
+	  gdk_pixbuf_get_pixels(children[x_child][y_child]);
+	child_rowstride[x_child][y_child] =
+	  gdk_pixbuf_get_rowstride(children[x_child][y_child]);
+      }
+    }
+
+  width = gdk_pixbuf_get_width(pixbuf);
+  height = gdk_pixbuf_get_height(pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+  pixels = gdk_pixbuf_get_pixels(pixbuf);
+
+  for (y_index = 0; y_index < height; y_index++)
+    for (x_index = 0; x_index < width; x_index++) {
+      x_child = 2*x_index/CARMEN_MAP_GRAPHICS_TILE_SIZE;
+      y_child = 2*y_index/CARMEN_MAP_GRAPHICS_TILE_SIZE;
+      x = 2*x_index%CARMEN_MAP_GRAPHICS_TILE_SIZE;
+      y = 2*y_index%CARMEN_MAP_GRAPHICS_TILE_SIZE;
+
+      count = 0;
+      sum[0] = sum[1] = sum[2] = 0;
+      for (dx = 0; dx < 2; dx++)
+	for (dy = 0; dy < 2; dy++) {
+	  if (x+dx >= gdk_pixbuf_get_width(children[x_child][y_child]) ||
+	      y+dy >= gdk_pixbuf_get_height(children[x_child][y_child]))
+	    continue;
+	  pixel = child_pixels[x_child][y_child]+
+	    (y+dy)*child_rowstride[x_child][y_child]+3*(x+dx);
+	  for (channel = 0; channel < 3; channel++)
+	    sum[channel] += pixel[channel];
+	  count++;
+	}
+
+      pixel = pixels+y_index*rowstride+3*x_index;
+      for (channel = 0; channel < 3; channel++)
+	pixel[channel] = sum[channel]/count;
+    }
+}
 
-  image = gdk_pixbuf_new_from_data((guchar *)image_data, GDK_COLORSPACE_RGB,
-				   FALSE, 8,  config.y_size, config.x_size,
-				   config.y_size*3, pixbuf_destroyed, NULL);
+static GdkPixbuf *
+get_tile_pixbuf(GtkMapViewer *map_view, int level_index, int x_tile,
+		int y_tile)
+{
+  carmen_map_graphics_level_p level;
+  carmen_map_graphics_tile_p tile;
+  int width, height;
 
-  rotated_image = gdk_pixbuf_rotate_simple
-    (image, GDK_PIXBUF_ROTATE_COUNTERCLOCKWISE);
-  g_object_unref(image);
+  level = map_view->levels+level_index;
+  tile = level->tiles+y_tile*level->x_tiles+x_tile;
+
+  if (tile->pixbuf == NULL) {
+    width = carmen_fmin(CARMEN_MAP_GRAPHICS_TILE_SIZE,
+			level->width-x_tile*CARMEN_MAP_GRAPHICS_TILE_SIZE);
+    height = carmen_fmin(CARMEN_MAP_GRAPHICS_TILE_SIZE,
+			 level->height-y_tile*CARMEN_MAP_GRAPHICS_TILE_SIZE);
+
+    tile->pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, width,
+				  height);
+    if (tile->pixbuf == NULL)
+      carmen_die("Requested pixbuf of size %d x %d failed.\n", width,
+		 height);
+
+    if (level_index == 0)
+      render_base_tile(map_view, tile->pixbuf, x_tile, y_tile);
+    else
+      render_pyramid_tile(map_view, tile->pixbuf, level_index, x_tile,
+			  y_tile);
+  }
+
+  return tile->pixbuf;
+}
+
+static void
+update_rescale_size(GtkMapViewer *map_view)
+{
+  double x_ratio, y_ratio;
+  double scale_to_fit_window;
+  carmen_map_config_t config;
+  double zoom;
+
+  config = (map_view->internal_map)->config;
 
   x_ratio = map_view->port_size_x / (double)config.x_size;
   y_ratio = map_view->port_size_y / (double)config.y_size;
@@ -186,13 +388,74 @@ regenerate_map_pixmap(GtkMapViewer *map_view)
   zoom = 100.0/map_view->zoom;
   map_view->rescale_size = scale_to_fit_window*zoom;
 
-  x_render_size = map_view->rescale_size*config.x_size;
-  y_render_size = map_view->rescale_size*config.y_size;
+  map_view->x_render_size = map_view->rescale_size*config.x_size;
+  map_view->y_render_size = map_view->rescale_size*config.y_size;
 
-  final_image = gdk_pixbuf_scale_simple(rotated_image, x_render_size,
-					y_render_size, GDK_INTERP_TILES);
-  map_view->current_pixbuf = final_image;
-  g_object_unref(rotated_image);
+  if (map_view->rescale_size != map_view->tile_rescale_size) {
+    invalidate_scaled_tiles(map_view, 1);
+    map_view->tile_rescale_size = map_view->rescale_size;
+  }
+}
+
+/* Draws the tiles intersecting the viewport from the coarsest pyramid
+   level that still provides at least one pixel per screen pixel. Only
+   these tiles are rendered and scaled, the scaled versions are kept as
+   long as they remain visible at the same zoom. */
+static void
+draw_map_tiles(GtkMapViewer *map_view, GdkGC *gc)
+{
+  carmen_map_graphics_level_p level;
+  carmen_map_graphics_tile_p tile;
+  int level_index, cells_per_tile;
+  int x_tile, y_tile, x_min, x_max, y_min, y_max;
+  int x_start, y_start, x_end, y_end;
+  double left, top, scale;
+
+  scale = map_view->rescale_size;
+  for (level_index = 0; level_index < map_view->num_levels-1 &&
+	 (2 << level_index)*scale <= 1.0; level_index++);
+  level = map_view->levels+level_index;
+  cells_per_tile = CARMEN_MAP_GRAPHICS_TILE_SIZE << level_index;
+
+  left = map_view->x_scroll_adj->value;
+  top = map_view->y_scroll_adj->value;
+
+  x_min = carmen_fmax(0, floor(left/scale)/cells_per_tile);
+  y_min = carmen_fmax(0, floor(top/scale)/cells_per_tile);
+  x_max = carmen_fmin(level->x_tiles-1,
+		      floor((left+map_view->port_size_x)/scale)/
+		      cells_per_tile);
+  y_max = carmen_fmin(level->y_tiles-1,
+		      floor((top+map_view->port_size_y)/scale)/
+		      cells_per_tile);
+
+  map_view->frame++;
+
+  for (x_tile = x_min; x_tile <= x_max; x_tile++)
+    for (y_tile = y_min; y_tile <= y_max; y_tile++) {
+      tile = level->tiles+y_tile*level->x_tiles+x_tile;
+
+      x_start = floor(x_tile*cells_per_tile*scale);
+      y_start = floor(y_tile*cells_per_tile*scale);
+      x_end = floor(carmen_fmin((x_tile+1)*cells_per_tile,
+				map_view->internal_map->config.x_size)*scale);
+      y_end = floor(carmen_fmin((y_tile+1)*cells_per_tile,
+				map_view->internal_map->config.y_size)*scale);
+      if (x_end <= x_start || y_end <= y_start)
+	continue;
+
+      if (tile->scaled_pixbuf == NULL)
+	tile->scaled_pixbuf = gdk_pixbuf_scale_simple
+	  (get_tile_pixbuf(map_view, level_index, x_tile, y_tile),
+	   x_end-x_start, y_end-y_start, GDK_INTERP_TILES);
+      tile->frame = map_view->frame;
+
+      gdk_draw_pixbuf(map_view->drawing_pixmap, gc, tile->scaled_pixbuf,
+		      0, 0, x_start-left, y_start-top, x_end-x_start,
+		      y_end-y_start, GDK_RGB_DITHER_NONE, 0, 0);
+    }
+
+  invalidate_scaled_tiles(map_view, 0);
 }
 
 static void
@@ -201,10 +464,6 @@ redraw (GtkMapViewer *map_view, int map_changed, int viewport_changed)
   GdkPixmap *drawing_pixmap;
 
   GtkWidget *widget;
-  int width, height;
-  int x_render_size, y_render_size;
-  carmen_map_config_t config;
-  carmen_point_t top_left;
 
   widget = map_view->image_widget;
   if (widget == NULL || widget->window == NULL)
@@ -216,8 +475,8 @@ redraw (GtkMapViewer *map_view, int map_changed, int viewport_changed)
   if (!map_view->window)
     return;
 
-  if (map_changed)
-    regenerate_map_pixmap(map_view);
+  if (map_changed || map_view->tile_rescale_size == 0)
+    update_rescale_size(map_view);
 
   if (!map_view->drawing_pixmap || viewport_changed) {
     if (map_view->drawing_pixmap) {
@@ -252,34 +511,7 @@ redraw (GtkMapViewer *map_view, int map_changed, int viewport_changed)
   gdk_draw_rectangle (drawing_pixmap, map_view->drawing_gc, TRUE, 0, 0,
                       map_view->port_size_x, map_view->port_size_y);
 
-  config = map_view->internal_map->config;
-  width = config.x_size;
-  height = config.y_size;
-
-  if (map_view->current_pixbuf) {
-    top_left.x = map_view->x_scroll_adj->value;
-    top_left.y = map_view->y_scroll_adj->value;
-
-    if (top_left.x + map_view->port_size_x >
-	gdk_pixbuf_get_width(map_view->current_pixbuf))
-      x_render_size = gdk_pixbuf_get_width(map_view->current_pixbuf) -
-	top_left.x;
-    else
-      x_render_size = map_view->port_size_x;
-
-    if (top_left.y + map_view->port_size_y >
-	gdk_pixbuf_get_height(map_view->current_pixbuf))
-      y_render_size = gdk_pixbuf_get_height(map_view->current_pixbuf) -
-	top_left.y;
-    else
-      y_render_size = map_view->port_size_y;
-
-    gdk_draw_pixbuf(map_view->drawing_pixmap,
-		    widget->style->fg_gc[GTK_WIDGET_STATE (widget)],
-		    map_view->current_pixbuf, top_left.x, top_left.y,
-		    0, 0, x_render_size, y_render_size,
-		    GDK_RGB_DITHER_NONE, 0, 0);
-  }
+  draw_map_tiles(map_view, widget->style->fg_gc[GTK_WIDGET_STATE (widget)]);
 
   if (map_view->user_draw_routine != NULL)
     (map_view->user_draw_routine)(map_view);
@@ -291,6 +523,11 @@ redraw (GtkMapViewer *map_view, int map_changed, int viewport_changed)
 		  map_view->y_scroll_adj->value, -1, -1);
 }
 
+static void scheduled_redraw(gpointer data)
+{
+  redraw((GtkMapViewer *)data, 0, 0);
+}
+
 static void set_drawing_area_size(GtkMapViewer *map_view)
 {
   double zoom = 100/map_view->zoom;
@@ -530,6 +767,9 @@ carmen_map_graphics_new_viewer(int x_size, int y_size, double initial_zoom)
   gtk_widget_show(map_box);
 
   construct_image(x_size, y_size, map_box, new_map_view);
+  new_map_view->redraw_scheduler = carmen_graphics_redraw_new
+    (new_map_view->image_widget, CARMEN_MAP_GRAPHICS_DEFAULT_FRAME_RATE,
+     scheduled_redraw, new_map_view);
 
   zoom_box = gtk_hbox_new(FALSE, 0);
   gtk_box_pack_start(GTK_BOX(map_box), zoom_box, FALSE, FALSE, 0);
@@ -568,6 +808,7 @@ carmen_map_graphics_add_map(GtkMapViewer *map_view, carmen_map_p new_map,
   if (new_map != NULL) {
     map_view->internal_map = carmen_map_copy(new_map);
     map_view->draw_flags = new_flags;
+    create_tile_cache(map_view);
   }
 
   point.pose.x = (new_map->config.x_size*3/4)*new_map->config.resolution;
@@ -581,19 +822,55 @@ carmen_map_graphics_add_map(GtkMapViewer *map_view, carmen_map_p new_map,
   redraw(map_view, 1, 0);
 }
 
+/* Only the tiles covering modified cells are invalidated, unless the
+   drawing flags or the range of a rescaled map change */
 void
 carmen_map_graphics_modify_map(GtkMapViewer *map_view, float *data,
 			       int new_flags)
 {
   carmen_map_config_t config;
+  double min_val, max_val;
+  int x_tile, y_tile, x, y_min, y_max;
+  float *column, *new_column;
 
   if (map_view->internal_map == NULL)
     return;
 
   config = map_view->internal_map->config;
-  memcpy(map_view->internal_map->complete_map, data,
-	 sizeof(float)*config.x_size*config.y_size);
-  map_view->draw_flags = new_flags;
+
+  if (new_flags != map_view->draw_flags) {
+    memcpy(map_view->internal_map->complete_map, data,
+	   sizeof(float)*config.x_size*config.y_size);
+    map_view->draw_flags = new_flags;
+    create_tile_cache(map_view);
+  } else {
+    for (x_tile = 0; x_tile < map_view->levels[0].x_tiles; x_tile++)
+      for (y_tile = 0; y_tile < map_view->levels[0].y_tiles; y_tile++) {
+	y_max = config.y_size-1-y_tile*CARMEN_MAP_GRAPHICS_TILE_SIZE;
+	y_min = carmen_fmax(0, y_max-CARMEN_MAP_GRAPHICS_TILE_SIZE+1);
+
+	for (x = x_tile*CARMEN_MAP_GRAPHICS_TILE_SIZE; x < config.x_size &&
+	       x < (x_tile+1)*CARMEN_MAP_GRAPHICS_TILE_SIZE; x++) {
+	  column = map_view->internal_map->map[x]+y_min;
+	  new_column = data+x*config.y_size+y_min;
+	  if (memcmp(column, new_column, (y_max-y_min+1)*sizeof(float))) {
+	    invalidate_tile(map_view, 0, x_tile, y_tile);
+	    break;
+	  }
+	}
+	for (; x < config.x_size &&
+	       x < (x_tile+1)*CARMEN_MAP_GRAPHICS_TILE_SIZE; x++)
+	  memcpy(map_view->internal_map->map[x]+y_min,
+		 data+x*config.y_size+y_min, (y_max-y_min+1)*sizeof(float));
+      }
+
+    if (map_view->draw_flags & CARMEN_GRAPHICS_RESCALE) {
+      carmen_graphics_get_map_range(map_view->internal_map, &min_val,
+				    &max_val);
+      if (min_val != map_view->min_val || max_val != map_view->max_val)
+	create_tile_cache(map_view);
+    }
+  }
 
   redraw(map_view, 1, 0);
 }
@@ -891,28 +1168,13 @@ carmen_map_graphics_add_button_press_event(GtkMapViewer *map_view,
 void
 carmen_map_graphics_redraw(GtkMapViewer *map_view)
 {
-  static double time_of_last_redraw = 0;
-  static double average = 0;
-  static int count = 0;
-  static double time_of_last_warning = 0;
-  double difference;
-
-  difference = carmen_get_time() - time_of_last_redraw;
-  if (count > 0) {
-    average += difference;
-    if ((average / count) < 0.1 && carmen_get_time() -
-	time_of_last_warning > 10) {
-      carmen_warn("carmen_map_graphics_redraw requests average more "
-		  "than 10 Hz.\nX will not be able to keep up with these "
-		  "requests. This is a bug\nand needs to be fixed.\n\n");
-      time_of_last_warning = carmen_get_time();
-    }
-  }
-  else
-    average = difference;
-
-  redraw(map_view, 0, 0);
+  carmen_graphics_redraw_request(map_view->redraw_scheduler);
+}
 
-  time_of_last_redraw = carmen_get_time();
-  count++;
+void
+carmen_map_graphics_set_frame_rate(GtkMapViewer *map_view,
+				   double max_frame_rate)
+{
+  carmen_graphics_redraw_set_frame_rate(map_view->redraw_scheduler,
+					max_frame_rate);
 }
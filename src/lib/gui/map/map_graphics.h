@@ -39,6 +39,24 @@ extern "C" {
 
 #include "global_graphics.h"
 
+/* Side length of a map tile in pixels. Tiles of pyramid level l cover
+   (CARMEN_MAP_GRAPHICS_TILE_SIZE << l) map cells per side. */
+#define CARMEN_MAP_GRAPHICS_TILE_SIZE 256
+
+#define CARMEN_MAP_GRAPHICS_DEFAULT_FRAME_RATE 10.0
+
+typedef struct {
+  GdkPixbuf *pixbuf;
+  GdkPixbuf *scaled_pixbuf;
+  int frame;
+} carmen_map_graphics_tile_t, *carmen_map_graphics_tile_p;
+
+typedef struct {
+  int width, height;
+  int x_tiles, y_tiles;
+  carmen_map_graphics_tile_p tiles;
+} carmen_map_graphics_level_t, *carmen_map_graphics_level_p;
+
 typedef struct {
   carmen_map_t * internal_map;
   int draw_flags;
@@ -46,6 +64,7 @@ typedef struct {
   double zoom;
   int port_size_x, port_size_y;
   double rescale_size;
+  int x_render_size, y_render_size;
 
   GtkWidget *image_widget;
   GtkWidget *map_box;
@@ -56,7 +75,11 @@ typedef struct {
   art_buffer_p art_buffer;
   art_context_p art_context;
 #else
-  GdkPixbuf *current_pixbuf;
+  carmen_map_graphics_level_p levels;
+  int num_levels;
+  double min_val, max_val;
+  double tile_rescale_size;
+  int frame;
   GdkGC *drawing_gc;
 #endif
   GdkPixmap *drawing_pixmap;
@@ -64,6 +87,7 @@ typedef struct {
   GtkAdjustment *x_scroll_adj;
   GtkAdjustment *y_scroll_adj;
   int button_two_down;
+  carmen_graphics_redraw_p redraw_scheduler;
   void (*user_draw_routine)();
   void (*motion_handler)();
   void (*button_release_handler)();
@@ -90,6 +114,8 @@ void carmen_map_graphics_adjust_scrollbars(GtkMapViewer *map_view,
 					   carmen_world_point_p new_centre);
 
 void carmen_map_graphics_redraw(GtkMapViewer *map_view);
+void carmen_map_graphics_set_frame_rate(GtkMapViewer *map_view,
+					double max_frame_rate);
 void carmen_map_graphics_draw_arc(GtkMapViewer *map_view, GdkColor *colour,
 				  int filled, carmen_world_point_p world_point,
 				  double radius,int start, int delta);
@@ -48,7 +48,6 @@ Cursor gdk_x11_cursor_get_xcursor (GdkCursor *cursor);
 #define BUTTON_HEIGHT 30
 #define GRADIENT_COLORS 40
 
-#define ALWAYS_REDRAW 1
 
 #define DEFAULT_ROBOT_COLOUR carmen_red
 #define DEFAULT_GOAL_COLOUR carmen_yellow
@@ -79,7 +78,6 @@ static carmen_list_t *place_action_uids = NULL;
 static carmen_list_t *goal_actions = NULL;
 static carmen_list_t *start_actions = NULL;
 
-static double time_of_last_redraw = 0;
 static int display_needs_updating = 0;
 static int num_path_points;
 static carmen_world_point_t *path = NULL;
@@ -102,7 +100,7 @@ static double last_navigator_update = 0;
 static double last_simulator_update = 0;
 
 static carmen_localize_globalpos_message *globalpos;
-static carmen_localize_particle_message particle_msg;
+static carmen_localize_compact_particle_message particle_msg;
 static carmen_localize_sensor_message sensor_msg;
 GdkColor RedBlueGradient[GRADIENT_COLORS];
 
@@ -161,6 +159,9 @@ delete_event(GtkWidget *widget, GdkEvent *event, gpointer data)
 {
   widget = widget; event = event; data = data;
 
+  if (carmen_carp_get_verbose())
+    carmen_graphics_redraw_print_stats(map_view->redraw_scheduler, stderr);
+
   gtk_main_quit ();
 }
 
@@ -397,12 +398,12 @@ switch_localize_display(GtkAction *action,
     nav_panel_config->show_particles = gtk_toggle_action_get_active(toggle);
     if (nav_panel_config->show_particles == 1 &&
 	!nav_panel_config->show_gaussians)
-      carmen_localize_subscribe_particle_message
+      carmen_localize_subscribe_compact_particle_message
 	(&particle_msg, NULL, CARMEN_SUBSCRIBE_LATEST);
     else if (!nav_panel_config->show_particles &&
 	     !nav_panel_config->show_gaussians)
-      carmen_localize_subscribe_particle_message(NULL, NULL,
-						 CARMEN_UNSUBSCRIBE);
+      carmen_localize_subscribe_compact_particle_message(NULL, NULL,
+							 CARMEN_UNSUBSCRIBE);
   } else if (strcmp(name, "ShowGaussians") == 0) {
     toggle = GTK_TOGGLE_ACTION(action);
     nav_panel_config->show_gaussians = gtk_toggle_action_get_active(toggle);
@@ -669,7 +670,7 @@ static GtkWidget *get_main_menu(void)
     (GTK_TOGGLE_ACTION(action), nav_panel_config->show_simulator_objects);
 
   if (nav_panel_config->show_particles || nav_panel_config->show_gaussians)
-    carmen_localize_subscribe_particle_message
+    carmen_localize_subscribe_compact_particle_message
       (&particle_msg, NULL, CARMEN_SUBSCRIBE_LATEST);
   if (nav_panel_config->show_lasers)
     carmen_localize_subscribe_sensor_message(&sensor_msg, NULL,
@@ -708,13 +709,10 @@ static GtkWidget *construct_status_frame(GtkWidget *parent)
 
 static void do_redraw(void)
 {
-  if (display_needs_updating &&
-      (carmen_get_time() - time_of_last_redraw > 0.3 || ALWAYS_REDRAW))
-    {
-      carmen_map_graphics_redraw(map_view);
-      time_of_last_redraw = carmen_get_time();
-      display_needs_updating = 0;
-    }
+  if (display_needs_updating) {
+    carmen_map_graphics_redraw(map_view);
+    display_needs_updating = 0;
+  }
 }
 
 static int received_robot_pose(void)
@@ -734,8 +732,10 @@ static void draw_particles(GtkMapViewer *the_map_view, double pixel_size)
   map_particle.map = the_map_view->internal_map;
 
   for(index = 0; index < particle_msg.num_particles; index++) {
-    particle.pose.x = particle_msg.particles[index].x;
-    particle.pose.y = particle_msg.particles[index].y;
+    particle.pose.x = particle_msg.globalpos.x + 
+      particle_msg.particles[index].x * particle_msg.xy_resolution;
+    particle.pose.y = particle_msg.globalpos.y + 
+      particle_msg.particles[index].y * particle_msg.xy_resolution;
     particle.map = the_map_view->internal_map;
     carmen_map_graphics_draw_circle(the_map_view, &robot_colour, TRUE,
 				    &particle, pixel_size);
@@ -1319,10 +1319,8 @@ save_image(gpointer data __attribute__ ((unused)),
 
   x_start = map_view->x_scroll_adj->value;
   y_start = map_view->y_scroll_adj->value;
-  x_size = carmen_fmin(gdk_pixbuf_get_width(map_view->current_pixbuf),
-		       map_view->port_size_x);
-  y_size = carmen_fmin(gdk_pixbuf_get_height(map_view->current_pixbuf),
-		       map_view->port_size_y);
+  x_size = carmen_fmin(map_view->x_render_size, map_view->port_size_x);
+  y_size = carmen_fmin(map_view->y_render_size, map_view->port_size_y);
 
   sprintf(filename, "%s%02d.png",
 	  carmen_extract_filename(map_view->internal_map->config.map_name),
@@ -1398,6 +1396,8 @@ navigator_graphics_init(int argc, char *argv[],
   gtk_container_add (GTK_CONTAINER (main_box), panel_box);
 
   map_view = carmen_map_graphics_new_viewer(400, 400, nav_panel_config->initial_map_zoom);
+  carmen_map_graphics_set_frame_rate(map_view,
+				     nav_panel_config->max_frame_rate);
   gtk_box_pack_start(GTK_BOX (panel_box), map_view->map_box, TRUE, TRUE, 0);
 
   carmen_map_graphics_add_motion_event
@@ -37,6 +37,7 @@ extern "C" {
 
   typedef struct {
     double initial_map_zoom;
+    double max_frame_rate;
     int track_robot;
     int draw_waypoints;
     int show_particles;
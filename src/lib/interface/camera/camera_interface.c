@@ -26,13 +26,190 @@
  *
  ********************************************************/
 
+#ifndef NO_ZLIB
+#include <zlib.h>
+#endif
+
 #include "global.h"
+#include "param_interface.h"
 #include "camera_messages.h"
 #include "camera_interface.h"
+#include "camera_shared.h"
 
 static carmen_camera_image_message *image_message_pointer_external = NULL;
 static carmen_handler_t image_message_handler_external = NULL;
 
+/* Set if image_message_pointer_external->image points into a shared 
+   memory segment rather than to memory of its own. */
+static int image_in_shared_memory = 0;
+
+static carmen_camera_shared_p subscriber_segment = NULL;
+static carmen_camera_shared_p publisher_segment = NULL;
+
+#ifndef NO_ZLIB
+
+/* Lossless encoding: the difference of each byte to the same channel of
+   the pixel to its left compresses far better than the pixels 
+   themselves. */
+
+static int
+deflate_encode(const unsigned char *pixels, int width, int height, 
+	       int bytes_per_pixel, int quality __attribute__ ((unused)), 
+	       unsigned char **data, int *data_size)
+{
+  unsigned char *differences;
+  uLongf compressed_size;
+  int row_size = width*bytes_per_pixel, x, y, err;
+
+  differences = (unsigned char *)malloc(row_size*height);
+  carmen_test_alloc(differences);
+  for (y = 0; y < height; y++) {
+    const unsigned char *row = pixels + y*row_size;
+    unsigned char *difference_row = differences + y*row_size;
+    for (x = 0; x < bytes_per_pixel && x < row_size; x++)
+      difference_row[x] = row[x];
+    for (; x < row_size; x++)
+      difference_row[x] = row[x] - row[x-bytes_per_pixel];
+  }
+
+  compressed_size = compressBound(row_size*height);
+  *data = (unsigned char *)malloc(compressed_size);
+  carmen_test_alloc(*data);
+  err = compress2(*data, &compressed_size, differences, row_size*height, 
+		  Z_BEST_SPEED);
+  free(differences);
+  if (err != Z_OK) {
+    free(*data);
+    *data = NULL;
+    return -1;
+  }
+
+  *data_size = compressed_size;
+  return 0;
+}
+
+static int
+deflate_decode(const unsigned char *data, int data_size, 
+	       unsigned char *pixels, int width, int height, 
+	       int bytes_per_pixel)
+{
+  uLongf image_size = width*height*bytes_per_pixel;
+  int row_size = width*bytes_per_pixel, x, y;
+
+  if (uncompress(pixels, &image_size, data, data_size) != Z_OK ||
+      image_size != (uLongf)(row_size*height))
+    return -1;
+
+  for (y = 0; y < height; y++) {
+    unsigned char *row = pixels + y*row_size;
+    for (x = bytes_per_pixel; x < row_size; x++)
+      row[x] += row[x-bytes_per_pixel];
+  }
+
+  return 0;
+}
+
+#endif
+
+static carmen_camera_encoder_t encoders[CARMEN_CAMERA_NUM_ENCODINGS] = {
+  NULL, NULL, 
+#ifndef NO_ZLIB
+  deflate_encode
+#else
+  NULL
+#endif
+};
+
+static carmen_camera_decoder_t decoders[CARMEN_CAMERA_NUM_ENCODINGS] = {
+  NULL, NULL, 
+#ifndef NO_ZLIB
+  deflate_decode
+#else
+  NULL
+#endif
+};
+
+void
+carmen_camera_register_codec(carmen_camera_encoding_t encoding,
+			     carmen_camera_encoder_t encoder,
+			     carmen_camera_decoder_t decoder)
+{
+  if (encoding <= CARMEN_CAMERA_ENCODING_RAW || 
+      encoding >= CARMEN_CAMERA_NUM_ENCODINGS)
+    return;
+
+  encoders[encoding] = encoder;
+  decoders[encoding] = decoder;
+}
+
+int
+carmen_camera_encoding_from_name(const char *name)
+{
+  if (name == NULL)
+    return -1;
+  if (carmen_strcasecmp(name, "raw") == 0)
+    return CARMEN_CAMERA_ENCODING_RAW;
+  if (carmen_strcasecmp(name, "jpeg") == 0)
+    return CARMEN_CAMERA_ENCODING_JPEG;
+  if (carmen_strcasecmp(name, "deflate") == 0)
+    return CARMEN_CAMERA_ENCODING_DEFLATE;
+  return -1;
+}
+
+int
+carmen_camera_encode(carmen_camera_encoding_t encoding, 
+		     const unsigned char *pixels, int width, int height, 
+		     int bytes_per_pixel, int quality, 
+		     unsigned char **data, int *data_size)
+{
+  if (encoding == CARMEN_CAMERA_ENCODING_RAW) {
+    *data_size = width*height*bytes_per_pixel;
+    *data = (unsigned char *)malloc(*data_size);
+    carmen_test_alloc(*data);
+    memcpy(*data, pixels, *data_size);
+    return 0;
+  }
+  if (encoding < 0 || encoding >= CARMEN_CAMERA_NUM_ENCODINGS || 
+      encoders[encoding] == NULL)
+    return -1;
+
+  return encoders[encoding](pixels, width, height, bytes_per_pixel, quality,
+			    data, data_size);
+}
+
+int
+carmen_camera_decode(carmen_camera_encoding_t encoding, 
+		     const unsigned char *data, int data_size, 
+		     unsigned char *pixels, int width, int height, 
+		     int bytes_per_pixel)
+{
+  if (encoding == CARMEN_CAMERA_ENCODING_RAW) {
+    if (data_size != width*height*bytes_per_pixel)
+      return -1;
+    memcpy(pixels, data, data_size);
+    return 0;
+  }
+  if (encoding < 0 || encoding >= CARMEN_CAMERA_NUM_ENCODINGS || 
+      decoders[encoding] == NULL)
+    return -1;
+
+  return decoders[encoding](data, data_size, pixels, width, height, 
+			    bytes_per_pixel);
+}
+
+static void
+release_image(carmen_camera_image_message *image)
+{
+  if (!image_in_shared_memory && image->image != NULL)
+    free(image->image);
+  image->image = NULL;
+  image_in_shared_memory = 0;
+
+  if (image->host != NULL)
+    free(image->host);
+  image->host = NULL;
+}
+
 static void 
 image_interface_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
 			void *clientData __attribute__ ((unused)))
@@ -43,8 +220,7 @@ image_interface_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
   formatter = IPC_msgInstanceFormatter(msgRef);
 
   if(image_message_pointer_external) {
-    if(image_message_pointer_external->image != NULL)
-      free(image_message_pointer_external->image);
+    release_image(image_message_pointer_external);
       
     err = IPC_unmarshallData(formatter, callData, 
 			     image_message_pointer_external,
@@ -58,6 +234,110 @@ image_interface_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
     image_message_handler_external(image_message_pointer_external);
 }
 
+/* Points data at the frame a compressed image message refers to. Returns
+   0 if the frame is gone, or cannot be reached from this host. */
+
+static int
+compressed_image_data(carmen_camera_compressed_image_message *compressed,
+		      const unsigned char **data, int *data_size)
+{
+  static int warned_remote = 0;
+
+  if (compressed->shared_name == NULL) {
+    *data = (unsigned char *)compressed->data;
+    *data_size = compressed->data_size;
+    return 1;
+  }
+
+  if (compressed->host == NULL || 
+      strcmp(compressed->host, carmen_get_host()) != 0) {
+    if (!warned_remote)
+      carmen_warn("Camera images from %s are published through shared "
+		  "memory and cannot be\nreceived on this host.\n", 
+		  compressed->host);
+    warned_remote = 1;
+    return 0;
+  }
+
+  *data = (const unsigned char *)
+    carmen_camera_shared_receive(&subscriber_segment, compressed->shared_name,
+				 compressed->shared_slot,
+				 compressed->shared_sequence, data_size);
+  return (*data != NULL);
+}
+
+static void 
+compressed_image_interface_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
+				   void *clientData __attribute__ ((unused)))
+{
+  IPC_RETURN_TYPE err = IPC_OK;
+  FORMATTER_PTR formatter;
+  carmen_camera_compressed_image_message compressed;
+  carmen_camera_image_message *image = image_message_pointer_external;
+  const unsigned char *data;
+  int data_size, decoded = 0;
+  
+  formatter = IPC_msgInstanceFormatter(msgRef);
+  err = IPC_unmarshallData(formatter, callData, &compressed,
+			   sizeof(carmen_camera_compressed_image_message));
+  IPC_freeByteArray(callData);
+  carmen_test_ipc_return(err, "Could not unmarshall", 
+			 IPC_msgInstanceName(msgRef));
+
+  if (image == NULL || !compressed_image_data(&compressed, &data, 
+					      &data_size)) {
+    IPC_freeDataElements(formatter, &compressed);
+    return;
+  }
+
+  release_image(image);
+  image->width = compressed.width;
+  image->height = compressed.height;
+  image->bytes_per_pixel = compressed.bytes_per_pixel;
+  image->image_size = compressed.image_size;
+  image->timestamp = compressed.timestamp;
+
+  if (compressed.encoding == CARMEN_CAMERA_ENCODING_RAW && 
+      data_size == compressed.image_size) {
+    /* No decoding needed: hand out the shared memory or the unmarshalled 
+       array itself */
+    if (compressed.shared_name != NULL) {
+      image->image = (char *)data;
+      image_in_shared_memory = 1;
+    }
+    else {
+      image->image = compressed.data;
+      compressed.data = NULL;
+    }
+    decoded = 1;
+  }
+  else {
+    image->image = (char *)malloc(compressed.image_size);
+    carmen_test_alloc(image->image);
+    decoded = (carmen_camera_decode(compressed.encoding, data, data_size, 
+				    (unsigned char *)image->image, 
+				    compressed.width, compressed.height, 
+				    compressed.bytes_per_pixel) == 0);
+    if (decoded && compressed.shared_name != NULL)
+      decoded = carmen_camera_shared_valid(subscriber_segment, 
+					   compressed.shared_slot, 
+					   compressed.shared_sequence);
+  }
+
+  image->host = compressed.host;
+  compressed.host = NULL;
+  IPC_freeDataElements(formatter, &compressed);
+
+  if (!decoded) {
+    carmen_warn("Could not decode camera image with encoding %d\n", 
+		compressed.encoding);
+    return;
+  }
+
+  if(image_message_handler_external)
+    image_message_handler_external(image);
+}
+
 void
 carmen_camera_subscribe_images(carmen_camera_image_message *image,
 			       carmen_handler_t handler,
@@ -70,8 +350,18 @@ carmen_camera_subscribe_images(carmen_camera_image_message *image,
   carmen_test_ipc_exit(err, "Could not define message", 
 		       CARMEN_CAMERA_IMAGE_NAME);
 
+  err = IPC_defineMsg(CARMEN_CAMERA_COMPRESSED_IMAGE_NAME, 
+		      IPC_VARIABLE_LENGTH, 
+		      CARMEN_CAMERA_COMPRESSED_IMAGE_FMT);
+  carmen_test_ipc_exit(err, "Could not define message", 
+		       CARMEN_CAMERA_COMPRESSED_IMAGE_NAME);
+
   if(subscribe_how == CARMEN_UNSUBSCRIBE) {
     IPC_unsubscribe(CARMEN_CAMERA_IMAGE_NAME, image_interface_handler);
+    IPC_unsubscribe(CARMEN_CAMERA_COMPRESSED_IMAGE_NAME, 
+		    compressed_image_interface_handler);
+    carmen_camera_shared_close(subscriber_segment);
+    subscriber_segment = NULL;
     return;
   }
 
@@ -79,6 +369,7 @@ carmen_camera_subscribe_images(carmen_camera_image_message *image,
     image_message_pointer_external = image;
     memset(image_message_pointer_external, 0, 
 	   sizeof(carmen_camera_image_message));
+    image_in_shared_memory = 0;
   } else if (image_message_pointer_external == NULL) {
     image_message_pointer_external = (carmen_camera_image_message *)
       calloc(1, sizeof(carmen_camera_image_message));
@@ -87,9 +378,154 @@ carmen_camera_subscribe_images(carmen_camera_image_message *image,
   
   image_message_handler_external = handler;
   err = IPC_subscribe(CARMEN_CAMERA_IMAGE_NAME, image_interface_handler, NULL);
-  if (subscribe_how == CARMEN_SUBSCRIBE_LATEST)
+  carmen_test_ipc(err, "Could not subscribe", CARMEN_CAMERA_IMAGE_NAME);
+  err = IPC_subscribe(CARMEN_CAMERA_COMPRESSED_IMAGE_NAME, 
+		      compressed_image_interface_handler, NULL);
+  carmen_test_ipc(err, "Could not subscribe", 
+		  CARMEN_CAMERA_COMPRESSED_IMAGE_NAME);
+  if (subscribe_how == CARMEN_SUBSCRIBE_LATEST) {
     IPC_setMsgQueueLength(CARMEN_CAMERA_IMAGE_NAME, 1);
-  else
+    IPC_setMsgQueueLength(CARMEN_CAMERA_COMPRESSED_IMAGE_NAME, 1);
+  }
+  else {
     IPC_setMsgQueueLength(CARMEN_CAMERA_IMAGE_NAME, 100);
-  carmen_test_ipc(err, "Could not subscribe", CARMEN_CAMERA_IMAGE_NAME);
+    IPC_setMsgQueueLength(CARMEN_CAMERA_COMPRESSED_IMAGE_NAME, 100);
+  }
+}
+
+static void
+close_publisher_segment(void)
+{
+  carmen_camera_shared_close(publisher_segment);
+  publisher_segment = NULL;
+}
+
+/* Copies data into the publisher's shared memory segment. A segment
+   the frames have outgrown is replaced by one of the next generation. */
+
+static int
+write_shared(carmen_camera_compressed_image_message *msg, 
+	     const unsigned char *data, int data_size)
+{
+  static char *prefix = NULL;
+  static int exit_handler_installed = 0;
+  int slot_size;
+
+  if (prefix == NULL)
+    prefix = carmen_new_string("/carmen_camera_%d", (int)getpid());
+  /* Leave room for encoded frames to vary in size */
+  slot_size = carmen_imax(data_size + data_size / 4, msg->image_size);
+  if (carmen_camera_shared_publish(&publisher_segment, prefix, data, 
+				   data_size, slot_size, &msg->shared_slot, 
+				   &msg->shared_sequence) < 0)
+    return -1;
+  if (!exit_handler_installed)
+    atexit(close_publisher_segment);
+  exit_handler_installed = 1;
+
+  msg->shared_name = publisher_segment->name;
+  msg->data = NULL;
+  msg->data_size = 0;
+  return 0;
+}
+
+void
+carmen_camera_publish_image(carmen_camera_image_message *image,
+			    carmen_camera_encoding_t encoding,
+			    int quality, int use_shared_memory)
+{
+  static int initialized = 0;
+  static int warned_encoding = 0;
+  IPC_RETURN_TYPE err;
+  carmen_camera_compressed_image_message msg;
+  unsigned char *encoded = NULL;
+
+  if (!initialized) {
+    err = IPC_defineMsg(CARMEN_CAMERA_IMAGE_NAME, IPC_VARIABLE_LENGTH, 
+			CARMEN_CAMERA_IMAGE_FMT);
+    carmen_test_ipc_exit(err, "Could not define", CARMEN_CAMERA_IMAGE_NAME);
+    err = IPC_defineMsg(CARMEN_CAMERA_COMPRESSED_IMAGE_NAME, 
+			IPC_VARIABLE_LENGTH, 
+			CARMEN_CAMERA_COMPRESSED_IMAGE_FMT);
+    carmen_test_ipc_exit(err, "Could not define", 
+			 CARMEN_CAMERA_COMPRESSED_IMAGE_NAME);
+    initialized = 1;
+  }
+
+  msg.width = image->width;
+  msg.height = image->height;
+  msg.bytes_per_pixel = image->bytes_per_pixel;
+  msg.image_size = image->image_size;
+  msg.encoding = CARMEN_CAMERA_ENCODING_RAW;
+  msg.data = image->image;
+  msg.data_size = image->image_size;
+  msg.shared_name = NULL;
+  msg.shared_slot = 0;
+  msg.shared_sequence = 0;
+  msg.timestamp = image->timestamp;
+  msg.host = image->host;
+
+  if (encoding != CARMEN_CAMERA_ENCODING_RAW) {
+    if (encoding < 0 || encoding >= CARMEN_CAMERA_NUM_ENCODINGS ||
+	encoders[encoding] == NULL ||
+	encoders[encoding]((unsigned char *)image->image, image->width, 
+			   image->height, image->bytes_per_pixel, quality, 
+			   &encoded, &msg.data_size) < 0) {
+      if (!warned_encoding)
+	carmen_warn("Could not encode camera image with encoding %d, "
+		    "publishing it raw\n", encoding);
+      warned_encoding = 1;
+      encoded = NULL;
+      msg.data_size = image->image_size;
+    }
+    else {
+      msg.encoding = encoding;
+      msg.data = (char *)encoded;
+    }
+  }
+
+  /* If the frame does not make it into shared memory, it is sent 
+     through central instead */
+  if (use_shared_memory && 
+      write_shared(&msg, (unsigned char *)msg.data, msg.data_size) < 0)
+    carmen_warn("Could not write camera image to shared memory\n");
+
+  if (msg.encoding == CARMEN_CAMERA_ENCODING_RAW && msg.shared_name == NULL) {
+    err = IPC_publishData(CARMEN_CAMERA_IMAGE_NAME, image);
+    carmen_test_ipc_exit(err, "Could not publish", CARMEN_CAMERA_IMAGE_NAME);
+  }
+  else {
+    err = IPC_publishData(CARMEN_CAMERA_COMPRESSED_IMAGE_NAME, &msg);
+    carmen_test_ipc_exit(err, "Could not publish", 
+			 CARMEN_CAMERA_COMPRESSED_IMAGE_NAME);
+  }
+  free(encoded);
+}
+
+void
+carmen_camera_install_transport_params(int argc, char **argv,
+				       carmen_camera_encoding_t *encoding,
+				       int *quality, int *use_shared_memory)
+{
+  char *encoding_name = NULL;
+  int allow_unfound;
+
+  carmen_param_t param_list[] = {
+    {"camera", "encoding", CARMEN_PARAM_STRING, &encoding_name, 0, NULL},
+    {"camera", "quality", CARMEN_PARAM_INT, quality, 0, NULL},
+    {"camera", "shared_memory", CARMEN_PARAM_ONOFF, use_shared_memory, 
+     0, NULL}};
+
+  allow_unfound = carmen_param_are_unfound_variables_allowed();
+  carmen_param_allow_unfound_variables(1);
+  carmen_param_install_params(argc, argv, param_list, 
+			      sizeof(param_list) / sizeof(param_list[0]));
+  carmen_param_allow_unfound_variables(allow_unfound);
+
+  if (encoding_name != NULL) {
+    *encoding = carmen_camera_encoding_from_name(encoding_name);
+    if ((int)*encoding < 0)
+      carmen_die("Unknown camera_encoding %s\n", encoding_name);
+    free(encoding_name);
+  }
 }
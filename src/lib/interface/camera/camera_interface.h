@@ -47,12 +47,83 @@
 extern "C" {
 #endif
 
-  /** Subscribe to images from camera_xxxxcam (e.g., camera_quickcam). */
+  /** Subscribe to images from camera_xxxxcam (e.g., camera_quickcam). 
+      Both raw and compressed images are delivered to the handler as a 
+      decoded carmen_camera_image_message. If the images arrive through 
+      shared memory without an encoding, image->image points into the 
+      shared memory segment: it must be copied if it is needed for longer 
+      than CARMEN_CAMERA_SHARED_NUM_SLOTS-1 further frames. */
 
 void
 carmen_camera_subscribe_images(carmen_camera_image_message *image,
 			       carmen_handler_t handler,
 			       carmen_subscribe_t subscribe_how);
+
+  /** Encodes width*height*bytes_per_pixel pixels into a newly allocated 
+      buffer *data of *data_size bytes. Returns 0 on success. */
+
+typedef int (*carmen_camera_encoder_t)(const unsigned char *pixels, 
+				       int width, int height, 
+				       int bytes_per_pixel, int quality, 
+				       unsigned char **data, int *data_size);
+
+  /** Decodes data_size bytes of data into pixels, which holds 
+      width*height*bytes_per_pixel bytes. Returns 0 on success. */
+
+typedef int (*carmen_camera_decoder_t)(const unsigned char *data, 
+				       int data_size, unsigned char *pixels, 
+				       int width, int height, 
+				       int bytes_per_pixel);
+
+  /** Installs the codec for an encoding. The JPEG codec lives in the
+      graphics library: programs that link it register it with 
+      carmen_camera_register_codec(CARMEN_CAMERA_ENCODING_JPEG, 
+      carmen_graphics_jpeg_compress, carmen_graphics_jpeg_decompress). */
+
+void carmen_camera_register_codec(carmen_camera_encoding_t encoding,
+				  carmen_camera_encoder_t encoder,
+				  carmen_camera_decoder_t decoder);
+
+  /** Returns the encoding called name ("raw", "jpeg" or "deflate"), or -1
+      if there is no such encoding. */
+
+int carmen_camera_encoding_from_name(const char *name);
+
+  /** Encodes an image with the codec registered for encoding. Returns -1 
+      if there is no encoder for it. */
+
+int carmen_camera_encode(carmen_camera_encoding_t encoding, 
+			 const unsigned char *pixels, int width, int height, 
+			 int bytes_per_pixel, int quality, 
+			 unsigned char **data, int *data_size);
+
+  /** Decodes an image with the codec registered for encoding. Returns -1 
+      if there is no decoder for it or the data is corrupt. */
+
+int carmen_camera_decode(carmen_camera_encoding_t encoding, 
+			 const unsigned char *data, int data_size, 
+			 unsigned char *pixels, int width, int height, 
+			 int bytes_per_pixel);
+
+  /** Publishes an image. Unencoded images that do not use shared memory 
+      are published as carmen_camera_image_message, as they always have 
+      been. Otherwise a carmen_camera_compressed_image_message is 
+      published, and with use_shared_memory only the slot of the image in 
+      a shared memory segment is sent through central. Shared memory can 
+      only be used if all subscribers run on the same host. */
+
+void carmen_camera_publish_image(carmen_camera_image_message *image,
+				 carmen_camera_encoding_t encoding,
+				 int quality, int use_shared_memory);
+
+  /** Reads the optional parameters camera_encoding, camera_quality and
+      camera_shared_memory of a camera module. Variables whose parameter
+      is not set keep their value. Exits on an unknown encoding. */
+
+void carmen_camera_install_transport_params(int argc, char **argv,
+					    carmen_camera_encoding_t *encoding,
+					    int *quality, 
+					    int *use_shared_memory);
 #ifdef __cplusplus
 }
 #endif
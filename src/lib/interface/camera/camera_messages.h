@@ -59,6 +59,47 @@ typedef struct {
 #define      CARMEN_CAMERA_IMAGE_NAME       "carmen_camera_image"
 #define      CARMEN_CAMERA_IMAGE_FMT        "{int,int,int,int,<char:4>,double,string}"
 
+  /** Encodings of the image data in carmen_camera_compressed_image_message. 
+      Encodings other than raw and deflate are only available if a codec
+      has been registered with carmen_camera_register_codec(). */
+
+typedef enum {
+  CARMEN_CAMERA_ENCODING_RAW = 0,     /**<Uncompressed pixels. */
+  CARMEN_CAMERA_ENCODING_JPEG = 1,    /**<Lossy JPEG, see global_jpeg.c. */
+  CARMEN_CAMERA_ENCODING_DEFLATE = 2  /**<Lossless, zlib-compressed
+					 horizontal pixel differences. */
+} carmen_camera_encoding_t;
+
+#define CARMEN_CAMERA_NUM_ENCODINGS 3
+
+  /** This message is published by the camera_xxxxxcam modules instead of
+      carmen_camera_image_message if an encoding or the shared memory
+      transport is configured. carmen_camera_subscribe_images() decodes it
+      transparently. */
+
+typedef struct {
+  int width;                    /**<The x dimension of the image in pixels. */
+  int height;                   /**<The y dimension of the image in pixels. */
+  int bytes_per_pixel;          /**<Usually 3 (RGB). */ 
+  int image_size;               /**<width*height*bytes_per_pixel. */ 
+  int encoding;                 /**<A carmen_camera_encoding_t. */
+  int data_size;                /**<Size of the encoded data. 0 if the data 
+				   is passed through shared memory. */
+  char *data;
+  char *shared_name;            /**<Shared memory segment holding the data, 
+				   NULL if the data is part of the 
+				   message. */
+  int shared_slot;              /**<Slot of the segment holding the data. */
+  int shared_sequence;          /**<Sequence number of the slot, used to 
+				   detect frames overwritten before they 
+				   were read. */
+  double timestamp;
+  char *host;
+} carmen_camera_compressed_image_message;
+
+#define      CARMEN_CAMERA_COMPRESSED_IMAGE_NAME  "carmen_camera_compressed_image"
+#define      CARMEN_CAMERA_COMPRESSED_IMAGE_FMT   "{int,int,int,int,int,int,<char:6>,string,int,int,double,string}"
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,280 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "global.h"
+#include "camera_shared.h"
+
+#define CAMERA_SHARED_MAGIC     0x43414d53
+#define CAMERA_SHARED_ALIGNMENT 64
+
+typedef struct {
+  int magic;
+  int num_slots;
+  int slot_size;
+  int slot_stride;
+} camera_shared_header_t;
+
+typedef struct {
+  volatile int sequence;
+  int size;
+} camera_shared_slot_t;
+
+static int
+align(int size)
+{
+  return (size + CAMERA_SHARED_ALIGNMENT - 1) / CAMERA_SHARED_ALIGNMENT *
+    CAMERA_SHARED_ALIGNMENT;
+}
+
+static camera_shared_header_t *
+header(carmen_camera_shared_p shared)
+{
+  return (camera_shared_header_t *)shared->segment;
+}
+
+static camera_shared_slot_t *
+slot_header(carmen_camera_shared_p shared, int slot)
+{
+  return (camera_shared_slot_t *)((char *)shared->segment + 
+				  align(sizeof(camera_shared_header_t)) + 
+				  slot * header(shared)->slot_stride);
+}
+
+static char *
+slot_data(carmen_camera_shared_p shared, int slot)
+{
+  return (char *)slot_header(shared, slot) + 
+    align(sizeof(camera_shared_slot_t));
+}
+
+carmen_camera_shared_p
+carmen_camera_shared_create(const char *name, int num_slots, int slot_size)
+{
+  carmen_camera_shared_p shared;
+  int fd, slot_stride;
+
+  if (num_slots < 1 || slot_size < 1)
+    return NULL;
+
+  shared = (carmen_camera_shared_p)calloc(1, sizeof(carmen_camera_shared_t));
+  carmen_test_alloc(shared);
+  shared->name = carmen_new_string("%s", name);
+  shared->owner = 1;
+  shared->num_slots = num_slots;
+  shared->slot_size = slot_size;
+
+  slot_stride = align(sizeof(camera_shared_slot_t)) + align(slot_size);
+  shared->segment_size = align(sizeof(camera_shared_header_t)) + 
+    num_slots * slot_stride;
+
+  shm_unlink(name);
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0 || ftruncate(fd, shared->segment_size) < 0) {
+    carmen_warn("Could not create shared memory segment %s: %s\n", name, 
+		strerror(errno));
+    if (fd >= 0) {
+      close(fd);
+      shm_unlink(name);
+    }
+    free(shared->name);
+    free(shared);
+    return NULL;
+  }
+
+  shared->segment = mmap(NULL, shared->segment_size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED, fd, 0);
+  close(fd);
+  if (shared->segment == MAP_FAILED) {
+    carmen_warn("Could not map shared memory segment %s: %s\n", name, 
+		strerror(errno));
+    shm_unlink(name);
+    free(shared->name);
+    free(shared);
+    return NULL;
+  }
+
+  header(shared)->num_slots = num_slots;
+  header(shared)->slot_size = slot_size;
+  header(shared)->slot_stride = slot_stride;
+  __sync_synchronize();
+  header(shared)->magic = CAMERA_SHARED_MAGIC;
+
+  return shared;
+}
+
+carmen_camera_shared_p
+carmen_camera_shared_open(const char *name)
+{
+  carmen_camera_shared_p shared;
+  struct stat segment_stat;
+  int fd;
+
+  fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0)
+    return NULL;
+  if (fstat(fd, &segment_stat) < 0 || 
+      segment_stat.st_size < (off_t)sizeof(camera_shared_header_t)) {
+    close(fd);
+    return NULL;
+  }
+
+  shared = (carmen_camera_shared_p)calloc(1, sizeof(carmen_camera_shared_t));
+  carmen_test_alloc(shared);
+  shared->segment_size = segment_stat.st_size;
+  shared->segment = mmap(NULL, shared->segment_size, PROT_READ, MAP_SHARED, 
+			 fd, 0);
+  close(fd);
+  if (shared->segment == MAP_FAILED || 
+      header(shared)->magic != CAMERA_SHARED_MAGIC ||
+      align(sizeof(camera_shared_header_t)) + header(shared)->num_slots * 
+      header(shared)->slot_stride > shared->segment_size) {
+    if (shared->segment != MAP_FAILED)
+      munmap(shared->segment, shared->segment_size);
+    free(shared);
+    return NULL;
+  }
+
+  shared->name = carmen_new_string("%s", name);
+  shared->num_slots = header(shared)->num_slots;
+  shared->slot_size = header(shared)->slot_size;
+
+  return shared;
+}
+
+void
+carmen_camera_shared_close(carmen_camera_shared_p shared)
+{
+  if (shared == NULL)
+    return;
+
+  munmap(shared->segment, shared->segment_size);
+  if (shared->owner)
+    shm_unlink(shared->name);
+  free(shared->name);
+  free(shared);
+}
+
+int
+carmen_camera_shared_write(carmen_camera_shared_p shared, const void *data, 
+			   int size, int *slot, int *sequence)
+{
+  camera_shared_slot_t *current;
+  int new_sequence;
+
+  if (size > shared->slot_size)
+    return -1;
+
+  *slot = shared->next_slot;
+  shared->next_slot = (shared->next_slot + 1) % shared->num_slots;
+  current = slot_header(shared, *slot);
+
+  /* An odd sequence number marks the slot as being written */
+  new_sequence = current->sequence + 2;
+  current->sequence = new_sequence - 1;
+  __sync_synchronize();
+  memcpy(slot_data(shared, *slot), data, size);
+  current->size = size;
+  __sync_synchronize();
+  current->sequence = new_sequence;
+
+  *sequence = new_sequence;
+  return 0;
+}
+
+const void *
+carmen_camera_shared_read(carmen_camera_shared_p shared, int slot, 
+			  int sequence, int *size)
+{
+  camera_shared_slot_t *current;
+
+  if (slot < 0 || slot >= shared->num_slots)
+    return NULL;
+
+  current = slot_header(shared, slot);
+  if (current->sequence != sequence)
+    return NULL;
+  __sync_synchronize();
+  if (size)
+    *size = current->size;
+
+  return slot_data(shared, slot);
+}
+
+int
+carmen_camera_shared_valid(carmen_camera_shared_p shared, int slot, 
+			   int sequence)
+{
+  if (slot < 0 || slot >= shared->num_slots)
+    return 0;
+
+  __sync_synchronize();
+  return slot_header(shared, slot)->sequence == sequence;
+}
+
+int
+carmen_camera_shared_publish(carmen_camera_shared_p *shared, 
+			     const char *prefix, const void *data, int size, 
+			     int slot_size, int *slot, int *sequence)
+{
+  int generation = 0;
+  char *name;
+
+  if (*shared == NULL || (*shared)->slot_size < size) {
+    if (*shared != NULL)
+      generation = (*shared)->generation + 1;
+    carmen_camera_shared_close(*shared);
+    name = carmen_new_string("%s_%d", prefix, generation);
+    *shared = carmen_camera_shared_create(name, CARMEN_CAMERA_SHARED_NUM_SLOTS,
+					  carmen_imax(slot_size, size));
+    free(name);
+    if (*shared == NULL)
+      return -1;
+    (*shared)->generation = generation;
+  }
+
+  return carmen_camera_shared_write(*shared, data, size, slot, sequence);
+}
+
+const void *
+carmen_camera_shared_receive(carmen_camera_shared_p *shared, 
+			     const char *name, int slot, int sequence, 
+			     int *size)
+{
+  if (*shared == NULL || strcmp((*shared)->name, name) != 0) {
+    carmen_camera_shared_close(*shared);
+    *shared = carmen_camera_shared_open(name);
+    if (*shared == NULL)
+      return NULL;
+  }
+
+  return carmen_camera_shared_read(*shared, slot, sequence, size);
+}
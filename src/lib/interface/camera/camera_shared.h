@@ -0,0 +1,123 @@
+/*********************************************************
+ *
+ * This source code is part of the Carnegie Mellon Robot
+ * Navigation Toolkit (CARMEN)
+ *
+ * CARMEN Copyright (c) 2002 Michael Montemerlo, Nicholas
+ * Roy, Sebastian Thrun, Dirk Haehnel, Cyrill Stachniss,
+ * and Jared Glover
+ *
+ * CARMEN is free software; you can redistribute it and/or 
+ * modify it under the terms of the GNU General Public 
+ * License as published by the Free Software Foundation; 
+ * either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * CARMEN is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied 
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more 
+ * details.
+ *
+ * You should have received a copy of the GNU General 
+ * Public License along with CARMEN; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, 
+ * Suite 330, Boston, MA  02111-1307 USA
+ *
+ ********************************************************/
+
+/** @addtogroup camera libcamera_interface **/
+// @{
+
+/** \file camera_shared.h
+ * \brief Shared memory transport for camera images.
+ *
+ * A camera module on the same host as its subscribers can write its
+ * frames into a ring of slots in a POSIX shared memory segment and
+ * publish only the slot number through central. Each slot is guarded by
+ * a sequence number that is odd while the slot is being written, so a
+ * reader can tell whether the frame it was told about is still there.
+ **/
+
+#ifndef CARMEN_CAMERA_SHARED_H
+#define CARMEN_CAMERA_SHARED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CARMEN_CAMERA_SHARED_NUM_SLOTS 8
+
+typedef struct {
+  char *name;
+  int owner;
+  int num_slots;
+  int slot_size;
+  int next_slot;
+  int generation;
+  void *segment;
+  int segment_size;
+} carmen_camera_shared_t, *carmen_camera_shared_p;
+
+  /** Creates (or re-creates) the shared memory segment name, with
+      num_slots slots of slot_size bytes each. Returns NULL on error. */
+
+carmen_camera_shared_p
+carmen_camera_shared_create(const char *name, int num_slots, int slot_size);
+
+  /** Maps an existing shared memory segment for reading. Returns NULL
+      if it does not exist. */
+
+carmen_camera_shared_p carmen_camera_shared_open(const char *name);
+
+  /** Unmaps the segment, and removes it if it was created by
+      carmen_camera_shared_create(). */
+
+void carmen_camera_shared_close(carmen_camera_shared_p shared);
+
+  /** Copies size bytes into the next slot, and returns the slot and its
+      new sequence number. Returns -1 if data does not fit into a slot. */
+
+int carmen_camera_shared_write(carmen_camera_shared_p shared, 
+			       const void *data, int size, int *slot, 
+			       int *sequence);
+
+  /** Returns the data in slot if it still holds the frame with the given
+      sequence number, NULL otherwise. The returned pointer refers to the
+      segment itself: it stays valid until the writer comes back to the
+      slot, i.e. for the next num_slots-1 frames. */
+
+const void *carmen_camera_shared_read(carmen_camera_shared_p shared, 
+				      int slot, int sequence, int *size);
+
+  /** Returns non-zero if the frame read with carmen_camera_shared_read()
+      has not been overwritten since. */
+
+int carmen_camera_shared_valid(carmen_camera_shared_p shared, int slot,
+			       int sequence);
+
+  /** Writes size bytes into the segment *shared of a publisher, named
+      prefix_<generation>. The first frame, and a frame that outgrows
+      the slots, create a segment with slots of at least slot_size bytes
+      under the next generation, so subscribers see a new name instead of
+      reading the removed segment. Returns -1 on error. */
+
+int carmen_camera_shared_publish(carmen_camera_shared_p *shared, 
+				 const char *prefix, const void *data, 
+				 int size, int slot_size, int *slot, 
+				 int *sequence);
+
+  /** Same as carmen_camera_shared_read() on the segment name of a
+      subscriber. *shared is (re)opened if it is not that segment. */
+
+const void *carmen_camera_shared_receive(carmen_camera_shared_p *shared,
+					 const char *name, int slot, 
+					 int sequence, int *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// @}
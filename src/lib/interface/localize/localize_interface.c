@@ -69,6 +69,95 @@ carmen_localize_unsubscribe_particle_message(carmen_handler_t handler)
   carmen_unsubscribe_message(CARMEN_LOCALIZE_PARTICLE_NAME, handler);
 }
 
+void
+carmen_localize_subscribe_compact_particle_message
+(carmen_localize_compact_particle_message *particle,
+ carmen_handler_t handler, carmen_subscribe_t subscribe_how)
+{
+  carmen_subscribe_message(CARMEN_LOCALIZE_COMPACT_PARTICLE_NAME, 
+                           CARMEN_LOCALIZE_COMPACT_PARTICLE_FMT,
+                           particle,
+			   sizeof(carmen_localize_compact_particle_message), 
+			   handler, subscribe_how);
+}
+
+void
+carmen_localize_unsubscribe_compact_particle_message(carmen_handler_t handler)
+{
+  carmen_unsubscribe_message(CARMEN_LOCALIZE_COMPACT_PARTICLE_NAME, handler);
+}
+
+static short
+quantize(double value, double resolution)
+{
+  return carmen_clamp(-32767, carmen_round(value / resolution), 32767);
+}
+
+void
+carmen_localize_encode_compact_particles
+(carmen_localize_particle_ipc_p particles, int num_particles,
+ int max_particles, carmen_localize_compact_particle_message *msg)
+{
+  carmen_localize_particle_ipc_p particle;
+  carmen_localize_compact_particle_p compact;
+  double max_weight, max_offset = 0.0;
+  int i;
+
+  if (num_particles < max_particles)
+    max_particles = num_particles;
+
+  max_weight = num_particles > 0 ? particles[0].weight : 0.0;
+  for (i = 1; i < num_particles; i++)
+    if (particles[i].weight > max_weight)
+      max_weight = particles[i].weight;
+
+  for (i = 0; i < max_particles; i++) {
+    particle = particles + (long)i * num_particles / max_particles;
+    max_offset = carmen_fmax(max_offset,
+			     fabs(particle->x - msg->globalpos.x));
+    max_offset = carmen_fmax(max_offset,
+			     fabs(particle->y - msg->globalpos.y));
+  }
+  msg->xy_resolution = carmen_fmax(CARMEN_LOCALIZE_COMPACT_XY_RESOLUTION,
+				   max_offset / 32767.0);
+
+  for (i = 0; i < max_particles; i++) {
+    particle = particles + (long)i * num_particles / max_particles;
+    compact = msg->particles + i;
+    compact->x = quantize(particle->x - msg->globalpos.x,
+			  msg->xy_resolution);
+    compact->y = quantize(particle->y - msg->globalpos.y,
+			  msg->xy_resolution);
+    compact->theta = quantize(carmen_normalize_theta(particle->theta),
+			      CARMEN_LOCALIZE_COMPACT_THETA_RESOLUTION);
+    compact->weight = carmen_clamp
+      (0, carmen_round((max_weight - particle->weight) /
+		       CARMEN_LOCALIZE_COMPACT_WEIGHT_RESOLUTION), 65535);
+  }
+
+  msg->num_particles = max_particles;
+  msg->filter_particles = num_particles;
+}
+
+void
+carmen_localize_decode_compact_particles
+(carmen_localize_compact_particle_message *msg,
+ carmen_localize_particle_ipc_p particles)
+{
+  carmen_localize_compact_particle_p compact;
+  int i;
+
+  for (i = 0; i < msg->num_particles; i++) {
+    compact = msg->particles + i;
+    particles[i].x = msg->globalpos.x + compact->x * msg->xy_resolution;
+    particles[i].y = msg->globalpos.y + compact->y * msg->xy_resolution;
+    particles[i].theta = compact->theta *
+      CARMEN_LOCALIZE_COMPACT_THETA_RESOLUTION;
+    particles[i].weight = -compact->weight *
+      CARMEN_LOCALIZE_COMPACT_WEIGHT_RESOLUTION;
+  }
+}
+
 void
 carmen_localize_subscribe_sensor_message(carmen_localize_sensor_message 
 					 *sensor,
@@ -66,6 +66,30 @@ carmen_localize_subscribe_particle_message(carmen_localize_particle_message
 void
 carmen_localize_unsubscribe_particle_message(carmen_handler_t handler);
 
+void 
+carmen_localize_subscribe_compact_particle_message
+(carmen_localize_compact_particle_message *particle, 
+ carmen_handler_t handler, carmen_subscribe_t subscribe_how);
+
+void
+carmen_localize_unsubscribe_compact_particle_message(carmen_handler_t handler);
+
+/* Fills msg->particles with at most max_particles of the given
+   particles, evenly subsampled. msg->particles must have room for
+   max_particles; msg->globalpos must be set. Sets msg->xy_resolution
+   to the finest resolution that holds every encoded particle. */
+void
+carmen_localize_encode_compact_particles
+(carmen_localize_particle_ipc_p particles, int num_particles,
+ int max_particles, carmen_localize_compact_particle_message *msg);
+
+/* Fills particles (msg->num_particles of them) with world poses and log
+   weights relative to the best particle. */
+void
+carmen_localize_decode_compact_particles
+(carmen_localize_compact_particle_message *msg,
+ carmen_localize_particle_ipc_p particles);
+
 void 
 carmen_localize_subscribe_initialize_message(carmen_localize_initialize_message *init_msg,
 					     carmen_handler_t handler, 
@@ -106,6 +106,40 @@ typedef struct {
 #define CARMEN_LOCALIZE_PARTICLE_NAME "carmen_localize_particle"
 #define CARMEN_LOCALIZE_PARTICLE_FMT  "{int,<{float,float,float,float}:1>,{double,double,double},{double,double,double},double,double,string}"
 
+/* compact particle message: at most localize_compact_max_particles
+   particles, evenly subsampled from the filter, with the pose stored
+   relative to globalpos in fixed point and the log weight relative to
+   the best particle. Use carmen_localize_decode_compact_particles() to
+   get floats back.
+
+   x and y are 16 bit multiples of xy_resolution, which is
+   CARMEN_LOCALIZE_COMPACT_XY_RESOLUTION as long as every particle lies
+   within 327.67 m of globalpos. A wider cloud (e.g. during global
+   localization) gets the resolution that just covers it. */
+
+#define CARMEN_LOCALIZE_COMPACT_XY_RESOLUTION      0.01
+#define CARMEN_LOCALIZE_COMPACT_THETA_RESOLUTION   (M_PI/32768.0)
+#define CARMEN_LOCALIZE_COMPACT_WEIGHT_RESOLUTION  (1.0/256.0)
+
+typedef struct {
+  short x, y, theta;
+  unsigned short weight;
+} carmen_localize_compact_particle_t, *carmen_localize_compact_particle_p;
+
+typedef struct {
+  int num_particles;
+  carmen_localize_compact_particle_p particles;
+  int filter_particles;
+  double xy_resolution;
+  carmen_point_t globalpos, globalpos_std;
+  double globalpos_xy_cov;
+  double timestamp;
+  char *host;
+} carmen_localize_compact_particle_message;
+
+#define CARMEN_LOCALIZE_COMPACT_PARTICLE_NAME "carmen_localize_compact_particle"
+#define CARMEN_LOCALIZE_COMPACT_PARTICLE_FMT  "{int,<{short,short,short,ushort}:1>,int,double,{double,double,double},{double,double,double},double,double,string}"
+
 /* sensor message in localize coordinates */
 
 typedef struct {
@@ -58,6 +58,41 @@ typedef struct {
   float** map;
 } carmen_map_t, *carmen_map_p;
 
+/* Compact cell encodings. Cells are stored column by column like
+   carmen_map_t, each column taking column_bytes bytes.
+
+   CARMEN_MAP_ENCODING_U8: one byte per cell, the occupancy probability
+   quantized to 0..CARMEN_MAP_U8_MAX, with CARMEN_MAP_U8_UNKNOWN for
+   unknown cells.
+
+   CARMEN_MAP_ENCODING_BITMAP: two bits per cell, one of
+   CARMEN_MAP_CELL_FREE, CARMEN_MAP_CELL_OCCUPIED or
+   CARMEN_MAP_CELL_UNKNOWN. Cells with an occupancy above
+   occupied_threshold were classified as occupied. */
+
+#define          CARMEN_MAP_ENCODING_U8              1
+#define          CARMEN_MAP_ENCODING_BITMAP          2
+
+#define          CARMEN_MAP_U8_MAX                   254
+#define          CARMEN_MAP_U8_UNKNOWN               255
+
+#define          CARMEN_MAP_CELL_FREE                0
+#define          CARMEN_MAP_CELL_OCCUPIED            1
+#define          CARMEN_MAP_CELL_UNKNOWN             2
+
+typedef struct {
+  carmen_map_config_t config;
+  int encoding;
+  int column_bytes;
+  float occupied_threshold;
+  unsigned char *data;
+} carmen_compact_map_t, *carmen_compact_map_p;
+
+#define CARMEN_COMPACT_MAP_U8_CELL(map, x, y) \
+  ((map)->data[(x)*(map)->column_bytes+(y)])
+#define CARMEN_COMPACT_MAP_BITMAP_CELL(map, x, y) \
+  (((map)->data[(x)*(map)->column_bytes+((y) >> 2)] >> (((y) & 3) << 1)) & 3)
+
 typedef struct {
   int type, size;
   char name[22];
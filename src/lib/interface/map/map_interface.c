@@ -444,15 +444,44 @@ int carmen_map_change_map_zone(char *zone_name)
   return 0;
 }
 
-/* send a request for a gridmap */
 int
-carmen_map_get_gridmap_by_name(char *name, carmen_map_p client_map)
+carmen_map_get_zone(char **zone_name)
 {
   IPC_RETURN_TYPE err;
-  static carmen_gridmap_request_message *query;
-  static carmen_named_gridmap_request named_query;
-  static carmen_grid_map_message *response;
+  carmen_map_zone_request_message *query;
+  carmen_map_zone_message *response;
   unsigned int timeout = 10000;
+
+  err = IPC_defineMsg(CARMEN_MAP_ZONE_REQUEST_NAME, IPC_VARIABLE_LENGTH,
+		      CARMEN_DEFAULT_MESSAGE_FMT);
+  carmen_test_ipc_exit(err, "Could not define message",
+		       CARMEN_MAP_ZONE_REQUEST_NAME);
+
+  query = carmen_default_message_create();
+  err = IPC_queryResponseData(CARMEN_MAP_ZONE_REQUEST_NAME, query,
+			      (void **)&response, timeout);
+  carmen_test_ipc_return_int(err, "Could not get map zone",
+			     CARMEN_MAP_ZONE_REQUEST_NAME);
+
+  if (zone_name) {
+    if (response->zone_name && response->zone_name[0] != '\0')
+      *zone_name = carmen_new_string(response->zone_name);
+    else
+      *zone_name = NULL;
+  }
+
+  free(response->zone_name);
+  free(response->host);
+  free(response);
+
+  return 0;
+}
+
+/* fills client_map from a gridmap response and frees the response */
+static int
+unpack_gridmap_response(carmen_grid_map_message *response, 
+			carmen_map_p client_map)
+{
   int i;
 #ifndef NO_ZLIB
   int uncompress_return;
@@ -460,40 +489,6 @@ carmen_map_get_gridmap_by_name(char *name, carmen_map_p client_map)
   uLong uncompress_size_result;
 #endif
 
-  if (name) {
-    err = IPC_defineMsg(CARMEN_NAMED_GRIDMAP_REQUEST_NAME, IPC_VARIABLE_LENGTH,
-			CARMEN_NAMED_GRIDMAP_REQUEST_FMT);
-    carmen_test_ipc_exit(err, "Could not define message",
-			 CARMEN_NAMED_GRIDMAP_REQUEST_NAME);
-
-    named_query.name = calloc(strlen(name) + 1, sizeof(char));
-    carmen_test_alloc(named_query.name);
-    strcpy(named_query.name, name);
-    named_query.host = carmen_get_host();
-    named_query.timestamp = carmen_get_time();
-    err = IPC_queryResponseData(CARMEN_NAMED_GRIDMAP_REQUEST_NAME, &named_query,
-				(void **)&response, timeout);
-  }
-  else {
-    err = IPC_defineMsg(CARMEN_GRIDMAP_REQUEST_NAME, IPC_VARIABLE_LENGTH,
-			CARMEN_DEFAULT_MESSAGE_FMT);
-    carmen_test_ipc_exit(err, "Could not define message",
-			 CARMEN_GRIDMAP_REQUEST_NAME);
-
-    query = carmen_default_message_create();
-    err = IPC_queryResponseData(CARMEN_GRIDMAP_REQUEST_NAME, query,
-				(void **)&response, timeout);
-  }
-
-  if (err != IPC_OK)
-    {
-      carmen_test_ipc(err, "Could not get map_request",
-		      CARMEN_GRIDMAP_REQUEST_NAME);
-      carmen_warn("\nDid you remember to start the mapserver, or give a map "
-		  "to the paramServer?\n");
-      return -1;
-    }
-
   if (response->size == 0)
     {
       carmen_warn("Error receiving map: %s\n", response->err_mesg);
@@ -563,12 +558,85 @@ carmen_map_get_gridmap_by_name(char *name, carmen_map_p client_map)
   return 0;
 }
 
+/* send a request for a gridmap */
+int
+carmen_map_get_gridmap_by_name(char *name, carmen_map_p client_map)
+{
+  IPC_RETURN_TYPE err;
+  static carmen_gridmap_request_message *query;
+  static carmen_named_gridmap_request named_query;
+  static carmen_grid_map_message *response;
+  unsigned int timeout = 10000;
+
+  if (name) {
+    err = IPC_defineMsg(CARMEN_NAMED_GRIDMAP_REQUEST_NAME, IPC_VARIABLE_LENGTH,
+			CARMEN_NAMED_GRIDMAP_REQUEST_FMT);
+    carmen_test_ipc_exit(err, "Could not define message",
+			 CARMEN_NAMED_GRIDMAP_REQUEST_NAME);
+
+    named_query.name = calloc(strlen(name) + 1, sizeof(char));
+    carmen_test_alloc(named_query.name);
+    strcpy(named_query.name, name);
+    named_query.host = carmen_get_host();
+    named_query.timestamp = carmen_get_time();
+    err = IPC_queryResponseData(CARMEN_NAMED_GRIDMAP_REQUEST_NAME, &named_query,
+				(void **)&response, timeout);
+  }
+  else {
+    err = IPC_defineMsg(CARMEN_GRIDMAP_REQUEST_NAME, IPC_VARIABLE_LENGTH,
+			CARMEN_DEFAULT_MESSAGE_FMT);
+    carmen_test_ipc_exit(err, "Could not define message",
+			 CARMEN_GRIDMAP_REQUEST_NAME);
+
+    query = carmen_default_message_create();
+    err = IPC_queryResponseData(CARMEN_GRIDMAP_REQUEST_NAME, query,
+				(void **)&response, timeout);
+  }
+
+  if (err != IPC_OK)
+    {
+      carmen_test_ipc(err, "Could not get map_request",
+		      CARMEN_GRIDMAP_REQUEST_NAME);
+      carmen_warn("\nDid you remember to start the mapserver, or give a map "
+		  "to the paramServer?\n");
+      return -1;
+    }
+
+  return unpack_gridmap_response(response, client_map);
+}
+
 int
 carmen_map_get_gridmap(carmen_map_p client_map)
 {
   return carmen_map_get_gridmap_by_name(NULL, client_map);
 }
 
+int
+carmen_map_get_distance_map(carmen_map_p client_map)
+{
+  IPC_RETURN_TYPE err;
+  carmen_distance_map_request_message *query;
+  carmen_grid_map_message *response;
+  unsigned int timeout = 10000;
+
+  err = IPC_defineMsg(CARMEN_DISTANCE_MAP_REQUEST_NAME, IPC_VARIABLE_LENGTH,
+		      CARMEN_DEFAULT_MESSAGE_FMT);
+  carmen_test_ipc_exit(err, "Could not define message",
+		       CARMEN_DISTANCE_MAP_REQUEST_NAME);
+
+  query = carmen_default_message_create();
+  err = IPC_queryResponseData(CARMEN_DISTANCE_MAP_REQUEST_NAME, query,
+			      (void **)&response, timeout);
+  if (err != IPC_OK)
+    {
+      carmen_test_ipc(err, "Could not get distance map",
+		      CARMEN_DISTANCE_MAP_REQUEST_NAME);
+      return -1;
+    }
+
+  return unpack_gridmap_response(response, client_map);
+}
+
 /*
 void
 carmen_placelist_interface_handler(MSG_INSTANCE msgRef, BYTE_ARRAY callData,
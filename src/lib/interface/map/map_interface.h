@@ -60,6 +60,10 @@ void carmen_map_free_hmap(carmen_hmap_p hmap);
 /* change map zone within an hmap */
 int carmen_map_change_map_zone(char *zone_name);
 
+/* request the current map zone from the server. zone_name is set to a
+   newly allocated string, or NULL if the map has no zones. */
+int carmen_map_get_zone(char **zone_name);
+
 /* subscribe to map zone messages */
 void carmen_map_subscribe_map_zone_message(char **zone_name,
 					   carmen_handler_t handler,
@@ -69,6 +73,11 @@ void carmen_map_subscribe_map_zone_message(char **zone_name,
 int carmen_map_get_gridmap(carmen_map_p map);
 int carmen_map_get_gridmap_by_name(char *name, carmen_map_p map);
 
+/* request the obstacle distance map of the current map from the server,
+   see carmen_map_util_distance_to_cspace() for turning it into a
+   configuration space */
+int carmen_map_get_distance_map(carmen_map_p map);
+
 /* subscribe to map messages output by the map server */
 void carmen_map_subscribe_gridmap_update_message(carmen_map_t *map, 
 						 carmen_handler_t handler, 
@@ -94,6 +94,19 @@ typedef struct {
 #define CARMEN_NAMED_GRIDMAP_REQUEST_NAME    "carmen_named_gridmap_request"
 #define CARMEN_NAMED_GRIDMAP_REQUEST_FMT     "{string,double,string}"
 
+/* Obstacle distance map of the current map: every cell holds the
+   distance in metres to the closest cell that is unknown or at least
+   CARMEN_MAP_DISTANCE_FREE_THRESHOLD. It is sent as a
+   carmen_grid_map_message and computed only once per map. */
+
+#define CARMEN_DISTANCE_MAP_REQUEST_NAME     "carmen_distance_map_request"
+typedef carmen_default_message carmen_distance_map_request_message;
+
+#define CARMEN_MAP_DISTANCE_MAP_NAME         "carmen_distance_map_message"
+#define CARMEN_MAP_DISTANCE_MAP_FMT          CARMEN_MAP_GRIDMAP_FMT
+
+#define CARMEN_MAP_DISTANCE_FREE_THRESHOLD   0.1
+
 typedef struct {  
   carmen_place_p places;
   int num_places;
@@ -159,6 +172,11 @@ typedef struct {
 #define CARMEN_MAP_ZONE_NAME                   "carmen_map_zone_message"
 #define CARMEN_MAP_ZONE_FMT                    "{string,double,string}"
 
+/* asks the map server for its current zone, answered with a
+   carmen_map_zone_message */
+#define CARMEN_MAP_ZONE_REQUEST_NAME           "carmen_map_zone_request"
+typedef carmen_default_message carmen_map_zone_request_message;
+
 typedef struct {
   char *zone_name;
   double timestamp;
@@ -243,6 +243,49 @@ carmen_navigator_set_goal_place(char *placename)
   return return_code;
 }
 
+int 
+carmen_navigator_set_goal_zone(char *zone_name, carmen_point_p goal)
+{
+  IPC_RETURN_TYPE err = IPC_OK;
+  carmen_navigator_set_goal_zone_message msg;
+  carmen_navigator_return_code_message *return_msg;
+  int return_code;
+  static int initialized = 0;
+
+  if (!initialized) 
+    {
+      err = IPC_defineMsg(CARMEN_NAVIGATOR_SET_GOAL_ZONE_NAME, 
+			  IPC_VARIABLE_LENGTH, 
+			  CARMEN_NAVIGATOR_SET_GOAL_ZONE_FMT);
+      carmen_test_ipc_exit(err, "Could not define message", 
+			   CARMEN_NAVIGATOR_SET_GOAL_ZONE_NAME);
+      initialized = 1;
+    }
+
+  msg.zone_name = zone_name;
+  msg.goal = *goal;
+  msg.timestamp = carmen_get_time();
+  msg.host = carmen_get_host();
+
+  err = IPC_queryResponseData(CARMEN_NAVIGATOR_SET_GOAL_ZONE_NAME, &msg, 
+			      (void **)&return_msg, timeout);
+  carmen_test_ipc(err, "Could not set goal by zone", 
+		  CARMEN_NAVIGATOR_SET_GOAL_ZONE_NAME);
+
+  if (err == IPC_OK) {
+    if (return_msg->code) {
+      carmen_warn("%s", return_msg->error);
+      free(return_msg->error);
+    }
+
+    return_code = return_msg->code;
+    free(return_msg);
+  } else 
+    return_code = err;
+
+  return return_code;
+}
+
 int 
 carmen_navigator_stop(void) 
 {
@@ -105,6 +105,14 @@ int carmen_navigator_set_goal_triplet(carmen_point_p goal);
   */ 
 int carmen_navigator_set_goal_place(char *name);
 
+  /** Using this function causes the robot to reach a final pose in another
+      zone of the hierarchical map, passing through the doors and elevators
+      that link the zones. The navigator plans a route over the zones and
+      follows it one zone at a time. This function does not start the robot
+      moving: carmen_navigator_go() must be called.
+  */
+int carmen_navigator_set_goal_zone(char *zone_name, carmen_point_p goal);
+
   /** Causes the navigator to stop trying to reach the goal. This also causes
       an autonomous_stopped message to be emitted. The goal position is
       unaffected. The trajectory can be resumed by calling
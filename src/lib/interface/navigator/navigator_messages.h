@@ -192,6 +192,21 @@ typedef struct {
   
 #define CARMEN_NAVIGATOR_SET_GOAL_PLACE_NAME "carmen_navigator_set_goal_place"
 #define CARMEN_NAVIGATOR_SET_GOAL_PLACE_FMT "{string,double,string}"
+
+  /** This message is sent to the navigator to set a goal pose in some zone
+      of the hierarchical map. See carmen_navigator_set_goal_zone() for more
+      information.
+  */
+
+typedef struct {
+  char *zone_name;
+  carmen_point_t goal;
+  double timestamp;
+  char *host;
+} carmen_navigator_set_goal_zone_message;
+
+#define CARMEN_NAVIGATOR_SET_GOAL_ZONE_NAME "carmen_navigator_set_goal_zone"
+#define CARMEN_NAVIGATOR_SET_GOAL_ZONE_FMT "{string,{double,double,double},double,string}"
   
 typedef struct {
   int code;
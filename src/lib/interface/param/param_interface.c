@@ -70,6 +70,11 @@ static char error_buffer[1024];
 
 static char *usage_line = NULL;
 
+/* Values fetched with a single bulk query by carmen_param_install_params(),
+   consulted by the carmen_param_get_* functions before they ask the
+   param_daemon for a single variable. */
+static carmen_param_response_bulk_message *prefetched = NULL;
+
 static void install_parameter(char *module, char *variable, 
 			      void *variable_address, 
 			      carmen_param_type_t type, int subscribe, 
@@ -237,6 +242,226 @@ param_check_commandline_directory(char *lvalue, char **dirname)
   return 1;
 }
 
+static int
+variable_not_found(const char *variable)
+{
+  if (allow_not_found_parameters)
+    return 0;
+
+  sprintf(error_buffer, "The parameter server contains no definition "
+	  "for %s_%s,\nrequested by this program. You may have started "
+	  "the param_daemon with\nan out-of-date carmen.ini file. Or, this "
+	  "may be a bug in this program\n(but probably not the parameter "
+	  "server). \n", (!module_name ? "" : module_name), variable);
+  return -1;
+}
+
+static int
+bulk_query_available(void)
+{
+  static int available = -1;
+
+  /* param_daemons that predate the bulk query would never answer it */
+  if (available < 0)
+    available = IPC_isConnected() &&
+      IPC_isMsgDefined(CARMEN_PARAM_QUERY_BULK_NAME) &&
+      IPC_numHandlers(CARMEN_PARAM_QUERY_BULK_NAME) > 0;
+
+  return available;
+}
+
+static void
+free_prefetched(void)
+{
+  int index;
+
+  if (prefetched == NULL)
+    return;
+
+  for (index = 0; index < prefetched->num_variables; index++) {
+    free(prefetched->module_names[index]);
+    free(prefetched->variable_names[index]);
+    free(prefetched->values[index]);
+  }
+  free(prefetched->module_names);
+  free(prefetched->variable_names);
+  free(prefetched->values);
+  free(prefetched->expert);
+  free(prefetched->status);
+  free(prefetched->host);
+  free(prefetched);
+  prefetched = NULL;
+}
+
+static void
+prefetch_params(carmen_param_p param_list, int num_items)
+{
+  IPC_RETURN_TYPE err;
+  carmen_param_query_bulk_message query;
+  int index;
+
+  free_prefetched();
+
+  if (num_items < 2 || !bulk_query_available())
+    return;
+
+  err = IPC_defineMsg(CARMEN_PARAM_QUERY_BULK_NAME, IPC_VARIABLE_LENGTH, 
+		      CARMEN_PARAM_QUERY_BULK_FMT);
+  carmen_test_ipc_exit(err, "Could not define message", 
+		       CARMEN_PARAM_QUERY_BULK_NAME);
+
+  query.num_variables = num_items;
+  query.module_names = (char **)calloc(num_items, sizeof(char *));
+  carmen_test_alloc(query.module_names);
+  query.variable_names = (char **)calloc(num_items, sizeof(char *));
+  carmen_test_alloc(query.variable_names);
+  for (index = 0; index < num_items; index++) {
+    query.module_names[index] = param_list[index].module;
+    query.variable_names[index] = param_list[index].variable;
+  }
+  query.timestamp = carmen_get_time();
+  query.host = carmen_get_host();
+
+  /* On failure, the variables are simply queried one by one */
+  err = IPC_queryResponseData(CARMEN_PARAM_QUERY_BULK_NAME, &query, 
+			      (void **)&prefetched, timeout);
+  if (err != IPC_OK)
+    prefetched = NULL;
+
+  free(query.module_names);
+  free(query.variable_names);
+}
+
+/* Returns the status of a prefetched variable of the current module, or -1
+   if it was not prefetched. */
+static int
+get_prefetched(const char *variable, char **value, int *expert)
+{
+  int index;
+  char *module;
+
+  if (prefetched == NULL)
+    return -1;
+
+  for (index = 0; index < prefetched->num_variables; index++) {
+    if (prefetched->variable_names[index] == NULL ||
+	carmen_strcasecmp(prefetched->variable_names[index], variable) != 0)
+      continue;
+    module = prefetched->module_names[index];
+    if ((module == NULL) != (module_name == NULL) ||
+	(module != NULL && carmen_strcasecmp(module, module_name) != 0))
+      continue;
+
+    *value = (prefetched->values[index] != NULL) ?
+      prefetched->values[index] : "";
+    *expert = prefetched->expert[index];
+    return prefetched->status[index];
+  }
+
+  return -1;
+}
+
+/* The following functions parse prefetched values the same way the
+   param_daemon parses them, with the return values of the
+   carmen_param_get_* functions. */
+
+static int
+get_prefetched_int(const char *variable, int *return_value, int *expert,
+		   int *found)
+{
+  char *value, *endptr;
+  int status, value_expert, new_value;
+
+  status = get_prefetched(variable, &value, &value_expert);
+  *found = (status >= 0);
+  if (status == CARMEN_PARAM_NOT_FOUND)
+    return variable_not_found(variable);
+  if (status != CARMEN_PARAM_OK)
+    return 0;
+
+  new_value = strtol(value, &endptr, 0);
+  if (endptr == value)
+    return 0;
+
+  *return_value = new_value;
+  if (expert)
+    *expert = value_expert;
+  return 1;
+}
+
+static int
+get_prefetched_double(const char *variable, double *return_value,
+		      int *expert, int *found)
+{
+  char *value, *endptr;
+  int status, value_expert;
+  double new_value;
+
+  status = get_prefetched(variable, &value, &value_expert);
+  *found = (status >= 0);
+  if (status == CARMEN_PARAM_NOT_FOUND)
+    return variable_not_found(variable);
+  if (status != CARMEN_PARAM_OK)
+    return 0;
+
+  new_value = strtod(value, &endptr);
+  if (endptr == value)
+    return 0;
+
+  *return_value = new_value;
+  if (expert)
+    *expert = value_expert;
+  return 1;
+}
+
+static int
+get_prefetched_onoff(const char *variable, int *return_value, int *expert,
+		     int *found)
+{
+  char *value;
+  int status, value_expert;
+
+  status = get_prefetched(variable, &value, &value_expert);
+  *found = (status >= 0);
+  if (status == CARMEN_PARAM_NOT_FOUND)
+    return variable_not_found(variable);
+  if (status != CARMEN_PARAM_OK || strlen(value) > 254)
+    return 0;
+
+  if (carmen_strncasecmp(value, "ON", 2) == 0)
+    *return_value = 1;
+  else if (carmen_strncasecmp(value, "OFF", 3) == 0)
+    *return_value = 0;
+  else
+    return 0;
+
+  if (expert)
+    *expert = value_expert;
+  return 1;
+}
+
+static int
+get_prefetched_string(const char *variable, char **return_value, int *expert,
+		      int *found)
+{
+  char *value;
+  int status, value_expert;
+
+  status = get_prefetched(variable, &value, &value_expert);
+  *found = (status >= 0);
+  if (status == CARMEN_PARAM_NOT_FOUND)
+    return variable_not_found(variable);
+  if (status != CARMEN_PARAM_OK)
+    return 0;
+
+  *return_value = (char *)calloc(strlen(value)+1, sizeof(char));
+  carmen_test_alloc(*return_value);
+  strcpy(*return_value, value);
+  if (expert)
+    *expert = value_expert;
+  return 1;
+}
+
 char *
 carmen_param_get_robot(void)
 {
@@ -449,6 +674,7 @@ carmen_param_get_int(const char *variable, int *return_value, int *expert)
 {
   IPC_RETURN_TYPE err;
   int commandline_return;
+  int prefetched_return, prefetched_found;
   char buffer[1024];
 
   carmen_param_query_message query;
@@ -482,6 +708,11 @@ carmen_param_get_int(const char *variable, int *return_value, int *expert)
   if (commandline_return != 0)
     return commandline_return;
 
+  prefetched_return = get_prefetched_int(variable, return_value, expert,
+					  &prefetched_found);
+  if (prefetched_found)
+    return prefetched_return;
+
   query.timestamp = carmen_get_time();
   query.host = carmen_get_host();
   query.module_name = module_name;
@@ -525,6 +756,7 @@ carmen_param_get_double(const char *variable, double *return_value, int *expert)
 {
   IPC_RETURN_TYPE err;
   int commandline_return;
+  int prefetched_return, prefetched_found;
   char buffer[1024];
   carmen_param_query_message query;
   carmen_param_response_double_message *response;
@@ -556,6 +788,11 @@ carmen_param_get_double(const char *variable, double *return_value, int *expert)
   if (commandline_return != 0)
     return commandline_return;
 
+  prefetched_return = get_prefetched_double(variable, return_value, expert,
+					  &prefetched_found);
+  if (prefetched_found)
+    return prefetched_return;
+
   query.timestamp = carmen_get_time();
   query.host = carmen_get_host();
   query.module_name = module_name;
@@ -599,6 +836,7 @@ carmen_param_get_onoff(const char *variable, int *return_value, int *expert)
 {
   IPC_RETURN_TYPE err;
   int commandline_return;
+  int prefetched_return, prefetched_found;
   char buffer[1024];
   carmen_param_query_message query;
   carmen_param_response_onoff_message *response;
@@ -631,6 +869,11 @@ carmen_param_get_onoff(const char *variable, int *return_value, int *expert)
   if (commandline_return != 0)
     return commandline_return;
 
+  prefetched_return = get_prefetched_onoff(variable, return_value, expert,
+					  &prefetched_found);
+  if (prefetched_found)
+    return prefetched_return;
+
   query.timestamp = carmen_get_time();
   query.host = carmen_get_host();
   query.module_name = module_name;
@@ -675,6 +918,7 @@ carmen_param_get_string(const char *variable, char **return_value, int *expert)
 {
   IPC_RETURN_TYPE err;
   int commandline_return;
+  int prefetched_return, prefetched_found;
   char buffer[1024];
   carmen_param_query_message query;
   carmen_param_response_string_message *response;
@@ -706,6 +950,11 @@ carmen_param_get_string(const char *variable, char **return_value, int *expert)
   if (commandline_return != 0)
     return commandline_return;
   
+  prefetched_return = get_prefetched_string(variable, return_value, expert,
+					  &prefetched_found);
+  if (prefetched_found)
+    return prefetched_return;
+
   query.timestamp = carmen_get_time();
   query.host = carmen_get_host();
   query.module_name = module_name;
@@ -752,6 +1001,7 @@ carmen_param_get_filename(const char *variable, char **return_value, int *expert
 {
   IPC_RETURN_TYPE err;
   int commandline_return;
+  int prefetched_return, prefetched_found;
   carmen_param_query_message query;
   carmen_param_response_string_message *response;
   char buffer[1024];
@@ -785,6 +1035,11 @@ carmen_param_get_filename(const char *variable, char **return_value, int *expert
   if (commandline_return != 0)
     return commandline_return;
   
+  prefetched_return = get_prefetched_string(variable, return_value, expert,
+					  &prefetched_found);
+  if (prefetched_found)
+    return prefetched_return;
+
   query.timestamp = carmen_get_time();
   query.host = carmen_get_host();
   query.module_name = module_name;
@@ -831,6 +1086,7 @@ carmen_param_get_directory(char *variable, char **return_value, int *expert)
 {
   IPC_RETURN_TYPE err;
   int commandline_return;
+  int prefetched_return, prefetched_found;
   carmen_param_query_message query;
   carmen_param_response_string_message *response;
   char buffer[1024];
@@ -864,6 +1120,11 @@ carmen_param_get_directory(char *variable, char **return_value, int *expert)
   if (commandline_return != 0)
     return commandline_return;
   
+  prefetched_return = get_prefetched_string(variable, return_value, expert,
+					  &prefetched_found);
+  if (prefetched_found)
+    return prefetched_return;
+
   query.timestamp = carmen_get_time();
   query.host = carmen_get_host();
   query.module_name = module_name;
@@ -1101,6 +1362,8 @@ carmen_param_install_params(int argc, char *argv[], carmen_param_p param_list,
 		       "It loads parameter settings from the param_daemon.", 
 		       argv[0]);
 
+  prefetch_params(param_list, num_items);
+
   for (index = 0; index < num_items; index++) {
     carmen_param_set_module(param_list[index].module);
     
@@ -1159,6 +1422,8 @@ carmen_param_install_params(int argc, char *argv[], carmen_param_p param_list,
 		      param_list[index].type, param_list[index].subscribe, 
 		      param_list[index].handler);
   }
+
+  free_prefetched();
   
   return last_command_line_arg;
 }
@@ -136,6 +136,46 @@ typedef struct {
 #define CARMEN_PARAM_RESPONSE_ALL_NAME     "carmen_param_respond_all"
 #define CARMEN_PARAM_RESPONSE_ALL_FMT "{string, int, <string:2>, <string:2>, <int:2>, int, double, string}"
 
+  /** This message asks for the values of many variables at once. Each
+      variable is given by its module name and variable name; a variable
+      name of "*" asks for all variables of the module. The param_daemon
+      answers with a carmen_param_response_bulk_message.
+  */
+
+typedef struct {
+  int num_variables;
+  char **module_names;
+  char **variable_names;
+  double timestamp;
+  char *host;
+} carmen_param_query_bulk_message;
+
+#define CARMEN_PARAM_QUERY_BULK_NAME  "carmen_param_query_bulk"
+#define CARMEN_PARAM_QUERY_BULK_FMT   "{int, <string:1>, <string:1>, double, string}"
+
+  /** This message reports the values of all variables asked for by a bulk
+      query, as strings, with one status per variable. Queries for all
+      variables of a module are expanded to one entry per variable.
+  */
+
+typedef struct {
+  int num_variables;
+  char **module_names;
+  char **variable_names;
+  char **values;                          /**< The value of each variable, or
+					     an empty string if it was not
+					     found. */
+  int *expert;
+  int *status;                            /**< CARMEN_PARAM_OK or
+					     CARMEN_PARAM_NOT_FOUND for each
+					     variable. */
+  double timestamp;
+  char *host;
+} carmen_param_response_bulk_message;
+
+#define CARMEN_PARAM_RESPONSE_BULK_NAME  "carmen_param_respond_bulk"
+#define CARMEN_PARAM_RESPONSE_BULK_FMT   "{int, <string:1>, <string:1>, <string:1>, <int:1>, <int:1>, double, string}"
+
   /** This message reports the current value for a specific variable, assumed
       to be an integer. Generally emitted in response to a query. All fields
       are undefined if status is not CARMEN_PARAM_OK, for example, if the
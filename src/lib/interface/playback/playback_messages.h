@@ -51,6 +51,8 @@ extern "C" {
 #define    CARMEN_PLAYBACK_COMMAND_FWD_SINGLE   5
 #define    CARMEN_PLAYBACK_COMMAND_RWD_SINGLE   6
 #define    CARMEN_PLAYBACK_COMMAND_SET_SPEED    7
+/** Jumps to arg seconds after the start of the log. **/
+#define    CARMEN_PLAYBACK_COMMAND_SEEK         8
 
 typedef struct {
   int cmd, arg;
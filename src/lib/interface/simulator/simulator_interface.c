@@ -27,6 +27,7 @@
  ********************************************************/
 
 #include "global.h"
+#include "param_interface.h"
 #include "simulator_interface.h"
 
 void
@@ -250,3 +251,90 @@ carmen_simulator_set_truepose(carmen_point_t *point)
 
   return 0;
 }
+
+void
+carmen_simulator_subscribe_clock_message(carmen_simulator_clock_message
+					 *clock,
+					 carmen_handler_t handler,
+					 carmen_subscribe_t subscribe_how)
+{
+  carmen_subscribe_message(CARMEN_SIMULATOR_CLOCK_NAME, 
+			   CARMEN_SIMULATOR_CLOCK_FMT,
+			   clock, sizeof(carmen_simulator_clock_message), 
+			   handler, subscribe_how);
+}
+
+void
+carmen_simulator_unsubscribe_clock_message(carmen_handler_t handler)
+{
+  carmen_unsubscribe_message(CARMEN_SIMULATOR_CLOCK_NAME, handler);
+}
+
+static carmen_simulator_clock_message simulated_clock;
+static char *simulated_clock_module = NULL;
+static int simulated_clock_acknowledge = 0;
+
+void
+carmen_simulator_acknowledge_clock(void)
+{
+  IPC_RETURN_TYPE err = IPC_OK;
+  carmen_simulator_clock_ack_message msg;
+  static int initialized = 0;
+
+  if (!initialized) 
+    {
+      err = IPC_defineMsg(CARMEN_SIMULATOR_CLOCK_ACK_NAME, 
+			  IPC_VARIABLE_LENGTH, 
+			  CARMEN_SIMULATOR_CLOCK_ACK_FMT);
+      carmen_test_ipc_exit(err, "Could not define message", 
+			   CARMEN_SIMULATOR_CLOCK_ACK_NAME);
+      initialized = 1;
+    }
+
+  msg.step = simulated_clock.step;
+  msg.module = simulated_clock_module;
+  msg.timestamp = carmen_get_time();
+  msg.host = carmen_get_host();
+
+  err = IPC_publishData(CARMEN_SIMULATOR_CLOCK_ACK_NAME, &msg);
+  carmen_test_ipc(err, "Could not publish", 
+		  CARMEN_SIMULATOR_CLOCK_ACK_NAME);
+}
+
+static void
+simulated_clock_handler(void)
+{
+  carmen_set_simulated_time(simulated_clock.timestamp);
+  if (simulated_clock_acknowledge)
+    carmen_simulator_acknowledge_clock();
+}
+
+void
+carmen_simulator_use_simulated_clock(char *module, int acknowledge)
+{
+  simulated_clock_module = carmen_new_string("%s", module);
+  simulated_clock_acknowledge = acknowledge;
+
+  carmen_simulator_subscribe_clock_message
+    (&simulated_clock, (carmen_handler_t)simulated_clock_handler,
+     CARMEN_SUBSCRIBE_ALL);
+}
+
+int
+carmen_simulator_initialize_clock(int argc, char **argv)
+{
+  int lockstep = 0, allow_unfound;
+  carmen_param_t param_list[] = {
+    {"simulator", "lockstep", CARMEN_PARAM_ONOFF, &lockstep, 0, NULL}};
+
+  allow_unfound = carmen_param_are_unfound_variables_allowed();
+  carmen_param_allow_unfound_variables(1);
+  carmen_param_install_params(argc, argv, param_list, 
+			      sizeof(param_list)/sizeof(param_list[0]));
+  carmen_param_allow_unfound_variables(allow_unfound);
+
+  if (lockstep)
+    carmen_simulator_use_simulated_clock(carmen_extract_filename(argv[0]), 1);
+
+  return lockstep;
+}
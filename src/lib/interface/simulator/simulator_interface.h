@@ -74,6 +74,29 @@ void carmen_simulator_clear_objects(void);
 
 void carmen_simulator_next_tick(void);
 
+void
+carmen_simulator_subscribe_clock_message(carmen_simulator_clock_message
+					 *clock,
+					 carmen_handler_t handler,
+					 carmen_subscribe_t subscribe_how);
+
+void
+carmen_simulator_unsubscribe_clock_message(carmen_handler_t handler);
+
+/** Follows the simulator's lockstep clock: carmen_get_time() returns the
+    simulated time of the last clock message. If acknowledge is set, each
+    clock message is acknowledged as soon as it is received, i.e. after
+    all readings of that step have been handled; otherwise the module
+    has to call carmen_simulator_acknowledge_clock() itself. **/
+void
+carmen_simulator_use_simulated_clock(char *module, int acknowledge);
+
+void carmen_simulator_acknowledge_clock(void);
+
+/** Follows the simulated clock if simulator_lockstep is set. Returns
+    whether lockstep mode is on. **/
+int carmen_simulator_initialize_clock(int argc, char **argv);
+
 #ifdef __cplusplus
 }
 #endif
@@ -104,6 +104,30 @@ typedef struct {
 #define CARMEN_SIMULATOR_OBJECTS_NAME "carmen_simulator_objects"
 #define CARMEN_SIMULATOR_OBJECTS_FMT  "{int,<{double,double,double,double,double}:1>,double,string}"
 
+/** Published by the simulator in lockstep mode after all readings of a
+    simulation step. The timestamp is the simulated time of the step. **/
+typedef struct {
+  int step;
+  double delta_t;
+  double timestamp;
+  char *host;
+} carmen_simulator_clock_message;
+
+#define CARMEN_SIMULATOR_CLOCK_NAME "carmen_simulator_clock"
+#define CARMEN_SIMULATOR_CLOCK_FMT  "{int,double,double,string}"
+
+/** Sent back by each lockstep consumer once it has handled all messages
+    of a simulation step. **/
+typedef struct {
+  int step;
+  char *module;
+  double timestamp;
+  char *host;
+} carmen_simulator_clock_ack_message;
+
+#define CARMEN_SIMULATOR_CLOCK_ACK_NAME "carmen_simulator_clock_ack"
+#define CARMEN_SIMULATOR_CLOCK_ACK_FMT  "{int,string,double,string}"
+
 #ifdef __cplusplus
 }
 #endif